@@ -0,0 +1,119 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "mln_bench.h"
+
+#define M_BENCH_MIN_US   100000 /*calibrate until one run lasts this long*/
+#define M_BENCH_REPS     3      /*measured repetitions, best one reported*/
+#define M_BENCH_MAX_N    ((mln_size_t)1 << 30)
+
+static FILE *bench_csv = NULL;
+static int bench_argc = 0;
+static char **bench_argv = NULL;
+
+static mln_u64_t mln_bench_now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (mln_u64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static mln_u64_t mln_bench_once(mln_bench_fn_t fn, mln_size_t n, mln_u64_t *bytes)
+{
+    mln_bench_t b;
+    mln_u64_t begin, end;
+
+    b.n = n;
+    b.bytes = 0;
+    begin = mln_bench_now_us();
+    fn(&b);
+    end = mln_bench_now_us();
+    *bytes = b.bytes;
+    return end - begin;
+}
+
+void mln_bench_run(char *suite, char *name, mln_bench_fn_t fn)
+{
+    int i;
+    mln_size_t n = 1;
+    mln_u64_t us, best_us, bytes;
+    double ns_op, mb_s;
+
+    /*warmup doubles as calibration*/
+    while (1) {
+        us = mln_bench_once(fn, n, &bytes);
+        if (us >= M_BENCH_MIN_US || n >= M_BENCH_MAX_N) break;
+        if (us < M_BENCH_MIN_US / 8)
+            n <<= 3;
+        else
+            n <<= 1;
+    }
+    best_us = us;
+    for (i = 0; i < M_BENCH_REPS; ++i) {
+        us = mln_bench_once(fn, n, &bytes);
+        if (us < best_us) best_us = us;
+    }
+    if (best_us == 0) best_us = 1;
+
+    ns_op = (double)best_us * 1000.0 / (double)n;
+    mb_s = bytes? (double)bytes / (double)best_us: 0.0;
+    if (bytes)
+        printf("%-10s %-24s %12.1f ns/op %10.1f MB/s  (n=%lu)\n", \
+               suite, name, ns_op, mb_s, (unsigned long)n);
+    else
+        printf("%-10s %-24s %12.1f ns/op %16s  (n=%lu)\n", \
+               suite, name, ns_op, "", (unsigned long)n);
+    if (bench_csv != NULL)
+        fprintf(bench_csv, "%s,%s,%lu,%.1f,%.1f\n", \
+                suite, name, (unsigned long)n, ns_op, mb_s);
+}
+
+static int mln_bench_suite_wanted(char *suite)
+{
+    int i, seen = 0;
+
+    for (i = 1; i < bench_argc; ++i) {
+        if (!strncmp(bench_argv[i], "--csv=", 6)) continue;
+        seen = 1;
+        if (!strcmp(bench_argv[i], suite)) return 1;
+    }
+    return !seen;
+}
+
+int main(int argc, char *argv[])
+{
+    int i;
+    struct {
+        char            *suite;
+        void           (*fn)(void);
+    } suites[] = {
+        {"hash",   mln_bench_suite_hash},
+        {"alloc",  mln_bench_suite_alloc},
+        {"json",   mln_bench_suite_json},
+        {"string", mln_bench_suite_string},
+        {"base64", mln_bench_suite_base64},
+    };
+
+    bench_argc = argc;
+    bench_argv = argv;
+    for (i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--csv=", 6)) continue;
+        bench_csv = fopen(argv[i] + 6, "a");
+        if (bench_csv == NULL) {
+            fprintf(stderr, "open %s failed\n", argv[i] + 6);
+            return 1;
+        }
+    }
+    for (i = 0; i < (int)(sizeof(suites)/sizeof(suites[0])); ++i) {
+        if (!mln_bench_suite_wanted(suites[i].suite)) continue;
+        suites[i].fn();
+    }
+    if (bench_csv != NULL) fclose(bench_csv);
+    return 0;
+}
+
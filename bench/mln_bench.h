@@ -0,0 +1,35 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#ifndef __MLN_BENCH_H
+#define __MLN_BENCH_H
+
+#include "mln_types.h"
+
+/*
+ * Microbenchmark harness ('make bench'). A case is a function that
+ * performs b->n iterations of one operation; the harness warms it up,
+ * doubles 'n' until a run lasts long enough to time reliably, then
+ * takes the best of several repetitions and reports ns/op (and MB/s
+ * when the case accounts bytes into b->bytes). Pass suite names on the
+ * command line to run a subset, and --csv=FILE to append
+ * machine-readable rows for regression tracking.
+ */
+typedef struct {
+    mln_size_t               n;     /*iterations the case must perform*/
+    mln_u64_t                bytes; /*bytes processed, accounted by the case*/
+} mln_bench_t;
+
+typedef void (*mln_bench_fn_t)(mln_bench_t *);
+
+extern void mln_bench_run(char *suite, char *name, mln_bench_fn_t fn);
+
+extern void mln_bench_suite_hash(void);
+extern void mln_bench_suite_alloc(void);
+extern void mln_bench_suite_json(void);
+extern void mln_bench_suite_string(void);
+extern void mln_bench_suite_base64(void);
+
+#endif
+
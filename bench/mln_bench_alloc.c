@@ -0,0 +1,72 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#include <stdio.h>
+#include "mln_bench.h"
+#include "mln_alloc.h"
+
+#define M_BENCH_ALLOC_WINDOW 128
+
+static mln_alloc_t *bench_pool = NULL;
+
+static void bench_alloc_small(mln_bench_t *b)
+{
+    mln_size_t i;
+    void *p;
+
+    for (i = 0; i < b->n; ++i) {
+        p = mln_alloc_m(bench_pool, 16);
+        if (p == NULL) return;
+        mln_alloc_free(p);
+    }
+    b->bytes = (mln_u64_t)b->n * 16;
+}
+
+static void bench_alloc_mixed(mln_bench_t *b)
+{
+    mln_size_t i, size, sizes[] = {16, 64, 256, 1024, 4096};
+    void *p;
+
+    for (i = 0; i < b->n; ++i) {
+        size = sizes[i % 5];
+        p = mln_alloc_m(bench_pool, size);
+        if (p == NULL) return;
+        mln_alloc_free(p);
+        b->bytes += size;
+    }
+}
+
+/*
+ * A sliding window of live allocations: each iteration allocates one
+ * block and frees the one allocated M_BENCH_ALLOC_WINDOW iterations
+ * ago, so frees hit cold chunks instead of the one just handed out.
+ */
+static void bench_alloc_churn(mln_bench_t *b)
+{
+    mln_size_t i;
+    void *window[M_BENCH_ALLOC_WINDOW] = {NULL};
+
+    for (i = 0; i < b->n; ++i) {
+        if (window[i % M_BENCH_ALLOC_WINDOW] != NULL)
+            mln_alloc_free(window[i % M_BENCH_ALLOC_WINDOW]);
+        window[i % M_BENCH_ALLOC_WINDOW] = mln_alloc_m(bench_pool, 64);
+        if (window[i % M_BENCH_ALLOC_WINDOW] == NULL) break;
+    }
+    for (i = 0; i < M_BENCH_ALLOC_WINDOW; ++i) {
+        if (window[i] != NULL) mln_alloc_free(window[i]);
+    }
+    b->bytes = (mln_u64_t)b->n * 64;
+}
+
+void mln_bench_suite_alloc(void)
+{
+    bench_pool = mln_alloc_init(NULL);
+    if (bench_pool == NULL) return;
+    mln_bench_run("alloc", "small-16", bench_alloc_small);
+    mln_bench_run("alloc", "mixed-16..4096", bench_alloc_mixed);
+    mln_bench_run("alloc", "churn-window-64", bench_alloc_churn);
+    mln_alloc_destroy(bench_pool);
+    bench_pool = NULL;
+}
+
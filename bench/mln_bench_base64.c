@@ -0,0 +1,61 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#include <stdio.h>
+#include "mln_bench.h"
+#include "mln_base64.h"
+
+#define M_BENCH_BASE64_LEN 4096
+
+static mln_u8_t bench_base64_raw[M_BENCH_BASE64_LEN];
+static mln_u8ptr_t bench_base64_code = NULL;
+static mln_uauto_t bench_base64_code_len = 0;
+
+static void bench_base64_encode(mln_bench_t *b)
+{
+    mln_size_t i;
+    mln_u8ptr_t out;
+    mln_uauto_t outlen;
+
+    for (i = 0; i < b->n; ++i) {
+        if (mln_base64_encode(bench_base64_raw, M_BENCH_BASE64_LEN, &out, &outlen) < 0)
+            return;
+        mln_base64_free(out);
+    }
+    b->bytes = (mln_u64_t)b->n * M_BENCH_BASE64_LEN;
+}
+
+static void bench_base64_decode(mln_bench_t *b)
+{
+    mln_size_t i;
+    mln_u8ptr_t out;
+    mln_uauto_t outlen;
+
+    for (i = 0; i < b->n; ++i) {
+        if (mln_base64_decode(bench_base64_code, bench_base64_code_len, &out, &outlen) < 0)
+            return;
+        mln_base64_free(out);
+    }
+    b->bytes = (mln_u64_t)b->n * bench_base64_code_len;
+}
+
+void mln_bench_suite_base64(void)
+{
+    mln_size_t i;
+    mln_u32_t seed = 0x87654321;
+
+    for (i = 0; i < M_BENCH_BASE64_LEN; ++i) {
+        seed = seed * 1103515245 + 12345;
+        bench_base64_raw[i] = (mln_u8_t)(seed >> 16);
+    }
+    mln_bench_run("base64", "encode-4k", bench_base64_encode);
+
+    if (mln_base64_encode(bench_base64_raw, M_BENCH_BASE64_LEN, \
+                          &bench_base64_code, &bench_base64_code_len) < 0)
+        return;
+    mln_bench_run("base64", "decode-4k", bench_base64_decode);
+    mln_base64_free(bench_base64_code);
+    bench_base64_code = NULL;
+}
+
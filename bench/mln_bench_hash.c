@@ -0,0 +1,91 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "mln_bench.h"
+#include "mln_hash.h"
+
+#define M_BENCH_HASH_KEYS (1 << 17)
+
+static mln_u64_t bench_hash_calc(mln_hash_t *h, void *key)
+{
+    return ((mln_u64_t)key * 0x9e3779b97f4a7c15ULL) % h->len;
+}
+
+static int bench_hash_cmp(mln_hash_t *h, void *key1, void *key2)
+{
+    return key1 == key2;
+}
+
+static mln_hash_t *bench_hash_new(void)
+{
+    struct mln_hash_attr attr;
+
+    attr.pool = NULL;
+    attr.pool_alloc = NULL;
+    attr.pool_free = NULL;
+    attr.hash = bench_hash_calc;
+    attr.cmp = bench_hash_cmp;
+    attr.free_key = NULL;
+    attr.free_val = NULL;
+    attr.len_base = 97;
+    attr.expandable = 1;
+    attr.calc_prime = 1;
+    attr.incremental = 0;
+    return mln_hash_new(&attr);
+}
+
+static void bench_hash_insert(mln_bench_t *b)
+{
+    mln_size_t i;
+    mln_hash_t *h = bench_hash_new();
+
+    if (h == NULL) return;
+    for (i = 0; i < b->n; ++i) {
+        if (mln_hash_insert(h, (void *)(i + 1), (void *)(i + 1)) < 0) break;
+    }
+    mln_hash_free(h, M_HASH_F_NONE);
+}
+
+static mln_hash_t *bench_hash_table = NULL;
+
+static void bench_hash_search(mln_bench_t *b)
+{
+    mln_size_t i;
+
+    for (i = 0; i < b->n; ++i) {
+        if (mln_hash_search(bench_hash_table, (void *)((i & (M_BENCH_HASH_KEYS - 1)) + 1)) == NULL)
+            abort();
+    }
+}
+
+static void bench_hash_search_miss(mln_bench_t *b)
+{
+    mln_size_t i;
+
+    for (i = 0; i < b->n; ++i) {
+        if (mln_hash_search(bench_hash_table, (void *)(M_BENCH_HASH_KEYS + i + 1)) != NULL)
+            abort();
+    }
+}
+
+void mln_bench_suite_hash(void)
+{
+    mln_size_t i;
+
+    mln_bench_run("hash", "insert", bench_hash_insert);
+
+    bench_hash_table = bench_hash_new();
+    if (bench_hash_table == NULL) return;
+    for (i = 0; i < M_BENCH_HASH_KEYS; ++i) {
+        if (mln_hash_insert(bench_hash_table, (void *)(i + 1), (void *)(i + 1)) < 0)
+            return;
+    }
+    mln_bench_run("hash", "search-hit", bench_hash_search);
+    mln_bench_run("hash", "search-miss", bench_hash_search_miss);
+    mln_hash_free(bench_hash_table, M_HASH_F_NONE);
+    bench_hash_table = NULL;
+}
+
@@ -0,0 +1,84 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#include <stdio.h>
+#include "mln_bench.h"
+#include "mln_json.h"
+#include "mln_string.h"
+
+/*
+ * A typical small API response: nested objects, an array of records,
+ * strings with escapes, integers, doubles, booleans and null.
+ */
+static char bench_json_corpus[] = "{\
+\"status\":\"ok\",\"code\":200,\"elapsed\":0.0327,\"cached\":false,\"next\":null,\
+\"user\":{\"id\":982451653,\"name\":\"Niklaus F.\\u0053chen\",\"email\":\"nfs@example.com\",\
+\"roles\":[\"admin\",\"committer\"],\"verified\":true},\
+\"records\":[\
+{\"seq\":1,\"ts\":1724830000,\"level\":\"info\",\"msg\":\"worker 3 started\",\"latency\":0.125},\
+{\"seq\":2,\"ts\":1724830001,\"level\":\"warn\",\"msg\":\"slow callback: 3086us\",\"latency\":3.086},\
+{\"seq\":3,\"ts\":1724830002,\"level\":\"info\",\"msg\":\"accepted 10.0.0.7:52114\",\"latency\":0.041},\
+{\"seq\":4,\"ts\":1724830003,\"level\":\"error\",\"msg\":\"upstream reset \\\"conn-77\\\"\",\"latency\":12.9},\
+{\"seq\":5,\"ts\":1724830004,\"level\":\"info\",\"msg\":\"flushed 256 trace records\",\"latency\":0.009}\
+],\
+\"stats\":{\"loops\":40,\"fd_events\":19,\"timer_events\":20,\"hist\":[18,4,12,3,1,0,0,0]}\
+}";
+
+static mln_string_t bench_json_text = mln_string(bench_json_corpus);
+static mln_json_t *bench_json_tree = NULL;
+
+static void bench_json_decode(mln_bench_t *b)
+{
+    mln_size_t i;
+    mln_json_t *j;
+
+    for (i = 0; i < b->n; ++i) {
+        j = mln_json_parse(&bench_json_text);
+        if (j == NULL) return;
+        mln_json_free(j);
+    }
+    b->bytes = (mln_u64_t)b->n * bench_json_text.len;
+}
+
+static void bench_json_decode_in_situ(mln_bench_t *b)
+{
+    mln_size_t i;
+    mln_json_t *j;
+    mln_string_t *dup;
+
+    for (i = 0; i < b->n; ++i) {
+        dup = mln_string_dup(&bench_json_text);
+        if (dup == NULL) return;
+        j = mln_json_parse_in_situ(dup);
+        if (j != NULL) mln_json_free(j);
+        mln_string_free(dup);
+    }
+    b->bytes = (mln_u64_t)b->n * bench_json_text.len;
+}
+
+static void bench_json_encode(mln_bench_t *b)
+{
+    mln_size_t i;
+    mln_string_t *out;
+
+    for (i = 0; i < b->n; ++i) {
+        out = mln_json_generate(bench_json_tree);
+        if (out == NULL) return;
+        b->bytes += out->len;
+        mln_string_free(out);
+    }
+}
+
+void mln_bench_suite_json(void)
+{
+    mln_bench_run("json", "decode", bench_json_decode);
+    mln_bench_run("json", "decode-in-situ", bench_json_decode_in_situ);
+
+    bench_json_tree = mln_json_parse(&bench_json_text);
+    if (bench_json_tree == NULL) return;
+    mln_bench_run("json", "encode", bench_json_encode);
+    mln_json_free(bench_json_tree);
+    bench_json_tree = NULL;
+}
+
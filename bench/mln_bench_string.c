@@ -0,0 +1,68 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mln_bench.h"
+#include "mln_string.h"
+
+#define M_BENCH_STRING_TEXT (64 * 1024)
+
+static char bench_string_buf[M_BENCH_STRING_TEXT + 1];
+static mln_string_t bench_string_text;
+
+static void bench_string_strstr(mln_bench_t *b)
+{
+    mln_size_t i;
+
+    for (i = 0; i < b->n; ++i) {
+        if (mln_string_const_strstr(&bench_string_text, "needle-in-the-haystack") == NULL)
+            abort();
+    }
+    b->bytes = (mln_u64_t)b->n * bench_string_text.len;
+}
+
+static void bench_string_kmp(mln_bench_t *b)
+{
+    mln_size_t i;
+
+    for (i = 0; i < b->n; ++i) {
+        if (mln_string_const_kmp(&bench_string_text, "needle-in-the-haystack") == NULL)
+            abort();
+    }
+    b->bytes = (mln_u64_t)b->n * bench_string_text.len;
+}
+
+static void bench_string_strstr_miss(mln_bench_t *b)
+{
+    mln_size_t i;
+
+    for (i = 0; i < b->n; ++i) {
+        if (mln_string_const_strstr(&bench_string_text, "needle-not-in-haystack") != NULL)
+            abort();
+    }
+    b->bytes = (mln_u64_t)b->n * bench_string_text.len;
+}
+
+void mln_bench_suite_string(void)
+{
+    mln_size_t i;
+    mln_u32_t seed = 0x12345678;
+    char pat[] = "needle-in-the-haystack";
+
+    /*pseudo-random lowercase text with the pattern placed near the end*/
+    for (i = 0; i < M_BENCH_STRING_TEXT; ++i) {
+        seed = seed * 1103515245 + 12345;
+        bench_string_buf[i] = 'a' + ((seed >> 16) % 26);
+    }
+    memcpy(bench_string_buf + M_BENCH_STRING_TEXT - sizeof(pat), pat, sizeof(pat) - 1);
+    bench_string_buf[M_BENCH_STRING_TEXT] = 0;
+    mln_string_nset(&bench_string_text, bench_string_buf, M_BENCH_STRING_TEXT);
+
+    mln_bench_run("string", "strstr-64k", bench_string_strstr);
+    mln_bench_run("string", "kmp-64k", bench_string_kmp);
+    mln_bench_run("string", "strstr-64k-miss", bench_string_strstr_miss);
+}
+
@@ -33,6 +33,9 @@
 typedef struct {
     mln_u32_t bits;
     mln_u32_t w[60];
+    mln_u8_t  hwek[240];/*hardware-path round keys in the byte order the ISA expects*/
+    mln_u8_t  hwdk[240];/*inverse-cipher round keys (InvMixColumns applied)*/
+    mln_u32_t hw:1;/*nonzero when AES instructions were detected at mln_aes_init()*/
 } mln_aes_t;
 
 
@@ -43,6 +46,33 @@ extern void mln_aes_free(mln_aes_t *a);
 extern void mln_aes_pool_free(mln_aes_t *a);
 extern int mln_aes_encrypt(mln_aes_t *a, mln_u8ptr_t text);
 extern int mln_aes_decrypt(mln_aes_t *a, mln_u8ptr_t cipher);
+/*
+ * Bulk counter mode. 'buf' is XORed in place with the keystream;
+ * 'counter' is the 16-byte counter block and is advanced (big-endian)
+ * one step per keystream block started. No partial-block keystream is
+ * carried between calls: a trailing fragment discards the rest of its
+ * keystream block, so when producing one stream over several calls,
+ * every call except the last must pass a multiple of 16 bytes.
+ * Encryption and decryption are the same operation.
+ */
+extern int mln_aes_ctr_crypt(mln_aes_t *a, mln_u8ptr_t counter, mln_u8ptr_t buf, mln_size_t len) __NONNULL3(1,2,3);
+/*
+ * AES-GCM. 'buf' is transformed in place; 'tag' is 16 bytes, written by
+ * encrypt and verified by decrypt. Decrypt leaves 'buf' untouched and
+ * returns -1 on authentication failure. 'aad' may be NULL with aadlen 0.
+ */
+extern int
+mln_aes_gcm_encrypt(mln_aes_t *a, \
+                    mln_u8ptr_t iv, mln_size_t ivlen, \
+                    mln_u8ptr_t aad, mln_size_t aadlen, \
+                    mln_u8ptr_t buf, mln_size_t len, \
+                    mln_u8ptr_t tag) __NONNULL3(1,2,8);
+extern int
+mln_aes_gcm_decrypt(mln_aes_t *a, \
+                    mln_u8ptr_t iv, mln_size_t ivlen, \
+                    mln_u8ptr_t aad, mln_size_t aadlen, \
+                    mln_u8ptr_t buf, mln_size_t len, \
+                    mln_u8ptr_t tag) __NONNULL3(1,2,8);
 
 #endif
 
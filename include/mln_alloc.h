@@ -19,18 +19,35 @@
 
 typedef int (*mln_alloc_shm_lock_cb_t)(void *);
 
+typedef struct mln_alloc_s       mln_alloc_t;
+
+typedef struct mln_alloc_stat_s {
+    mln_size_t                blk_size;  /*0 for the large one-off chunk record*/
+    mln_size_t                live_bytes;
+    mln_size_t                chunk_count;
+    mln_size_t                high_water;
+} mln_alloc_stat_t;
+
+typedef int  (*mln_alloc_stat_iterate_handler)(mln_alloc_stat_t *st, void *udata);
+typedef void (*mln_alloc_sample_handler)(mln_alloc_t *pool, mln_size_t size, void *caller, void *udata);
+
 #define M_ALLOC_BEGIN_OFF        ((mln_size_t)4)
 #define M_ALLOC_MGR_GRAIN_SIZE   2
 #define M_ALLOC_MGR_LEN          18*M_ALLOC_MGR_GRAIN_SIZE-(M_ALLOC_MGR_GRAIN_SIZE-1)
 #define M_ALLOC_BLK_NUM          4
 #define M_ALLOC_CHUNK_COUNT      1023
 
+#define M_ALLOC_TCACHE_COUNT     64
+#define M_ALLOC_TCACHE_BATCH     16
+
+#define M_ALLOC_SHM_CLS_NUM      8
+#define M_ALLOC_SHM_CLS_MIN      64
+
 #define M_ALLOC_SHM_BITMAP_LEN   4096
 #define M_ALLOC_SHM_BIT_SIZE     64
 #define M_ALLOC_SHM_LARGE_SIZE   (1*1024+512)*1024
 #define M_ALLOC_SHM_DEFAULT_SIZE 2*1024*1024
 
-typedef struct mln_alloc_s       mln_alloc_t;
 typedef struct mln_alloc_mgr_s   mln_alloc_mgr_t;
 typedef struct mln_alloc_chunk_s mln_alloc_chunk_t;
 
@@ -41,6 +58,11 @@ struct mln_alloc_shm_attr_s {
     mln_alloc_shm_lock_cb_t   unlock;
 };
 
+struct mln_alloc_arena_attr_s {
+    mln_size_t                size;    /*reservation, prefaulted at init*/
+    mln_u32_t                 hugepage;/*back the reservation with 2MB pages when available*/
+};
+
 /*
  * Note:
  * In Darwin, if set mln_alloc_blk_t's prev and next at the beginning of the structure,
@@ -78,6 +100,9 @@ struct mln_alloc_mgr_s {
     mln_alloc_blk_t          *used_tail;
     mln_alloc_chunk_t        *chunk_head;
     mln_alloc_chunk_t        *chunk_tail;
+    mln_size_t                live_bytes;
+    mln_size_t                chunk_count;
+    mln_size_t                high_water;
 };
 
 typedef struct mln_alloc_shm_s {
@@ -104,6 +129,21 @@ struct mln_alloc_s {
     void                     *locker;
     mln_alloc_shm_lock_cb_t   lock;
     mln_alloc_shm_lock_cb_t   unlock;
+    mln_u32_t                 tcache_enabled;
+    pthread_mutex_t           tcache_lock;
+    mln_size_t                cp_epoch;
+    mln_u32_t                 shm_lockfree;
+    mln_u64_t                 shm_cls[M_ALLOC_SHM_CLS_NUM];
+    void                     *arena;
+    mln_size_t                arena_size;
+    mln_size_t                arena_pos;
+    mln_u32_t                 stats_enabled;
+    mln_size_t                large_live;
+    mln_size_t                large_count;
+    mln_size_t                large_high;
+    mln_size_t                sample_threshold;
+    mln_alloc_sample_handler  sample_handler;
+    void                     *sample_data;
 #if defined(WIN32)
     HANDLE                    map_handle;
 #endif
@@ -113,12 +153,77 @@ struct mln_alloc_s {
 #define mln_alloc_is_shm(pool) (pool->mem != NULL)
 
 extern mln_alloc_t *mln_alloc_shm_init(struct mln_alloc_shm_attr_s *attr);
+/*
+ * Like mln_alloc_shm_init, but common sizes (64B..8KB classes) are
+ * recycled through CAS-based freelists living in the shm region, so
+ * alloc/free of those sizes never takes the attr lock. The lock is
+ * still required: the bitmap slow path and oversized requests take it
+ * internally, and callers must NOT wrap mln_alloc_m/free themselves.
+ */
+extern mln_alloc_t *mln_alloc_shm_lockfree_init(struct mln_alloc_shm_attr_s *attr);
 extern mln_alloc_t *mln_alloc_init(mln_alloc_t *parent);
+/*
+ * Heap pool whose chunks are carved from one mmap'd reservation instead
+ * of per-chunk malloc. The reservation is prefaulted at init (and backed
+ * by 2MB huge pages when requested and supported), which removes
+ * first-touch page faults and cuts TLB pressure for large interpreter
+ * heaps. Demand beyond the reservation falls back to malloc chunks.
+ */
+extern mln_alloc_t *mln_alloc_arena_init(struct mln_alloc_arena_attr_s *attr);
+/*
+ * Turn the pool into a shared pool usable from many threads. Each thread
+ * keeps a magazine of small blocks per size class and batch-refills it
+ * from the pool under an internal lock, so the common alloc/free path is
+ * lock-free. A thread's magazine binds to the first shared pool it touches.
+ * Not supported on shm pools.
+ */
+extern int mln_alloc_thread_cache_enable(mln_alloc_t *pool);
+/*
+ * Opt-in accounting for heap pools. Once enabled, every size class keeps
+ * live bytes, chunk count and a high-water mark, and mln_alloc_stats walks
+ * them through the handler (blk_size 0 is the record for large one-off
+ * chunks). With the thread-cache layer on, magazine-cached blocks are
+ * accounted as live. mln_alloc_sample_set installs a hook invoked for any
+ * allocation of at least 'threshold' bytes with the caller's return
+ * address, so hot callsites can be dumped through mln_log without a
+ * debugger; a NULL handler removes the hook.
+ */
+extern int mln_alloc_stats_enable(mln_alloc_t *pool);
+extern int mln_alloc_stats(mln_alloc_t *pool, mln_alloc_stat_iterate_handler handler, void *udata);
+extern void mln_alloc_sample_set(mln_alloc_t *pool, \
+                                 mln_size_t threshold, \
+                                 mln_alloc_sample_handler handler, \
+                                 void *udata);
+/*
+ * Request-scoped reclamation for heap pools. mln_alloc_reset releases
+ * every live block back onto the chunk freelists without tearing down
+ * the manager table, so the chunks stay warm for the next request.
+ * mln_alloc_checkpoint marks a position and mln_alloc_rollback releases
+ * everything allocated since that mark. Not available on shm pools and
+ * not meant to be combined with the thread-cache layer.
+ */
+typedef mln_size_t mln_alloc_checkpoint_t;
+extern void mln_alloc_reset(mln_alloc_t *pool);
+extern mln_alloc_checkpoint_t mln_alloc_checkpoint(mln_alloc_t *pool);
+extern void mln_alloc_rollback(mln_alloc_t *pool, mln_alloc_checkpoint_t cp);
 extern void mln_alloc_destroy(mln_alloc_t *pool);
-extern void *mln_alloc_m(mln_alloc_t *pool, mln_size_t size);
+extern void *mln_alloc_m(mln_alloc_t *pool, mln_size_t size) __HOT__;
 extern void *mln_alloc_c(mln_alloc_t *pool, mln_size_t size);
 extern void *mln_alloc_re(mln_alloc_t *pool, void *ptr, mln_size_t size);
-extern void mln_alloc_free(void *ptr);
+/*
+ * Move the allocation at 'ptr' into 'pool' and return its (unchanged)
+ * address. Large allocations own their chunk and are relinked outright;
+ * a small allocation migrates when it is the only live block of its
+ * chunk, which then becomes a donor: the chunk moves wholesale and its
+ * free blocks join the destination's freelists. When relinking is not
+ * possible (shm pools, thread-cached pools, pools with different
+ * parents, arena-carved or shared chunks) the data is copied into
+ * 'pool' instead and a new address is returned, so callers promoting
+ * data to a longer-lived pool can always use this one call; NULL means
+ * the fallback copy failed.
+ */
+extern void *mln_alloc_adopt(mln_alloc_t *pool, void *ptr) __NONNULL1(1);
+extern void mln_alloc_free(void *ptr) __HOT__;
 
 #endif
 
@@ -21,6 +21,14 @@ struct mln_array_attr {
     mln_size_t                nalloc;
 };
 
+/*
+ * Inline capacity in bytes for arrays set up with
+ * mln_array_inline_init(); may be overridden at compile time.
+ */
+#ifndef M_ARRAY_INLINE_SIZE
+#define M_ARRAY_INLINE_SIZE 64
+#endif
+
 typedef struct {
     void                     *elts;
     mln_size_t                size;
@@ -30,12 +38,33 @@ typedef struct {
     array_pool_alloc_handler  pool_alloc;
     array_pool_free_handler   pool_free;
     array_free                free;
+    mln_u8_t                  inline_buf[M_ARRAY_INLINE_SIZE];
 } mln_array_t;
 
 #define mln_array_elts(arr)    ((arr)->elts)
 #define mln_array_nelts(arr)   ((arr)->nelts)
 
 extern int mln_array_init(mln_array_t *arr, struct mln_array_attr *attr) __NONNULL2(1,2);
+/*
+ * Like mln_array_init() but the first elements live in the structure
+ * itself (up to M_ARRAY_INLINE_SIZE bytes), so small arrays never
+ * allocate. Note: an array using its inline storage must not be
+ * relocated (e.g. stored by value inside another growing array) --
+ * 'elts' would keep pointing at the old location.
+ */
+extern int mln_array_inline_init(mln_array_t *arr, struct mln_array_attr *attr) __NONNULL2(1,2);
+/*
+ * Grow capacity to at least 'n' elements (rounded up to a power of
+ * two) in one step. Returns 0 on success, -1 on allocation failure.
+ */
+extern int mln_array_reserve(mln_array_t *arr, mln_size_t n) __NONNULL1(1);
+/*
+ * Append by moving: the element bytes are taken over from 'elt' and
+ * 'elt' is released back to the array's allocator (pool_free or
+ * free()), replacing the usual construct-copy-free sequence of
+ * separately allocated elements. Returns the new slot or NULL.
+ */
+extern void *mln_array_push_move(mln_array_t *arr, void *elt) __NONNULL2(1,2);
 extern mln_array_t *mln_array_new(struct mln_array_attr *attr) __NONNULL1(1);
 extern void mln_array_destroy(mln_array_t *arr);
 extern void mln_array_free(mln_array_t *arr);
@@ -14,6 +14,7 @@
 #define M_ASN1_RET_OK         0
 #define M_ASN1_RET_INCOMPLETE 1
 #define M_ASN1_RET_ERROR      2
+#define M_ASN1_RET_DONE       3
 
 /*
  * class
@@ -76,6 +77,47 @@ extern void mln_asn1_deresult_free(mln_asn1_deresult_t *res);
 extern mln_asn1_deresult_t *mln_asn1_deresult_content_get(mln_asn1_deresult_t *res, mln_u32_t index) __NONNULL1(1);
 extern void mln_asn1_deresult_dump(mln_asn1_deresult_t *res);
 
+/*
+ * Streaming decoder. Instead of materializing the whole structure tree
+ * as the mln_asn1_decode* family does, a walk cursor steps through the
+ * TLVs of one region: mln_asn1_walk_next() parses a single header,
+ * lends the content bytes as a slice into the caller's buffer (nothing
+ * is copied or allocated) and skips past the value by its length, so
+ * siblings that are never descended into are never parsed. Descend
+ * into a constructed node with mln_asn1_walk_in(), or grab one member
+ * directly with mln_asn1_node_child(). Slices stay valid as long as
+ * the decoded buffer does. Tag and length limits match the tree
+ * decoder (no high-tag-number form, lengths up to 8 bytes).
+ */
+typedef struct {
+    mln_string_t                code;    /*whole TLV*/
+    mln_string_t                content; /*value bytes*/
+    mln_u32_t                   _class:2;
+    mln_u32_t                   is_struct:1;
+    mln_u32_t                   ident:28;
+} mln_asn1_node_t;
+
+typedef struct {
+    mln_u8ptr_t                 pos;
+    mln_u8ptr_t                 end;
+} mln_asn1_walk_t;
+
+#define mln_asn1_node_class_get(n)    ((n)->_class)
+#define mln_asn1_node_isstruct_get(n) ((n)->is_struct)
+#define mln_asn1_node_ident_get(n)    ((n)->ident)
+#define mln_asn1_node_code_get(n)     (&(n)->code)
+#define mln_asn1_node_content_get(n)  (&(n)->content)
+
+extern void mln_asn1_walk_init(mln_asn1_walk_t *w, void *data, mln_u64_t len) __NONNULL2(1,2);
+/*
+ * Fills 'node' with the next TLV and moves the cursor past it.
+ * Returns M_ASN1_RET_OK, M_ASN1_RET_DONE at the end of the region,
+ * M_ASN1_RET_INCOMPLETE on truncation or M_ASN1_RET_ERROR.
+ */
+extern int mln_asn1_walk_next(mln_asn1_walk_t *w, mln_asn1_node_t *node) __NONNULL2(1,2);
+extern void mln_asn1_walk_in(mln_asn1_walk_t *w, mln_asn1_node_t *node) __NONNULL2(1,2);
+extern int mln_asn1_node_child(mln_asn1_node_t *parent, mln_u32_t index, mln_asn1_node_t *out) __NONNULL2(1,3);
+
 
 typedef struct {
     mln_alloc_t             *pool;
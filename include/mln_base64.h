@@ -7,11 +7,19 @@
 
 #include "mln_types.h"
 #include "mln_alloc.h"
+#include "mln_chain.h"
 
 extern int
 mln_base64_encode(mln_u8ptr_t in, mln_uauto_t inlen, mln_u8ptr_t *out, mln_uauto_t *outlen) __NONNULL3(1,3,4);
 extern int
 mln_base64_pool_encode(mln_alloc_t *pool, mln_u8ptr_t in, mln_uauto_t inlen, mln_u8ptr_t *out, mln_uauto_t *outlen) __NONNULL4(1,2,4,5);
+/*
+ * Encodes straight into a pool-allocated chain node so the result can
+ * be handed to mln_tcp_conn_append() without another copy. Returns
+ * NULL on allocation failure; release with mln_chain_pool_release().
+ */
+extern mln_chain_t *
+mln_base64_chain_encode(mln_alloc_t *pool, mln_u8ptr_t in, mln_uauto_t inlen) __NONNULL2(1,2);
 extern int
 mln_base64_decode(mln_u8ptr_t in, mln_uauto_t inlen, mln_u8ptr_t *out, mln_uauto_t *outlen) __NONNULL3(1,3,4);
 extern int
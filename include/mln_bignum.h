@@ -22,6 +22,19 @@ typedef struct {
     mln_u64_t data[M_BIGNUM_SIZE];
 } mln_bignum_t;
 
+/*
+ * Bump allocator over a caller-provided (or pool-backed) array of
+ * bignums. A caller running many operations can allocate every
+ * transient value from one arena and drop them all with a single
+ * mln_bignum_scratch_reset() instead of one mln_bignum_new()/free()
+ * pair per value.
+ */
+typedef struct {
+    mln_bignum_t *base;
+    mln_u32_t     size;
+    mln_u32_t     pos;
+} mln_bignum_scratch_t;
+
 #define mln_bignum_init(bn)         ({\
     bn.tag = M_BIGNUM_POSITIVE;\
     bn.length = 0;\
@@ -33,10 +46,16 @@ typedef struct {
 #define mln_bignum_is_negative(pbn) ((pbn)->tag == M_BIGNUM_NEGATIVE)
 #define mln_bignum_get_length(pbn)  ((pbn)->length)
 #define mln_bignum_zero()           {M_BIGNUM_POSITIVE, 0, {0}}
+#define mln_bignum_scratch_reset(sc)  ((sc)->pos = 0)
+#define mln_bignum_scratch_left(sc)   ((sc)->size - (sc)->pos)
 extern mln_bignum_t *mln_bignum_new(void);
 extern mln_bignum_t *mln_bignum_pool_new(mln_alloc_t *pool) __NONNULL1(1);
 extern void mln_bignum_free(mln_bignum_t *bn);
 extern void mln_bignum_pool_free(mln_bignum_t *bn);
+extern void mln_bignum_scratch_init(mln_bignum_scratch_t *sc, mln_bignum_t *base, mln_u32_t n) __NONNULL2(1,2);
+extern mln_bignum_scratch_t *mln_bignum_scratch_pool_new(mln_alloc_t *pool, mln_u32_t n) __NONNULL1(1);
+extern void mln_bignum_scratch_pool_free(mln_bignum_scratch_t *sc);
+extern mln_bignum_t *mln_bignum_scratch_alloc(mln_bignum_scratch_t *sc) __NONNULL1(1);
 extern mln_bignum_t *mln_bignum_dup(mln_bignum_t *bn) __NONNULL1(1);
 extern mln_bignum_t *mln_bignum_pool_dup(mln_alloc_t *pool, mln_bignum_t *bn) __NONNULL2(1,2);
 extern int mln_bignum_assign(mln_bignum_t *bn, mln_s8ptr_t sval, mln_u32_t len) __NONNULL2(1,2);
@@ -0,0 +1,67 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#ifndef __MLN_CHACHA20_H
+#define __MLN_CHACHA20_H
+
+#include "mln_types.h"
+#include "mln_chain.h"
+
+#define __M_CHACHA20_BLOCKLEN    64
+#define __M_POLY1305_BLOCKLEN    16
+#define __M_POLY1305_TAGLEN      16
+
+typedef struct {
+    mln_u32_t   state[16];
+    mln_u8_t    stream[__M_CHACHA20_BLOCKLEN];
+    mln_u32_t   pos;
+} mln_chacha20_t;
+
+typedef struct {
+    mln_u32_t   r[5];
+    mln_u32_t   h[5];
+    mln_u32_t   pad[4];
+    mln_u8_t    buf[__M_POLY1305_BLOCKLEN];
+    mln_u32_t   pos;
+} mln_poly1305_t;
+
+/*
+ * RFC 8439 ChaCha20. 'key' is 32 bytes, 'nonce' is 12 bytes; 'counter'
+ * is the initial block counter (0 unless resuming a stream).
+ * mln_chacha20_calc() XORs the keystream into 'data' in place, so the
+ * same call sequence encrypts and decrypts, like mln_rc4_calc().
+ */
+extern void mln_chacha20_init(mln_chacha20_t *c, mln_u8ptr_t key, mln_u8ptr_t nonce, mln_u32_t counter) __NONNULL3(1,2,3);
+extern void mln_chacha20_calc(mln_chacha20_t *c, mln_u8ptr_t data, mln_uauto_t len) __NONNULL1(1);
+/*
+ * XOR the keystream into every in-memory buffer of 'in' (pos..last) in
+ * place, so a received chain can be deciphered without assembling it.
+ */
+extern void mln_chacha20_calc_chain(mln_chacha20_t *c, mln_chain_t *in) __NONNULL1(1);
+
+/*
+ * RFC 8439 Poly1305. 'key' is the 32-byte one-time key. Feed data with
+ * mln_poly1305_calc() ('is_last' finalizes, like mln_md5_calc()), then
+ * read the 16-byte tag with mln_poly1305_tobytes().
+ */
+extern void mln_poly1305_init(mln_poly1305_t *p, mln_u8ptr_t key) __NONNULL2(1,2);
+extern void mln_poly1305_calc(mln_poly1305_t *p, mln_u8ptr_t input, mln_uauto_t len, mln_u32_t is_last) __NONNULL1(1);
+extern void mln_poly1305_tobytes(mln_poly1305_t *p, mln_u8ptr_t tag, mln_u32_t len) __NONNULL1(1);
+
+/*
+ * RFC 8439 AEAD. Encryption ciphers 'data' in place and writes the
+ * 16-byte tag; decryption verifies the tag first and returns -1 without
+ * touching 'data' on mismatch, 0 on success.
+ */
+extern void mln_chacha20_poly1305_encrypt(mln_u8ptr_t key, mln_u8ptr_t nonce, \
+                                          mln_u8ptr_t aad, mln_uauto_t aadlen, \
+                                          mln_u8ptr_t data, mln_uauto_t len, \
+                                          mln_u8ptr_t tag) __NONNULL3(1,2,7);
+extern int mln_chacha20_poly1305_decrypt(mln_u8ptr_t key, mln_u8ptr_t nonce, \
+                                         mln_u8ptr_t aad, mln_uauto_t aadlen, \
+                                         mln_u8ptr_t data, mln_uauto_t len, \
+                                         mln_u8ptr_t tag) __NONNULL3(1,2,7);
+
+#endif
+
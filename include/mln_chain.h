@@ -22,7 +22,9 @@ typedef struct mln_buf_s {
     mln_off_t           file_pos;
     mln_off_t           file_last;
     mln_file_t         *file;
+    mln_u32_t           ref;/*outstanding shadows created by mln_buf_ref()*/
     mln_u32_t           temporary:1;
+    mln_u32_t           released:1;/*owner gone, data lives until the last shadow drops*/
 #if !defined(WIN32)
     mln_u32_t           mmap:1;
 #endif
@@ -60,6 +62,22 @@ typedef struct mln_chain_s {
 
 extern mln_buf_t *mln_buf_new(mln_alloc_t *pool);
 extern mln_chain_t *mln_chain_new(mln_alloc_t *pool);
+/*
+ * mln_buf_ref():
+ * Share 'b''s underlying data without copying it. The returned shadow
+ * buf carries its own positions, so every chain holding one can send
+ * at its own pace; the data is freed only after the owner and all of
+ * its shadows have been released.
+ */
+extern mln_buf_t *mln_buf_ref(mln_alloc_t *pool, mln_buf_t *b);
+/*
+ * mln_buf_reset():
+ * Drop whatever 'b' references (same ownership rules as
+ * mln_buf_pool_release()) but keep the descriptor, reinitialized as if
+ * it just came from mln_buf_new(). 'b' must not be referenced by any
+ * shadow (b->ref == 0).
+ */
+extern void mln_buf_reset(mln_buf_t *b);
 extern void mln_buf_pool_release(mln_buf_t *b);
 extern void mln_chain_pool_release(mln_chain_t *c);
 extern void mln_chain_pool_release_all(mln_chain_t *c);
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#ifndef __MLN_CLOCK_H
+#define __MLN_CLOCK_H
+
+#include <time.h>
+#if defined(WIN32)
+#include <winsock2.h>
+#else
+#include <sys/time.h>
+#endif
+#include "mln_types.h"
+#include "mln_string.h"
+
+/*
+ * Coarse cached clock.
+ *
+ * Every running event loop refreshes the snapshot once per iteration --
+ * the poll timeout bounds the error to a few milliseconds -- so the hot
+ * consumers (timer bookkeeping, log record stamping, HTTP Date
+ * generation) read a cached word instead of issuing a system call
+ * apiece.  While no loop is running the getters fall back to a real
+ * clock read, so standalone callers never observe a stale value.
+ */
+
+extern volatile mln_u64_t mln_clock_mono_us_cached;
+extern volatile mln_u64_t mln_clock_wall_us_cached;
+extern volatile mln_u32_t mln_clock_driven;
+
+extern void mln_clock_update(void);
+extern void mln_clock_enter(void);
+extern void mln_clock_leave(void);
+extern mln_string_t *mln_clock_http_date(void);
+
+/*monotonic microseconds since an unspecified origin*/
+static inline mln_u64_t mln_clock_mono_us(void)
+{
+    if (!mln_clock_driven) mln_clock_update();
+    return mln_clock_mono_us_cached;
+}
+
+static inline mln_u64_t mln_clock_mono_ms(void)
+{
+    return mln_clock_mono_us() / 1000;
+}
+
+/*wall-clock time in the shape gettimeofday() hands out*/
+static inline void mln_clock_wall(struct timeval *tv)
+{
+    mln_u64_t us;
+    if (!mln_clock_driven) mln_clock_update();
+    us = mln_clock_wall_us_cached;
+    tv->tv_sec = (time_t)(us / 1000000);
+    tv->tv_usec = (long)(us % 1000000);
+}
+
+#endif
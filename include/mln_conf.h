@@ -13,6 +13,10 @@
 
 #define M_IPC_TYPE_CONF 1
 
+/*for compiled configuration cache*/
+#define M_CONF_CACHE_MAGIC   0x4d434346
+#define M_CONF_CACHE_VERSION 1
+
 typedef struct mln_conf_item_s    mln_conf_item_t;
 typedef struct mln_conf_domain_s  mln_conf_domain_t;
 typedef struct mln_conf_cmd_s     mln_conf_cmd_t;
@@ -70,6 +74,49 @@ struct mln_conf_s {
     mln_conf_domain_cb_t           remove;
 };
 
+/*
+ * Compiled configuration image. All offsets are relative to the start
+ * of the image, 0 meaning "none"; names and strings are stored
+ * NUL-terminated so they can be handed out as C strings.
+ */
+typedef struct {
+    mln_u32_t                      magic;
+    mln_u32_t                      version;
+    mln_u64_t                      hash;     /*content hash of the conf file*/
+    mln_u32_t                      nbuckets; /*domain buckets, power of two*/
+    mln_u32_t                      ndomains;
+    mln_u64_t                      size;
+} mln_conf_cache_header_t;
+
+typedef struct {
+    mln_u32_t                      next;     /*next domain in the same bucket*/
+    mln_u32_t                      name;
+    mln_u32_t                      name_len;
+    mln_u32_t                      nbuckets; /*command buckets, power of two*/
+    mln_u32_t                      ncmds;
+    mln_u32_t                      buckets;  /*offset of the command bucket array*/
+} mln_conf_cache_domain_t;
+
+typedef struct {
+    mln_u32_t                      next;
+    mln_u32_t                      name;
+    mln_u32_t                      name_len;
+    mln_u32_t                      n_args;
+    mln_u32_t                      args;     /*offset of the item array*/
+    mln_u32_t                      padding;
+} mln_conf_cache_cmd_t;
+
+typedef struct {
+    mln_u32_t                      type;     /*CONF_* of mln_conf_item_t*/
+    mln_u32_t                      slen;     /*string length for CONF_STR*/
+    mln_u64_t                      val;      /*CONF_STR: byte offset, others: raw value*/
+} mln_conf_cache_item_t;
+
+typedef struct {
+    void                          *map;
+    mln_size_t                     map_size;
+} mln_conf_cache_t;
+
 typedef struct mln_conf_hook_s {
     reload_handler                 reload;
     void                          *data;
@@ -77,6 +124,31 @@ typedef struct mln_conf_hook_s {
     struct mln_conf_hook_s        *next;
 } mln_conf_hook_t;
 
+/*
+ * Differential reload. After a re-parse, the new tree is compared with
+ * the old one and these hooks fire only for directives that actually
+ * changed, so subsystems whose directives are untouched skip
+ * reinitialization (the wholesale mln_conf_hook_set hooks still run).
+ */
+enum mln_conf_change_type {
+    M_CONF_CHANGE_ADD = 0,
+    M_CONF_CHANGE_MODIFY,
+    M_CONF_CHANGE_REMOVE
+};
+
+/*for M_CONF_CHANGE_REMOVE, 'cc' is the command from the old tree and
+ *is only valid for the duration of the call*/
+typedef int (*mln_conf_change_handler)(char *domain, mln_conf_cmd_t *cc, int type, void *data);
+
+typedef struct mln_conf_change_hook_s {
+    char                            *domain;
+    char                            *cmd;  /*NULL matches every command in the domain*/
+    mln_conf_change_handler          handler;
+    void                            *data;
+    struct mln_conf_change_hook_s   *prev;
+    struct mln_conf_change_hook_s   *next;
+} mln_conf_change_hook_t;
+
 /*
  * mln_conf_load should be called before any pthread_create
  */
@@ -88,6 +160,11 @@ extern void mln_conf_dump(void);
 extern mln_conf_hook_t *mln_conf_hook_set(reload_handler reload, void *data);
 extern void mln_conf_hook_unset(mln_conf_hook_t *hook);
 extern void mln_conf_hook_free(void);
+/*'domain' and 'cmd' are borrowed and must outlive the hook*/
+extern mln_conf_change_hook_t *
+mln_conf_change_hook_set(char *domain, char *cmd, mln_conf_change_handler handler, void *data) __NONNULL2(1,3);
+extern void mln_conf_change_hook_unset(mln_conf_change_hook_t *hook);
+extern void mln_conf_change_hook_free(void);
 
 extern mln_u32_t
 mln_conf_cmd_num(mln_conf_t *cf, char *domain) __NONNULL2(1,2);
@@ -96,5 +173,32 @@ mln_conf_cmds(mln_conf_t *cf, char *domain, mln_conf_cmd_t **vector) __NONNULL3(
 extern mln_u32_t
 mln_conf_arg_num(mln_conf_cmd_t *cc) __NONNULL1(1);
 
+/*
+ * Compiled configuration cache. mln_conf_cache_dump() serializes the
+ * loaded configuration into a flat hash-indexed image (written through
+ * a temporary file and renamed, keyed on a content hash of the conf
+ * file). mln_conf_cache_load() maps the image read-only so all
+ * mln_fork workers share one physical copy, and returns NULL when the
+ * image is missing, from another format version or built from a
+ * different conf file -- the caller then falls back to mln_conf().
+ * Domain and command lookup are one hash plus a short chain walk.
+ * mln_conf_cache_arg() fills 'out' with the item at 'index' (starting
+ * from 1, like mln_conf_item_cb_t); for CONF_STR items 'sbuf' is set
+ * to point into the image and out->val.s refers to it, so neither may
+ * outlive the cache.
+ */
+extern int mln_conf_cache_dump(const char *path);
+extern mln_conf_cache_t *mln_conf_cache_load(const char *path);
+extern void mln_conf_cache_free(mln_conf_cache_t *cache);
+extern mln_conf_cache_domain_t *mln_conf_cache_domain(mln_conf_cache_t *cache, char *domain) __NONNULL2(1,2);
+extern mln_conf_cache_cmd_t *
+mln_conf_cache_cmd(mln_conf_cache_t *cache, mln_conf_cache_domain_t *cd, char *cmd) __NONNULL3(1,2,3);
+extern int mln_conf_cache_arg(mln_conf_cache_t *cache, \
+                              mln_conf_cache_cmd_t *cmd, \
+                              mln_u32_t index, \
+                              mln_conf_item_t *out, \
+                              mln_string_t *sbuf) __NONNULL2(1,2);
+#define mln_conf_cache_arg_num(cmd) ((cmd)->n_args)
+
 #endif
 
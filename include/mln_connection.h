@@ -34,6 +34,22 @@
 #define M_C_TYPE_MEMORY 0x1
 #define M_C_TYPE_FILE   0x2
 
+/*kTLS cipher selection for mln_tcp_conn_ktls_set()*/
+#define M_C_TLS_AES_GCM_128 1
+#define M_C_TLS_AES_GCM_256 2
+/*TLS versions for mln_tcp_conn_ktls_param_t.version*/
+#define M_C_TLS_VERSION_1_2 0x0303
+#define M_C_TLS_VERSION_1_3 0x0304
+
+typedef struct {
+    mln_u16_t    version;   /*M_C_TLS_VERSION_1_2 or M_C_TLS_VERSION_1_3*/
+    mln_u16_t    cipher;    /*M_C_TLS_AES_GCM_128 or M_C_TLS_AES_GCM_256*/
+    mln_u8_t     iv[8];     /*explicit nonce part*/
+    mln_u8_t     key[32];   /*16 or 32 bytes used, per cipher*/
+    mln_u8_t     salt[4];   /*implicit nonce part*/
+    mln_u8_t     rec_seq[8];/*current record sequence number*/
+} mln_tcp_conn_ktls_param_t;
+
 typedef struct {
     mln_alloc_t *pool;
     mln_chain_t *rcv_head;
@@ -42,6 +58,9 @@ typedef struct {
     mln_chain_t *snd_tail;
     mln_chain_t *sent_head;
     mln_chain_t *sent_tail;
+    mln_chain_t *free_head;/*recycled descriptors, see mln_tcp_conn_chain_release()*/
+    mln_size_t   free_cnt;
+    mln_size_t   rcv_bufsize;/*adaptive: grows on full reads, shrinks on small ones*/
     int          sockfd;
 } mln_tcp_conn_t;
 
@@ -53,6 +72,21 @@ typedef struct {
 #define mln_tcp_conn_fd_set(pconn,fd) (pconn)->sockfd = (fd)
 #define mln_tcp_conn_pool_get(pconn) ((pconn)->pool)
 extern int mln_tcp_conn_init(mln_tcp_conn_t *tc, int sockfd) __NONNULL1(1);
+/*
+ * mln_tcp_conn_ktls_set():
+ * Hand the record layer of an externally negotiated TLS session to the
+ * kernel. The TLS ULP is attached to the connection's socket and the
+ * given session keys are programmed for the transmit ('tx') and/or
+ * receive ('rx') direction (either may be NULL). From then on
+ * mln_tcp_conn_send()/mln_tcp_conn_recv() move plaintext while the
+ * kernel encrypts on the wire, so the writev and sendfile zero-copy
+ * paths keep working for encrypted traffic.
+ * Return 0 on success, -1 on failure (errno set; always fails where
+ * the platform has no kTLS, e.g. non-Linux systems).
+ */
+extern int mln_tcp_conn_ktls_set(mln_tcp_conn_t *tc, \
+                                 mln_tcp_conn_ktls_param_t *tx, \
+                                 mln_tcp_conn_ktls_param_t *rx) __NONNULL1(1);
 extern void mln_tcp_conn_destroy(mln_tcp_conn_t *tc);
 extern void
 mln_tcp_conn_append_chain(mln_tcp_conn_t *tc, \
@@ -67,6 +101,84 @@ extern mln_chain_t *mln_tcp_conn_pop(mln_tcp_conn_t *tc, int type) __NONNULL1(1)
 extern mln_chain_t *mln_tcp_conn_tail(mln_tcp_conn_t *tc, int type) __NONNULL1(1);
 extern int mln_tcp_conn_send(mln_tcp_conn_t *tc) __NONNULL1(1);
 extern int mln_tcp_conn_recv(mln_tcp_conn_t *tc, mln_u32_t flag) __NONNULL1(1);
+/*
+ * mln_tcp_conn_chain_release():
+ * Like mln_chain_pool_release_all(), but parks the chain and buf
+ * descriptors on the connection's freelist (up to a fixed cap) so the
+ * next receive reuses them instead of allocating. Intended for links
+ * collected from the sent chain on keep-alive connections.
+ */
+extern void mln_tcp_conn_chain_release(mln_tcp_conn_t *tc, mln_chain_t *c) __NONNULL1(1);
+
+/*
+ * batched UDP I/O
+ *
+ * A UDP connection moves datagrams in batches: mln_udp_conn_recv()
+ * fills an array of datagrams with one recvmmsg() call, queued sends
+ * are flushed with one sendmmsg() in mln_udp_conn_send(). Where the
+ * platform lacks recvmmsg/sendmmsg the same interface falls back to a
+ * recvfrom/sendto loop. Sockets are expected to be nonblocking and
+ * driven by mln_event handlers, like their TCP counterpart.
+ */
+
+/*datagrams moved per syscall*/
+#define M_C_UDP_BATCH_MAX 64
+
+typedef struct {
+    struct sockaddr_storage addr;     /*peer address*/
+    mln_u32_t               addr_len; /*0 on a connected socket*/
+    mln_u8ptr_t             data;     /*payload, allocated from the connection pool*/
+    mln_size_t              len;
+} mln_udp_dgram_t;
+
+typedef struct mln_udp_dgram_node_s mln_udp_dgram_node_t;
+
+typedef struct {
+    mln_alloc_t            *pool;
+    mln_udp_dgram_node_t   *snd_head;
+    mln_udp_dgram_node_t   *snd_tail;
+    mln_size_t              snd_nr;
+    mln_size_t              rcv_bufsize;/*per-datagram receive buffer size*/
+    int                     sockfd;
+} mln_udp_conn_t;
+
+#define mln_udp_conn_send_empty(pconn) ((pconn)->snd_head == NULL)
+#define mln_udp_conn_fd_get(pconn) ((pconn)->sockfd)
+#define mln_udp_conn_fd_set(pconn,fd) (pconn)->sockfd = (fd)
+#define mln_udp_conn_pool_get(pconn) ((pconn)->pool)
+#define mln_udp_conn_rcv_bufsize_set(pconn,size) (pconn)->rcv_bufsize = (size)
+
+extern int mln_udp_conn_init(mln_udp_conn_t *uc, int sockfd) __NONNULL1(1);
+extern void mln_udp_conn_destroy(mln_udp_conn_t *uc);
+/*
+ * Queue one datagram for 'addr' ('addr' NULL on a connected socket).
+ * The payload is copied into the connection pool, so the caller's
+ * buffer may be reused immediately. Return 0, or -1 on allocation
+ * failure.
+ */
+extern int mln_udp_conn_append(mln_udp_conn_t *uc, \
+                               void *buf, \
+                               mln_size_t len, \
+                               struct sockaddr *addr, \
+                               mln_u32_t addr_len) __NONNULL2(1,2);
+/*
+ * Flush the queued datagrams, M_C_UDP_BATCH_MAX per syscall.
+ * Return M_C_FINISH when the queue is drained, M_C_NOTYET when the
+ * socket would block (remaining datagrams stay queued), M_C_ERROR on
+ * failure.
+ */
+extern int mln_udp_conn_send(mln_udp_conn_t *uc) __NONNULL1(1);
+/*
+ * Receive up to 'ndgrams' (capped at M_C_UDP_BATCH_MAX) datagrams in
+ * one batch. Each received entry carries the source address and a
+ * payload of at most 'rcv_bufsize' bytes allocated from the connection
+ * pool; the caller releases it with mln_alloc_free() once consumed.
+ * Return the number received (0 when the socket would block), or -1 on
+ * failure.
+ */
+extern int mln_udp_conn_recv(mln_udp_conn_t *uc, \
+                             mln_udp_dgram_t *dgrams, \
+                             mln_size_t ndgrams) __NONNULL2(1,2);
 
 #endif
 
@@ -7,7 +7,62 @@
 
 #include <time.h>
 #include "mln_string.h"
+#include "mln_fheap.h"
 
 extern time_t mln_cron_parse(mln_string_t *exp, time_t base) __NONNULL1(1);
 
+/*
+ * Compiled cron expression: each field is parsed once into a bitmask
+ * (bit i set means value i matches), so next-fire queries walk
+ * calendar fields without touching the expression string again.
+ * Fields support '*', values, 'a-b' ranges, ',' lists and '/step',
+ * with day-of-month and day-of-week both required to match when both
+ * are restricted.
+ */
+typedef struct {
+    mln_u64_t        minutes; /*bits 0-59*/
+    mln_u32_t        hours;   /*bits 0-23*/
+    mln_u32_t        days;    /*bits 1-31*/
+    mln_u16_t        months;  /*bits 1-12*/
+    mln_u8_t         weeks;   /*bits 0-6, 7 folded onto 0*/
+} mln_cron_t;
+
+typedef struct {
+    mln_cron_t        cron;
+    time_t            next;
+    void             *data;
+    mln_fheap_node_t *node;
+} mln_cron_task_t;
+
+typedef struct {
+    mln_fheap_t      *heap;
+} mln_cron_sched_t;
+
+#define mln_cron_task_data(t) ((t)->data)
+#define mln_cron_task_next(t) ((t)->next)
+
+extern int mln_cron_compile(mln_cron_t *c, mln_string_t *exp) __NONNULL2(1,2);
+/*
+ * First firing time strictly after 'base', or 0 if the expression
+ * cannot be satisfied.
+ */
+extern time_t mln_cron_next(mln_cron_t *c, time_t base) __NONNULL1(1);
+
+/*
+ * Entry scheduler: tasks sit in a min-heap ordered by next-fire time,
+ * so a tick pops due entries in O(due log n) instead of re-evaluating
+ * every expression. mln_cron_sched_pop() returns one due task at a
+ * time (NULL when nothing is due), rescheduling it to its next firing
+ * before returning; the returned pointer stays valid until the task
+ * is removed or the scheduler is freed. Should the expression never
+ * fire again, 'next' is 0 and the task leaves the heap -- the caller
+ * then owns it and releases it with mln_cron_sched_remove().
+ */
+extern mln_cron_sched_t *mln_cron_sched_new(void);
+extern void mln_cron_sched_free(mln_cron_sched_t *s);
+extern mln_cron_task_t *
+mln_cron_sched_add(mln_cron_sched_t *s, mln_string_t *exp, time_t base, void *data) __NONNULL2(1,2);
+extern void mln_cron_sched_remove(mln_cron_sched_t *s, mln_cron_task_t *t) __NONNULL2(1,2);
+extern mln_cron_task_t *mln_cron_sched_pop(mln_cron_sched_t *s, time_t now) __NONNULL1(1);
+
 #endif
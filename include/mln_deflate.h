@@ -0,0 +1,60 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#ifndef __MLN_DEFLATE_H
+#define __MLN_DEFLATE_H
+
+#include "mln_types.h"
+#include "mln_alloc.h"
+
+#define M_DEFLATE_WINDOW_SIZE 32768
+
+/*
+ * Raw DEFLATE (RFC 1951) codec with an optional persistent 32KB
+ * sliding window ('takeover'), as needed by permessage-deflate:
+ * with takeover enabled the window survives across calls so later
+ * messages may back-reference earlier ones; without it every call
+ * starts from an empty history.
+ * One context handles one direction of one stream -- use separate
+ * contexts for compression and decompression.
+ */
+typedef struct mln_deflate_s {
+    mln_alloc_t             *pool;
+    mln_u8ptr_t              window;
+    mln_size_t               wlen;
+    mln_u32_t                takeover:1;
+    mln_u32_t                padding:31;
+} mln_deflate_t;
+
+extern mln_deflate_t *mln_deflate_new(mln_alloc_t *pool, int takeover);
+extern void mln_deflate_free(mln_deflate_t *ctx);
+extern void mln_deflate_reset(mln_deflate_t *ctx);
+/*
+ * mln_deflate_compress():
+ * Compress 'in' into a fixed-Huffman DEFLATE stream ending on a byte
+ * boundary with the trailing empty stored block removed, exactly the
+ * per-message form permessage-deflate puts on the wire. '*out' is
+ * allocated from the context's pool; release it with mln_alloc_free().
+ * Return 0 on success or -1 on failure.
+ */
+extern int mln_deflate_compress(mln_deflate_t *ctx, \
+                                mln_u8ptr_t in, \
+                                mln_size_t inlen, \
+                                mln_u8ptr_t *out, \
+                                mln_size_t *outlen);
+/*
+ * mln_deflate_decompress():
+ * Inflate a raw DEFLATE stream (stored, fixed and dynamic Huffman
+ * blocks). Decoding stops at a final block or at the end of input,
+ * whichever comes first. Allocation and return value conventions are
+ * the same as mln_deflate_compress().
+ */
+extern int mln_deflate_decompress(mln_deflate_t *ctx, \
+                                  mln_u8ptr_t in, \
+                                  mln_size_t inlen, \
+                                  mln_u8ptr_t *out, \
+                                  mln_size_t *outlen);
+
+#endif
+
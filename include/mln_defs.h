@@ -43,6 +43,25 @@
 #define __NONNULL5(v,w,x,y,z) __nonnull((v)) __nonnull((w)) __nonnull((x)) __nonnull((y)) __nonnull((z))
 #endif
 
+/*
+ * branch and function placement hints. mln_likely/mln_unlikely steer
+ * static branch prediction and block layout on hot paths; __HOT__ and
+ * __COLD__ group the annotated functions into the hot/cold text
+ * sections so the frequently executed code shares fewer pages. All of
+ * them compile away on toolchains without the attributes.
+ */
+#if defined(__GNUC__)
+#define mln_likely(x)   __builtin_expect(!!(x), 1)
+#define mln_unlikely(x) __builtin_expect(!!(x), 0)
+#define __HOT__         __attribute__((hot))
+#define __COLD__        __attribute__((cold))
+#else
+#define mln_likely(x)   (x)
+#define mln_unlikely(x) (x)
+#define __HOT__
+#define __COLD__
+#endif
+
 /*
  * lock
  */
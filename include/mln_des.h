@@ -54,6 +54,17 @@ extern void mln_des_buf(mln_des_t *d, \
                         mln_u8ptr_t out, mln_uauto_t outlen, \
                         mln_u8_t fill, \
                         mln_u32_t is_encrypt) __NONNULL3(1,2,4);
+/*
+ * CBC over whole buffers, framed like mln_des_buf() (a short tail is
+ * padded with 'fill'). The caller owns the IV; to continue a stream,
+ * pass the previous call's last ciphertext block as the next IV.
+ */
+extern void mln_des_cbc_buf(mln_des_t *d, \
+                            mln_u8ptr_t in, mln_uauto_t inlen, \
+                            mln_u8ptr_t out, mln_uauto_t outlen, \
+                            mln_u8_t fill, \
+                            mln_u64_t iv, \
+                            mln_u32_t is_encrypt) __NONNULL3(1,2,4);
 
 typedef struct {
     mln_des_t _1key;
@@ -71,6 +82,12 @@ extern void mln_3des_buf(mln_3des_t *tdes, \
                          mln_u8ptr_t out, mln_uauto_t outlen, \
                          mln_u8_t fill, \
                          mln_u32_t is_encrypt) __NONNULL3(1,2,4);
+extern void mln_3des_cbc_buf(mln_3des_t *tdes, \
+                             mln_u8ptr_t in, mln_uauto_t inlen, \
+                             mln_u8ptr_t out, mln_uauto_t outlen, \
+                             mln_u8_t fill, \
+                             mln_u64_t iv, \
+                             mln_u32_t is_encrypt) __NONNULL3(1,2,4);
 
 #endif
 
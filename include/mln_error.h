@@ -15,23 +15,21 @@ extern mln_size_t    mln_error_nmsg;
 
 #define __FILENAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 
+/*
+ * Builds the packed error integer: file index, line and code only. The
+ * file index is resolved once per call site and kept in a site-local
+ * static, so returning an error costs a few instructions -- no table
+ * scan, no formatting, no allocation -- and every string is rendered
+ * lazily by mln_error_string(). The unsynchronized cache write is
+ * benign, every racer stores the same index.
+ */
 #define RET(code) ({\
+    static int mln_error_fidx_cache = -1;\
     int r, l = __LINE__ >= 0x3fff? 0x3fff: (__LINE__ & 0x3fff);\
     int c = ((code) < 0 || (code) >= 0xff)? 0xff: (((code) & 0xff) >= mln_error_nmsg? 0xff: ((code) & 0xff));\
     if (c > 0) {\
-        if (mln_error_filenames == NULL) {\
-            r = 0x1ff;\
-        } else {\
-            mln_string_t tmp;\
-            mln_string_set(&tmp, __FILENAME__);\
-            for (r = 0; r < mln_error_nfile; ++r) {\
-                if (!mln_string_strcmp(&tmp, &mln_error_filenames[r]))\
-                    break;\
-            }\
-            if (r >= 0x1ff || r >= mln_error_nfile) {\
-                r = 0x1ff;\
-            }\
-        }\
+        if ((r = mln_error_fidx_cache) < 0)\
+            r = mln_error_filenames == NULL? 0x1ff: (mln_error_fidx_cache = mln_error_file_index(__FILENAME__));\
         r = (r << 22) | (l << 8) | c;\
         r = -r;\
     } else {\
@@ -40,9 +38,16 @@ extern mln_size_t    mln_error_nmsg;
     r;\
 })
 
-#define CODE(r)   ((-(r)) & 0xff)
+/*
+ * Field accessors over the packed integer, for callers that inspect or
+ * route an error without ever printing it.
+ */
+#define CODE(r)    ((-(r)) & 0xff)
+#define LINENO(r)  (((-(r)) >> 8) & 0x3fff)
+#define FILEIDX(r) (((-(r)) >> 22) & 0x1ff)
 
 extern void mln_error_init(mln_string_t *filenames, mln_string_t *errmsgs, mln_size_t nfile, mln_size_t nmsg);
+extern int mln_error_file_index(const char *filename) __NONNULL1(1);
 extern char *mln_error_string(int err, void *buf, mln_size_t len);
 
 #endif
@@ -6,7 +6,13 @@
 #ifndef __MLN_EVENT_H
 #define __MLN_EVENT_H
 
-#if defined(MLN_EPOLL)
+#if defined(MLN_IO_URING)
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <poll.h>
+#elif defined(MLN_EPOLL)
 #include <sys/epoll.h>
 #elif defined(MLN_KQUEUE)
 #include <sys/event.h>
@@ -27,6 +33,13 @@
 /*common*/
 #define M_EV_HASH_LEN 64
 #define M_EV_EPOLL_SIZE 1024 /*already ignored, see man epoll_create*/
+/*for timer mode*/
+#define M_EV_TIMER_FHEAP 0
+#define M_EV_TIMER_WHEEL 1
+#define M_EV_WHEEL_BITS   6
+#define M_EV_WHEEL_SLOTS  (1 << M_EV_WHEEL_BITS)
+#define M_EV_WHEEL_MASK   (M_EV_WHEEL_SLOTS - 1)
+#define M_EV_WHEEL_LEVELS 4
 /*for fd*/
 #define M_EV_RECV ((mln_u32_t)0x1)
 #define M_EV_SEND ((mln_u32_t)0x2)
@@ -37,7 +50,8 @@
 #define M_EV_BLOCK ((mln_u32_t)0x20)
 #define M_EV_APPEND ((mln_u32_t)0x40)
 #define M_EV_CLR ((mln_u32_t)0x80)
-#define M_EV_FD_MASK ((mln_u32_t)0xff)
+#define M_EV_ET ((mln_u32_t)0x100) /*edge-triggered, epoll/kqueue only*/
+#define M_EV_FD_MASK ((mln_u32_t)0x1ff)
 #define M_EV_UNLIMITED -1
 #define M_EV_UNMODIFIED -2
 /*for epool, kqueue, select*/
@@ -83,7 +97,13 @@ typedef struct mln_event_fd_s {
     mln_u32_t                rd_oneshot:1;
     mln_u32_t                wr_oneshot:1;
     mln_u32_t                err_oneshot:1;
-    mln_u32_t                padding:26;
+    mln_u32_t                uring_armed:3;/*events submitted to io_uring, unused by other backends*/
+    mln_u32_t                et:1;
+    mln_u32_t                armed_valid:1;/*the armed_* caches below reflect kernel state*/
+    mln_u32_t                rd_armed:2;   /*kqueue read filter: 0 disabled, 1 enabled, 2 enabled|clear*/
+    mln_u32_t                wr_armed:2;   /*kqueue write filter, same encoding*/
+    mln_u32_t                padding:17;
+    mln_u32_t                armed_events; /*epoll event mask last handed to the kernel*/
 } mln_event_fd_t;
 
 typedef struct mln_event_tm_s {
@@ -115,6 +135,8 @@ struct mln_event_s {
     mln_event_desc_t        *ev_fd_active_tail;
     mln_fheap_t             *ev_fd_timeout_heap;
     mln_fheap_t             *ev_timer_heap;
+    void                    *ev_timer_wheel;
+    void                    *stats;
     mln_u32_t                is_break:1;
     mln_u32_t                padding:31;
     int                      rd_fd;
@@ -122,12 +144,32 @@ struct mln_event_s {
     pthread_mutex_t          fd_lock;
     pthread_mutex_t          timer_lock;
     pthread_mutex_t          cb_lock;
-#if defined(MLN_EPOLL)
+#if defined(MLN_IO_URING)
+    int                      ring_fd;
+    mln_u32_t                sqe_entries;
+    mln_u32_t                sq_mask;
+    mln_u32_t                cq_mask;
+    mln_u32_t               *sq_head;
+    mln_u32_t               *sq_tail;
+    mln_u32_t               *sq_array;
+    mln_u32_t               *cq_head;
+    mln_u32_t               *cq_tail;
+    struct io_uring_sqe     *sqes;
+    struct io_uring_cqe     *cqes;
+    void                    *sq_ring;
+    void                    *cq_ring;
+    mln_size_t               sq_ring_size;
+    mln_size_t               cq_ring_size;
+    mln_size_t               sqes_size;
+    struct __kernel_timespec uring_ts;
+#elif defined(MLN_EPOLL)
     int                      epollfd;
     int                      unusedfd;
 #elif defined(MLN_KQUEUE)
     int                      kqfd;
     int                      unusedfd;
+    struct kevent           *kq_chg;      /*non-NULL while a batch collects changes*/
+    int                      kq_nchg;
 #else
     int                      select_fd;
     fd_set                   rd_set;
@@ -138,10 +180,37 @@ struct mln_event_s {
 
 #define mln_event_break_set(ev) ((ev)->is_break = 1);
 #define mln_event_break_reset(ev) ((ev)->is_break = 0);
+
+/*
+ * Dispatch instrumentation. When enabled, each loop iteration's
+ * processing phase (handlers, not the poll wait) is timed into a
+ * power-of-two-bucket latency histogram, and one callback in 'sample'
+ * is timed via the cycle counter to maintain max/total durations.
+ * Counters are per event loop; mln_event_stat_get() snapshots them
+ * with durations converted to microseconds. The snapshot is a flat
+ * struct, so a worker can ship it to the master verbatim (see
+ * mln_ipc_event_stat_send()).
+ */
+#define M_EV_STAT_HIST 32
+
+typedef struct {
+    mln_u64_t                loops;        /*dispatch iterations*/
+    mln_u64_t                fd_events;    /*fd handlers invoked*/
+    mln_u64_t                timer_events; /*timer handlers fired*/
+    mln_u64_t                cb_samples;   /*callbacks actually timed*/
+    mln_u64_t                cb_max_us;
+    mln_u64_t                cb_total_us;
+    mln_u64_t                hist[M_EV_STAT_HIST]; /*bucket i: [2^i, 2^(i+1)) us*/
+} mln_event_stat_t;
+
+extern int mln_event_stat_enable(mln_event_t *ev, mln_u32_t sample) __NONNULL1(1);
+extern void mln_event_stat_disable(mln_event_t *ev);
+extern int mln_event_stat_get(mln_event_t *ev, mln_event_stat_t *st) __NONNULL2(1,2);
+extern void mln_event_stat_reset(mln_event_t *ev);
 #define mln_event_signal_set signal
 extern mln_event_t *mln_event_new(void);
 extern void mln_event_free(mln_event_t *ev);
-extern void mln_event_dispatch(mln_event_t *event) __NONNULL1(1);
+extern void mln_event_dispatch(mln_event_t *event) __NONNULL1(1) __HOT__;
 /*
  * Note: There is a event named A triggered in thread t1,
  * and another event B triggered in thread t2. If we want to free
@@ -155,12 +224,63 @@ mln_event_fd_set(mln_event_t *event, \
                  int timeout_ms, \
                  void *data, \
                  ev_fd_handler fd_handler) __NONNULL1(1);
+/*
+ * Batched fd registration. Each entry carries the same arguments
+ * mln_event_fd_set() takes; the whole array is applied under one
+ * fd_lock acquisition, on kqueue the kernel changes accumulate into a
+ * single changelist submitted with one kevent() call, and on every
+ * backend a registration whose resulting kernel event mask equals the
+ * one already armed for that fd skips the kernel call entirely, so an
+ * accept burst that re-arms thousands of unchanged masks costs no
+ * syscalls. Entries are applied in order and may repeat an fd.
+ * Return 0, or -1 at the first entry that fails (earlier entries
+ * stay applied).
+ */
+typedef struct {
+    int                      fd;
+    mln_u32_t                flag;
+    int                      timeout_ms;
+    void                    *data;
+    ev_fd_handler            handler;
+} mln_event_fd_reg_t;
+
+extern int
+mln_event_fd_set_batch(mln_event_t *event, mln_event_fd_reg_t *regs, mln_size_t nregs) __NONNULL1(1);
+/*
+ * Note: the timer mode must be chosen right after mln_event_new and
+ * before any timer is set. M_EV_TIMER_WHEEL trades the heap's ordered
+ * extraction for O(1) insert/cancel, which suits high-churn per-connection
+ * idle timers.
+ */
+extern int mln_event_timer_mode_set(mln_event_t *event, int mode) __NONNULL1(1);
 extern mln_event_timer_t *
 mln_event_timer_set(mln_event_t *event, \
                     mln_u32_t msec, \
                     void *data, \
                     ev_tm_handler tm_handler) __NONNULL1(1);
+/*
+ * Like mln_event_timer_set(), but the timer may fire anywhere within
+ * [deadline, deadline+slack_msec]. Deadlines are rounded up to a
+ * slack-sized boundary, so timers set with the same slack land in the
+ * same expiry batch and are processed in one sweep instead of one
+ * wakeup apiece -- intended for coarse timers like idle-connection
+ * reaping, where thousands of deadlines cluster and seconds of slack
+ * are acceptable. slack_msec of 0 behaves exactly like
+ * mln_event_timer_set().
+ */
+extern mln_event_timer_t *
+mln_event_timer_set_slack(mln_event_t *event, \
+                          mln_u32_t msec, \
+                          mln_u32_t slack_msec, \
+                          void *data, \
+                          ev_tm_handler tm_handler) __NONNULL1(1);
 extern void mln_event_timer_cancel(mln_event_t *event, mln_event_timer_t *timer) __NONNULL1(1);
+/*
+ * Keeps invoking the fd's receive handler until the socket reports
+ * EAGAIN or EOF. Intended for M_EV_ET registrations where a single
+ * notification must fully drain the socket.
+ */
+extern int mln_event_fd_drain(mln_event_t *event, int fd) __NONNULL1(1);
 extern void
 mln_event_fd_timeout_handler_set(mln_event_t *event, \
                                  int fd, \
@@ -169,5 +289,33 @@ mln_event_fd_timeout_handler_set(mln_event_t *event, \
 extern void mln_event_callback_set(mln_event_t *ev, \
                                    dispatch_callback dc, \
                                    void *dc_data) __NONNULL1(1);
+
+#if !defined(WIN32)
+/*
+ * Multi-loop: N event loops pinned to cores inside one process.
+ * New fds are assigned to the least-loaded loop and a pipe-based
+ * wakeup lets any thread hand work to a sleeping loop.
+ */
+typedef struct mln_event_multi_s {
+    mln_event_t            **loops;
+    mln_size_t              *loads;
+    pthread_t               *tids;
+    mln_u32_t                nloops;
+} mln_event_multi_t;
+
+#define mln_event_multi_nloops(m)      ((m)->nloops)
+#define mln_event_multi_loop_get(m, i) ((m)->loops[(i)])
+extern mln_event_multi_t *mln_event_multi_new(mln_u32_t nloops);
+extern void mln_event_multi_free(mln_event_multi_t *m);
+extern int mln_event_wakeup(mln_event_t *ev) __NONNULL1(1);
+extern mln_event_t *
+mln_event_multi_fd_set(mln_event_multi_t *m, \
+                       int fd, \
+                       mln_u32_t flag, \
+                       int timeout_ms, \
+                       void *data, \
+                       ev_fd_handler fd_handler) __NONNULL1(1);
+extern int mln_event_multi_dispatch(mln_event_multi_t *m) __NONNULL1(1);
+#endif
 #endif
 
@@ -28,6 +28,24 @@ typedef struct {
     mln_u16_t               pt:7;    /*fec's rtp pt field*/
 } mln_fec_t;
 
+/*
+ * Incremental encoding state. The repair packet's accumulators are
+ * updated as each source packet is submitted, so closing a group only
+ * has to assemble the packet instead of re-XORing the whole group.
+ */
+typedef struct {
+    mln_fec_t              *fec;
+    mln_u8_t                header[M_FEC_FECHEADER_LEN]; /*XOR of 80-bit strings*/
+    mln_u8_t                body[M_FEC_G_MAXLEN];        /*XOR of packet payloads*/
+    mln_u8_t                sn[2];                       /*first packet's SN field*/
+    mln_u8_t                ts_ssrc[8];                  /*last packet's TS and SSRC*/
+    mln_u64_t               offsets;                     /*SN offsets seen in group*/
+    mln_u16_t               sn_base;
+    mln_u16_t               last_sn;
+    mln_u16_t               maxlen;
+    mln_u16_t               count;
+} mln_fec_group_t;
+
 #define mln_fec_set_pt(fec,_pt)        ((fec)->pt = (_pt))
 #define mln_fec_get_result(_result,index,_len)   \
   ((_result)->nr_packets<=(index)? \
@@ -43,6 +61,9 @@ mln_fec_encode(mln_fec_t *fec, uint8_t *packets[], uint16_t packlen[], size_t n,
 extern "C" void mln_fec_result_free(mln_fec_result_t *fr);
 extern "C" mln_fec_result_t *
 mln_fec_decode(mln_fec_t *fec, uint8_t *packets[], uint16_t *packlen, size_t n);
+extern "C" void mln_fec_group_init(mln_fec_t *fec, mln_fec_group_t *group);
+extern "C" int mln_fec_group_add(mln_fec_group_t *group, uint8_t *packet, uint16_t len);
+extern "C" mln_string_t *mln_fec_group_close(mln_fec_group_t *group);
 #else
 extern mln_fec_t *mln_fec_new(void);
 extern void mln_fec_free(mln_fec_t *fec);
@@ -51,6 +72,18 @@ mln_fec_encode(mln_fec_t *fec, uint8_t *packets[], uint16_t packlen[], size_t n,
 extern void mln_fec_result_free(mln_fec_result_t *fr);
 extern mln_fec_result_t *
 mln_fec_decode(mln_fec_t *fec, uint8_t *packets[], uint16_t *packlen, size_t n);
+extern void mln_fec_group_init(mln_fec_t *fec, mln_fec_group_t *group);
+/*
+ * Folds one source packet into the group's accumulators. Packets must
+ * be submitted in sequence number order; a group holds at most 48.
+ */
+extern int mln_fec_group_add(mln_fec_group_t *group, uint8_t *packet, uint16_t len);
+/*
+ * Assembles the repair packet for the submitted packets -- identical to
+ * the one mln_fec_encode() would build for the same group -- and resets
+ * the group for reuse. Release the result with mln_string_free().
+ */
+extern mln_string_t *mln_fec_group_close(mln_fec_group_t *group);
 #endif
 
 #endif
@@ -20,6 +20,19 @@ enum mln_fheap_mark {
     FHEAP_TRUE
 };
 
+/*
+ * Two heap layouts share the node structure and the external API.
+ * The Fibonacci mode is the original one; the pairing mode trades the
+ * O(1) amortized decrease-key bound for much lower constant factors
+ * (no marking, no cascading cuts, no degree consolidation), which wins
+ * on decrease-key heavy workloads such as shortest-path recomputation.
+ * The mln_fheap_inline_* macros operate on Fibonacci heaps only.
+ */
+enum mln_fheap_mode {
+    FHEAP_MODE_FIB = 0,
+    FHEAP_MODE_PAIRING
+};
+
 /*
  * return value: 0 - p1 < p2   !0 - p1 >= p2
  */
@@ -64,6 +77,7 @@ typedef struct {
     mln_fheap_node_t         *min;
     mln_fheap_node_t         *root_list;
     mln_size_t                num;
+    mln_u32_t                 mode;
 } mln_fheap_t;
 
 /*
@@ -285,6 +299,90 @@ mln_fheap_remove_child(mln_fheap_node_t **root)
     }\
 })
 
+/*
+ * pairing mode internals. Node field reuse: 'child' is the leftmost
+ * child, 'right' the next sibling, 'left' the previous sibling (NULL
+ * for the leftmost), 'parent' the parent; 'degree' and 'mark' are
+ * unused. A node stays within one cache line on 64-bit targets.
+ */
+static inline mln_fheap_node_t *
+mln_fheap_pairing_meld(fheap_cmp cmp, mln_fheap_node_t *a, mln_fheap_node_t *b)
+{
+    mln_fheap_node_t *tmp;
+
+    if (a == NULL) return b;
+    if (b == NULL) return a;
+    if (!cmp(b->key, a->key)) {
+        tmp = a;
+        a = b;
+        b = tmp;
+    }
+    b->parent = a;
+    b->left = NULL;
+    b->right = a->child;
+    if (a->child != NULL) a->child->left = b;
+    a->child = b;
+    a->parent = NULL;
+    a->left = a->right = NULL;
+    return a;
+}
+
+static inline void
+mln_fheap_pairing_insert(mln_fheap_t *fh, mln_fheap_node_t *fn, fheap_cmp cmp)
+{
+    fn->parent = NULL;
+    fn->left = fn->right = NULL;
+    fh->min = mln_fheap_pairing_meld(cmp, fh->min, fn);
+    ++(fh->num);
+}
+
+static inline mln_fheap_node_t *
+mln_fheap_pairing_extract(mln_fheap_t *fh, fheap_cmp cmp)
+{
+    mln_fheap_node_t *z = fh->min, *list, *stack, *a, *b, *next, *m;
+
+    if (z == NULL) return NULL;
+    /*two-pass pairing: meld adjacent pairs, then meld right to left*/
+    stack = NULL;
+    for (list = z->child; list != NULL; list = next) {
+        a = list;
+        b = a->right;
+        next = b == NULL? NULL: b->right;
+        a->parent = a->left = a->right = NULL;
+        if (b != NULL) b->parent = b->left = b->right = NULL;
+        m = mln_fheap_pairing_meld(cmp, a, b);
+        m->left = stack;
+        stack = m;
+    }
+    m = NULL;
+    while (stack != NULL) {
+        a = stack;
+        stack = stack->left;
+        a->left = NULL;
+        m = mln_fheap_pairing_meld(cmp, m, a);
+    }
+    fh->min = m;
+    --(fh->num);
+    z->child = NULL;
+    z->left = z->right = NULL;
+    return z;
+}
+
+static inline int
+mln_fheap_pairing_decrease(mln_fheap_t *fh, mln_fheap_node_t *node, void *k, fheap_copy cp, fheap_cmp cmp)
+{
+    if (!cmp(node->key, k)) return -1;
+    cp(node->key, k);
+    if (node == fh->min) return 0;
+    if (node->left != NULL) node->left->right = node->right;
+    else node->parent->child = node->right;
+    if (node->right != NULL) node->right->left = node->left;
+    node->parent = NULL;
+    node->left = node->right = NULL;
+    fh->min = mln_fheap_pairing_meld(cmp, fh->min, node);
+    return 0;
+}
+
 #define mln_fheap_node_init(fn, k) ({\
     (fn)->key = (k);\
     (fn)->parent = NULL;\
@@ -306,6 +404,20 @@ mln_fheap_remove_child(mln_fheap_node_t **root)
 
 extern mln_fheap_t *
 mln_fheap_new(void *min_val, struct mln_fheap_attr *attr) __NONNULL1(1);
+/*
+ * Same attributes and API as mln_fheap_new(), but the returned heap
+ * runs in pairing mode; callers pick the layout per workload at
+ * creation time.
+ */
+extern mln_fheap_t *
+mln_fheap_pairing_new(void *min_val, struct mln_fheap_attr *attr) __NONNULL1(1);
+/*
+ * Bulk constructor: allocate a node per key and insert all of them,
+ * O(1) each in both modes. Returns 0 on success, -1 on allocation
+ * failure (already inserted keys stay in the heap).
+ */
+extern int
+mln_fheap_build(mln_fheap_t *fh, void **keys, mln_size_t n) __NONNULL2(1,2);
 extern void
 mln_fheap_free(mln_fheap_t *fh);
 extern void
@@ -17,6 +17,8 @@ typedef struct mln_file_s {
     mln_string_t      *file_path;
     int                fd;
     mln_u32_t          is_tmp:1;
+    mln_u32_t          cache_stale:1;
+    mln_u32_t          negative:1;  /*remembers an ENOENT, fd is -1*/
     time_t             mtime;
     time_t             ctime;
     time_t             atime;
@@ -26,14 +28,32 @@ typedef struct mln_file_s {
     struct mln_file_s *next;
     mln_fileset_t     *fset;
     mln_rbtree_node_t *node;
+    void              *map;        /*mmap'd content, NULL if not cached*/
+    mln_string_t       content;    /*view over 'map'*/
+    time_t             check_time; /*last stat-based revalidation*/
+    struct mln_file_s *cache_prev; /*LRU chain of mapped files*/
+    struct mln_file_s *cache_next;
 } mln_file_t;
 
+typedef struct {
+    mln_u64_t          hit;     /*opens served by a cached descriptor*/
+    mln_u64_t          miss;    /*opens that went to the filesystem*/
+    mln_u64_t          evict;   /*entries dropped to honour max_file*/
+    mln_u64_t          neg_hit; /*opens of known-missing files answered without a syscall*/
+} mln_fileset_stat_t;
+
 struct mln_fileset_s {
     mln_alloc_t       *pool;
     mln_rbtree_t      *reg_file_tree;
-    mln_file_t        *reg_free_head;
+    mln_file_t        *reg_free_head; /*LRU of unreferenced entries, head evicted first*/
     mln_file_t        *reg_free_tail;
     mln_size_t         max_file;
+    mln_fileset_stat_t stat;
+    mln_file_t        *cache_head;      /*LRU head, evicted first*/
+    mln_file_t        *cache_tail;
+    mln_size_t         cache_size;      /*total mapped bytes*/
+    mln_size_t         cache_max;       /*0 means content cache disabled*/
+    mln_size_t         cache_threshold; /*only map files up to this size*/
 };
 
 #define mln_file_fd(pfile) ((pfile)->fd)
@@ -42,6 +62,30 @@ extern void mln_fileset_destroy(mln_fileset_t *fs);
 extern mln_file_t *mln_file_open(mln_fileset_t *fs, const char *filepath) __NONNULL2(1,2);
 extern void mln_file_close(mln_file_t *pfile);
 extern mln_file_t *mln_file_tmp_open(mln_alloc_t *pool) __NONNULL1(1);
+/*
+ * Content cache: files not larger than 'file_threshold' bytes are
+ * mmap'd once and handed out as read-only mln_string_t views, with
+ * files evicted least-recently-used when the total mapped bytes exceed
+ * 'max_bytes'. A view stays valid until the mln_file_t reference it
+ * was obtained through is released with mln_file_close; a mapping is
+ * only unmapped once no reference is held. Changes on disk (mtime or
+ * size) are detected by stat at most once per second per file; a stale
+ * mapping is then dropped as soon as possible and mln_file_content()
+ * returns NULL until it can be remapped, so callers must always be
+ * prepared to fall back to read().
+ */
+extern void mln_fileset_cache_set(mln_fileset_t *fs, mln_size_t max_bytes, mln_size_t file_threshold) __NONNULL1(1);
+extern mln_string_t *mln_file_content(mln_file_t *pfile) __NONNULL1(1);
+/*
+ * Descriptor cache statistics, accumulated from mln_fileset_init();
+ * 'hit' + 'neg_hit' is the number of open(2) calls the set saved.
+ * Paths whose open failed with ENOENT are kept as negative entries:
+ * further opens of the same path are answered from the entry and the
+ * filesystem is re-probed at most once per second. Negative entries
+ * live on the same LRU as unreferenced files and count against
+ * max_file.
+ */
+extern void mln_fileset_stat(mln_fileset_t *fs, mln_fileset_stat_t *st) __NONNULL2(1,2);
 
 #endif
 
@@ -15,9 +15,12 @@
 #define M_F_TYPELEN   sizeof(mln_u32_t)
 #define M_F_LENLEN    sizeof(mln_u32_t)
 
+#define M_IPC_TYPE_QUIT 3
+
 typedef struct mln_fork_s mln_fork_t;
 
 typedef void (*clr_handler)(void *);
+typedef void (*quit_handler)(mln_event_t *);
 
 typedef int (*fork_iterate_handler)(mln_event_t *, mln_fork_t *, void *);
 /*ipc handler*/
@@ -59,14 +62,79 @@ struct mln_fork_s {
     pid_t                    pid;
     mln_u32_t                n_args;
     mln_u32_t                state;
+    mln_u32_t                quit; /*replaced, don't restart on exit*/
     mln_u32_t                msg_len;
     mln_u32_t                msg_type;
     mln_size_t               error_bytes;
     void                    *msg_content;
+    void                    *bulk_ring; /*shared-memory bulk IPC ring, see mln_ipc.h*/
     enum proc_exec_type      etype;
     enum proc_state_type     stype;
 };
 
+/*
+ * Worker placement (Linux only). With 'worker_affinity on;' in the
+ * configuration each forked worker is pinned to one CPU before its
+ * event loop starts, round-robin across NUMA nodes first so workers
+ * spread over sockets, and its memory policy prefers the local node.
+ * An explicit CPU list ('worker_affinity 0, 4, 1, 5;') is assigned
+ * round-robin as given. Without the command no placement is applied.
+ */
+/*
+ * Shared-memory worker health block.
+ *
+ * With 'health_file "/path";' in the 'main' configuration domain the
+ * master maps a small file of M_FORK_HEALTH_MAX cache-line slots
+ * before forking. Each worker claims one slot and publishes into it
+ * from a periodic event-loop timer: a heartbeat counter, the monotonic
+ * millisecond stamp of the beat, its state and how late the timer
+ * fired (a loaded or stuck loop shows up immediately as lag or as a
+ * stalled heartbeat). The connection-count gauge is the application's
+ * to maintain through mln_fork_health_conn_set(). The master and any
+ * external agent that maps the same file read the slots with plain
+ * loads -- no syscall, no IPC round trip and no worker wakeup, so the
+ * mln_ipc polling this replaces disappears. A slot whose owner died is
+ * reused by the next worker to start. Without the configuration
+ * command the facility is off and costs nothing.
+ */
+#define M_FORK_HEALTH_MAX        256
+#define M_FORK_HEALTH_PERIOD_MS  100
+
+#define M_FORK_HEALTH_BOOT       0
+#define M_FORK_HEALTH_RUNNING    1
+#define M_FORK_HEALTH_QUITTING   2
+
+typedef struct {
+    mln_u64_t                heartbeat;   /*increases every beat*/
+    mln_u64_t                mono_ms;     /*monotonic ms of the last beat*/
+    mln_u32_t                pid;         /*0 -- slot free*/
+    mln_u32_t                state;       /*M_FORK_HEALTH_**/
+    mln_u32_t                loop_lag_ms; /*timer lateness at the last beat*/
+    mln_u32_t                conn_count;  /*application gauge*/
+    mln_u8_t                 padding[32]; /*one cache line per worker*/
+} mln_fork_health_t;
+
+typedef int (*fork_health_iterate_handler)(mln_fork_health_t *slot, void *udata);
+
+extern int mln_fork_health_enabled(void);
+/*worker-side gauges; no-ops while the facility is off*/
+extern void mln_fork_health_state_set(mln_u32_t state);
+extern void mln_fork_health_conn_set(mln_u32_t count);
+/*
+ * Walk every claimed slot (master side, or a worker reading its
+ * peers). The handler may return <0 to stop. Return -1 when the
+ * facility is off. Liveness follows from the slot data itself:
+ * a worker is stalled when now - mono_ms spans several periods.
+ */
+extern int mln_fork_health_iterate(fork_health_iterate_handler handler, void *udata);
+/*
+ * External-agent access: map an existing health file read-only and
+ * return its M_FORK_HEALTH_MAX slots, or NULL on failure. Release
+ * with mln_fork_health_detach().
+ */
+extern mln_fork_health_t *mln_fork_health_attach(const char *path) __NONNULL1(1);
+extern void mln_fork_health_detach(mln_fork_health_t *slots);
+
 extern int mln_fork_prepare(void);
 extern int mln_fork_master_ipc_handler_set(mln_u32_t type, ipc_handler handler, void *data) __NONNULL1(2);
 extern int mln_fork_worker_ipc_handler_set(mln_u32_t type, ipc_handler handler, void *data) __NONNULL1(2);
@@ -86,6 +154,53 @@ mln_fork_spawn(enum proc_state_type stype, \
                mln_event_t *master_ev);
 extern int
 mln_fork_restart(mln_event_t *master_ev);
+/*
+ * Zygote worker template. mln_fork_zygote_init() forks one fully
+ * initialized but idle template process; call it once in the master
+ * after configuration and application state are loaded and before any
+ * worker is forked. It returns 1 in the master, 0 in every worker
+ * later spawned from the template (the caller should fall into its
+ * worker routine, exactly as after mln_fork_restart() returns 0) and
+ * -1 on failure. While the template is alive, mln_fork_restart() and
+ * the 'worker_proc' forks are served by asking it to fork, so a
+ * replacement inherits all warm state copy-on-write instead of paying
+ * full initialization; 'proc_exec' children still exec and are
+ * unaffected. The template exits when the master does. Zygote-spawned
+ * workers get no shared-memory bulk IPC channel: a mapping the master
+ * creates after the template forked cannot be inherited through it.
+ */
+extern int
+mln_fork_zygote_init(void);
+/*
+ * Rolling restart. The master spawns one replacement for every active
+ * worker, then sends each old worker an M_IPC_TYPE_QUIT message; the
+ * old worker stops being restarted on exit. On the worker side the
+ * quit handler set with mln_fork_worker_quit_handler_set is invoked so
+ * the application can close or yield its listeners and break the event
+ * loop once in-flight requests drained; without a handler the event
+ * loop is broken immediately. Returns 1 in the master, 0 in a
+ * replacement child (which should fall into the worker routine, as the
+ * framework does), -1 on failure.
+ */
+extern int
+mln_fork_replace(mln_event_t *master_ev) __NONNULL1(1);
+extern void
+mln_fork_worker_quit_handler_set(quit_handler handler);
+/*
+ * Descriptor passing over the master-worker socketpair (SCM_RIGHTS),
+ * e.g. to hand an established listening socket to a new worker. The
+ * transfer is out of band with respect to the framed IPC stream: the
+ * receiving side must call mln_fork_fd_recv() before returning to the
+ * event loop -- typically from the IPC handler of an application
+ * message announcing the transfer, with the master calling
+ * mln_fork_fd_send() directly from the handler of the worker's
+ * request so no framed traffic interleaves. Both return -1 on failure;
+ * mln_fork_fd_recv returns the received descriptor.
+ */
+extern int
+mln_fork_fd_send(mln_fork_t *f, int fd) __NONNULL1(1);
+extern int
+mln_fork_fd_recv(void);
 extern void
 mln_fork_master_events_set(mln_event_t *ev) __NONNULL1(1);
 extern void
@@ -6,10 +6,20 @@
 #define __MLN_FRAMEWORK_H
 
 #include "mln_event.h"
+#if !defined(WIN32)
+#include <sys/types.h>
+#endif
+
+#define M_IPC_TYPE_ACCEPT_STAT 2
+
+/*flags of mln_framework_listener_open*/
+#define M_LISTEN_REUSEPORT 0x1 /*each caller binds its own accept queue*/
+#define M_LISTEN_CPU_STEER 0x2 /*steer connections to the listener of the handling CPU (Linux cBPF)*/
 
 typedef int (*mln_framework_init_t)(void);
 #if !defined(WIN32)
 typedef void (*mln_framework_process_t)(mln_event_t *);
+typedef void (*mln_framework_accept_stat_cb_t)(pid_t pid, mln_u64_t count);
 #endif
 
 struct mln_framework_attr {
@@ -24,4 +34,30 @@ struct mln_framework_attr {
 };
 
 extern int mln_framework_init(struct mln_framework_attr *attr) __NONNULL1(1);
+/*
+ * Worker listening. With M_LISTEN_REUSEPORT each worker calls
+ * mln_framework_listener_open() in its worker_process routine and gets
+ * its own kernel accept queue, so accepts no longer funnel through one
+ * shared socket and wake every worker. M_LISTEN_CPU_STEER additionally
+ * attaches a classic BPF program steering each connection to the
+ * listener bound on the CPU that handled the packet (best effort, only
+ * where SO_ATTACH_REUSEPORT_CBPF exists). The returned descriptor is
+ * nonblocking and listening; -1 on failure.
+ * mln_framework_listener_accept() accepts one connection, makes it
+ * nonblocking and counts it for this worker; mln_framework_accept_count()
+ * returns the worker's running total.
+ */
+extern int mln_framework_listener_open(const char *host, const char *service, mln_u32_t flags) __NONNULL2(1,2);
+extern int mln_framework_listener_accept(int listenfd);
+extern mln_u64_t mln_framework_accept_count(void);
+#if !defined(WIN32)
+/*
+ * Periodic accept-rate reports: every 'period_ms' milliseconds each
+ * worker sends its accept counter to the master over IPC
+ * (M_IPC_TYPE_ACCEPT_STAT); the master invokes 'cb' per report, or
+ * logs the counter at report level when 'cb' is NULL. Must be called
+ * before mln_framework_init().
+ */
+extern int mln_framework_accept_stat_set(mln_u32_t period_ms, mln_framework_accept_stat_cb_t cb);
+#endif
 #endif
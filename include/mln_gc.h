@@ -7,6 +7,24 @@
 
 #include "mln_types.h"
 #include "mln_alloc.h"
+#include "mln_event.h"
+
+/*
+ * Incremental collection states. A cycle walks
+ * enqueue -> mark -> partition -> clean -> sweep; mln_gc_collect_step()
+ * resumes wherever the previous slice stopped.
+ */
+#define M_GC_STATE_IDLE      0
+#define M_GC_STATE_ENQUEUE   1
+#define M_GC_STATE_MARK      2
+#define M_GC_STATE_PARTITION 3
+#define M_GC_STATE_CLEAN     4
+#define M_GC_STATE_SWEEP     5
+
+#define M_GC_DEFAULT_BUDGET  256
+
+/*collections an item must survive before leaving the nursery*/
+#define M_GC_GEN_PROMOTE_AGE 2
 
 typedef struct mln_gc_s      mln_gc_t;
 typedef struct mln_gc_item_s mln_gc_item_t;
@@ -39,10 +57,16 @@ struct mln_gc_item_s {
     struct mln_gc_item_s   *next;
     struct mln_gc_item_s   *proc_prev;
     struct mln_gc_item_s   *proc_next;
+    struct mln_gc_item_s   *rset_prev;
+    struct mln_gc_item_s   *rset_next;
     mln_u32_t               suspected:1;
     mln_u32_t               credit:1;
     mln_u32_t               inc:1;
     mln_u32_t               visited:1;
+    mln_u32_t               gen:1;/*0 nursery, 1 old generation*/
+    mln_u32_t               age:2;
+    mln_u32_t               remembered:1;/*old item on the remembered set*/
+    mln_u32_t               young_ref:1;/*referenced a nursery item during the last mark*/
 };
 
 struct mln_gc_s {
@@ -60,7 +84,23 @@ struct mln_gc_s {
     gc_root_setter          root_setter;
     gc_clean_searcher       clean_searcher;
     gc_free_handler         free_handler;
+    mln_gc_item_t          *stage_head;
+    mln_gc_item_t          *stage_tail;
+    mln_gc_item_t          *old_head;
+    mln_gc_item_t          *old_tail;
+    mln_gc_item_t          *rset_head;
+    mln_gc_item_t          *rset_tail;
+    mln_gc_item_t          *scan;
+    mln_gc_item_t          *rscan;
+    mln_gc_item_t          *marking;/*item whose members are being set*/
+    void                   *root;
+    mln_size_t              budget;
     mln_u32_t               del:1;
+    mln_u32_t               state:3;
+    mln_u32_t               dirty:1;
+    mln_u32_t               progress:1;
+    mln_u32_t               minor:1;
+    mln_u32_t               old_done:1;
 };
 
 extern mln_gc_t *mln_gc_new(struct mln_gc_attr *attr) __NONNULL1(1);
@@ -72,5 +112,37 @@ extern void mln_gc_collect_add(mln_gc_t *gc, void *data) __NONNULL1(1);
 extern int mln_gc_clean_add(mln_gc_t *gc, void *data) __NONNULL2(1,2);
 extern void mln_gc_collect(mln_gc_t *gc, void *root_data) __NONNULL1(1);
 extern void mln_gc_remove(mln_gc_t *gc, void *data, mln_gc_t *proc_gc)__NONNULL2(1,2);
+/*
+ * Incremental collection. mln_gc_collect_begin() opens a cycle
+ * ('root_data' must stay valid until it completes; -1 if one is
+ * already running), then mln_gc_collect_step() performs up to 'budget'
+ * item visits (0 means unlimited) and returns >0 while work remains,
+ * 0 once the cycle is done. While a cycle is marking, callers mutating
+ * an object's references should call mln_gc_write_barrier() on the
+ * mutated object so it is re-scanned before the cycle ends.
+ * mln_gc_collect_schedule() drives the slices from a re-arming
+ * zero-delay timer on 'ev', interleaving collection with the event
+ * loop's regular processing.
+ */
+extern int mln_gc_collect_begin(mln_gc_t *gc, void *root_data) __NONNULL1(1);
+extern int mln_gc_collect_step(mln_gc_t *gc, mln_size_t budget) __NONNULL1(1);
+extern int mln_gc_collect_schedule(mln_gc_t *gc, mln_event_t *ev, void *root_data, mln_size_t budget) __NONNULL2(1,2);
+extern void mln_gc_write_barrier(mln_gc_t *gc, void *data) __NONNULL1(1);
+/*
+ * Generational collection. New items start in the nursery; once one
+ * survives M_GC_GEN_PROMOTE_AGE collections it moves to the old
+ * generation, which a minor collection leaves untouched apart from the
+ * remembered set -- the old items known to reference nursery items.
+ * mln_gc_write_barrier() feeds that set (so it must be called whenever
+ * an object that may already be promoted gains a reference), and each
+ * scan re-checks the recorded items so stale entries drop out on their
+ * own. Suspected old items are only freed by the full collectors
+ * (mln_gc_collect()/mln_gc_collect_begin()), which walk both
+ * generations and can therefore run rarely. mln_gc_collect_minor() is
+ * the synchronous form; mln_gc_collect_minor_begin() opens a minor
+ * cycle driven by mln_gc_collect_step() like any other.
+ */
+extern void mln_gc_collect_minor(mln_gc_t *gc, void *root_data) __NONNULL1(1);
+extern int mln_gc_collect_minor_begin(mln_gc_t *gc, void *root_data) __NONNULL1(1);
 
 #endif
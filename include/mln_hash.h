@@ -27,6 +27,23 @@ typedef enum mln_hash_flag {
     M_HASH_F_KV
 } mln_hash_flag_t;
 
+/*
+ * Note:
+ * 'incremental' only takes effect with 'expandable' set. In this mode a
+ * resize keeps the old bucket array alive and every insert/lookup migrates
+ * a bounded number of buckets, so no single operation pays for a full
+ * migration. The hash handler MUST derive its bucket index from h->len,
+ * because the old index is recovered by re-invoking it with h->len
+ * temporarily set to the old length.
+ */
+/*
+ * With 'string_key' set the keys are mln_string_t pointers and the
+ * table ignores the 'hash' and 'cmp' handlers (they may be NULL):
+ * bucket indices come from the hash cached inside the string by
+ * mln_string_hash(), so a key looked up repeatedly is scanned once
+ * ever, and comparison is mln_string_strseqcmp(). Derived from h->len
+ * on every use, so it composes with incremental rehash.
+ */
 struct mln_hash_attr {
     void                    *pool;
     hash_pool_alloc_handler  pool_alloc;
@@ -38,6 +55,8 @@ struct mln_hash_attr {
     mln_u64_t                len_base;
     mln_u32_t                expandable:1;
     mln_u32_t                calc_prime:1;
+    mln_u32_t                incremental:1;
+    mln_u32_t                string_key:1;
 };
 
 typedef struct mln_hash_entry_s {
@@ -62,10 +81,15 @@ struct mln_hash_s {
     hash_free_handler        free_val;
     mln_hash_mgr_t          *tbl;
     mln_u64_t                len;
+    mln_hash_mgr_t          *old_tbl;/*non-NULL while an incremental rehash is in progress*/
+    mln_u64_t                old_len;
+    mln_u64_t                rehash_idx;
     mln_u32_t                nr_nodes;
     mln_u32_t                threshold;
     mln_u32_t                expandable:1;
     mln_u32_t                calc_prime:1;
+    mln_u32_t                incremental:1;
+    mln_u32_t                string_key:1;
 };
 
 
@@ -74,9 +98,25 @@ mln_hash_new(struct mln_hash_attr *attr) __NONNULL1(1);
 extern void
 mln_hash_free(mln_hash_t *h, mln_hash_flag_t flg) __NONNULL1(1);
 extern void *
-mln_hash_search(mln_hash_t *h, void *key) __NONNULL2(1,2);
+mln_hash_search(mln_hash_t *h, void *key) __NONNULL2(1,2) __HOT__;
 extern void *
 mln_hash_search_iterator(mln_hash_t *h, void *key, int **ctx) __NONNULL3(1,2,3);
+/*
+ * mln_hash_search_hashed():
+ * Like mln_hash_search but skips the hash handler; 'hval' is reduced
+ * modulo the table length, so it may be either the raw hash of 'key'
+ * (when the handler folds with '% h->len') or the handler's own result.
+ * mln_hash_search_multi():
+ * Resolves 'n' keys in one call, software-prefetching the target buckets
+ * and their first entries across each batch to overlap the memory
+ * latency of dependent lookups. 'hvals' may be NULL to fall back to the
+ * hash handler. 'vals' receives one value (or NULL) per key; the return
+ * value is the number of keys found.
+ */
+extern void *
+mln_hash_search_hashed(mln_hash_t *h, void *key, mln_u64_t hval) __NONNULL2(1,2);
+extern mln_size_t
+mln_hash_search_multi(mln_hash_t *h, void **keys, mln_u64_t *hvals, mln_size_t n, void **vals) __NONNULL3(1,2,5);
 /*
  * mln_hash_replace():
  * The second and third arguments are all second rank pointer variables.
@@ -86,7 +126,7 @@ mln_hash_search_iterator(mln_hash_t *h, void *key, int **ctx) __NONNULL3(1,2,3);
 extern int
 mln_hash_replace(mln_hash_t *h, void *key, void *val) __NONNULL3(1,2,3);
 extern int
-mln_hash_insert(mln_hash_t *h, void *key, void *val) __NONNULL2(1,2);
+mln_hash_insert(mln_hash_t *h, void *key, void *val) __NONNULL2(1,2) __HOT__;
 extern void
 mln_hash_remove(mln_hash_t *h, void *key, mln_hash_flag_t flg) __NONNULL2(1,2);
 extern int
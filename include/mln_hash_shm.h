@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#ifndef __MLN_HASH_SHM_H
+#define __MLN_HASH_SHM_H
+
+#include "mln_types.h"
+#include "mln_alloc.h"
+
+/*
+ * Shared-memory resident hash table for cross-worker state (e.g. one
+ * session table instead of a private copy per mln_fork worker). The
+ * table header, bucket array and entries all live in an mln_alloc shm
+ * pool, and keys and values are copied into it, so every worker sees
+ * the same data. The shm mapping is created before fork and inherited
+ * at the same address by every worker, so entries link with plain
+ * pointers. Each bucket carries its own spin lock; operations on
+ * different buckets never contend, and no global lock exists. Lookups
+ * copy the value out under the bucket lock, since a pointer into the
+ * table could be freed by a concurrent remove. Use an
+ * mln_alloc_shm_lockfree_init() pool to keep entry allocation off the
+ * pool lock as well.
+ */
+
+typedef struct mln_hash_shm_s mln_hash_shm_t;
+
+/*
+ * Handler called per entry by mln_hash_shm_iterate() with the bucket
+ * lock held: keep it short and do not call back into the same table.
+ * Return <0 to stop the iteration.
+ */
+typedef int (*mln_hash_shm_iterate_handler)(mln_u8ptr_t /*key*/, mln_size_t /*klen*/, \
+                                            mln_u8ptr_t /*val*/, mln_size_t /*vlen*/, \
+                                            void * /*udata*/);
+
+/*
+ * Create a table with at least 'len_base' buckets (rounded to a prime)
+ * in the given shm pool. The bucket count is fixed: size it for the
+ * expected population up front. Return NULL on allocation failure.
+ */
+extern mln_hash_shm_t *mln_hash_shm_new(mln_alloc_t *pool, mln_u64_t len_base) __NONNULL1(1);
+extern void mln_hash_shm_free(mln_hash_shm_t *h);
+/*
+ * Insert or overwrite the value under 'key'; both are copied into the
+ * shm pool. A same-size overwrite reuses the entry in place.
+ * Return 0, or -1 on allocation failure.
+ */
+extern int mln_hash_shm_insert(mln_hash_shm_t *h, \
+                               void *key, \
+                               mln_size_t klen, \
+                               void *val, \
+                               mln_size_t vlen) __NONNULL3(1,2,4);
+/*
+ * Copy the value under 'key' into 'val' ('*vlen' holds its capacity on
+ * entry, the value length on return). Return 0 on a hit, -1 when the
+ * key is absent or the value does not fit (errno ENOENT/ERANGE).
+ */
+extern int mln_hash_shm_search(mln_hash_shm_t *h, \
+                               void *key, \
+                               mln_size_t klen, \
+                               void *val, \
+                               mln_size_t *vlen) __NONNULL4(1,2,4,5);
+/*
+ * Remove the entry under 'key'. Return 0, or -1 when absent.
+ */
+extern int mln_hash_shm_remove(mln_hash_shm_t *h, void *key, mln_size_t klen) __NONNULL2(1,2);
+extern int mln_hash_shm_iterate(mln_hash_shm_t *h, mln_hash_shm_iterate_handler handler, void *udata) __NONNULL2(1,2);
+extern mln_u64_t mln_hash_shm_count(mln_hash_shm_t *h) __NONNULL1(1);
+
+#endif
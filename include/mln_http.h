@@ -12,6 +12,7 @@
 
 #define M_HTTP_HASH_LEN                        31
 #define M_HTTP_GENERATE_ALLOC_SIZE             1024
+#define M_HTTP_COMMON_HEADER_NR                20
 
 /*http type*/
 #define M_HTTP_UNKNOWN                         0
@@ -93,8 +94,15 @@
 #define M_HTTP_NOT_EXTENDED                    510
 #define M_HTTP_UNPARSEABLE_RESPONSE_HEADERS    600
 
+/*chunked transfer-encoding parse states (internal)*/
+#define M_HTTP_CHUNK_SIZE                      0
+#define M_HTTP_CHUNK_DATA                      1
+#define M_HTTP_CHUNK_CRLF                      2
+#define M_HTTP_CHUNK_TRAILER                   3
+
 typedef struct mln_http_s mln_http_t;
 typedef int (*mln_http_handler)(mln_http_t *, mln_chain_t **, mln_chain_t **);
+typedef int (*mln_http_chunk_handler)(mln_http_t *, mln_buf_t *);
 
 typedef struct {
     mln_string_t            msg_str;
@@ -106,6 +114,9 @@ struct mln_http_s {
     mln_tcp_conn_t         *connection;
     mln_alloc_t            *pool;
     mln_hash_t             *header_fields;
+    mln_string_t           *common_vals[M_HTTP_COMMON_HEADER_NR];
+    mln_chain_t            *held_head;/*consumed receive buffers referenced by zero-copy slices*/
+    mln_chain_t            *held_tail;
     mln_chain_t            *body_head;
     mln_chain_t            *body_tail;
     mln_http_handler        body_handler;
@@ -113,12 +124,15 @@ struct mln_http_s {
     mln_string_t           *uri;
     mln_string_t           *args;
     mln_string_t           *response_msg;
+    mln_size_t              chunk_left;
     mln_u32_t               error;
     mln_u32_t               status;
     mln_u32_t               method;
     mln_u32_t               version;
     mln_u32_t               type:2;
     mln_u32_t               done:1;
+    mln_u32_t               zerocopy:1;
+    mln_u32_t               chunk_state:2;
 };
 
 /*for internal*/
@@ -151,6 +165,17 @@ struct mln_http_s {
 #define mln_http_error_get(h)            ((h)->error)
 #define mln_http_error_set(h,e)          (h)->error = (e)
 #define mln_http_header_get(h)           ((h)->header_fields)
+/*
+ * Zero-copy parse mode. Header names, values, URI and arguments become
+ * slices into the connection's receive buffers instead of pool copies;
+ * consumed buffers are held by the mln_http_t and released by
+ * mln_http_reset()/mln_http_destroy(), so fetched field strings must not
+ * be used across a reset. Common headers (Host, Content-Length, ...) are
+ * resolved through a fixed perfect-hash index, bypassing the generic
+ * header hash entirely.
+ */
+#define mln_http_zerocopy_get(h)         ((h)->zerocopy)
+#define mln_http_zerocopy_set(h,z)       (h)->zerocopy = (z)
 
 extern mln_http_t *
 mln_http_init(mln_tcp_conn_t *connection, void *data, mln_http_handler body_handler);
@@ -170,6 +195,24 @@ extern void mln_http_reset(mln_http_t *http);
  * set NULL. Just ignore it.
  */
 extern int mln_http_parse(mln_http_t *http, mln_chain_t **in);
+/*
+ * mln_http_pipeline():
+ * Consume pipelined keep-alive requests back-to-back from 'in'.
+ * Each fully parsed request is handed to 'request_handler', which
+ * should generate that request's response chain via its second and
+ * third arguments (e.g. by calling mln_http_generate()). Response
+ * chains are appended to out_head/out_tail in arrival order, and the
+ * parse state is reset between requests without touching the pool or
+ * re-walking consumed buffers.
+ * Return M_HTTP_RET_OK if input is exhausted (a trailing partial
+ * request stays buffered in the mln_http_t and parsing resumes on the
+ * next call), or M_HTTP_RET_ERROR on parse or handler failure.
+ */
+extern int mln_http_pipeline(mln_http_t *http, \
+                             mln_chain_t **in, \
+                             mln_http_handler request_handler, \
+                             mln_chain_t **out_head, \
+                             mln_chain_t **out_tail);
 /*
  * mln_http_generate():
  * Return value is the same s mln_http_parse().
@@ -178,10 +221,43 @@ extern int mln_http_parse(mln_http_t *http, mln_chain_t **in);
  * via the second and third arguments of 'body_handler'.
  */
 extern int mln_http_generate(mln_http_t *http, mln_chain_t **out_head, mln_chain_t **out_tail);
+/*
+ * mln_http_chunk_parse():
+ * Decode a chunked transfer-encoding body incrementally from 'in'.
+ * Chunk data is NOT copied: each decoded segment is handed to
+ * 'chunk_handler' as an mln_buf_t pointing into the receive buffer it
+ * arrived in, so the handler must consume (or copy) it before returning
+ * unless zero-copy mode holds the buffers alive. A NULL buf signals the
+ * final zero-size chunk. Trailer fields after the last chunk are added
+ * to the header hash.
+ * Return M_HTTP_RET_OK if more input is needed (decode state is kept in
+ * the mln_http_t and resumes on the next call), M_HTTP_RET_DONE once
+ * the terminating chunk and trailers are consumed, or M_HTTP_RET_ERROR.
+ */
+extern int mln_http_chunk_parse(mln_http_t *http, mln_chain_t **in, mln_http_chunk_handler chunk_handler);
+/*
+ * mln_http_chunk_generate():
+ * Append one chunk of a chunked transfer-encoding body to the send
+ * chain without knowing the total body length. 'b' is linked into the
+ * chain as-is (no copy) framed by its hexadecimal size line and CRLF.
+ * Pass NULL (or an empty buf) to emit the terminating zero-size chunk
+ * and mark the end of the message.
+ * Return M_HTTP_RET_OK after an intermediate chunk, M_HTTP_RET_DONE
+ * after the terminating one, or M_HTTP_RET_ERROR on failure.
+ */
+extern int mln_http_chunk_generate(mln_http_t *http, mln_chain_t **out_head, mln_chain_t **out_tail, mln_buf_t *b);
 extern int mln_http_field_set(mln_http_t *http, mln_string_t *key, mln_string_t *val);
 extern mln_string_t *mln_http_field_get(mln_http_t *http, mln_string_t *key);
 extern mln_string_t *mln_http_field_iterator(mln_http_t *http, mln_string_t *key);
 extern void mln_http_field_remove(mln_http_t *http, mln_string_t *key);
+/*
+ * mln_http_date_set():
+ * Set the Date header field to the current time in RFC 1123 format.
+ * The string comes from the cached clock, which re-renders it at most
+ * once per second, so stamping every response costs no time formatting.
+ * Return M_HTTP_RET_OK on success, M_HTTP_RET_ERROR on failure.
+ */
+extern int mln_http_date_set(mln_http_t *http);
 
 extern void mln_http_dump(mln_http_t *http);
 
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#ifndef __MLN_HTTP_CLIENT_H
+#define __MLN_HTTP_CLIENT_H
+
+#include "mln_http.h"
+#include "mln_event.h"
+
+/*
+ * Upstream HTTP client: per-destination pools of warm keep-alive
+ * connections driven by an mln_event loop.
+ *
+ * Destinations are keyed by host:port. A request acquires an idle
+ * pooled connection when one exists and only connects (nonblocking,
+ * completed on the event loop) when the pool is empty, so steady
+ * service-to-service traffic skips TCP setup entirely. Responses on a
+ * kept-alive connection return it to its destination's idle list; a
+ * health timer reaps connections idle beyond the configured timeout,
+ * and an idle connection whose peer closes is noticed by its armed
+ * receive event and dropped from the pool. Host names are re-resolved
+ * transparently once the cached address outlives its TTL -- existing
+ * connections finish on the old address, new ones use the fresh one.
+ *
+ * Requests flagged M_HTTP_CLIENT_PIPELINE may be written onto a
+ * connection that is still awaiting earlier responses, provided every
+ * request in flight there carries the flag too (the caller asserts the
+ * requests are safe to pipeline, e.g. idempotent GETs); responses are
+ * matched back in FIFO order. Unflagged requests always get a
+ * connection to themselves.
+ */
+
+#define M_HTTP_CLIENT_PIPELINE 0x1
+
+typedef struct mln_http_client_s      mln_http_client_t;
+typedef struct mln_http_client_req_s  mln_http_client_req_t;
+/*
+ * Completion callback. 'resp' is the parsed response -- headers via
+ * mln_http_field_get(), status via mln_http_status_get(), body via
+ * mln_http_client_body() -- valid only inside the callback; it is
+ * NULL when the request failed (connect, send, parse or peer close).
+ */
+typedef void (*mln_http_client_cb_t)(mln_http_client_t *, mln_http_t * /*resp*/, void *);
+
+extern mln_http_client_t *mln_http_client_new(mln_event_t *ev) __NONNULL1(1);
+extern void mln_http_client_free(mln_http_client_t *client);
+/*
+ * Pool tuning; call before issuing requests. 'max_idle' warm
+ * connections are kept per destination, each reaped after
+ * 'idle_timeout_ms' without traffic; resolved addresses live for
+ * 'resolve_ttl_ms'; at most 'pipeline_depth' pipelined requests share
+ * one connection.
+ */
+extern void mln_http_client_conf(mln_http_client_t *client, \
+                                 mln_u32_t max_idle, \
+                                 mln_u32_t idle_timeout_ms, \
+                                 mln_u32_t resolve_ttl_ms, \
+                                 mln_u32_t pipeline_depth) __NONNULL1(1);
+/*
+ * Prepare a request for host:port on a pooled (or fresh) connection.
+ * The returned handle exposes its mln_http_t via
+ * mln_http_client_request_http(); set method, URI and header fields on
+ * it before sending (Host and version 1.1 are pre-set). Return NULL on
+ * resolution or allocation failure.
+ */
+extern mln_http_client_req_t *
+mln_http_client_request_new(mln_http_client_t *client, \
+                            mln_string_t *host, \
+                            mln_u16_t port, \
+                            mln_u32_t flags) __NONNULL2(1,2);
+extern mln_http_t *mln_http_client_request_http(mln_http_client_req_t *req) __NONNULL1(1);
+/*
+ * Send the prepared request; 'cb' fires once with the response or with
+ * NULL on failure. The request handle is consumed either way.
+ * Return 0, or -1 when generation fails (the callback will not fire).
+ */
+extern int mln_http_client_send(mln_http_client_t *client, \
+                                mln_http_client_req_t *req, \
+                                mln_http_client_cb_t cb, \
+                                void *udata) __NONNULL2(1,2);
+/*
+ * Response body of 'resp' inside a completion callback (NULL head when
+ * the response has none). The chain is released after the callback
+ * returns; copy what must outlive it.
+ */
+extern void mln_http_client_body(mln_http_t *resp, \
+                                 mln_chain_t **head, \
+                                 mln_chain_t **tail) __NONNULL3(1,2,3);
+
+#endif
@@ -30,11 +30,39 @@ struct mln_iothread_msg_s {
     struct mln_iothread_msg_s  *next;
 };
 
+/*
+ * Lock-free SPSC ring carrying one direction of messages. The socketpair
+ * is only a doorbell: the consumer raises 'waiting' before parking on
+ * the fd and the producer kicks it exactly when that flag is up.
+ */
+typedef struct mln_iothread_ring_s {
+    mln_iothread_msg_t        **slots;
+    mln_u32_t                   size;/*power of two*/
+    mln_u32_t                   mask;
+    mln_u32_t                   head;/*written by the consumer only*/
+    mln_u32_t                   tail;/*written by the producer only*/
+    mln_u32_t                   waiting;
+} mln_iothread_ring_t;
+
+/*
+ * With sharded channels every I/O thread owns one of these lists;
+ * submission spreads messages over the shards and a thread that runs
+ * dry sweeps its siblings' lists, so the threads no longer serialize
+ * on the single io_lock.
+ */
+typedef struct {
+    pthread_mutex_t             lock;
+    mln_iothread_msg_t         *head;
+    mln_iothread_msg_t         *tail;
+} mln_iothread_shard_t;
+
 struct mln_iothread_attr {
     mln_u32_t                   nthread;
     mln_iothread_entry_t        entry;
     void                       *args;
     mln_iothread_msg_process_t  handler;
+    mln_u32_t                   ringsize;/*nonzero: ring transport, rounded up to a power of two, needs nthread == 1*/
+    mln_u32_t                   sharded;/*nonzero: per-I/O-thread message lists, needs ringsize == 0*/
 };
 
 struct mln_iothread_s {
@@ -50,6 +78,10 @@ struct mln_iothread_s {
     mln_iothread_msg_t         *io_tail;
     mln_iothread_msg_t         *user_head;
     mln_iothread_msg_t         *user_tail;
+    mln_iothread_ring_t        *io_ring;/*messages heading to the io thread*/
+    mln_iothread_ring_t        *user_ring;/*messages heading to the user thread*/
+    mln_iothread_shard_t       *shards;/*per-I/O-thread lists, NULL unless sharded*/
+    mln_u32_t                   rr;/*round-robin submission cursor*/
     mln_u32_t                   nthread;
 };
 
@@ -62,6 +94,15 @@ struct mln_iothread_s {
 extern int mln_iothread_init(mln_iothread_t *t, struct mln_iothread_attr *attr);
 extern void mln_iothread_destroy(mln_iothread_t *t);
 extern int mln_iothread_send(mln_iothread_t *t, mln_u32_t type, void *data, mln_iothread_ep_type_t to, mln_u32_t feedback);
+/*
+ * Like mln_iothread_send(), but on a sharded instance messages heading
+ * to the I/O threads with the same 'key' always land on the same shard
+ * and are consumed in submission order by whichever thread drains that
+ * shard; a steal hands over the whole backlog at once, so a stolen
+ * batch stays ordered as well. Without sharding, or towards the user
+ * thread, the key is ignored.
+ */
+extern int mln_iothread_send_key(mln_iothread_t *t, mln_u32_t type, void *data, mln_iothread_ep_type_t to, mln_u32_t feedback, mln_u32_t key);
 extern int mln_iothread_recv(mln_iothread_t *t, mln_iothread_ep_type_t from);
 
 #endif
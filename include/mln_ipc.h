@@ -10,6 +10,8 @@
 #include "mln_types.h"
 #include "mln_fork.h"
 
+#define M_IPC_TYPE_BULK 4
+
 typedef struct mln_ipc_set_s {
     struct mln_ipc_set_s *next;
     ipc_handler           master_handler;
@@ -29,6 +31,45 @@ mln_ipc_handler_register(mln_u32_t type, \
                          ipc_handler worker_handler, \
                          void *master_data, \
                          void *worker_data) __NONNULL2(2,3);
+
+/*
+ * Bulk channel: a per-worker ring in shared memory carrying
+ * variable-size records from worker to master, with the socketpair used
+ * only as a doorbell when the master may be idle. Call
+ * mln_ipc_bulk_init() in the master before workers are forked
+ * (e.g. from global_init); 'ring_size' is rounded up to a power of two
+ * and 'cb' is invoked once per record while the master drains a ring.
+ * Workers ship records with mln_ipc_bulk_send(); -1 means the ring is
+ * full (or the channel is not set up) and the caller may retry.
+ * mln_ipc_bulk_drain() is the batched receive the doorbell handler
+ * uses; the master may also call it directly to poll a worker's ring.
+ */
+typedef void (*mln_ipc_bulk_cb_t)(mln_fork_t *, void *, mln_u32_t, void *);
+
+extern int
+mln_ipc_bulk_init(mln_size_t ring_size, mln_ipc_bulk_cb_t cb, void *udata) __NONNULL1(2);
+extern int
+mln_ipc_bulk_send(mln_event_t *ev, void *buf, mln_u32_t len) __NONNULL2(1,2);
+extern mln_size_t
+mln_ipc_bulk_drain(mln_fork_t *f) __NONNULL1(1);
+/*fork-time glue, used by mln_fork*/
+extern void *mln_ipc_bulk_ring_new(void);
+extern void mln_ipc_bulk_ring_free(void *ring);
+extern void mln_ipc_bulk_worker_attach(void *ring);
+
+/*
+ * Event-loop statistics channel: a worker with instrumentation enabled
+ * (mln_event_stat_enable()) ships its snapshot to the master with
+ * mln_ipc_event_stat_send(), e.g. from a periodic timer. The master
+ * registers a receive callback with mln_ipc_event_stat_init() before
+ * workers are forked.
+ */
+#define M_IPC_TYPE_EVSTAT 5
+
+typedef void (*mln_ipc_event_stat_cb_t)(mln_fork_t *, mln_event_stat_t *, void *);
+
+extern int mln_ipc_event_stat_init(mln_ipc_event_stat_cb_t cb, void *udata) __NONNULL1(1);
+extern int mln_ipc_event_stat_send(mln_event_t *ev) __NONNULL1(1);
 #endif
 
 #endif
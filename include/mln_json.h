@@ -10,6 +10,7 @@
 #include "mln_alloc.h"
 #include "mln_hash.h"
 #include "mln_rbtree.h"
+#include "mln_chain.h"
 
 #define M_JSON_HASH_LEN         31
 
@@ -38,6 +39,8 @@ typedef struct {
 struct mln_json_s {
     mln_uauto_t                  index;
     enum json_type               type;
+    mln_u32_t                    esc:1;/*in-situ string slice still carries raw escapes*/
+    mln_u32_t                    padding:31;
     union {
         mln_hash_t       *m_j_obj;
         mln_rbtree_t     *m_j_array;
@@ -85,6 +88,117 @@ struct mln_json_s {
 
 extern mln_json_t *mln_json_new(void);
 extern mln_json_t *mln_json_parse(mln_string_t *jstr);
+/*
+ * mln_json_parse_in_situ():
+ * Like mln_json_parse but string values and keys borrow slices of the
+ * caller's buffer instead of copying, so decoding allocates almost
+ * nothing per string. The buffer must stay alive and unmodified for the
+ * whole lifetime of the returned tree. Strings containing escapes keep
+ * their raw text and are unescaped lazily by mln_json_string_data_get;
+ * fetch such values through it (M_JSON_GET_DATA_STRING would hand back
+ * the raw slice) before re-encoding the tree with mln_json_generate.
+ */
+extern mln_json_t *mln_json_parse_in_situ(mln_string_t *jstr);
+extern mln_string_t *mln_json_string_data_get(mln_json_t *j);
+
+typedef struct {
+    mln_u32_t       type; /*M_JSON_* type of the matched value*/
+    mln_string_t    text; /*borrowed raw slice of the input*/
+    double          num;  /*parsed value when type is M_JSON_NUM*/
+} mln_json_query_result_t;
+
+/*
+ * mln_json_query():
+ * Extract one value from raw JSON text without building the document
+ * tree. 'path' names the value as dotted keys and bracketed indexes,
+ * e.g. "a.b[3].c"; only the branches on that path are descended, every
+ * sibling subtree is skipped with the structural scanner. The result
+ * borrows slices of 'jstr' (nothing is allocated), so the buffer must
+ * outlive the result. String values keep their raw text -- escapes are
+ * not decoded -- and keys in 'path' are matched against the raw key
+ * bytes. Returns 0 on match, -1 on malformed input or no such path.
+ */
+extern int mln_json_query(mln_string_t *jstr, char *path, mln_json_query_result_t *res) __NONNULL3(1,2,3);
+
+enum mln_json_sax_event {
+    M_JSON_SAX_OBJ_START = 0,
+    M_JSON_SAX_OBJ_END,
+    M_JSON_SAX_ARRAY_START,
+    M_JSON_SAX_ARRAY_END,
+    M_JSON_SAX_KEY,
+    M_JSON_SAX_STRING,
+    M_JSON_SAX_NUMBER,
+    M_JSON_SAX_TRUE,
+    M_JSON_SAX_FALSE,
+    M_JSON_SAX_NULL
+};
+
+typedef struct mln_json_sax_s mln_json_sax_t;
+/*
+ * Invoked once per token. 'text' carries the decoded content for
+ * M_JSON_SAX_KEY and M_JSON_SAX_STRING (valid only during the call),
+ * 'num' the value for M_JSON_SAX_NUMBER. Return <0 to abort parsing.
+ */
+typedef int (*mln_json_sax_handler)(mln_json_sax_t *ctx, \
+                                    enum mln_json_sax_event event, \
+                                    mln_string_t *text, \
+                                    double num, \
+                                    void *udata);
+
+struct mln_json_sax_s {
+    mln_json_sax_handler         handler;
+    void                        *udata;
+    mln_u8ptr_t                  save;/*bytes of the token cut by a buffer boundary*/
+    mln_size_t                   save_len;
+    mln_size_t                   save_size;
+    mln_u8ptr_t                  stack;/*one byte per nesting level: 'o' or 'a'*/
+    mln_u32_t                    depth;
+    mln_u32_t                    stack_size;
+    mln_u32_t                    state;
+    mln_u32_t                    tok;
+    mln_u32_t                    done:1;
+    mln_u32_t                    error:1;
+    mln_u32_t                    tok_esc:1;
+    mln_u32_t                    padding:29;
+};
+
+/*
+ * Push parser. Feed it whatever the transport delivers -- each buffer of
+ * an mln_tcp_conn_recv() chain, for instance -- and tokens are reported
+ * through the handler as soon as they complete, so arbitrarily large
+ * documents parse in memory bounded by nesting depth plus the largest
+ * single token. Tokens split across feeds are reassembled internally.
+ * mln_json_sax_feed() returns 1 when the document is complete, 0 when
+ * more input is needed and -1 on error; mln_json_sax_finish() flushes a
+ * trailing number or literal and verifies the document ended cleanly.
+ */
+extern mln_json_sax_t *mln_json_sax_new(mln_json_sax_handler handler, void *udata);
+extern int mln_json_sax_feed(mln_json_sax_t *ctx, mln_u8ptr_t buf, mln_size_t len);
+extern int mln_json_sax_finish(mln_json_sax_t *ctx);
+extern void mln_json_sax_free(mln_json_sax_t *ctx);
+/*
+ * mln_json_generate_chain():
+ * Encode directly into a buffer chain allocated from 'pool', ready to be
+ * handed to mln_tcp_conn_append(). Unlike mln_json_generate() there is no
+ * sizing pass and no flat copy of the whole document, so the peak cost is
+ * one M_JSON_CHAIN_ALLOC_SIZE buffer at a time.
+ */
+extern int mln_json_generate_chain(mln_json_t *j, mln_alloc_t *pool, mln_chain_t **out_head, mln_chain_t **out_tail);
+/*
+ * mln_json_encode_length():
+ * Sizing pass only: the byte length mln_json_generate() would produce
+ * for 'j' (numbers are measured by formatting, escapes are counted),
+ * for callers that want to reserve space themselves.
+ */
+extern mln_size_t mln_json_encode_length(mln_json_t *j);
+/*
+ * mln_json_generate_buf():
+ * Two-pass encode into one buffer: the sizing pass fixes the length,
+ * then a single pool allocation is filled in one forward pass and
+ * returned as a one-node chain ready for mln_tcp_conn_append(). No
+ * growth or reallocation happens no matter how large the document is.
+ */
+extern mln_chain_t *mln_json_generate_buf(mln_json_t *j, mln_alloc_t *pool) __NONNULL2(1,2);
 extern void mln_json_free(void *json);
 extern void mln_json_dump(mln_json_t *j, int n_space, char *prefix);
 extern mln_string_t *mln_json_generate(mln_json_t *j);
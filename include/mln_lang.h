@@ -22,8 +22,18 @@
 #define M_LANG_RUN_STACK_LEN       1024
 #define M_LANG_SCOPE_LEN           1024
 #define M_LANG_MAX_OPENFILE        67
+#define M_LANG_CTX_CACHE_MAX       16
+#define M_LANG_LEAF_ARGS_MAX       8
 #define M_LANG_DEFAULT_STEP        1700
 #define M_LANG_HEARTBEAT_US        50000
+#define M_LANG_PRIORITY_LEVELS     32
+#define M_LANG_PRIORITY_MIN        0
+#define M_LANG_PRIORITY_MAX        (M_LANG_PRIORITY_LEVELS - 1)
+#define M_LANG_PRIORITY_DEFAULT    (M_LANG_PRIORITY_LEVELS >> 1)
+#define M_LANG_INT_CACHE_MIN       -128
+#define M_LANG_INT_CACHE_MAX       1024
+#define M_LANG_STR_CACHE_TABLE_LEN 371
+#define M_LANG_STR_CACHE_MAX_LEN   64
 #define MLN_LANG_PIPE_LIST_NALLOC  1024
 #define MLN_LANG_PIPE_ELEM_NALLOC  6
 #define MLN_LANG_IMPORT_FREE_COUNT 65535
@@ -55,14 +65,26 @@ typedef struct mln_lang_array_elem_s    mln_lang_array_elem_t;
 typedef struct mln_lang_methods_s       mln_lang_method_t;
 typedef struct mln_lang_resource_s      mln_lang_resource_t;
 typedef struct mln_lang_ast_cache_s     mln_lang_ast_cache_t;
+typedef struct mln_lang_shared_cache_s  mln_lang_shared_cache_t;
+typedef struct mln_lang_group_s         mln_lang_group_t;
 typedef struct mln_lang_hash_s          mln_lang_hash_t;
 typedef struct mln_lang_hash_bucket_s   mln_lang_hash_bucket_t;
+typedef struct mln_lang_str_cache_s     mln_lang_str_cache_t;
+typedef struct mln_lang_str_cache_node_s mln_lang_str_cache_node_t;
 typedef struct mln_lang_ctx_pipe_elem_s mln_lang_ctx_pipe_elem_t;
 
 typedef int (*mln_lang_run_ctl_t)(mln_lang_t *);
 typedef void (*mln_lang_stack_handler)(mln_lang_ctx_t *);
 typedef int (*mln_lang_op)(mln_lang_ctx_t *, mln_lang_var_t **, mln_lang_var_t *, mln_lang_var_t *);
 typedef mln_lang_var_t *(*mln_lang_internal) (mln_lang_ctx_t *);
+/*
+ * Leaf native handler. The evaluated arguments are borrowed -- at most
+ * M_LANG_LEAF_ARGS_MAX of them, read-only, valid only for the duration
+ * of the call. The handler must not suspend the context and must not
+ * keep any argument pointer. The returned variable becomes the call's
+ * result, NULL reports a failure.
+ */
+typedef mln_lang_var_t *(*mln_lang_internal_leaf) (mln_lang_ctx_t *, mln_lang_var_t **, mln_size_t);
 typedef int (*mln_msg_c_handler)(mln_lang_ctx_t *, const mln_lang_val_t *);
 typedef void (*mln_lang_return_handler)(mln_lang_ctx_t *);
 typedef void (*mln_lang_resource_free)(void *data);
@@ -83,6 +105,16 @@ struct mln_lang_hash_bucket_s {
     mln_lang_symbol_node_t          *tail;
 };
 
+struct mln_lang_str_cache_s {
+    mln_lang_str_cache_node_t      **bucket;
+    mln_size_t                       len;
+};
+
+struct mln_lang_str_cache_node_s {
+    mln_lang_val_t                  *val;
+    struct mln_lang_str_cache_node_s *next;
+};
+
 struct mln_lang_ast_cache_s {
     mln_lang_stm_t                  *stm;
     mln_string_t                    *code;
@@ -93,11 +125,42 @@ struct mln_lang_ast_cache_s {
     struct mln_lang_ast_cache_s     *next;
 };
 
+/*
+ * A process-wide store of compiled scripts shared read-only by several
+ * interpreter instances, each running on its own event loop in its own
+ * thread. Entries, their ASTs and the parser shift table live in the
+ * store's own pool and are only created or released under 'lock';
+ * between those points the ASTs are immutable, so a script compiled by
+ * one worker is executed by all of them without per-worker copies.
+ */
+struct mln_lang_shared_cache_s {
+    mln_alloc_t                     *pool;
+    void                            *shift_table;
+    mln_lang_ast_cache_t            *cache_head;
+    mln_lang_ast_cache_t            *cache_tail;
+    mln_u32_t                        ref;/*creator plus every attached interpreter*/
+    pthread_mutex_t                  lock;
+};
+
+/*
+ * Work distribution over a set of interpreters: incoming jobs are
+ * handed round-robin to the attached mln_lang_t instances. Submission
+ * is safe from any thread, the target instance is woken through its
+ * own signal handler.
+ */
+struct mln_lang_group_s {
+    mln_lang_t                     **langs;
+    mln_size_t                       nlangs;
+    mln_size_t                       cursor;
+    pthread_mutex_t                  lock;
+};
+
 struct mln_lang_s {
     mln_event_t                     *ev;
     mln_alloc_t                     *pool;
-    mln_lang_ctx_t                  *run_head;
-    mln_lang_ctx_t                  *run_tail;
+    mln_lang_ctx_t                  *run_head[M_LANG_PRIORITY_LEVELS];
+    mln_lang_ctx_t                  *run_tail[M_LANG_PRIORITY_LEVELS];
+    mln_u32_t                        run_map;/*bit n set when priority n has runnable tasks*/
     mln_lang_ctx_t                  *wait_head;
     mln_lang_ctx_t                  *wait_tail;
     mln_rbtree_t                    *resource_set;
@@ -107,6 +170,14 @@ struct mln_lang_s {
     void                            *shift_table;
     mln_lang_ast_cache_t            *cache_head;
     mln_lang_ast_cache_t            *cache_tail;
+    /*
+     * Recycled execution contexts. A finished context is torn down to
+     * its shell (struct + reset pool) and parked here, so the next
+     * mln_lang_job_new() skips pool construction entirely.
+     */
+    mln_lang_ctx_t                  *ctx_cache_head;
+    mln_u32_t                        ctx_cache_n;
+    mln_lang_shared_cache_t         *shared_cache;/*replaces the per-instance AST cache when attached*/
     mln_lang_run_ctl_t               signal;
     mln_lang_run_ctl_t               clear;
     ev_fd_handler                    launcher;
@@ -210,6 +281,18 @@ struct mln_lang_ctx_s {
     mln_lang_ast_cache_t            *cache;
     mln_gc_t                        *gc;
     mln_lang_hash_t                 *symbols;
+    mln_lang_val_t                 **int_cache;/*shared values for small integer constants*/
+    mln_lang_str_cache_t            *str_cache;/*interned string constant values*/
+    /*
+     * free-lists of recycled variable/value cells (linked via ->next);
+     * arithmetic churns through these at one cell per operation, so
+     * reuse keeps the hot path out of the allocator entirely
+     */
+    mln_lang_var_t                  *cell_vars;
+    mln_lang_val_t                  *cell_vals;
+    mln_u32_t                        cell_nvars;
+    mln_u32_t                        cell_nvals;
+    void                            *bc;/*bytecode program (mln_lang_bc_t), NULL on the AST walker*/
     struct mln_lang_ctx_s           *prev;
     struct mln_lang_ctx_s           *next;
     mln_lang_symbol_node_t          *sym_head;
@@ -227,7 +310,8 @@ struct mln_lang_ctx_s {
     mln_u32_t                        op_real_flag:1;
     mln_u32_t                        op_str_flag:1;
     mln_u32_t                        quit:1;
-    mln_u32_t                        padding:6;
+    mln_u32_t                        priority:5;/*run queue level, 0 is the most urgent*/
+    mln_u32_t                        shared_stm:1;/*AST borrowed from a shared cache, treat it read-only*/
 };
 
 struct mln_lang_resource_s {
@@ -276,6 +360,7 @@ struct mln_lang_var_s {
     mln_lang_var_t                  *prev;
     mln_lang_var_t                  *next;
     mln_uauto_t                      ref;
+    mln_lang_ctx_t                  *ctx;/*owner, backs the cell cache; NULL on stack temporaries*/
 };
 
 typedef enum {
@@ -293,8 +378,10 @@ struct mln_lang_func_detail_s {
     mln_lang_func_type_t             type;
     union {
         mln_lang_internal        process;
+        mln_lang_internal_leaf   leaf_process;
         mln_lang_stm_t          *stm;
     } data;
+    mln_u32_t                        leaf:1;/*internal handler takes the fast, frameless call path*/
 };
 
 typedef enum {
@@ -316,6 +403,7 @@ struct mln_lang_object_s {
     mln_lang_set_detail_t           *in_set;
     mln_rbtree_t                    *members;
     mln_u64_t                        ref;
+    mln_u64_t                        version;/*shape stamp, renewed whenever the member set changes*/
     mln_lang_gc_item_t              *gc_item;
     mln_lang_ctx_t                  *ctx;
 };
@@ -337,6 +425,7 @@ struct mln_lang_val_s {
     mln_u32_t                        ref;
     mln_lang_val_t                  *udata;
     mln_lang_func_detail_t          *func;
+    mln_lang_ctx_t                  *ctx;/*owner, backs the cell cache; NULL on stack temporaries*/
     mln_u32_t                        not_modify:1;
 };
 
@@ -352,8 +441,19 @@ struct mln_lang_funccall_val_s {
 struct mln_lang_array_s {
     mln_rbtree_t                    *elems_index;
     mln_rbtree_t                    *elems_key;
+    /*
+     * Dense part. While an array only ever sees the integer keys
+     * 0,1,2,... (the usual for-loop shape), its values live in the
+     * contiguous 'vec' and indexing is O(1). The first sparse,
+     * negative or non-integer key spills the vector into the trees
+     * and the array stays tree-backed from then on.
+     */
+    mln_lang_var_t                 **vec;
+    mln_u64_t                        vec_n;
+    mln_u64_t                        vec_cap;
     mln_u64_t                        index;
     mln_u64_t                        ref;
+    mln_u32_t                        spilled;
     mln_lang_gc_item_t              *gc_item;
     mln_lang_ctx_t                  *ctx;
 };
@@ -441,7 +541,18 @@ extern mln_lang_method_t *mln_lang_methods[];
 #define mln_lang_ctx_is_quit(ctx)    ((ctx)->quit)
 #define mln_lang_mutex_lock(lang)    pthread_mutex_lock(&(lang)->lock)
 #define mln_lang_mutex_unlock(lang)  pthread_mutex_unlock(&(lang)->lock)
-#define mln_lang_task_empty(lang)    ((lang)->run_head == NULL && (lang)->wait_head == NULL)
+#define mln_lang_task_empty(lang)    ((lang)->run_map == 0 && (lang)->wait_head == NULL)
+#define mln_lang_ctx_priority_get(ctx) ((ctx)->priority)
+/*
+ * Scheduling budget of one time slice, sized from the context's
+ * priority: level 0 gets twice M_LANG_DEFAULT_STEP, the lowest level
+ * gets the plain default, levels in between scale linearly. The
+ * scheduler spends it on execution steps (AST walker) or backward
+ * branches (bytecode engine).
+ */
+#define mln_lang_ctx_step_budget(ctx) \
+    ((int)(M_LANG_DEFAULT_STEP + \
+           ((M_LANG_PRIORITY_MAX - (ctx)->priority) * M_LANG_DEFAULT_STEP) / M_LANG_PRIORITY_MAX))
 #define mln_lang_signal_get(lang)    ((lang)->signal)
 #define mln_lang_event_get(lang)     ((lang)->ev)
 #define mln_lang_launcher_get(lang)  ((lang)->launcher)
@@ -458,6 +569,19 @@ mln_lang_job_new(mln_lang_t *lang, \
                  void *udata, \
                  mln_lang_return_handler handler) __NONNULL2(1,3);
 extern void mln_lang_job_free(mln_lang_ctx_t *ctx);
+extern mln_lang_shared_cache_t *mln_lang_shared_cache_new(void);
+/* Drops one reference; the store is destroyed when the creator and all attached interpreters are gone. */
+extern void mln_lang_shared_cache_free(mln_lang_shared_cache_t *sc);
+extern int mln_lang_shared_cache_attach(mln_lang_t *lang, mln_lang_shared_cache_t *sc) __NONNULL2(1,2);
+extern mln_lang_group_t *mln_lang_group_new(void);
+extern void mln_lang_group_free(mln_lang_group_t *group);
+extern int mln_lang_group_add(mln_lang_group_t *group, mln_lang_t *lang) __NONNULL2(1,2);
+extern mln_lang_ctx_t *
+mln_lang_group_job_new(mln_lang_group_t *group, \
+                       mln_u32_t type, \
+                       mln_string_t *data, \
+                       void *udata, \
+                       mln_lang_return_handler handler) __NONNULL2(1,3);
 extern void mln_lang_funccall_val_object_add(mln_lang_funccall_val_t *func, mln_lang_val_t *obj_val) __NONNULL2(1,2);
 /*
  * Note:
@@ -465,6 +589,17 @@ extern void mln_lang_funccall_val_object_add(mln_lang_funccall_val_t *func, mln_
  */
 extern int mln_lang_ctx_global_var_add(mln_lang_ctx_t *ctx, mln_string_t *name, void *val, mln_u32_t type) __NONNULL2(1,2);
 extern mln_lang_var_t *mln_lang_var_create_call(mln_lang_ctx_t *ctx, mln_lang_funccall_val_t *call);
+/*
+ * Builds a scalar (nil/bool/int/real) operation result. When 'reuse'
+ * is a dying temporary -- unnamed, unreferenced and sole owner of an
+ * unshared scalar value, i.e. an intermediate produced and consumed
+ * within one expression -- the result is written into its cells in
+ * place instead of allocating new ones, which keeps chained arithmetic
+ * on the same pair of cells. Otherwise equivalent to creating a fresh
+ * anonymous variable of 'type'.
+ */
+extern mln_lang_var_t *
+mln_lang_var_result(mln_lang_ctx_t *ctx, mln_lang_var_t *reuse, mln_s32_t type, void *data) __NONNULL1(1);
 extern mln_lang_var_t *mln_lang_var_create_nil(mln_lang_ctx_t *ctx, mln_string_t *name) __NONNULL1(1);
 extern mln_lang_var_t *mln_lang_var_create_obj(mln_lang_ctx_t *ctx, mln_lang_set_detail_t *in_set, mln_string_t *name) __NONNULL1(1);
 extern mln_lang_var_t *mln_lang_var_create_true(mln_lang_ctx_t *ctx, mln_string_t *name) __NONNULL1(1);
@@ -505,6 +640,15 @@ mln_lang_func_detail_new(mln_lang_ctx_t *ctx, \
                          void *data, \
                          mln_lang_exp_t *exp, \
                          mln_lang_exp_t *closure) __NONNULL2(1,3);
+/*
+ * Registers an internal function on the fast call path: no scope
+ * symbols are built, the handler receives the borrowed arguments
+ * directly (see mln_lang_internal_leaf). Only for handlers that never
+ * suspend; arguments beyond M_LANG_LEAF_ARGS_MAX are not visible to
+ * the handler.
+ */
+extern mln_lang_func_detail_t *
+mln_lang_func_detail_leaf_new(mln_lang_ctx_t *ctx, mln_lang_internal_leaf process) __NONNULL2(1,2);
 extern void mln_lang_func_detail_free(mln_lang_func_detail_t *lfd);
 extern void mln_lang_func_detail_arg_append(mln_lang_func_detail_t *func, mln_lang_var_t *var) __NONNULL2(1,2);
 extern mln_lang_val_t *mln_lang_val_new(mln_lang_ctx_t *ctx, mln_s32_t type, void *data) __NONNULL1(1);
@@ -531,12 +675,27 @@ extern int
 mln_lang_set_member_add(mln_alloc_t *pool, mln_rbtree_t *members, mln_lang_var_t *var) __NONNULL3(1,2,3);
 extern int
 mln_lang_object_add_member(mln_lang_ctx_t *ctx, mln_lang_object_t *obj, mln_lang_var_t *var) __NONNULL3(1,2,3);
+/*
+ * Renews the object's shape stamp from a monotonic counter. Must be
+ * called after any mutation of the member set so the inline caches
+ * keyed by the old stamp stop matching; stamps are never reused, so a
+ * freed object's cache entries cannot alias a new one.
+ */
+extern void mln_lang_object_shape_restamp(mln_lang_object_t *obj) __NONNULL1(1);
 extern mln_lang_array_t *mln_lang_array_new(mln_lang_ctx_t *ctx) __NONNULL1(1);
 extern void mln_lang_array_free(mln_lang_array_t *array);
 extern int mln_lang_array_elem_exist(mln_lang_array_t *array, mln_lang_var_t *key) __NONNULL2(1,2);
 extern int mln_lang_ctx_resource_register(mln_lang_ctx_t *ctx, char *name, void *data, mln_lang_resource_free free_handler) __NONNULL2(1,2);
 extern void *mln_lang_ctx_resource_fetch(mln_lang_ctx_t *ctx, const char *name) __NONNULL2(1,2);
 extern void mln_lang_ctx_set_ret_var(mln_lang_ctx_t *ctx, mln_lang_var_t *var) __NONNULL1(1);
+/*
+ * mln_lang_ctx_priority_set():
+ * Move a task to another run queue level. Level 0 is scheduled first;
+ * tasks on the same level keep round-robin order. Values outside
+ * [M_LANG_PRIORITY_MIN, M_LANG_PRIORITY_MAX] are clamped. Suspended
+ * tasks only change level and are re-queued on it when they continue.
+ */
+extern void mln_lang_ctx_priority_set(mln_lang_ctx_t *ctx, mln_u32_t priority) __NONNULL1(1);
 extern void mln_lang_ctx_suspend(mln_lang_ctx_t *ctx) __NONNULL1(1);
 extern void mln_lang_ctx_continue(mln_lang_ctx_t *ctx) __NONNULL1(1);
 extern int mln_lang_resource_register(mln_lang_t *lang, char *name, void *data, mln_lang_resource_free free_handler) __NONNULL2(1,2);
@@ -394,6 +394,14 @@ struct mln_lang_locate_s {
     mln_lang_locate_t               *next;
     void                            *jump;
     int                              type;
+    /*
+     * inline cache for M_LOCATE_PROPERTY: the member slot resolved at
+     * this site, valid while the object still carries 'cache_version'
+     * (see the locate stack handler in mln_lang.c)
+     */
+    void                            *cache_members;
+    mln_u64_t                        cache_version;
+    void                            *cache_var;
 };
 
 struct mln_lang_locate_tmp_s {
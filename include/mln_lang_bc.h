@@ -0,0 +1,68 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#ifndef __MLN_LANG_BC_H
+#define __MLN_LANG_BC_H
+
+#include "mln_lang.h"
+#include "mln_lang_ast.h"
+
+#define M_LANG_BC_STACK_LEN 128
+
+typedef struct mln_lang_bc_inst_s {
+    mln_u16_t                        op;
+    mln_u16_t                        moff;/*offset of the handler in mln_lang_method_t*/
+    mln_s32_t                        target;
+    union {
+        mln_s64_t                i;
+        double                   f;
+        mln_string_t            *s;/*borrowed from the AST, which outlives the program*/
+    } data;
+    mln_lang_symbol_node_t          *sym;/*runtime symbol cache for LOAD/STORE*/
+} mln_lang_bc_inst_t;
+
+typedef struct mln_lang_bc_s {
+    mln_lang_bc_inst_t              *insts;
+    mln_size_t                       ninst;
+    mln_size_t                       cap;
+    mln_size_t                       pc;
+    mln_s32_t                        sp;
+    mln_lang_var_t                  *stack[M_LANG_BC_STACK_LEN];
+} mln_lang_bc_t;
+
+/*
+ * mln_lang_bc_compile():
+ * Compile the task's AST into a flat instruction array. Only the
+ * statement and expression subset whose semantics the bytecode engine
+ * reproduces exactly is accepted -- plain variables, literals, the
+ * operator set, if/while/for, break/continue and return. Anything else
+ * (functions, sets, arrays, switch, goto, ...) makes compilation
+ * return NULL and the task falls back to the AST-walking interpreter.
+ */
+extern mln_lang_bc_t *mln_lang_bc_compile(mln_lang_ctx_t *ctx) __NONNULL1(1);
+extern void mln_lang_bc_free(mln_lang_bc_t *bc);
+/*
+ * mln_lang_bc_load():
+ * Load a precompiled program from '<path>.mlnc'. The cache is validated
+ * against the source file's size and mtime and against the cache format
+ * version; any mismatch returns NULL and the caller parses the source
+ * as usual. mln_lang_bc_store() writes the cache after a successful
+ * compilation, atomically via a temporary file. Both are no-ops on
+ * platforms without mmap.
+ */
+extern mln_lang_bc_t *mln_lang_bc_load(mln_lang_ctx_t *ctx, mln_string_t *path) __NONNULL2(1,2);
+extern void mln_lang_bc_store(mln_lang_ctx_t *ctx, mln_string_t *path) __NONNULL2(1,2);
+/*
+ * mln_lang_bc_run():
+ * Execute the task's program until 'step' backward branches have been
+ * taken. Straight-line code and forward branches run unchecked: the
+ * compiled subset has no calls, so only a backward branch can make
+ * execution unbounded, and charging the budget there keeps the hot
+ * dispatch path free of scheduling tests. Sets ctx->quit when the
+ * program finishes or an error is raised.
+ */
+extern void mln_lang_bc_run(mln_lang_ctx_t *ctx, int step) __NONNULL1(1);
+
+#endif
+
@@ -25,6 +25,9 @@
 #define M_INPUT_T_BUF  0
 #define M_INPUT_T_FILE 1
 
+#define M_LEX_RUN_ID   0
+#define M_LEX_RUN_NUM  1
+
 /*
  * error number
  */
@@ -137,6 +140,7 @@ struct mln_lex_attr {
 
 typedef struct {
     mln_u32_t           type;
+    mln_u32_t           mapped; /*file input mmap'd, buf covers the whole file*/
     int                 fd;
     mln_string_t       *data;
     mln_string_t       *dir;
@@ -158,6 +162,9 @@ struct mln_lex_s {
     mln_stack_t        *stack;
     mln_lex_hooks_t     hooks;
     mln_rbtree_t       *keywords;
+    mln_lex_keyword_t  *kw_tbl;     /*perfect-hash slots, empty slot keyword is NULL*/
+    mln_u64_t           kw_tbl_len; /*power of two*/
+    mln_u64_t           kw_seed;
     mln_s8ptr_t         err_msg;
     mln_u8ptr_t         result_buf;
     mln_u8ptr_t         result_pos;
@@ -245,6 +252,33 @@ static inline int mln_lex_putchar(mln_lex_t *lex, char c)
     return 0;
 }
 
+static inline int mln_lex_putbytes(mln_lex_t *lex, mln_u8ptr_t buf, mln_u64_t len)
+{
+    if (lex->result_buf == NULL) {
+        if ((lex->result_buf = (mln_u8ptr_t)mln_alloc_m(lex->pool, lex->result_buf_len)) == NULL) {
+            lex->error = MLN_LEX_ENMEM;
+            return MLN_ERR;
+        }
+        lex->result_pos = lex->result_buf;
+    }
+    if (lex->result_pos + len > lex->result_buf + lex->result_buf_len) {
+        mln_u64_t diff = lex->result_pos - lex->result_buf;
+        mln_u64_t newlen = lex->result_buf_len;
+        mln_u8ptr_t tmp = lex->result_buf;
+        while (diff + len > newlen) newlen += ((newlen + 1) >> 1);
+        if ((lex->result_buf = (mln_u8ptr_t)mln_alloc_re(lex->pool, tmp, newlen)) == NULL) {
+            lex->result_buf = tmp;
+            lex->error = MLN_LEX_ENMEM;
+            return MLN_ERR;
+        }
+        lex->result_buf_len = newlen;
+        lex->result_pos = lex->result_buf + diff;
+    }
+    memcpy(lex->result_pos, buf, len);
+    lex->result_pos += len;
+    return 0;
+}
+
 static inline char mln_lex_getchar(mln_lex_t *lex)
 {
     int n;
@@ -254,7 +288,7 @@ lp:
         return MLN_EOF;
     }
     in = lex->cur;
-    if (in->type == M_INPUT_T_BUF) {
+    if (in->type == M_INPUT_T_BUF || in->mapped) {
         if (in->buf == NULL) {
             in->pos = in->buf = in->data->data;
         }
@@ -291,6 +325,51 @@ again:
     return (char)(*(in->pos)++);
 }
 
+static inline int mln_lex_run_char(char c, int kind)
+{
+    if (kind == M_LEX_RUN_ID)
+        return c == '_' || isalpha(c) || isdigit(c);
+    return isdigit(c) || isalpha(c) || c == '.';
+}
+
+/*
+ * Consumes a run of identifier or number characters starting with 'c',
+ * which the caller has already read and classified. When the current
+ * input is contiguous in memory (a buffer, or an mmap'd file) the run
+ * is located with pointer arithmetic and appended in one memcpy() instead
+ * of going through getchar/putchar per character. Returns the first
+ * character past the run (not stepped back), or MLN_ERR.
+ */
+static inline char mln_lex_scan_run(mln_lex_t *lex, char c, int kind)
+{
+    mln_lex_input_t *in;
+    while (1) {
+        if (mln_lex_putchar(lex, c) == MLN_ERR) return MLN_ERR;
+        in = lex->cur;
+        if (in != NULL && (in->type == M_INPUT_T_BUF || in->mapped) && in->buf != NULL) {
+            mln_u8ptr_t p = in->pos, end = in->buf + in->buf_len;
+            while (p < end && mln_lex_run_char((char)(*p), kind)) ++p;
+            if (p > in->pos) {
+                if (mln_lex_putbytes(lex, in->pos, p - in->pos) == MLN_ERR) return MLN_ERR;
+                in->pos = p;
+            }
+        }
+        if ((c = mln_lex_getchar(lex)) == MLN_ERR) return MLN_ERR;
+        if (!mln_lex_run_char(c, kind)) break;
+    }
+    return c;
+}
+
+static inline mln_u64_t mln_lex_keyword_hash(mln_u8ptr_t s, mln_u64_t len, mln_u64_t seed)
+{
+    mln_u64_t h = seed ^ 0xcbf29ce484222325ULL;
+    for (; len > 0; --len, ++s) {
+        h ^= *s;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
 static inline int mln_lex_is_letter(char c)
 {
     if (c == '_' || isalpha(c))
@@ -675,6 +754,13 @@ PREFIX_NAME##_type_t PREFIX_NAME##_token_type_array[] = {           \
         mln_u8ptr_t p = lex->result_buf;\
         mln_lex_keyword_t lk, *plk;\
         mln_rbtree_node_t *rn;\
+        if (lex->kw_tbl != NULL) {\
+            plk = &lex->kw_tbl[mln_lex_keyword_hash(p, diff, lex->kw_seed) & (lex->kw_tbl_len - 1)];\
+            if (plk->keyword != NULL && plk->keyword->len == diff && !memcmp(plk->keyword->data, p, diff)) {\
+                return PREFIX_NAME##_new(lex, TK_PREFIX##_TK_KEYWORD_BEGIN+plk->val+1);\
+            }\
+            return PREFIX_NAME##_new(lex, TK_PREFIX##_TK_ID);\
+        }\
         mln_string_nset(&tmp, p, diff);\
         lk.keyword = &tmp;\
         rn = mln_rbtree_search(lex->keywords, &lk);\
@@ -685,15 +771,20 @@ PREFIX_NAME##_type_t PREFIX_NAME##_token_type_array[] = {           \
         return PREFIX_NAME##_new(lex, TK_PREFIX##_TK_ID);\
     }\
     \
+    static signed char PREFIX_NAME##_handler_index[256];\
     static inline PREFIX_NAME##_struct_t *PREFIX_NAME##_process_spec_char(mln_lex_t *lex, char c)\
     {\
         mln_s32_t i;\
         mln_s32_t end = sizeof(PREFIX_NAME##_handlers)/sizeof(mln_spechar_t);\
-        for (i = 0; i<end; ++i) {\
-            if (c == PREFIX_NAME##_handlers[i].sc) {\
-                return (PREFIX_NAME##_struct_t *)PREFIX_NAME##_handlers[i].handler(lex, PREFIX_NAME##_handlers[i].data);\
+        if (PREFIX_NAME##_handler_index[0] == 0) {\
+            memset(PREFIX_NAME##_handler_index, -1, sizeof(PREFIX_NAME##_handler_index));\
+            for (i = 0; i < end; ++i) {\
+                PREFIX_NAME##_handler_index[(mln_u8_t)PREFIX_NAME##_handlers[i].sc] = i;\
             }\
         }\
+        if ((i = PREFIX_NAME##_handler_index[(mln_u8_t)c]) >= 0) {\
+            return (PREFIX_NAME##_struct_t *)PREFIX_NAME##_handlers[i].handler(lex, PREFIX_NAME##_handlers[i].data);\
+        }\
         mln_lex_error_set(lex, MLN_LEX_EINVCHAR);\
         return NULL;\
     }\
@@ -729,11 +820,7 @@ lp:\
             default:\
                 {\
                     if (mln_lex_is_letter(c)) {\
-                        while (mln_lex_is_letter(c) || isdigit(c)) {\
-                            if (mln_lex_putchar(lex, c) == MLN_ERR) return NULL;\
-                            c = mln_lex_getchar(lex);\
-                            if (c == MLN_ERR) return NULL;\
-                        }\
+                        if ((c = mln_lex_scan_run(lex, c, M_LEX_RUN_ID)) == MLN_ERR) return NULL;\
                         mln_lex_stepback(lex, c);\
                         if (lex->result_buf[0] == (mln_u8_t)'_' && lex->result_pos == lex->result_buf+1) {\
                             sret = PREFIX_NAME##_process_spec_char(lex, '_');\
@@ -744,15 +831,8 @@ lp:\
                         if (sret == NULL || !lex->ignore) return sret;\
                         goto beg;\
                     } else if (isdigit(c)) {\
-                        while ( 1 ) {\
-                            if (mln_lex_putchar(lex, c) == MLN_ERR) return NULL;\
-                            c = mln_lex_getchar(lex);\
-                            if (c == MLN_ERR) return NULL;\
-                            if (!isdigit(c) && !isalpha(c) && c != '.') {\
-                                mln_lex_stepback(lex, c);\
-                                break;\
-                            }\
-                        }\
+                        if ((c = mln_lex_scan_run(lex, c, M_LEX_RUN_NUM)) == MLN_ERR) return NULL;\
+                        mln_lex_stepback(lex, c);\
                         /*check number*/\
                         mln_u8ptr_t chk = lex->result_buf;\
                         if (*chk == (mln_u8_t)'0' && lex->result_pos-lex->result_buf > 1) {\
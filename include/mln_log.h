@@ -27,7 +27,10 @@ typedef struct {
     int             fd;
     mln_u32_t       in_daemon:1;
     mln_u32_t       init:1;
-    mln_u32_t       padding:30;
+    mln_u32_t       async:1;          /*'log_async on;' in domain 'main'*/
+    mln_u32_t       overflow_block:1; /*'log_async_overflow "block";', default drop*/
+    mln_u32_t       binary:1;         /*'log_binary on;', implies async*/
+    mln_u32_t       padding:27;
     mln_log_level_t level;
     mln_spin_t      thread_lock;
 } mln_log_t;
@@ -56,6 +59,23 @@ extern void _mln_sys_log(mln_log_level_t level, \
 #define mln_log(err_lv,msg,...) \
     _mln_sys_log(err_lv, __FILE__, __FUNCTION__, __LINE__, msg, ## __VA_ARGS__)
 extern ssize_t mln_log_writen(void *buf, mln_size_t size);
+/*
+ * Asynchronous mode ('log_async on;' in domain 'main'): each logging
+ * thread formats its record into a private bounded ring buffer without
+ * taking any lock, and a dedicated flusher thread drains the rings to
+ * the log file. When a ring is full the record is dropped and counted
+ * (the flusher reports the count), or the producer waits for space
+ * with 'log_async_overflow "block";'. mln_log_async_dropped() returns
+ * the total number of records dropped so far.
+ *
+ * 'log_binary on;' (read at initialization only, implies log_async)
+ * additionally defers formatting: the logging thread captures the
+ * format string address and the raw arguments, and the flusher renders
+ * the text, so the hot path pays neither snprintf nor locking.
+ * Messages from a custom logger set via mln_log_logger_set() cannot be
+ * deferred and keep the formatted async path.
+ */
+extern mln_u64_t mln_log_async_dropped(void);
 extern int mln_log_fd(void);
 extern char *mln_log_dir_path(void);
 extern char *mln_log_logfile_path(void);
@@ -21,5 +21,72 @@ extern mln_matrix_t *
 mln_matrix_mul(mln_matrix_t *m1, mln_matrix_t *m2) __NONNULL2(1,2);
 extern mln_matrix_t *mln_matrix_inverse(mln_matrix_t *matrix);
 extern void mln_matrix_dump(mln_matrix_t *matrix);
+
+/*
+ * Parallel variants. They partition row blocks across an
+ * mln_thread_pool whose child_process_handler is
+ * mln_matrix_pool_handler, and must be called from that pool's main
+ * thread (the one inside mln_thread_pool_run), which submits the
+ * blocks and waits on their futures. 'nworker' is the number of blocks
+ * to split into, normally the pool's worker count; with nworker <= 1,
+ * or when a matrix is too small for splitting to pay off, they run the
+ * serial path. Like mln_matrix_inverse, the parallel inverse consumes
+ * the input matrix's data. Elimination steps are parallelized per
+ * pivot; pivoting and normalization stay on the main thread.
+ */
+extern int mln_matrix_pool_handler(void *data) __NONNULL1(1);
+extern mln_matrix_t *
+mln_matrix_mul_parallel(mln_matrix_t *m1, mln_matrix_t *m2, mln_u32_t nworker) __NONNULL2(1,2);
+extern mln_matrix_t *
+mln_matrix_inverse_parallel(mln_matrix_t *matrix, mln_u32_t nworker);
+
+/*
+ * Single-precision batches of same-shape small matrices (4x4 to 16x16
+ * is the intended range). Elements are stored structure-of-arrays: the
+ * (i,j) element of every matrix in the batch lies contiguously, i.e.
+ * data[(i*col + j)*n + b] is element (i,j) of matrix 'b'. With that
+ * layout a batched multiply is pure element-wise FMA across the batch
+ * dimension, so one call amortizes dispatch over the whole batch and
+ * the kernels vectorize regardless of how tiny each matrix is, at half
+ * the memory traffic of the double-precision path.
+ */
+typedef struct {
+    mln_size_t  row;
+    mln_size_t  col;
+    mln_size_t  n;      /*matrices in the batch*/
+    float      *data;
+    mln_u32_t   is_ref:1;
+} mln_matrix_f32_batch_t;
+
+/*element (i,j) of matrix 'b' in the batch*/
+#define mln_matrix_f32_at(batch,b,i,j) \
+    ((batch)->data[((i)*(batch)->col + (j))*(batch)->n + (b)])
+
+extern mln_matrix_f32_batch_t *
+mln_matrix_f32_batch_new(mln_size_t row, mln_size_t col, mln_size_t n, \
+                         float *data, mln_u32_t is_ref) __NONNULL1(4);
+extern void mln_matrix_f32_batch_free(mln_matrix_f32_batch_t *batch);
+/*
+ * Multiply batch element b of 'b1' by batch element b of 'b2' for
+ * every b at once. Shapes must agree (b1->col == b2->row,
+ * b1->n == b2->n; errno EINVAL otherwise). Return a new row1 x col2
+ * batch, or NULL on error.
+ */
+extern mln_matrix_f32_batch_t *
+mln_matrix_mul_batch(mln_matrix_f32_batch_t *b1, mln_matrix_f32_batch_t *b2) __NONNULL2(1,2);
+/*
+ * Layout conversion between 'nr' caller-side row-major matrices
+ * ('mats', each row*col floats, laid out one after another) and the
+ * batch's interleaved storage, for feeding and draining batches at the
+ * edges of a pipeline.
+ */
+extern void mln_matrix_f32_batch_pack(mln_matrix_f32_batch_t *batch, \
+                                      mln_size_t b0, \
+                                      const float *mats, \
+                                      mln_size_t nr) __NONNULL2(1,3);
+extern void mln_matrix_f32_batch_unpack(mln_matrix_f32_batch_t *batch, \
+                                        mln_size_t b0, \
+                                        float *mats, \
+                                        mln_size_t nr) __NONNULL2(1,3);
 #endif
 
@@ -7,6 +7,7 @@
 
 #include "mln_types.h"
 #include "mln_alloc.h"
+#include "mln_chain.h"
 
 #define __M_MD5_BUFLEN 64
 #define __M_MD5_F(x,y,z) (((x)&(y))|((~(x))&(z)))
@@ -36,6 +37,21 @@ extern mln_md5_t *mln_md5_pool_new(mln_alloc_t *pool) __NONNULL1(1);
 extern void mln_md5_free(mln_md5_t *m);
 extern void mln_md5_pool_free(mln_md5_t *m);
 extern void mln_md5_calc(mln_md5_t *m, mln_u8ptr_t input, mln_uauto_t len, mln_u32_t is_last) __NONNULL1(1);
+/*
+ * Feed every in-memory buffer of 'in' (pos..last, as filled by
+ * mln_tcp_conn_recv) into the digest, so a streamed upload is hashed
+ * chain by chain without assembling it first. 'is_last' finalizes
+ * after the last buffer, like mln_md5_calc().
+ */
+extern void mln_md5_calc_chain(mln_md5_t *m, mln_chain_t *in, mln_u32_t is_last) __NONNULL1(1);
+/*
+ * Digest 'n' independent messages; digests[i] receives the 16-byte
+ * digest of inputs[i]/lens[i]. On SSE2 hosts four messages are hashed
+ * in parallel, one per 32-bit SIMD lane, for as long as all four still
+ * have full 64-byte blocks; intended for batch verification jobs over
+ * many similar-sized objects.
+ */
+extern void mln_md5_batch(mln_u8ptr_t *inputs, mln_uauto_t *lens, mln_u8ptr_t *digests, mln_size_t n) __NONNULL3(1,2,3);
 extern void mln_md5_tobytes(mln_md5_t *m, mln_u8ptr_t buf, mln_u32_t len) __NONNULL1(1);
 extern void mln_md5_tostring(mln_md5_t *m, mln_s8ptr_t buf, mln_u32_t len) __NONNULL1(1);
 extern void mln_md5_dump(mln_md5_t *m) __NONNULL1(1);
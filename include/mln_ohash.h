@@ -0,0 +1,67 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+
+#ifndef __MLN_OHASH_H
+#define __MLN_OHASH_H
+
+#include "mln_hash.h"
+
+typedef struct mln_ohash_s mln_ohash_t;
+
+/*
+ * Open-addressing counterpart of mln_hash for hot lookup paths.
+ * Key/value pairs live inline in one flat slot array probed linearly
+ * with robin-hood displacement, so a hit touches one or two cache
+ * lines and inserts allocate nothing. Unlike mln_hash, the hash
+ * handler must return the FULL hash value; the table folds it with
+ * its own power-of-two mask and resizes itself without re-invoking
+ * the handler.
+ */
+typedef mln_u64_t (*ohash_calc_handler)(mln_ohash_t *, void *);
+typedef int (*ohash_cmp_handler)(mln_ohash_t *, void *, void *);
+typedef int (*ohash_iterate_handler)(void * /*key*/, void * /*val*/, void *);
+
+struct mln_ohash_attr {
+    void                    *pool;
+    hash_pool_alloc_handler  pool_alloc;
+    hash_pool_free_handler   pool_free;
+    ohash_calc_handler       hash;
+    ohash_cmp_handler        cmp;
+    hash_free_handler        free_key;
+    hash_free_handler        free_val;
+    mln_u64_t                len_base;/*rounded up to a power of two*/
+};
+
+typedef struct {
+    mln_u64_t                hash;
+    void                    *key;/*NULL means the slot is empty*/
+    void                    *val;
+} mln_ohash_slot_t;
+
+struct mln_ohash_s {
+    void                    *pool;
+    hash_pool_alloc_handler  pool_alloc;
+    hash_pool_free_handler   pool_free;
+    ohash_calc_handler       hash;
+    ohash_cmp_handler        cmp;
+    hash_free_handler        free_key;
+    hash_free_handler        free_val;
+    mln_ohash_slot_t        *slots;
+    mln_u64_t                mask;/*capacity - 1*/
+    mln_u64_t                nr_nodes;
+};
+
+extern mln_ohash_t *mln_ohash_new(struct mln_ohash_attr *attr) __NONNULL1(1);
+extern void mln_ohash_free(mln_ohash_t *h, mln_hash_flag_t flg) __NONNULL1(1);
+extern void *mln_ohash_search(mln_ohash_t *h, void *key) __NONNULL2(1,2);
+extern int mln_ohash_insert(mln_ohash_t *h, void *key, void *val) __NONNULL2(1,2);
+extern void mln_ohash_remove(mln_ohash_t *h, void *key, mln_hash_flag_t flg) __NONNULL2(1,2);
+extern void *mln_ohash_change_value(mln_ohash_t *h, void *key, void *new_value) __NONNULL2(1,2);
+extern int mln_ohash_key_exist(mln_ohash_t *h, void *key) __NONNULL2(1,2);
+extern int mln_ohash_iterate(mln_ohash_t *h, ohash_iterate_handler handler, void *udata) __NONNULL1(1);
+extern void mln_ohash_reset(mln_ohash_t *h, mln_hash_flag_t flg) __NONNULL1(1);
+
+#endif
+
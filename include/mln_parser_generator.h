@@ -21,6 +21,14 @@
 #define M_PG_SHIFT 1
 #define M_PG_REDUCE 2
 #define M_PG_ACCEPT 3
+/*for serialized table cache*/
+#define M_PG_CACHE_MAGIC   0x4d504743
+#define M_PG_CACHE_VERSION 1
+#if defined(__GNUC__)
+#define M_PG_UNUSED __attribute__((unused))
+#else
+#define M_PG_UNUSED
+#endif
 /*for parser*/
 #define M_P_QLEN 16
 #define M_P_CUR_STACK 0
@@ -90,8 +98,12 @@ typedef struct {
 
 typedef struct {
     mln_shift_t             **tbl;
+    mln_shift_t              *flat;     /*dense nr_state x nr_col block, rows of 'tbl' point into it*/
     mln_sauto_t               nr_state;
     int                       type_val;
+    mln_u32_t                 nr_col;   /*columns per state row*/
+    void                     *map;      /*non-NULL when mmap'd from cache*/
+    mln_size_t                map_size;
 } mln_pg_shift_tbl_t;
 
 struct mln_pg_calc_info_s {
@@ -187,6 +199,21 @@ extern int mln_pg_calc_follow(volatile int *map, mln_pg_rule_t *r, mln_u32_t nr_
 extern int mln_pg_closure(mln_pg_state_t *s, mln_pg_rule_t *r, mln_u32_t nr_rule);
 extern int mln_pg_goto(struct mln_pg_calc_info_s *pci);
 extern void mln_pg_output_state(mln_pg_state_t *s);
+/*
+ * Serialized table cache. mln_pg_shift_tbl_dump() writes the shift
+ * table as a versioned binary blob keyed on the grammar hash (written
+ * to a temporary file and renamed, so readers never see a partial
+ * blob). mln_pg_shift_tbl_load() maps the blob read-only and returns
+ * a table whose rows point into the mapping -- mln_fork() workers all
+ * share one physical copy -- or NULL when the file is missing, from a
+ * different library version or built from a different grammar, in
+ * which case the caller regenerates. Tables from either origin are
+ * released with the generated PREFIX##_pg_data_free().
+ */
+extern mln_u64_t mln_pg_grammar_hash(mln_production_t *prod_tbl, mln_u32_t nr_prod);
+extern int mln_pg_shift_tbl_dump(mln_pg_shift_tbl_t *tbl, mln_u64_t hash, const char *path);
+extern mln_pg_shift_tbl_t *mln_pg_shift_tbl_load(mln_u64_t hash, const char *path);
+extern void mln_pg_shift_tbl_cache_free(mln_pg_shift_tbl_t *tbl);
 
 
 #define MLN_DECLARE_PARSER_GENERATOR(SCOPE,PREFIX_NAME,TK_PREFIX,...); \
@@ -224,6 +251,7 @@ PREFIX_NAME##_pg_process_token(struct PREFIX_NAME##_preprocess_attr *attr, mln_l
 SCOPE int PREFIX_NAME##_preprocess(struct PREFIX_NAME##_preprocess_attr *attr);\
 SCOPE void PREFIX_NAME##_preprocess_attr_free(struct PREFIX_NAME##_preprocess_attr *attr);\
 SCOPE void *PREFIX_NAME##_parser_generate(mln_production_t *prod_tbl, mln_u32_t nr_prod, mln_string_t *env);\
+SCOPE void *PREFIX_NAME##_parser_generate_cached(mln_production_t *prod_tbl, mln_u32_t nr_prod, mln_string_t *env, const char *path);\
 SCOPE mln_factor_t *PREFIX_NAME##_factor_init(void *data, \
                                               enum factor_data_type data_type, \
                                               int token_type, \
@@ -294,7 +322,17 @@ SCOPE mln_pg_shift_tbl_t *PREFIX_NAME##_build_shift_tbl(struct mln_pg_calc_info_
     }\
     stbl->nr_state = pci->id_counter;\
     stbl->type_val = attr->terminal_type_val;\
+    stbl->nr_col = attr->type_val + 1;\
+    stbl->map = NULL;\
+    stbl->map_size = 0;\
 \
+    /* one dense block: row s is flat + s * nr_col, lookups are pure arithmetic */\
+    stbl->flat = (mln_shift_t *)calloc((mln_size_t)stbl->nr_state * stbl->nr_col, sizeof(mln_shift_t));\
+    if (stbl->flat == NULL) {\
+        mln_log(error, "No memory.\n");\
+        free(stbl);\
+        return NULL;\
+    }\
     stbl->tbl = (mln_shift_t **)calloc(stbl->nr_state, sizeof(mln_shift_t *));\
     if (stbl->tbl == NULL) {\
         mln_log(error, "No memory.\n");\
@@ -308,12 +346,7 @@ SCOPE mln_pg_shift_tbl_t *PREFIX_NAME##_build_shift_tbl(struct mln_pg_calc_info_
     int index, type, failed = 0;\
     struct PREFIX_NAME##_reduce_info info;\
     for (s = pci->head; s != NULL; s = s->next) {\
-        stbl->tbl[s->id] = (mln_shift_t *)calloc(attr->type_val+1, sizeof(mln_shift_t));\
-        if (stbl->tbl[s->id] == NULL) {\
-            mln_log(error, "No memory.\n");\
-            PREFIX_NAME##_pg_data_free((void *)stbl);\
-            return NULL;\
-        }\
+        stbl->tbl[s->id] = stbl->flat + (mln_size_t)s->id * stbl->nr_col;\
         sh = stbl->tbl[s->id];\
         for (it = s->head; it != NULL; it = it->next) {\
             if (it->pos == it->rule->nr_right) {\
@@ -362,14 +395,14 @@ SCOPE void PREFIX_NAME##_pg_data_free(void *pg_data)\
 {\
     mln_pg_shift_tbl_t *tbl = (mln_pg_shift_tbl_t *)pg_data;\
     if (tbl == NULL) return ;\
-    if (tbl->tbl != NULL) {\
-        mln_sauto_t i;\
-        for (i = 0; i < tbl->nr_state; ++i) {\
-            if (tbl->tbl[i] != NULL)\
-                free(tbl->tbl[i]);\
-        }\
-        free(tbl->tbl);\
+    if (tbl->map != NULL) {\
+        mln_pg_shift_tbl_cache_free(tbl);\
+        return;\
     }\
+    if (tbl->flat != NULL)\
+        free(tbl->flat);\
+    if (tbl->tbl != NULL)\
+        free(tbl->tbl);\
     free(tbl);\
 }\
 \
@@ -695,6 +728,18 @@ SCOPE void *PREFIX_NAME##_parser_generate(mln_production_t *prod_tbl, mln_u32_t
     return (void *)shift_tbl;\
 }\
 \
+M_PG_UNUSED SCOPE void *PREFIX_NAME##_parser_generate_cached(mln_production_t *prod_tbl, mln_u32_t nr_prod, mln_string_t *env, const char *path)\
+{\
+    mln_u64_t hash = mln_pg_grammar_hash(prod_tbl, nr_prod);\
+    mln_pg_shift_tbl_t *tbl;\
+    if ((tbl = mln_pg_shift_tbl_load(hash, path)) != NULL)\
+        return (void *)tbl;\
+    tbl = (mln_pg_shift_tbl_t *)PREFIX_NAME##_parser_generate(prod_tbl, nr_prod, env);\
+    if (tbl != NULL)\
+        (void)mln_pg_shift_tbl_dump(tbl, hash, path);/*best effort*/\
+    return (void *)tbl;\
+}\
+\
 SCOPE mln_factor_t *PREFIX_NAME##_factor_init(void *data, \
                                               enum factor_data_type data_type, \
                                               int token_type, \
@@ -763,9 +808,19 @@ SCOPE void *PREFIX_NAME##_factor_copy(void *ptr, void *data)\
     return (void *)dest;\
 }\
 \
+static __thread mln_parser_t *PREFIX_NAME##_parser_pool = NULL;\
+\
 SCOPE mln_parser_t *PREFIX_NAME##_parser_init(void)\
 {\
-    mln_parser_t *p = (mln_parser_t *)malloc(sizeof(mln_parser_t));\
+    mln_parser_t *p;\
+    if ((p = PREFIX_NAME##_parser_pool) != NULL) {/*parked drained, states just need a reset*/\
+        PREFIX_NAME##_parser_pool = NULL;\
+        p->cur_state = p->cur_reduce = 0;\
+        p->old_state = p->old_reduce = 0;\
+        p->err_state = p->err_reduce = 0;\
+        return p;\
+    }\
+    p = (mln_parser_t *)malloc(sizeof(mln_parser_t));\
     if (p == NULL) return NULL;\
     struct mln_stack_attr sattr;\
     sattr.free_handler = PREFIX_NAME##_factor_destroy;\
@@ -811,6 +866,46 @@ err1:\
 SCOPE void PREFIX_NAME##_parser_destroy(mln_parser_t *p)\
 {\
     if (p == NULL) return;\
+    if (PREFIX_NAME##_parser_pool == NULL) {\
+        /*\
+         * Park the parser for the next parse on this thread: drain\
+         * everything but keep the stacks (and their segment free\
+         * lists) and the lookahead queue alive, so a parse-heavy\
+         * loop pays no per-parse setup.\
+         */\
+        void *d;\
+        while ((d = mln_stack_pop(p->cur_stack)) != NULL)\
+            PREFIX_NAME##_factor_destroy(d);\
+        while ((d = mln_stack_pop(p->old_stack)) != NULL)\
+            PREFIX_NAME##_factor_destroy(d);\
+        while (!mln_queue_empty(p->cur_queue)) {\
+            d = mln_queue_get(p->cur_queue);\
+            mln_queue_remove(p->cur_queue);\
+            PREFIX_NAME##_factor_destroy(d);\
+        }\
+        if (p->cur_la != NULL) {\
+            PREFIX_NAME##_factor_destroy(p->cur_la);\
+            p->cur_la = NULL;\
+        }\
+        if (p->old_la != NULL) {\
+            PREFIX_NAME##_factor_destroy(p->old_la);\
+            p->old_la = NULL;\
+        }\
+        if (p->err_stack != NULL) {\
+            mln_stack_destroy(p->err_stack);\
+            p->err_stack = NULL;\
+        }\
+        if (p->err_la != NULL) {\
+            PREFIX_NAME##_factor_destroy(p->err_la);\
+            p->err_la = NULL;\
+        }\
+        if (p->err_queue != NULL) {\
+            mln_queue_destroy(p->err_queue);\
+            p->err_queue = NULL;\
+        }\
+        PREFIX_NAME##_parser_pool = p;\
+        return;\
+    }\
     if (p->cur_stack != NULL) \
         mln_stack_destroy(p->cur_stack);\
     if (p->cur_la != NULL) \
@@ -918,7 +1013,7 @@ SCOPE int PREFIX_NAME##_sys_parse(struct mln_sys_parse_attr *spattr)\
         } else {\
             col_index = (*la)->token_type;\
         }\
-        sh = &(spattr->tbl->tbl)[*state][col_index];\
+        sh = spattr->tbl->flat + (mln_size_t)(*state) * spattr->tbl->nr_col + col_index;\
         state_type = sh->type;\
         if (state_type == M_PG_SHIFT) {\
             is_recovered = 0;\
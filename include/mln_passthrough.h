@@ -0,0 +1,63 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#ifndef __MLN_PASSTHROUGH_H
+#define __MLN_PASSTHROUGH_H
+
+#include "mln_event.h"
+#include "mln_connection.h"
+
+/*
+ * One-directional zero-copy pump between two TCP connections, for proxy
+ * body forwarding. Buffers arriving on 'src''s receive chain are moved
+ * onto 'dst''s send chain by relinking the chain descriptors -- the
+ * payload is never copied -- and on Linux, when both ends accept it,
+ * bytes are moved entirely in the kernel through a pipe with splice(2),
+ * never surfacing in userspace at all. The pump owns both sockets'
+ * event registrations while it runs: when 'dst' cannot drain, reading
+ * from 'src' is suspended until the backlog is flushed, so a slow
+ * client throttles the upstream instead of buffering its body.
+ *
+ * A pump moves one direction; a full proxy runs one per direction.
+ * Both connections (and any bytes already sitting on 'src''s receive
+ * chain, which are forwarded first) stay owned by the caller and must
+ * outlive the pump.
+ */
+
+typedef struct mln_passthrough_s mln_passthrough_t;
+/*
+ * Called once when the pump stops: 'reason' is M_C_CLOSED after 'src'
+ * hit EOF and every byte was flushed to 'dst', M_C_ERROR on a socket
+ * failure. Both sockets' registrations are already cleared; the
+ * callback usually tears down the connections and frees the pump.
+ */
+typedef void (*mln_passthrough_done_t)(mln_passthrough_t *pt, int reason);
+
+struct mln_passthrough_s {
+    mln_event_t              *ev;
+    mln_tcp_conn_t           *src;
+    mln_tcp_conn_t           *dst;
+    mln_passthrough_done_t    done;
+    void                     *data;
+    mln_u64_t                 forwarded; /*total payload bytes moved*/
+    mln_size_t                piped;     /*bytes parked in the kernel pipe*/
+    int                       pipefds[2];/*{-1,-1} -- splice path unavailable*/
+    mln_u32_t                 eof:1;
+    mln_u32_t                 paused:1;  /*src reads suspended by backpressure*/
+    mln_u32_t                 finished:1;
+};
+
+#define mln_passthrough_data_get(pt)      ((pt)->data)
+#define mln_passthrough_forwarded_get(pt) ((pt)->forwarded)
+
+extern mln_passthrough_t *
+mln_passthrough_new(mln_event_t *ev, \
+                    mln_tcp_conn_t *src, \
+                    mln_tcp_conn_t *dst, \
+                    mln_passthrough_done_t done, \
+                    void *data) __NONNULL3(1,2,3);
+extern void mln_passthrough_free(mln_passthrough_t *pt);
+
+#endif
+
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#ifndef __MLN_PERF_H
+#define __MLN_PERF_H
+
+#include "mln_types.h"
+#include "mln_string.h"
+
+/*
+ * Hardware performance-counter sections.
+ *
+ * Each instrumented thread owns one perf_event_open() counter group
+ * (cycles as leader, instructions, cache misses, branch misses) read
+ * as a whole with PERF_FORMAT_GROUP, so a section boundary costs one
+ * read() system call. mln_perf_begin()/mln_perf_end() attribute the
+ * counter deltas between them to a named section registered with
+ * mln_perf_section_register(); per-section totals accumulate in the
+ * owning thread and mln_perf_stat() sums them across threads at query
+ * time, so sections on the hot path never touch a lock. When a trace
+ * point base is set, every mln_perf_end() also emits the four deltas
+ * through mln_trace_fast() at point base+section, riding the same
+ * ring-buffer pipeline as the other fast trace points. On kernels or
+ * platforms where the counters cannot be opened (perf_event_paranoid,
+ * containers, non-Linux), sections degrade to no-ops and mln_perf_stat()
+ * reports zeros; callers need no fallback of their own.
+ */
+
+#define M_PERF_MAX_SECTION 64
+
+typedef struct {
+    mln_u64_t calls;
+    mln_u64_t cycles;
+    mln_u64_t instructions;
+    mln_u64_t cache_misses;
+    mln_u64_t branch_misses;
+} mln_perf_stat_t;
+
+extern mln_u32_t mln_perf_on;
+
+/*
+ * Section boundaries check the global switch inline so that code
+ * instrumented with sections pays one predictable branch while the
+ * module is off. Sections of different ids may nest; a section must
+ * end on the thread that began it.
+ */
+#define mln_perf_begin(sid) \
+    do {\
+        if (mln_perf_on) mln_perf_section_begin(sid);\
+    } while (0)
+#define mln_perf_end(sid) \
+    do {\
+        if (mln_perf_on) mln_perf_section_end(sid);\
+    } while (0)
+
+extern int mln_perf_init(void);
+extern void mln_perf_finalize(void);
+/*
+ * Map 'name' to a section id, registering it on first use.
+ * Return the id, or -1 when the section table is full.
+ */
+extern int mln_perf_section_register(char *name) __NONNULL1(1);
+extern mln_string_t *mln_perf_section_name(int sid);
+extern void mln_perf_section_begin(int sid);
+extern void mln_perf_section_end(int sid);
+/*
+ * Sum the totals of section 'sid' over every thread that ran it.
+ * Return 0, or -1 when 'sid' was never registered.
+ */
+extern int mln_perf_stat(int sid, mln_perf_stat_t *st) __NONNULL1(2);
+/*
+ * Emit counter deltas as fast trace records at point 'base'+section;
+ * 0 (the default) turns the emission off.
+ */
+extern void mln_perf_trace_base_set(mln_u32_t base);
+
+#endif
@@ -13,6 +13,15 @@
 typedef void (*queue_free)(void *);
 typedef int (*queue_iterate_handler)(void *, void *);
 
+/*
+ * MPMC ring cell: the sequence number tells producers and consumers
+ * whose turn a slot is (Vyukov bounded queue).
+ */
+typedef struct {
+    volatile mln_u64_t     seq;
+    void                  *data;
+} mln_queue_cell_t;
+
 typedef struct {
     void                 **head;
     void                 **tail;
@@ -20,6 +29,12 @@ typedef struct {
     mln_uauto_t            qlen;
     mln_uauto_t            nr_element;
     queue_free             free_handler;
+    /*MPMC mode only; the positions sit on their own cache lines*/
+    mln_queue_cell_t      *cells;
+    mln_u8_t               pad1[64];
+    volatile mln_u64_t     enq_pos;
+    mln_u8_t               pad2[64];
+    volatile mln_u64_t     deq_pos;
 } mln_queue_t;
 
 struct mln_queue_attr {
@@ -42,5 +57,21 @@ extern void *mln_queue_search(mln_queue_t *q, mln_uauto_t index) __NONNULL1(1);
 extern void mln_queue_free_index(mln_queue_t *q, mln_uauto_t index) __NONNULL1(1);
 extern int mln_queue_iterate(mln_queue_t *q, queue_iterate_handler handler, void *udata) __NONNULL1(1);
 
+/*
+ * Lock-free MPMC mode. A queue from mln_queue_mpmc_init() (qlen rounded
+ * up to a power of two) may be pushed and popped concurrently from any
+ * number of threads without external locking; the other entry points
+ * and the empty/full/element macros do not apply to it. Push returns
+ * -1 when the ring is full, pop returns -1 when it is empty; the batch
+ * variants return how many elements were moved, stopping early at a
+ * full/empty ring. mln_queue_mpmc_element() is a racy snapshot.
+ */
+#define mln_queue_mpmc_element(q) ((mln_uauto_t)((q)->enq_pos - (q)->deq_pos))
+extern mln_queue_t *mln_queue_mpmc_init(struct mln_queue_attr *attr) __NONNULL1(1);
+extern int mln_queue_push_mpmc(mln_queue_t *q, void *data) __NONNULL1(1);
+extern int mln_queue_pop_mpmc(mln_queue_t *q, void **data) __NONNULL2(1,2);
+extern mln_uauto_t mln_queue_push_mpmc_batch(mln_queue_t *q, void **data, mln_uauto_t n) __NONNULL2(1,2);
+extern mln_uauto_t mln_queue_pop_mpmc_batch(mln_queue_t *q, void **data, mln_uauto_t n) __NONNULL2(1,2);
+
 #endif
 
@@ -43,6 +43,13 @@ struct mln_rbtree_node_s {
     mln_u32_t                  color:31;
 };
 
+/*
+ * Freed nodes are cached on 'free_head' (linked through 'next', at most
+ * M_RBTREE_CACHE_MAX of them) and handed back by mln_rbtree_node_new,
+ * so high-churn trees stop round-tripping through the allocator.
+ */
+#define M_RBTREE_CACHE_MAX 1024
+
 typedef struct rbtree_s {
     void                      *pool;
     rbtree_pool_alloc_handler  pool_alloc;
@@ -55,6 +62,8 @@ typedef struct rbtree_s {
     mln_rbtree_node_t         *head;
     mln_rbtree_node_t         *tail;
     mln_rbtree_node_t         *iter;
+    mln_rbtree_node_t         *free_head;
+    mln_uauto_t                free_count;
     mln_uauto_t                nr_node;
     mln_u32_t                  del:1;
 } mln_rbtree_t;
@@ -201,7 +210,11 @@ rbtree_insert_fixup(mln_rbtree_t *t, mln_rbtree_node_t *n)
     if ((n)->data != NULL && f != NULL)\
         f((n)->data);\
     if (!(n)->nofree) {\
-        if ((t)->pool != NULL) (t)->pool_free((n));\
+        if ((t)->free_count < M_RBTREE_CACHE_MAX) {\
+            (n)->next = (t)->free_head;\
+            (t)->free_head = (n);\
+            ++((t)->free_count);\
+        } else if ((t)->pool != NULL) (t)->pool_free((n));\
         else free((n));\
     }\
 })
@@ -223,6 +236,11 @@ rbtree_insert_fixup(mln_rbtree_t *t, mln_rbtree_node_t *n)
             mln_rbtree_chain_del(&((t)->head), &((t)->tail), fr);\
             mln_rbtree_inline_node_free((t), fr, (freer));\
         }\
+        while ((fr = (t)->free_head) != NULL) {\
+            (t)->free_head = fr->next;\
+            if ((t)->pool != NULL) (t)->pool_free(fr);\
+            else free(fr);\
+        }\
         if ((t)->pool != NULL) (t)->pool_free((t));\
         else free((t));\
     }\
@@ -268,5 +286,303 @@ extern mln_rbtree_node_t *mln_rbtree_node_new(mln_rbtree_t *t, void *data) __NON
 extern void mln_rbtree_node_free(mln_rbtree_t *t, mln_rbtree_node_t *n) __NONNULL2(1,2);
 
 extern int mln_rbtree_iterate(mln_rbtree_t *t, rbtree_iterate_handler handler, void *udata) __NONNULL2(1,2);
+/*
+ * mln_rbtree_bulk_load():
+ * Builds a perfectly balanced tree from 'datas' in O(n) without any
+ * rebalancing. The array must be sorted ascending by the tree's cmp and
+ * the tree must be empty. On failure -1 is returned and the tree is left
+ * empty; already-created nodes are released without invoking data_free.
+ * mln_rbtree_range_iterate():
+ * Invokes 'handler' on every node whose data lies in [low, high],
+ * descending once to the first node and then stepping by successor.
+ * The handler may delete the node passed to it, but no other node.
+ */
+extern int mln_rbtree_bulk_load(mln_rbtree_t *t, void **datas, mln_uauto_t n) __NONNULL2(1,2);
+extern int
+mln_rbtree_range_iterate(mln_rbtree_t *t, void *low, void *high, rbtree_iterate_handler handler, void *udata) __NONNULL2(1,4);
+
+/*
+ * Type-specialized intrusive variant.
+ *
+ * The generic tree above pays an indirect call per comparison and keeps
+ * every node in its own allocation pointing at the user's data. For the
+ * hottest trees both costs matter, so MLN_RBTREE_DEFINE() generates a
+ * tree whose nodes are embedded in the user's own structs and whose
+ * comparison expands inline at every call site, in the manner of BSD's
+ * <sys/tree.h>.
+ *
+ * Declare the embedded links in the user struct (the struct's typedef
+ * must be forward-declared first, as this header does for its own
+ * types):
+ *
+ *     typedef struct mln_foo_s mln_foo_t;
+ *     struct mln_foo_s {
+ *         mln_u64_t               key;
+ *         MLN_RBTREE_NODE(mln_foo_t) rbnode;
+ *     };
+ *
+ * then instantiate the tree once per translation unit (or in a shared
+ * header) with the entry member name and an inline-expandable
+ * comparison over two user structs:
+ *
+ *     MLN_RBTREE_DEFINE(foo, mln_foo_t, rbnode, mln_foo_cmp);
+ *
+ * which generates (all static inline):
+ *
+ *     mln_rbtree_foo_t;
+ *     void       mln_rbtree_foo_init(mln_rbtree_foo_t *t);
+ *     void       mln_rbtree_foo_insert(mln_rbtree_foo_t *t, mln_foo_t *n);
+ *     mln_foo_t *mln_rbtree_foo_search(mln_rbtree_foo_t *t, mln_foo_t *key);
+ *     void       mln_rbtree_foo_remove(mln_rbtree_foo_t *t, mln_foo_t *n);
+ *     mln_foo_t *mln_rbtree_foo_min(mln_rbtree_foo_t *t);
+ *     mln_foo_t *mln_rbtree_foo_next(mln_foo_t *n);
+ *
+ * The caller owns node storage entirely: nothing is allocated or freed
+ * here, and a struct removed from the tree may be reinserted or
+ * released at the caller's discretion. search() takes a struct holding
+ * only the key fields the comparison reads. next() steps in key order
+ * for iteration from min(). The generic API is untouched; specialize a
+ * tree only where a profile shows the comparison or node dereference
+ * dominating.
+ */
+#define MLN_RBTREE_NODE(type) \
+    struct {\
+        type      *parent;\
+        type      *left;\
+        type      *right;\
+        mln_u32_t  color;\
+    }
+
+#define MLN_RBTREE_DEFINE(name, type, field, cmp) \
+typedef struct {\
+    type        *root;\
+    mln_uauto_t  nr_node;\
+} mln_rbtree_##name##_t;\
+\
+static inline void mln_rbtree_##name##_init(mln_rbtree_##name##_t *t)\
+{\
+    t->root = NULL;\
+    t->nr_node = 0;\
+}\
+\
+static inline void mln_rbtree_##name##_left_rotate(mln_rbtree_##name##_t *t, type *n)\
+{\
+    type *tmp = n->field.right;\
+    if ((n->field.right = tmp->field.left) != NULL)\
+        tmp->field.left->field.parent = n;\
+    if ((tmp->field.parent = n->field.parent) == NULL) t->root = tmp;\
+    else if (n == n->field.parent->field.left) n->field.parent->field.left = tmp;\
+    else n->field.parent->field.right = tmp;\
+    tmp->field.left = n;\
+    n->field.parent = tmp;\
+}\
+\
+static inline void mln_rbtree_##name##_right_rotate(mln_rbtree_##name##_t *t, type *n)\
+{\
+    type *tmp = n->field.left;\
+    if ((n->field.left = tmp->field.right) != NULL)\
+        tmp->field.right->field.parent = n;\
+    if ((tmp->field.parent = n->field.parent) == NULL) t->root = tmp;\
+    else if (n == n->field.parent->field.right) n->field.parent->field.right = tmp;\
+    else n->field.parent->field.left = tmp;\
+    tmp->field.right = n;\
+    n->field.parent = tmp;\
+}\
+\
+static inline void mln_rbtree_##name##_insert(mln_rbtree_##name##_t *t, type *n)\
+{\
+    type *y = NULL, *x = t->root, *g, *u;\
+    while (x != NULL) {\
+        y = x;\
+        if (cmp(n, x) < 0) x = x->field.left;\
+        else x = x->field.right;\
+    }\
+    n->field.parent = y;\
+    if (y == NULL) t->root = n;\
+    else if (cmp(n, y) < 0) y->field.left = n;\
+    else y->field.right = n;\
+    n->field.left = n->field.right = NULL;\
+    n->field.color = M_RB_RED;\
+    while ((y = n->field.parent) != NULL && y->field.color == M_RB_RED) {\
+        g = y->field.parent;\
+        if (y == g->field.left) {\
+            u = g->field.right;\
+            if (u != NULL && u->field.color == M_RB_RED) {\
+                y->field.color = M_RB_BLACK;\
+                u->field.color = M_RB_BLACK;\
+                g->field.color = M_RB_RED;\
+                n = g;\
+                continue;\
+            } else if (n == y->field.right) {\
+                n = y;\
+                mln_rbtree_##name##_left_rotate(t, n);\
+                y = n->field.parent;\
+            }\
+            y->field.color = M_RB_BLACK;\
+            g->field.color = M_RB_RED;\
+            mln_rbtree_##name##_right_rotate(t, g);\
+        } else {\
+            u = g->field.left;\
+            if (u != NULL && u->field.color == M_RB_RED) {\
+                y->field.color = M_RB_BLACK;\
+                u->field.color = M_RB_BLACK;\
+                g->field.color = M_RB_RED;\
+                n = g;\
+                continue;\
+            } else if (n == y->field.left) {\
+                n = y;\
+                mln_rbtree_##name##_right_rotate(t, n);\
+                y = n->field.parent;\
+            }\
+            y->field.color = M_RB_BLACK;\
+            g->field.color = M_RB_RED;\
+            mln_rbtree_##name##_left_rotate(t, g);\
+        }\
+    }\
+    t->root->field.color = M_RB_BLACK;\
+    ++(t->nr_node);\
+}\
+\
+static inline type *mln_rbtree_##name##_search(mln_rbtree_##name##_t *t, type *key)\
+{\
+    type *x = t->root;\
+    int ret;\
+    while (x != NULL && (ret = cmp(key, x)) != 0) {\
+        if (ret < 0) x = x->field.left;\
+        else x = x->field.right;\
+    }\
+    return x;\
+}\
+\
+static inline type *mln_rbtree_##name##_min(mln_rbtree_##name##_t *t)\
+{\
+    type *x = t->root;\
+    if (x == NULL) return NULL;\
+    while (x->field.left != NULL) x = x->field.left;\
+    return x;\
+}\
+\
+static inline type *mln_rbtree_##name##_next(type *n)\
+{\
+    type *p;\
+    if (n->field.right != NULL) {\
+        n = n->field.right;\
+        while (n->field.left != NULL) n = n->field.left;\
+        return n;\
+    }\
+    p = n->field.parent;\
+    while (p != NULL && n == p->field.right) {\
+        n = p;\
+        p = p->field.parent;\
+    }\
+    return p;\
+}\
+\
+static inline void mln_rbtree_##name##_transplant(mln_rbtree_##name##_t *t, type *u, type *v)\
+{\
+    if (u->field.parent == NULL) t->root = v;\
+    else if (u == u->field.parent->field.left) u->field.parent->field.left = v;\
+    else u->field.parent->field.right = v;\
+    if (v != NULL) v->field.parent = u->field.parent;\
+}\
+\
+static inline void mln_rbtree_##name##_remove_fixup(mln_rbtree_##name##_t *t, type *x, type *xp)\
+{\
+    type *w;\
+    while (x != t->root && (x == NULL || x->field.color == M_RB_BLACK)) {\
+        if (x == xp->field.left) {\
+            w = xp->field.right;\
+            if (w->field.color == M_RB_RED) {\
+                w->field.color = M_RB_BLACK;\
+                xp->field.color = M_RB_RED;\
+                mln_rbtree_##name##_left_rotate(t, xp);\
+                w = xp->field.right;\
+            }\
+            if ((w->field.left == NULL || w->field.left->field.color == M_RB_BLACK) && \
+                (w->field.right == NULL || w->field.right->field.color == M_RB_BLACK))\
+            {\
+                w->field.color = M_RB_RED;\
+                x = xp;\
+                xp = x->field.parent;\
+                continue;\
+            } else if (w->field.right == NULL || w->field.right->field.color == M_RB_BLACK) {\
+                if (w->field.left != NULL) w->field.left->field.color = M_RB_BLACK;\
+                w->field.color = M_RB_RED;\
+                mln_rbtree_##name##_right_rotate(t, w);\
+                w = xp->field.right;\
+            }\
+            w->field.color = xp->field.color;\
+            xp->field.color = M_RB_BLACK;\
+            if (w->field.right != NULL) w->field.right->field.color = M_RB_BLACK;\
+            mln_rbtree_##name##_left_rotate(t, xp);\
+            x = t->root;\
+        } else {\
+            w = xp->field.left;\
+            if (w->field.color == M_RB_RED) {\
+                w->field.color = M_RB_BLACK;\
+                xp->field.color = M_RB_RED;\
+                mln_rbtree_##name##_right_rotate(t, xp);\
+                w = xp->field.left;\
+            }\
+            if ((w->field.right == NULL || w->field.right->field.color == M_RB_BLACK) && \
+                (w->field.left == NULL || w->field.left->field.color == M_RB_BLACK))\
+            {\
+                w->field.color = M_RB_RED;\
+                x = xp;\
+                xp = x->field.parent;\
+                continue;\
+            } else if (w->field.left == NULL || w->field.left->field.color == M_RB_BLACK) {\
+                if (w->field.right != NULL) w->field.right->field.color = M_RB_BLACK;\
+                w->field.color = M_RB_RED;\
+                mln_rbtree_##name##_left_rotate(t, w);\
+                w = xp->field.left;\
+            }\
+            w->field.color = xp->field.color;\
+            xp->field.color = M_RB_BLACK;\
+            if (w->field.left != NULL) w->field.left->field.color = M_RB_BLACK;\
+            mln_rbtree_##name##_right_rotate(t, xp);\
+            x = t->root;\
+        }\
+    }\
+    if (x != NULL) x->field.color = M_RB_BLACK;\
+}\
+\
+static inline void mln_rbtree_##name##_remove(mln_rbtree_##name##_t *t, type *n)\
+{\
+    type *x, *xp, *y = n;\
+    mln_u32_t y_original_color = y->field.color;\
+    if (n->field.left == NULL) {\
+        x = n->field.right;\
+        xp = n->field.parent;\
+        mln_rbtree_##name##_transplant(t, n, n->field.right);\
+    } else if (n->field.right == NULL) {\
+        x = n->field.left;\
+        xp = n->field.parent;\
+        mln_rbtree_##name##_transplant(t, n, n->field.left);\
+    } else {\
+        y = n->field.right;\
+        while (y->field.left != NULL) y = y->field.left;\
+        y_original_color = y->field.color;\
+        x = y->field.right;\
+        if (y->field.parent == n) {\
+            xp = y;\
+        } else {\
+            xp = y->field.parent;\
+            mln_rbtree_##name##_transplant(t, y, y->field.right);\
+            y->field.right = n->field.right;\
+            y->field.right->field.parent = y;\
+        }\
+        mln_rbtree_##name##_transplant(t, n, y);\
+        y->field.left = n->field.left;\
+        y->field.left->field.parent = y;\
+        y->field.color = n->field.color;\
+    }\
+    if (y_original_color == M_RB_BLACK) mln_rbtree_##name##_remove_fixup(t, x, xp);\
+    n->field.parent = n->field.left = n->field.right = NULL;\
+    --(t->nr_node);\
+}
+
+#define mln_rbtree_inline_node_num(ptree)     ((ptree)->nr_node)
+#define mln_rbtree_inline_empty(ptree)        ((ptree)->root == NULL)
 #endif
 
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#ifndef __MLN_RCU_H
+#define __MLN_RCU_H
+
+#include "mln_types.h"
+#include "mln_alloc.h"
+
+/*
+ * Read-mostly data publication across mln_fork workers.
+ *
+ * A publication handle lives in an mln_alloc shm pool created before
+ * fork, so every worker maps it at the same address. Writers build a
+ * complete new version of the shared structure in the same pool and
+ * swap it in with mln_rcu_publish(); readers pick the current version
+ * up lock-free inside a read section. No worker keeps a private copy
+ * and no update ever blocks a reader.
+ *
+ * Reclamation is epoch-based: publish retires the displaced version
+ * stamped with the global epoch and advances the epoch, and a retired
+ * version is freed only once every registered reader has either left
+ * its read section or entered one under a later epoch. The read-side
+ * cost is one load of the epoch, one store into the reader's own slot,
+ * a full barrier, and the load-acquire of the version pointer -- no
+ * lock, no shared-line read-modify-write. Read sections must be short
+ * and may not nest on one reader handle; a version pointer obtained in
+ * a section is valid only until the matching unlock.
+ *
+ * Writers serialize on an internal spin lock, so concurrent publishers
+ * are safe. The retire ring holds M_RCU_RETIRE_MAX displaced versions;
+ * with updates several orders of magnitude rarer than reads it never
+ * fills, and should it fill, publish reclaims in place until a slot
+ * opens. A worker that may read must register once after fork; a
+ * worker that exits mid-section strands retired versions, so read
+ * sections must not span blocking calls.
+ */
+
+#define M_RCU_READER_MAX 128
+#define M_RCU_RETIRE_MAX 64
+
+typedef struct mln_rcu_s        mln_rcu_t;
+typedef struct mln_rcu_reader_s mln_rcu_reader_t;
+typedef void (*mln_rcu_free_handler)(void *);
+
+struct mln_rcu_reader_s {
+    mln_u64_t                    epoch; /*0 -- quiescent*/
+    mln_u32_t                    in_use;
+};
+
+/*
+ * Create a publication handle in 'pool' (an shm pool, before fork).
+ * 'free_handler' releases a version no reader can see any longer; NULL
+ * means mln_alloc_free(). Return NULL on allocation failure.
+ */
+extern mln_rcu_t *mln_rcu_new(mln_alloc_t *pool, mln_rcu_free_handler free_handler) __NONNULL1(1);
+/*
+ * Release the handle and every version it still tracks, current one
+ * included. Only valid once no worker reads or publishes any more.
+ */
+extern void mln_rcu_free(mln_rcu_t *rcu);
+/*
+ * Claim a reader slot; call once per reading process (or thread) after
+ * fork and keep the handle. Return NULL when all M_RCU_READER_MAX
+ * slots are taken.
+ */
+extern mln_rcu_reader_t *mln_rcu_reader_register(mln_rcu_t *rcu) __NONNULL1(1);
+extern void mln_rcu_reader_unregister(mln_rcu_reader_t *reader);
+/*
+ * Enter a read section and return the current version (NULL before the
+ * first publish). The version stays valid until mln_rcu_read_unlock().
+ */
+extern void *mln_rcu_read_lock(mln_rcu_t *rcu, mln_rcu_reader_t *reader) __NONNULL2(1,2) __HOT__;
+extern void mln_rcu_read_unlock(mln_rcu_reader_t *reader) __NONNULL1(1) __HOT__;
+/*
+ * Swap 'version' (built complete in the shm pool) in as the current
+ * one, retire the displaced version and reclaim whatever no reader can
+ * still hold.
+ */
+extern void mln_rcu_publish(mln_rcu_t *rcu, void *version) __NONNULL1(1);
+/*
+ * Unprotected peek at the current version, for writers that want to
+ * copy-modify it while holding no read section of their own. The
+ * caller must guarantee it stays alive by other means (e.g. being the
+ * only publisher).
+ */
+extern void *mln_rcu_current(mln_rcu_t *rcu) __NONNULL1(1);
+
+#endif
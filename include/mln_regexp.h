@@ -7,6 +7,7 @@
 #define __MLN_REGEXP_H
 
 #include "mln_string.h"
+#include "mln_alloc.h"
 
 #define M_REGEXP_MASK_SQUARE  ((unsigned int)0x00800000)
 #define M_REGEXP_MASK_OR      ((unsigned int)0x01000000)
@@ -39,9 +40,60 @@ typedef struct mln_reg_match_s {
     struct mln_reg_match_s *next;
 } mln_reg_match_t;
 
+typedef struct {
+    mln_alloc_t            *pool;    /*NULL when heap-allocated*/
+    mln_string_t           *exp;     /*pattern copy for the backtracking path*/
+    mln_u16_t              *trans;   /*DFA transitions, nstates*256, NULL if
+                                       the pattern is outside the DFA subset*/
+    mln_u8ptr_t             accepts; /*per-state accept flags*/
+    mln_u8ptr_t             literal; /*required literal bytes, NULL if none*/
+    mln_u32_t               litlen;
+    mln_u32_t               nstates;
+} mln_reg_t;
+
 extern int mln_reg_match(mln_string_t *exp, mln_string_t *text, mln_reg_match_t **head, mln_reg_match_t **tail);
 extern int mln_reg_equal(mln_string_t *exp, mln_string_t *text);
 extern void mln_reg_match_result_free(mln_reg_match_t *results);
+/*
+ * Compiles 'exp' once for reuse across calls. Patterns made of
+ * literals, '.', '\d', '\D', '\a', character classes and the '*',
+ * '+', '?' quantifiers are turned into a DFA; anything else (groups,
+ * alternation, repetition braces) keeps the backtracking matcher.
+ * A literal substring the pattern requires is extracted as well and
+ * used as a memchr() prefilter, so inputs that cannot match are
+ * rejected without running the automaton or the backtracker.
+ */
+extern mln_reg_t *mln_reg_compile(mln_string_t *exp);
+/*same, but every allocation comes from 'pool' so the compiled
+  pattern can be shared across a worker and torn down with it*/
+extern mln_reg_t *mln_reg_pool_compile(mln_alloc_t *pool, mln_string_t *exp);
+extern void mln_reg_free(mln_reg_t *reg);
+extern int mln_reg_compiled_equal(mln_reg_t *reg, mln_string_t *text);
+/*capture collection always goes through the backtracking matcher*/
+extern int mln_reg_compiled_match(mln_reg_t *reg, mln_string_t *text, mln_reg_match_t **head, mln_reg_match_t **tail);
+
+typedef struct {
+    mln_reg_t             **regs;
+    mln_u32_t              *order;     /*pattern indices grouped by literal first byte*/
+    mln_u32_t               heads[257];/*offsets into 'order' per byte value*/
+    mln_size_t              nregs;
+    mln_size_t              cap;
+    mln_u32_t               dirty:1;
+} mln_reg_set_t;
+
+extern mln_reg_set_t *mln_reg_set_new(void);
+extern int mln_reg_set_add(mln_reg_set_t *set, mln_reg_t *reg);
+/*
+ * Evaluates every pattern in the set against 'text' in one shot:
+ * a single scan of the subject locates all required literals, then
+ * only the patterns whose literal was seen (or that have none) run
+ * their automaton or the backtracker. results[i] is set to 1 when
+ * pattern i matches the whole text, 0 otherwise; returns the number
+ * of matching patterns, or -1 on failure.
+ */
+extern int mln_reg_set_equal(mln_reg_set_t *set, mln_string_t *text, mln_u8ptr_t results);
+/*frees the set only; the compiled patterns stay with their owner*/
+extern void mln_reg_set_free(mln_reg_set_t *set);
 
 #endif
 
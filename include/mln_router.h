@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#ifndef __MLN_ROUTER_H
+#define __MLN_ROUTER_H
+
+#include "mln_alloc.h"
+#include "mln_string.h"
+
+/*
+ * URL router. Routes are compiled once into a trie keyed on path
+ * segments, so a lookup costs O(path length) no matter how many routes
+ * are registered. A pattern segment starting with ':' captures that
+ * path segment under the given name; a final segment starting with '*'
+ * captures the whole remainder of the path. Literal segments win over
+ * a parameter at the same node, and the matcher backtracks, so
+ * "/users/me" and "/users/:id" coexist. Matching allocates nothing:
+ * captures are returned as slices of the caller's path buffer.
+ */
+
+typedef struct mln_router_s mln_router_t;
+
+typedef struct {
+    mln_string_t            name;  /*parameter name from the pattern*/
+    mln_string_t            value; /*slice of the matched path*/
+} mln_router_param_t;
+
+extern mln_router_t *mln_router_new(void);
+extern void mln_router_free(mln_router_t *router);
+/*
+ * Register 'data' (typically a handler) under 'path'.
+ * Return -1 on a duplicate route, a conflicting parameter name at the
+ * same position, a misplaced wildcard or allocation failure.
+ */
+extern int mln_router_add(mln_router_t *router, mln_string_t *path, void *data) __NONNULL3(1,2,3);
+/*
+ * Look up 'path'. On a hit the registered data is returned and the
+ * first 'nparams' captures are written into 'params' with the count in
+ * '*matched' (pass NULL/0 when no route captures). A route whose
+ * captures do not fit in 'params' is treated as no match.
+ * Return NULL when nothing matches.
+ */
+extern void *mln_router_match(mln_router_t *router, \
+                              mln_string_t *path, \
+                              mln_router_param_t *params, \
+                              mln_size_t nparams, \
+                              mln_size_t *matched) __NONNULL2(1,2);
+
+#endif
@@ -34,6 +34,13 @@ typedef struct {
         (&((_presult)->data[(index)*((_presult)->len/(_presult)->num)]) )))
 
 extern mln_rs_result_t *mln_rs_encode(uint8_t *data_vector, size_t len, size_t n, size_t k);
+/*
+ * Same as mln_rs_encode() but splits the stripe into column slices
+ * encoded by up to 'nthread' threads (capped at 16); slices are
+ * independent so no locking is involved. Falls back to the single
+ * threaded path for small inputs or nthread <= 1.
+ */
+extern mln_rs_result_t *mln_rs_encode_parallel(uint8_t *data_vector, size_t len, size_t n, size_t k, size_t nthread);
 extern void mln_rs_result_free(mln_rs_result_t *result);
 extern mln_rs_result_t *mln_rs_decode(uint8_t **data_vector, size_t len, size_t n, size_t k);
 extern void mln_rs_matrix_dump(mln_rs_matrix_t *matrix);
@@ -20,7 +20,11 @@ typedef struct {
     mln_bignum_t dp;
     mln_bignum_t dq;
     mln_bignum_t qinv;
+    mln_bignum_t e;/*public exponent, kept for base blinding; zero length disables it*/
+    mln_bignum_t bre;/*cached blinding pair r^e and r^-1, squared on every use*/
+    mln_bignum_t brinv;
     mln_u32_t    pwr:1;
+    mln_u32_t    blind:1;
 } mln_rsa_key_t;
 
 
@@ -55,6 +55,14 @@ extern void mln_sha256_calc(mln_sha256_t *s, mln_u8ptr_t input, mln_uauto_t len,
 extern void mln_sha256_tobytes(mln_sha256_t *s, mln_u8ptr_t buf, mln_u32_t len) __NONNULL1(1);
 extern void mln_sha256_tostring(mln_sha256_t *s, mln_s8ptr_t buf, mln_u32_t len) __NONNULL1(1);
 extern void mln_sha256_dump(mln_sha256_t *s) __NONNULL1(1);
+/*
+ * Hashes 'n' independent buffers to completion in one call. 'ss[i]'
+ * must be initialized contexts; 'inputs[i]'/'lens[i]' is the whole
+ * message of stream i. On hardware with SHA instructions two streams
+ * are interleaved per pass to hide instruction latency, which is
+ * noticeably faster than hashing the buffers one after another.
+ */
+extern void mln_sha256_batch(mln_sha256_t **ss, mln_u8ptr_t *inputs, mln_uauto_t *lens, mln_u32_t n) __NONNULL3(1,2,3);
 
 #endif
 
@@ -12,17 +12,27 @@ typedef void (*stack_free)(void *);
 typedef void *(*stack_copy)(void *, void *);
 typedef int (*stack_iterate_handler)(void *, void *);
 
-typedef struct mln_stack_node_s {
-    void                    *data;
-    struct mln_stack_node_s *prev;
-    struct mln_stack_node_s *next;
-} mln_stack_node_t;
+/*
+ * Elements are stored inline in fixed segments, so push and pop just
+ * bump an index in the common case. A segment emptied by pops is
+ * parked on the free list instead of being released, so a push/pop
+ * cycle sitting on a segment boundary never goes back to the
+ * allocator.
+ */
+#define M_STACK_SEG_NR  64
+
+typedef struct mln_stack_seg_s {
+    struct mln_stack_seg_s  *prev;
+    struct mln_stack_seg_s  *next;
+    void                    *elems[M_STACK_SEG_NR];
+} mln_stack_seg_t;
 
 typedef struct {
-    mln_stack_node_t        *bottom;
-    mln_stack_node_t        *top;
-    mln_stack_node_t        *free_head;
-    mln_stack_node_t        *free_tail;
+    mln_stack_seg_t         *bottom;
+    mln_stack_seg_t         *top;
+    mln_stack_seg_t         *free_head;
+    mln_stack_seg_t         *free_tail;
+    mln_u32_t                top_idx;/*filled slots in 'top', > 0 while the stack is nonempty*/
     mln_uauto_t              nr_node;
     stack_free               free_handler;
     stack_copy               copy_handler;
@@ -35,7 +45,7 @@ struct mln_stack_attr {
 
 
 #define mln_stack_empty(s) (!(s)->nr_node)
-#define mln_stack_top(st) ((st)->top == NULL? NULL: (st)->top->data)
+#define mln_stack_top(st) ((st)->nr_node == 0? NULL: (st)->top->elems[(st)->top_idx - 1])
 extern mln_stack_t *
 mln_stack_init(struct mln_stack_attr *attr) __NONNULL1(1);
 extern void
@@ -13,6 +13,7 @@
 typedef struct {
     mln_u8ptr_t  data;
     mln_u64_t    len;
+    mln_u64_t    hash; /*lazily cached by mln_string_hash(), 0 -- not computed*/
     mln_uauto_t  data_ref:1;
     mln_uauto_t  pool:1;
     mln_uauto_t  ref:30;
@@ -21,11 +22,12 @@ typedef struct {
 /*
  * init & free
  */
-#define mln_string(s) {(mln_u8ptr_t)s, sizeof(s)-1, 1, 0, 1}
+#define mln_string(s) {(mln_u8ptr_t)s, sizeof(s)-1, 0, 1, 0, 1}
 #define mln_string_set(pstring,s) \
     ({\
         (pstring)->data = (mln_u8ptr_t)(s);\
         (pstring)->len = strlen(s);\
+        (pstring)->hash = 0;\
         (pstring)->data_ref = 1;\
         (pstring)->pool = 0;\
         (pstring)->ref = 1;\
@@ -35,11 +37,36 @@ typedef struct {
     ({\
         (pstring)->data = (mln_u8ptr_t)(s);\
         (pstring)->len = (n);\
+        (pstring)->hash = 0;\
         (pstring)->data_ref = 1;\
         (pstring)->pool = 0;\
         (pstring)->ref = 1;\
         (pstring);\
     })
+
+/*
+ * Hash of the string's bytes (FNV-1a 64), computed on first use and
+ * cached in the string, so keys looked up many times pay the scan
+ * once. Strings are treated as immutable after creation; the in-place
+ * mutators (mln_string_upper/mln_string_lower) drop the cache, but
+ * callers rewriting 'data' by hand must clear 'hash' themselves. A
+ * result of 0 is remapped so it never collides with the empty mark.
+ */
+static inline mln_u64_t mln_string_hash(mln_string_t *s)
+{
+    mln_u64_t h = s->hash;
+    if (h == 0) {
+        mln_u8ptr_t p = s->data, end = s->data + s->len;
+        h = 0xcbf29ce484222325ULL;
+        for (; p < end; ++p) {
+            h ^= *p;
+            h *= 0x100000001b3ULL;
+        }
+        if (h == 0) h = 0x9e3779b97f4a7c15ULL;
+        s->hash = h;
+    }
+    return h;
+}
 #define mln_string_ref(pstring) ({\
     mln_string_t *__s = (pstring);\
     ++__s->ref;\
@@ -76,6 +103,35 @@ extern mln_string_t *mln_string_const_ndup(char *str, mln_s32_t size) __NONNULL1
 extern mln_string_t *mln_string_ref_dup(mln_string_t *str) __NONNULL1(1);
 extern mln_string_t *mln_string_const_ref_dup(char *s);
 
+/*
+ * String builder.
+ * Append fragments with mln_string_builder_append(), then
+ * mln_string_builder_finalize() emits one contiguous mln_string_t in a
+ * single allocation and empties the builder. If 'pool' given to
+ * mln_string_builder_init() is NULL, malloc/free are used instead.
+ * mln_string_builder_destroy() drops an unfinished builder; the
+ * builder struct itself is caller-owned.
+ */
+typedef struct mln_string_builder_seg_s {
+    struct mln_string_builder_seg_s *next;
+    mln_size_t                       len;
+    mln_size_t                       size;
+    /*fragment bytes follow the header*/
+} mln_string_builder_seg_t;
+
+typedef struct {
+    mln_alloc_t              *pool;
+    mln_string_builder_seg_t *head;
+    mln_string_builder_seg_t *tail;
+    mln_u64_t                 len;
+} mln_string_builder_t;
+
+extern void mln_string_builder_init(mln_string_builder_t *sb, mln_alloc_t *pool) __NONNULL1(1);
+extern void mln_string_builder_destroy(mln_string_builder_t *sb);
+extern int mln_string_builder_append(mln_string_builder_t *sb, char *s, mln_u64_t len) __NONNULL2(1,2);
+extern int mln_string_builder_append_string(mln_string_builder_t *sb, mln_string_t *s) __NONNULL2(1,2);
+extern mln_string_t *mln_string_builder_finalize(mln_string_builder_t *sb) __NONNULL1(1);
+
 /*
  * tool functions
  */
@@ -88,6 +144,11 @@ extern int mln_string_strcasecmp(mln_string_t *s1, mln_string_t *s2) __NONNULL2(
 extern int mln_string_const_strcasecmp(mln_string_t *s1, char *s2) __NONNULL1(1);
 extern int mln_string_const_strncasecmp(mln_string_t *s1, char *s2, mln_u32_t n) __NONNULL1(1);
 extern int mln_string_strncasecmp(mln_string_t *s1, mln_string_t *s2, mln_u32_t n) __NONNULL2(1,2);
+/*
+ * case-insensitive equality: the length check rejects most candidates
+ * before any byte is touched. Return 1 when equal, 0 otherwise.
+ */
+extern int mln_string_eq_ci(mln_string_t *s1, mln_string_t *s2) __NONNULL2(1,2);
 extern char *mln_string_strstr(mln_string_t *text, mln_string_t *pattern) __NONNULL2(1,2);
 extern char *mln_string_const_strstr(mln_string_t *text, char *pattern) __NONNULL2(1,2);
 /*
@@ -108,6 +169,27 @@ extern char *mln_string_const_kmp(mln_string_t *text, char *pattern) __NONNULL1(
  */
 extern mln_string_t *mln_string_new_kmp(mln_string_t *text, mln_string_t *pattern) __NONNULL2(1,2);
 extern mln_string_t *mln_string_new_const_kmp(mln_string_t *text, char *pattern) __NONNULL2(1,2);
+/*
+ * Multi-pattern matcher (Aho-Corasick automaton).
+ * Build the automaton once with mln_string_ac_new(), then every call to
+ * mln_string_ac_match() scans the text against all patterns in a single
+ * pass. The callback receives the offset of each occurrence and the
+ * index of the matched pattern; returning a negative value stops the
+ * scan and makes mln_string_ac_match() return -1.
+ */
+typedef struct {
+    mln_u32_t  *tbl;   /*nstates x 256 transition table, failure folded in*/
+    mln_u32_t  *fail;
+    mln_u32_t  *olink; /*next suffix state with output, 0 means none*/
+    mln_u32_t  *out;   /*pattern index + 1, 0 means none*/
+    mln_size_t *plen;  /*pattern lengths, for reporting offsets*/
+    mln_u32_t   nstates;
+    mln_size_t  npatterns;
+} mln_string_ac_t;
+typedef int (*mln_string_ac_cb_t)(mln_string_t *text, mln_size_t offset, mln_size_t index, void *udata);
+extern mln_string_ac_t *mln_string_ac_new(mln_string_t *patterns, mln_size_t n) __NONNULL1(1);
+extern void mln_string_ac_free(mln_string_ac_t *ac);
+extern int mln_string_ac_match(mln_string_ac_t *ac, mln_string_t *text, mln_string_ac_cb_t cb, void *udata) __NONNULL3(1,2,3);
 /*
  * mln_string_slice will modify s.
  * So if you want to get avoid this side-effect,
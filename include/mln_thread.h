@@ -63,6 +63,21 @@ typedef struct mln_thread_msgq_s {
     mln_thread_msg_t           msg;
 } mln_thread_msgq_t;
 
+/*
+ * Lock-free SPSC ring carrying one direction of thread messages by
+ * value. The socketpair is only a doorbell: the consumer raises
+ * 'waiting' before parking on its descriptor and the producer kicks it
+ * exactly when that flag is up.
+ */
+typedef struct {
+    mln_u32_t                  size;    /*power of two*/
+    mln_u32_t                  mask;
+    mln_u32_t                  head;    /*written by the consumer only*/
+    mln_u32_t                  tail;    /*written by the producer only*/
+    mln_u32_t                  waiting;
+    mln_thread_msg_t          *slots;
+} mln_thread_ring_t;
+
 struct mln_thread_s {
     mln_event_t               *ev;
     mln_thread_entrance_t      thread_main;
@@ -78,6 +93,8 @@ struct mln_thread_s {
     mln_thread_msgq_t         *local_tail;
     mln_thread_msgq_t         *dest_head;
     mln_thread_msgq_t         *dest_tail;
+    mln_thread_ring_t         *to_main;  /*child -> main loop*/
+    mln_thread_ring_t         *to_child; /*main loop -> child*/
     mln_rbtree_node_t         *node;
 };
 
@@ -99,5 +116,24 @@ extern void mln_thread_exit(int exit_code);
 extern void mln_thread_kill(mln_string_t *alias);
 extern void mln_thread_cleanup_set(void (*tcleanup)(void *), void *data);
 extern void mln_thread_module_set(mln_thread_module_t *modules, mln_size_t num);
+/*
+ * Ring transport. mln_thread_ring_size_set() -- call it before the
+ * threads are loaded; 0 (the default) keeps the classic transport --
+ * gives every subsequently created thread a pair of lock-free SPSC
+ * rings, rounded up to a power of two, and its socketpair is kept only
+ * as a sleep/wake doorbell. Children then exchange messages with
+ * mln_thread_msg_post()/mln_thread_msg_fetch() instead of writing
+ * mln_thread_msg_t records to their socket: post hands one message to
+ * the main loop (0 on success, 1 when the ring is full, -1 when the
+ * ring transport is off), fetch copies one delivered message out (0)
+ * or returns -1 once the ring is drained, swallowing pending doorbell
+ * bytes and raising the doorbell flag so the caller can park on its
+ * descriptor. The main loop drains a whole ring per doorbell and
+ * delivers routed messages into the target's ring in batches, falling
+ * back to a short timer retry while a target ring is full.
+ */
+extern void mln_thread_ring_size_set(mln_u32_t size);
+extern int mln_thread_msg_post(mln_thread_msg_t *msg) __NONNULL1(1);
+extern int mln_thread_msg_fetch(mln_thread_msg_t *msg) __NONNULL1(1);
 #endif
 
@@ -19,14 +19,41 @@ typedef struct mln_thread_pool_s mln_thread_pool_t;
 typedef int  (*mln_thread_process)(void *);
 typedef void (*mln_thread_data_free)(void *);
 
+/*
+ * A future is completed with the child handler's return value once its
+ * task has run. Tasks dropped at pool shutdown complete with -1.
+ */
+typedef struct mln_thread_pool_future_s {
+    pthread_mutex_t                    mutex;
+    pthread_cond_t                     cond;
+    int                                rc;
+    mln_u32_t                          done:1;
+    mln_u32_t                          padding:31;
+} mln_thread_pool_future_t;
+
 typedef struct mln_thread_pool_resource_s {
     void                              *data;
+    mln_thread_pool_future_t          *future;
+    struct mln_thread_pool_resource_s *prev;
     struct mln_thread_pool_resource_s *next;
 } mln_thread_pool_resource_t;
 
+/*
+ * In work-stealing mode every worker owns one deque. The owner takes
+ * resources from the head and idle siblings steal from the tail, so
+ * the pool mutex is off the fast path.
+ */
+typedef struct mln_thread_pool_deque_s {
+    mln_spin_t                         lock;
+    mln_thread_pool_resource_t        *head;
+    mln_thread_pool_resource_t        *tail;
+} mln_thread_pool_deque_t;
+
 typedef struct mln_thread_pool_member_s {
     void                              *data;
+    mln_thread_pool_future_t          *future;
     mln_thread_pool_t                 *pool;
+    mln_thread_pool_deque_t           *deque;/*work-stealing mode only*/
     mln_u32_t                          idle:1;
     mln_u32_t                          locked:1;
     mln_u32_t                          forked:1;
@@ -43,13 +70,22 @@ struct mln_thread_pool_s {
     mln_thread_pool_resource_t        *res_chain_tail;
     mln_thread_pool_member_t          *child_head;
     mln_thread_pool_member_t          *child_tail;
+    mln_thread_pool_deque_t           *deques;
+    mln_u32_t                          n_deques;
+    mln_u32_t                          rr;/*round-robin submission cursor*/
     mln_u32_t                          max;
+    mln_u32_t                          min;
     mln_u32_t                          idle;
     mln_u32_t                          counter;
     mln_u32_t                          quit:1;
-    mln_u32_t                          padding:31;
+    mln_u32_t                          steal:1;
+    mln_u32_t                          padding:30;
     mln_u64_t                          cond_timeout;/*ms*/
+    mln_u64_t                          idle_timeout;/*ms*/
+    mln_u64_t                          spawned;
+    mln_u64_t                          retired;
     mln_size_t                         n_res;
+    mln_size_t                         spawn_threshold;
     mln_thread_process                 process_handler;
     mln_thread_data_free               free_handler;
 };
@@ -60,19 +96,36 @@ struct mln_thread_pool_attr {
     mln_thread_process                 main_process_handler;
     mln_thread_data_free               free_handler;
     mln_u64_t                          cond_timeout; /*ms*/
+    mln_u64_t                          idle_timeout; /*ms a worker must stay workless before it may retire, 0: retire on the first quiet cond_timeout*/
     mln_u32_t                          max;
+    mln_u32_t                          min;          /*workers kept alive through idle periods (started up front), 0: all may retire*/
     mln_u32_t                          concurrency;
+    mln_size_t                         spawn_threshold;/*queued resources that force a spawn even while workers are busy, 0: spawn only when none is idle*/
+    mln_u32_t                          work_stealing;/*nonzero: per-worker deques, all 'max' workers started up front*/
 };
 
 struct mln_thread_pool_info {
     mln_u32_t                          max_num;
+    mln_u32_t                          min_num;
     mln_u32_t                          idle_num;
     mln_u32_t                          cur_num;
     mln_size_t                         res_num;
+    mln_u64_t                          spawned;/*workers created since the pool started*/
+    mln_u64_t                          retired;/*workers that left voluntarily after idling*/
 };
 
 extern int mln_thread_pool_run(struct mln_thread_pool_attr *tpattr) __NONNULL1(1);
 extern int mln_thread_pool_resource_add(void *data) __NONNULL1(1);
+extern int mln_thread_pool_resource_add_future(void *data, mln_thread_pool_future_t *future) __NONNULL2(1,2);
+/*
+ * Enqueue 'n' resources with one lock acquisition and one broadcast.
+ * 'futures' may be NULL, otherwise futures[i] tracks datas[i].
+ */
+extern int mln_thread_pool_resource_batch_add(void **datas, mln_thread_pool_future_t **futures, mln_size_t n) __NONNULL1(1);
+extern mln_thread_pool_future_t *mln_thread_pool_future_new(void);
+extern void mln_thread_pool_future_free(mln_thread_pool_future_t *future);
+extern int mln_thread_pool_future_wait(mln_thread_pool_future_t *future) __NONNULL1(1);
+extern int mln_thread_pool_future_try(mln_thread_pool_future_t *future, int *rc) __NONNULL1(1);
 extern void mln_thread_quit(void);
 extern void mln_thread_resource_info(struct mln_thread_pool_info *info);
 #endif
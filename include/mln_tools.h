@@ -33,6 +33,28 @@ struct utctime {
 
 
 extern int mln_sys_limit_modify(void);
+/*
+ * Boot-stage memory layout tuning, driven by two commands in the
+ * 'main' configuration domain and run before any worker is forked so
+ * every worker inherits the result:
+ *
+ *     hot_text_hugepage on;
+ *         Remap the executable segments of the binary and of libmelon
+ *         onto 2MB-backed anonymous memory (copy text aside, move it
+ *         back over itself with one atomic mremap), collapsing the
+ *         many 4KB text pages the library plus interpreter span into a
+ *         few iTLB entries. Linux only; the remapped text loses its
+ *         file backing in /proc/self/maps.
+ *     prefault_data on;
+ *         Touch every resident-capable page of the writable private
+ *         data segments so workers start with populated page tables
+ *         instead of faulting their way to them.
+ *
+ * Both are best-effort: a kernel that refuses any step leaves the
+ * affected region as it was and boot continues. Return -1 only on
+ * configuration errors.
+ */
+extern int mln_sys_layout_modify(void);
 #if !defined(WIN32)
 extern int mln_daemon(void);
 #endif
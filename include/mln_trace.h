@@ -24,5 +24,40 @@ extern void mln_trace_finalize(void);
 extern void mln_trace_init_callback_set(mln_trace_init_cb_t cb);
 extern int mln_trace_recv_handler_set(mln_lang_ctx_pipe_recv_cb_t recv_handler);
 
+/*
+ * Fast trace points. mln_trace() hands every call to the Melang script
+ * inline, which costs microseconds per point; mln_trace_fast() instead
+ * appends a fixed-size binary record to a per-thread ring buffer and a
+ * flush timer ships whole batches to the script asynchronously as one
+ * binary string (an array of mln_trace_record_t) per message, so hot
+ * paths pay only the sampled record write. Sampling is head-based:
+ * with 'sample' set to N, one call in N is recorded and the rest
+ * return immediately. Arguments must be integers (at most 4); records
+ * that do not fit into a full ring are dropped and counted. Call
+ * mln_trace_fast_finalize() only after tracing threads have stopped.
+ */
+typedef struct {
+    mln_u64_t time;   /*microseconds since the epoch*/
+    mln_u64_t tid;
+    mln_u32_t point;
+    mln_u32_t nargs;
+    mln_s64_t args[4];
+} mln_trace_record_t;
+
+#define M_TRACE_FAST_NARGS_(d, a1, a2, a3, a4, n, ...) n
+#define M_TRACE_FAST_NARGS(...) M_TRACE_FAST_NARGS_(0, ##__VA_ARGS__, 4, 3, 2, 1, 0)
+#define mln_trace_fast_pad_(point, n, a1, a2, a3, a4, ...) \
+    mln_trace_fast_emit((point), (n), (mln_s64_t)(a1), (mln_s64_t)(a2), (mln_s64_t)(a3), (mln_s64_t)(a4))
+#define mln_trace_fast(point, ...) \
+    mln_trace_fast_pad_((point), M_TRACE_FAST_NARGS(__VA_ARGS__), ##__VA_ARGS__, 0, 0, 0, 0)
+
+extern int mln_trace_fast_init(mln_event_t *ev, mln_u32_t nrecord, mln_u32_t sample) __NONNULL1(1);
+extern int
+mln_trace_fast_emit(mln_u32_t point, mln_u32_t nargs, mln_s64_t a1, mln_s64_t a2, mln_s64_t a3, mln_s64_t a4);
+extern void mln_trace_fast_sample_set(mln_u32_t sample);
+extern mln_size_t mln_trace_fast_flush(void);
+extern mln_u64_t mln_trace_fast_drops(void);
+extern void mln_trace_fast_finalize(void);
+
 #endif
 
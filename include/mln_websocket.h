@@ -11,6 +11,7 @@
 #include "mln_chain.h"
 #include "mln_alloc.h"
 #include "mln_hash.h"
+#include "mln_deflate.h"
 
 /*
  * return value
@@ -20,6 +21,10 @@
 #define M_WS_RET_FAILED                   1
 #define M_WS_RET_NOTWS                    2
 #define M_WS_RET_NOTYET                   3
+/*a fragment was consumed, the message it belongs to is not complete yet*/
+#define M_WS_RET_FRAGMENT                 4
+
+#define M_WS_BATCH_ALLOC_SIZE             4096
 /*
  * status code
  */
@@ -53,9 +58,12 @@
 #define M_WS_FLAG_END                     0x2
 #define M_WS_FLAG_CLIENT                  0x4
 #define M_WS_FLAG_SERVER                  0x8
+/*for mln_websocket_broadcast(): emit a TEXT frame instead of BINARY*/
+#define M_WS_FLAG_TEXT                    0x10
 
 typedef struct mln_websocket_s mln_websocket_t;
 typedef int (*mln_ws_extension_handle)(mln_websocket_t *);
+typedef int (*mln_websocket_frame_handler)(mln_websocket_t *, void *);
 
 struct mln_websocket_s {
     mln_http_t              *http;
@@ -69,6 +77,8 @@ struct mln_websocket_s {
     void                    *data;
     void                    *content;
     mln_ws_extension_handle  extension_handler;
+    mln_deflate_t           *deflate_enc;/*permessage-deflate, outbound*/
+    mln_deflate_t           *deflate_dec;/*permessage-deflate, inbound*/
     mln_u64_t                content_len;
     mln_u16_t                content_free:1;
     mln_u16_t                fin:1;
@@ -77,9 +87,14 @@ struct mln_websocket_s {
     mln_u16_t                rsv3:1;
     mln_u16_t                opcode:4;
     mln_u16_t                mask:1;
-    mln_u16_t                padding:6;
+    mln_u16_t                deflate:1;/*permessage-deflate requested/negotiated*/
+    mln_u16_t                reassemble:1;/*collect fragmented messages as a chain*/
+    mln_u16_t                msg_opcode:4;/*opcode of the message under reassembly*/
     mln_u16_t                status;
     mln_u32_t                masking_key;
+    mln_chain_t             *msg_head;/*reassembled fragments, shadow buffers*/
+    mln_chain_t             *msg_tail;
+    mln_u64_t                msg_len;
 };
 
 #define mln_websocket_get_http(ws)             ((ws)->http)
@@ -124,6 +139,32 @@ struct mln_websocket_s {
 #define mln_websocket_get_maskbit(ws)          ((ws)->mask)
 #define mln_websocket_set_masking_key(ws,k)    ((ws)->masking_key = (k))
 #define mln_websocket_get_masking_key(ws)      ((ws)->masking_key)
+/*
+ * Opt in to permessage-deflate before generating the handshake
+ * (request on the client, response on the server). Once both peers
+ * agree, outgoing data messages are compressed and RSV1-flagged
+ * incoming ones are inflated transparently, with the sliding-window
+ * context kept on the connection unless a no_context_takeover
+ * parameter was negotiated.
+ */
+#define mln_websocket_deflate_set(ws)          ((ws)->deflate = 1)
+#define mln_websocket_deflate_reset(ws)        ((ws)->deflate = 0)
+#define mln_websocket_deflate_get(ws)          ((ws)->deflate)
+/*
+ * Opt in to zero-copy message reassembly. With it set,
+ * mln_websocket_parse() keeps the payload of TEXT/BINARY/CONTINUE
+ * frames as shadow buffers borrowing the receive chain (no coalescing
+ * copy; see mln_buf_ref()) and returns M_WS_RET_FRAGMENT until the
+ * final fragment arrives, then M_WS_RET_OK with the whole message
+ * available as a chain. Control frames and inflated messages still go
+ * through the per-frame content buffer.
+ */
+#define mln_websocket_reassemble_set(ws)       ((ws)->reassemble = 1)
+#define mln_websocket_reassemble_reset(ws)     ((ws)->reassemble = 0)
+#define mln_websocket_reassemble_get(ws)       ((ws)->reassemble)
+#define mln_websocket_msg_get(ws)              ((ws)->msg_head)
+#define mln_websocket_msg_len_get(ws)          ((ws)->msg_len)
+#define mln_websocket_msg_opcode_get(ws)       ((ws)->msg_opcode)
 
 extern int mln_websocket_init(mln_websocket_t *ws, mln_http_t *http) __NONNULL2(1,2);
 extern mln_websocket_t *mln_websocket_new(mln_http_t *http) __NONNULL1(1);
@@ -160,6 +201,66 @@ extern int mln_websocket_close_generate(mln_websocket_t *ws, \
 extern int mln_websocket_ping_generate(mln_websocket_t *ws, mln_chain_t **out_cnode, mln_u32_t flags) __NONNULL2(1,2);
 extern int mln_websocket_pong_generate(mln_websocket_t *ws, mln_chain_t **out_cnode, mln_u32_t flags) __NONNULL2(1,2);
 extern int mln_websocket_generate(mln_websocket_t *ws, mln_chain_t **out_cnode) __NONNULL1(1);
+/*
+ * mln_websocket_generate_append():
+ * Same as mln_websocket_generate() but coalesces frames: the frame is
+ * written into the spare room of the tail buffer of out_head/out_tail
+ * when it fits, and a new M_WS_BATCH_ALLOC_SIZE buffer is chained only
+ * when it does not, so many small frames share one allocation.
+ */
+extern int mln_websocket_generate_append(mln_websocket_t *ws, \
+                                         mln_chain_t **out_head, \
+                                         mln_chain_t **out_tail) __NONNULL3(1,2,3);
 extern int mln_websocket_parse(mln_websocket_t *ws, mln_chain_t **in) __NONNULL1(1);
+/*
+ * mln_websocket_parse_batch():
+ * Parse every complete frame in 'in' in one call, invoking
+ * 'frame_handler' after each one with the frame fields set on the
+ * mln_websocket_t. Return M_WS_RET_NOTYET once no complete frame is
+ * left (a trailing partial frame stays in 'in'), or the first
+ * non-M_WS_RET_OK value from the parser or the handler.
+ */
+extern int mln_websocket_parse_batch(mln_websocket_t *ws, \
+                                     mln_chain_t **in, \
+                                     mln_websocket_frame_handler frame_handler, \
+                                     void *data) __NONNULL2(1,2);
+/*
+ * mln_websocket_msg_take():
+ * Detach and return the reassembled message chain. The caller owns it
+ * and releases it with mln_chain_pool_release_all(); a message never
+ * taken is dropped when the next message starts. The message length
+ * and opcode stay readable via mln_websocket_msg_len_get()/
+ * mln_websocket_msg_opcode_get() until the next message begins.
+ */
+extern mln_chain_t *mln_websocket_msg_take(mln_websocket_t *ws) __NONNULL1(1);
+/*
+ * mln_websocket_msg_flatten():
+ * For callers that truly need contiguity: copy the current reassembled
+ * message into one pool buffer, install it as the websocket content
+ * (content/content_len) and release the fragment chain.
+ * Return the buffer, or NULL if there is no message or on allocation
+ * failure.
+ */
+extern mln_u8ptr_t mln_websocket_msg_flatten(mln_websocket_t *ws) __NONNULL1(1);
+/*
+ * mln_websocket_broadcast():
+ * Fan one payload out to many connections. The server-to-client frame
+ * (BINARY, or TEXT with M_WS_FLAG_TEXT; M_WS_FLAG_NEW/M_WS_FLAG_END as
+ * in the per-connection generators) is rendered exactly once, then
+ * appended to every connection's send chain as refcounted shadow
+ * buffers, so the cost is O(connections) rather than
+ * O(connections x payload). Frames are unmasked, as server-side frames
+ * must be; use a websocket without permessage-deflate negotiated for
+ * broadcasting, since peers cannot share one compression context.
+ * The frame bytes are freed once every connection has sent them.
+ * Return M_WS_RET_OK, or M_WS_RET_FAILED on allocation failure (some
+ * connections may already have the frame queued by then).
+ */
+extern int mln_websocket_broadcast(mln_websocket_t *ws, \
+                                   mln_tcp_conn_t **conns, \
+                                   mln_size_t nconns, \
+                                   void *buf, \
+                                   mln_size_t len, \
+                                   mln_u32_t flags) __NONNULL2(1,2);
 
 #endif
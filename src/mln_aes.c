@@ -7,6 +7,27 @@
 #include <stdlib.h>
 #include "mln_aes.h"
 
+/*
+ * Hardware AES: AES-NI on x86-64 and the ARMv8 Crypto Extensions on
+ * aarch64. Support is detected once at runtime; mln_aes_init() then
+ * expands the round keys into the byte order the instructions expect
+ * and the encrypt/decrypt entry points take the one-instruction-per-
+ * round path. The table-based C code below stays as the fallback.
+ * The target attribute keeps the rest of the library free of any ISA
+ * requirement, so no build flags change.
+ */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define MLN_AES_HW_X86 1
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#if defined(HWCAP_AES)
+#define MLN_AES_HW_ARM 1
+#include <arm_neon.h>
+#endif
+#endif
+
 static inline void mln_aes_addroundkey(mln_u32_t *state, mln_u32_t *roundkey, int round);
 static inline void mln_aes_mixcolume(mln_u32_t *state);
 static inline void mln_aes_bytesub(mln_u32_t *state);
@@ -74,6 +95,160 @@ static mln_u32_t rcon[] = {
                                  ((((mln_u32_t)sbox[(val >> 16) & 0xff]) & 0xff) << 16) | \
                                  ((((mln_u32_t)sbox[(val >> 24) & 0xff]) & 0xff) << 24))
 
+#if defined(MLN_AES_HW_X86) || defined(MLN_AES_HW_ARM)
+static int mln_aes_hw_support(void)
+{
+    static int support = -1;
+    if (support < 0) {
+#if defined(MLN_AES_HW_X86)
+        support = __builtin_cpu_supports("aes")? 1: 0;
+#else
+        support = (getauxval(AT_HWCAP) & HWCAP_AES)? 1: 0;
+#endif
+    }
+    return support;
+}
+
+static inline void mln_aes_hw_rk_bytes(mln_aes_t *a, mln_u32_t nr)
+{
+    /*w[] packs each round key word big-endian, the ISAs take plain bytes*/
+    mln_u32_t i, n = (nr + 1) << 2;
+    for (i = 0; i < n; ++i) {
+        a->hwek[(i << 2) + 0] = (a->w[i] >> 24) & 0xff;
+        a->hwek[(i << 2) + 1] = (a->w[i] >> 16) & 0xff;
+        a->hwek[(i << 2) + 2] = (a->w[i] >> 8) & 0xff;
+        a->hwek[(i << 2) + 3] = a->w[i] & 0xff;
+    }
+}
+#endif
+
+#if defined(MLN_AES_HW_X86)
+__attribute__((target("aes,sse2"))) static void
+mln_aes_hw_setup(mln_aes_t *a, mln_u32_t nr)
+{
+    mln_u32_t i;
+    __m128i k;
+
+    mln_aes_hw_rk_bytes(a, nr);
+    /*equivalent inverse cipher: middle round keys pass through AESIMC*/
+    k = _mm_loadu_si128((__m128i *)(a->hwek + (nr << 4)));
+    _mm_storeu_si128((__m128i *)(a->hwdk), k);
+    for (i = 1; i < nr; ++i) {
+        k = _mm_loadu_si128((__m128i *)(a->hwek + ((nr - i) << 4)));
+        _mm_storeu_si128((__m128i *)(a->hwdk + (i << 4)), _mm_aesimc_si128(k));
+    }
+    k = _mm_loadu_si128((__m128i *)(a->hwek));
+    _mm_storeu_si128((__m128i *)(a->hwdk + (nr << 4)), k);
+}
+
+__attribute__((target("aes,sse2"))) static void
+mln_aes_hw_encrypt(mln_aes_t *a, mln_u8ptr_t text, mln_u32_t nr)
+{
+    mln_u32_t i;
+    __m128i b = _mm_loadu_si128((__m128i *)text);
+
+    b = _mm_xor_si128(b, _mm_loadu_si128((__m128i *)(a->hwek)));
+    for (i = 1; i < nr; ++i) {
+        b = _mm_aesenc_si128(b, _mm_loadu_si128((__m128i *)(a->hwek + (i << 4))));
+    }
+    b = _mm_aesenclast_si128(b, _mm_loadu_si128((__m128i *)(a->hwek + (nr << 4))));
+    _mm_storeu_si128((__m128i *)text, b);
+}
+
+__attribute__((target("aes,sse2"))) static void
+mln_aes_hw_decrypt(mln_aes_t *a, mln_u8ptr_t cipher, mln_u32_t nr)
+{
+    mln_u32_t i;
+    __m128i b = _mm_loadu_si128((__m128i *)cipher);
+
+    b = _mm_xor_si128(b, _mm_loadu_si128((__m128i *)(a->hwdk)));
+    for (i = 1; i < nr; ++i) {
+        b = _mm_aesdec_si128(b, _mm_loadu_si128((__m128i *)(a->hwdk + (i << 4))));
+    }
+    b = _mm_aesdeclast_si128(b, _mm_loadu_si128((__m128i *)(a->hwdk + (nr << 4))));
+    _mm_storeu_si128((__m128i *)cipher, b);
+}
+
+/*n independent blocks in flight so the AES unit's pipeline stays full*/
+__attribute__((target("aes,sse2"))) static void
+mln_aes_hw_encrypt_n(mln_aes_t *a, mln_u8ptr_t blks, mln_u32_t n, mln_u32_t nr)
+{
+    mln_u32_t i, j;
+    __m128i b[8], k;
+
+    for (j = 0; j < n; ++j) b[j] = _mm_loadu_si128((__m128i *)(blks + (j << 4)));
+    k = _mm_loadu_si128((__m128i *)(a->hwek));
+    for (j = 0; j < n; ++j) b[j] = _mm_xor_si128(b[j], k);
+    for (i = 1; i < nr; ++i) {
+        k = _mm_loadu_si128((__m128i *)(a->hwek + (i << 4)));
+        for (j = 0; j < n; ++j) b[j] = _mm_aesenc_si128(b[j], k);
+    }
+    k = _mm_loadu_si128((__m128i *)(a->hwek + (nr << 4)));
+    for (j = 0; j < n; ++j) b[j] = _mm_aesenclast_si128(b[j], k);
+    for (j = 0; j < n; ++j) _mm_storeu_si128((__m128i *)(blks + (j << 4)), b[j]);
+}
+#elif defined(MLN_AES_HW_ARM)
+__attribute__((target("+crypto"))) static void
+mln_aes_hw_setup(mln_aes_t *a, mln_u32_t nr)
+{
+    mln_u32_t i;
+
+    mln_aes_hw_rk_bytes(a, nr);
+    vst1q_u8(a->hwdk, vld1q_u8(a->hwek + (nr << 4)));
+    for (i = 1; i < nr; ++i) {
+        vst1q_u8(a->hwdk + (i << 4), vaesimcq_u8(vld1q_u8(a->hwek + ((nr - i) << 4))));
+    }
+    vst1q_u8(a->hwdk + (nr << 4), vld1q_u8(a->hwek));
+}
+
+__attribute__((target("+crypto"))) static void
+mln_aes_hw_encrypt(mln_aes_t *a, mln_u8ptr_t text, mln_u32_t nr)
+{
+    mln_u32_t i;
+    uint8x16_t b = vld1q_u8(text);
+
+    for (i = 0; i + 1 < nr; ++i) {
+        b = vaesmcq_u8(vaeseq_u8(b, vld1q_u8(a->hwek + (i << 4))));
+    }
+    b = vaeseq_u8(b, vld1q_u8(a->hwek + ((nr - 1) << 4)));
+    b = veorq_u8(b, vld1q_u8(a->hwek + (nr << 4)));
+    vst1q_u8(text, b);
+}
+
+__attribute__((target("+crypto"))) static void
+mln_aes_hw_decrypt(mln_aes_t *a, mln_u8ptr_t cipher, mln_u32_t nr)
+{
+    mln_u32_t i;
+    uint8x16_t b = vld1q_u8(cipher);
+
+    for (i = 0; i + 1 < nr; ++i) {
+        b = vaesimcq_u8(vaesdq_u8(b, vld1q_u8(a->hwdk + (i << 4))));
+    }
+    b = vaesdq_u8(b, vld1q_u8(a->hwdk + ((nr - 1) << 4)));
+    b = veorq_u8(b, vld1q_u8(a->hwdk + (nr << 4)));
+    vst1q_u8(cipher, b);
+}
+
+/*n independent blocks in flight so the AES unit's pipeline stays full*/
+__attribute__((target("+crypto"))) static void
+mln_aes_hw_encrypt_n(mln_aes_t *a, mln_u8ptr_t blks, mln_u32_t n, mln_u32_t nr)
+{
+    mln_u32_t i, j;
+    uint8x16_t b[8], k;
+
+    for (j = 0; j < n; ++j) b[j] = vld1q_u8(blks + (j << 4));
+    for (i = 0; i + 1 < nr; ++i) {
+        k = vld1q_u8(a->hwek + (i << 4));
+        for (j = 0; j < n; ++j) b[j] = vaesmcq_u8(vaeseq_u8(b[j], k));
+    }
+    k = vld1q_u8(a->hwek + ((nr - 1) << 4));
+    for (j = 0; j < n; ++j) b[j] = vaeseq_u8(b[j], k);
+    k = vld1q_u8(a->hwek + (nr << 4));
+    for (j = 0; j < n; ++j) b[j] = veorq_u8(b[j], k);
+    for (j = 0; j < n; ++j) vst1q_u8(blks + (j << 4), b[j]);
+}
+#endif
+
 int mln_aes_init(mln_aes_t *a, mln_u8ptr_t key, mln_u32_t bits)
 {
     int i;
@@ -114,7 +289,14 @@ int mln_aes_init(mln_aes_t *a, mln_u8ptr_t key, mln_u32_t bits)
     for (; i < 60; ++i) roundkey[i] = 0;
 
     a->bits = bits;
-    
+    a->hw = 0;
+#if defined(MLN_AES_HW_X86) || defined(MLN_AES_HW_ARM)
+    if (mln_aes_hw_support()) {
+        mln_aes_hw_setup(a, (times >> 2) - 1);
+        a->hw = 1;
+    }
+#endif
+
     return 0;
 }
 
@@ -227,6 +409,13 @@ int mln_aes_encrypt(mln_aes_t *a, mln_u8ptr_t text)
         default: return -1;
     }
 
+#if defined(MLN_AES_HW_X86) || defined(MLN_AES_HW_ARM)
+    if (a->hw) {
+        mln_aes_hw_encrypt(a, text, nr);
+        return 0;
+    }
+#endif
+
     for (i = 0; i < sizeof(mln_u32_t); ++i) {
         for (j = 0; j < sizeof(mln_u32_t); ++j) {
             state[j] |= (((mln_u32_t)(text[(i<<2) + j] & 0xff)) << ((sizeof(mln_u32_t)-1-i) << 3));
@@ -272,6 +461,13 @@ int mln_aes_decrypt(mln_aes_t *a, mln_u8ptr_t cipher)
         default: return -1;
     }
 
+#if defined(MLN_AES_HW_X86) || defined(MLN_AES_HW_ARM)
+    if (a->hw) {
+        mln_aes_hw_decrypt(a, cipher, nr);
+        return 0;
+    }
+#endif
+
     for (i = 0; i < sizeof(mln_u32_t); ++i) {
         for (j = 0; j < sizeof(mln_u32_t); ++j) {
             state[j] |= (((mln_u32_t)(cipher[(i<<2) + j] & 0xff)) << ((sizeof(mln_u32_t)-1-i) << 3));
@@ -346,3 +542,252 @@ static inline void mln_aes_invmixcolume(mln_u32_t *state)
     }
 }
 
+
+/*
+ * Counter mode. The keystream is produced a batch of blocks at a time
+ * (M_AES_CTR_LANES independent counters) so the hardware path can keep
+ * several blocks in flight; the table-based path just walks the batch.
+ * A trailing fragment consumes a whole counter step and the unused tail
+ * of its keystream block is dropped, so callers splitting one stream
+ * across calls must keep every call but the last block-aligned.
+ */
+#define M_AES_CTR_LANES 8
+
+static inline void mln_aes_ctr_inc(mln_u8ptr_t counter, mln_u32_t width)
+{
+    /*big-endian increment over the low 'width' bytes of the block*/
+    mln_u32_t i;
+    for (i = 16; i > 16 - width; ) {
+        if (++counter[--i] != 0) break;
+    }
+}
+
+static int mln_aes_ctr_core(mln_aes_t *a, mln_u8ptr_t counter, mln_u8ptr_t buf, mln_size_t len, mln_u32_t width)
+{
+    mln_u32_t i, n, nr;
+    mln_size_t chunk;
+    mln_u8_t ks[M_AES_CTR_LANES << 4];
+
+    switch (a->bits) {
+        case M_AES_128:
+            nr = __MLN_AES128_Nr;
+            break;
+        case M_AES_192:
+            nr = __MLN_AES192_Nr;
+            break;
+        case M_AES_256:
+            nr = __MLN_AES256_Nr;
+            break;
+        default: return -1;
+    }
+
+    while (len > 0) {
+        n = (len + 15) >> 4;
+        if (n > M_AES_CTR_LANES) n = M_AES_CTR_LANES;
+        for (i = 0; i < n; ++i) {
+            memcpy(ks + (i << 4), counter, 16);
+            mln_aes_ctr_inc(counter, width);
+        }
+#if defined(MLN_AES_HW_X86) || defined(MLN_AES_HW_ARM)
+        if (a->hw) {
+            mln_aes_hw_encrypt_n(a, ks, n, nr);
+        } else {
+#endif
+            for (i = 0; i < n; ++i) {
+                mln_aes_encrypt(a, ks + (i << 4));
+            }
+#if defined(MLN_AES_HW_X86) || defined(MLN_AES_HW_ARM)
+        }
+#endif
+        chunk = (mln_size_t)n << 4;
+        if (chunk > len) chunk = len;
+        for (i = 0; i < chunk; ++i) buf[i] ^= ks[i];
+        buf += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+int mln_aes_ctr_crypt(mln_aes_t *a, mln_u8ptr_t counter, mln_u8ptr_t buf, mln_size_t len)
+{
+    return mln_aes_ctr_core(a, counter, buf, len, 16);
+}
+
+
+/*
+ * GCM. GHASH uses Shoup's 4-bit table method: 16 multiples of the hash
+ * key H are precomputed per call, then each block costs 32 table
+ * lookups. Encryption is the counter core above with the 32-bit
+ * increment GCM specifies.
+ */
+typedef struct {
+    mln_u64_t hh[16];
+    mln_u64_t hl[16];
+} mln_aes_ghash_t;
+
+static const mln_u64_t mln_aes_gcm_last4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+static inline mln_u64_t mln_aes_gcm_load64(mln_u8ptr_t p)
+{
+    return ((mln_u64_t)p[0] << 56) | ((mln_u64_t)p[1] << 48) | \
+           ((mln_u64_t)p[2] << 40) | ((mln_u64_t)p[3] << 32) | \
+           ((mln_u64_t)p[4] << 24) | ((mln_u64_t)p[5] << 16) | \
+           ((mln_u64_t)p[6] << 8) | (mln_u64_t)p[7];
+}
+
+static inline void mln_aes_gcm_store64(mln_u8ptr_t p, mln_u64_t v)
+{
+    p[0] = (v >> 56) & 0xff;
+    p[1] = (v >> 48) & 0xff;
+    p[2] = (v >> 40) & 0xff;
+    p[3] = (v >> 32) & 0xff;
+    p[4] = (v >> 24) & 0xff;
+    p[5] = (v >> 16) & 0xff;
+    p[6] = (v >> 8) & 0xff;
+    p[7] = v & 0xff;
+}
+
+static void mln_aes_ghash_init(mln_aes_ghash_t *g, mln_u8ptr_t h)
+{
+    mln_u64_t vh = mln_aes_gcm_load64(h), vl = mln_aes_gcm_load64(h + 8);
+    mln_u32_t i, j, t;
+
+    g->hh[0] = 0;
+    g->hl[0] = 0;
+    g->hh[8] = vh;
+    g->hl[8] = vl;
+    for (i = 4; i > 0; i >>= 1) {
+        t = (mln_u32_t)(vl & 1) * 0xe1000000;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ ((mln_u64_t)t << 32);
+        g->hh[i] = vh;
+        g->hl[i] = vl;
+    }
+    for (i = 2; i <= 8; i <<= 1) {
+        vh = g->hh[i];
+        vl = g->hl[i];
+        for (j = 1; j < i; ++j) {
+            g->hh[i + j] = vh ^ g->hh[j];
+            g->hl[i + j] = vl ^ g->hl[j];
+        }
+    }
+}
+
+static void mln_aes_ghash_mult(mln_aes_ghash_t *g, mln_u8ptr_t x)
+{
+    mln_s32_t i;
+    mln_u8_t lo, hi, rem;
+    mln_u64_t zh, zl;
+
+    lo = x[15] & 0xf;
+    zh = g->hh[lo];
+    zl = g->hl[lo];
+    for (i = 15; i >= 0; --i) {
+        lo = x[i] & 0xf;
+        hi = (x[i] >> 4) & 0xf;
+        if (i != 15) {
+            rem = (mln_u8_t)(zl & 0xf);
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (mln_aes_gcm_last4[rem] << 48);
+            zh ^= g->hh[lo];
+            zl ^= g->hl[lo];
+        }
+        rem = (mln_u8_t)(zl & 0xf);
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ (mln_aes_gcm_last4[rem] << 48);
+        zh ^= g->hh[hi];
+        zl ^= g->hl[hi];
+    }
+    mln_aes_gcm_store64(x, zh);
+    mln_aes_gcm_store64(x + 8, zl);
+}
+
+static void mln_aes_ghash_update(mln_aes_ghash_t *g, mln_u8ptr_t s, mln_u8ptr_t data, mln_size_t len)
+{
+    mln_size_t i, n;
+
+    while (len > 0) {
+        n = len > 16? 16: len;
+        for (i = 0; i < n; ++i) s[i] ^= data[i];
+        mln_aes_ghash_mult(g, s);
+        data += n;
+        len -= n;
+    }
+}
+
+static int mln_aes_gcm_crypt(mln_aes_t *a, \
+                             mln_u8ptr_t iv, mln_size_t ivlen, \
+                             mln_u8ptr_t aad, mln_size_t aadlen, \
+                             mln_u8ptr_t buf, mln_size_t len, \
+                             mln_u8ptr_t tag, int enc)
+{
+    mln_aes_ghash_t g;
+    mln_u8_t h[16], j0[16], s[16], lenblk[16], ctr[16], diff;
+    mln_u32_t i;
+
+    if (ivlen == 0) return -1;
+
+    memset(h, 0, sizeof(h));
+    if (mln_aes_encrypt(a, h) < 0) return -1;
+    mln_aes_ghash_init(&g, h);
+
+    if (ivlen == 12) {
+        memcpy(j0, iv, 12);
+        j0[12] = j0[13] = j0[14] = 0;
+        j0[15] = 1;
+    } else {
+        memset(j0, 0, sizeof(j0));
+        mln_aes_ghash_update(&g, j0, iv, ivlen);
+        memset(lenblk, 0, 8);
+        mln_aes_gcm_store64(lenblk + 8, (mln_u64_t)ivlen << 3);
+        for (i = 0; i < 16; ++i) j0[i] ^= lenblk[i];
+        mln_aes_ghash_mult(&g, j0);
+    }
+    memcpy(ctr, j0, sizeof(ctr));
+    mln_aes_ctr_inc(ctr, 4);
+
+    memset(s, 0, sizeof(s));
+    mln_aes_ghash_update(&g, s, aad, aadlen);
+
+    if (enc && mln_aes_ctr_core(a, ctr, buf, len, 4) < 0) return -1;
+    mln_aes_ghash_update(&g, s, buf, len);
+
+    mln_aes_gcm_store64(lenblk, (mln_u64_t)aadlen << 3);
+    mln_aes_gcm_store64(lenblk + 8, (mln_u64_t)len << 3);
+    for (i = 0; i < 16; ++i) s[i] ^= lenblk[i];
+    mln_aes_ghash_mult(&g, s);
+
+    if (mln_aes_encrypt(a, j0) < 0) return -1;
+    for (i = 0; i < 16; ++i) s[i] ^= j0[i];
+
+    if (enc) {
+        memcpy(tag, s, 16);
+        return 0;
+    }
+    /*verify before releasing any plaintext*/
+    for (diff = 0, i = 0; i < 16; ++i) diff |= s[i] ^ tag[i];
+    if (diff) return -1;
+    return mln_aes_ctr_core(a, ctr, buf, len, 4);
+}
+
+int mln_aes_gcm_encrypt(mln_aes_t *a, \
+                        mln_u8ptr_t iv, mln_size_t ivlen, \
+                        mln_u8ptr_t aad, mln_size_t aadlen, \
+                        mln_u8ptr_t buf, mln_size_t len, \
+                        mln_u8ptr_t tag)
+{
+    return mln_aes_gcm_crypt(a, iv, ivlen, aad, aadlen, buf, len, tag, 1);
+}
+
+int mln_aes_gcm_decrypt(mln_aes_t *a, \
+                        mln_u8ptr_t iv, mln_size_t ivlen, \
+                        mln_u8ptr_t aad, mln_size_t aadlen, \
+                        mln_u8ptr_t buf, mln_size_t len, \
+                        mln_u8ptr_t tag)
+{
+    return mln_aes_gcm_crypt(a, iv, ivlen, aad, aadlen, buf, len, tag, 0);
+}
+
@@ -6,6 +6,15 @@
 #include "mln_alloc.h"
 #include "mln_defs.h"
 
+#define mln_alloc_shm_need_lock(p) (mln_alloc_is_shm(p) && !(p)->shm_lockfree)
+#define mln_alloc_arena_contain(p,ptr) \
+    ((p)->arena != NULL && \
+     (mln_u8ptr_t)(ptr) >= (mln_u8ptr_t)((p)->arena) && \
+     (mln_u8ptr_t)(ptr) < (mln_u8ptr_t)((p)->arena) + (p)->arena_size)
+#define mln_alloc_shm_cls_off(v)        ((v) & 0xffffffffffffULL)
+#define mln_alloc_shm_cls_tag(v)        ((v) >> 48)
+#define mln_alloc_shm_cls_pack(off,tag) ((((mln_u64_t)(tag) & 0xffff) << 48) | ((mln_u64_t)(off) & 0xffffffffffffULL))
+
 
 MLN_CHAIN_FUNC_DECLARE(mln_blk, \
                        mln_alloc_blk_t, \
@@ -26,6 +35,14 @@ static inline int mln_alloc_shm_allowed(mln_alloc_shm_t *as, mln_off_t *Boff, ml
 static inline void *mln_alloc_shm_set_bitmap(mln_alloc_shm_t *as, mln_off_t Boff, mln_off_t boff, mln_size_t size);
 static inline mln_alloc_shm_t *mln_alloc_shm_new_block(mln_alloc_t *pool, mln_off_t *Boff, mln_off_t *boff, mln_size_t size);
 static inline void mln_alloc_free_shm(void *ptr);
+static void *mln_alloc_heap_m(mln_alloc_t *pool, mln_size_t size);
+static void mln_alloc_heap_free(mln_alloc_blk_t *blk);
+static void *mln_alloc_tcache_m(mln_alloc_t *pool, mln_size_t size);
+static void mln_alloc_tcache_free(mln_alloc_t *pool, mln_alloc_blk_t *blk);
+static inline void *mln_alloc_shm_m_locked(mln_alloc_t *pool, mln_size_t size);
+static void *mln_alloc_shm_lockfree_m(mln_alloc_t *pool, mln_size_t size);
+static inline void mln_alloc_free_shm_locked(void *ptr);
+static inline mln_u8ptr_t mln_alloc_arena_carve(mln_alloc_t *pool, mln_size_t size);
 
 static inline mln_alloc_shm_t *mln_alloc_shm_new(mln_alloc_t *pool, mln_size_t size, int is_large)
 {
@@ -130,19 +147,93 @@ mln_alloc_t *mln_alloc_shm_init(struct mln_alloc_shm_attr_s *attr)
     pool->locker = attr->locker;
     pool->lock = attr->lock;
     pool->unlock = attr->unlock;
+    pool->tcache_enabled = 0;
+    pool->shm_lockfree = 0;
+    pool->arena = NULL;
+    pool->arena_size = pool->arena_pos = 0;
+    pool->stats_enabled = 0;
+    pool->large_live = pool->large_count = pool->large_high = 0;
+    pool->sample_threshold = 0;
+    pool->sample_handler = NULL;
+    pool->sample_data = NULL;
+    return pool;
+}
+
+mln_alloc_t *mln_alloc_shm_lockfree_init(struct mln_alloc_shm_attr_s *attr)
+{
+    mln_alloc_t *pool = mln_alloc_shm_init(attr);
+    if (pool == NULL) return NULL;
+    memset(pool->shm_cls, 0, sizeof(pool->shm_cls));
+    pool->shm_lockfree = 1;
     return pool;
 }
 
+static inline int mln_alloc_shm_cls_index(mln_size_t size)
+{
+    int i;
+    mln_size_t s = M_ALLOC_SHM_CLS_MIN;
+    for (i = 0; i < M_ALLOC_SHM_CLS_NUM; ++i, s <<= 1) {
+        if (size <= s) return i;
+    }
+    return -1;
+}
+
+static inline void mln_alloc_shm_cls_push(mln_alloc_t *pool, int idx, mln_alloc_blk_t *blk)
+{
+    mln_u64_t old, nv, next, off = (mln_u8ptr_t)blk - (mln_u8ptr_t)(pool->mem);
+    do {
+        old = __atomic_load_n(&(pool->shm_cls[idx]), __ATOMIC_ACQUIRE);
+        next = mln_alloc_shm_cls_off(old);
+        memcpy(blk->data, &next, sizeof(next));
+        nv = mln_alloc_shm_cls_pack(off, mln_alloc_shm_cls_tag(old) + 1);
+    } while (!__atomic_compare_exchange_n(&(pool->shm_cls[idx]), &old, nv, 0,                                           __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static inline mln_alloc_blk_t *mln_alloc_shm_cls_pop(mln_alloc_t *pool, int idx)
+{
+    mln_u64_t old, nv, next, off;
+    mln_alloc_blk_t *blk;
+    do {
+        old = __atomic_load_n(&(pool->shm_cls[idx]), __ATOMIC_ACQUIRE);
+        off = mln_alloc_shm_cls_off(old);
+        if (off == 0) return NULL;
+        blk = (mln_alloc_blk_t *)((mln_u8ptr_t)(pool->mem) + off);
+        memcpy(&next, blk->data, sizeof(next));
+        nv = mln_alloc_shm_cls_pack(next, mln_alloc_shm_cls_tag(old) + 1);
+    } while (!__atomic_compare_exchange_n(&(pool->shm_cls[idx]), &old, nv, 0,                                           __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+    return blk;
+}
+
+static void *mln_alloc_shm_lockfree_m(mln_alloc_t *pool, mln_size_t size)
+{
+    int idx = mln_alloc_shm_cls_index(size);
+    void *ptr;
+    mln_alloc_blk_t *blk;
+
+    if (idx >= 0) {
+        if ((blk = mln_alloc_shm_cls_pop(pool, idx)) != NULL) {
+            blk->in_used = 1;
+            return blk->data;
+        }
+        /*carve class-sized blocks so a later free lands back on this class*/
+        size = (mln_size_t)M_ALLOC_SHM_CLS_MIN << idx;
+    }
+    if (pool->lock(pool->locker) != 0) return NULL;
+    ptr = mln_alloc_shm_m_locked(pool, size);
+    (void)pool->unlock(pool->locker);
+    return ptr;
+}
+
 mln_alloc_t *mln_alloc_init(mln_alloc_t *parent)
 {
     mln_alloc_t *pool;
 
     if (parent != NULL) {
-        if (mln_alloc_is_shm(parent)) {
+        if (mln_alloc_shm_need_lock(parent)) {
             if (parent->lock(parent->locker) != 0) return NULL;
         }
         pool = (mln_alloc_t *)mln_alloc_m(parent, sizeof(mln_alloc_t));
-        if (mln_alloc_is_shm(parent)) {
+        if (mln_alloc_shm_need_lock(parent)) {
             (void)parent->unlock(parent->locker);
         }
     } else {
@@ -158,9 +249,110 @@ mln_alloc_t *mln_alloc_init(mln_alloc_t *parent)
     pool->locker = NULL;
     pool->lock = NULL;
     pool->unlock = NULL;
+    pool->tcache_enabled = 0;
+    pool->cp_epoch = 0;
+    pool->shm_lockfree = 0;
+    pool->arena = NULL;
+    pool->arena_size = pool->arena_pos = 0;
+    pool->stats_enabled = 0;
+    pool->large_live = pool->large_count = pool->large_high = 0;
+    pool->sample_threshold = 0;
+    pool->sample_handler = NULL;
+    pool->sample_data = NULL;
     return pool;
 }
 
+mln_alloc_t *mln_alloc_arena_init(struct mln_alloc_arena_attr_s *attr)
+{
+    mln_alloc_t *pool;
+
+    if (attr == NULL || attr->size == 0) return NULL;
+    pool = mln_alloc_init(NULL);
+    if (pool == NULL) return NULL;
+#if !defined(WIN32)
+    {
+        void *base = NULL;
+        /*round the reservation up to the 2MB huge page granule*/
+        mln_size_t size = (attr->size + 0x1fffff) & ~((mln_size_t)0x1fffff);
+#if defined(MAP_HUGETLB)
+        if (attr->hugepage) {
+            base = mmap(NULL, size, PROT_READ|PROT_WRITE, \
+                        MAP_PRIVATE|MAP_ANON|MAP_HUGETLB, -1, 0);
+            if (base == MAP_FAILED) base = NULL;/*no huge pages reserved, fall back*/
+        }
+#endif
+        if (base == NULL) {
+            base = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANON, -1, 0);
+            if (base == MAP_FAILED) base = NULL;
+        }
+        if (base != NULL) {
+            mln_u8ptr_t p, end = (mln_u8ptr_t)base + size;
+            for (p = (mln_u8ptr_t)base; p < end; p += 4096) *p = 0;/*prefault*/
+            pool->arena = base;
+            pool->arena_size = size;
+        }
+    }
+#endif
+    return pool;
+}
+
+/*
+ * Chunk backing store for arena pools. Chunks are bumped out of the
+ * pre-zeroed reservation and never handed back to it; released chunks
+ * simply stay cached on their manager, so the arena cannot fragment.
+ * Once the reservation is exhausted we degrade to malloc chunks.
+ */
+static inline mln_u8ptr_t mln_alloc_arena_carve(mln_alloc_t *pool, mln_size_t size)
+{
+    if (pool->arena != NULL) {
+        mln_size_t pos = (pool->arena_pos + 0xf) & ~((mln_size_t)0xf);
+        if (size <= pool->arena_size && pos <= pool->arena_size - size) {
+            pool->arena_pos = pos + size;
+            return (mln_u8ptr_t)(pool->arena) + pos;
+        }
+    }
+    return (mln_u8ptr_t)calloc(1, size);
+}
+
+int mln_alloc_stats_enable(mln_alloc_t *pool)
+{
+    if (mln_alloc_is_shm(pool)) return -1;
+    pool->stats_enabled = 1;
+    return 0;
+}
+
+int mln_alloc_stats(mln_alloc_t *pool, mln_alloc_stat_iterate_handler handler, void *udata)
+{
+    mln_alloc_stat_t st;
+    mln_alloc_mgr_t *am, *amend;
+
+    if (mln_alloc_is_shm(pool) || !pool->stats_enabled) return -1;
+    amend = pool->mgr_tbl + M_ALLOC_MGR_LEN;
+    for (am = pool->mgr_tbl; am < amend; ++am) {
+        if (am->high_water == 0 && am->chunk_count == 0) continue;
+        st.blk_size = am->blk_size;
+        st.live_bytes = am->live_bytes;
+        st.chunk_count = am->chunk_count;
+        st.high_water = am->high_water;
+        if (handler(&st, udata) < 0) return -1;
+    }
+    st.blk_size = 0;
+    st.live_bytes = pool->large_live;
+    st.chunk_count = pool->large_count;
+    st.high_water = pool->large_high;
+    return handler(&st, udata) < 0? -1: 0;
+}
+
+void mln_alloc_sample_set(mln_alloc_t *pool, \
+                          mln_size_t threshold, \
+                          mln_alloc_sample_handler handler, \
+                          void *udata)
+{
+    pool->sample_threshold = threshold;
+    pool->sample_handler = handler;
+    pool->sample_data = udata;
+}
+
 static inline void
 mln_alloc_mgr_table_init(mln_alloc_mgr_t *tbl)
 {
@@ -177,12 +369,14 @@ mln_alloc_mgr_table_init(mln_alloc_mgr_t *tbl)
         am->used_head = am->used_tail = NULL;
         am->chunk_head = am->chunk_tail = NULL;
         am->blk_size = blk_size + 1;
+        am->live_bytes = am->chunk_count = am->high_water = 0;
         if (i != 0) {
             amprev = &tbl[i-1];
             amprev->free_head = amprev->free_tail = NULL;
             amprev->used_head = amprev->used_tail = NULL;
             amprev->chunk_head = amprev->chunk_tail = NULL;
             amprev->blk_size = (am->blk_size + tbl[i-2].blk_size) >> 1;
+            amprev->live_bytes = amprev->chunk_count = amprev->high_water = 0;
         }
     }
 }
@@ -192,7 +386,7 @@ void mln_alloc_destroy(mln_alloc_t *pool)
     if (pool == NULL) return;
 
     mln_alloc_t *parent = pool->parent;
-    if (parent != NULL && mln_alloc_is_shm(parent))
+    if (parent != NULL && mln_alloc_shm_need_lock(parent))
         if (parent->lock(parent->locker) != 0)
             return;
     if (pool->mem == NULL) {
@@ -203,7 +397,7 @@ void mln_alloc_destroy(mln_alloc_t *pool)
             while ((ch = am->chunk_head) != NULL) {
                 mln_chunk_chain_del(&(am->chunk_head), &(am->chunk_tail), ch);
                 if (parent != NULL) mln_alloc_free(ch);
-                else free(ch);
+                else if (!mln_alloc_arena_contain(pool, ch)) free(ch);
             }
         }
         while ((ch = pool->large_used_head) != NULL) {
@@ -211,6 +405,14 @@ void mln_alloc_destroy(mln_alloc_t *pool)
             if (parent != NULL) mln_alloc_free(ch);
             else free(ch);
         }
+        if (pool->tcache_enabled) {
+            pool->tcache_enabled = 0;
+            pthread_mutex_destroy(&pool->tcache_lock);
+        }
+#if !defined(WIN32)
+        if (pool->arena != NULL)
+            munmap(pool->arena, pool->arena_size);
+#endif
         if (parent != NULL) mln_alloc_free(pool);
         else free(pool);
     } else {
@@ -222,11 +424,179 @@ void mln_alloc_destroy(mln_alloc_t *pool)
         munmap(pool->mem, pool->shm_size);
 #endif
     }
-    if (parent != NULL && mln_alloc_is_shm(parent))
+    if (parent != NULL && mln_alloc_shm_need_lock(parent))
         (void)parent->unlock(parent->locker);
 }
 
+/*
+ * thread-local magazines
+ * Small blocks are cached per thread in singly-linked freelists threaded
+ * through the block data itself; the pool lock is only taken to refill
+ * or flush a magazine in batches of M_ALLOC_TCACHE_BATCH.
+ */
+typedef struct {
+    void                     *head;
+    mln_u32_t                 count;
+} mln_alloc_tcache_class_t;
+
+typedef struct {
+    mln_alloc_t              *owner;
+    mln_alloc_tcache_class_t  classes[M_ALLOC_MGR_LEN];
+} mln_alloc_tcache_t;
+
+static __thread mln_alloc_tcache_t m_alloc_tcache;
+
+int mln_alloc_thread_cache_enable(mln_alloc_t *pool)
+{
+    if (pool->mem != NULL) return -1;
+    if (pool->tcache_enabled) return 0;
+    if (pthread_mutex_init(&pool->tcache_lock, NULL) != 0)
+        return -1;
+    pool->tcache_enabled = 1;
+    return 0;
+}
+
+static void *mln_alloc_tcache_m(mln_alloc_t *pool, mln_size_t size)
+{
+    int i;
+    void *ptr;
+    mln_alloc_mgr_t *am;
+    mln_alloc_tcache_t *tc = &m_alloc_tcache;
+    mln_alloc_tcache_class_t *cls;
+
+    am = mln_alloc_get_mgr_by_size(pool->mgr_tbl, size);
+    if (tc->owner == NULL) tc->owner = pool;
+    if (am == NULL || tc->owner != pool) {
+        pthread_mutex_lock(&pool->tcache_lock);
+        ptr = mln_alloc_heap_m(pool, size);
+        pthread_mutex_unlock(&pool->tcache_lock);
+        return ptr;
+    }
+
+    cls = &(tc->classes[am - pool->mgr_tbl]);
+    if (cls->head == NULL) {
+        pthread_mutex_lock(&pool->tcache_lock);
+        for (i = 0; i < M_ALLOC_TCACHE_BATCH; ++i) {
+            if ((ptr = mln_alloc_heap_m(pool, am->blk_size)) == NULL)
+                break;
+            *(void **)ptr = cls->head;
+            cls->head = ptr;
+            ++(cls->count);
+        }
+        pthread_mutex_unlock(&pool->tcache_lock);
+        if (cls->head == NULL) return NULL;
+    }
+    ptr = cls->head;
+    cls->head = *(void **)ptr;
+    --(cls->count);
+    return ptr;
+}
+
+static void mln_alloc_tcache_free(mln_alloc_t *pool, mln_alloc_blk_t *blk)
+{
+    int i;
+    void *ptr;
+    mln_alloc_tcache_t *tc = &m_alloc_tcache;
+    mln_alloc_tcache_class_t *cls;
+
+    if (blk->is_large || tc->owner != pool) {
+        pthread_mutex_lock(&pool->tcache_lock);
+        mln_alloc_heap_free(blk);
+        pthread_mutex_unlock(&pool->tcache_lock);
+        return;
+    }
+
+    cls = &(tc->classes[blk->chunk->mgr - pool->mgr_tbl]);
+    if (cls->count >= M_ALLOC_TCACHE_COUNT) {
+        pthread_mutex_lock(&pool->tcache_lock);
+        for (i = 0; i < M_ALLOC_TCACHE_BATCH && cls->head != NULL; ++i) {
+            ptr = cls->head;
+            cls->head = *(void **)ptr;
+            --(cls->count);
+            mln_alloc_heap_free((mln_alloc_blk_t *)((mln_u8ptr_t)ptr - sizeof(mln_alloc_blk_t)));
+        }
+        pthread_mutex_unlock(&pool->tcache_lock);
+    }
+    ptr = blk->data;
+    *(void **)ptr = cls->head;
+    cls->head = ptr;
+    ++(cls->count);
+}
+
+/*
+ * request-scoped reclamation
+ */
+void mln_alloc_reset(mln_alloc_t *pool)
+{
+    mln_alloc_mgr_t *am, *amend;
+    mln_alloc_chunk_t *ch;
+    mln_alloc_blk_t *blk;
+
+    if (pool->mem != NULL) return;
+    amend = pool->mgr_tbl + M_ALLOC_MGR_LEN;
+    for (am = pool->mgr_tbl; am < amend; ++am) {
+        while ((blk = am->used_head) != NULL) {
+            mln_blk_chain_del(&(am->used_head), &(am->used_tail), blk);
+            mln_blk_chain_add(&(am->free_head), &(am->free_tail), blk);
+            blk->in_used = 0;
+        }
+        for (ch = am->chunk_head; ch != NULL; ch = ch->next) {
+            ch->refer = 0;
+            ch->count = 0;
+        }
+    }
+    while ((ch = pool->large_used_head) != NULL) {
+        blk = (mln_alloc_blk_t *)((mln_u8ptr_t)ch + sizeof(mln_alloc_chunk_t));
+        mln_alloc_heap_free(blk);
+    }
+    pool->cp_epoch = 0;
+}
+
+mln_alloc_checkpoint_t mln_alloc_checkpoint(mln_alloc_t *pool)
+{
+    return ++(pool->cp_epoch);
+}
+
+void mln_alloc_rollback(mln_alloc_t *pool, mln_alloc_checkpoint_t cp)
+{
+    mln_alloc_mgr_t *am, *amend;
+    mln_alloc_chunk_t *ch, *next;
+    mln_alloc_blk_t *blk, *blk_next;
+    mln_size_t epoch = cp & 0x3fffffff;
+
+    if (pool->mem != NULL) return;
+    amend = pool->mgr_tbl + M_ALLOC_MGR_LEN;
+    for (am = pool->mgr_tbl; am < amend; ++am) {
+        for (blk = am->used_head; blk != NULL; blk = blk_next) {
+            blk_next = blk->next;
+            if (blk->padding >= epoch)
+                mln_alloc_heap_free(blk);
+        }
+    }
+    for (ch = pool->large_used_head; ch != NULL; ch = next) {
+        next = ch->next;
+        blk = (mln_alloc_blk_t *)((mln_u8ptr_t)ch + sizeof(mln_alloc_chunk_t));
+        if (blk->padding >= epoch)
+            mln_alloc_heap_free(blk);
+    }
+    pool->cp_epoch = epoch;
+}
+
 void *mln_alloc_m(mln_alloc_t *pool, mln_size_t size)
+{
+    if (mln_unlikely(pool->mem != NULL)) {
+        return mln_alloc_shm_m(pool, size);
+    }
+    if (mln_unlikely(pool->sample_handler != NULL && size >= pool->sample_threshold)) {
+        pool->sample_handler(pool, size, __builtin_return_address(0), pool->sample_data);
+    }
+    if (pool->tcache_enabled) {
+        return mln_alloc_tcache_m(pool, size);
+    }
+    return mln_alloc_heap_m(pool, size);
+}
+
+static void *mln_alloc_heap_m(mln_alloc_t *pool, mln_size_t size)
 {
     mln_alloc_blk_t *blk;
     mln_alloc_mgr_t *am;
@@ -234,22 +604,18 @@ void *mln_alloc_m(mln_alloc_t *pool, mln_size_t size)
     mln_u8ptr_t ptr;
     mln_size_t n;
 
-    if (pool->mem != NULL) {
-        return mln_alloc_shm_m(pool, size);
-    }
-
     am = mln_alloc_get_mgr_by_size(pool->mgr_tbl, size);
 
     if (am == NULL) {
         n = (size + sizeof(mln_alloc_blk_t) + sizeof(mln_alloc_chunk_t) + 3) >> 2;
         size = n << 2;
         if (pool->parent != NULL) {
-            if (mln_alloc_is_shm(pool->parent)) {
+            if (mln_alloc_shm_need_lock(pool->parent)) {
                 if (pool->parent->lock(pool->parent->locker) != 0)
                     return NULL;
             }
             ptr = (mln_u8ptr_t)mln_alloc_c(pool->parent, size);
-            if (mln_alloc_is_shm(pool->parent)) {
+            if (mln_alloc_shm_need_lock(pool->parent)) {
                 (void)pool->parent->unlock(pool->parent->locker);
             }
         } else {
@@ -266,7 +632,14 @@ void *mln_alloc_m(mln_alloc_t *pool, mln_size_t size)
         blk->blk_size = size - (sizeof(mln_alloc_chunk_t) + sizeof(mln_alloc_blk_t));
         blk->is_large = 1;
         blk->in_used = 1;
+        blk->padding = pool->cp_epoch;
         ch->blks[0] = blk;
+        if (pool->stats_enabled) {
+            pool->large_live += blk->blk_size;
+            ++(pool->large_count);
+            if (pool->large_live > pool->large_high)
+                pool->large_high = pool->large_live;
+        }
         return blk->data;
     }
 
@@ -277,16 +650,16 @@ void *mln_alloc_m(mln_alloc_t *pool, mln_size_t size)
         n = (sizeof(mln_alloc_chunk_t) + M_ALLOC_BLK_NUM * size + 3) >> 2;
 
         if (pool->parent != NULL) {
-            if (mln_alloc_is_shm(pool->parent)) {
+            if (mln_alloc_shm_need_lock(pool->parent)) {
                 if (pool->parent->lock(pool->parent->locker) != 0)
                     return NULL;
             }
             ptr = (mln_u8ptr_t)mln_alloc_c(pool->parent, n << 2);
-            if (mln_alloc_is_shm(pool->parent)) {
+            if (mln_alloc_shm_need_lock(pool->parent)) {
                 (void)pool->parent->unlock(pool->parent->locker);
             }
         } else {
-            ptr = (mln_u8ptr_t)calloc(1, n << 2);
+            ptr = mln_alloc_arena_carve(pool, n << 2);
         }
         if (ptr == NULL) {
             for (; am < pool->mgr_tbl + M_ALLOC_MGR_LEN; ++am) {
@@ -297,6 +670,7 @@ void *mln_alloc_m(mln_alloc_t *pool, mln_size_t size)
         ch = (mln_alloc_chunk_t *)ptr;
         ch->mgr = am;
         mln_chunk_chain_add(&(am->chunk_head), &(am->chunk_tail), ch);
+        if (pool->stats_enabled) ++(am->chunk_count);
         ptr += sizeof(mln_alloc_chunk_t);
         for (n = 0; n < M_ALLOC_BLK_NUM; ++n) {
             blk = (mln_alloc_blk_t *)ptr;
@@ -315,7 +689,13 @@ out:
     mln_blk_chain_del(&(am->free_head), &(am->free_tail), blk);
     mln_blk_chain_add(&(am->used_head), &(am->used_tail), blk);
     blk->in_used = 1;
+    blk->padding = pool->cp_epoch;
     ++(blk->chunk->refer);
+    if (pool->stats_enabled) {
+        am->live_bytes += am->blk_size;
+        if (am->live_bytes > am->high_water)
+            am->high_water = am->live_bytes;
+    }
     return blk->data;
 }
 
@@ -370,7 +750,93 @@ void *mln_alloc_re(mln_alloc_t *pool, void *ptr, mln_size_t size)
     if (new_ptr == NULL) return NULL;
     memcpy(new_ptr, ptr, old_blk->blk_size);
     mln_alloc_free(ptr);
-    
+
+    return new_ptr;
+}
+
+void *mln_alloc_adopt(mln_alloc_t *pool, void *ptr)
+{
+    mln_alloc_blk_t *blk, **blks;
+    mln_alloc_chunk_t *ch;
+    mln_alloc_mgr_t *sm, *dm;
+    mln_alloc_t *src;
+    mln_u8ptr_t new_ptr;
+
+    if (ptr == NULL) return NULL;
+    blk = (mln_alloc_blk_t *)((mln_u8ptr_t)ptr - sizeof(mln_alloc_blk_t));
+    ASSERT(blk->in_used);
+    src = blk->pool;
+    if (src == pool) return ptr;
+
+    /*
+     * Relinking requires both sides to free through the same backing:
+     * plain heap pools (or pools sharing one parent), no shm mapping
+     * and no thread-cache layer, whose chains a magazine may hold.
+     */
+    if (src->mem == NULL && pool->mem == NULL && \
+        !src->tcache_enabled && !pool->tcache_enabled && \
+        src->parent == pool->parent)
+    {
+        ch = blk->chunk;
+        if (blk->is_large) {
+            if (src->stats_enabled) {
+                src->large_live -= blk->blk_size;
+                --(src->large_count);
+            }
+            mln_chunk_chain_del(&(src->large_used_head), &(src->large_used_tail), ch);
+            mln_chunk_chain_add(&(pool->large_used_head), &(pool->large_used_tail), ch);
+            blk->pool = pool;
+            blk->padding = pool->cp_epoch;
+            if (pool->stats_enabled) {
+                pool->large_live += blk->blk_size;
+                ++(pool->large_count);
+                if (pool->large_live > pool->large_high)
+                    pool->large_high = pool->large_live;
+            }
+            return ptr;
+        }
+        /*
+         * Donor chunk: when this block is the only live one the whole
+         * chunk migrates, its free blocks joining the destination's
+         * freelist. Chunks carved from the source's arena stay put --
+         * that memory dies with the source pool.
+         */
+        if (ch->refer == 1 && !mln_alloc_arena_contain(src, ch)) {
+            sm = ch->mgr;
+            dm = mln_alloc_get_mgr_by_size(pool->mgr_tbl, sm->blk_size);
+            mln_blk_chain_del(&(sm->used_head), &(sm->used_tail), blk);
+            for (blks = ch->blks; *blks != NULL; ++blks) {
+                if (!(*blks)->in_used)
+                    mln_blk_chain_del(&(sm->free_head), &(sm->free_tail), *blks);
+                (*blks)->pool = pool;
+            }
+            mln_chunk_chain_del(&(sm->chunk_head), &(sm->chunk_tail), ch);
+            if (src->stats_enabled) {
+                sm->live_bytes -= sm->blk_size;
+                --(sm->chunk_count);
+            }
+            ch->mgr = dm;
+            mln_chunk_chain_add(&(dm->chunk_head), &(dm->chunk_tail), ch);
+            for (blks = ch->blks; *blks != NULL; ++blks) {
+                if (!(*blks)->in_used)
+                    mln_blk_chain_add(&(dm->free_head), &(dm->free_tail), *blks);
+            }
+            mln_blk_chain_add(&(dm->used_head), &(dm->used_tail), blk);
+            blk->padding = pool->cp_epoch;
+            if (pool->stats_enabled) {
+                ++(dm->chunk_count);
+                dm->live_bytes += dm->blk_size;
+                if (dm->live_bytes > dm->high_water)
+                    dm->high_water = dm->live_bytes;
+            }
+            return ptr;
+        }
+    }
+
+    if ((new_ptr = (mln_u8ptr_t)mln_alloc_m(pool, blk->blk_size)) == NULL)
+        return NULL;
+    memcpy(new_ptr, ptr, blk->blk_size);
+    mln_alloc_free(ptr);
     return new_ptr;
 }
 
@@ -381,8 +847,6 @@ void mln_alloc_free(void *ptr)
     }
 
     mln_alloc_t *pool;
-    mln_alloc_chunk_t *ch;
-    mln_alloc_mgr_t *am;
     mln_alloc_blk_t *blk;
 
     blk = (mln_alloc_blk_t *)((mln_u8ptr_t)ptr - sizeof(mln_alloc_blk_t));
@@ -393,17 +857,33 @@ void mln_alloc_free(void *ptr)
     if (pool->mem) {
         return mln_alloc_free_shm(ptr);
     }
+    if (pool->tcache_enabled) {
+        return mln_alloc_tcache_free(pool, blk);
+    }
+    mln_alloc_heap_free(blk);
+}
 
+static void mln_alloc_heap_free(mln_alloc_blk_t *blk)
+{
+    mln_alloc_t *pool;
+    mln_alloc_chunk_t *ch;
+    mln_alloc_mgr_t *am;
+
+    pool = blk->pool;
     if (blk->is_large) {
+        if (pool->stats_enabled) {
+            pool->large_live -= blk->blk_size;
+            --(pool->large_count);
+        }
         mln_chunk_chain_del(&(pool->large_used_head), &(pool->large_used_tail), blk->chunk);
         if (pool->parent != NULL) {
-            if (mln_alloc_is_shm(pool->parent)) {
+            if (mln_alloc_shm_need_lock(pool->parent)) {
                 if (pool->parent->lock(pool->parent->locker) != 0) {
                     return;
                 }
             }
             mln_alloc_free(blk->chunk);
-            if (mln_alloc_is_shm(pool->parent)) {
+            if (mln_alloc_shm_need_lock(pool->parent)) {
                 (void)pool->parent->unlock(pool->parent->locker);
             }
         } else
@@ -415,20 +895,24 @@ void mln_alloc_free(void *ptr)
     blk->in_used = 0;
     mln_blk_chain_del(&(am->used_head), &(am->used_tail), blk);
     mln_blk_chain_add(&(am->free_head), &(am->free_tail), blk);
-    if (!--(ch->refer) && ++(ch->count) > M_ALLOC_CHUNK_COUNT) {
+    if (pool->stats_enabled) am->live_bytes -= am->blk_size;
+    if (!--(ch->refer) && ++(ch->count) > M_ALLOC_CHUNK_COUNT && \
+        !mln_alloc_arena_contain(pool, ch))
+    {
         mln_alloc_blk_t **blks = ch->blks;
         while (*blks != NULL) {
             mln_blk_chain_del(&(am->free_head), &(am->free_tail), *(blks++));
         }
         mln_chunk_chain_del(&(am->chunk_head), &(am->chunk_tail), ch);
+        if (pool->stats_enabled) --(am->chunk_count);
         if (pool->parent != NULL) {
-            if (mln_alloc_is_shm(pool->parent)) {
+            if (mln_alloc_shm_need_lock(pool->parent)) {
                 if (pool->parent->lock(pool->parent->locker) != 0) {
                     return;
                 }
             }
             mln_alloc_free(ch);
-            if (mln_alloc_is_shm(pool->parent)) {
+            if (mln_alloc_shm_need_lock(pool->parent)) {
                 (void)pool->parent->unlock(pool->parent->locker);
             }
         } else
@@ -437,6 +921,14 @@ void mln_alloc_free(void *ptr)
 }
 
 static inline void *mln_alloc_shm_m(mln_alloc_t *pool, mln_size_t size)
+{
+    if (pool->shm_lockfree) {
+        return mln_alloc_shm_lockfree_m(pool, size);
+    }
+    return mln_alloc_shm_m_locked(pool, size);
+}
+
+static inline void *mln_alloc_shm_m_locked(mln_alloc_t *pool, mln_size_t size)
 {
     mln_alloc_shm_t *as;
     mln_off_t Boff = -1, boff = -1;
@@ -568,6 +1060,31 @@ static inline void *mln_alloc_shm_set_bitmap(mln_alloc_shm_t *as, mln_off_t Boff
 }
 
 static inline void mln_alloc_free_shm(void *ptr)
+{
+    int idx;
+    mln_alloc_blk_t *blk;
+    mln_alloc_shm_t *as;
+    mln_alloc_t *pool;
+
+    blk = (mln_alloc_blk_t *)((mln_u8ptr_t)ptr - sizeof(mln_alloc_blk_t));
+    as = (mln_alloc_shm_t *)(blk->chunk);
+    pool = as->pool;
+    if (pool->shm_lockfree) {
+        idx = blk->is_large? -1: mln_alloc_shm_cls_index(blk->blk_size);
+        if (idx >= 0) {
+            blk->in_used = 0;
+            mln_alloc_shm_cls_push(pool, idx, blk);
+            return;
+        }
+        if (pool->lock(pool->locker) != 0) return;
+        mln_alloc_free_shm_locked(ptr);
+        (void)pool->unlock(pool->locker);
+        return;
+    }
+    mln_alloc_free_shm_locked(ptr);
+}
+
+static inline void mln_alloc_free_shm_locked(void *ptr)
 {
     mln_alloc_blk_t *blk;
     mln_alloc_shm_t *as;
@@ -22,6 +22,21 @@ int mln_array_init(mln_array_t *arr, struct mln_array_attr *attr)
     return mln_array_alloc(arr, arr->nalloc);
 }
 
+int mln_array_inline_init(mln_array_t *arr, struct mln_array_attr *attr)
+{
+    if (attr->size == 0 || attr->size > M_ARRAY_INLINE_SIZE)
+        return mln_array_init(arr, attr);
+    arr->elts = arr->inline_buf;
+    arr->size = attr->size;
+    arr->nalloc = M_ARRAY_INLINE_SIZE / attr->size;
+    arr->nelts = 0;
+    arr->pool = attr->pool;
+    arr->pool_alloc = attr->pool_alloc;
+    arr->pool_free = attr->pool_free;
+    arr->free = attr->free;
+    return 0;
+}
+
 mln_array_t *mln_array_new(struct mln_array_attr *attr)
 {
     mln_array_t *arr;
@@ -52,6 +67,8 @@ void mln_array_destroy(mln_array_t *arr)
             arr->free(p);
     }
 
+    if (arr->elts == (void *)(arr->inline_buf))
+        return;
     if (arr->pool != NULL)
         arr->pool_free(arr->elts);
     else
@@ -69,10 +86,12 @@ void mln_array_free(mln_array_t *arr)
     }
 
     if (arr->pool != NULL) {
-        arr->pool_free(arr->elts);
+        if (arr->elts != (void *)(arr->inline_buf))
+            arr->pool_free(arr->elts);
         arr->pool_free(arr);
     } else {
-        free(arr->elts);
+        if (arr->elts != (void *)(arr->inline_buf))
+            free(arr->elts);
         free(arr);
     }
 }
@@ -114,29 +133,57 @@ void *mln_array_pushn(mln_array_t *arr, mln_size_t n)
 static inline int mln_array_alloc(mln_array_t *arr, mln_size_t n)
 {
     mln_u8ptr_t ptr;
-    mln_size_t num = arr->nalloc;
-    while (n + arr->nelts > num) {
-        num <<= 1;
-    }
+    mln_size_t num, need = n + arr->nelts;
+
+    /*power-of-two growth*/
+    for (num = 1; num < need || num < arr->nalloc; num <<= 1)
+        ;
+    if (num <= arr->nalloc && arr->elts != NULL)
+        return 0;
+
     if (arr->pool != NULL) {
-        ptr = arr->pool_alloc(arr->pool, num * arr->size);
+        if ((ptr = arr->pool_alloc(arr->pool, num * arr->size)) == NULL)
+            return -1;
+        if (arr->nelts)
+            memcpy(ptr, arr->elts, arr->nelts * arr->size);
+        if (arr->elts != NULL && arr->elts != (void *)(arr->inline_buf))
+            arr->pool_free(arr->elts);
+    } else if (arr->elts == (void *)(arr->inline_buf)) {
+        if ((ptr = malloc(num * arr->size)) == NULL)
+            return -1;
+        if (arr->nelts)
+            memcpy(ptr, arr->elts, arr->nelts * arr->size);
     } else {
-        ptr = malloc(num * arr->size);
+        /*realloc may extend in place and skip the copy*/
+        if ((ptr = realloc(arr->elts, num * arr->size)) == NULL)
+            return -1;
     }
-    if (ptr == NULL)
-        return -1;
-
-    memcpy(ptr, arr->elts, arr->nelts * arr->size);
-    if (arr->pool != NULL)
-        arr->pool_free(arr->elts);
-    else
-        free(arr->elts);
     arr->elts = ptr;
     arr->nalloc = num;
 
     return 0;
 }
 
+int mln_array_reserve(mln_array_t *arr, mln_size_t n)
+{
+    if (n <= arr->nalloc && arr->elts != NULL)
+        return 0;
+    return mln_array_alloc(arr, n > arr->nelts? n - arr->nelts: 0);
+}
+
+void *mln_array_push_move(mln_array_t *arr, void *elt)
+{
+    void *slot = mln_array_push(arr);
+
+    if (slot == NULL) return NULL;
+    memcpy(slot, elt, arr->size);
+    if (arr->pool != NULL)
+        arr->pool_free(elt);
+    else
+        free(elt);
+    return slot;
+}
+
 void mln_array_pop(mln_array_t *arr)
 {
     if (arr == NULL || !arr->nelts)
@@ -203,6 +203,77 @@ inc:
     return res;
 }
 
+/*
+ * walk
+ */
+void mln_asn1_walk_init(mln_asn1_walk_t *w, void *data, mln_u64_t len)
+{
+    w->pos = (mln_u8ptr_t)data;
+    w->end = w->pos + len;
+}
+
+int mln_asn1_walk_next(mln_asn1_walk_t *w, mln_asn1_node_t *node)
+{
+    mln_u8ptr_t p = w->pos, start = w->pos;
+    mln_u8_t ch;
+    mln_u64_t length = 0;
+
+    if (p >= w->end) return M_ASN1_RET_DONE;
+    if (w->end - p < 2) return M_ASN1_RET_INCOMPLETE;
+
+    /*Tag -- not support high-tag-number-form*/
+    ch = *p++;
+    node->_class = (ch >> 6) & 0x3;
+    node->is_struct = (ch >> 5) & 0x1;
+    node->ident = ch & 0x1f;
+
+    /*length -- Don't support more than 8-byte length.*/
+    ch = *p++;
+    if (ch & 0x80) {
+        mln_u8_t n = ch & 0x7f;
+        if (n > sizeof(mln_u64_t)) return M_ASN1_RET_ERROR;
+        if (w->end - p < n) return M_ASN1_RET_INCOMPLETE;
+        for (; n > 0; --n) {
+            length = (length << 8) | *p++;
+        }
+    } else {
+        length = ch;
+    }
+    if ((mln_u64_t)(w->end - p) < length) return M_ASN1_RET_INCOMPLETE;
+
+    node->content.data = p;
+    node->content.len = length;
+    node->content.data_ref = 1;
+    node->content.pool = 0;
+    node->content.ref = 1;
+    node->code.data = start;
+    node->code.len = (p - start) + length;
+    node->code.data_ref = 1;
+    node->code.pool = 0;
+    node->code.ref = 1;
+
+    w->pos = p + length;
+    return M_ASN1_RET_OK;
+}
+
+void mln_asn1_walk_in(mln_asn1_walk_t *w, mln_asn1_node_t *node)
+{
+    w->pos = node->content.data;
+    w->end = node->content.data + node->content.len;
+}
+
+int mln_asn1_node_child(mln_asn1_node_t *parent, mln_u32_t index, mln_asn1_node_t *out)
+{
+    mln_asn1_walk_t w;
+    int rc;
+
+    mln_asn1_walk_in(&w, parent);
+    do {
+        if ((rc = mln_asn1_walk_next(&w, out)) != M_ASN1_RET_OK) return rc;
+    } while (index--);
+    return M_ASN1_RET_OK;
+}
+
 mln_asn1_deresult_t *mln_asn1_deresult_content_get(mln_asn1_deresult_t *res, mln_u32_t index)
 {
     if (res->contents == NULL) return NULL;
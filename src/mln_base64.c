@@ -4,70 +4,189 @@
  */
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "mln_base64.h"
+#include "mln_chain.h"
+
+/*
+ * SIMD base64: the usual shuffle-based codec (split packed 24-bit
+ * groups into 6-bit indices with multiplies/shuffles, then translate
+ * with an in-register lookup), 12 input bytes per iteration on x86-64
+ * and 48 on aarch64 NEON. Support is detected at runtime and the
+ * byte-at-a-time code below remains the fallback and finishes tails
+ * and padding. Decoding falls back as soon as a byte outside the
+ * alphabet shows up, so '=' handling stays in one place.
+ */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define MLN_BASE64_HW_X86 1
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define MLN_BASE64_HW_ARM 1
+#include <arm_neon.h>
+#endif
 
 static mln_s8_t base_map[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-int mln_base64_encode(mln_u8ptr_t in, mln_uauto_t inlen, \
-                      mln_u8ptr_t *out, mln_uauto_t *outlen)
+#if defined(MLN_BASE64_HW_X86)
+static int mln_base64_hw_support(void)
 {
-    mln_uauto_t i, state, j;
+    static int support = -1;
+    if (support < 0) {
+        support = (__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1"))? 1: 0;
+    }
+    return support;
+}
 
-    *outlen = inlen / 3 * 4;
-    if (inlen % 3) (*outlen) += 4;
+/*returns the number of input bytes consumed; always a multiple of 3*/
+__attribute__((target("ssse3,sse4.1"))) static mln_uauto_t
+mln_base64_hw_encode(mln_u8ptr_t in, mln_uauto_t inlen, mln_u8ptr_t o)
+{
+    mln_uauto_t i = 0, j = 0;
+    __m128i x, t, indices, result, less;
+    const __m128i shuf = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i shift_lut = _mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
 
-    *out = (mln_u8ptr_t)calloc(1, *outlen + 1);
-    if (*out == NULL) return -1;
+    while (i + 16 <= inlen) {
+        x = _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)(in + i)), shuf);
+        t = _mm_mulhi_epu16(_mm_and_si128(x, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+        x = _mm_mullo_epi16(_mm_and_si128(x, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+        indices = _mm_or_si128(t, x);
+        result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+        result = _mm_add_epi8(_mm_shuffle_epi8(shift_lut, result), indices);
+        _mm_storeu_si128((__m128i *)(o + j), result);
+        i += 12;
+        j += 16;
+    }
+    return i;
+}
 
-    mln_u8ptr_t o = *out;
+/*returns the number of input bytes consumed; always a multiple of 4*/
+__attribute__((target("ssse3,sse4.1"))) static mln_uauto_t
+mln_base64_hw_decode(mln_u8ptr_t in, mln_uauto_t inlen, mln_u8ptr_t o)
+{
+    mln_uauto_t i = 0, j = 0;
+    mln_u8_t tmp[16];
+    __m128i x, higher, lower, sh, shift, m, bit;
+    const __m128i shift_lut = _mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_lut = _mm_setr_epi8(
+        (char)0xa8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8,
+        (char)0xf8, (char)0xf8, (char)0xf0, 0x54, 0x50, 0x50, 0x50, 0x54);
+    const __m128i bitpos_lut = _mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i pack_shuf = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
 
-    for (i = 0, state = 0, j = 0; i < inlen; ++j) {
-        if (state == 0) {
-            o[j] = (mln_u8_t)base_map[(in[i] >> 2) & 0x3f];
-            state = 1;
-        } else if (state == 1) {
-            if (i+1 >= inlen) {
-                o[j++] = (mln_u8_t)base_map[(in[i] & 0x3) << 4];
-                o[j++] = (mln_u8_t)'=';
-                o[j] = (mln_u8_t)'=';
-                break;
-            } else {
-                o[j] = (mln_u8_t)base_map[((in[i] & 0x3) << 4)|((in[i+1] >> 4) & 0xf)];
-                ++i;
-                state = 2;
-            }
-        } else {
-            if (i+1 >= inlen) {
-                o[j++] = (mln_u8_t)base_map[((in[i] & 0xf) << 2)];
-                o[j] = (mln_u8_t)'=';
-                break;
-            } else {
-                o[j++] = (mln_u8_t)base_map[((in[i] & 0xf) << 2)|((in[i+1] >> 6) & 0x3)];
-                o[j] = (mln_u8_t)base_map[in[++i] & 0x3f];
-                ++i;
-                state = 0;
-            }
+    while (i + 16 <= inlen) {
+        x = _mm_loadu_si128((__m128i *)(in + i));
+        higher = _mm_and_si128(_mm_srli_epi32(x, 4), _mm_set1_epi8(0x0f));
+        lower = _mm_and_si128(x, _mm_set1_epi8(0x0f));
+        m = _mm_shuffle_epi8(mask_lut, lower);
+        bit = _mm_shuffle_epi8(bitpos_lut, higher);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(m, bit), _mm_setzero_si128()))) {
+            break; /*padding or a stray byte, the scalar loop deals with it*/
         }
+        sh = _mm_shuffle_epi8(shift_lut, higher);
+        shift = _mm_blendv_epi8(sh, _mm_set1_epi8(16), _mm_cmpeq_epi8(x, _mm_set1_epi8(0x2f)));
+        x = _mm_add_epi8(x, shift);
+        x = _mm_maddubs_epi16(x, _mm_set1_epi32(0x01400140));
+        x = _mm_madd_epi16(x, _mm_set1_epi32(0x00011000));
+        _mm_storeu_si128((__m128i *)tmp, _mm_shuffle_epi8(x, pack_shuf));
+        memcpy(o + j, tmp, 12);
+        i += 16;
+        j += 12;
     }
+    return i;
+}
+#elif defined(MLN_BASE64_HW_ARM)
+static int mln_base64_hw_support(void)
+{
+    return 1; /*NEON is baseline on aarch64*/
+}
 
-    return 0;
+static mln_uauto_t mln_base64_hw_encode(mln_u8ptr_t in, mln_uauto_t inlen, mln_u8ptr_t o)
+{
+    mln_uauto_t i = 0, j = 0;
+    uint8x16x3_t x;
+    uint8x16x4_t r, tbl;
+
+    tbl.val[0] = vld1q_u8((uint8_t *)base_map);
+    tbl.val[1] = vld1q_u8((uint8_t *)base_map + 16);
+    tbl.val[2] = vld1q_u8((uint8_t *)base_map + 32);
+    tbl.val[3] = vld1q_u8((uint8_t *)base_map + 48);
+
+    while (i + 48 <= inlen) {
+        x = vld3q_u8(in + i);
+        r.val[0] = vqtbl4q_u8(tbl, vshrq_n_u8(x.val[0], 2));
+        r.val[1] = vqtbl4q_u8(tbl, vorrq_u8(vshlq_n_u8(vandq_u8(x.val[0], vdupq_n_u8(0x03)), 4), vshrq_n_u8(x.val[1], 4)));
+        r.val[2] = vqtbl4q_u8(tbl, vorrq_u8(vshlq_n_u8(vandq_u8(x.val[1], vdupq_n_u8(0x0f)), 2), vshrq_n_u8(x.val[2], 6)));
+        r.val[3] = vqtbl4q_u8(tbl, vandq_u8(x.val[2], vdupq_n_u8(0x3f)));
+        vst4q_u8(o + j, r);
+        i += 48;
+        j += 64;
+    }
+    return i;
 }
 
-int mln_base64_pool_encode(mln_alloc_t *pool, \
-                           mln_u8ptr_t in, mln_uauto_t inlen, \
-                           mln_u8ptr_t *out, mln_uauto_t *outlen)
+/*map one lane of characters to sextets; 0xff marks bytes outside the alphabet*/
+static inline uint8x16_t mln_base64_hw_sextet(uint8x16_t c, uint8x16_t *invalid)
 {
-    mln_uauto_t i, state, j;
+    uint8x16_t az, lz, dg, pl, sl, r;
 
-    *outlen = inlen / 3 * 4;
-    if (inlen % 3) (*outlen) += 4;
+    az = vandq_u8(vcgeq_u8(c, vdupq_n_u8('A')), vcleq_u8(c, vdupq_n_u8('Z')));
+    lz = vandq_u8(vcgeq_u8(c, vdupq_n_u8('a')), vcleq_u8(c, vdupq_n_u8('z')));
+    dg = vandq_u8(vcgeq_u8(c, vdupq_n_u8('0')), vcleq_u8(c, vdupq_n_u8('9')));
+    pl = vceqq_u8(c, vdupq_n_u8('+'));
+    sl = vceqq_u8(c, vdupq_n_u8('/'));
+    r = vandq_u8(az, vsubq_u8(c, vdupq_n_u8('A')));
+    r = vorrq_u8(r, vandq_u8(lz, vsubq_u8(c, vdupq_n_u8('a' - 26))));
+    r = vorrq_u8(r, vandq_u8(dg, vsubq_u8(c, vdupq_n_u8('0' - 52))));
+    r = vorrq_u8(r, vandq_u8(pl, vdupq_n_u8(62)));
+    r = vorrq_u8(r, vandq_u8(sl, vdupq_n_u8(63)));
+    *invalid = vorrq_u8(*invalid, vmvnq_u8(vorrq_u8(vorrq_u8(vorrq_u8(az, lz), dg), vorrq_u8(pl, sl))));
+    return r;
+}
 
-    *out = (mln_u8ptr_t)mln_alloc_c(pool, *outlen + 1);
-    if (*out == NULL) return -1;
+static mln_uauto_t mln_base64_hw_decode(mln_u8ptr_t in, mln_uauto_t inlen, mln_u8ptr_t o)
+{
+    mln_uauto_t i = 0, j = 0;
+    uint8x16x4_t x;
+    uint8x16x3_t r;
+    uint8x16_t s0, s1, s2, s3, invalid;
 
-    mln_u8ptr_t o = *out;
+    while (i + 64 <= inlen) {
+        x = vld4q_u8(in + i);
+        invalid = vdupq_n_u8(0);
+        s0 = mln_base64_hw_sextet(x.val[0], &invalid);
+        s1 = mln_base64_hw_sextet(x.val[1], &invalid);
+        s2 = mln_base64_hw_sextet(x.val[2], &invalid);
+        s3 = mln_base64_hw_sextet(x.val[3], &invalid);
+        if (vmaxvq_u8(invalid)) {
+            break; /*padding or a stray byte, the scalar loop deals with it*/
+        }
+        r.val[0] = vorrq_u8(vshlq_n_u8(s0, 2), vshrq_n_u8(s1, 4));
+        r.val[1] = vorrq_u8(vshlq_n_u8(s1, 4), vshrq_n_u8(s2, 2));
+        r.val[2] = vorrq_u8(vshlq_n_u8(s2, 6), s3);
+        vst3q_u8(o + j, r);
+        i += 64;
+        j += 48;
+    }
+    return i;
+}
+#endif
+
+static void mln_base64_encode_core(mln_u8ptr_t in, mln_uauto_t inlen, mln_u8ptr_t o)
+{
+    mln_uauto_t i = 0, state, j = 0;
 
-    for (i = 0, state = 0, j = 0; i < inlen; ++j) {
+#if defined(MLN_BASE64_HW_X86) || defined(MLN_BASE64_HW_ARM)
+    if (mln_base64_hw_support()) {
+        i = mln_base64_hw_encode(in, inlen, o);
+        j = i / 3 * 4;
+    }
+#endif
+    for (state = 0; i < inlen; ++j) {
         if (state == 0) {
             o[j] = (mln_u8_t)base_map[(in[i] >> 2) & 0x3f];
             state = 1;
@@ -95,31 +214,25 @@ int mln_base64_pool_encode(mln_alloc_t *pool, \
             }
         }
     }
-
-    return 0;
 }
 
-int mln_base64_decode(mln_u8ptr_t in, mln_uauto_t inlen, \
-                      mln_u8ptr_t *out, mln_uauto_t *outlen)
+static void mln_base64_decode_core(mln_u8ptr_t in, mln_uauto_t inlen, mln_u8ptr_t o)
 {
-    if (inlen % 4) return -1;
-
     mln_u8_t ascii[256] = {0};
-    mln_uauto_t i, state, j;
+    mln_uauto_t i, state, j = 0;
 
     for (i = 0; i < 64; ++i) {
         ascii[(mln_u8_t)base_map[i]] = i;
     }
 
-    *outlen = inlen / 4 * 3;
-    if (in[inlen-1] == '=') --(*outlen);
-    if (in[inlen-2] == '=') --(*outlen);
-
-    *out = (mln_u8ptr_t)calloc(1, *outlen + 1);
-    if (*out == NULL) return -1;
-    mln_u8ptr_t o = *out;
-
-    for (i = 0, state = 0, j = 0; i < inlen; ) {
+    i = 0;
+#if defined(MLN_BASE64_HW_X86) || defined(MLN_BASE64_HW_ARM)
+    if (mln_base64_hw_support()) {
+        i = mln_base64_hw_decode(in, inlen, o);
+        j = i / 4 * 3;
+    }
+#endif
+    for (state = 0; i < inlen; ) {
         if (state == 0) {
             o[j] = (ascii[in[i]] << 2);
             state = 1;
@@ -146,22 +259,90 @@ int mln_base64_decode(mln_u8ptr_t in, mln_uauto_t inlen, \
             ++i;
         }
     }
+}
+
+int mln_base64_encode(mln_u8ptr_t in, mln_uauto_t inlen, \
+                      mln_u8ptr_t *out, mln_uauto_t *outlen)
+{
+    *outlen = inlen / 3 * 4;
+    if (inlen % 3) (*outlen) += 4;
+
+    *out = (mln_u8ptr_t)calloc(1, *outlen + 1);
+    if (*out == NULL) return -1;
+
+    mln_base64_encode_core(in, inlen, *out);
 
     return 0;
 }
 
-int mln_base64_pool_decode(mln_alloc_t *pool, \
+int mln_base64_pool_encode(mln_alloc_t *pool, \
                            mln_u8ptr_t in, mln_uauto_t inlen, \
                            mln_u8ptr_t *out, mln_uauto_t *outlen)
 {
-    if (inlen % 4) return -1;
+    *outlen = inlen / 3 * 4;
+    if (inlen % 3) (*outlen) += 4;
 
-    mln_u8_t ascii[256] = {0};
-    mln_uauto_t i, state, j;
+    *out = (mln_u8ptr_t)mln_alloc_c(pool, *outlen + 1);
+    if (*out == NULL) return -1;
 
-    for (i = 0; i < 64; ++i) {
-        ascii[(mln_u8_t)base_map[i]] = i;
+    mln_base64_encode_core(in, inlen, *out);
+
+    return 0;
+}
+
+mln_chain_t *mln_base64_chain_encode(mln_alloc_t *pool, mln_u8ptr_t in, mln_uauto_t inlen)
+{
+    mln_chain_t *c;
+    mln_buf_t *b;
+    mln_u8ptr_t buf;
+    mln_uauto_t outlen = inlen / 3 * 4;
+
+    if (inlen % 3) outlen += 4;
+
+    c = mln_chain_new(pool);
+    if (c == NULL) return NULL;
+    b = mln_buf_new(pool);
+    if (b == NULL) {
+        mln_chain_pool_release(c);
+        return NULL;
+    }
+    c->buf = b;
+    buf = (mln_u8ptr_t)mln_alloc_m(pool, outlen);
+    if (buf == NULL) {
+        mln_chain_pool_release(c);
+        return NULL;
     }
+    mln_base64_encode_core(in, inlen, buf);
+    b->left_pos = b->pos = b->start = buf;
+    b->end = b->last = buf + outlen;
+    b->in_memory = 1;
+    b->last_buf = 1;
+
+    return c;
+}
+
+int mln_base64_decode(mln_u8ptr_t in, mln_uauto_t inlen, \
+                      mln_u8ptr_t *out, mln_uauto_t *outlen)
+{
+    if (inlen % 4) return -1;
+
+    *outlen = inlen / 4 * 3;
+    if (in[inlen-1] == '=') --(*outlen);
+    if (in[inlen-2] == '=') --(*outlen);
+
+    *out = (mln_u8ptr_t)calloc(1, *outlen + 1);
+    if (*out == NULL) return -1;
+
+    mln_base64_decode_core(in, inlen, *out);
+
+    return 0;
+}
+
+int mln_base64_pool_decode(mln_alloc_t *pool, \
+                           mln_u8ptr_t in, mln_uauto_t inlen, \
+                           mln_u8ptr_t *out, mln_uauto_t *outlen)
+{
+    if (inlen % 4) return -1;
 
     *outlen = inlen / 4 * 3;
     if (in[inlen-1] == '=') --(*outlen);
@@ -169,35 +350,8 @@ int mln_base64_pool_decode(mln_alloc_t *pool, \
 
     *out = (mln_u8ptr_t)mln_alloc_c(pool, *outlen + 1);
     if (*out == NULL) return -1;
-    mln_u8ptr_t o = *out;
 
-    for (i = 0, state = 0, j = 0; i < inlen; ) {
-        if (state == 0) {
-            o[j] = (ascii[in[i]] << 2);
-            state = 1;
-            ++i;
-        } else if (state == 1) {
-            o[j++] |= ((ascii[in[i]] >> 4) & 0x3);
-            state = 2;
-        } else if (state == 2) {
-            o[j] = (ascii[in[i]] & 0xf) << 4;
-            state = 3;
-            ++i;
-        } else if (state == 3) {
-            if (in[i] == '=') break;
-            o[j++] |= ((ascii[in[i]] >> 2) & 0xf);
-            state = 4;
-        } else if (state == 4) {
-            o[j] = (ascii[in[i]] & 0x3) << 6;
-            state = 5;
-            ++i;
-        } else {
-            if (in[i] == '=') break;
-            o[j++] |= (ascii[in[i]] & 0x3f);
-            state = 0;
-            ++i;
-        }
-    }
+    mln_base64_decode_core(in, inlen, *out);
 
     return 0;
 }
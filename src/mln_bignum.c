@@ -79,6 +79,39 @@ void mln_bignum_pool_free(mln_bignum_t *bn)
     mln_alloc_free(bn);
 }
 
+void mln_bignum_scratch_init(mln_bignum_scratch_t *sc, mln_bignum_t *base, mln_u32_t n)
+{
+    sc->base = base;
+    sc->size = n;
+    sc->pos = 0;
+}
+
+mln_bignum_scratch_t *mln_bignum_scratch_pool_new(mln_alloc_t *pool, mln_u32_t n)
+{
+    mln_bignum_scratch_t *sc;
+
+    sc = (mln_bignum_scratch_t *)mln_alloc_m(pool, sizeof(mln_bignum_scratch_t) + n * sizeof(mln_bignum_t));
+    if (sc == NULL) return NULL;
+    mln_bignum_scratch_init(sc, (mln_bignum_t *)(sc + 1), n);
+    return sc;
+}
+
+void mln_bignum_scratch_pool_free(mln_bignum_scratch_t *sc)
+{
+    if (sc == NULL) return;
+    mln_alloc_free(sc);
+}
+
+mln_bignum_t *mln_bignum_scratch_alloc(mln_bignum_scratch_t *sc)
+{
+    mln_bignum_t *bn;
+
+    if (sc->pos >= sc->size) return NULL;
+    bn = &sc->base[sc->pos++];
+    memset(bn, 0, sizeof(mln_bignum_t));
+    return bn;
+}
+
 mln_bignum_t *mln_bignum_dup(mln_bignum_t *bn)
 {
     mln_bignum_t *target = (mln_bignum_t *)malloc(sizeof(mln_bignum_t));
@@ -386,6 +419,117 @@ static inline void __mln_bignum_sub_core(mln_bignum_t *dest, mln_bignum_t *src)
     dest->length = (end < dest_data)? 0: end - dest_data + 1;
 }
 
+/*
+ * Karatsuba multiplication on raw limb arrays (32-bit limbs held in
+ * mln_u64_t slots). Below the threshold the schoolbook loop is faster
+ * because of the splitting overhead. Toom-3 is deliberately left out:
+ * with the library capped at M_BIGNUM_BITS its crossover is barely
+ * reached, so the extra interpolation code would never pay off.
+ */
+#define M_BIGNUM_KARATSUBA_MIN 24
+
+static void
+mln_bignum_nmul_school(mln_u64_t *r, mln_u64_t *a, mln_u64_t *b, mln_u32_t n)
+{
+    mln_u32_t i, j;
+    mln_u64_t carry, tmp;
+
+    memset(r, 0, (n << 1) * sizeof(mln_u64_t));
+    for (i = 0; i < n; ++i) {
+        if (a[i] == 0) continue;
+        carry = 0;
+        for (j = 0; j < n; ++j) {
+            tmp = a[i] * b[j] + r[i + j] + carry;
+            r[i + j] = tmp % M_BIGNUM_UMAX;
+            carry = tmp >> M_BIGNUM_SHIFT;
+        }
+        r[i + n] = carry;
+    }
+}
+
+static inline void
+mln_bignum_nadd_ext(mln_u64_t *r, mln_u64_t *a, mln_u32_t an, mln_u32_t rn)
+{
+    /*r += a, carry propagated through the rn limbs of r*/
+    mln_u64_t carry = 0, tmp;
+    mln_u32_t i;
+
+    for (i = 0; i < an; ++i) {
+        tmp = r[i] + a[i] + carry;
+        r[i] = tmp % M_BIGNUM_UMAX;
+        carry = tmp >> M_BIGNUM_SHIFT;
+    }
+    for (; carry && i < rn; ++i) {
+        tmp = r[i] + carry;
+        r[i] = tmp % M_BIGNUM_UMAX;
+        carry = tmp >> M_BIGNUM_SHIFT;
+    }
+}
+
+static inline void
+mln_bignum_nsub_ext(mln_u64_t *r, mln_u64_t *a, mln_u32_t an, mln_u32_t rn)
+{
+    /*r -= a, r is known to be >= a*/
+    mln_u64_t borrow = 0;
+    mln_u32_t i;
+
+    for (i = 0; i < an; ++i) {
+        if (r[i] < a[i] + borrow) {
+            r[i] = r[i] + M_BIGNUM_UMAX - a[i] - borrow;
+            borrow = 1;
+        } else {
+            r[i] -= (a[i] + borrow);
+            borrow = 0;
+        }
+    }
+    for (; borrow && i < rn; ++i) {
+        if (r[i] < borrow) {
+            r[i] = r[i] + M_BIGNUM_UMAX - borrow;
+        } else {
+            r[i] -= borrow;
+            borrow = 0;
+        }
+    }
+}
+
+static void
+mln_bignum_kmul(mln_u64_t *r, mln_u64_t *a, mln_u64_t *b, mln_u32_t n, mln_u64_t *ws)
+{
+    mln_u32_t h, k;
+    mln_u64_t *sa, *sb, *z1, *wsn;
+
+    if (n < M_BIGNUM_KARATSUBA_MIN) {
+        mln_bignum_nmul_school(r, a, b, n);
+        return;
+    }
+
+    h = n >> 1;
+    k = n - h;
+    sa = ws;
+    sb = ws + k + 1;
+    z1 = ws + ((k + 1) << 1);
+    wsn = z1 + ((k + 1) << 1);
+
+    /*z0 = a0*b0 and z2 = a1*b1, straight into the result*/
+    mln_bignum_kmul(r, a, b, h, wsn);
+    mln_bignum_kmul(r + (h << 1), a + h, b + h, k, wsn);
+
+    /*sa = a0+a1, sb = b0+b1, each k+1 limbs*/
+    memcpy(sa, a, h * sizeof(mln_u64_t));
+    memset(sa + h, 0, (k + 1 - h) * sizeof(mln_u64_t));
+    mln_bignum_nadd_ext(sa, a + h, k, k + 1);
+    memcpy(sb, b, h * sizeof(mln_u64_t));
+    memset(sb + h, 0, (k + 1 - h) * sizeof(mln_u64_t));
+    mln_bignum_nadd_ext(sb, b + h, k, k + 1);
+
+    /*z1 = sa*sb - z0 - z2 = a0*b1 + a1*b0*/
+    mln_bignum_kmul(z1, sa, sb, k + 1, wsn);
+    mln_bignum_nsub_ext(z1, r, h << 1, (k + 1) << 1);
+    mln_bignum_nsub_ext(z1, r + (h << 1), k << 1, (k + 1) << 1);
+
+    mln_bignum_nadd_ext(r + h, z1, (k + 1) << 1, (n << 1) - h);
+}
+
 static inline void __mln_bignum_mul(mln_bignum_t *dest, mln_bignum_t *src)
 {
     mln_u32_t tag = dest->tag ^ src->tag;
@@ -406,6 +550,26 @@ static inline void __mln_bignum_mul(mln_bignum_t *dest, mln_bignum_t *src)
         return;
     }
 
+    if (dest->length >= M_BIGNUM_KARATSUBA_MIN && src->length >= M_BIGNUM_KARATSUBA_MIN) {
+        mln_u32_t n = dest->length > src->length? dest->length: src->length, rl;
+        mln_u64_t pa[M_BIGNUM_SIZE], pb[M_BIGNUM_SIZE];
+        mln_u64_t prod[M_BIGNUM_SIZE << 1], ws[(M_BIGNUM_SIZE << 2) + 64];
+
+        memcpy(pa, dest->data, dest->length * sizeof(mln_u64_t));
+        memset(pa + dest->length, 0, (n - dest->length) * sizeof(mln_u64_t));
+        memcpy(pb, src->data, src->length * sizeof(mln_u64_t));
+        memset(pb + src->length, 0, (n - src->length) * sizeof(mln_u64_t));
+        mln_bignum_kmul(prod, pa, pb, n, ws);
+
+        rl = (n << 1) > M_BIGNUM_SIZE? M_BIGNUM_SIZE: (n << 1);
+        memcpy(res.data, prod, rl * sizeof(mln_u64_t));
+        while (rl > 0 && res.data[rl - 1] == 0) --rl;
+        res.length = rl;
+        res.tag = tag;
+        *dest = res;
+        return;
+    }
+
     mln_u64_t *data = res.data, tmp, *dest_data = dest->data, *src_data;
     mln_u64_t *dend, *send, *last = res.data + M_BIGNUM_SIZE;
 
@@ -609,10 +773,154 @@ int mln_bignum_pwr(mln_bignum_t *dest, mln_bignum_t *exponent, mln_bignum_t *mod
     return __mln_bignum_pwr(dest, exponent, mod);
 }
 
+/*
+ * Montgomery-form modular exponentiation for odd moduli (the RSA case).
+ * Numbers are kept as x*R mod m with R = 2^(32n), so each step is one
+ * CIOS multiply-and-reduce instead of a full division. The exponent is
+ * consumed in fixed 4-bit windows against a 16-entry table of powers.
+ */
+#define M_BIGNUM_MONT_MAX   (M_BIGNUM_SIZE >> 1)
+#define M_BIGNUM_MONT_WIN   4
+
+static inline mln_u32_t mln_bignum_mont_n0inv(mln_u32_t m0)
+{
+    /*Newton iteration: correct bits double each round, odd m0 starts with 3*/
+    mln_u32_t inv = m0;
+    inv *= 2 - m0 * inv;
+    inv *= 2 - m0 * inv;
+    inv *= 2 - m0 * inv;
+    inv *= 2 - m0 * inv;
+    return (mln_u32_t)(0 - inv);
+}
+
+static void
+mln_bignum_mont_mul(mln_u64_t *r, mln_u64_t *a, mln_u64_t *b, mln_u64_t *m, mln_u32_t n, mln_u32_t n0inv)
+{
+    mln_u64_t t[M_BIGNUM_MONT_MAX + 2], tmp, carry, u, ai;
+    mln_u32_t i, j;
+
+    memset(t, 0, (n + 2) * sizeof(mln_u64_t));
+    for (i = 0; i < n; ++i) {
+        ai = a[i];
+        carry = 0;
+        for (j = 0; j < n; ++j) {
+            tmp = t[j] + ai * b[j] + carry;
+            t[j] = tmp % M_BIGNUM_UMAX;
+            carry = tmp >> M_BIGNUM_SHIFT;
+        }
+        tmp = t[n] + carry;
+        t[n] = tmp % M_BIGNUM_UMAX;
+        t[n + 1] = tmp >> M_BIGNUM_SHIFT;
+
+        u = ((mln_u32_t)t[0] * n0inv) % M_BIGNUM_UMAX;
+        tmp = t[0] + u * m[0];
+        carry = tmp >> M_BIGNUM_SHIFT;
+        for (j = 1; j < n; ++j) {
+            tmp = t[j] + u * m[j] + carry;
+            t[j - 1] = tmp % M_BIGNUM_UMAX;
+            carry = tmp >> M_BIGNUM_SHIFT;
+        }
+        tmp = t[n] + carry;
+        t[n - 1] = tmp % M_BIGNUM_UMAX;
+        t[n] = t[n + 1] + (tmp >> M_BIGNUM_SHIFT);
+    }
+
+    /*one conditional subtraction brings t below m*/
+    if (t[n] != 0) {
+        mln_bignum_nsub_ext(t, m, n, n + 1);
+    } else {
+        mln_s32_t c = 0;
+        for (i = n; i > 0; --i) {
+            if (t[i - 1] != m[i - 1]) {
+                c = t[i - 1] > m[i - 1]? 1: -1;
+                break;
+            }
+        }
+        if (c >= 0) mln_bignum_nsub_ext(t, m, n, n);
+    }
+    memcpy(r, t, n * sizeof(mln_u64_t));
+}
+
+static int mln_bignum_mont_pwr(mln_bignum_t *dest, mln_bignum_t *exponent, mln_bignum_t *mod)
+{
+    mln_u32_t n = mod->length, n0inv, w, s;
+    mln_u64_t tbl[1 << M_BIGNUM_MONT_WIN][M_BIGNUM_MONT_MAX];
+    mln_u64_t x[M_BIGNUM_MONT_MAX], rrd[M_BIGNUM_MONT_MAX], one[M_BIGNUM_MONT_MAX];
+    mln_bignum_t rr;
+    mln_s32_t bits, wi, nwin;
+
+    for (bits = (exponent->length << 5) - 1; bits >= 0; --bits) {
+        if (__mln_bignum_bit_test(exponent, bits)) break;
+    }
+    if (bits < 0) {
+        memset(dest, 0, sizeof(mln_bignum_t));
+        dest->tag = M_BIGNUM_POSITIVE;
+        dest->length = 1;
+        dest->data[0] = 1;
+        return 0;
+    }
+
+    if (__mln_bignum_abs_compare(dest, mod) >= 0) {
+        if (__mln_bignum_div(dest, mod, NULL) < 0) return -1;
+    }
+
+    /*rr = R^2 mod m, the only division needed*/
+    memset(&rr, 0, sizeof(rr));
+    rr.data[n << 1] = 1;
+    rr.length = (n << 1) + 1;
+    if (__mln_bignum_div(&rr, mod, NULL) < 0) return -1;
+    memset(rrd, 0, n * sizeof(mln_u64_t));
+    memcpy(rrd, rr.data, rr.length * sizeof(mln_u64_t));
+
+    n0inv = mln_bignum_mont_n0inv((mln_u32_t)mod->data[0]);
+
+    /*tbl[0] = 1*R, tbl[1] = a*R, tbl[i] = a^i*R*/
+    memset(one, 0, n * sizeof(mln_u64_t));
+    one[0] = 1;
+    mln_bignum_mont_mul(tbl[0], one, rrd, mod->data, n, n0inv);
+    memset(x, 0, n * sizeof(mln_u64_t));
+    memcpy(x, dest->data, dest->length * sizeof(mln_u64_t));
+    mln_bignum_mont_mul(tbl[1], x, rrd, mod->data, n, n0inv);
+    for (w = 2; w < (1 << M_BIGNUM_MONT_WIN); ++w) {
+        mln_bignum_mont_mul(tbl[w], tbl[w - 1], tbl[1], mod->data, n, n0inv);
+    }
+
+    memcpy(x, tbl[0], n * sizeof(mln_u64_t));
+    nwin = (bits + M_BIGNUM_MONT_WIN) / M_BIGNUM_MONT_WIN;
+    for (wi = nwin - 1; wi >= 0; --wi) {
+        for (s = 0; s < M_BIGNUM_MONT_WIN; ++s) {
+            mln_bignum_mont_mul(x, x, x, mod->data, n, n0inv);
+        }
+        for (w = 0, s = 0; s < M_BIGNUM_MONT_WIN; ++s) {
+            mln_u32_t idx = wi * M_BIGNUM_MONT_WIN + s;
+            if (idx < (exponent->length << 5))
+                w |= (mln_u32_t)__mln_bignum_bit_test(exponent, idx) << s;
+        }
+        mln_bignum_mont_mul(x, x, tbl[w], mod->data, n, n0inv);
+    }
+
+    /*leave Montgomery form*/
+    mln_bignum_mont_mul(x, x, one, mod->data, n, n0inv);
+
+    memset(dest, 0, sizeof(mln_bignum_t));
+    dest->tag = M_BIGNUM_POSITIVE;
+    memcpy(dest->data, x, n * sizeof(mln_u64_t));
+    while (n > 0 && dest->data[n - 1] == 0) --n;
+    dest->length = n;
+    return 0;
+}
+
 static inline int __mln_bignum_pwr(mln_bignum_t *dest, mln_bignum_t *exponent, mln_bignum_t *mod)
 {
     if (exponent->tag == M_BIGNUM_NEGATIVE) return -1;
 
+    if (mod != NULL && mod->length > 1 && (mod->data[0] & 1) && \
+        mod->tag == M_BIGNUM_POSITIVE && dest->tag == M_BIGNUM_POSITIVE && \
+        mod->length <= M_BIGNUM_MONT_MAX)
+    {
+        return mln_bignum_mont_pwr(dest, exponent, mod);
+    }
+
     mln_bignum_t x;
     mln_s32_t i;
 
@@ -0,0 +1,370 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "mln_chacha20.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define MLN_CHACHA20_SIMD_SSE2 1
+#endif
+
+#define __M_CHACHA20_QR(x,a,b,c,d) do {\
+    (x)[a] += (x)[b]; (x)[d] ^= (x)[a]; (x)[d] = ((x)[d] << 16) | ((x)[d] >> 16);\
+    (x)[c] += (x)[d]; (x)[b] ^= (x)[c]; (x)[b] = ((x)[b] << 12) | ((x)[b] >> 20);\
+    (x)[a] += (x)[b]; (x)[d] ^= (x)[a]; (x)[d] = ((x)[d] << 8) | ((x)[d] >> 24);\
+    (x)[c] += (x)[d]; (x)[b] ^= (x)[c]; (x)[b] = ((x)[b] << 7) | ((x)[b] >> 25);\
+} while (0)
+
+static inline mln_u32_t mln_chacha20_load32(mln_u8ptr_t p)
+{
+    mln_u32_t v;
+    memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+static inline void mln_chacha20_store32(mln_u8ptr_t p, mln_u32_t v)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    memcpy(p, &v, sizeof(v));
+}
+
+static void mln_chacha20_block(mln_chacha20_t *c)
+{
+    mln_u32_t x[16];
+    int i;
+
+    memcpy(x, c->state, sizeof(x));
+    for (i = 0; i < 10; ++i) {
+        __M_CHACHA20_QR(x, 0, 4,  8, 12);
+        __M_CHACHA20_QR(x, 1, 5,  9, 13);
+        __M_CHACHA20_QR(x, 2, 6, 10, 14);
+        __M_CHACHA20_QR(x, 3, 7, 11, 15);
+        __M_CHACHA20_QR(x, 0, 5, 10, 15);
+        __M_CHACHA20_QR(x, 1, 6, 11, 12);
+        __M_CHACHA20_QR(x, 2, 7,  8, 13);
+        __M_CHACHA20_QR(x, 3, 4,  9, 14);
+    }
+    for (i = 0; i < 16; ++i) {
+        mln_chacha20_store32(c->stream + (i << 2), x[i] + c->state[i]);
+    }
+    ++c->state[12];
+}
+
+void mln_chacha20_init(mln_chacha20_t *c, mln_u8ptr_t key, mln_u8ptr_t nonce, mln_u32_t counter)
+{
+    int i;
+
+    c->state[0] = 0x61707865;
+    c->state[1] = 0x3320646e;
+    c->state[2] = 0x79622d32;
+    c->state[3] = 0x6b206574;
+    for (i = 0; i < 8; ++i) {
+        c->state[4 + i] = mln_chacha20_load32(key + (i << 2));
+    }
+    c->state[12] = counter;
+    c->state[13] = mln_chacha20_load32(nonce);
+    c->state[14] = mln_chacha20_load32(nonce + 4);
+    c->state[15] = mln_chacha20_load32(nonce + 8);
+    c->pos = __M_CHACHA20_BLOCKLEN;
+}
+
+#if defined(MLN_CHACHA20_SIMD_SSE2)
+#define __M_CHACHA20_VROTL(x,n) _mm_or_si128(_mm_slli_epi32((x), (n)), _mm_srli_epi32((x), 32-(n)))
+#define __M_CHACHA20_VQR(a,b,c,d) do {\
+    v[a] = _mm_add_epi32(v[a], v[b]); v[d] = _mm_xor_si128(v[d], v[a]); v[d] = __M_CHACHA20_VROTL(v[d], 16);\
+    v[c] = _mm_add_epi32(v[c], v[d]); v[b] = _mm_xor_si128(v[b], v[c]); v[b] = __M_CHACHA20_VROTL(v[b], 12);\
+    v[a] = _mm_add_epi32(v[a], v[b]); v[d] = _mm_xor_si128(v[d], v[a]); v[d] = __M_CHACHA20_VROTL(v[d], 8);\
+    v[c] = _mm_add_epi32(v[c], v[d]); v[b] = _mm_xor_si128(v[b], v[c]); v[b] = __M_CHACHA20_VROTL(v[b], 7);\
+} while (0)
+
+/*
+ * Cipher four consecutive blocks at once, one block per 32-bit SIMD
+ * lane; counters run state[12]..state[12]+3. Only entered on a block
+ * boundary (c->pos exhausted), so no partial keystream is in flight.
+ */
+static void mln_chacha20_calc_x4(mln_chacha20_t *c, mln_u8ptr_t data)
+{
+    __m128i v[16];
+    const __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+    mln_u32_t tmp[16][4];
+    mln_u32_t m;
+    int i, b;
+
+    for (i = 0; i < 16; ++i) {
+        v[i] = _mm_set1_epi32(c->state[i]);
+    }
+    v[12] = _mm_add_epi32(v[12], lane);
+    for (i = 0; i < 10; ++i) {
+        __M_CHACHA20_VQR(0, 4,  8, 12);
+        __M_CHACHA20_VQR(1, 5,  9, 13);
+        __M_CHACHA20_VQR(2, 6, 10, 14);
+        __M_CHACHA20_VQR(3, 7, 11, 15);
+        __M_CHACHA20_VQR(0, 5, 10, 15);
+        __M_CHACHA20_VQR(1, 6, 11, 12);
+        __M_CHACHA20_VQR(2, 7,  8, 13);
+        __M_CHACHA20_VQR(3, 4,  9, 14);
+    }
+    for (i = 0; i < 16; ++i) {
+        __m128i s = _mm_set1_epi32(c->state[i]);
+        if (i == 12) s = _mm_add_epi32(s, lane);
+        _mm_storeu_si128((__m128i *)tmp[i], _mm_add_epi32(v[i], s));
+    }
+    for (b = 0; b < 4; ++b) {
+        for (i = 0; i < 16; ++i) {
+            memcpy(&m, data, sizeof(m));
+            m ^= tmp[i][b];
+            memcpy(data, &m, sizeof(m));
+            data += sizeof(m);
+        }
+    }
+    c->state[12] += 4;
+}
+#endif
+
+void mln_chacha20_calc(mln_chacha20_t *c, mln_u8ptr_t data, mln_uauto_t len)
+{
+    mln_uauto_t i, n;
+
+    while (len > 0) {
+#if defined(MLN_CHACHA20_SIMD_SSE2)
+        if (c->pos == __M_CHACHA20_BLOCKLEN) {
+            while (len >= (__M_CHACHA20_BLOCKLEN << 2)) {
+                mln_chacha20_calc_x4(c, data);
+                data += (__M_CHACHA20_BLOCKLEN << 2);
+                len -= (__M_CHACHA20_BLOCKLEN << 2);
+            }
+            if (len == 0) break;
+        }
+#endif
+        if (c->pos == __M_CHACHA20_BLOCKLEN) {
+            mln_chacha20_block(c);
+            c->pos = 0;
+        }
+        n = __M_CHACHA20_BLOCKLEN - c->pos;
+        if (n > len) n = len;
+        for (i = 0; i < n; ++i) {
+            data[i] ^= c->stream[c->pos + i];
+        }
+        c->pos += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void mln_chacha20_calc_chain(mln_chacha20_t *c, mln_chain_t *in)
+{
+    mln_buf_t *b;
+
+    for (; in != NULL; in = in->next) {
+        b = in->buf;
+        if (b == NULL || !b->in_memory || b->pos == NULL) continue;
+        if (b->last <= b->pos) continue;
+        mln_chacha20_calc(c, b->pos, b->last - b->pos);
+    }
+}
+
+
+void mln_poly1305_init(mln_poly1305_t *p, mln_u8ptr_t key)
+{
+    p->r[0] = mln_chacha20_load32(key) & 0x3ffffff;
+    p->r[1] = (mln_chacha20_load32(key + 3) >> 2) & 0x3ffff03;
+    p->r[2] = (mln_chacha20_load32(key + 6) >> 4) & 0x3ffc0ff;
+    p->r[3] = (mln_chacha20_load32(key + 9) >> 6) & 0x3f03fff;
+    p->r[4] = (mln_chacha20_load32(key + 12) >> 8) & 0x00fffff;
+    p->h[0] = p->h[1] = p->h[2] = p->h[3] = p->h[4] = 0;
+    p->pad[0] = mln_chacha20_load32(key + 16);
+    p->pad[1] = mln_chacha20_load32(key + 20);
+    p->pad[2] = mln_chacha20_load32(key + 24);
+    p->pad[3] = mln_chacha20_load32(key + 28);
+    p->pos = 0;
+}
+
+static void mln_poly1305_blocks(mln_poly1305_t *p, mln_u8ptr_t m, mln_uauto_t bytes, mln_u32_t hibit)
+{
+    mln_u32_t r0 = p->r[0], r1 = p->r[1], r2 = p->r[2], r3 = p->r[3], r4 = p->r[4];
+    mln_u32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    mln_u32_t h0 = p->h[0], h1 = p->h[1], h2 = p->h[2], h3 = p->h[3], h4 = p->h[4];
+    mln_u64_t d0, d1, d2, d3, d4;
+    mln_u32_t c;
+
+    while (bytes >= __M_POLY1305_BLOCKLEN) {
+        h0 += mln_chacha20_load32(m) & 0x3ffffff;
+        h1 += (mln_chacha20_load32(m + 3) >> 2) & 0x3ffffff;
+        h2 += (mln_chacha20_load32(m + 6) >> 4) & 0x3ffffff;
+        h3 += (mln_chacha20_load32(m + 9) >> 6) & 0x3ffffff;
+        h4 += (mln_chacha20_load32(m + 12) >> 8) | hibit;
+
+        d0 = (mln_u64_t)h0*r0 + (mln_u64_t)h1*s4 + (mln_u64_t)h2*s3 + (mln_u64_t)h3*s2 + (mln_u64_t)h4*s1;
+        d1 = (mln_u64_t)h0*r1 + (mln_u64_t)h1*r0 + (mln_u64_t)h2*s4 + (mln_u64_t)h3*s3 + (mln_u64_t)h4*s2;
+        d2 = (mln_u64_t)h0*r2 + (mln_u64_t)h1*r1 + (mln_u64_t)h2*r0 + (mln_u64_t)h3*s4 + (mln_u64_t)h4*s3;
+        d3 = (mln_u64_t)h0*r3 + (mln_u64_t)h1*r2 + (mln_u64_t)h2*r1 + (mln_u64_t)h3*r0 + (mln_u64_t)h4*s4;
+        d4 = (mln_u64_t)h0*r4 + (mln_u64_t)h1*r3 + (mln_u64_t)h2*r2 + (mln_u64_t)h3*r1 + (mln_u64_t)h4*r0;
+
+        c = (mln_u32_t)(d0 >> 26); h0 = (mln_u32_t)d0 & 0x3ffffff;
+        d1 += c; c = (mln_u32_t)(d1 >> 26); h1 = (mln_u32_t)d1 & 0x3ffffff;
+        d2 += c; c = (mln_u32_t)(d2 >> 26); h2 = (mln_u32_t)d2 & 0x3ffffff;
+        d3 += c; c = (mln_u32_t)(d3 >> 26); h3 = (mln_u32_t)d3 & 0x3ffffff;
+        d4 += c; c = (mln_u32_t)(d4 >> 26); h4 = (mln_u32_t)d4 & 0x3ffffff;
+        h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff; h1 += c;
+
+        m += __M_POLY1305_BLOCKLEN;
+        bytes -= __M_POLY1305_BLOCKLEN;
+    }
+
+    p->h[0] = h0; p->h[1] = h1; p->h[2] = h2; p->h[3] = h3; p->h[4] = h4;
+}
+
+static void mln_poly1305_finish(mln_poly1305_t *p)
+{
+    mln_u32_t h0, h1, h2, h3, h4, g0, g1, g2, g3, g4, c, mask;
+    mln_u64_t f;
+
+    if (p->pos) {
+        p->buf[p->pos] = 1;
+        memset(p->buf + p->pos + 1, 0, __M_POLY1305_BLOCKLEN - p->pos - 1);
+        mln_poly1305_blocks(p, p->buf, __M_POLY1305_BLOCKLEN, 0);
+        p->pos = 0;
+    }
+
+    h0 = p->h[0]; h1 = p->h[1]; h2 = p->h[2]; h3 = p->h[3]; h4 = p->h[4];
+    c = h1 >> 26; h1 &= 0x3ffffff; h2 += c;
+    c = h2 >> 26; h2 &= 0x3ffffff; h3 += c;
+    c = h3 >> 26; h3 &= 0x3ffffff; h4 += c;
+    c = h4 >> 26; h4 &= 0x3ffffff; h0 += c * 5;
+    c = h0 >> 26; h0 &= 0x3ffffff; h1 += c;
+
+    g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+    g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+    g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+    g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+    g4 = h4 + c - (1 << 26);
+
+    mask = (g4 >> 31) - 1;
+    g0 &= mask; g1 &= mask; g2 &= mask; g3 &= mask; g4 &= mask;
+    mask = ~mask;
+    h0 = (h0 & mask) | g0;
+    h1 = (h1 & mask) | g1;
+    h2 = (h2 & mask) | g2;
+    h3 = (h3 & mask) | g3;
+    h4 = (h4 & mask) | g4;
+
+    h0 = h0 | (h1 << 26);
+    h1 = (h1 >> 6) | (h2 << 20);
+    h2 = (h2 >> 12) | (h3 << 14);
+    h3 = (h3 >> 18) | (h4 << 8);
+
+    f = (mln_u64_t)h0 + p->pad[0];             mln_chacha20_store32(p->buf, (mln_u32_t)f);
+    f = (mln_u64_t)h1 + p->pad[1] + (f >> 32); mln_chacha20_store32(p->buf + 4, (mln_u32_t)f);
+    f = (mln_u64_t)h2 + p->pad[2] + (f >> 32); mln_chacha20_store32(p->buf + 8, (mln_u32_t)f);
+    f = (mln_u64_t)h3 + p->pad[3] + (f >> 32); mln_chacha20_store32(p->buf + 12, (mln_u32_t)f);
+}
+
+void mln_poly1305_calc(mln_poly1305_t *p, mln_u8ptr_t input, mln_uauto_t len, mln_u32_t is_last)
+{
+    mln_uauto_t n;
+
+    if (p->pos) {
+        n = __M_POLY1305_BLOCKLEN - p->pos;
+        if (n > len) n = len;
+        memcpy(p->buf + p->pos, input, n);
+        p->pos += n;
+        input += n;
+        len -= n;
+        if (p->pos == __M_POLY1305_BLOCKLEN) {
+            mln_poly1305_blocks(p, p->buf, __M_POLY1305_BLOCKLEN, 1 << 24);
+            p->pos = 0;
+        }
+    }
+    if (len >= __M_POLY1305_BLOCKLEN) {
+        n = len & ~((mln_uauto_t)__M_POLY1305_BLOCKLEN - 1);
+        mln_poly1305_blocks(p, input, n, 1 << 24);
+        input += n;
+        len -= n;
+    }
+    if (len) {
+        memcpy(p->buf + p->pos, input, len);
+        p->pos += len;
+    }
+    if (is_last) mln_poly1305_finish(p);
+}
+
+void mln_poly1305_tobytes(mln_poly1305_t *p, mln_u8ptr_t tag, mln_u32_t len)
+{
+    if (len > __M_POLY1305_TAGLEN) len = __M_POLY1305_TAGLEN;
+    memcpy(tag, p->buf, len);
+}
+
+
+static void mln_chacha20_poly1305_tag(mln_u8ptr_t key, mln_u8ptr_t nonce, \
+                                      mln_u8ptr_t aad, mln_uauto_t aadlen, \
+                                      mln_u8ptr_t cipher, mln_uauto_t clen, \
+                                      mln_u8ptr_t tag)
+{
+    mln_chacha20_t c;
+    mln_poly1305_t p;
+    mln_u8_t polykey[__M_CHACHA20_BLOCKLEN];
+    mln_u8_t pad[__M_POLY1305_BLOCKLEN];
+
+    memset(polykey, 0, sizeof(polykey));
+    memset(pad, 0, sizeof(pad));
+    mln_chacha20_init(&c, key, nonce, 0);
+    mln_chacha20_calc(&c, polykey, sizeof(polykey));
+    mln_poly1305_init(&p, polykey);
+    if (aadlen) {
+        mln_poly1305_calc(&p, aad, aadlen, 0);
+        if (aadlen & (__M_POLY1305_BLOCKLEN - 1))
+            mln_poly1305_calc(&p, pad, __M_POLY1305_BLOCKLEN - (aadlen & (__M_POLY1305_BLOCKLEN - 1)), 0);
+    }
+    if (clen) {
+        mln_poly1305_calc(&p, cipher, clen, 0);
+        if (clen & (__M_POLY1305_BLOCKLEN - 1))
+            mln_poly1305_calc(&p, pad, __M_POLY1305_BLOCKLEN - (clen & (__M_POLY1305_BLOCKLEN - 1)), 0);
+    }
+    mln_chacha20_store32(pad, (mln_u32_t)aadlen);
+    mln_chacha20_store32(pad + 4, (mln_u32_t)((mln_u64_t)aadlen >> 32));
+    mln_chacha20_store32(pad + 8, (mln_u32_t)clen);
+    mln_chacha20_store32(pad + 12, (mln_u32_t)((mln_u64_t)clen >> 32));
+    mln_poly1305_calc(&p, pad, __M_POLY1305_BLOCKLEN, 1);
+    mln_poly1305_tobytes(&p, tag, __M_POLY1305_TAGLEN);
+}
+
+void mln_chacha20_poly1305_encrypt(mln_u8ptr_t key, mln_u8ptr_t nonce, \
+                                   mln_u8ptr_t aad, mln_uauto_t aadlen, \
+                                   mln_u8ptr_t data, mln_uauto_t len, \
+                                   mln_u8ptr_t tag)
+{
+    mln_chacha20_t c;
+
+    mln_chacha20_init(&c, key, nonce, 1);
+    mln_chacha20_calc(&c, data, len);
+    mln_chacha20_poly1305_tag(key, nonce, aad, aadlen, data, len, tag);
+}
+
+int mln_chacha20_poly1305_decrypt(mln_u8ptr_t key, mln_u8ptr_t nonce, \
+                                  mln_u8ptr_t aad, mln_uauto_t aadlen, \
+                                  mln_u8ptr_t data, mln_uauto_t len, \
+                                  mln_u8ptr_t tag)
+{
+    mln_chacha20_t c;
+    mln_u8_t t[__M_POLY1305_TAGLEN];
+    mln_u8_t diff = 0;
+    int i;
+
+    mln_chacha20_poly1305_tag(key, nonce, aad, aadlen, data, len, t);
+    for (i = 0; i < __M_POLY1305_TAGLEN; ++i) {
+        diff |= t[i] ^ tag[i];
+    }
+    if (diff) return -1;
+    mln_chacha20_init(&c, key, nonce, 1);
+    mln_chacha20_calc(&c, data, len);
+    return 0;
+}
+
@@ -5,19 +5,25 @@
 
 #include "mln_chain.h"
 
-mln_buf_t *mln_buf_new(mln_alloc_t *pool)
+static inline void mln_buf_init(mln_buf_t *b)
 {
-    mln_buf_t *b = mln_alloc_m(pool, sizeof(mln_buf_t));
     b->left_pos = b->pos = b->last = NULL;
     b->start = b->end = NULL;
     b->shadow = NULL;
     b->file_left_pos = b->file_pos = b->file_last = 0;
     b->file = NULL;
-    b->temporary = b->in_memory = b->in_file = 0;
+    b->ref = 0;
+    b->temporary = b->released = b->in_memory = b->in_file = 0;
 #if !defined(WIN32)
     b->mmap = 0;
 #endif
     b->flush = b->sync = b->last_buf = b->last_in_chain = 0;
+}
+
+mln_buf_t *mln_buf_new(mln_alloc_t *pool)
+{
+    mln_buf_t *b = mln_alloc_m(pool, sizeof(mln_buf_t));
+    mln_buf_init(b);
     return b;
 }
 
@@ -29,14 +35,22 @@ mln_chain_t *mln_chain_new(mln_alloc_t *pool)
     return c;
 }
 
-void mln_buf_pool_release(mln_buf_t *b)
+mln_buf_t *mln_buf_ref(mln_alloc_t *pool, mln_buf_t *b)
 {
-    if (b == NULL) return;
+    mln_buf_t *owner = b->shadow != NULL? b->shadow: b;
+    mln_buf_t *nb = mln_buf_new(pool);
+    if (nb == NULL) return NULL;
+    *nb = *b;
+    nb->shadow = owner;
+    nb->ref = 0;
+    nb->released = 0;
+    ++(owner->ref);
+    return nb;
+}
 
-    if (b->shadow != NULL || b->temporary) {
-        mln_alloc_free(b);
-        return;
-    }
+static void mln_buf_data_free(mln_buf_t *b)
+{
+    if (b->temporary) return;
 
     if (b->in_memory) {
 #if !defined(WIN32)
@@ -56,16 +70,53 @@ void mln_buf_pool_release(mln_buf_t *b)
 #if !defined(WIN32)
         }
 #endif
-        mln_alloc_free(b);
         return;
     }
 
     if (b->in_file) {
         mln_file_close(b->file);
+    }
+}
+
+void mln_buf_reset(mln_buf_t *b)
+{
+    mln_buf_t *owner;
+
+    if (b->shadow != NULL) {
+        owner = b->shadow;
+        if (owner->ref > 0 && --(owner->ref) == 0 && owner->released) {
+            mln_buf_data_free(owner);
+            mln_alloc_free(owner);
+        }
+    } else {
+        mln_buf_data_free(b);
+    }
+    mln_buf_init(b);
+}
+
+void mln_buf_pool_release(mln_buf_t *b)
+{
+    mln_buf_t *owner;
+
+    if (b == NULL) return;
+
+    if (b->shadow != NULL) {
+        owner = b->shadow;
         mln_alloc_free(b);
+        if (owner->ref == 0 || --(owner->ref) > 0 || !owner->released)
+            return;
+        /*last reference dropped after the owner, free the data now*/
+        mln_buf_data_free(owner);
+        mln_alloc_free(owner);
+        return;
+    }
+
+    if (b->ref > 0) {
+        b->released = 1;/*shadows still in flight*/
         return;
     }
 
+    mln_buf_data_free(b);
     mln_alloc_free(b);
 }
 
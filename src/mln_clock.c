@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#include <stdio.h>
+#include <pthread.h>
+#include "mln_clock.h"
+#include "mln_tools.h"
+
+volatile mln_u64_t mln_clock_mono_us_cached = 0;
+volatile mln_u64_t mln_clock_wall_us_cached = 0;
+volatile mln_u32_t mln_clock_driven = 0;
+
+/*
+ * The HTTP date is re-rendered at most once per second.  Formatting
+ * alternates between two buffers and publishes the fresh one with a
+ * single pointer store, so readers on other threads either see the
+ * previous second's string or the new one, never a half-written buffer.
+ */
+static char mln_clock_date_buf[2][32];
+static mln_string_t mln_clock_date_str[2];
+static mln_string_t * volatile mln_clock_date_cur = NULL;
+static mln_u64_t mln_clock_date_sec = 0;
+static mln_u32_t mln_clock_date_idx = 0;
+static pthread_mutex_t mln_clock_date_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static char mln_clock_wday[][4] = {
+    "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
+};
+static char mln_clock_mon[][4] = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun", \
+    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+void mln_clock_update(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    mln_clock_wall_us_cached = (mln_u64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+#if defined(CLOCK_MONOTONIC)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        mln_clock_mono_us_cached = (mln_u64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    }
+#else
+    mln_clock_mono_us_cached = mln_clock_wall_us_cached;
+#endif
+}
+
+void mln_clock_enter(void)
+{
+    __sync_fetch_and_add(&mln_clock_driven, 1);
+    mln_clock_update();
+}
+
+void mln_clock_leave(void)
+{
+    __sync_fetch_and_sub(&mln_clock_driven, 1);
+}
+
+static mln_string_t *mln_clock_http_date_format(mln_u64_t sec)
+{
+    int n;
+    mln_u32_t idx;
+    struct utctime uc;
+
+    pthread_mutex_lock(&mln_clock_date_lock);
+    if (mln_clock_date_cur == NULL || sec != mln_clock_date_sec) {
+        idx = mln_clock_date_idx ^ 1;
+        mln_time2utc((time_t)sec, &uc);
+        n = snprintf(mln_clock_date_buf[idx], sizeof(mln_clock_date_buf[idx]), \
+                     "%s, %02ld %s %ld %02ld:%02ld:%02ld GMT", \
+                     mln_clock_wday[uc.week], uc.day, mln_clock_mon[uc.month - 1], \
+                     uc.year, uc.hour, uc.minute, uc.second);
+        mln_string_nset(&mln_clock_date_str[idx], mln_clock_date_buf[idx], n);
+        mln_clock_date_idx = idx;
+        mln_clock_date_sec = sec;
+        mln_clock_date_cur = &mln_clock_date_str[idx];
+    }
+    pthread_mutex_unlock(&mln_clock_date_lock);
+    return mln_clock_date_cur;
+}
+
+mln_string_t *mln_clock_http_date(void)
+{
+    mln_u64_t sec;
+    mln_string_t *cur;
+
+    if (!mln_clock_driven) mln_clock_update();
+    sec = mln_clock_wall_us_cached / 1000000;
+    cur = mln_clock_date_cur;
+    if (cur != NULL && sec == mln_clock_date_sec)
+        return cur;
+    return mln_clock_http_date_format(sec);
+}
@@ -8,6 +8,11 @@
 #include "mln_log.h"
 #include "mln_ipc.h"
 #include <stdlib.h>
+#if !defined(WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 
 #define CONF_ERR(lex,TK,MSG); \
 {\
@@ -23,6 +28,7 @@
 }
 
 static mln_conf_hook_t *g_conf_hook_head = NULL, *g_conf_hook_tail = NULL;
+static mln_conf_change_hook_t *g_conf_change_hook_head = NULL, *g_conf_change_hook_tail = NULL;
 static mln_conf_t *g_conf = NULL;
 static char default_domain[] = "main";
 static mln_string_t conf_keywords[] = {
@@ -49,6 +55,9 @@ MLN_DEFINE_TOKEN(mln_conf_lex, CONF, \
 MLN_CHAIN_FUNC_DECLARE(conf_hook, \
                        mln_conf_hook_t, \
                        static inline void,);
+MLN_CHAIN_FUNC_DECLARE(conf_change_hook, \
+                       mln_conf_change_hook_t, \
+                       static inline void,);
 
 /*
  * declarations
@@ -943,14 +952,164 @@ void mln_conf_hook_free(void)
     }
 }
 
+mln_conf_change_hook_t *
+mln_conf_change_hook_set(char *domain, char *cmd, mln_conf_change_handler handler, void *data)
+{
+    mln_conf_change_hook_t *ch = (mln_conf_change_hook_t *)malloc(sizeof(mln_conf_change_hook_t));
+    if (ch == NULL) return NULL;
+    ch->domain = domain;
+    ch->cmd = cmd;
+    ch->handler = handler;
+    ch->data = data;
+    ch->prev = ch->next = NULL;
+    conf_change_hook_chain_add(&g_conf_change_hook_head, &g_conf_change_hook_tail, ch);
+    return ch;
+}
+
+void mln_conf_change_hook_unset(mln_conf_change_hook_t *hook)
+{
+    if (hook == NULL) return;
+    conf_change_hook_chain_del(&g_conf_change_hook_head, &g_conf_change_hook_tail, hook);
+    free(hook);
+}
+
+void mln_conf_change_hook_free(void)
+{
+    mln_conf_change_hook_t *ch;
+    while ((ch = g_conf_change_hook_head) != NULL) {
+        conf_change_hook_chain_del(&g_conf_change_hook_head, &g_conf_change_hook_tail, ch);
+        free(ch);
+    }
+}
+
 /*
  * reload
  */
+static inline int mln_conf_item_equal(mln_conf_item_t *i1, mln_conf_item_t *i2)
+{
+    if (i1->type != i2->type) return 0;
+    switch (i1->type) {
+        case CONF_STR:   return !mln_string_strcmp(i1->val.s, i2->val.s);
+        case CONF_CHAR:  return i1->val.c == i2->val.c;
+        case CONF_BOOL:  return i1->val.b == i2->val.b;
+        case CONF_INT:   return i1->val.i == i2->val.i;
+        case CONF_FLOAT: return i1->val.f == i2->val.f;
+        default:         return 1;
+    }
+}
+
+static inline int mln_conf_cmd_equal(mln_conf_cmd_t *c1, mln_conf_cmd_t *c2)
+{
+    mln_u32_t i;
+
+    if (c1->n_args != c2->n_args) return 0;
+    for (i = 0; i < c1->n_args; ++i) {
+        if (!mln_conf_item_equal(&c1->arg_tbl[i], &c2->arg_tbl[i]))
+            return 0;
+    }
+    return 1;
+}
+
+static void mln_conf_change_fire(char *domain, mln_conf_cmd_t *cc, int type)
+{
+    mln_conf_change_hook_t *h;
+
+    for (h = g_conf_change_hook_head; h != NULL; h = h->next) {
+        if (strcmp(h->domain, domain)) continue;
+        if (h->cmd != NULL && mln_string_const_strcmp(cc->cmd_name, h->cmd)) continue;
+        h->handler(domain, cc, type, h->data);
+    }
+}
+
+struct mln_conf_diff_s {
+    mln_conf_t        *other;
+    mln_conf_domain_t *other_domain;
+    char              *domain_name;
+};
+
+static int mln_conf_diff_cmd_new_handler(mln_rbtree_node_t *node, void *udata)
+{
+    struct mln_conf_diff_s *d = (struct mln_conf_diff_s *)udata;
+    mln_conf_cmd_t *cc = (mln_conf_cmd_t *)mln_rbtree_node_data_get(node), *old_cc;
+
+    old_cc = d->other_domain == NULL? NULL: \
+             d->other_domain->search(d->other_domain, (char *)cc->cmd_name->data);
+    if (old_cc == NULL) {
+        mln_conf_change_fire(d->domain_name, cc, M_CONF_CHANGE_ADD);
+    } else if (!mln_conf_cmd_equal(cc, old_cc)) {
+        mln_conf_change_fire(d->domain_name, cc, M_CONF_CHANGE_MODIFY);
+    }
+    return 0;
+}
+
+static int mln_conf_diff_cmd_old_handler(mln_rbtree_node_t *node, void *udata)
+{
+    struct mln_conf_diff_s *d = (struct mln_conf_diff_s *)udata;
+    mln_conf_cmd_t *cc = (mln_conf_cmd_t *)mln_rbtree_node_data_get(node);
+
+    if (d->other_domain == NULL || \
+        d->other_domain->search(d->other_domain, (char *)cc->cmd_name->data) == NULL)
+    {
+        mln_conf_change_fire(d->domain_name, cc, M_CONF_CHANGE_REMOVE);
+    }
+    return 0;
+}
+
+static int mln_conf_diff_domain_new_handler(mln_rbtree_node_t *node, void *udata)
+{
+    struct mln_conf_diff_s *d = (struct mln_conf_diff_s *)udata;
+    mln_conf_domain_t *cd = (mln_conf_domain_t *)mln_rbtree_node_data_get(node);
+    struct mln_conf_diff_s sub;
+
+    sub.other = NULL;
+    sub.other_domain = d->other == NULL? NULL: \
+                       d->other->search(d->other, (char *)cd->domain_name->data);
+    sub.domain_name = (char *)cd->domain_name->data;
+    mln_rbtree_iterate(cd->cmd, mln_conf_diff_cmd_new_handler, &sub);
+    return 0;
+}
+
+static int mln_conf_diff_domain_old_handler(mln_rbtree_node_t *node, void *udata)
+{
+    struct mln_conf_diff_s *d = (struct mln_conf_diff_s *)udata;
+    mln_conf_domain_t *cd = (mln_conf_domain_t *)mln_rbtree_node_data_get(node);
+    struct mln_conf_diff_s sub;
+
+    sub.other = NULL;
+    sub.other_domain = d->other == NULL? NULL: \
+                       d->other->search(d->other, (char *)cd->domain_name->data);
+    sub.domain_name = (char *)cd->domain_name->data;
+    mln_rbtree_iterate(cd->cmd, mln_conf_diff_cmd_old_handler, &sub);
+    return 0;
+}
+
+static void mln_conf_diff(mln_conf_t *old, mln_conf_t *new)
+{
+    struct mln_conf_diff_s d;
+
+    /*new against old: additions and modifications*/
+    d.other = old;
+    d.other_domain = NULL;
+    d.domain_name = NULL;
+    if (new != NULL) mln_rbtree_iterate(new->domain, mln_conf_diff_domain_new_handler, &d);
+    /*old against new: removals*/
+    d.other = new;
+    if (old != NULL) mln_rbtree_iterate(old->domain, mln_conf_diff_domain_old_handler, &d);
+}
+
 int mln_conf_reload(void)
 {
-    mln_conf_free();
-    mln_conf_load();
+    mln_conf_t *old = g_conf;
     mln_conf_hook_t *ch;
+
+    g_conf = NULL;
+    if (mln_conf_load() < 0) {
+        g_conf = old; /*keep serving the previous configuration*/
+        return -1;
+    }
+    if (g_conf_change_hook_head != NULL)
+        mln_conf_diff(old, g_conf);
+    if (old != NULL) mln_conf_destroy(old);
     for (ch = g_conf_hook_head; ch != NULL; ch = ch->next) {
         if (ch->reload != NULL && ch->reload(ch->data) < 0)
             return -1;
@@ -1059,6 +1218,392 @@ static int mln_conf_dump_domain_iterate_handler(mln_rbtree_node_t *node, void *u
     return 0;
 }
 
+/*
+ * compiled cache
+ */
+static inline mln_u64_t mln_conf_cache_hash(mln_u8ptr_t s, mln_u64_t len)
+{
+    mln_u64_t h = 0xcbf29ce484222325ULL;
+    for (; len > 0; --len, ++s) {
+        h ^= *s;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+#if !defined(WIN32)
+static int mln_conf_cache_file_hash(mln_u64_t *hash)
+{
+    int fd, n;
+    mln_u8_t buf[4096];
+    mln_u64_t h = 0xcbf29ce484222325ULL;
+    mln_u8ptr_t p, end;
+
+    if ((fd = open(mln_path_conf(), O_RDONLY)) < 0) return -1;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        for (p = buf, end = buf + n; p < end; ++p) {
+            h ^= *p;
+            h *= 0x100000001b3ULL;
+        }
+    }
+    close(fd);
+    if (n < 0) return -1;
+    *hash = h;
+    return 0;
+}
+
+struct conf_cache_builder_s {
+    mln_u8ptr_t       buf;
+    mln_size_t        len;
+    mln_size_t        size;
+};
+
+static mln_u32_t conf_cache_builder_reserve(struct conf_cache_builder_s *b, mln_size_t len)
+{
+    mln_size_t off = b->len;
+    if (b->len + len > b->size) {
+        mln_size_t newsize = b->size? b->size: 4096;
+        mln_u8ptr_t tmp;
+        while (b->len + len > newsize) newsize <<= 1;
+        if ((tmp = (mln_u8ptr_t)realloc(b->buf, newsize)) == NULL) return 0;
+        b->buf = tmp;
+        b->size = newsize;
+    }
+    memset(b->buf + off, 0, len);
+    b->len += len;
+    return (mln_u32_t)off;
+}
+
+static mln_u32_t conf_cache_builder_append(struct conf_cache_builder_s *b, void *data, mln_size_t len)
+{
+    mln_u32_t off = conf_cache_builder_reserve(b, len);
+    if (off == 0) return 0;
+    memcpy(b->buf + off, data, len);
+    return off;
+}
+
+struct conf_cache_collect_s {
+    void            **arr;
+    mln_u32_t         pos;
+};
+
+static int mln_conf_cache_collect_handler(mln_rbtree_node_t *node, void *udata)
+{
+    struct conf_cache_collect_s *c = (struct conf_cache_collect_s *)udata;
+    c->arr[(c->pos)++] = mln_rbtree_node_data_get(node);
+    return 0;
+}
+
+static mln_u32_t
+mln_conf_cache_dump_cmd(struct conf_cache_builder_s *b, mln_conf_cmd_t *cc, mln_u32_t next)
+{
+    mln_u32_t i, name, args, off, pad;
+    mln_conf_cache_item_t *it;
+    mln_conf_item_t *ci;
+    mln_conf_cache_cmd_t *rec;
+
+    if ((name = conf_cache_builder_append(b, cc->cmd_name->data, cc->cmd_name->len + 1)) == 0)
+        return 0;
+    if ((pad = b->len % sizeof(mln_u64_t)) != 0 && \
+        conf_cache_builder_reserve(b, sizeof(mln_u64_t) - pad) == 0)
+        return 0;
+    if ((args = conf_cache_builder_reserve(b, cc->n_args * sizeof(mln_conf_cache_item_t))) == 0 && cc->n_args)
+        return 0;
+    for (i = 0; i < cc->n_args; ++i) {
+        ci = &(cc->arg_tbl[i]);
+        switch (ci->type) {
+            case CONF_STR:
+            {
+                mln_u32_t soff = conf_cache_builder_append(b, ci->val.s->data, ci->val.s->len + 1);
+                if (soff == 0) return 0;
+                it = (mln_conf_cache_item_t *)(b->buf + args) + i;
+                it->type = CONF_STR;
+                it->slen = ci->val.s->len;
+                it->val = soff;
+                break;
+            }
+            case CONF_CHAR:
+                it = (mln_conf_cache_item_t *)(b->buf + args) + i;
+                it->type = CONF_CHAR;
+                it->val = (mln_u64_t)(mln_u8_t)ci->val.c;
+                break;
+            case CONF_BOOL:
+                it = (mln_conf_cache_item_t *)(b->buf + args) + i;
+                it->type = CONF_BOOL;
+                it->val = ci->val.b;
+                break;
+            case CONF_INT:
+                it = (mln_conf_cache_item_t *)(b->buf + args) + i;
+                it->type = CONF_INT;
+                it->val = (mln_u64_t)ci->val.i;
+                break;
+            case CONF_FLOAT:
+                it = (mln_conf_cache_item_t *)(b->buf + args) + i;
+                it->type = CONF_FLOAT;
+                memcpy(&(it->val), &(ci->val.f), sizeof(float));
+                break;
+            default:
+                it = (mln_conf_cache_item_t *)(b->buf + args) + i;
+                it->type = CONF_NONE;
+                break;
+        }
+    }
+    if ((off = conf_cache_builder_reserve(b, sizeof(mln_conf_cache_cmd_t))) == 0)
+        return 0;
+    rec = (mln_conf_cache_cmd_t *)(b->buf + off);
+    rec->next = next;
+    rec->name = name;
+    rec->name_len = cc->cmd_name->len;
+    rec->n_args = cc->n_args;
+    rec->args = cc->n_args? args: 0;
+    return off;
+}
+
+static mln_u32_t
+mln_conf_cache_dump_domain(struct conf_cache_builder_s *b, mln_conf_domain_t *cd, mln_u32_t next)
+{
+    mln_u32_t name, buckets, off, h, i, nbuckets, ncmds;
+    mln_conf_cmd_t **cmds = NULL;
+    mln_conf_cache_domain_t *rec;
+    struct conf_cache_collect_s c;
+
+    ncmds = mln_rbtree_node_num(cd->cmd);
+    for (nbuckets = 1; nbuckets < (ncmds << 1); nbuckets <<= 1) ;
+    if (ncmds > 0) {
+        if ((cmds = (mln_conf_cmd_t **)malloc(ncmds * sizeof(mln_conf_cmd_t *))) == NULL)
+            return 0;
+        c.arr = (void **)cmds;
+        c.pos = 0;
+        mln_rbtree_iterate(cd->cmd, mln_conf_cache_collect_handler, &c);
+    }
+    if ((name = conf_cache_builder_append(b, cd->domain_name->data, cd->domain_name->len + 1)) == 0 || \
+        (buckets = conf_cache_builder_reserve(b, nbuckets * sizeof(mln_u32_t))) == 0)
+    {
+        if (cmds != NULL) free(cmds);
+        return 0;
+    }
+    for (i = 0; i < ncmds; ++i) {
+        h = mln_conf_cache_hash(cmds[i]->cmd_name->data, cmds[i]->cmd_name->len) & (nbuckets - 1);
+        off = mln_conf_cache_dump_cmd(b, cmds[i], ((mln_u32_t *)(b->buf + buckets))[h]);
+        if (off == 0) {
+            free(cmds);
+            return 0;
+        }
+        ((mln_u32_t *)(b->buf + buckets))[h] = off;
+    }
+    if (cmds != NULL) free(cmds);
+    if ((off = conf_cache_builder_reserve(b, sizeof(mln_conf_cache_domain_t))) == 0)
+        return 0;
+    rec = (mln_conf_cache_domain_t *)(b->buf + off);
+    rec->next = next;
+    rec->name = name;
+    rec->name_len = cd->domain_name->len;
+    rec->nbuckets = nbuckets;
+    rec->ncmds = ncmds;
+    rec->buckets = buckets;
+    return off;
+}
+#endif
+
+int mln_conf_cache_dump(const char *path)
+{
+#if defined(WIN32)
+    return -1;
+#else
+    int fd;
+    char tmp[1024];
+    mln_u32_t i, h, off, nbuckets, ndomains, buckets;
+    mln_u64_t hash;
+    mln_conf_domain_t **domains;
+    mln_conf_cache_header_t *hdr;
+    struct conf_cache_builder_s b = {NULL, 0, 0};
+    struct conf_cache_collect_s c;
+
+    if (g_conf == NULL || path == NULL) return -1;
+    if (mln_conf_cache_file_hash(&hash) < 0) return -1;
+
+    ndomains = mln_rbtree_node_num(g_conf->domain);
+    for (nbuckets = 1; nbuckets < (ndomains << 1); nbuckets <<= 1) ;
+    if ((domains = (mln_conf_domain_t **)malloc(ndomains * sizeof(mln_conf_domain_t *))) == NULL)
+        return -1;
+    c.arr = (void **)domains;
+    c.pos = 0;
+    mln_rbtree_iterate(g_conf->domain, mln_conf_cache_collect_handler, &c);
+
+    /*the header occupies offset 0, so offset 0 never names a record*/
+    conf_cache_builder_reserve(&b, sizeof(mln_conf_cache_header_t));
+    if (b.buf == NULL) {
+        free(domains);
+        return -1;
+    }
+    if ((buckets = conf_cache_builder_reserve(&b, nbuckets * sizeof(mln_u32_t))) == 0) {
+err:
+        free(domains);
+        if (b.buf != NULL) free(b.buf);
+        return -1;
+    }
+    for (i = 0; i < ndomains; ++i) {
+        h = mln_conf_cache_hash(domains[i]->domain_name->data, domains[i]->domain_name->len) & (nbuckets - 1);
+        off = mln_conf_cache_dump_domain(&b, domains[i], ((mln_u32_t *)(b.buf + buckets))[h]);
+        if (off == 0) goto err;
+        ((mln_u32_t *)(b.buf + buckets))[h] = off;
+    }
+    free(domains);
+    hdr = (mln_conf_cache_header_t *)(b.buf);
+    hdr->magic = M_CONF_CACHE_MAGIC;
+    hdr->version = M_CONF_CACHE_VERSION;
+    hdr->hash = hash;
+    hdr->nbuckets = nbuckets;
+    hdr->ndomains = ndomains;
+    hdr->size = b.len;
+
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    if ((fd = open(tmp, O_WRONLY|O_CREAT|O_TRUNC, 0644)) < 0) {
+        free(b.buf);
+        return -1;
+    }
+    if (write(fd, b.buf, b.len) != (ssize_t)(b.len)) {
+        close(fd);
+        unlink(tmp);
+        free(b.buf);
+        return -1;
+    }
+    close(fd);
+    free(b.buf);
+    if (rename(tmp, path) < 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+#endif
+}
+
+mln_conf_cache_t *mln_conf_cache_load(const char *path)
+{
+#if defined(WIN32)
+    return NULL;
+#else
+    int fd;
+    struct stat st;
+    void *map;
+    mln_u64_t hash;
+    mln_conf_cache_header_t *hdr;
+    mln_conf_cache_t *cache;
+
+    if (path == NULL) return NULL;
+    if (mln_conf_cache_file_hash(&hash) < 0) return NULL;
+    if ((fd = open(path, O_RDONLY)) < 0) return NULL;
+    if (fstat(fd, &st) < 0 || (mln_size_t)st.st_size < sizeof(mln_conf_cache_header_t)) {
+        close(fd);
+        return NULL;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+    hdr = (mln_conf_cache_header_t *)map;
+    if (hdr->magic != M_CONF_CACHE_MAGIC || \
+        hdr->version != M_CONF_CACHE_VERSION || \
+        hdr->hash != hash || \
+        hdr->size != (mln_u64_t)st.st_size)
+    {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    if ((cache = (mln_conf_cache_t *)malloc(sizeof(mln_conf_cache_t))) == NULL) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    cache->map = map;
+    cache->map_size = st.st_size;
+    return cache;
+#endif
+}
+
+void mln_conf_cache_free(mln_conf_cache_t *cache)
+{
+    if (cache == NULL) return;
+#if !defined(WIN32)
+    munmap(cache->map, cache->map_size);
+#endif
+    free(cache);
+}
+
+mln_conf_cache_domain_t *mln_conf_cache_domain(mln_conf_cache_t *cache, char *domain)
+{
+    mln_u8ptr_t base = (mln_u8ptr_t)(cache->map);
+    mln_conf_cache_header_t *hdr = (mln_conf_cache_header_t *)base;
+    mln_u64_t len = strlen(domain);
+    mln_u32_t off;
+    mln_conf_cache_domain_t *cd;
+
+    off = ((mln_u32_t *)(base + sizeof(mln_conf_cache_header_t)))\
+              [mln_conf_cache_hash((mln_u8ptr_t)domain, len) & (hdr->nbuckets - 1)];
+    for (; off != 0; off = cd->next) {
+        cd = (mln_conf_cache_domain_t *)(base + off);
+        if (cd->name_len == len && !memcmp(base + cd->name, domain, len))
+            return cd;
+    }
+    return NULL;
+}
+
+mln_conf_cache_cmd_t *
+mln_conf_cache_cmd(mln_conf_cache_t *cache, mln_conf_cache_domain_t *cd, char *cmd)
+{
+    mln_u8ptr_t base = (mln_u8ptr_t)(cache->map);
+    mln_u64_t len = strlen(cmd);
+    mln_u32_t off;
+    mln_conf_cache_cmd_t *cc;
+
+    off = ((mln_u32_t *)(base + cd->buckets))\
+              [mln_conf_cache_hash((mln_u8ptr_t)cmd, len) & (cd->nbuckets - 1)];
+    for (; off != 0; off = cc->next) {
+        cc = (mln_conf_cache_cmd_t *)(base + off);
+        if (cc->name_len == len && !memcmp(base + cc->name, cmd, len))
+            return cc;
+    }
+    return NULL;
+}
+
+int mln_conf_cache_arg(mln_conf_cache_t *cache, \
+                       mln_conf_cache_cmd_t *cmd, \
+                       mln_u32_t index, \
+                       mln_conf_item_t *out, \
+                       mln_string_t *sbuf)
+{
+    mln_u8ptr_t base = (mln_u8ptr_t)(cache->map);
+    mln_conf_cache_item_t *it;
+
+    if (!index || index > cmd->n_args) return -1;
+    it = (mln_conf_cache_item_t *)(base + cmd->args) + (index - 1);
+    switch (it->type) {
+        case CONF_STR:
+            out->type = CONF_STR;
+            mln_string_nset(sbuf, base + it->val, it->slen);
+            out->val.s = sbuf;
+            break;
+        case CONF_CHAR:
+            out->type = CONF_CHAR;
+            out->val.c = (mln_s8_t)(it->val);
+            break;
+        case CONF_BOOL:
+            out->type = CONF_BOOL;
+            out->val.b = (mln_u8_t)(it->val);
+            break;
+        case CONF_INT:
+            out->type = CONF_INT;
+            out->val.i = (mln_sauto_t)(it->val);
+            break;
+        case CONF_FLOAT:
+            out->type = CONF_FLOAT;
+            memcpy(&(out->val.f), &(it->val), sizeof(float));
+            break;
+        default:
+            out->type = CONF_NONE;
+            break;
+    }
+    return 0;
+}
+
 /*
  * chain
  */
@@ -1067,6 +1612,11 @@ MLN_CHAIN_FUNC_DEFINE(conf_hook, \
                       static inline void, \
                       prev, \
                       next);
+MLN_CHAIN_FUNC_DEFINE(conf_change_hook, \
+                      mln_conf_change_hook_t, \
+                      static inline void, \
+                      prev, \
+                      next);
 
 /*
  * ipc handlers
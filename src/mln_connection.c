@@ -2,6 +2,9 @@
 /*
  * Copyright (C) Niklaus F.Schen.
  */
+#if defined(MLN_MMSG) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /*for recvmmsg/sendmmsg*/
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -16,9 +19,25 @@
 #include "mln_file.h"
 #if defined(MLN_WRITEV)
 #include <sys/uio.h>
+#include <limits.h>
+#if !defined(IOV_MAX)
+#define IOV_MAX 1024
+#endif
+/*as many segments per writev as the system allows, bounded for the stack*/
+#define M_CONN_IOV_MAX (IOV_MAX > 1024? 1024: IOV_MAX)
 #endif
 #if defined(MLN_SENDFILE)
 #include <sys/sendfile.h>
+#elif defined(MLN_SENDFILE_FREEBSD) || defined(MLN_SENDFILE_DARWIN)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+#if defined(MLN_KTLS)
+#include <netinet/tcp.h>
+#include <linux/tls.h>
+#if !defined(SOL_TLS)
+#define SOL_TLS 282
+#endif
 #endif
 
 
@@ -33,7 +52,16 @@ mln_tcp_conn_recv_chain_file(int sockfd, \
                              mln_buf_t *b, \
                              mln_buf_t *last);
 static inline int
-mln_tcp_conn_recv_chain_mem(int sockfd, mln_alloc_t *pool, mln_buf_t *b);
+mln_tcp_conn_recv_chain_mem(mln_tcp_conn_t *tc, mln_buf_t *b);
+
+static inline mln_chain_t *
+mln_tcp_conn_chain_fetch(mln_tcp_conn_t *tc);
+
+/*bounds for the adaptive receive buffer*/
+#define M_CONN_RCVBUF_MIN 1024
+#define M_CONN_RCVBUF_MAX 65536
+/*recycled descriptors kept per connection*/
+#define M_CONN_FREE_MAX   64
 static inline ssize_t
 mln_tcp_conn_send_chain_memory(mln_tcp_conn_t *tc);
 static inline ssize_t
@@ -63,10 +91,73 @@ int mln_tcp_conn_init(mln_tcp_conn_t *tc, int sockfd)
     tc->rcv_head = tc->rcv_tail = NULL;
     tc->snd_head = tc->snd_tail = NULL;
     tc->sent_head = tc->sent_tail = NULL;
+    tc->free_head = NULL;
+    tc->free_cnt = 0;
+    tc->rcv_bufsize = M_CONN_RCVBUF_MIN;
     tc->sockfd = sockfd;
     return 0;
 }
 
+#if defined(MLN_KTLS)
+static int
+mln_tcp_conn_ktls_direction_set(int sockfd, int direction, mln_tcp_conn_ktls_param_t *param)
+{
+    switch (param->cipher) {
+        case M_C_TLS_AES_GCM_128:
+        {
+            struct tls12_crypto_info_aes_gcm_128 ci;
+            memset(&ci, 0, sizeof(ci));
+            ci.info.version = param->version;
+            ci.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+            memcpy(ci.iv, param->iv, TLS_CIPHER_AES_GCM_128_IV_SIZE);
+            memcpy(ci.key, param->key, TLS_CIPHER_AES_GCM_128_KEY_SIZE);
+            memcpy(ci.salt, param->salt, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+            memcpy(ci.rec_seq, param->rec_seq, TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE);
+            return setsockopt(sockfd, SOL_TLS, direction, &ci, sizeof(ci));
+        }
+#if defined(TLS_CIPHER_AES_GCM_256)
+        case M_C_TLS_AES_GCM_256:
+        {
+            struct tls12_crypto_info_aes_gcm_256 ci;
+            memset(&ci, 0, sizeof(ci));
+            ci.info.version = param->version;
+            ci.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+            memcpy(ci.iv, param->iv, TLS_CIPHER_AES_GCM_256_IV_SIZE);
+            memcpy(ci.key, param->key, TLS_CIPHER_AES_GCM_256_KEY_SIZE);
+            memcpy(ci.salt, param->salt, TLS_CIPHER_AES_GCM_256_SALT_SIZE);
+            memcpy(ci.rec_seq, param->rec_seq, TLS_CIPHER_AES_GCM_256_REC_SEQ_SIZE);
+            return setsockopt(sockfd, SOL_TLS, direction, &ci, sizeof(ci));
+        }
+#endif
+        default:
+            break;
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+int mln_tcp_conn_ktls_set(mln_tcp_conn_t *tc, \
+                          mln_tcp_conn_ktls_param_t *tx, \
+                          mln_tcp_conn_ktls_param_t *rx)
+{
+    if (setsockopt(tc->sockfd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) < 0)
+        return -1;
+    if (tx != NULL && mln_tcp_conn_ktls_direction_set(tc->sockfd, TLS_TX, tx) < 0)
+        return -1;
+    if (rx != NULL && mln_tcp_conn_ktls_direction_set(tc->sockfd, TLS_RX, rx) < 0)
+        return -1;
+    return 0;
+}
+#else
+int mln_tcp_conn_ktls_set(mln_tcp_conn_t *tc, \
+                          mln_tcp_conn_ktls_param_t *tx, \
+                          mln_tcp_conn_ktls_param_t *rx)
+{
+    errno = ENOSYS;
+    return -1;
+}
+#endif
+
 void mln_tcp_conn_destroy(mln_tcp_conn_t *tc)
 {
     if (tc == NULL) return;
@@ -74,9 +165,65 @@ void mln_tcp_conn_destroy(mln_tcp_conn_t *tc)
     mln_chain_pool_release_all(mln_tcp_conn_remove(tc, M_C_SEND));
     mln_chain_pool_release_all(mln_tcp_conn_remove(tc, M_C_RECV));
     mln_chain_pool_release_all(mln_tcp_conn_remove(tc, M_C_SENT));
+    mln_chain_pool_release_all(tc->free_head);
+    tc->free_head = NULL;
+    tc->free_cnt = 0;
     mln_alloc_destroy(tc->pool);
 }
 
+static inline mln_chain_t *
+mln_tcp_conn_chain_fetch(mln_tcp_conn_t *tc)
+{
+    mln_chain_t *c = tc->free_head;
+
+    if (c != NULL) {
+        tc->free_head = c->next;
+        --(tc->free_cnt);
+        c->next = NULL;
+        if (c->buf != NULL) return c;
+        if ((c->buf = mln_buf_new(tc->pool)) == NULL) {
+            mln_alloc_free(c);
+            return NULL;
+        }
+        return c;
+    }
+
+    if ((c = mln_chain_new(tc->pool)) == NULL) return NULL;
+    if ((c->buf = mln_buf_new(tc->pool)) == NULL) {
+        mln_alloc_free(c);
+        return NULL;
+    }
+    return c;
+}
+
+void mln_tcp_conn_chain_release(mln_tcp_conn_t *tc, mln_chain_t *c)
+{
+    mln_chain_t *fr;
+    mln_buf_t *b;
+
+    while (c != NULL) {
+        fr = c;
+        c = c->next;
+        if (tc->free_cnt >= M_CONN_FREE_MAX) {
+            fr->next = NULL;
+            mln_chain_pool_release(fr);
+            continue;
+        }
+        if ((b = fr->buf) != NULL) {
+            if (b->ref > 0) {
+                /*shadows still point at this descriptor, it cannot be reused*/
+                mln_buf_pool_release(b);
+                fr->buf = NULL;
+            } else {
+                mln_buf_reset(b);
+            }
+        }
+        fr->next = tc->free_head;
+        tc->free_head = fr;
+        ++(tc->free_cnt);
+    }
+}
+
 void mln_tcp_conn_append_chain(mln_tcp_conn_t *tc, mln_chain_t *c_head, mln_chain_t *c_tail, int type)
 {
     if (c_head == NULL) return;
@@ -255,8 +402,8 @@ mln_tcp_conn_send_chain_memory(mln_tcp_conn_t *tc)
     mln_buf_t *b;
     ssize_t n, is_done = 0;
     register mln_size_t buf_left_size;
-    int proc_vec, nvec = 256;
-    struct iovec vector[256];
+    int proc_vec, nvec = M_CONN_IOV_MAX;
+    struct iovec vector[M_CONN_IOV_MAX];
 
     if (mln_fd_is_nonblock(tc->sockfd)) {
         while (1) {
@@ -275,6 +422,20 @@ mln_tcp_conn_send_chain_memory(mln_tcp_conn_t *tc)
             }
 
             if (!proc_vec) {
+                for (c = tc->snd_head; c != NULL; c = c->next) {
+                    if (c->buf != NULL && c->buf->in_file) break;
+                }
+                if (c != NULL) {
+                    /*
+                     * Nothing left in memory but file data follows; pop the
+                     * drained links and hand over to the sendfile path.
+                     */
+                    while ((c = tc->snd_head) != NULL && (c->buf == NULL || !c->buf->in_file)) {
+                        c = mln_tcp_conn_pop_inline(tc, M_C_SEND);
+                        mln_tcp_conn_append(tc, c, M_C_SENT);
+                    }
+                    return 0;
+                }
                 if (tc->snd_head != NULL) mln_chain_pool_release_all(tc->snd_head);
                 tc->snd_head = tc->snd_tail = NULL;
                 return 0;
@@ -330,6 +491,20 @@ non:
     }
 
     if (!proc_vec) {
+        for (c = tc->snd_head; c != NULL; c = c->next) {
+            if (c->buf != NULL && c->buf->in_file) break;
+        }
+        if (c != NULL) {
+            /*
+             * Nothing left in memory but file data follows; pop the
+             * drained links and hand over to the sendfile path.
+             */
+            while ((c = tc->snd_head) != NULL && (c->buf == NULL || !c->buf->in_file)) {
+                c = mln_tcp_conn_pop_inline(tc, M_C_SEND);
+                mln_tcp_conn_append(tc, c, M_C_SENT);
+            }
+            return 0;
+        }
         if (tc->snd_head != NULL) mln_chain_pool_release_all(tc->snd_head);
         tc->snd_head = tc->snd_tail = NULL;
         return 0;
@@ -503,7 +678,32 @@ blk:
 #endif
 
 
+#if defined(MLN_SENDFILE) || defined(MLN_SENDFILE_FREEBSD) || defined(MLN_SENDFILE_DARWIN)
+/*
+ * One zero-copy call, hiding the signature differences between the
+ * Linux, FreeBSD and Darwin variants. Advances b->file_left_pos by the
+ * number of bytes moved and returns that count, or -1 with errno set.
+ */
+static inline ssize_t
+mln_tcp_conn_sendfile(int sockfd, mln_buf_t *b, mln_size_t len)
+{
 #if defined(MLN_SENDFILE)
+    return sendfile(sockfd, mln_file_fd(b->file), &b->file_left_pos, len);
+#elif defined(MLN_SENDFILE_FREEBSD)
+    off_t sbytes = 0;
+    if (sendfile(mln_file_fd(b->file), sockfd, b->file_left_pos, len, NULL, &sbytes, 0) < 0 && sbytes == 0)
+        return -1;
+    b->file_left_pos += sbytes;
+    return (ssize_t)sbytes;
+#else /*MLN_SENDFILE_DARWIN*/
+    off_t slen = (off_t)len;
+    if (sendfile(mln_file_fd(b->file), sockfd, b->file_left_pos, &slen, NULL, 0) < 0 && slen == 0)
+        return -1;
+    b->file_left_pos += slen;
+    return (ssize_t)slen;
+#endif
+}
+
 static inline ssize_t
 mln_tcp_conn_send_chain_file(mln_tcp_conn_t *tc)
 {
@@ -526,10 +726,7 @@ mln_tcp_conn_send_chain_file(mln_tcp_conn_t *tc)
 
             if (buf_left_size) {
 non:
-                n = sendfile(sockfd, \
-                             mln_file_fd(b->file), \
-                             &b->file_left_pos, \
-                             buf_left_size);
+                n = mln_tcp_conn_sendfile(sockfd, b, buf_left_size);
                 if (n <= 0) {
                     if (errno == EINTR) goto non;
                     if (errno == EAGAIN) return 0;
@@ -560,10 +757,7 @@ non:
     if (!b->in_file) return 0;
 
 blk:
-    n = sendfile(sockfd, \
-                 mln_file_fd(b->file), \
-                 &b->file_left_pos, \
-                 mln_buf_left_size(b));
+    n = mln_tcp_conn_sendfile(sockfd, b, mln_buf_left_size(b));
     if (n <= 0) {
         if (errno == EINTR) goto blk;
         return -1;
@@ -756,13 +950,11 @@ mln_tcp_conn_recv_chain(mln_tcp_conn_t *tc, mln_u32_t flag)
     mln_chain_t *c;
     mln_alloc_t *pool = mln_tcp_conn_pool_get(tc);
 
-    c = mln_chain_new(pool);
-    b = mln_buf_new(pool);
-    if (c == NULL || b == NULL) {
+    if ((c = mln_tcp_conn_chain_fetch(tc)) == NULL) {
         errno = ENOMEM;
         return -1;
     }
-    c->buf = b;
+    b = c->buf;
 
     if (flag & M_C_TYPE_FILE) {
         if (flag & M_C_TYPE_FOLLOW && tc->rcv_tail != NULL && tc->rcv_tail->buf != NULL) {
@@ -773,13 +965,13 @@ mln_tcp_conn_recv_chain(mln_tcp_conn_t *tc, mln_u32_t flag)
         }
         n = mln_tcp_conn_recv_chain_file(tc->sockfd, pool, b, last);
     } else if (flag & M_C_TYPE_MEMORY) {
-        n = mln_tcp_conn_recv_chain_mem(tc->sockfd, pool, b);
+        n = mln_tcp_conn_recv_chain_mem(tc, b);
     } else {
         ASSERT(0);
     }
 
     if (n <= 0) {
-        mln_chain_pool_release(c);
+        mln_tcp_conn_chain_release(tc, c);
     } else {
         mln_tcp_conn_append(tc, c, M_C_RECV);
     }
@@ -812,6 +1004,7 @@ mln_tcp_conn_recv_chain_file(int sockfd, \
         b->file_left_pos = b->file_pos = last->file_last;
         b->file = last->file;
         last->shadow = b;
+        ++(b->ref);/*'b' owns the file now, keep it until 'last' drops too*/
     }
     b->file_last = b->file_pos + n;
     b->in_file = 1;
@@ -825,27 +1018,40 @@ mln_tcp_conn_recv_chain_file(int sockfd, \
 }
 
 static inline int
-mln_tcp_conn_recv_chain_mem(int sockfd, mln_alloc_t *pool, mln_buf_t *b)
+mln_tcp_conn_recv_chain_mem(mln_tcp_conn_t *tc, mln_buf_t *b)
 {
     mln_u8ptr_t buf;
+    mln_size_t bufsize = tc->rcv_bufsize;
     int n;
 
-    buf = (mln_u8ptr_t)mln_alloc_m(pool, 1024);
+    buf = (mln_u8ptr_t)mln_alloc_m(tc->pool, bufsize);
     if (buf == NULL) {
         errno = ENOMEM;
         return -1;
     }
 
 #if defined(WIN32)
-    n = recv(sockfd, (char *)buf, 1024, 0);
+    n = recv(tc->sockfd, (char *)buf, bufsize, 0);
 #else
-    n = recv(sockfd, buf, 1024, 0);
+    n = recv(tc->sockfd, buf, bufsize, 0);
 #endif
     if (n <= 0) {
         mln_alloc_free(buf);
         return n;
     }
 
+    /*
+     * Filled completely means the socket probably had more, so double
+     * the next read; well under half full means the peer sends small
+     * messages, so shrink back. The pool recycles freed chunks by size
+     * class, so a stable size also means recycled buffers.
+     */
+    if ((mln_size_t)n == bufsize) {
+        if (bufsize < M_CONN_RCVBUF_MAX) tc->rcv_bufsize = bufsize << 1;
+    } else if ((mln_size_t)n < (bufsize >> 2)) {
+        if (bufsize > M_CONN_RCVBUF_MIN) tc->rcv_bufsize = bufsize >> 1;
+    }
+
     b->left_pos = b->pos = b->start = buf;
     b->last = b->end = buf + n;
     b->in_memory = 1;
@@ -854,3 +1060,227 @@ mln_tcp_conn_recv_chain_mem(int sockfd, mln_alloc_t *pool, mln_buf_t *b)
     return n;
 }
 
+
+
+/*
+ * mln_udp_conn_t
+ */
+
+struct mln_udp_dgram_node_s {
+    mln_udp_dgram_node_t *next;
+    struct sockaddr_storage addr;
+    mln_u32_t             addr_len;
+    mln_size_t            len;
+    /*payload follows the node*/
+};
+
+/*MTU-sized media/RPC datagrams; callers can raise it for jumbo frames*/
+#define M_CONN_UDP_BUFSIZE 2048
+
+int mln_udp_conn_init(mln_udp_conn_t *uc, int sockfd)
+{
+    uc->pool = mln_alloc_init(NULL);
+    if (uc->pool == NULL) return -1;
+    uc->snd_head = uc->snd_tail = NULL;
+    uc->snd_nr = 0;
+    uc->rcv_bufsize = M_CONN_UDP_BUFSIZE;
+    uc->sockfd = sockfd;
+    return 0;
+}
+
+void mln_udp_conn_destroy(mln_udp_conn_t *uc)
+{
+    if (uc == NULL) return;
+    uc->snd_head = uc->snd_tail = NULL;
+    uc->snd_nr = 0;
+    mln_alloc_destroy(uc->pool);
+}
+
+int mln_udp_conn_append(mln_udp_conn_t *uc, \
+                        void *buf, \
+                        mln_size_t len, \
+                        struct sockaddr *addr, \
+                        mln_u32_t addr_len)
+{
+    mln_udp_dgram_node_t *n;
+
+    if (addr_len > sizeof(n->addr)) {
+        errno = EINVAL;
+        return -1;
+    }
+    n = (mln_udp_dgram_node_t *)mln_alloc_m(uc->pool, sizeof(mln_udp_dgram_node_t) + len);
+    if (n == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    n->next = NULL;
+    if (addr != NULL && addr_len) {
+        memcpy(&n->addr, addr, addr_len);
+        n->addr_len = addr_len;
+    } else {
+        n->addr_len = 0;
+    }
+    n->len = len;
+    memcpy(n + 1, buf, len);
+
+    if (uc->snd_tail == NULL) {
+        uc->snd_head = uc->snd_tail = n;
+    } else {
+        uc->snd_tail->next = n;
+        uc->snd_tail = n;
+    }
+    ++(uc->snd_nr);
+    return 0;
+}
+
+static inline void mln_udp_conn_sent(mln_udp_conn_t *uc, int nsent)
+{
+    mln_udp_dgram_node_t *n;
+
+    while (nsent-- > 0 && (n = uc->snd_head) != NULL) {
+        if ((uc->snd_head = n->next) == NULL) uc->snd_tail = NULL;
+        --(uc->snd_nr);
+        mln_alloc_free(n);
+    }
+}
+
+#if defined(MLN_MMSG)
+int mln_udp_conn_send(mln_udp_conn_t *uc)
+{
+    struct mmsghdr msgs[M_C_UDP_BATCH_MAX];
+    struct iovec iovs[M_C_UDP_BATCH_MAX];
+    mln_udp_dgram_node_t *n;
+    unsigned int i;
+    int r;
+
+    while (uc->snd_head != NULL) {
+        for (i = 0, n = uc->snd_head; n != NULL && i < M_C_UDP_BATCH_MAX; n = n->next, ++i) {
+            iovs[i].iov_base = n + 1;
+            iovs[i].iov_len = n->len;
+            memset(&msgs[i], 0, sizeof(msgs[i]));
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            if (n->addr_len) {
+                msgs[i].msg_hdr.msg_name = &n->addr;
+                msgs[i].msg_hdr.msg_namelen = n->addr_len;
+            }
+        }
+        r = sendmmsg(uc->sockfd, msgs, i, 0);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return M_C_NOTYET;
+            return M_C_ERROR;
+        }
+        mln_udp_conn_sent(uc, r);
+    }
+    return M_C_FINISH;
+}
+
+int mln_udp_conn_recv(mln_udp_conn_t *uc, mln_udp_dgram_t *dgrams, mln_size_t ndgrams)
+{
+    struct mmsghdr msgs[M_C_UDP_BATCH_MAX];
+    struct iovec iovs[M_C_UDP_BATCH_MAX];
+    mln_size_t i;
+    int r;
+
+    if (ndgrams > M_C_UDP_BATCH_MAX) ndgrams = M_C_UDP_BATCH_MAX;
+    for (i = 0; i < ndgrams; ++i) {
+        dgrams[i].data = (mln_u8ptr_t)mln_alloc_m(uc->pool, uc->rcv_bufsize);
+        if (dgrams[i].data == NULL) {
+            while (i > 0) mln_alloc_free(dgrams[--i].data);
+            errno = ENOMEM;
+            return -1;
+        }
+        iovs[i].iov_base = dgrams[i].data;
+        iovs[i].iov_len = uc->rcv_bufsize;
+        memset(&msgs[i], 0, sizeof(msgs[i]));
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &dgrams[i].addr;
+        msgs[i].msg_hdr.msg_namelen = sizeof(dgrams[i].addr);
+    }
+
+    do {
+        r = recvmmsg(uc->sockfd, msgs, ndgrams, 0, NULL);
+    } while (r < 0 && errno == EINTR);
+    if (r < 0) {
+        for (i = 0; i < ndgrams; ++i) mln_alloc_free(dgrams[i].data);
+        return (errno == EAGAIN || errno == EWOULDBLOCK)? 0: -1;
+    }
+
+    for (i = 0; i < (mln_size_t)r; ++i) {
+        dgrams[i].len = msgs[i].msg_len;
+        dgrams[i].addr_len = msgs[i].msg_hdr.msg_namelen;
+    }
+    for (; i < ndgrams; ++i) {
+        mln_alloc_free(dgrams[i].data);
+        dgrams[i].data = NULL;
+    }
+    return r;
+}
+#else
+int mln_udp_conn_send(mln_udp_conn_t *uc)
+{
+    mln_udp_dgram_node_t *n;
+    int r;
+
+    while ((n = uc->snd_head) != NULL) {
+#if defined(WIN32)
+        r = sendto(uc->sockfd, (char *)(n + 1), n->len, 0, \
+                   n->addr_len? (struct sockaddr *)&n->addr: NULL, n->addr_len);
+#else
+        r = sendto(uc->sockfd, n + 1, n->len, 0, \
+                   n->addr_len? (struct sockaddr *)&n->addr: NULL, n->addr_len);
+#endif
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return M_C_NOTYET;
+            return M_C_ERROR;
+        }
+        mln_udp_conn_sent(uc, 1);
+    }
+    return M_C_FINISH;
+}
+
+int mln_udp_conn_recv(mln_udp_conn_t *uc, mln_udp_dgram_t *dgrams, mln_size_t ndgrams)
+{
+    mln_size_t i;
+    socklen_t alen;
+    int r;
+
+    if (ndgrams > M_C_UDP_BATCH_MAX) ndgrams = M_C_UDP_BATCH_MAX;
+    for (i = 0; i < ndgrams; ) {
+        dgrams[i].data = (mln_u8ptr_t)mln_alloc_m(uc->pool, uc->rcv_bufsize);
+        if (dgrams[i].data == NULL) {
+            errno = ENOMEM;
+            goto err;
+        }
+        alen = sizeof(dgrams[i].addr);
+#if defined(WIN32)
+        r = recvfrom(uc->sockfd, (char *)dgrams[i].data, uc->rcv_bufsize, 0, \
+                     (struct sockaddr *)&dgrams[i].addr, (int *)&alen);
+#else
+        r = recvfrom(uc->sockfd, dgrams[i].data, uc->rcv_bufsize, 0, \
+                     (struct sockaddr *)&dgrams[i].addr, &alen);
+#endif
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            mln_alloc_free(dgrams[i].data);
+            dgrams[i].data = NULL;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            goto err;
+        }
+        dgrams[i].len = r;
+        dgrams[i].addr_len = alen;
+        ++i;
+    }
+    return (int)i;
+
+err:
+    while (i > 0) {
+        mln_alloc_free(dgrams[--i].data);
+        dgrams[i].data = NULL;
+    }
+    return -1;
+}
+#endif
@@ -404,3 +404,217 @@ static long mln_cron_parse_week(mln_string_t *sweek, long week, int greater)
     return save;
 }
 
+
+/*
+ * Compiled expressions and the next-fire scheduler.
+ */
+static int mln_cron_field_compile(mln_u64_t *mask, mln_string_t *field, long lo, long hi)
+{
+    mln_u8ptr_t p = field->data, end = field->data + field->len;
+    long a, b, step, ranged;
+
+    if (!field->len) return -1;
+    *mask = 0;
+    while (p < end) {
+        step = 1;
+        ranged = 0;
+        if (*p == '*') {
+            ++p;
+            a = lo;
+            b = hi;
+            ranged = 1;
+        } else {
+            if (!isdigit(*p)) return -1;
+            for (a = 0; p < end && isdigit(*p); ++p) a = a * 10 + (*p - '0');
+            b = a;
+            if (p < end && *p == '-') {
+                if (++p >= end || !isdigit(*p)) return -1;
+                for (b = 0; p < end && isdigit(*p); ++p) b = b * 10 + (*p - '0');
+                ranged = 1;
+            }
+        }
+        if (p < end && *p == '/') {
+            if (++p >= end || !isdigit(*p)) return -1;
+            for (step = 0; p < end && isdigit(*p); ++p) step = step * 10 + (*p - '0');
+            if (step < 1) return -1;
+            if (!ranged) b = hi; /* 'a/n' runs from a to the field maximum */
+        }
+        if (a < lo || b > hi || a > b) return -1;
+        for (; a <= b; a += step) *mask |= ((mln_u64_t)1 << a);
+        if (p < end) {
+            if (*p != ',' || ++p >= end) return -1;
+        }
+    }
+    return 0;
+}
+
+int mln_cron_compile(mln_cron_t *c, mln_string_t *exp)
+{
+    mln_string_t *arr;
+    mln_u64_t mask;
+    mln_size_t n;
+
+    if ((arr = mln_string_slice(exp, " \t")) == NULL) return -1;
+    for (n = 0; arr[n].len != 0; ++n)
+        ;
+    if (n != 5) {
+        mln_string_slice_free(arr);
+        return -1;
+    }
+    if (mln_cron_field_compile(&mask, &arr[0], 0, 59) < 0) goto err;
+    c->minutes = mask;
+    if (mln_cron_field_compile(&mask, &arr[1], 0, 23) < 0) goto err;
+    c->hours = (mln_u32_t)mask;
+    if (mln_cron_field_compile(&mask, &arr[2], 1, 31) < 0) goto err;
+    c->days = (mln_u32_t)mask;
+    if (mln_cron_field_compile(&mask, &arr[3], 1, 12) < 0) goto err;
+    c->months = (mln_u16_t)mask;
+    if (mln_cron_field_compile(&mask, &arr[4], 0, 7) < 0) goto err;
+    if (mask & ((mln_u64_t)1 << 7)) mask |= 1; /* 7 is Sunday too */
+    c->weeks = (mln_u8_t)(mask & 0x7f);
+    mln_string_slice_free(arr);
+    return 0;
+err:
+    mln_string_slice_free(arr);
+    return -1;
+}
+
+time_t mln_cron_next(mln_cron_t *c, time_t base)
+{
+    struct utctime u;
+    int guard;
+
+    mln_time2utc(base + 60, &u);
+    u.second = 0;
+    /*
+     * Jump field by field from the coarsest mismatch; the guard bounds
+     * unsatisfiable dates (e.g. Feb 30) which otherwise step one day
+     * forever.
+     */
+    for (guard = 0; guard < 3072; ++guard) {
+        if (!(c->months & ((mln_u32_t)1 << u.month))) {
+            ++u.month;
+            u.day = 1;
+            u.hour = 0;
+            u.minute = 0;
+            mln_utc_adjust(&u);
+            continue;
+        }
+        if (!(c->days & ((mln_u32_t)1 << u.day)) || !(c->weeks & (1 << u.week))) {
+            ++u.day;
+            u.hour = 0;
+            u.minute = 0;
+            mln_utc_adjust(&u);
+            continue;
+        }
+        if (!(c->hours & ((mln_u32_t)1 << u.hour))) {
+            ++u.hour;
+            u.minute = 0;
+            mln_utc_adjust(&u);
+            continue;
+        }
+        if (!(c->minutes & ((mln_u64_t)1 << u.minute))) {
+            ++u.minute;
+            mln_utc_adjust(&u);
+            continue;
+        }
+        return mln_utc2time(&u);
+    }
+    return 0;
+}
+
+static int mln_cron_sched_cmp(const void *k1, const void *k2)
+{
+    return ((mln_cron_task_t *)k1)->next < ((mln_cron_task_t *)k2)->next? 0: 1;
+}
+
+static void mln_cron_sched_copy(void *k1, void *k2)
+{
+    ((mln_cron_task_t *)k1)->next = ((mln_cron_task_t *)k2)->next;
+}
+
+mln_cron_sched_t *mln_cron_sched_new(void)
+{
+    static mln_cron_task_t min_task = {{0, 0, 0, 0, 0}, 0, NULL, NULL};
+    struct mln_fheap_attr attr;
+    mln_cron_sched_t *s;
+
+    if ((s = (mln_cron_sched_t *)malloc(sizeof(mln_cron_sched_t))) == NULL)
+        return NULL;
+    memset(&attr, 0, sizeof(attr));
+    attr.cmp = mln_cron_sched_cmp;
+    attr.copy = mln_cron_sched_copy;
+    if ((s->heap = mln_fheap_pairing_new(&min_task, &attr)) == NULL) {
+        free(s);
+        return NULL;
+    }
+    return s;
+}
+
+void mln_cron_sched_free(mln_cron_sched_t *s)
+{
+    mln_fheap_node_t *node;
+
+    if (s == NULL) return;
+    while ((node = mln_fheap_extract_min(s->heap)) != NULL) {
+        free(mln_fheap_node_key(node));
+        mln_fheap_node_free(s->heap, node);
+    }
+    mln_fheap_free(s->heap);
+    free(s);
+}
+
+mln_cron_task_t *mln_cron_sched_add(mln_cron_sched_t *s, mln_string_t *exp, time_t base, void *data)
+{
+    mln_cron_task_t *t;
+
+    if ((t = (mln_cron_task_t *)malloc(sizeof(mln_cron_task_t))) == NULL)
+        return NULL;
+    if (mln_cron_compile(&t->cron, exp) < 0 || (t->next = mln_cron_next(&t->cron, base)) == 0) {
+        free(t);
+        return NULL;
+    }
+    t->data = data;
+    if ((t->node = mln_fheap_node_new(s->heap, t)) == NULL) {
+        free(t);
+        return NULL;
+    }
+    mln_fheap_insert(s->heap, t->node);
+    return t;
+}
+
+void mln_cron_sched_remove(mln_cron_sched_t *s, mln_cron_task_t *t)
+{
+    if (t->node != NULL) {
+        mln_fheap_delete(s->heap, t->node);
+        mln_fheap_node_free(s->heap, t->node);
+    }
+    free(t);
+}
+
+mln_cron_task_t *mln_cron_sched_pop(mln_cron_sched_t *s, time_t now)
+{
+    mln_fheap_node_t *node;
+    mln_cron_task_t *t;
+    time_t fired;
+
+    if ((node = mln_fheap_minimum(s->heap)) == NULL) return NULL;
+    t = (mln_cron_task_t *)mln_fheap_node_key(node);
+    if (t->next > now) return NULL;
+
+    node = mln_fheap_extract_min(s->heap);
+    mln_fheap_node_free(s->heap, node);
+    fired = t->next;
+    /*reschedule from 'now' so missed ticks collapse into one firing*/
+    if ((t->next = mln_cron_next(&t->cron, now > fired? now: fired)) == 0) {
+        t->node = NULL;
+        return t;
+    }
+    if ((t->node = mln_fheap_node_new(s->heap, t)) == NULL) {
+        t->node = NULL;
+        t->next = 0;
+        return t;
+    }
+    mln_fheap_insert(s->heap, t->node);
+    return t;
+}
@@ -0,0 +1,563 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "mln_deflate.h"
+
+#define M_DEFLATE_MAX_BITS   15
+#define M_DEFLATE_MAX_LCODES 286
+#define M_DEFLATE_MAX_DCODES 30
+#define M_DEFLATE_FIX_LCODES 288
+#define M_DEFLATE_HASH_SIZE  (1<<15)
+#define M_DEFLATE_MAX_CHAIN  128
+#define M_DEFLATE_MAX_MATCH  258
+#define M_DEFLATE_MIN_MATCH  3
+
+struct mln_deflate_bits_s {
+    mln_u8ptr_t  p;
+    mln_u8ptr_t  end;
+    mln_u32_t    bitbuf;
+    mln_u32_t    bitcnt;
+};
+
+struct mln_deflate_huff_s {
+    mln_u16_t   *count;
+    mln_u16_t   *symbol;
+};
+
+struct mln_deflate_buf_s {
+    mln_alloc_t *pool;
+    mln_u8ptr_t  buf;
+    mln_size_t   len;
+    mln_size_t   size;
+    mln_u32_t    bitbuf;
+    mln_u32_t    bitcnt;
+};
+
+static const mln_u16_t mln_deflate_lens[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const mln_u16_t mln_deflate_lext[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const mln_u16_t mln_deflate_dists[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const mln_u16_t mln_deflate_dext[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+mln_deflate_t *mln_deflate_new(mln_alloc_t *pool, int takeover)
+{
+    mln_deflate_t *ctx = (mln_deflate_t *)mln_alloc_m(pool, sizeof(mln_deflate_t));
+    if (ctx == NULL) return NULL;
+    ctx->window = (mln_u8ptr_t)mln_alloc_m(pool, M_DEFLATE_WINDOW_SIZE);
+    if (ctx->window == NULL) {
+        mln_alloc_free(ctx);
+        return NULL;
+    }
+    ctx->pool = pool;
+    ctx->wlen = 0;
+    ctx->takeover = takeover? 1: 0;
+    ctx->padding = 0;
+    return ctx;
+}
+
+void mln_deflate_free(mln_deflate_t *ctx)
+{
+    if (ctx == NULL) return;
+    if (ctx->window != NULL) mln_alloc_free(ctx->window);
+    mln_alloc_free(ctx);
+}
+
+void mln_deflate_reset(mln_deflate_t *ctx)
+{
+    if (ctx == NULL) return;
+    ctx->wlen = 0;
+}
+
+static inline void
+mln_deflate_window_update(mln_deflate_t *ctx, mln_u8ptr_t data, mln_size_t len)
+{
+    mln_size_t keep;
+
+    if (!ctx->takeover) {
+        ctx->wlen = 0;
+        return;
+    }
+    if (len >= M_DEFLATE_WINDOW_SIZE) {
+        memcpy(ctx->window, data + len - M_DEFLATE_WINDOW_SIZE, M_DEFLATE_WINDOW_SIZE);
+        ctx->wlen = M_DEFLATE_WINDOW_SIZE;
+        return;
+    }
+    keep = M_DEFLATE_WINDOW_SIZE - len;
+    if (ctx->wlen < keep) keep = ctx->wlen;
+    if (keep) memmove(ctx->window, ctx->window + ctx->wlen - keep, keep);
+    memcpy(ctx->window + keep, data, len);
+    ctx->wlen = keep + len;
+}
+
+/*
+ * decompression
+ */
+
+static inline int mln_deflate_bits_get(struct mln_deflate_bits_s *s, int need)
+{
+    mln_u32_t val = s->bitbuf;
+
+    while (s->bitcnt < (mln_u32_t)need) {
+        if (s->p >= s->end) return -1;
+        val |= ((mln_u32_t)(*(s->p)++)) << s->bitcnt;
+        s->bitcnt += 8;
+    }
+    s->bitbuf = val >> need;
+    s->bitcnt -= need;
+
+    return (int)(val & ((1 << need) - 1));
+}
+
+static int
+mln_deflate_huff_construct(struct mln_deflate_huff_s *h, mln_u16_t *length, int n)
+{
+    int symbol, len, left;
+    mln_u16_t offs[M_DEFLATE_MAX_BITS+1];
+
+    for (len = 0; len <= M_DEFLATE_MAX_BITS; ++len) h->count[len] = 0;
+    for (symbol = 0; symbol < n; ++symbol) ++(h->count[length[symbol]]);
+    if (h->count[0] == n) return 0;
+
+    left = 1;
+    for (len = 1; len <= M_DEFLATE_MAX_BITS; ++len) {
+        left <<= 1;
+        left -= h->count[len];
+        if (left < 0) return left;
+    }
+
+    offs[1] = 0;
+    for (len = 1; len < M_DEFLATE_MAX_BITS; ++len)
+        offs[len+1] = offs[len] + h->count[len];
+    for (symbol = 0; symbol < n; ++symbol) {
+        if (length[symbol] != 0)
+            h->symbol[offs[length[symbol]]++] = symbol;
+    }
+
+    return left;
+}
+
+static inline int
+mln_deflate_huff_decode(struct mln_deflate_bits_s *s, struct mln_deflate_huff_s *h)
+{
+    int len, code = 0, first = 0, index = 0, count, bit;
+
+    for (len = 1; len <= M_DEFLATE_MAX_BITS; ++len) {
+        if ((bit = mln_deflate_bits_get(s, 1)) < 0) return -1;
+        code |= bit;
+        count = h->count[len];
+        if (code - count < first)
+            return h->symbol[index + (code - first)];
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+
+    return -1;
+}
+
+static inline int mln_deflate_buf_put(struct mln_deflate_buf_s *o, mln_u8_t c)
+{
+    if (o->len >= o->size) {
+        mln_size_t size = o->size << 1;
+        mln_u8ptr_t buf = (mln_u8ptr_t)mln_alloc_m(o->pool, size);
+        if (buf == NULL) return -1;
+        memcpy(buf, o->buf, o->len);
+        mln_alloc_free(o->buf);
+        o->buf = buf;
+        o->size = size;
+    }
+    o->buf[o->len++] = c;
+    return 0;
+}
+
+static int
+mln_deflate_codes(mln_deflate_t *ctx, \
+                  struct mln_deflate_bits_s *s, \
+                  struct mln_deflate_buf_s *o, \
+                  struct mln_deflate_huff_s *lencode, \
+                  struct mln_deflate_huff_s *distcode)
+{
+    int symbol, len, dist, extra;
+    mln_u8_t c;
+
+    do {
+        symbol = mln_deflate_huff_decode(s, lencode);
+        if (symbol < 0) return -1;
+        if (symbol < 256) {
+            if (mln_deflate_buf_put(o, (mln_u8_t)symbol) < 0) return -1;
+        } else if (symbol > 256) {
+            symbol -= 257;
+            if (symbol >= 29) return -1;
+            len = mln_deflate_lens[symbol];
+            if (mln_deflate_lext[symbol]) {
+                if ((extra = mln_deflate_bits_get(s, mln_deflate_lext[symbol])) < 0) return -1;
+                len += extra;
+            }
+            symbol = mln_deflate_huff_decode(s, distcode);
+            if (symbol < 0 || symbol >= 30) return -1;
+            dist = mln_deflate_dists[symbol];
+            if (mln_deflate_dext[symbol]) {
+                if ((extra = mln_deflate_bits_get(s, mln_deflate_dext[symbol])) < 0) return -1;
+                dist += extra;
+            }
+            if ((mln_size_t)dist > o->len + ctx->wlen) return -1;
+            while (len-- > 0) {
+                if ((mln_size_t)dist <= o->len)
+                    c = o->buf[o->len - dist];
+                else
+                    c = ctx->window[ctx->wlen - (dist - o->len)];
+                if (mln_deflate_buf_put(o, c) < 0) return -1;
+            }
+        }
+    } while (symbol != 256);
+
+    return 0;
+}
+
+static int mln_deflate_stored(struct mln_deflate_bits_s *s, struct mln_deflate_buf_s *o)
+{
+    mln_u32_t len, nlen;
+
+    s->bitbuf = 0;
+    s->bitcnt = 0;
+    if (s->end - s->p < 4) return -1;
+    len = s->p[0] | (((mln_u32_t)(s->p[1])) << 8);
+    nlen = s->p[2] | (((mln_u32_t)(s->p[3])) << 8);
+    if (len != (~nlen & 0xffff)) return -1;
+    s->p += 4;
+    if ((mln_size_t)(s->end - s->p) < len) return -1;
+    for (; len > 0; --len) {
+        if (mln_deflate_buf_put(o, *(s->p)++) < 0) return -1;
+    }
+    return 0;
+}
+
+static int
+mln_deflate_fixed(mln_deflate_t *ctx, struct mln_deflate_bits_s *s, struct mln_deflate_buf_s *o)
+{
+    int symbol;
+    mln_u16_t lengths[M_DEFLATE_FIX_LCODES];
+    mln_u16_t lencnt[M_DEFLATE_MAX_BITS+1], lensym[M_DEFLATE_FIX_LCODES];
+    mln_u16_t distcnt[M_DEFLATE_MAX_BITS+1], distsym[M_DEFLATE_MAX_DCODES];
+    struct mln_deflate_huff_s lencode = {lencnt, lensym}, distcode = {distcnt, distsym};
+
+    for (symbol = 0; symbol < 144; ++symbol) lengths[symbol] = 8;
+    for (; symbol < 256; ++symbol) lengths[symbol] = 9;
+    for (; symbol < 280; ++symbol) lengths[symbol] = 7;
+    for (; symbol < M_DEFLATE_FIX_LCODES; ++symbol) lengths[symbol] = 8;
+    if (mln_deflate_huff_construct(&lencode, lengths, M_DEFLATE_FIX_LCODES) < 0) return -1;
+
+    for (symbol = 0; symbol < M_DEFLATE_MAX_DCODES; ++symbol) lengths[symbol] = 5;
+    if (mln_deflate_huff_construct(&distcode, lengths, M_DEFLATE_MAX_DCODES) < 0) return -1;
+
+    return mln_deflate_codes(ctx, s, o, &lencode, &distcode);
+}
+
+static int
+mln_deflate_dynamic(mln_deflate_t *ctx, struct mln_deflate_bits_s *s, struct mln_deflate_buf_s *o)
+{
+    int nlen, ndist, ncode, index, err, symbol, len;
+    mln_u16_t lengths[M_DEFLATE_MAX_LCODES+M_DEFLATE_MAX_DCODES];
+    mln_u16_t lencnt[M_DEFLATE_MAX_BITS+1], lensym[M_DEFLATE_MAX_LCODES];
+    mln_u16_t distcnt[M_DEFLATE_MAX_BITS+1], distsym[M_DEFLATE_MAX_DCODES];
+    struct mln_deflate_huff_s lencode = {lencnt, lensym}, distcode = {distcnt, distsym};
+    static const mln_u16_t order[19] = {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+    };
+
+    if ((nlen = mln_deflate_bits_get(s, 5)) < 0) return -1;
+    nlen += 257;
+    if ((ndist = mln_deflate_bits_get(s, 5)) < 0) return -1;
+    ndist += 1;
+    if ((ncode = mln_deflate_bits_get(s, 4)) < 0) return -1;
+    ncode += 4;
+    if (nlen > M_DEFLATE_MAX_LCODES || ndist > M_DEFLATE_MAX_DCODES) return -1;
+
+    for (index = 0; index < ncode; ++index) {
+        if ((err = mln_deflate_bits_get(s, 3)) < 0) return -1;
+        lengths[order[index]] = err;
+    }
+    for (; index < 19; ++index) lengths[order[index]] = 0;
+    if (mln_deflate_huff_construct(&lencode, lengths, 19) != 0) return -1;
+
+    index = 0;
+    while (index < nlen + ndist) {
+        symbol = mln_deflate_huff_decode(s, &lencode);
+        if (symbol < 0) return -1;
+        if (symbol < 16) {
+            lengths[index++] = symbol;
+        } else {
+            len = 0;
+            if (symbol == 16) {
+                if (index == 0) return -1;
+                len = lengths[index-1];
+                if ((symbol = mln_deflate_bits_get(s, 2)) < 0) return -1;
+                symbol += 3;
+            } else if (symbol == 17) {
+                if ((symbol = mln_deflate_bits_get(s, 3)) < 0) return -1;
+                symbol += 3;
+            } else {
+                if ((symbol = mln_deflate_bits_get(s, 7)) < 0) return -1;
+                symbol += 11;
+            }
+            if (index + symbol > nlen + ndist) return -1;
+            while (symbol-- > 0) lengths[index++] = len;
+        }
+    }
+    if (lengths[256] == 0) return -1;
+
+    err = mln_deflate_huff_construct(&lencode, lengths, nlen);
+    if (err < 0 || (err > 0 && nlen - lencode.count[0] != 1)) return -1;
+    err = mln_deflate_huff_construct(&distcode, lengths+nlen, ndist);
+    if (err < 0 || (err > 0 && ndist - distcode.count[0] != 1)) return -1;
+
+    return mln_deflate_codes(ctx, s, o, &lencode, &distcode);
+}
+
+int mln_deflate_decompress(mln_deflate_t *ctx, \
+                           mln_u8ptr_t in, \
+                           mln_size_t inlen, \
+                           mln_u8ptr_t *out, \
+                           mln_size_t *outlen)
+{
+    int last, type, err = 0;
+    struct mln_deflate_bits_s s;
+    struct mln_deflate_buf_s o;
+
+    if (ctx == NULL || out == NULL || outlen == NULL) return -1;
+
+    s.p = in;
+    s.end = in + inlen;
+    s.bitbuf = 0;
+    s.bitcnt = 0;
+    o.pool = ctx->pool;
+    o.len = 0;
+    o.size = (inlen << 1) + 64;
+    o.buf = (mln_u8ptr_t)mln_alloc_m(o.pool, o.size);
+    if (o.buf == NULL) return -1;
+
+    for (;;) {
+        if (s.p >= s.end && s.bitcnt == 0) break;/*stream ends on a block boundary*/
+        if ((last = mln_deflate_bits_get(&s, 1)) < 0 || \
+            (type = mln_deflate_bits_get(&s, 2)) < 0)
+        {
+            err = -1;
+            break;
+        }
+        if (type == 0) {
+            err = mln_deflate_stored(&s, &o);
+        } else if (type == 1) {
+            err = mln_deflate_fixed(ctx, &s, &o);
+        } else if (type == 2) {
+            err = mln_deflate_dynamic(ctx, &s, &o);
+        } else {
+            err = -1;
+        }
+        if (err || last) break;
+    }
+    if (err) {
+        mln_alloc_free(o.buf);
+        return -1;
+    }
+
+    mln_deflate_window_update(ctx, o.buf, o.len);
+    *out = o.buf;
+    *outlen = o.len;
+    return 0;
+}
+
+/*
+ * compression (fixed Huffman codes with an LZ77 hash-chain matcher)
+ */
+
+static inline int mln_deflate_wr_byte(struct mln_deflate_buf_s *w, mln_u8_t c)
+{
+    return mln_deflate_buf_put(w, c);
+}
+
+static inline int mln_deflate_wr_bits(struct mln_deflate_buf_s *w, mln_u32_t val, int n)
+{
+    w->bitbuf |= (val & ((1 << n) - 1)) << w->bitcnt;
+    w->bitcnt += n;
+    while (w->bitcnt >= 8) {
+        if (mln_deflate_wr_byte(w, w->bitbuf & 0xff) < 0) return -1;
+        w->bitbuf >>= 8;
+        w->bitcnt -= 8;
+    }
+    return 0;
+}
+
+/*huffman codes are transmitted most-significant bit first*/
+static inline int mln_deflate_wr_code(struct mln_deflate_buf_s *w, mln_u32_t code, int n)
+{
+    int i;
+    for (i = n - 1; i >= 0; --i) {
+        if (mln_deflate_wr_bits(w, (code >> i) & 1, 1) < 0) return -1;
+    }
+    return 0;
+}
+
+static inline int mln_deflate_wr_sym(struct mln_deflate_buf_s *w, int sym)
+{
+    if (sym < 144) return mln_deflate_wr_code(w, 0x30 + sym, 8);
+    if (sym < 256) return mln_deflate_wr_code(w, 0x190 + sym - 144, 9);
+    if (sym < 280) return mln_deflate_wr_code(w, sym - 256, 7);
+    return mln_deflate_wr_code(w, 0xc0 + sym - 280, 8);
+}
+
+static inline int mln_deflate_wr_match(struct mln_deflate_buf_s *w, int len, int dist)
+{
+    int ci;
+
+    for (ci = 0; ci < 28 && mln_deflate_lens[ci+1] <= (mln_u16_t)len; ++ci)
+        ;
+    if (mln_deflate_wr_sym(w, 257 + ci) < 0) return -1;
+    if (mln_deflate_lext[ci] && \
+        mln_deflate_wr_bits(w, len - mln_deflate_lens[ci], mln_deflate_lext[ci]) < 0)
+        return -1;
+
+    for (ci = 0; ci < 29 && mln_deflate_dists[ci+1] <= (mln_u16_t)dist; ++ci)
+        ;
+    if (mln_deflate_wr_code(w, ci, 5) < 0) return -1;
+    if (mln_deflate_dext[ci] && \
+        mln_deflate_wr_bits(w, dist - mln_deflate_dists[ci], mln_deflate_dext[ci]) < 0)
+        return -1;
+
+    return 0;
+}
+
+static inline mln_u32_t mln_deflate_hash(mln_u8ptr_t p)
+{
+    return ((((mln_u32_t)p[0]) << 10) ^ (((mln_u32_t)p[1]) << 5) ^ p[2]) & (M_DEFLATE_HASH_SIZE - 1);
+}
+
+int mln_deflate_compress(mln_deflate_t *ctx, \
+                         mln_u8ptr_t in, \
+                         mln_size_t inlen, \
+                         mln_u8ptr_t *out, \
+                         mln_size_t *outlen)
+{
+    mln_u8ptr_t work = in;
+    mln_s32_t *head = NULL, *prev = NULL, cand;
+    mln_size_t wlen, total, pos, i, limit;
+    int len, best_len, best_dist, chain, err = -1;
+    struct mln_deflate_buf_s w;
+
+    if (ctx == NULL || out == NULL || outlen == NULL) return -1;
+    if (in == NULL && inlen) return -1;
+
+    wlen = ctx->wlen;
+    total = wlen + inlen;
+    w.pool = ctx->pool;
+    w.len = 0;
+    w.bitbuf = 0;
+    w.bitcnt = 0;
+    w.size = inlen + (inlen >> 3) + 64;
+    w.buf = (mln_u8ptr_t)mln_alloc_m(w.pool, w.size);
+    if (w.buf == NULL) return -1;
+
+    if (wlen) {
+        work = (mln_u8ptr_t)mln_alloc_m(ctx->pool, total);
+        if (work == NULL) goto out;
+        memcpy(work, ctx->window, wlen);
+        memcpy(work + wlen, in, inlen);
+    }
+    if (total >= M_DEFLATE_MIN_MATCH) {
+        head = (mln_s32_t *)mln_alloc_m(ctx->pool, M_DEFLATE_HASH_SIZE * sizeof(mln_s32_t));
+        prev = (mln_s32_t *)mln_alloc_m(ctx->pool, total * sizeof(mln_s32_t));
+        if (head == NULL || prev == NULL) goto out;
+        for (i = 0; i < M_DEFLATE_HASH_SIZE; ++i) head[i] = -1;
+        for (i = 0; i + M_DEFLATE_MIN_MATCH - 1 < total && i < wlen; ++i) {
+            mln_u32_t h = mln_deflate_hash(work + i);
+            prev[i] = head[h];
+            head[h] = i;
+        }
+    }
+
+    /*one fixed-huffman block (BFINAL=0) holding the whole message*/
+    if (mln_deflate_wr_bits(&w, 0, 1) < 0 || mln_deflate_wr_bits(&w, 1, 2) < 0) goto out;
+
+    pos = wlen;
+    while (pos < total) {
+        best_len = 0;
+        best_dist = 0;
+        if (pos + M_DEFLATE_MIN_MATCH - 1 < total) {
+            limit = total - pos;
+            if (limit > M_DEFLATE_MAX_MATCH) limit = M_DEFLATE_MAX_MATCH;
+            cand = head[mln_deflate_hash(work + pos)];
+            for (chain = M_DEFLATE_MAX_CHAIN; \
+                 cand >= 0 && pos - cand <= M_DEFLATE_WINDOW_SIZE && chain > 0; \
+                 cand = prev[cand], --chain)
+            {
+                for (len = 0; (mln_size_t)len < limit; ++len) {
+                    if (work[cand+len] != work[pos+len]) break;
+                }
+                if (len > best_len) {
+                    best_len = len;
+                    best_dist = pos - cand;
+                    if ((mln_size_t)len >= limit) break;
+                }
+            }
+        }
+        if (best_len >= M_DEFLATE_MIN_MATCH) {
+            if (mln_deflate_wr_match(&w, best_len, best_dist) < 0) goto out;
+            for (i = pos; i < pos + best_len; ++i) {
+                if (i + M_DEFLATE_MIN_MATCH - 1 >= total) break;
+                mln_u32_t h = mln_deflate_hash(work + i);
+                prev[i] = head[h];
+                head[h] = i;
+            }
+            pos += best_len;
+        } else {
+            if (mln_deflate_wr_sym(&w, work[pos]) < 0) goto out;
+            if (pos + M_DEFLATE_MIN_MATCH - 1 < total) {
+                mln_u32_t h = mln_deflate_hash(work + pos);
+                prev[pos] = head[h];
+                head[h] = pos;
+            }
+            ++pos;
+        }
+    }
+    if (mln_deflate_wr_sym(&w, 256) < 0) goto out;
+
+    /*
+     * open the trailing empty stored block and pad to the byte
+     * boundary; its LEN/NLEN bytes (00 00 ff ff) are what
+     * permessage-deflate strips, so they are simply not written.
+     */
+    if (mln_deflate_wr_bits(&w, 0, 3) < 0) goto out;
+    if (w.bitcnt > 0) {
+        if (mln_deflate_wr_byte(&w, w.bitbuf & 0xff) < 0) goto out;
+        w.bitbuf = 0;
+        w.bitcnt = 0;
+    }
+
+    mln_deflate_window_update(ctx, in, inlen);
+    *out = w.buf;
+    *outlen = w.len;
+    err = 0;
+
+out:
+    if (head != NULL) mln_alloc_free(head);
+    if (prev != NULL) mln_alloc_free(prev);
+    if (work != in && work != NULL) mln_alloc_free(work);
+    if (err) mln_alloc_free(w.buf);
+    return err;
+}
+
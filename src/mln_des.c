@@ -7,12 +7,30 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "mln_des.h"
+#include "mln_defs.h"
 
 static inline void mln_des_begin_permute(mln_u64_t *msg);
 static inline void mln_des_extension_permute(mln_u64_t *right);
 static inline void mln_des_s_permute(mln_u64_t *right);
 static inline void mln_des_p_permute(mln_u64_t *right);
 static inline void mln_des_final_permute(mln_u64_t *msg);
+static void mln_des_tbl_build(void);
+
+/*
+ * Table-driven fast path. The bit-by-bit permutation loops above define
+ * the semantics; these tables are generated from them once, so the fast
+ * path cannot diverge from the reference. IP, FP and E become one
+ * lookup per input byte (a bit permutation is the OR of its per-byte
+ * images), and S followed by P collapses into one 6-bit-indexed table
+ * per group, making a round eight lookups and a few XORs instead of
+ * eighty-eight single-bit moves.
+ */
+static mln_u64_t mln_des_ip_tbl[8][256];
+static mln_u64_t mln_des_fp_tbl[8][256];
+static mln_u64_t mln_des_e_tbl[4][256];
+static mln_u32_t mln_des_sp_tbl[8][64];
+static volatile mln_u32_t mln_des_tbl_built = 0;
+static mln_u32_t mln_des_tbl_lock = 0;
 
 static mln_u8_t begin_permutation[] = {
     57, 49, 41, 33, 25, 17, 9, 1, 59, 51, 43, 35, 27, 19, 11, 3,
@@ -165,40 +183,60 @@ void mln_des_pool_free(mln_des_t *d)
     mln_alloc_free(d);
 }
 
+static inline mln_u32_t mln_des_round_f(mln_u32_t right, mln_u64_t key)
+{
+    mln_u64_t e;
+
+    e = mln_des_e_tbl[0][(right >> 24) & 0xff] | \
+        mln_des_e_tbl[1][(right >> 16) & 0xff] | \
+        mln_des_e_tbl[2][(right >> 8) & 0xff] | \
+        mln_des_e_tbl[3][right & 0xff];
+    e ^= key;
+    return mln_des_sp_tbl[0][e & 0x3f] ^ \
+           mln_des_sp_tbl[1][(e >> 6) & 0x3f] ^ \
+           mln_des_sp_tbl[2][(e >> 12) & 0x3f] ^ \
+           mln_des_sp_tbl[3][(e >> 18) & 0x3f] ^ \
+           mln_des_sp_tbl[4][(e >> 24) & 0x3f] ^ \
+           mln_des_sp_tbl[5][(e >> 30) & 0x3f] ^ \
+           mln_des_sp_tbl[6][(e >> 36) & 0x3f] ^ \
+           mln_des_sp_tbl[7][(e >> 42) & 0x3f];
+}
+
+static inline mln_u64_t mln_des_bytes_permute(mln_u64_t tbl[8][256], mln_u64_t msg)
+{
+    return tbl[0][(msg >> 56) & 0xff] | tbl[1][(msg >> 48) & 0xff] | \
+           tbl[2][(msg >> 40) & 0xff] | tbl[3][(msg >> 32) & 0xff] | \
+           tbl[4][(msg >> 24) & 0xff] | tbl[5][(msg >> 16) & 0xff] | \
+           tbl[6][(msg >> 8) & 0xff] | tbl[7][msg & 0xff];
+}
+
 mln_u64_t mln_des(mln_des_t *d, mln_u64_t msg, mln_u32_t is_encrypt)
 {
     mln_s32_t i;
-    mln_u64_t left = 0, right = 0, tmp;
+    mln_u32_t left, right, tmp;
 
-    mln_des_begin_permute(&msg);
+    if (!mln_des_tbl_built) mln_des_tbl_build();
+
+    msg = mln_des_bytes_permute(mln_des_ip_tbl, msg);
 
     left = (msg >> 32) & 0xffffffff;
     right = msg & 0xffffffff;
     if (is_encrypt) {
         for (i = 0; i < 16; ++i) {
             tmp = right;
-            mln_des_extension_permute(&right);
-            right ^= d->sub_keys[i];
-            mln_des_s_permute(&right);
-            mln_des_p_permute(&right);
-            right ^= left;
+            right = mln_des_round_f(right, d->sub_keys[i]) ^ left;
             left = tmp;
         }
     } else {
         for (i = 15; i >= 0; --i) {
             tmp = right;
-            mln_des_extension_permute(&right);
-            right ^= d->sub_keys[i];
-            mln_des_s_permute(&right);
-            mln_des_p_permute(&right);
-            right ^= left;
+            right = mln_des_round_f(right, d->sub_keys[i]) ^ left;
             left = tmp;
         }
     }
-    msg = ((right & 0xffffffff) << 32) | (left & 0xffffffff);
+    msg = (((mln_u64_t)right) << 32) | left;
 
-    mln_des_final_permute(&msg);
-    return msg;
+    return mln_des_bytes_permute(mln_des_fp_tbl, msg);
 }
 
 static inline void mln_des_begin_permute(mln_u64_t *msg)
@@ -267,6 +305,46 @@ static inline void mln_des_final_permute(mln_u64_t *msg)
     *msg = ret;
 }
 
+static void mln_des_tbl_build(void)
+{
+    mln_u32_t b, v, g, two, index;
+    mln_u64_t x;
+
+    mln_spin_lock(&mln_des_tbl_lock);
+    if (!mln_des_tbl_built) {
+        for (b = 0; b < 8; ++b) {
+            for (v = 0; v < 256; ++v) {
+                x = ((mln_u64_t)v) << ((7 - b) << 3);
+                mln_des_begin_permute(&x);
+                mln_des_ip_tbl[b][v] = x;
+                x = ((mln_u64_t)v) << ((7 - b) << 3);
+                mln_des_final_permute(&x);
+                mln_des_fp_tbl[b][v] = x;
+            }
+        }
+        for (b = 0; b < 4; ++b) {
+            for (v = 0; v < 256; ++v) {
+                x = ((mln_u64_t)v) << ((3 - b) << 3);
+                mln_des_extension_permute(&x);
+                mln_des_e_tbl[b][v] = x;
+            }
+        }
+        for (g = 0; g < 8; ++g) {
+            for (v = 0; v < 64; ++v) {
+                /*group input decoding as in mln_des_s_permute()*/
+                two = (v & 0x1) | (((v >> 5) & 0x1) << 1);
+                index = ((v >> 1) & 0xf) + (two << 4);
+                x = ((mln_u64_t)(s_box[7 - g][index] & 0xf)) << (g << 2);
+                mln_des_p_permute(&x);
+                mln_des_sp_tbl[g][v] = (mln_u32_t)x;
+            }
+        }
+        __sync_synchronize();
+        mln_des_tbl_built = 1;
+    }
+    mln_spin_unlock(&mln_des_tbl_lock);
+}
+
 void mln_des_buf(mln_des_t *d, \
                  mln_u8ptr_t in, mln_uauto_t inlen, \
                  mln_u8ptr_t out, mln_uauto_t outlen, \
@@ -369,3 +447,80 @@ void mln_3des_buf(mln_3des_t *tdes, \
     }
 }
 
+
+/*
+ * The CBC walkers share the framing of the ECB ones above: whole
+ * 64-bit blocks, a short tail padded with 'fill'. The caller keeps the
+ * IV; feed the last ciphertext block back in to continue a stream.
+ */
+void mln_des_cbc_buf(mln_des_t *d, \
+                     mln_u8ptr_t in, mln_uauto_t inlen, \
+                     mln_u8ptr_t out, mln_uauto_t outlen, \
+                     mln_u8_t fill, \
+                     mln_u64_t iv, \
+                     mln_u32_t is_encrypt)
+{
+    mln_uauto_t i = 0;
+    mln_u64_t input, output, prev = iv;
+
+    while (inlen) {
+        input = 0;
+        for (i = 0; i < sizeof(mln_u64_t) && inlen > 0; ++i, --inlen, ++in) {
+            input |= ((((mln_u64_t)(*in)) & 0xff) << ((sizeof(mln_u64_t)-1-i) << 3));
+        }
+        if (i < sizeof(mln_u64_t)) {
+            for (; i < sizeof(mln_u64_t); ++i) {
+                input |= ((((mln_u64_t)fill) & 0xff) << ((sizeof(mln_u64_t)-1-i) << 3));
+            }
+        }
+        if (is_encrypt) {
+            output = mln_des(d, input ^ prev, 1);
+            prev = output;
+        } else {
+            output = mln_des(d, input, 0) ^ prev;
+            prev = input;
+        }
+
+        for (i = 0; i < sizeof(output); ++i, --outlen, ++out) {
+            if (outlen == 0) return;
+
+            *out = (output >> ((sizeof(mln_u64_t)-1-i) << 3)) & 0xff;
+        }
+    }
+}
+
+void mln_3des_cbc_buf(mln_3des_t *tdes, \
+                      mln_u8ptr_t in, mln_uauto_t inlen, \
+                      mln_u8ptr_t out, mln_uauto_t outlen, \
+                      mln_u8_t fill, \
+                      mln_u64_t iv, \
+                      mln_u32_t is_encrypt)
+{
+    mln_uauto_t i = 0;
+    mln_u64_t input, output, prev = iv;
+
+    while (inlen) {
+        input = 0;
+        for (i = 0; i < sizeof(mln_u64_t) && inlen > 0; ++i, --inlen, ++in) {
+            input |= ((((mln_u64_t)(*in)) & 0xff) << ((sizeof(mln_u64_t)-1-i) << 3));
+        }
+        if (i < sizeof(mln_u64_t)) {
+            for (; i < sizeof(mln_u64_t); ++i) {
+                input |= ((((mln_u64_t)fill) & 0xff) << ((sizeof(mln_u64_t)-1-i) << 3));
+            }
+        }
+        if (is_encrypt) {
+            output = mln_3des(tdes, input ^ prev, 1);
+            prev = output;
+        } else {
+            output = mln_3des(tdes, input, 0) ^ prev;
+            prev = input;
+        }
+
+        for (i = 0; i < sizeof(output); ++i, --outlen, ++out) {
+            if (outlen == 0) return;
+
+            *out = (output >> ((sizeof(mln_u64_t)-1-i) << 3)) & 0xff;
+        }
+    }
+}
@@ -19,6 +19,22 @@ void mln_error_init(mln_string_t *filenames, mln_string_t *errmsgs, mln_size_t n
     mln_error_nmsg = nmsg;
 }
 
+int mln_error_file_index(const char *filename)
+{
+    mln_size_t i;
+    mln_string_t tmp;
+
+    if (mln_error_filenames == NULL) return 0x1ff;
+    mln_string_set(&tmp, filename);
+    for (i = 0; i < mln_error_nfile; ++i) {
+        if (!mln_string_strcmp(&tmp, &mln_error_filenames[i]))
+            break;
+    }
+    if (i >= 0x1ff || i >= mln_error_nfile)
+        return 0x1ff;
+    return (int)i;
+}
+
 char *mln_error_string(int err, void *buf, mln_size_t len)
 {
     int i = 0, line = 0;
@@ -3,6 +3,9 @@
  * Copyright (C) Niklaus F.Schen.
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /*for pthread_setaffinity_np*/
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,9 +15,17 @@
 #include "mln_defs.h"
 #include "mln_event.h"
 #include "mln_global.h"
+#include "mln_clock.h"
 #if !defined(WIN32)
 #include <sys/socket.h>
 #endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#if defined(MLN_KQUEUE)
+#define M_EV_KQ_BATCH 256 /*kevent changelist entries collected per submission*/
+#endif
 
 /*declarations*/
 MLN_CHAIN_FUNC_DECLARE(ev_fd_wait, \
@@ -65,6 +76,18 @@ mln_event_fd_append_set(mln_event_t *event, \
                         int other_mark);
 static int
 mln_event_fd_timeout_set(mln_event_t *ev, mln_event_desc_t *ed, int timeout_ms);
+typedef struct mln_event_wheel_s mln_event_wheel_t;
+static void mln_event_wheel_free(mln_event_wheel_t *w);
+static void mln_event_wheel_process(mln_event_t *event);
+#if defined(MLN_IO_URING)
+static int mln_event_uring_init(mln_event_t *ev) __NONNULL1(1);
+static void mln_event_uring_destroy(mln_event_t *ev) __NONNULL1(1);
+static inline struct io_uring_sqe *mln_event_uring_sqe_get(mln_event_t *ev);
+static inline int
+mln_event_uring_enter(mln_event_t *ev, mln_u32_t to_submit, mln_u32_t min_complete, mln_u32_t flags);
+static inline void
+mln_event_uring_cq_process(mln_event_t *event, mln_event_desc_t *skip);
+#endif
 
 /*varliables*/
 mln_event_desc_t fheap_min = {
@@ -73,6 +96,138 @@ mln_event_desc_t fheap_min = {
     NULL, NULL, NULL, NULL
 };
 
+/*
+ * Dispatch instrumentation. Durations are kept in raw cycle-counter
+ * ticks (TSC on x86-64, CNTVCT on aarch64, microseconds elsewhere) and
+ * converted with the enable-time calibration when snapshotted.
+ */
+typedef struct {
+    mln_u64_t                loops;
+    mln_u64_t                fd_events;
+    mln_u64_t                timer_events;
+    mln_u64_t                cb_samples;
+    mln_u64_t                cb_max;
+    mln_u64_t                cb_total;
+    mln_u64_t                hist[M_EV_STAT_HIST];
+    mln_u64_t                loop_start;
+    mln_u64_t                ticks_per_us;
+    mln_u32_t                sample;
+    mln_u32_t                countdown;
+} mln_event_stat_internal_t;
+
+static inline mln_u64_t mln_event_stat_ticks(void)
+{
+#if defined(__GNUC__) && defined(__x86_64__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__GNUC__) && defined(__aarch64__)
+    mln_u64_t v;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (mln_u64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
+static inline void mln_event_stat_loop_begin(mln_event_t *event)
+{
+    mln_event_stat_internal_t *st = (mln_event_stat_internal_t *)event->stats;
+    if (mln_likely(st == NULL)) return;
+    ++st->loops;
+    st->loop_start = mln_event_stat_ticks();
+}
+
+static inline void mln_event_stat_loop_end(mln_event_t *event)
+{
+    mln_event_stat_internal_t *st = (mln_event_stat_internal_t *)event->stats;
+    mln_u64_t us;
+    mln_u32_t b = 0;
+    if (mln_likely(st == NULL)) return;
+    us = (mln_event_stat_ticks() - st->loop_start) / st->ticks_per_us;
+    while (us >>= 1) ++b;
+    ++st->hist[b >= M_EV_STAT_HIST? M_EV_STAT_HIST - 1: b];
+}
+
+static inline mln_u64_t mln_event_stat_cb_begin(mln_event_t *event)
+{
+    mln_event_stat_internal_t *st = (mln_event_stat_internal_t *)event->stats;
+    if (mln_likely(st == NULL)) return 0;
+    if (--st->countdown) return 0;
+    st->countdown = st->sample;
+    return mln_event_stat_ticks();
+}
+
+static inline void mln_event_stat_cb_end(mln_event_t *event, mln_u64_t t0, int is_timer)
+{
+    mln_event_stat_internal_t *st = (mln_event_stat_internal_t *)event->stats;
+    mln_u64_t d;
+    if (mln_likely(st == NULL)) return;
+    if (is_timer) ++st->timer_events;
+    else ++st->fd_events;
+    if (!t0) return;
+    d = mln_event_stat_ticks() - t0;
+    ++st->cb_samples;
+    st->cb_total += d;
+    if (d > st->cb_max) st->cb_max = d;
+}
+
+int mln_event_stat_enable(mln_event_t *ev, mln_u32_t sample)
+{
+    mln_event_stat_internal_t *st;
+    struct timeval tv0, tv1;
+    mln_u64_t t0, t1, us;
+
+    if (ev->stats != NULL) return -1;
+    if ((st = (mln_event_stat_internal_t *)calloc(1, sizeof(mln_event_stat_internal_t))) == NULL)
+        return -1;
+    st->sample = st->countdown = sample? sample: 1;
+    gettimeofday(&tv0, NULL);
+    t0 = mln_event_stat_ticks();
+    usleep(10000);
+    t1 = mln_event_stat_ticks();
+    gettimeofday(&tv1, NULL);
+    us = (mln_u64_t)(tv1.tv_sec - tv0.tv_sec) * 1000000 + (tv1.tv_usec - tv0.tv_usec);
+    st->ticks_per_us = us? (t1 - t0) / us: 1;
+    if (!st->ticks_per_us) st->ticks_per_us = 1;
+    ev->stats = st;
+    return 0;
+}
+
+void mln_event_stat_disable(mln_event_t *ev)
+{
+    if (ev->stats == NULL) return;
+    free(ev->stats);
+    ev->stats = NULL;
+}
+
+int mln_event_stat_get(mln_event_t *ev, mln_event_stat_t *st)
+{
+    mln_event_stat_internal_t *in = (mln_event_stat_internal_t *)ev->stats;
+    if (in == NULL) return -1;
+    st->loops = in->loops;
+    st->fd_events = in->fd_events;
+    st->timer_events = in->timer_events;
+    st->cb_samples = in->cb_samples;
+    st->cb_max_us = in->cb_max / in->ticks_per_us;
+    st->cb_total_us = in->cb_total / in->ticks_per_us;
+    memcpy(st->hist, in->hist, sizeof(st->hist));
+    return 0;
+}
+
+void mln_event_stat_reset(mln_event_t *ev)
+{
+    mln_event_stat_internal_t *in = (mln_event_stat_internal_t *)ev->stats;
+    mln_u64_t tpu;
+    mln_u32_t sample;
+    if (in == NULL) return;
+    tpu = in->ticks_per_us;
+    sample = in->sample;
+    memset(in, 0, sizeof(mln_event_stat_internal_t));
+    in->ticks_per_us = tpu;
+    in->sample = in->countdown = sample;
+}
+
 mln_event_t *mln_event_new(void)
 {
     int rc;
@@ -108,8 +263,16 @@ mln_event_t *mln_event_new(void)
     if (ev->ev_timer_heap == NULL) {
         goto err3;
     }
+    ev->ev_timer_wheel = NULL;
+    ev->stats = NULL;
     ev->is_break = 0;
-#if defined(MLN_EPOLL)
+    ev->rd_fd = -1;
+    ev->wr_fd = -1;
+#if defined(MLN_IO_URING)
+    if (mln_event_uring_init(ev) < 0) {
+        goto err4;
+    }
+#elif defined(MLN_EPOLL)
     ev->epollfd = epoll_create(M_EV_EPOLL_SIZE);
     if (ev->epollfd < 0) {
         goto err4;
@@ -129,6 +292,8 @@ mln_event_t *mln_event_new(void)
         close(ev->kqfd);
         goto err4;
     }
+    ev->kq_chg = NULL;
+    ev->kq_nchg = 0;
 #else
     ev->select_fd = 3;
     FD_ZERO(&(ev->rd_set));
@@ -145,7 +310,9 @@ mln_event_t *mln_event_new(void)
         pthread_mutex_destroy(&ev->fd_lock);
         pthread_mutex_destroy(&ev->timer_lock);
         pthread_mutex_destroy(&ev->cb_lock);
-#if defined(MLN_EPOLL)
+#if defined(MLN_IO_URING)
+        mln_event_uring_destroy(ev);
+#elif defined(MLN_EPOLL)
         close(ev->epollfd);
 #elif defined(MLN_KQUEUE)
         close(ev->kqfd);
@@ -179,7 +346,11 @@ void mln_event_free(mln_event_t *ev)
         mln_event_desc_free(ed);
     }
     mln_fheap_inline_free(ev->ev_timer_heap, mln_event_fheap_timer_cmp, mln_event_desc_free);
-#if defined(MLN_EPOLL)
+    mln_event_wheel_free((mln_event_wheel_t *)(ev->ev_timer_wheel));
+    mln_event_stat_disable(ev);
+#if defined(MLN_IO_URING)
+    mln_event_uring_destroy(ev);
+#elif defined(MLN_EPOLL)
     close(ev->epollfd);
     close(ev->unusedfd);
 #elif defined(MLN_KQUEUE)
@@ -191,6 +362,8 @@ void mln_event_free(mln_event_t *ev)
     pthread_mutex_destroy(&ev->fd_lock);
     pthread_mutex_destroy(&ev->timer_lock);
     pthread_mutex_destroy(&ev->cb_lock);
+    if (ev->rd_fd >= 0) close(ev->rd_fd);
+    if (ev->wr_fd >= 0) close(ev->wr_fd);
     free(ev);
 }
 
@@ -201,6 +374,300 @@ mln_event_desc_free(void *data)
     free(data);
 }
 
+#if defined(MLN_IO_URING)
+/*
+ * io_uring ring management.
+ * Readiness is obtained via batched IORING_OP_POLL_ADD submissions,
+ * so one io_uring_enter() per dispatch loop replaces the per-fd
+ * epoll_ctl/epoll_wait syscall traffic.
+ */
+static inline int
+mln_event_uring_enter(mln_event_t *ev, mln_u32_t to_submit, mln_u32_t min_complete, mln_u32_t flags)
+{
+    return (int)syscall(__NR_io_uring_enter, ev->ring_fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int
+mln_event_uring_init(mln_event_t *ev)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    ev->ring_fd = (int)syscall(__NR_io_uring_setup, M_EV_EPOLL_SIZE, &p);
+    if (ev->ring_fd < 0) {
+        return -1;
+    }
+    ev->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(mln_u32_t);
+    ev->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ev->cq_ring_size > ev->sq_ring_size)
+            ev->sq_ring_size = ev->cq_ring_size;
+        ev->cq_ring_size = ev->sq_ring_size;
+    }
+    ev->sq_ring = mmap(NULL, ev->sq_ring_size, PROT_READ|PROT_WRITE, \
+                       MAP_SHARED|MAP_POPULATE, ev->ring_fd, IORING_OFF_SQ_RING);
+    if (ev->sq_ring == MAP_FAILED) {
+        close(ev->ring_fd);
+        return -1;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        ev->cq_ring = ev->sq_ring;
+    } else {
+        ev->cq_ring = mmap(NULL, ev->cq_ring_size, PROT_READ|PROT_WRITE, \
+                           MAP_SHARED|MAP_POPULATE, ev->ring_fd, IORING_OFF_CQ_RING);
+        if (ev->cq_ring == MAP_FAILED) {
+            munmap(ev->sq_ring, ev->sq_ring_size);
+            close(ev->ring_fd);
+            return -1;
+        }
+    }
+    ev->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    ev->sqes = (struct io_uring_sqe *)mmap(NULL, ev->sqes_size, PROT_READ|PROT_WRITE, \
+                                           MAP_SHARED|MAP_POPULATE, ev->ring_fd, IORING_OFF_SQES);
+    if (ev->sqes == MAP_FAILED) {
+        if (ev->cq_ring != ev->sq_ring)
+            munmap(ev->cq_ring, ev->cq_ring_size);
+        munmap(ev->sq_ring, ev->sq_ring_size);
+        close(ev->ring_fd);
+        return -1;
+    }
+    ev->sqe_entries = p.sq_entries;
+    ev->sq_head = (mln_u32_t *)((mln_u8ptr_t)(ev->sq_ring) + p.sq_off.head);
+    ev->sq_tail = (mln_u32_t *)((mln_u8ptr_t)(ev->sq_ring) + p.sq_off.tail);
+    ev->sq_mask = *(mln_u32_t *)((mln_u8ptr_t)(ev->sq_ring) + p.sq_off.ring_mask);
+    ev->sq_array = (mln_u32_t *)((mln_u8ptr_t)(ev->sq_ring) + p.sq_off.array);
+    ev->cq_head = (mln_u32_t *)((mln_u8ptr_t)(ev->cq_ring) + p.cq_off.head);
+    ev->cq_tail = (mln_u32_t *)((mln_u8ptr_t)(ev->cq_ring) + p.cq_off.tail);
+    ev->cq_mask = *(mln_u32_t *)((mln_u8ptr_t)(ev->cq_ring) + p.cq_off.ring_mask);
+    ev->cqes = (struct io_uring_cqe *)((mln_u8ptr_t)(ev->cq_ring) + p.cq_off.cqes);
+    return 0;
+}
+
+static void
+mln_event_uring_destroy(mln_event_t *ev)
+{
+    munmap(ev->sqes, ev->sqes_size);
+    if (ev->cq_ring != ev->sq_ring)
+        munmap(ev->cq_ring, ev->cq_ring_size);
+    munmap(ev->sq_ring, ev->sq_ring_size);
+    close(ev->ring_fd);
+}
+
+static inline struct io_uring_sqe *
+mln_event_uring_sqe_get(mln_event_t *ev)
+{
+    mln_u32_t head = __atomic_load_n(ev->sq_head, __ATOMIC_ACQUIRE);
+    mln_u32_t tail = *(ev->sq_tail);
+    struct io_uring_sqe *sqe;
+    if (tail - head >= ev->sqe_entries)
+        return NULL;
+    sqe = &(ev->sqes[tail & ev->sq_mask]);
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    ev->sq_array[tail & ev->sq_mask] = tail & ev->sq_mask;
+    __atomic_store_n(ev->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+/*
+ * Drain completions. 'skip' is a descriptor being cleared whose
+ * pending completions must be discarded before it is freed.
+ */
+static inline void
+mln_event_uring_cq_process(mln_event_t *event, mln_event_desc_t *skip)
+{
+    mln_u32_t head = *(event->cq_head);
+    mln_u32_t tail = __atomic_load_n(event->cq_tail, __ATOMIC_ACQUIRE);
+    struct io_uring_cqe *cqe;
+    mln_event_desc_t *ed;
+    mln_u32_t move;
+
+    for (; head != tail; ++head) {
+        cqe = &(event->cqes[head & event->cq_mask]);
+        ed = (mln_event_desc_t *)(unsigned long)(cqe->user_data);
+        if (ed == NULL || ed == skip)
+            continue;
+        ed->data.fd.uring_armed = 0;
+        if (cqe->res <= 0)
+            continue;
+        if (ed->data.fd.is_clear || ed->data.fd.in_active || ed->data.fd.in_process)
+            continue;
+        move = 0;
+        if ((cqe->res & POLLIN) && (ed->flag & M_EV_RECV)) {
+            ed->data.fd.active_flag |= M_EV_RECV;
+            if (ed->data.fd.rd_oneshot == 1) {
+                ed->flag &= (~M_EV_RECV);
+                ed->data.fd.rd_oneshot = 0;
+            }
+            move = 1;
+        }
+        if ((cqe->res & POLLOUT) && (ed->flag & M_EV_SEND)) {
+            ed->data.fd.active_flag |= M_EV_SEND;
+            if (ed->data.fd.wr_oneshot == 1) {
+                ed->flag &= (~M_EV_SEND);
+                ed->data.fd.wr_oneshot = 0;
+            }
+            move = 1;
+        }
+        if ((cqe->res & (POLLERR|POLLHUP)) && (ed->flag & M_EV_ERROR)) {
+            ed->data.fd.active_flag |= M_EV_ERROR;
+            if (ed->data.fd.err_oneshot == 1) {
+                ed->flag &= (~M_EV_ERROR);
+                ed->data.fd.err_oneshot = 0;
+            }
+            move = 1;
+        }
+        if (move) {
+            ev_fd_active_chain_add(&(event->ev_fd_active_head), \
+                                   &(event->ev_fd_active_tail), \
+                                   ed);
+            ed->data.fd.in_active = 1;
+        }
+    }
+    __atomic_store_n(event->cq_head, head, __ATOMIC_RELEASE);
+}
+#endif
+
+/*
+ * ev_timer - hashed hierarchical timer wheel mode
+ */
+typedef struct mln_event_wheel_node_s {
+    void                            *data;
+    ev_tm_handler                    handler;
+    mln_u64_t                        end_ms;
+    struct mln_event_wheel_node_s   *prev;
+    struct mln_event_wheel_node_s   *next;
+    struct mln_event_wheel_node_s  **slot;
+} mln_event_wheel_node_t;
+
+struct mln_event_wheel_s {
+    mln_u64_t                 current;/*ms*/
+    mln_event_wheel_node_t   *slots[M_EV_WHEEL_LEVELS][M_EV_WHEEL_SLOTS];
+};
+
+static inline mln_u64_t mln_event_now_ms(void)
+{
+    return mln_clock_mono_ms();
+}
+
+static inline void
+mln_event_wheel_insert(mln_event_wheel_t *w, mln_event_wheel_node_t *n)
+{
+    int level;
+    mln_u64_t delta = n->end_ms > w->current? n->end_ms - w->current: 0;
+    mln_event_wheel_node_t **slot;
+    for (level = 0; level < M_EV_WHEEL_LEVELS - 1; ++level) {
+        if (delta < ((mln_u64_t)1 << ((level + 1) * M_EV_WHEEL_BITS)))
+            break;
+    }
+    slot = &(w->slots[level][(n->end_ms >> (level * M_EV_WHEEL_BITS)) & M_EV_WHEEL_MASK]);
+    n->slot = slot;
+    n->prev = NULL;
+    n->next = *slot;
+    if (*slot != NULL) (*slot)->prev = n;
+    *slot = n;
+}
+
+static inline void
+mln_event_wheel_remove(mln_event_wheel_node_t *n)
+{
+    if (n->prev != NULL) n->prev->next = n->next;
+    else *(n->slot) = n->next;
+    if (n->next != NULL) n->next->prev = n->prev;
+    n->prev = n->next = NULL;
+    n->slot = NULL;
+}
+
+int mln_event_timer_mode_set(mln_event_t *event, int mode)
+{
+    int i, j;
+    mln_event_wheel_t *w;
+    if (mode == M_EV_TIMER_WHEEL) {
+        if (event->ev_timer_wheel != NULL) return 0;
+        if (mln_fheap_minimum(event->ev_timer_heap) != NULL)
+            return -1;
+        w = (mln_event_wheel_t *)calloc(1, sizeof(mln_event_wheel_t));
+        if (w == NULL) return -1;
+        w->current = mln_event_now_ms();
+        event->ev_timer_wheel = w;
+    } else {
+        if ((w = (mln_event_wheel_t *)(event->ev_timer_wheel)) == NULL) return 0;
+        for (i = 0; i < M_EV_WHEEL_LEVELS; ++i) {
+            for (j = 0; j < M_EV_WHEEL_SLOTS; ++j) {
+                if (w->slots[i][j] != NULL)
+                    return -1;
+            }
+        }
+        free(w);
+        event->ev_timer_wheel = NULL;
+    }
+    return 0;
+}
+
+static void mln_event_wheel_free(mln_event_wheel_t *w)
+{
+    int i, j;
+    mln_event_wheel_node_t *n;
+    if (w == NULL) return;
+    for (i = 0; i < M_EV_WHEEL_LEVELS; ++i) {
+        for (j = 0; j < M_EV_WHEEL_SLOTS; ++j) {
+            while ((n = w->slots[i][j]) != NULL) {
+                mln_event_wheel_remove(n);
+                free(n);
+            }
+        }
+    }
+    free(w);
+}
+
+static void mln_event_wheel_process(mln_event_t *event)
+{
+    int level;
+    mln_u64_t now;
+    mln_event_wheel_t *w;
+    mln_event_wheel_node_t *n, *next, **slot, *fired = NULL;
+
+    if (pthread_mutex_trylock(&event->timer_lock))
+        return;
+    w = (mln_event_wheel_t *)(event->ev_timer_wheel);
+    now = mln_event_now_ms();
+    while (w->current < now) {
+        ++(w->current);
+        /*cascade higher levels when lower wheels wrap*/
+        for (level = 0; \
+             level < M_EV_WHEEL_LEVELS - 1 && \
+                 ((w->current >> (level * M_EV_WHEEL_BITS)) & M_EV_WHEEL_MASK) == 0; \
+             )
+        {
+            ++level;
+            slot = &(w->slots[level][(w->current >> (level * M_EV_WHEEL_BITS)) & M_EV_WHEEL_MASK]);
+            for (n = *slot; n != NULL; n = next) {
+                next = n->next;
+                mln_event_wheel_remove(n);
+                mln_event_wheel_insert(w, n);
+            }
+        }
+        slot = &(w->slots[0][w->current & M_EV_WHEEL_MASK]);
+        for (n = *slot; n != NULL; n = next) {
+            next = n->next;
+            if (n->end_ms > w->current)
+                continue;
+            mln_event_wheel_remove(n);
+            n->next = fired;
+            fired = n;
+        }
+    }
+    pthread_mutex_unlock(&event->timer_lock);
+
+    while ((n = fired) != NULL) {
+        fired = n->next;
+        if (n->handler != NULL) {
+            mln_u64_t t0 = mln_event_stat_cb_begin(event);
+            n->handler(event, n->data);
+            mln_event_stat_cb_end(event, t0, 1);
+        }
+        free(n);
+    }
+}
+
 /*
  * ev_timer
  */
@@ -209,9 +676,41 @@ mln_event_timer_t *mln_event_timer_set(mln_event_t *event, \
                                        void *data, \
                                        ev_tm_handler tm_handler)
 {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    mln_uauto_t end = tv.tv_sec*1000000 + tv.tv_usec + msec*1000;
+    return mln_event_timer_set_slack(event, msec, 0, data, tm_handler);
+}
+
+mln_event_timer_t *mln_event_timer_set_slack(mln_event_t *event, \
+                                             mln_u32_t msec, \
+                                             mln_u32_t slack_msec, \
+                                             void *data, \
+                                             ev_tm_handler tm_handler)
+{
+    if (event->ev_timer_wheel != NULL) {
+        mln_event_wheel_t *w = (mln_event_wheel_t *)(event->ev_timer_wheel);
+        mln_event_wheel_node_t *n;
+        n = (mln_event_wheel_node_t *)malloc(sizeof(mln_event_wheel_node_t));
+        if (n == NULL) {
+            return NULL;
+        }
+        n->data = data;
+        n->handler = tm_handler;
+        n->end_ms = mln_event_now_ms() + msec;
+        if (slack_msec)
+            /*round up to a slack boundary so clustered deadlines share a slot*/
+            n->end_ms = ((n->end_ms + slack_msec - 1) / slack_msec) * slack_msec;
+        pthread_mutex_lock(&event->timer_lock);
+        if (n->end_ms <= w->current)
+            n->end_ms = w->current + 1;
+        mln_event_wheel_insert(w, n);
+        pthread_mutex_unlock(&event->timer_lock);
+        return (mln_event_timer_t *)n;
+    }
+    mln_uauto_t end = mln_clock_mono_us() + msec*1000;
+    if (slack_msec) {
+        mln_uauto_t q = (mln_uauto_t)slack_msec * 1000;
+        /*identical keys pop together, one sweep drains the whole batch*/
+        end = ((end + q - 1) / q) * q;
+    }
     mln_event_desc_t *ed;
     ed = (mln_event_desc_t *)malloc(sizeof(mln_event_desc_t));
     if (ed == NULL) {
@@ -239,6 +738,15 @@ mln_event_timer_t *mln_event_timer_set(mln_event_t *event, \
 
 void mln_event_timer_cancel(mln_event_t *event, mln_event_timer_t *timer)
 {
+    if (event->ev_timer_wheel != NULL) {
+        mln_event_wheel_node_t *n = (mln_event_wheel_node_t *)timer;
+        pthread_mutex_lock(&event->timer_lock);
+        if (n->slot != NULL)
+            mln_event_wheel_remove(n);
+        free(n);
+        pthread_mutex_unlock(&event->timer_lock);
+        return;
+    }
     pthread_mutex_lock(&event->timer_lock);
     mln_fheap_inline_delete(event->ev_timer_heap, timer, mln_event_fheap_timer_copy, mln_event_fheap_timer_cmp);
     mln_fheap_inline_node_free(event->ev_timer_heap, timer, mln_event_desc_free);
@@ -247,10 +755,11 @@ void mln_event_timer_cancel(mln_event_t *event, mln_event_timer_t *timer)
 
 static inline void mln_event_timer_process(mln_event_t *event)
 {
-    mln_uauto_t now;
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    now = tv.tv_sec * 1000000 + tv.tv_usec;
+    if (event->ev_timer_wheel != NULL) {
+        mln_event_wheel_process(event);
+        return;
+    }
+    mln_uauto_t now = mln_clock_mono_us();
     mln_event_desc_t *ed;
     mln_fheap_node_t *fn;
 
@@ -274,8 +783,11 @@ lp:
 
     pthread_mutex_unlock(&event->timer_lock);
 
-    if (ed->data.tm.handler != NULL)
+    if (ed->data.tm.handler != NULL) {
+        mln_u64_t t0 = mln_event_stat_cb_begin(event);
         ed->data.tm.handler(event, ed->data.tm.data);
+        mln_event_stat_cb_end(event, t0, 1);
+    }
 
     mln_fheap_inline_node_free(event->ev_timer_heap, fn, mln_event_desc_free);
 
@@ -304,19 +816,57 @@ void mln_event_fd_timeout_handler_set(mln_event_t *event, \
     pthread_mutex_unlock(&event->fd_lock);
 }
 
-int mln_event_fd_set(mln_event_t *event, \
-                     int fd, \
-                     mln_u32_t flag, \
-                     int timeout_ms, \
-                     void *data, \
-                     ev_fd_handler fd_handler)
+int mln_event_fd_drain(mln_event_t *event, int fd)
 {
-    ASSERT(fd >= 0 && !(flag & ~M_EV_FD_MASK) && flag <= M_EV_CLR && !((flag & M_EV_NONBLOCK) && (flag & M_EV_BLOCK)));
+    char b;
+    ssize_t n;
+    ev_fd_handler h;
+    void *data;
+    mln_event_desc_t tmp, *ed;
+    mln_rbtree_node_t *rn;
+
+    while (1) {
+        pthread_mutex_lock(&event->fd_lock);
+        memset(&tmp, 0, sizeof(tmp));
+        tmp.type = M_EV_FD;
+        tmp.data.fd.fd = fd;
+        rn = mln_rbtree_inline_search(event->ev_fd_tree, &tmp, mln_event_rbtree_fd_cmp);
+        if (mln_rbtree_null(rn, event->ev_fd_tree)) {
+            pthread_mutex_unlock(&event->fd_lock);
+            return -1;
+        }
+        ed = (mln_event_desc_t *)mln_rbtree_node_data_get(rn);
+        if (ed->data.fd.is_clear || (h = ed->data.fd.rcv_handler) == NULL) {
+            pthread_mutex_unlock(&event->fd_lock);
+            return 0;
+        }
+        data = ed->data.fd.rcv_data;
+        pthread_mutex_unlock(&event->fd_lock);
+
+        h(event, fd, data);
+
+        n = recv(fd, &b, 1, MSG_PEEK);
+        if (n == 0) return 0;
+        if (n < 0) {
+#if !defined(WIN32)
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+#endif
+            return -1;
+        }
+    }
+}
+
+static int mln_event_fd_set_nolock(mln_event_t *event, \
+                                   int fd, \
+                                   mln_u32_t flag, \
+                                   int timeout_ms, \
+                                   void *data, \
+                                   ev_fd_handler fd_handler)
+{
+    ASSERT(fd >= 0 && !(flag & ~M_EV_FD_MASK) && (flag & ~M_EV_ET) <= M_EV_CLR && !((flag & M_EV_NONBLOCK) && (flag & M_EV_BLOCK)));
 
-    pthread_mutex_lock(&event->fd_lock);
     if (flag == M_EV_CLR) {
         mln_event_fd_clr_set(event, fd);
-        pthread_mutex_unlock(&event->fd_lock);
         return 0;
     }
     mln_event_desc_t tmp;
@@ -341,7 +891,6 @@ int mln_event_fd_set(mln_event_t *event, \
                                         fd_handler, \
                                         1) < 0)
             {
-                pthread_mutex_unlock(&event->fd_lock);
                 return -1;
             }
         } else {
@@ -359,11 +908,9 @@ int mln_event_fd_set(mln_event_t *event, \
                                         fd_handler, \
                                         ((mln_event_desc_t *)(rn->data))->data.fd.is_clear?0:1) < 0)
             {
-                pthread_mutex_unlock(&event->fd_lock);
                 return -1;
             }
         }
-        pthread_mutex_unlock(&event->fd_lock);
         return 0;
     }
     if (flag & M_EV_NONBLOCK) {
@@ -372,13 +919,88 @@ int mln_event_fd_set(mln_event_t *event, \
         mln_event_fd_block_set(fd);
     }
     if (mln_event_fd_normal_set(event, NULL, fd, flag, timeout_ms, data, fd_handler, 0) < 0) {
-        pthread_mutex_unlock(&event->fd_lock);
         return -1;
     }
-    pthread_mutex_unlock(&event->fd_lock);
     return 0;
 }
 
+int mln_event_fd_set(mln_event_t *event, \
+                     int fd, \
+                     mln_u32_t flag, \
+                     int timeout_ms, \
+                     void *data, \
+                     ev_fd_handler fd_handler)
+{
+    int ret;
+
+    pthread_mutex_lock(&event->fd_lock);
+    ret = mln_event_fd_set_nolock(event, fd, flag, timeout_ms, data, fd_handler);
+    pthread_mutex_unlock(&event->fd_lock);
+    return ret;
+}
+
+int mln_event_fd_set_batch(mln_event_t *event, mln_event_fd_reg_t *regs, mln_size_t nregs)
+{
+    mln_size_t i;
+    int ret = 0;
+#if defined(MLN_KQUEUE)
+    struct kevent chg[M_EV_KQ_BATCH];
+#endif
+
+    pthread_mutex_lock(&event->fd_lock);
+#if defined(MLN_KQUEUE)
+    event->kq_chg = chg;
+    event->kq_nchg = 0;
+#endif
+    for (i = 0; i < nregs; ++i) {
+        if (mln_event_fd_set_nolock(event, \
+                                    regs[i].fd, \
+                                    regs[i].flag, \
+                                    regs[i].timeout_ms, \
+                                    regs[i].data, \
+                                    regs[i].handler) < 0)
+        {
+            ret = -1;
+            break;
+        }
+    }
+#if defined(MLN_KQUEUE)
+    if (event->kq_nchg > 0)
+        kevent(event->kqfd, event->kq_chg, event->kq_nchg, NULL, 0, NULL);
+    event->kq_chg = NULL;
+    event->kq_nchg = 0;
+#endif
+    pthread_mutex_unlock(&event->fd_lock);
+    return ret;
+}
+
+#if defined(MLN_KQUEUE)
+/*
+ * Submit one kqueue change, or append it to the changelist a running
+ * mln_event_fd_set_batch() collects so the whole batch reaches the
+ * kernel in one kevent() call (flushing early if the list fills).
+ */
+static inline void
+mln_event_kq_change(mln_event_t *event, int fd, short filter, unsigned short flags, void *udata)
+{
+    struct kevent ev;
+
+    if (event->kq_chg != NULL) {
+        if (event->kq_nchg == M_EV_KQ_BATCH) {
+            kevent(event->kqfd, event->kq_chg, event->kq_nchg, NULL, 0, NULL);
+            event->kq_nchg = 0;
+        }
+        EV_SET(&event->kq_chg[event->kq_nchg], fd, filter, flags, 0, 0, udata);
+        ++(event->kq_nchg);
+        return;
+    }
+    EV_SET(&ev, fd, filter, flags, 0, 0, udata);
+    if (kevent(event->kqfd, &ev, 1, NULL, 0, NULL) < 0) {
+        ASSERT(0);
+    }
+}
+#endif
+
 static inline int
 mln_event_fd_normal_set(mln_event_t *event, \
                         mln_event_desc_t *ed, \
@@ -428,6 +1050,7 @@ mln_event_fd_normal_set(mln_event_t *event, \
             ed->data.fd.rd_oneshot = 0;
             ed->data.fd.wr_oneshot = 0;
             ed->data.fd.err_oneshot = 0;
+            ed->data.fd.et = 0;
             ed->data.fd.fd = fd;
         }
         if (mln_event_fd_timeout_set(event, ed, timeout_ms) < 0) {
@@ -457,31 +1080,60 @@ mln_event_fd_append_set(mln_event_t *event, \
 {
     if (mln_event_fd_timeout_set(event, ed, timeout_ms) < 0)
         return -1;
-#if defined(MLN_EPOLL)
+    if (flag & M_EV_ET) ed->data.fd.et = 1;
+#if defined(MLN_IO_URING)
+    /*other_mark useless, poll submission is deferred to mln_event_dispatch*/
+    if (flag & M_EV_RECV) {
+        ed->flag |= M_EV_RECV;
+        if (flag & M_EV_ONESHOT) {
+            ed->data.fd.rd_oneshot = 1;
+        }
+        ed->data.fd.rcv_data = data;
+        ed->data.fd.rcv_handler = fd_handler;
+    }
+    if (flag & M_EV_SEND) {
+        ed->flag |= M_EV_SEND;
+        if (flag & M_EV_ONESHOT) {
+            ed->data.fd.wr_oneshot = 1;
+        }
+        ed->data.fd.snd_data = data;
+        ed->data.fd.snd_handler = fd_handler;
+    }
+    if (flag & M_EV_ERROR) {
+        ed->flag |= M_EV_ERROR;
+        if (flag & M_EV_ONESHOT) {
+            ed->data.fd.err_oneshot = 1;
+        }
+        ed->data.fd.err_data = data;
+        ed->data.fd.err_handler = fd_handler;
+    }
+#elif defined(MLN_EPOLL)
+/*
+ * A MOD whose event mask equals the one already armed is a no-op to
+ * the kernel, so it is skipped against the armed_events cache -- except
+ * when EPOLLONESHOT is anywhere in play, since a fired oneshot leaves
+ * the kernel disarmed behind an unchanged cache.
+ */
 #define CASE_MACRO(flg); \
+    ev.events = (flg)|et_flag|(oneshot? EPOLLONESHOT: 0);\
+    ev.data.ptr = ed;\
     if (other_mark) {\
-        if (oneshot) {\
-            ev.events = (flg)|EPOLLONESHOT;\
-            ev.data.ptr = ed;\
-            epoll_ctl(event->epollfd, EPOLL_CTL_MOD, fd, &ev);\
-        } else {\
-            ev.events = (flg);\
-            ev.data.ptr = ed;\
+        if (!ed->data.fd.armed_valid || \
+            ed->data.fd.armed_events != ev.events || \
+            (ev.events & EPOLLONESHOT))\
+        {\
             epoll_ctl(event->epollfd, EPOLL_CTL_MOD, fd, &ev);\
+            ed->data.fd.armed_events = ev.events;\
+            ed->data.fd.armed_valid = 1;\
         }\
     } else {\
-        if (oneshot) {\
-            ev.events = (flg)|EPOLLONESHOT;\
-            ev.data.ptr = ed;\
-            epoll_ctl(event->epollfd, EPOLL_CTL_ADD, fd, &ev);\
-        } else {\
-            ev.events = (flg);\
-            ev.data.ptr = ed;\
-            epoll_ctl(event->epollfd, EPOLL_CTL_ADD, fd, &ev);\
-        }\
+        epoll_ctl(event->epollfd, EPOLL_CTL_ADD, fd, &ev);\
+        ed->data.fd.armed_events = ev.events;\
+        ed->data.fd.armed_valid = 1;\
     }
 
     int oneshot = (flag & M_EV_ONESHOT)? 1: 0;
+    __uint32_t et_flag = ed->data.fd.et? EPOLLET: 0;
     int mask = 0;
     if (ed->flag & M_EV_RECV) mask |= 0x1;
     if (ed->flag & M_EV_SEND) mask |= 0x2;
@@ -534,24 +1186,22 @@ mln_event_fd_append_set(mln_event_t *event, \
         default: return 0;
     }
 #elif defined(MLN_KQUEUE)
-    struct kevent ev;
     int oneshot = (flag & M_EV_ONESHOT)? 1: 0;
+    int want;
     if (!other_mark) {
-        EV_SET(&ev, fd, EVFILT_READ, EV_ADD|EV_ERROR|EV_DISABLE, 0, 0, ed);
-        if (kevent(event->kqfd, &ev, 1, NULL, 0, NULL) < 0) {
-            ASSERT(0);
-        }
-        EV_SET(&ev, fd, EVFILT_WRITE, EV_ADD|EV_ERROR|EV_DISABLE, 0, 0, ed);
-        if (kevent(event->kqfd, &ev, 1, NULL, 0, NULL) < 0) {
-            ASSERT(0);
-        }
+        mln_event_kq_change(event, fd, EVFILT_READ, EV_ADD|EV_ERROR|EV_DISABLE, ed);
+        mln_event_kq_change(event, fd, EVFILT_WRITE, EV_ADD|EV_ERROR|EV_DISABLE, ed);
+        ed->data.fd.rd_armed = 0;
+        ed->data.fd.wr_armed = 0;
+        ed->data.fd.armed_valid = 1;
     }
     if (flag & M_EV_RECV) {
         ed->flag |= M_EV_RECV;
         if (oneshot) ed->data.fd.rd_oneshot = 1;
-        EV_SET(&ev, fd, EVFILT_READ, EV_ENABLE, 0, 0, ed);
-        if (kevent(event->kqfd, &ev, 1, NULL, 0, NULL) < 0) {
-            ASSERT(0);
+        want = ed->data.fd.et? 2: 1;
+        if (!ed->data.fd.armed_valid || ed->data.fd.rd_armed != want) {
+            mln_event_kq_change(event, fd, EVFILT_READ, want == 2? (EV_ENABLE|EV_CLEAR): EV_ENABLE, ed);
+            ed->data.fd.rd_armed = want;
         }
         ed->data.fd.rcv_data = data;
         ed->data.fd.rcv_handler = fd_handler;
@@ -559,9 +1209,10 @@ mln_event_fd_append_set(mln_event_t *event, \
     if (flag & M_EV_SEND) {
         ed->flag |= M_EV_SEND;
         if (oneshot) ed->data.fd.wr_oneshot = 1;
-        EV_SET(&ev, fd, EVFILT_WRITE, EV_ENABLE, 0, 0, ed);
-        if (kevent(event->kqfd, &ev, 1, NULL, 0, NULL) < 0) {
-            ASSERT(0);
+        want = ed->data.fd.et? 2: 1;
+        if (!ed->data.fd.armed_valid || ed->data.fd.wr_armed != want) {
+            mln_event_kq_change(event, fd, EVFILT_WRITE, want == 2? (EV_ENABLE|EV_CLEAR): EV_ENABLE, ed);
+            ed->data.fd.wr_armed = want;
         }
         ed->data.fd.snd_data = data;
         ed->data.fd.snd_handler = fd_handler;
@@ -620,11 +1271,9 @@ mln_event_fd_timeout_set(mln_event_t *ev, mln_event_desc_t *ed, int timeout_ms)
         return 0;
     }
     mln_fheap_node_t *fn;
-    struct timeval tv;
-    memset(&tv, 0, sizeof(tv));
-    gettimeofday(&tv, NULL);
+    mln_u64_t now_us = mln_clock_mono_us();
     if (ef->timeout_node == NULL) {
-        ef->end_us = tv.tv_sec*1000000+tv.tv_usec+timeout_ms*1000;
+        ef->end_us = now_us+timeout_ms*1000;
         fn = mln_fheap_node_new(ev->ev_fd_timeout_heap, ed);
         if (fn == NULL) {
             return -1;
@@ -634,7 +1283,7 @@ mln_event_fd_timeout_set(mln_event_t *ev, mln_event_desc_t *ed, int timeout_ms)
     } else {
         fn = ef->timeout_node;
         mln_fheap_inline_delete(ev->ev_fd_timeout_heap, fn, mln_event_fd_timeout_copy, mln_event_fd_timeout_cmp);
-        ef->end_us = tv.tv_sec*1000000+tv.tv_usec+timeout_ms*1000;
+        ef->end_us = now_us+timeout_ms*1000;
         mln_fheap_inline_insert(ev->ev_fd_timeout_heap, fn, mln_event_fd_timeout_cmp);
     }
     return 0;
@@ -659,16 +1308,30 @@ mln_event_fd_clr_set(mln_event_t *event, int fd)
         ed->data.fd.timeout_node = NULL;
         ed->data.fd.end_us = 0;
     }
-#if defined(MLN_EPOLL)
+#if defined(MLN_IO_URING)
+    if (ed->data.fd.uring_armed) {
+        struct io_uring_sqe *sqe = mln_event_uring_sqe_get(event);
+        if (sqe != NULL) {
+            sqe->opcode = IORING_OP_POLL_REMOVE;
+            sqe->fd = -1;
+            sqe->addr = (mln_u64_t)(unsigned long)ed;
+            sqe->user_data = 0;
+            /*POLL_REMOVE completes inline, flush stale completions before the free below*/
+            if (mln_event_uring_enter(event, 1, 0, 0) >= 0)
+                mln_event_uring_cq_process(event, ed);
+        }
+        ed->data.fd.uring_armed = 0;
+    }
+#elif defined(MLN_EPOLL)
     struct epoll_event ev;
     memset(&ev, 0, sizeof(ev));
     ev.data.ptr = ed;
     epoll_ctl(event->epollfd, EPOLL_CTL_DEL, fd, &ev);
+    ed->data.fd.armed_valid = 0;
 #elif defined(MLN_KQUEUE)
-    struct kevent ev;
-    EV_SET(&ev, fd, EVFILT_READ, EV_DELETE, 0, 0, ed);
-    EV_SET(&ev, fd, EVFILT_WRITE, EV_DELETE, 0, 0, ed);
-    kevent(event->kqfd, &ev, 1, NULL, 0, NULL);
+    mln_event_kq_change(event, fd, EVFILT_READ, EV_DELETE, ed);
+    mln_event_kq_change(event, fd, EVFILT_WRITE, EV_DELETE, ed);
+    ed->data.fd.armed_valid = 0;
 #else
     if (ed->flag & M_EV_RECV)
         FD_CLR(fd, &(event->rd_set));
@@ -747,9 +1410,100 @@ mln_event_fd_block_set(int fd)
  */
 #define BREAK_OUT(); \
     if (event->is_break) {\
+        mln_clock_leave();\
         return;\
     }
-#if defined(MLN_EPOLL)
+#if defined(MLN_IO_URING)
+void mln_event_dispatch(mln_event_t *event)
+{
+    mln_u32_t to_submit, desired;
+    int ret;
+    mln_event_desc_t *ed;
+    struct io_uring_sqe *sqe;
+
+    mln_clock_enter();
+    while (1) {
+        mln_clock_update();
+        mln_event_stat_loop_begin(event);
+        if (!pthread_mutex_trylock(&event->cb_lock)) {
+            dispatch_callback cb = event->callback;
+            void *data = event->callback_data;
+            if (cb != NULL) {
+                pthread_mutex_unlock(&event->cb_lock);
+                cb(event, data);
+            } else {
+                pthread_mutex_unlock(&event->cb_lock);
+            }
+        }
+        BREAK_OUT();
+        mln_event_timer_process(event);
+        BREAK_OUT();
+        mln_event_active_fd_process(event);
+        BREAK_OUT();
+        mln_event_fd_timeout_process(event);
+        BREAK_OUT();
+        mln_event_timer_process(event);
+        BREAK_OUT();
+        mln_event_stat_loop_end(event);
+
+        if (pthread_mutex_trylock(&event->fd_lock)) {
+            usleep(M_EV_NOLOCK_TIMEOUT_US);
+        } else {
+            to_submit = 0;
+            for (ed = event->ev_fd_wait_head; ed != NULL; ed = ed->next) {
+                if (ed->data.fd.is_clear || ed->data.fd.in_active || ed->data.fd.in_process)
+                    continue;
+                desired = ed->flag & (M_EV_RECV|M_EV_SEND|M_EV_ERROR);
+                if (ed->data.fd.uring_armed == desired)
+                    continue;
+                if (ed->data.fd.uring_armed) {
+                    if ((sqe = mln_event_uring_sqe_get(event)) == NULL)
+                        break;
+                    sqe->opcode = IORING_OP_POLL_REMOVE;
+                    sqe->fd = -1;
+                    sqe->addr = (mln_u64_t)(unsigned long)ed;
+                    sqe->user_data = 0;
+                    ed->data.fd.uring_armed = 0;
+                    ++to_submit;
+                }
+                if (desired == 0)
+                    continue;
+                if ((sqe = mln_event_uring_sqe_get(event)) == NULL)
+                    break;
+                sqe->opcode = IORING_OP_POLL_ADD;
+                sqe->fd = ed->data.fd.fd;
+                if (desired & M_EV_RECV) sqe->poll_events |= POLLIN;
+                if (desired & M_EV_SEND) sqe->poll_events |= POLLOUT;
+                if (desired & M_EV_ERROR) sqe->poll_events |= POLLERR;
+                sqe->user_data = (mln_u64_t)(unsigned long)ed;
+                ed->data.fd.uring_armed = desired;
+                ++to_submit;
+            }
+            if ((sqe = mln_event_uring_sqe_get(event)) != NULL) {
+                event->uring_ts.tv_sec = 0;
+                event->uring_ts.tv_nsec = M_EV_TIMEOUT_NS;
+                sqe->opcode = IORING_OP_TIMEOUT;
+                sqe->fd = -1;
+                sqe->addr = (mln_u64_t)(unsigned long)&(event->uring_ts);
+                sqe->len = 1;
+                sqe->user_data = 0;
+                ++to_submit;
+            }
+            ret = mln_event_uring_enter(event, to_submit, 1, IORING_ENTER_GETEVENTS);
+            if (ret < 0) {
+                if (errno == EINTR) {
+                    pthread_mutex_unlock(&event->fd_lock);
+                    continue;
+                } else {
+                    ASSERT(0);
+                }
+            }
+            mln_event_uring_cq_process(event, NULL);
+            pthread_mutex_unlock(&event->fd_lock);
+        }
+    }
+}
+#elif defined(MLN_EPOLL)
 void mln_event_dispatch(mln_event_t *event)
 {
     __uint32_t mod_event;
@@ -757,7 +1511,10 @@ void mln_event_dispatch(mln_event_t *event)
     mln_event_desc_t *ed;
     struct epoll_event events[M_EV_EPOLL_SIZE], *ev, mod_ev;
 
+    mln_clock_enter();
     while (1) {
+        mln_clock_update();
+        mln_event_stat_loop_begin(event);
         if (!pthread_mutex_trylock(&event->cb_lock)) {
             dispatch_callback cb = event->callback;
             void *data = event->callback_data;
@@ -777,6 +1534,7 @@ void mln_event_dispatch(mln_event_t *event)
         BREAK_OUT();
         mln_event_timer_process(event);
         BREAK_OUT();
+        mln_event_stat_loop_end(event);
 
         if (pthread_mutex_trylock(&event->fd_lock)) {
             epoll_wait(event->unusedfd, events, M_EV_EPOLL_SIZE, M_EV_NOLOCK_TIMEOUT_MS);
@@ -877,6 +1635,7 @@ void mln_event_dispatch(mln_event_t *event)
                     if (ed->flag & M_EV_RECV) mod_event |= EPOLLIN;
                     if (ed->flag & M_EV_SEND) mod_event |= EPOLLOUT;
                     if (ed->flag & M_EV_ERROR) mod_event |= EPOLLERR;
+                    if (ed->data.fd.et) mod_event |= EPOLLET;
                     if (ed->data.fd.rd_oneshot || \
                         ed->data.fd.wr_oneshot || \
                         ed->data.fd.err_oneshot)
@@ -893,6 +1652,8 @@ void mln_event_dispatch(mln_event_t *event)
                         mod_ev.data.ptr = ed;\
                         epoll_ctl(event->epollfd, EPOLL_CTL_MOD, ed->data.fd.fd, &mod_ev);\
                     }
+                    ed->data.fd.armed_events = mod_ev.events;
+                    ed->data.fd.armed_valid = 1;
                 }
             }
             pthread_mutex_unlock(&event->fd_lock);
@@ -907,7 +1668,10 @@ void mln_event_dispatch(mln_event_t *event)
     struct kevent events[M_EV_EPOLL_SIZE], *ev, mod;
     struct timespec ts;
 
+    mln_clock_enter();
     while (1) {
+        mln_clock_update();
+        mln_event_stat_loop_begin(event);
         if (!pthread_mutex_trylock(&event->cb_lock)) {
             dispatch_callback cb = event->callback;
             void *data = event->callback_data;
@@ -927,6 +1691,7 @@ void mln_event_dispatch(mln_event_t *event)
         BREAK_OUT();
         mln_event_timer_process(event);
         BREAK_OUT();
+        mln_event_stat_loop_end(event);
 
         if (pthread_mutex_trylock(&event->fd_lock)) {
             ts.tv_sec = 0;
@@ -974,6 +1739,7 @@ void mln_event_dispatch(mln_event_t *event)
                             if (kevent(event->kqfd, &mod, 1, NULL, 0, NULL) < 0) {
                                 ASSERT(0);
                             }
+                            ed->data.fd.rd_armed = 0;
                             ed->flag &= (~M_EV_RECV);
                         }
                     }
@@ -998,6 +1764,7 @@ void mln_event_dispatch(mln_event_t *event)
                             if (kevent(event->kqfd, &mod, 1, NULL, 0, NULL) < 0) {
                                 ASSERT(0);
                             }
+                            ed->data.fd.wr_armed = 0;
                             ed->flag &= (~M_EV_SEND);
                         }
                     }
@@ -1047,7 +1814,10 @@ void mln_event_dispatch(mln_event_t *event)
     struct timeval tm;
     mln_u32_t move;
 
+    mln_clock_enter();
     while (1) {
+        mln_clock_update();
+        mln_event_stat_loop_begin(event);
         if (!pthread_mutex_trylock(&event->cb_lock)) {
             dispatch_callback cb = event->callback;
             void *data = event->callback_data;
@@ -1067,6 +1837,7 @@ void mln_event_dispatch(mln_event_t *event)
         BREAK_OUT();
         mln_event_timer_process(event);
         BREAK_OUT();
+        mln_event_stat_loop_end(event);
         event->select_fd = 1;
         FD_ZERO(rd_set);
         FD_ZERO(wr_set);
@@ -1163,6 +1934,7 @@ mln_event_active_fd_process(mln_event_t *event)
     mln_event_fd_t *ef;
     ev_fd_handler h;
     void *data;
+    mln_u64_t t0;
     int fd;
 
 lp:
@@ -1192,7 +1964,9 @@ lp:
                 data = ef->rcv_data;
                 fd = ef->fd;
                 pthread_mutex_unlock(&event->fd_lock);
+                t0 = mln_event_stat_cb_begin(event);
                 h(event, fd, data);
+                mln_event_stat_cb_end(event, t0, 0);
                 pthread_mutex_lock(&event->fd_lock);
             }
             ef->active_flag &= (~M_EV_RECV);
@@ -1204,7 +1978,9 @@ lp:
                 data = ef->snd_data;
                 fd = ef->fd;
                 pthread_mutex_unlock(&event->fd_lock);
+                t0 = mln_event_stat_cb_begin(event);
                 h(event, fd, data);
+                mln_event_stat_cb_end(event, t0, 0);
                 pthread_mutex_lock(&event->fd_lock);
             }
             ef->active_flag &= (~M_EV_SEND);
@@ -1216,7 +1992,9 @@ lp:
                 data = ef->err_data;
                 fd = ef->fd;
                 pthread_mutex_unlock(&event->fd_lock);
+                t0 = mln_event_stat_cb_begin(event);
                 h(event, fd, data);
+                mln_event_stat_cb_end(event, t0, 0);
                 pthread_mutex_lock(&event->fd_lock);
             }
             ef->active_flag &= (~M_EV_ERROR);
@@ -1236,15 +2014,13 @@ lp:
 
 static inline void mln_event_fd_timeout_process(mln_event_t *event)
 {
-    mln_u64_t now;
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    now = tv.tv_sec * 1000000 + tv.tv_usec;
+    mln_u64_t now = mln_clock_mono_us();
     mln_event_desc_t *ed;
     mln_fheap_node_t *fn;
     mln_event_fd_t *ef;
     ev_fd_handler h;
     void *data;
+    mln_u64_t t0;
     int fd;
 
 lp:
@@ -1278,7 +2054,9 @@ lp:
         fd = ed->data.fd.fd;
         data = ed->data.fd.timeout_data;
         pthread_mutex_unlock(&event->fd_lock);
+        t0 = mln_event_stat_cb_begin(event);
         h(event, fd, data);
+        mln_event_stat_cb_end(event, t0, 0);
         pthread_mutex_lock(&event->fd_lock);
     }
 
@@ -1292,6 +2070,150 @@ lp:
     goto lp;
 }
 
+/*
+ * multi-loop
+ */
+#if !defined(WIN32)
+struct mln_event_multi_arg_s {
+    mln_event_multi_t *m;
+    mln_u32_t          idx;
+};
+
+static void mln_event_multi_wakeup_handler(mln_event_t *ev, int fd, void *data)
+{
+    char buf[64];
+    while (read(fd, buf, sizeof(buf)) > 0)
+        ;
+}
+
+static inline void mln_event_multi_pin(mln_u32_t idx)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(idx % sysconf(_SC_NPROCESSORS_ONLN), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+int mln_event_wakeup(mln_event_t *ev)
+{
+    if (ev->wr_fd < 0) return -1;
+    if (write(ev->wr_fd, "w", 1) < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        return -1;
+    return 0;
+}
+
+mln_event_multi_t *mln_event_multi_new(mln_u32_t nloops)
+{
+    mln_u32_t i;
+    int fds[2];
+    mln_event_t *ev;
+    mln_event_multi_t *m;
+
+    if (nloops == 0) return NULL;
+    m = (mln_event_multi_t *)malloc(sizeof(mln_event_multi_t));
+    if (m == NULL) return NULL;
+    m->nloops = nloops;
+    m->loops = (mln_event_t **)calloc(nloops, sizeof(mln_event_t *));
+    m->loads = (mln_size_t *)calloc(nloops, sizeof(mln_size_t));
+    m->tids = (pthread_t *)calloc(nloops, sizeof(pthread_t));
+    if (m->loops == NULL || m->loads == NULL || m->tids == NULL)
+        goto err;
+    for (i = 0; i < nloops; ++i) {
+        if ((ev = mln_event_new()) == NULL)
+            goto err;
+        m->loops[i] = ev;
+        if (pipe(fds) < 0)
+            goto err;
+        ev->rd_fd = fds[0];
+        ev->wr_fd = fds[1];
+        if (mln_event_fd_set(ev, \
+                             ev->rd_fd, \
+                             M_EV_RECV|M_EV_NONBLOCK, \
+                             M_EV_UNLIMITED, \
+                             NULL, \
+                             mln_event_multi_wakeup_handler) < 0)
+        {
+            goto err;
+        }
+    }
+    return m;
+
+err:
+    mln_event_multi_free(m);
+    return NULL;
+}
+
+void mln_event_multi_free(mln_event_multi_t *m)
+{
+    mln_u32_t i;
+    if (m == NULL) return;
+    if (m->loops != NULL) {
+        for (i = 0; i < m->nloops; ++i) {
+            mln_event_free(m->loops[i]);
+        }
+        free(m->loops);
+    }
+    if (m->loads != NULL) free(m->loads);
+    if (m->tids != NULL) free(m->tids);
+    free(m);
+}
+
+mln_event_t *mln_event_multi_fd_set(mln_event_multi_t *m, \
+                                    int fd, \
+                                    mln_u32_t flag, \
+                                    int timeout_ms, \
+                                    void *data, \
+                                    ev_fd_handler fd_handler)
+{
+    mln_u32_t i, min = 0;
+    for (i = 1; i < m->nloops; ++i) {
+        if (m->loads[i] < m->loads[min])
+            min = i;
+    }
+    if (mln_event_fd_set(m->loops[min], fd, flag, timeout_ms, data, fd_handler) < 0)
+        return NULL;
+    ++(m->loads[min]);
+    mln_event_wakeup(m->loops[min]);
+    return m->loops[min];
+}
+
+static void *mln_event_multi_dispatch_entry(void *data)
+{
+    struct mln_event_multi_arg_s *arg = (struct mln_event_multi_arg_s *)data;
+    mln_event_multi_pin(arg->idx);
+    mln_event_dispatch(arg->m->loops[arg->idx]);
+    return NULL;
+}
+
+int mln_event_multi_dispatch(mln_event_multi_t *m)
+{
+    mln_u32_t i, n;
+    struct mln_event_multi_arg_s *args;
+
+    args = (struct mln_event_multi_arg_s *)malloc(m->nloops * sizeof(struct mln_event_multi_arg_s));
+    if (args == NULL) return -1;
+    for (n = 1; n < m->nloops; ++n) {
+        args[n].m = m;
+        args[n].idx = n;
+        if (pthread_create(&(m->tids[n]), NULL, mln_event_multi_dispatch_entry, &args[n]) != 0)
+            break;
+    }
+    mln_event_multi_pin(0);
+    mln_event_dispatch(m->loops[0]);
+    for (i = 1; i < n; ++i) {
+        mln_event_break_set(m->loops[i]);
+        mln_event_wakeup(m->loops[i]);
+    }
+    for (i = 1; i < n; ++i) {
+        pthread_join(m->tids[i], NULL);
+    }
+    free(args);
+    return n == m->nloops? 0: -1;
+}
+#endif
+
 /*
  * rbtree functions
  */
@@ -5,6 +5,15 @@
  */
 #include "mln_fec.h"
 #include <errno.h>
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define MLN_FEC_HW_X86 1
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define MLN_FEC_HW_ARM 1
+#include <arm_neon.h>
+#endif
 
 /*string_vector*/
 static inline mln_string_t **mln_string_vector_new(mln_size_t n)
@@ -26,35 +35,54 @@ static inline void mln_string_vector_free(mln_string_t **vec)
 /*
  * operations
  */
-static inline mln_string_t *
-mln_fec_xor(mln_string_t *data1, mln_string_t *data2)
+#if defined(MLN_FEC_HW_X86)
+static int mln_fec_hw_support(void)
 {
-    mln_string_t *ret;
-    mln_u8ptr_t p1, p2, end;
-    if (data1->len > data2->len) {
-        if ((ret = mln_string_dup(data1)) == NULL) {
-            errno = ENOMEM;
-            return NULL;
-        }
-        p1 = ret->data;
-        p2 = data2->data;
-        end = data2->data + data2->len;
-        for (; p2 < end; ++p1, ++p2) {
-            *p1 ^= *p2;
-        }
-    } else {
-        if ((ret = mln_string_dup(data2)) == NULL) {
-            errno = ENOMEM;
-            return NULL;
-        }
-        p1 = data1->data;
-        p2 = ret->data;
-        end = data1->data + data1->len;
-        for (; p1 < end; ++p1, ++p2) {
-            *p2 ^= *p1;
-        }
+    static int support = -1;
+    if (support < 0)
+        support = __builtin_cpu_supports("avx2")? 1: 0;
+    return support;
+}
+
+__attribute__((target("avx2")))
+static mln_size_t mln_fec_xor_region_avx2(mln_u8ptr_t dst, mln_u8ptr_t src, mln_size_t len)
+{
+    mln_size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        _mm256_storeu_si256((__m256i *)(dst + i), \
+                            _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(dst + i)), \
+                                             _mm256_loadu_si256((const __m256i *)(src + i))));
+    }
+    return i;
+}
+#endif
+
+static inline void mln_fec_xor_region(mln_u8ptr_t dst, mln_u8ptr_t src, mln_size_t len)
+{
+    mln_size_t i = 0;
+#if defined(MLN_FEC_HW_X86)
+    if (len >= 32 && mln_fec_hw_support())
+        i = mln_fec_xor_region_avx2(dst, src, len);
+    for (; i + 16 <= len; i += 16) {
+        _mm_storeu_si128((__m128i *)(dst + i), \
+                         _mm_xor_si128(_mm_loadu_si128((const __m128i *)(dst + i)), \
+                                       _mm_loadu_si128((const __m128i *)(src + i))));
+    }
+#elif defined(MLN_FEC_HW_ARM)
+    for (; i + 16 <= len; i += 16) {
+        vst1q_u8(dst + i, veorq_u8(vld1q_u8(dst + i), vld1q_u8(src + i)));
+    }
+#endif
+    for (; i + 8 <= len; i += 8) {
+        mln_u64_t w1, w2;
+        memcpy(&w1, dst + i, sizeof(w1));
+        memcpy(&w2, src + i, sizeof(w2));
+        w1 ^= w2;
+        memcpy(dst + i, &w1, sizeof(w1));
+    }
+    for (; i < len; ++i) {
+        dst[i] ^= src[i];
     }
-    return ret;
 }
 
 /*mln_fec_result_t*/
@@ -106,46 +134,32 @@ mln_fec_generate_fecpacket_fecheader(mln_fec_t *fec, \
                                      mln_size_t *len)
 {
     mln_u16_t tmp16;
-    mln_string_t *ret, tmp, *t;
-    mln_u8_t header[10] = {0}, sn[2];
+    mln_u8_t header[10], acc[10] = {0}, sn[2];
     mln_u8ptr_t *end = packets + n, p;
 
     sn[0] = packets[0][2];
     sn[1] = packets[0][3];
-    mln_string_nset(&tmp, header, sizeof(header));
-    if ((ret = mln_string_dup(&tmp)) == NULL) {
-        errno = ENOMEM;
-        return -1;
-    }
 
     for (; packets < end; ++packets, ++packlen) {
-        t = ret;
         tmp16 = *packlen - M_FEC_RTP_FIXEDLEN;
         memcpy(header, *packets, 8);
         p = header + 8;
         mln_bigendian_encode(tmp16, p, 2);
-        mln_string_nset(&tmp, header, sizeof(header));
-        ret = mln_fec_xor(&tmp, t);
-        mln_string_free(t);
-        if (ret == NULL) {
-            errno = ENOMEM;
-            return -1;
-        }
+        mln_fec_xor_region(acc, header, sizeof(header));
     }
 
-    buf[0] = ret->data[0] & 0x3f;
+    buf[0] = acc[0] & 0x3f;
     if (n > 16) buf[0] |= 0x40;
-    buf[1] = ret->data[1];
+    buf[1] = acc[1];
     buf[2] = sn[0];
     buf[3] = sn[1];
-    buf[4] = ret->data[4];
-    buf[5] = ret->data[5];
-    buf[6] = ret->data[6];
-    buf[7] = ret->data[7];
-    buf[8] = ret->data[8];
-    buf[9] = ret->data[9];
+    buf[4] = acc[4];
+    buf[5] = acc[5];
+    buf[6] = acc[6];
+    buf[7] = acc[7];
+    buf[8] = acc[8];
+    buf[9] = acc[9];
     *len += 10;
-    mln_string_free(ret);
     return 0;
 }
 
@@ -157,11 +171,10 @@ mln_fec_generate_fecpacket_fecbody(mln_fec_t *fec, \
                                    mln_u8ptr_t buf, \
                                    mln_size_t *len)
 {
-    mln_u8_t c = 0;
     mln_u64_t mask = 0;
     mln_u8ptr_t *end, *p, ptr;
-    mln_string_t *t, *ret, tmp;
-    mln_u16_t tmp_sn, sn_base, *pl;
+    mln_u16_t tmp_sn, sn_base, *pl, protect_len = 0;
+    mln_u8_t body[M_FEC_G_MAXLEN] = {0};
 
     ptr = *packets + 2;
     mln_bigendian_decode(sn_base, ptr, 2);
@@ -169,25 +182,14 @@ mln_fec_generate_fecpacket_fecbody(mln_fec_t *fec, \
     mln_bigendian_decode(tmp_sn, ptr, 2);
 
     /*calc ulp level 0 body*/
-    mln_string_nset(&tmp, &c, 1);
-    if ((ret = mln_string_dup(&tmp)) == NULL) {
-        errno = ENOMEM;
-        return -1;
-    }
     end = packets + n;
     for (p = packets, pl = packlen; p < end; ++p, ++pl) {
-        t = ret;
-        mln_string_nset(&tmp, *p, *pl);
-        ret = mln_fec_xor(&tmp, t);
-        mln_string_free(t);
-        if (ret == NULL) {
-            errno = ENOMEM;
-            return -1;
-        }
+        mln_fec_xor_region(body, *p, *pl);
+        if (*pl > protect_len) protect_len = *pl;
     }
 
     /*fill ulp level 0 header*/
-    mln_bigendian_encode(ret->len, buf, 2);
+    mln_bigendian_encode(protect_len, buf, 2);
     *len += 2;
     if (n > 16 || tmp_sn-sn_base > 16) {
         for (p = packets, end = packets+n; p < end; ++p) {
@@ -208,9 +210,8 @@ mln_fec_generate_fecpacket_fecbody(mln_fec_t *fec, \
     }
 
     /*fill ulp level 0 body*/
-    memcpy(buf, ret->data+M_FEC_RTP_FIXEDLEN, ret->len-M_FEC_RTP_FIXEDLEN); 
-    *len += ret->len-M_FEC_RTP_FIXEDLEN;
-    mln_string_free(ret);
+    memcpy(buf, body+M_FEC_RTP_FIXEDLEN, protect_len-M_FEC_RTP_FIXEDLEN);
+    *len += protect_len-M_FEC_RTP_FIXEDLEN;
 
     return 0;
 }
@@ -313,6 +314,126 @@ mln_fec_encode(mln_fec_t *fec, uint8_t *packets[], uint16_t packlen[], size_t n,
     return result;
 }
 
+/*incremental generation*/
+void mln_fec_group_init(mln_fec_t *fec, mln_fec_group_t *group)
+{
+    group->fec = fec;
+    memset(group->header, 0, sizeof(group->header));
+    memset(group->body, 0, sizeof(group->body));
+    group->offsets = 0;
+    group->sn_base = 0;
+    group->last_sn = 0;
+    group->maxlen = 0;
+    group->count = 0;
+}
+
+int mln_fec_group_add(mln_fec_group_t *group, uint8_t *packet, uint16_t len)
+{
+    mln_u16_t seq_no, tmp16;
+    mln_u8ptr_t p;
+    mln_u8_t bit_string[M_FEC_FECHEADER_LEN];
+
+    if (group == NULL || \
+        packet == NULL || \
+        len < M_FEC_RTP_FIXEDLEN || \
+        len > M_FEC_G_MAXLEN || \
+        group->count >= 48)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    p = packet + 2;
+    mln_bigendian_decode(seq_no, p, 2);
+    if (!group->count) {
+        group->sn[0] = packet[2];
+        group->sn[1] = packet[3];
+        group->sn_base = seq_no;
+    } else if (seq_no < group->sn_base || seq_no - group->sn_base > 47) {
+        errno = EINVAL;
+        return -1;
+    }
+    group->offsets |= ((mln_u64_t)1 << (seq_no - group->sn_base));
+    group->last_sn = seq_no;
+
+    memcpy(bit_string, packet, 8);
+    tmp16 = len - M_FEC_RTP_FIXEDLEN;
+    p = bit_string + 8;
+    mln_bigendian_encode(tmp16, p, 2);
+    mln_fec_xor_region(group->header, bit_string, sizeof(bit_string));
+    mln_fec_xor_region(group->body, packet, len);
+    if (len > group->maxlen) group->maxlen = len;
+    memcpy(group->ts_ssrc, packet+4, 8);/*TS and SSRC*/
+    ++group->count;
+    return 0;
+}
+
+mln_string_t *mln_fec_group_close(mln_fec_group_t *group)
+{
+    mln_fec_t *fec;
+    mln_u64_t mask = 0, offsets;
+    mln_string_t tmp, *ret;
+    mln_size_t len = 0, mod;
+    mln_u16_t off;
+    mln_u8_t buf[1472] = {0}, *p;
+
+    if (group == NULL || !group->count) {
+        errno = EINVAL;
+        return NULL;
+    }
+    fec = group->fec;
+
+    p = buf + M_FEC_RTP_FIXEDLEN;
+    p[0] = group->header[0] & 0x3f;
+    if (group->count > 16) p[0] |= 0x40;
+    p[1] = group->header[1];
+    p[2] = group->sn[0];
+    p[3] = group->sn[1];
+    memcpy(p+4, group->header+4, 6);
+    len += M_FEC_FECHEADER_LEN;
+
+    p = buf + M_FEC_RTP_FIXEDLEN + M_FEC_FECHEADER_LEN;
+    mln_bigendian_encode(group->maxlen, p, 2);
+    len += 2;
+    offsets = group->offsets;
+    if (group->count > 16 || group->last_sn - group->sn_base > 16) {
+        for (off = 0; offsets; offsets >>= 1, ++off) {
+            if (offsets & 0x1)
+                mask |= ((mln_u64_t)1 << (47 - off));
+        }
+        mln_bigendian_encode(mask, p, 6);
+        len += 6;
+    } else {
+        for (off = 0; offsets; offsets >>= 1, ++off) {
+            if (offsets & 0x1)
+                mask |= ((mln_u64_t)1 << (15 - off));
+        }
+        mln_bigendian_encode(mask, p, 2);
+        len += 2;
+    }
+    memcpy(p, group->body+M_FEC_RTP_FIXEDLEN, group->maxlen-M_FEC_RTP_FIXEDLEN);
+    len += group->maxlen - M_FEC_RTP_FIXEDLEN;
+
+    len += M_FEC_RTP_FIXEDLEN;
+    buf[0] |= 0x80;
+    if ((mod = (len % 4))) {
+        buf[len + mod - 1] = mod;
+        buf[0] |= 0x20;
+        len += mod;
+    }
+    buf[1] = fec->pt;
+    p = buf + 2;
+    mln_bigendian_encode(fec->seq_no, p, 2);
+    ++fec->seq_no;
+    memcpy(p, group->ts_ssrc, 8);/*TS and SSRC*/
+    mln_string_nset(&tmp, buf, len);
+    if ((ret = mln_string_dup(&tmp)) == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    mln_fec_group_init(fec, group);
+    return ret;
+}
+
 /*recovery*/
 static inline void
 mln_fec_recover_header_info_get(mln_string_t *fec_packet, \
@@ -359,21 +480,15 @@ static int mln_fec_decode_header(mln_fec_t *fec, \
     mln_u8ptr_t ptr;
     mln_u64_t mask = 0;
     mln_u32_t ssrc = 0;
-    mln_string_t tmp, *t, *res;
     mln_u8ptr_t *p, *pend;
     mln_u16_t *pl, seq_no, is_long = 0;
     mln_u16_t sn_base = 0;
-    mln_u8_t bit_string[10] = {0};
+    mln_u8_t bit_string[10], acc[10] = {0};
 
     mln_fec_recover_header_info_get(fec_packet, &sn_base, &ssrc, &mask, &is_long);
     p = packets;
     pend = packets + n;
     pl = packlen;
-    mln_string_nset(&tmp, bit_string, sizeof(bit_string));
-    if ((res = mln_string_dup(&tmp)) == NULL) {
-        errno = ENOMEM;
-        return -1;
-    }
     for (; p < pend; ++p, ++pl) {
         if (((*p)[1] & 0x7f) == fec->pt)
             continue;
@@ -391,21 +506,13 @@ static int mln_fec_decode_header(mln_fec_t *fec, \
             mask &= (~((mln_u64_t)1 << (15 - (seq_no - sn_base))));
         }
 
-        t = res;
         memcpy(bit_string, *p, 8);
         ptr = bit_string + 8;
         *body_len = *pl - M_FEC_RTP_FIXEDLEN;
         mln_bigendian_encode(*body_len, ptr, 2);
-        mln_string_nset(&tmp, bit_string, sizeof(bit_string));
-        res = mln_fec_xor(t, &tmp);
-        mln_string_free(t);
-        if (res == NULL) {
-            errno = ENOMEM;
-            return -1;
-        }
+        mln_fec_xor_region(acc, bit_string, sizeof(bit_string));
     }
     if (!mask) {
-        mln_string_free(res);
         *blen = 0;
         return 0;
     }
@@ -419,21 +526,12 @@ static int mln_fec_decode_header(mln_fec_t *fec, \
         }
     }
     if (mask) {
-        mln_string_free(res);
         errno = EFAULT;
         return -1;
     }
 
-    memcpy(bit_string, fec_packet->data+M_FEC_RTP_FIXEDLEN, sizeof(bit_string));
-    mln_string_nset(&tmp, bit_string, sizeof(bit_string));
-    t = res;
-    res = mln_fec_xor(t, &tmp);
-    mln_string_free(t);
-    if (res == NULL) {
-        errno = ENOMEM;
-        return -1;
-    }
-    ptr = res->data;
+    mln_fec_xor_region(acc, fec_packet->data+M_FEC_RTP_FIXEDLEN, sizeof(acc));
+    ptr = acc;
     *buf++ = ((*ptr++) & 0x3f) | 0x80;
     *buf++ = *ptr++;
     mln_bigendian_encode(seq_no, buf, 2);
@@ -445,7 +543,6 @@ static int mln_fec_decode_header(mln_fec_t *fec, \
     mln_bigendian_encode(ssrc, buf, 4);
     *blen = M_FEC_RTP_FIXEDLEN;
     mln_bigendian_decode(*body_len, ptr, 2);
-    mln_string_free(res);
     return 0;
 }
 
@@ -462,7 +559,6 @@ static int mln_fec_decode_body(mln_fec_t *fec, \
     mln_u16_t seq_no, sn_base, protect_len = 0;
     mln_u16_t *pl, is_long = 0;
     mln_u8ptr_t ptr, *p, *pend;
-    mln_string_t *t, *res, tmp;
     mln_u8_t body[1472] = {0};
 
     mln_fec_recover_header_info_get(fec_packet, &sn_base, NULL, &mask, &is_long);
@@ -471,11 +567,6 @@ static int mln_fec_decode_body(mln_fec_t *fec, \
     ptr = is_long? ptr+6: ptr+2;
     if (ptr - fec_packet->data < fec_packet->len)
         memcpy(body+M_FEC_RTP_FIXEDLEN, ptr, protect_len-M_FEC_RTP_FIXEDLEN);
-    mln_string_nset(&tmp, body, protect_len);
-    if ((res = mln_string_dup(&tmp)) == NULL) {
-        errno = ENOMEM;
-        return -1;
-    }
     p = (mln_u8ptr_t *)packets;
     pend = (mln_u8ptr_t *)packets + n;
     pl = packlen;
@@ -494,17 +585,9 @@ static int mln_fec_decode_body(mln_fec_t *fec, \
             mask &= (~((mln_u64_t)1 << (15 - (seq_no - sn_base))));
         }
 
-        t = res;
-        mln_string_nset(&tmp, *p, *pl>protect_len? protect_len: *pl);
-        res = mln_fec_xor(t, &tmp);
-        mln_string_free(t);
-        if (res == NULL) {
-            errno = ENOMEM;
-            return -1;
-        }
+        mln_fec_xor_region(body, *p, *pl>protect_len? protect_len: *pl);
     }
-    memcpy(buf, res->data+M_FEC_RTP_FIXEDLEN, body_len);
-    mln_string_free(res);
+    memcpy(buf, body+M_FEC_RTP_FIXEDLEN, body_len);
     *blen += body_len;
     return 0;
 }
@@ -41,31 +41,76 @@ mln_fheap_t *mln_fheap_new(void *min_val, struct mln_fheap_attr *attr)
     fh->min = NULL;
     fh->root_list = NULL;
     fh->num = 0;
+    fh->mode = FHEAP_MODE_FIB;
+    return fh;
+}
+
+mln_fheap_t *mln_fheap_pairing_new(void *min_val, struct mln_fheap_attr *attr)
+{
+    mln_fheap_t *fh = mln_fheap_new(min_val, attr);
+    if (fh != NULL) fh->mode = FHEAP_MODE_PAIRING;
     return fh;
 }
 
 void mln_fheap_insert(mln_fheap_t *fh, mln_fheap_node_t *fn)
 {
+    if (fh->mode == FHEAP_MODE_PAIRING) {
+        mln_fheap_pairing_insert(fh, fn, fh->cmp);
+        return;
+    }
     mln_fheap_inline_insert(fh, fn, NULL);
 }
 
+int mln_fheap_build(mln_fheap_t *fh, void **keys, mln_size_t n)
+{
+    mln_size_t i;
+    mln_fheap_node_t *fn;
+
+    for (i = 0; i < n; ++i) {
+        if ((fn = mln_fheap_node_new(fh, keys[i])) == NULL)
+            return -1;
+        mln_fheap_insert(fh, fn);
+    }
+    return 0;
+}
+
 mln_fheap_node_t *mln_fheap_extract_min(mln_fheap_t *fh)
 {
+    if (fh->mode == FHEAP_MODE_PAIRING)
+        return mln_fheap_pairing_extract(fh, fh->cmp);
     return mln_fheap_inline_extract_min(fh, NULL);
 }
 
 int mln_fheap_decrease_key(mln_fheap_t *fh, mln_fheap_node_t *node, void *key)
 {
+    if (fh->mode == FHEAP_MODE_PAIRING)
+        return mln_fheap_pairing_decrease(fh, node, key, fh->copy, fh->cmp);
     return mln_fheap_inline_decrease_key(fh, node, key, NULL, NULL);
 }
 
 void mln_fheap_delete(mln_fheap_t *fh, mln_fheap_node_t *node)
 {
+    if (fh->mode == FHEAP_MODE_PAIRING) {
+        mln_fheap_pairing_decrease(fh, node, fh->min_val, fh->copy, fh->cmp);
+        mln_fheap_pairing_extract(fh, fh->cmp);
+        return;
+    }
     mln_fheap_inline_delete(fh, node, NULL, NULL);
 }
 
 void mln_fheap_free(mln_fheap_t *fh)
 {
+    mln_fheap_node_t *fn;
+
+    if (fh == NULL) return;
+    if (fh->mode == FHEAP_MODE_PAIRING) {
+        while ((fn = mln_fheap_pairing_extract(fh, fh->cmp)) != NULL) {
+            mln_fheap_inline_node_free(fh, fn, NULL);
+        }
+        if (fh->pool != NULL) fh->pool_free(fh);
+        else free(fh);
+        return;
+    }
     mln_fheap_inline_free(fh, NULL, NULL);
 }
 
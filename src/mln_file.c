@@ -10,11 +10,21 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <errno.h>
+#include <time.h>
 #include <sys/time.h>
+#if !defined(WIN32)
+#include <sys/mman.h>
+#endif
 
 MLN_CHAIN_FUNC_DECLARE(reg_file, \
                        mln_file_t, \
                        static inline void,);
+#if !defined(WIN32)
+MLN_CHAIN_FUNC_DECLARE(cache_file, \
+                       mln_file_t, \
+                       static inline void,);
+static void mln_file_cache_unmap(mln_file_t *f);
+#endif
 static int mln_file_set_cmp(const void *data1, const void *data2);
 static void mln_file_free(void *pfile);
 
@@ -47,10 +57,39 @@ mln_fileset_t *mln_fileset_init(mln_size_t max_file)
 
     fs->reg_free_head = fs->reg_free_tail = NULL;
     fs->max_file = max_file;
+    memset(&(fs->stat), 0, sizeof(fs->stat));
+    fs->cache_head = fs->cache_tail = NULL;
+    fs->cache_size = 0;
+    fs->cache_max = 0;
+    fs->cache_threshold = 0;
 
     return fs;
 }
 
+void mln_fileset_cache_set(mln_fileset_t *fs, mln_size_t max_bytes, mln_size_t file_threshold)
+{
+    fs->cache_max = max_bytes;
+    fs->cache_threshold = file_threshold;
+}
+
+void mln_fileset_stat(mln_fileset_t *fs, mln_fileset_stat_t *st)
+{
+    *st = fs->stat;
+}
+
+static inline void mln_fileset_shrink(mln_fileset_t *fs)
+{
+    mln_file_t *f;
+    while (mln_rbtree_node_num(fs->reg_file_tree) > fs->max_file && \
+           (f = fs->reg_free_head) != NULL)
+    {
+        reg_file_chain_del(&(fs->reg_free_head), &(fs->reg_free_tail), f);
+        mln_rbtree_delete(fs->reg_file_tree, f->node);
+        mln_rbtree_node_free(fs->reg_file_tree, f->node);
+        ++(fs->stat.evict);
+    }
+}
+
 static int mln_file_set_cmp(const void *data1, const void *data2)
 {
     mln_file_t *f1 = (mln_file_t *)data1;
@@ -82,6 +121,7 @@ mln_file_t *mln_file_open(mln_fileset_t *fs, const char *filepath)
     if (mln_rbtree_null(rn, fs->reg_file_tree)) {
         struct stat st;
 
+        ++(fs->stat.miss);
         if ((f = (mln_file_t *)mln_alloc_m(fs->pool, sizeof(mln_file_t))) == NULL) {
             return NULL;
         }
@@ -89,35 +129,84 @@ mln_file_t *mln_file_open(mln_fileset_t *fs, const char *filepath)
             mln_alloc_free(f);
             return NULL;
         }
+        f->negative = 0;
         if ((f->fd = open(filepath, O_RDONLY)) < 0) {
-            mln_string_free(f->file_path);
-            mln_alloc_free(f);
-            return NULL;
+            if (errno != ENOENT) {
+                mln_string_free(f->file_path);
+                mln_alloc_free(f);
+                return NULL;
+            }
+            f->negative = 1;
+            f->mtime = f->ctime = f->atime = 0;
+            f->size = 0;
+            f->check_time = time(NULL);
+        } else {
+            if (fstat(f->fd, &st) < 0) {
+                close(f->fd);
+                mln_string_free(f->file_path);
+                mln_alloc_free(f);
+                return NULL;
+            }
+            f->mtime = st.st_mtime;
+            f->ctime = st.st_ctime;
+            f->atime = st.st_atime;
+            f->size = st.st_size;
+            f->check_time = 0;
         }
         f->is_tmp = 0;
-        if (fstat(f->fd, &st) < 0) {
-            close(f->fd);
-            mln_string_free(f->file_path);
-            mln_alloc_free(f);
-            return NULL;
-        }
-        f->mtime = st.st_mtime;
-        f->ctime = st.st_ctime;
-        f->atime = st.st_atime;
-        f->size = st.st_size;
         f->refer_cnt = 0;
+        f->cache_stale = 0;
+        f->map = NULL;
+        mln_string_nset(&(f->content), NULL, 0);
+        f->cache_prev = f->cache_next = NULL;
         reg_file_chain_add(&(fs->reg_free_head), &(fs->reg_free_tail), f);
         f->fset = fs;
         if ((rn = mln_rbtree_node_new(fs->reg_file_tree, f)) == NULL) {
-            close(f->fd);
+            reg_file_chain_del(&(fs->reg_free_head), &(fs->reg_free_tail), f);
+            if (f->fd >= 0) close(f->fd);
             mln_string_free(f->file_path);
             mln_alloc_free(f);
             return NULL;
         }
         mln_rbtree_insert(fs->reg_file_tree, rn);
         f->node = rn;
+        if (f->negative) {
+            mln_fileset_shrink(fs);
+            return NULL;
+        }
     } else {
         f = (mln_file_t *)mln_rbtree_node_data_get(rn);
+        if (f->negative) {
+            struct stat st;
+            time_t now = time(NULL);
+
+            /*touch the entry so repeatedly probed paths stay cached*/
+            reg_file_chain_del(&(fs->reg_free_head), &(fs->reg_free_tail), f);
+            reg_file_chain_add(&(fs->reg_free_head), &(fs->reg_free_tail), f);
+            if (now == f->check_time) {
+                ++(fs->stat.neg_hit);
+                return NULL;
+            }
+            ++(fs->stat.miss);
+            if ((f->fd = open(filepath, O_RDONLY)) < 0) {
+                f->check_time = now;
+                return NULL;
+            }
+            if (fstat(f->fd, &st) < 0) {
+                close(f->fd);
+                f->fd = -1;
+                f->check_time = now;
+                return NULL;
+            }
+            f->negative = 0;
+            f->mtime = st.st_mtime;
+            f->ctime = st.st_ctime;
+            f->atime = st.st_atime;
+            f->size = st.st_size;
+            f->check_time = 0;
+        } else {
+            ++(fs->stat.hit);
+        }
     }
 
     if (f->refer_cnt++ == 0) {
@@ -145,14 +234,13 @@ void mln_file_close(mln_file_t *pfile)
     }
 
     fs = pfile->fset;
+#if !defined(WIN32)
+    if (pfile->map != NULL && pfile->cache_stale)
+        mln_file_cache_unmap(pfile);
+#endif
     reg_file_chain_add(&(fs->reg_free_head), &(fs->reg_free_tail), pfile);
 
-    if (mln_rbtree_node_num(fs->reg_file_tree) > fs->max_file) {
-        pfile = fs->reg_free_head;
-        reg_file_chain_del(&(fs->reg_free_head), &(fs->reg_free_tail), pfile);
-        mln_rbtree_delete(fs->reg_file_tree, pfile->node);
-        mln_rbtree_node_free(fs->reg_file_tree, pfile->node);
-    }
+    mln_fileset_shrink(fs);
 }
 
 static void mln_file_free(void *pfile)
@@ -160,12 +248,101 @@ static void mln_file_free(void *pfile)
     if (pfile == NULL) return;
 
     mln_file_t *f = (mln_file_t *)pfile;
+#if !defined(WIN32)
+    if (f->map != NULL)
+        mln_file_cache_unmap(f);
+#endif
     if (f->file_path != NULL)
         mln_string_free(f->file_path);
     if (f->fd >= 0) close(f->fd);
     mln_alloc_free(f);
 }
 
+#if !defined(WIN32)
+static void mln_file_cache_unmap(mln_file_t *f)
+{
+    mln_fileset_t *fs = f->fset;
+    cache_file_chain_del(&(fs->cache_head), &(fs->cache_tail), f);
+    fs->cache_size -= f->content.len;
+    munmap(f->map, f->content.len);
+    f->map = NULL;
+    f->cache_stale = 0;
+    mln_string_nset(&(f->content), NULL, 0);
+}
+
+static void mln_file_cache_evict(mln_fileset_t *fs)
+{
+    mln_file_t *f, *next;
+    for (f = fs->cache_head; f != NULL && fs->cache_size > fs->cache_max; f = next) {
+        next = f->cache_next;
+        if (f->refer_cnt > 0) continue; /*views may still be in use*/
+        mln_file_cache_unmap(f);
+    }
+}
+#endif
+
+mln_string_t *mln_file_content(mln_file_t *pfile)
+{
+#if defined(WIN32)
+    return NULL;
+#else
+    struct stat st;
+    mln_fileset_t *fs = pfile->fset;
+    void *addr;
+    int fd, changed;
+
+    if (fs == NULL || fs->cache_max == 0 || pfile->is_tmp || pfile->fd < 0)
+        return NULL;
+    time_t now = time(NULL);
+    if (pfile->map != NULL && !pfile->cache_stale && now == pfile->check_time) {
+        cache_file_chain_del(&(fs->cache_head), &(fs->cache_tail), pfile);
+        cache_file_chain_add(&(fs->cache_head), &(fs->cache_tail), pfile);
+        return &(pfile->content);
+    }
+    if (stat((char *)(pfile->file_path->data), &st) < 0)
+        return NULL;
+    pfile->check_time = now;
+    changed = st.st_mtime != pfile->mtime || (size_t)st.st_size != pfile->size;
+    if (pfile->map != NULL) {
+        if (!changed && !pfile->cache_stale) {
+            cache_file_chain_del(&(fs->cache_head), &(fs->cache_tail), pfile);
+            cache_file_chain_add(&(fs->cache_head), &(fs->cache_tail), pfile);
+            return &(pfile->content);
+        }
+        pfile->cache_stale = 1;
+        if (pfile->refer_cnt > 1) return NULL; /*old views may still be in use*/
+        mln_file_cache_unmap(pfile);
+    }
+    if (changed) {
+        /*
+         * the descriptor may still refer to a replaced inode; it can
+         * only be refreshed when the caller is the sole holder.
+         */
+        if (pfile->refer_cnt > 1) return NULL;
+        if ((fd = open((char *)(pfile->file_path->data), O_RDONLY)) < 0)
+            return NULL;
+        close(pfile->fd);
+        pfile->fd = fd;
+        pfile->mtime = st.st_mtime;
+        pfile->ctime = st.st_ctime;
+        pfile->atime = st.st_atime;
+        pfile->size = st.st_size;
+    }
+    if (st.st_size <= 0 || (mln_size_t)st.st_size > fs->cache_threshold)
+        return NULL;
+    addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, pfile->fd, 0);
+    if (addr == MAP_FAILED)
+        return NULL;
+    pfile->map = addr;
+    mln_string_nset(&(pfile->content), addr, st.st_size);
+    cache_file_chain_add(&(fs->cache_head), &(fs->cache_tail), pfile);
+    fs->cache_size += st.st_size;
+    if (fs->cache_size > fs->cache_max)
+        mln_file_cache_evict(fs);
+    return &(pfile->content);
+#endif
+}
+
 mln_file_t *mln_file_tmp_open(mln_alloc_t *pool)
 {
     char dir_path[512] = {0};
@@ -192,12 +369,18 @@ mln_file_t *mln_file_tmp_open(mln_alloc_t *pool)
     f->file_path = NULL;
     f->fd = -1;
     f->is_tmp = 1;
+    f->cache_stale = 0;
+    f->negative = 0;
     f->mtime = f->ctime = f->atime = 0;
     f->size = 0;
     f->refer_cnt = 0;
     f->prev = f->next = NULL;
     f->fset = NULL;
     f->node = NULL;
+    f->map = NULL;
+    mln_string_nset(&(f->content), NULL, 0);
+    f->check_time = 0;
+    f->cache_prev = f->cache_next = NULL;
 lp:
     gettimeofday(&now, NULL);
     suffix = now.tv_sec * 1000000 + now.tv_usec;
@@ -224,3 +407,11 @@ MLN_CHAIN_FUNC_DEFINE(reg_file, \
                       prev, \
                       next);
 
+#if !defined(WIN32)
+MLN_CHAIN_FUNC_DEFINE(cache_file, \
+                      mln_file_t, \
+                      static inline void, \
+                      cache_prev, \
+                      cache_next);
+#endif
+
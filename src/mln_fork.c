@@ -3,11 +3,19 @@
  * Copyright (C) Niklaus F.Schen.
  */
 #if !defined(WIN32)
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /*for sched_setaffinity*/
+#endif
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
 #include <signal.h>
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
 #include "mln_defs.h"
 #include "mln_fork.h"
 #include "mln_rbtree.h"
@@ -16,7 +24,11 @@
 #include "mln_global.h"
 #include "mln_ipc.h"
 #include "mln_alloc.h"
+#include "mln_clock.h"
 #include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 
 mln_tcp_conn_t master_conn;
 mln_size_t child_error_bytes;
@@ -30,6 +42,14 @@ mln_rbtree_t *master_ipc_tree = NULL;
 mln_rbtree_t *worker_ipc_tree = NULL;
 clr_handler rs_clr_handler = NULL;
 void *rs_clr_data = NULL;
+quit_handler worker_quit_handler = NULL;
+#if defined(__linux__)
+static mln_u32_t fork_slot = 0;
+#endif
+static int zygote_fd = -1; /*master end of the zygote template channel, -1 when off*/
+static mln_fork_health_t *health_blk = NULL;  /*mapped health file, NULL when off*/
+static mln_fork_health_t *health_self = NULL; /*this worker's claimed slot*/
+static mln_u64_t health_sched_ms = 0;         /*when the next beat should fire*/
 
 MLN_CHAIN_FUNC_DECLARE(worker_list, \
                        mln_fork_t, \
@@ -64,6 +84,159 @@ static void
 mln_ipc_fd_handler_worker_send(mln_event_t *ev, int fd, void *data);
 static inline mln_ipc_handler_t *mln_ipc_handler_new(mln_u32_t type, ipc_handler handler, void *data);
 static void mln_ipc_handler_free(mln_ipc_handler_t *ih);
+static void
+mln_fork_quit_worker_handler(mln_event_t *ev, void *c, void *buf, mln_u32_t len, void **udata);
+static int
+mln_fork_zygote_entry(int chan);
+static int
+mln_fork_zygote_request(mln_u32_t slot, pid_t *pid);
+#if defined(__linux__)
+static int mln_fork_cpu_node(int cpu);
+static int mln_fork_node_count(void);
+static int mln_fork_cpu_pick(mln_u32_t slot);
+static void mln_fork_worker_place(mln_u32_t slot);
+#endif
+
+/*
+ * worker health block
+ */
+static int mln_fork_health_init(void)
+{
+    char path[512] = {0};
+    int fd, len;
+    mln_size_t size = M_FORK_HEALTH_MAX * sizeof(mln_fork_health_t);
+    void *addr;
+
+    mln_conf_t *cf = mln_conf();
+    if (cf == NULL) return 0;
+    mln_conf_domain_t *cd = cf->search(cf, "main");
+    if (cd == NULL) return 0;
+    mln_conf_cmd_t *cc = cd->search(cd, "health_file");
+    if (cc == NULL) return 0;
+
+    mln_conf_item_t *ci = cc->search(cc, 1);
+    if (ci == NULL || ci->type != CONF_STR) {
+        mln_log(error, "Command 'health_file' need a string parameter.\n");
+        return -1;
+    }
+    len = ci->val.s->len;
+    if (len > (int)sizeof(path) - 1) len = sizeof(path) - 1;
+    memcpy(path, ci->val.s->data, len);
+
+    if ((fd = open(path, O_RDWR|O_CREAT, 0644)) < 0) {
+        mln_log(error, "open '%s' failed, %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, size) < 0) {
+        mln_log(error, "ftruncate '%s' failed, %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    addr = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);/*the mapping keeps the file alive*/
+    if (addr == MAP_FAILED) {
+        mln_log(error, "mmap '%s' failed, %s\n", path, strerror(errno));
+        return -1;
+    }
+    memset(addr, 0, size);
+    health_blk = (mln_fork_health_t *)addr;
+    return 0;
+}
+
+/*
+ * Claim the first slot that is free or whose owner no longer exists
+ * (a restarted worker inherits its predecessor's line). CAS on the pid
+ * keeps two workers racing for the same line apart.
+ */
+static void mln_fork_health_claim(void)
+{
+    mln_fork_health_t *s, *end;
+    mln_u32_t owner;
+
+    if (health_blk == NULL) return;
+    end = health_blk + M_FORK_HEALTH_MAX;
+    for (s = health_blk; s < end; ++s) {
+        owner = __atomic_load_n(&s->pid, __ATOMIC_ACQUIRE);
+        if (owner != 0 && (kill((pid_t)owner, 0) == 0 || errno != ESRCH))
+            continue;
+        if (__atomic_compare_exchange_n(&s->pid, &owner, (mln_u32_t)getpid(), 0, \
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        {
+            s->heartbeat = 0;
+            s->loop_lag_ms = 0;
+            s->conn_count = 0;
+            __atomic_store_n(&s->mono_ms, mln_clock_mono_ms(), __ATOMIC_RELEASE);
+            __atomic_store_n(&s->state, M_FORK_HEALTH_BOOT, __ATOMIC_RELEASE);
+            health_self = s;
+            return;
+        }
+    }
+    mln_log(report, "All %d health slots taken; worker unmonitored.\n", M_FORK_HEALTH_MAX);
+}
+
+static void mln_fork_health_beat(mln_event_t *ev, void *data)
+{
+    mln_u64_t now = mln_clock_mono_ms();
+    mln_fork_health_t *s = health_self;
+
+    __atomic_store_n(&s->loop_lag_ms, \
+                     now > health_sched_ms? (mln_u32_t)(now - health_sched_ms): 0, \
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&s->mono_ms, now, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&s->heartbeat, 1, __ATOMIC_RELEASE);
+    health_sched_ms = now + M_FORK_HEALTH_PERIOD_MS;
+    if (mln_event_timer_set(ev, M_FORK_HEALTH_PERIOD_MS, NULL, mln_fork_health_beat) < 0)
+        mln_log(error, "health timer re-arm failed.\n");
+}
+
+int mln_fork_health_enabled(void)
+{
+    return health_blk != NULL;
+}
+
+void mln_fork_health_state_set(mln_u32_t state)
+{
+    if (health_self == NULL) return;
+    __atomic_store_n(&health_self->state, state, __ATOMIC_RELEASE);
+}
+
+void mln_fork_health_conn_set(mln_u32_t count)
+{
+    if (health_self == NULL) return;
+    __atomic_store_n(&health_self->conn_count, count, __ATOMIC_RELAXED);
+}
+
+int mln_fork_health_iterate(fork_health_iterate_handler handler, void *udata)
+{
+    mln_fork_health_t *s, *end;
+
+    if (health_blk == NULL) return -1;
+    end = health_blk + M_FORK_HEALTH_MAX;
+    for (s = health_blk; s < end; ++s) {
+        if (__atomic_load_n(&s->pid, __ATOMIC_ACQUIRE) == 0) continue;
+        if (handler != NULL && handler(s, udata) < 0) break;
+    }
+    return 0;
+}
+
+mln_fork_health_t *mln_fork_health_attach(const char *path)
+{
+    int fd;
+    void *addr;
+    mln_size_t size = M_FORK_HEALTH_MAX * sizeof(mln_fork_health_t);
+
+    if ((fd = open(path, O_RDONLY)) < 0) return NULL;
+    addr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return NULL;
+    return (mln_fork_health_t *)addr;
+}
+
+void mln_fork_health_detach(mln_fork_health_t *slots)
+{
+    if (slots == NULL) return;
+    munmap(slots, M_FORK_HEALTH_MAX * sizeof(mln_fork_health_t));
+}
 
 /*pre-fork*/
 int mln_fork_prepare(void)
@@ -107,6 +280,17 @@ int mln_fork_prepare(void)
         mln_tcp_conn_destroy(&master_conn);
         return -1;
     }
+    if (mln_fork_worker_ipc_handler_set(M_IPC_TYPE_QUIT, mln_fork_quit_worker_handler, NULL) < 0) {
+        mln_log(error, "No memory.\n");
+        mln_rbtree_free(worker_ipc_tree);
+        worker_ipc_tree = NULL;
+        mln_rbtree_free(master_ipc_tree);
+        master_ipc_tree = NULL;
+        if (mln_tcp_conn_fd_get(&master_conn) >= 0)
+            mln_socket_close(mln_tcp_conn_fd_get(&master_conn));
+        mln_tcp_conn_destroy(&master_conn);
+        return -1;
+    }
     if (mln_set_ipc_handlers() < 0) {
         mln_log(error, "No memory.\n");
         mln_rbtree_free(worker_ipc_tree);
@@ -118,6 +302,16 @@ int mln_fork_prepare(void)
         mln_tcp_conn_destroy(&master_conn);
         return -1;
     }
+    if (mln_fork_health_init() < 0) {
+        mln_rbtree_free(worker_ipc_tree);
+        worker_ipc_tree = NULL;
+        mln_rbtree_free(master_ipc_tree);
+        master_ipc_tree = NULL;
+        if (mln_tcp_conn_fd_get(&master_conn) >= 0)
+            mln_socket_close(mln_tcp_conn_fd_get(&master_conn));
+        mln_tcp_conn_destroy(&master_conn);
+        return -1;
+    }
     return 0;
 }
 
@@ -147,10 +341,12 @@ mln_fork_init(struct mln_fork_attr *attr)
     f->pid = attr->pid;
     f->n_args = attr->n_args;
     f->state = STATE_IDLE;
+    f->quit = 0;
     f->msg_len = 0;
     f->msg_type = 0;
     f->error_bytes = 0;
     f->msg_content = NULL;
+    f->bulk_ring = NULL;
     f->etype = attr->etype;
     f->stype = attr->stype;
     worker_list_chain_add(&worker_list_head, &worker_list_tail, f);
@@ -168,6 +364,10 @@ mln_fork_destroy(mln_fork_t *f, int free_args)
     if (f->msg_content != NULL) {
         free(f->msg_content);
     }
+    if (f->bulk_ring != NULL) {
+        mln_ipc_bulk_ring_free(f->bulk_ring);
+        f->bulk_ring = NULL;
+    }
     if (mln_tcp_conn_fd_get(&(f->conn)) >= 0)
         mln_socket_close(mln_tcp_conn_fd_get(&(f->conn)));
     mln_tcp_conn_destroy(&(f->conn));
@@ -305,6 +505,272 @@ int mln_fork_restart(mln_event_t *master_ev)
                         master_ev);
 }
 
+/*
+ * zygote worker template
+ */
+int mln_fork_zygote_init(void)
+{
+    int fds[2];
+    pid_t pid;
+
+    if (zygote_fd >= 0) return 1;/*already armed*/
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        mln_log(error, "socketpair() error. %s\n", strerror(errno));
+        return -1;
+    }
+    pid = fork();
+    if (pid > 0) {
+        mln_socket_close(fds[1]);
+        zygote_fd = fds[0];
+        return 1;
+    } else if (pid < 0) {
+        mln_log(error, "fork() error. %s\n", strerror(errno));
+        mln_socket_close(fds[0]);
+        mln_socket_close(fds[1]);
+        return -1;
+    }
+    /*template process: sit idle on the channel and fork on demand*/
+    mln_socket_close(fds[0]);
+    return mln_fork_zygote_entry(fds[1]);
+}
+
+/*
+ * The template's service loop. Each request carries the worker slot in
+ * the data bytes and the worker's end of a master-created socketpair as
+ * an SCM_RIGHTS descriptor. The loop only returns in a freshly forked
+ * worker -- and from there mln_fork_zygote_init() returns 0 -- so the
+ * worker pays nothing but the fork: all state built before the template
+ * was created is inherited copy-on-write. EOF on the channel means the
+ * master exited or never armed more spawns; the template just quits.
+ */
+static int
+mln_fork_zygote_entry(int chan)
+{
+    int n, wfd;
+    pid_t pid;
+    mln_u32_t slot;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    char cbuf[CMSG_SPACE(sizeof(int))];
+
+    while (1) {
+        memset(&msg, 0, sizeof(msg));
+        memset(cbuf, 0, sizeof(cbuf));
+        iov.iov_base = &slot;
+        iov.iov_len = sizeof(slot);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = cbuf;
+        msg.msg_controllen = sizeof(cbuf);
+        while ((n = recvmsg(chan, &msg, 0)) < 0 && (errno == EINTR || errno == EAGAIN))
+            ;
+        if (n <= 0) exit(0);
+        cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            exit(1);
+        memcpy(&wfd, CMSG_DATA(cmsg), sizeof(int));
+
+        pid = fork();
+        if (pid == 0) {
+            mln_socket_close(chan);
+            mln_fork_destroy_all();
+            mln_rbtree_free(master_ipc_tree);
+            if (rs_clr_handler != NULL)
+                rs_clr_handler(rs_clr_data);
+            master_ipc_tree = NULL;
+            mln_tcp_conn_fd_set(&master_conn, wfd);
+            signal(SIGCHLD, SIG_DFL);
+#if defined(__linux__)
+            mln_fork_worker_place(slot);
+#endif
+            if (write(wfd, " ", 1) < 0)
+                exit(1);
+            return 0;
+        }
+        if (pid < 0)
+            mln_log(error, "fork() error. %s\n", strerror(errno));
+        mln_socket_close(wfd);
+        while (write(chan, &pid, sizeof(pid)) < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            exit(1);
+        }
+    }
+}
+
+/*
+ * Master side of a template spawn: hand the worker's socketpair end and
+ * its slot to the template, read the new pid back, then wait for the
+ * worker's ready byte just as do_fork_core() does before arming any
+ * event on the descriptor. Returns the master's end of the socketpair,
+ * or -1; a dead template disarms zygote mode so callers can fall back
+ * to a plain fork.
+ */
+static int
+mln_fork_zygote_request(mln_u32_t slot, pid_t *pid)
+{
+    int fds[2], n;
+    pid_t p;
+    mln_u8_t c;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    char cbuf[CMSG_SPACE(sizeof(int))];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        mln_log(error, "socketpair() error. %s\n", strerror(errno));
+        return -1;
+    }
+    memset(&msg, 0, sizeof(msg));
+    memset(cbuf, 0, sizeof(cbuf));
+    iov.iov_base = &slot;
+    iov.iov_len = sizeof(slot);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fds[1], sizeof(int));
+    while (sendmsg(zygote_fd, &msg, 0) < 0) {
+        if (errno == EINTR || errno == EAGAIN) continue;
+        goto dead;
+    }
+    mln_socket_close(fds[1]);
+    fds[1] = -1;
+    while ((n = read(zygote_fd, &p, sizeof(p))) < 0 && (errno == EINTR || errno == EAGAIN))
+        ;
+    if (n != sizeof(p)) goto dead;
+    if (p < 0) {/*template alive but its fork() failed*/
+        mln_socket_close(fds[0]);
+        return -1;
+    }
+    while (read(fds[0], &c, 1) <= 0)
+        ;
+    *pid = p;
+    return fds[0];
+
+dead:
+    mln_log(error, "Zygote template dead, fall back to fork().\n");
+    mln_socket_close(zygote_fd);
+    zygote_fd = -1;
+    mln_socket_close(fds[0]);
+    if (fds[1] >= 0) mln_socket_close(fds[1]);
+    return -1;
+}
+
+int mln_fork_replace(mln_event_t *master_ev)
+{
+    mln_fork_t *f, *end = worker_list_tail;
+    int rv;
+
+    if (worker_list_head == NULL) return 1;
+    for (f = worker_list_head; ; f = f->next) {
+        if (!f->quit) {
+            if (f->etype == M_PET_DFL) {
+                if ((rv = mln_fork_restart(master_ev)) < 0) {
+                    mln_log(error, "mln_fork_restart() error.\n");
+                    return -1;
+                } else if (rv == 0) {
+                    /*replacement child: leave the master's event loop*/
+                    mln_event_break_set(master_ev);
+                    return 0;
+                }
+            } else {/*M_PET_EXE*/
+                if (mln_fork_spawn(f->stype, f->args, f->n_args, master_ev) < 0) {
+                    mln_log(error, "mln_fork_spawn() error.\n");
+                    return -1;
+                }
+            }
+            f->quit = 1;
+            if (mln_ipc_master_send_prepare(master_ev, M_IPC_TYPE_QUIT, "quit", 4, f) < 0) {
+                mln_log(error, "mln_ipc_master_send_prepare() failed.\n");
+                return -1;
+            }
+            mln_log(report, "Worker %l replaced.\n", (long)(f->pid));
+        }
+        if (f == end) break;/*workers spawned above sit after 'end'*/
+    }
+    return 1;
+}
+
+void mln_fork_worker_quit_handler_set(quit_handler handler)
+{
+    worker_quit_handler = handler;
+}
+
+static void
+mln_fork_quit_worker_handler(mln_event_t *ev, void *c, void *buf, mln_u32_t len, void **udata)
+{
+    mln_fork_health_state_set(M_FORK_HEALTH_QUITTING);
+    if (worker_quit_handler != NULL) {
+        worker_quit_handler(ev);
+    } else {
+        mln_event_break_set(ev);
+    }
+}
+
+/*
+ * descriptor passing (SCM_RIGHTS) over the master-worker socketpair
+ */
+int mln_fork_fd_send(mln_fork_t *f, int fd)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    char byte = 'F';
+    char cbuf[CMSG_SPACE(sizeof(int))];
+
+    memset(&msg, 0, sizeof(msg));
+    memset(cbuf, 0, sizeof(cbuf));
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    while (sendmsg(mln_tcp_conn_fd_get(&(f->conn)), &msg, 0) < 0) {
+        if (errno == EINTR || errno == EAGAIN) continue;
+        return -1;
+    }
+    return 0;
+}
+
+int mln_fork_fd_recv(void)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    char byte;
+    char cbuf[CMSG_SPACE(sizeof(int))];
+    int fd;
+
+    memset(&msg, 0, sizeof(msg));
+    memset(cbuf, 0, sizeof(cbuf));
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    while (recvmsg(mln_tcp_conn_fd_get(&master_conn), &msg, 0) <= 0) {
+        if (errno == EINTR || errno == EAGAIN) continue;
+        return -1;
+    }
+    cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+        return -1;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
+}
+
 static int
 do_fork_worker_process(mln_sauto_t n_worker_proc)
 {
@@ -327,6 +793,104 @@ void mln_fork_resource_clear_handler_set(clr_handler handler, void *data)
     rs_clr_data = data;
 }
 
+#if defined(__linux__)
+#define M_FORK_MAX_NODE        64
+#define M_FORK_MPOL_PREFERRED  1
+
+static int mln_fork_cpu_node(int cpu)
+{
+    int node;
+    char path[128];
+    for (node = 0; node < M_FORK_MAX_NODE; ++node) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", node);
+        if (access(path, F_OK) < 0) break;
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpu%d", node, cpu);
+        if (access(path, F_OK) == 0) return node;
+    }
+    return -1;
+}
+
+static int mln_fork_node_count(void)
+{
+    int node;
+    char path[128];
+    for (node = 0; node < M_FORK_MAX_NODE; ++node) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", node);
+        if (access(path, F_OK) < 0) break;
+    }
+    return node > 0? node: 1;
+}
+
+/*
+ * Pick the CPU for the worker numbered 'slot', or -1 when pinning is
+ * off. 'worker_affinity on;' round-robins across NUMA nodes first so
+ * consecutive workers land on different sockets, then across the CPUs
+ * of each node; an explicit CPU list is used round-robin as given.
+ */
+static int mln_fork_cpu_pick(mln_u32_t slot)
+{
+    mln_conf_t *cf;
+    mln_conf_domain_t *cd;
+    mln_conf_cmd_t *cc;
+    mln_conf_item_t *ci;
+    mln_u32_t n;
+    long ncpu;
+    int nnode, node, cnt, want, cpu;
+
+    if ((cf = mln_conf()) == NULL) return -1;
+    if ((cd = cf->search(cf, "main")) == NULL) return -1;
+    if ((cc = cd->search(cd, "worker_affinity")) == NULL) return -1;
+    if ((n = mln_conf_arg_num(cc)) == 0) {
+        mln_log(error, "Command 'worker_affinity' need parameter(s).\n");
+        return -1;
+    }
+    ci = cc->search(cc, 1);
+    if (n == 1 && ci != NULL && ci->type == CONF_BOOL) {
+        if (!ci->val.b) return -1;
+        if ((ncpu = sysconf(_SC_NPROCESSORS_ONLN)) <= 0) return -1;
+        if ((nnode = mln_fork_node_count()) <= 1) return slot % ncpu;
+        node = slot % nnode;
+        for (cnt = 0, cpu = 0; cpu < ncpu; ++cpu)
+            if (mln_fork_cpu_node(cpu) == node) ++cnt;
+        if (cnt == 0) return slot % ncpu;
+        want = (slot / nnode) % cnt;
+        for (cpu = 0; cpu < ncpu; ++cpu)
+            if (mln_fork_cpu_node(cpu) == node && want-- == 0) return cpu;
+        return slot % ncpu;
+    }
+    ci = cc->search(cc, slot % n + 1);
+    if (ci == NULL || ci->type != CONF_INT || ci->val.i < 0) {
+        mln_log(error, "Invalid parameter of command 'worker_affinity'.\n");
+        return -1;
+    }
+    return (int)ci->val.i;
+}
+
+static void mln_fork_worker_place(mln_u32_t slot)
+{
+    int cpu, node;
+    cpu_set_t set;
+
+    if ((cpu = mln_fork_cpu_pick(slot)) < 0) return;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) < 0) {
+        mln_log(report, "Pin worker to CPU %d failed. %s\n", cpu, strerror(errno));
+        return;
+    }
+#if defined(SYS_set_mempolicy)
+    if ((node = mln_fork_cpu_node(cpu)) >= 0) {
+        unsigned long mask[2] = {0, 0};
+        mask[node / (sizeof(unsigned long) * 8)] |= 1UL << (node % (sizeof(unsigned long) * 8));
+        /*best effort: kernels built without NUMA support reject this*/
+        syscall(SYS_set_mempolicy, M_FORK_MPOL_PREFERRED, mask, sizeof(mask) * 8);
+    }
+#else
+    (void)node;
+#endif
+}
+#endif
+
 static int
 do_fork_core(enum proc_exec_type etype, \
              enum proc_state_type stype, \
@@ -336,11 +900,52 @@ do_fork_core(enum proc_exec_type etype, \
 {
     int fds[2];
     mln_u8_t c;
+    void *bulk;
+#if defined(__linux__)
+    mln_u32_t slot = fork_slot++;
+#else
+    mln_u32_t slot = 0;
+#endif
+
+    if (zygote_fd >= 0 && etype == M_PET_DFL) {
+        int cfd;
+        pid_t zpid;
+        if ((cfd = mln_fork_zygote_request(slot, &zpid)) >= 0) {
+            struct mln_fork_attr fattr;
+            fattr.args = args;
+            fattr.n_args = n_args;
+            fattr.fd = cfd;
+            fattr.pid = zpid;
+            fattr.etype = etype;
+            fattr.stype = stype;
+            mln_fork_t *f = mln_fork_init(&fattr);
+            if (f == NULL) {
+                mln_log(error, "No memory.\n");
+                abort();
+            }
+            if (master_ev != NULL) {
+                if (mln_event_fd_set(master_ev, \
+                                     mln_tcp_conn_fd_get(&(f->conn)), \
+                                     M_EV_RECV, \
+                                     M_EV_UNLIMITED, \
+                                     f, \
+                                     mln_ipc_fd_handler_master) < 0)
+                {
+                    mln_log(error, "mln_event_fd_set() failed.\n");
+                    abort();
+                }
+            }
+            return 1;
+        }
+        if (zygote_fd >= 0) return -1;
+        /*the template died; disarmed above, fall through to a plain fork*/
+    }
 
     if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
         mln_log(error, "socketpair() error. %s\n", strerror(errno));
         return -1;
     }
+    bulk = mln_ipc_bulk_ring_new();/*NULL unless the bulk channel is set up*/
 
     pid_t pid = fork();
     if (pid > 0) {
@@ -374,6 +979,7 @@ do_fork_core(enum proc_exec_type etype, \
             mln_log(error, "No memory.\n");
             abort();
         }
+        f->bulk_ring = bulk;
         if (master_ev != NULL) {
             if (mln_event_fd_set(master_ev, \
                                  mln_tcp_conn_fd_get(&(f->conn)), \
@@ -389,6 +995,7 @@ do_fork_core(enum proc_exec_type etype, \
         return 1;
     } else if (pid == 0) {
         mln_socket_close(fds[0]);
+        mln_ipc_bulk_worker_attach(bulk);/*before destroy_all: rings live in shared memory*/
         mln_fork_destroy_all();
         mln_rbtree_free(master_ipc_tree);
         if (rs_clr_handler != NULL)
@@ -396,11 +1003,17 @@ do_fork_core(enum proc_exec_type etype, \
         master_ipc_tree = NULL;
         mln_tcp_conn_fd_set(&master_conn, fds[1]);
         signal(SIGCHLD, SIG_DFL);
+#if defined(__linux__)
+        mln_fork_worker_place(slot);
+#endif
         if (write(fds[1], " ", 1) < 0)
             exit(1);
         return 0;
     }
     mln_log(error, "fork() error. %s\n", strerror(errno));
+    mln_ipc_bulk_ring_free(bulk);
+    mln_socket_close(fds[0]);
+    mln_socket_close(fds[1]);
     return -1;
 }
 
@@ -493,6 +1106,17 @@ void mln_fork_worker_events_set(mln_event_t *ev)
         mln_log(error, "mln_event_fd_set() failed.\n");
         abort();
     }
+    if (health_blk != NULL && health_self == NULL) {
+        mln_fork_health_claim();
+        if (health_self != NULL) {
+            health_sched_ms = mln_clock_mono_ms() + M_FORK_HEALTH_PERIOD_MS;
+            if (mln_event_timer_set(ev, M_FORK_HEALTH_PERIOD_MS, NULL, mln_fork_health_beat) < 0) {
+                mln_log(error, "health timer set failed.\n");
+            } else {
+                mln_fork_health_state_set(M_FORK_HEALTH_RUNNING);
+            }
+        }
+    }
 }
 
 int mln_fork_iterate(mln_event_t *ev, fork_iterate_handler handler, void *data)
@@ -675,6 +1299,12 @@ mln_ipc_fd_handler_master_process(mln_event_t *ev, mln_fork_t *f)
 void mln_fork_socketpair_close_handler(mln_event_t *ev, mln_fork_t *f, int fd)
 {
     mln_event_fd_set(ev, fd, M_EV_CLR, M_EV_UNLIMITED, NULL, NULL);
+    if (f->quit) {
+        /*replaced worker finished draining; its successor already runs*/
+        mln_log(report, "Replaced worker exited.\n");
+        mln_fork_destroy(f, 0);
+        return;
+    }
     enum proc_exec_type etype = f->etype;
     enum proc_state_type stype = f->stype;
     mln_s8ptr_t *args = f->args;
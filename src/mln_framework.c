@@ -4,6 +4,7 @@
  */
 #include "mln_thread.h"
 #include "mln_fork.h"
+#include "mln_ipc.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -27,6 +28,9 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #endif
+#if defined(__linux__)
+#include <linux/filter.h>
+#endif
 
 static void mln_init_notice(int argc, char *argv[]);
 #if !defined(WIN32)
@@ -36,9 +40,14 @@ static void mln_master_routine(struct mln_framework_attr *attr);
 static mln_string_t *mln_get_framework_status(void);
 static void mln_sig_conf_reload(int signo);
 static int mln_conf_reload_iterate_handler(mln_event_t *ev, mln_fork_t *f, void *data);
+static void mln_accept_stat_timer_handler(mln_event_t *ev, void *data);
+static void mln_accept_stat_master_handler(mln_event_t *ev, void *f, void *buf, mln_u32_t len, void **udata);
 
 static mln_event_t *_ev = NULL;
+static mln_u32_t m_accept_stat_period = 0;
+static mln_framework_accept_stat_cb_t m_accept_stat_cb = NULL;
 #endif
+static mln_u64_t m_accept_cnt = 0;
 
 
 int mln_framework_init(struct mln_framework_attr *attr)
@@ -66,6 +75,11 @@ int mln_framework_init(struct mln_framework_attr *attr)
             return -1;
         }
 
+        /*Memory layout tuning (hot-text huge pages, data prefault)*/
+        if (mln_sys_layout_modify() < 0) {
+            return -1;
+        }
+
         /*daemon*/
         if (mln_daemon() < 0) {
             fprintf(stderr, "Melon boot up failed.\n");
@@ -130,6 +144,9 @@ static void mln_worker_routine(struct mln_framework_attr *attr)
     }
 
     mln_trace_init(ev, mln_trace_path());
+    if (m_accept_stat_period > 0) {
+        mln_event_timer_set(ev, m_accept_stat_period, NULL, mln_accept_stat_timer_handler);
+    }
     if (i_thread_mode) {
         if (mln_load_thread(ev) < 0)
             exit(1);
@@ -212,7 +229,152 @@ static mln_string_t *mln_get_framework_status(void)
     }
     return NULL;
 }
+
+/*
+ * accept-rate reports
+ */
+typedef struct {
+    mln_u64_t pid;
+    mln_u64_t count;
+} mln_accept_stat_msg_t;
+
+static void mln_accept_stat_worker_handler(mln_event_t *ev, void *c, void *buf, mln_u32_t len, void **udata)
+{
+    /*the master never sends this type to workers*/
+}
+
+int mln_framework_accept_stat_set(mln_u32_t period_ms, mln_framework_accept_stat_cb_t cb)
+{
+    m_accept_stat_period = period_ms;
+    m_accept_stat_cb = cb;
+    return mln_ipc_handler_register(M_IPC_TYPE_ACCEPT_STAT, \
+                                    mln_accept_stat_master_handler, \
+                                    mln_accept_stat_worker_handler, \
+                                    NULL, \
+                                    NULL);
+}
+
+static void mln_accept_stat_timer_handler(mln_event_t *ev, void *data)
+{
+    mln_accept_stat_msg_t msg;
+
+    msg.pid = (mln_u64_t)getpid();
+    msg.count = m_accept_cnt;
+    mln_ipc_worker_send_prepare(ev, M_IPC_TYPE_ACCEPT_STAT, &msg, sizeof(msg));
+    mln_event_timer_set(ev, m_accept_stat_period, NULL, mln_accept_stat_timer_handler);
+}
+
+static void mln_accept_stat_master_handler(mln_event_t *ev, void *f, void *buf, mln_u32_t len, void **udata)
+{
+    mln_accept_stat_msg_t msg;
+
+    if (len != sizeof(msg)) return;
+    memcpy(&msg, buf, sizeof(msg));
+    if (m_accept_stat_cb != NULL) {
+        m_accept_stat_cb((pid_t)msg.pid, msg.count);
+    } else {
+        mln_log(report, "accept stat: pid %l accepted %U connection(s)\n", \
+                (long)msg.pid, (unsigned long)msg.count);
+    }
+}
+#endif
+
+/*
+ * worker listening
+ */
+int mln_framework_listener_open(const char *host, const char *service, mln_u32_t flags)
+{
+    struct addrinfo hints, *res = NULL, *rp;
+    int fd = -1, opt = 1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_flags = AI_PASSIVE;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_IP;
+    if (getaddrinfo(host, service, &hints, &res) != 0 || res == NULL) {
+        return -1;
+    }
+    for (rp = res; rp != NULL; rp = rp->ai_next) {
+        if ((fd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol)) < 0) {
+            continue;
+        }
+#if defined(WIN32)
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (char *)&opt, sizeof(opt));
+#else
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+#if defined(SO_REUSEPORT)
+        if (flags & M_LISTEN_REUSEPORT) {
+            if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+                mln_socket_close(fd);
+                fd = -1;
+                continue;
+            }
+        }
+#endif
+#endif
+#if defined(WIN32)
+        {
+            u_long nb = 1;
+            ioctlsocket(fd, FIONBIO, &nb);
+        }
+#else
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, NULL) | O_NONBLOCK);
+#endif
+        if (bind(fd, rp->ai_addr, rp->ai_addrlen) == 0 && listen(fd, 511) == 0) {
+            break;
+        }
+        mln_socket_close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0) return -1;
+
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+    if ((flags & M_LISTEN_REUSEPORT) && (flags & M_LISTEN_CPU_STEER)) {
+        /*
+         * keep a connection on the CPU its packets arrive on: the
+         * listener index in the reuseport group is taken from the
+         * current CPU number. Best effort -- without it the kernel's
+         * flow hash still spreads the load.
+         */
+        struct sock_filter code[2];
+        struct sock_fprog prog;
+        memset(code, 0, sizeof(code));
+        code[0].code = BPF_LD | BPF_W | BPF_ABS;
+        code[0].k = (mln_u32_t)(SKF_AD_OFF + SKF_AD_CPU);
+        code[1].code = BPF_RET | BPF_A;
+        prog.len = 2;
+        prog.filter = code;
+        setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+    }
+#endif
+    return fd;
+}
+
+int mln_framework_listener_accept(int listenfd)
+{
+    int fd;
+
+    if ((fd = accept(listenfd, NULL, NULL)) < 0) {
+        return -1;
+    }
+#if defined(WIN32)
+    {
+        u_long nb = 1;
+        ioctlsocket(fd, FIONBIO, &nb);
+    }
+#else
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, NULL) | O_NONBLOCK);
 #endif
+    ++m_accept_cnt;
+    return fd;
+}
+
+mln_u64_t mln_framework_accept_count(void)
+{
+    return m_accept_cnt;
+}
 
 static void mln_init_notice(int argc, char *argv[])
 {
@@ -23,6 +23,14 @@ MLN_CHAIN_FUNC_DEFINE(mln_gc_item_proc, \
                       static inline void, \
                       proc_prev, \
                       proc_next);
+MLN_CHAIN_FUNC_DECLARE(mln_gc_item_rset, \
+                       mln_gc_item_t, \
+                       static inline void,);
+MLN_CHAIN_FUNC_DEFINE(mln_gc_item_rset, \
+                      mln_gc_item_t, \
+                      static inline void, \
+                      rset_prev, \
+                      rset_next);
 
 static inline mln_gc_item_t *mln_gc_item_new(mln_gc_t *gc, void *data)
 {
@@ -34,10 +42,15 @@ static inline mln_gc_item_t *mln_gc_item_new(mln_gc_t *gc, void *data)
     item->data = data;
     item->prev = item->next = NULL;
     item->proc_prev = item->proc_next = NULL;
+    item->rset_prev = item->rset_next = NULL;
     item->suspected = 0;
     item->credit = 0;
     item->inc = 0;
     item->visited = 0;
+    item->gen = 0;
+    item->age = 0;
+    item->remembered = 0;
+    item->young_ref = 0;
     return item;
 }
 
@@ -76,7 +89,20 @@ mln_gc_t *mln_gc_new(struct mln_gc_attr *attr)
     gc->root_setter = attr->root_setter;
     gc->clean_searcher = attr->clean_searcher;
     gc->free_handler = attr->free_handler;
+    gc->stage_head = gc->stage_tail = NULL;
+    gc->old_head = gc->old_tail = NULL;
+    gc->rset_head = gc->rset_tail = NULL;
+    gc->scan = NULL;
+    gc->rscan = NULL;
+    gc->marking = NULL;
+    gc->root = NULL;
+    gc->budget = 0;
     gc->del = 0;
+    gc->state = M_GC_STATE_IDLE;
+    gc->dirty = 0;
+    gc->progress = 0;
+    gc->minor = 0;
+    gc->old_done = 0;
     return gc;
 }
 
@@ -84,14 +110,25 @@ void mln_gc_free(mln_gc_t *gc)
 {
     if (gc == NULL) return;
     mln_gc_item_t *item;
+    while ((item = gc->stage_head) != NULL) {
+        mln_gc_item_proc_chain_del(&(gc->stage_head), &(gc->stage_tail), item);
+    }
     while ((item = gc->proc_head) != NULL) {
         mln_gc_item_proc_chain_del(&(gc->proc_head), &(gc->proc_tail), item);
     }
+    while ((item = gc->rset_head) != NULL) {
+        mln_gc_item_rset_chain_del(&(gc->rset_head), &(gc->rset_tail), item);
+    }
     while ((item = gc->item_head) != NULL) {
         mln_gc_item_chain_del(&(gc->item_head), &(gc->item_tail), item);
         gc->free_handler(item->data);
         mln_gc_item_free(item);
     }
+    while ((item = gc->old_head) != NULL) {
+        mln_gc_item_chain_del(&(gc->old_head), &(gc->old_tail), item);
+        gc->free_handler(item->data);
+        mln_gc_item_free(item);
+    }
     mln_alloc_free(gc);
 }
 
@@ -120,12 +157,22 @@ void mln_gc_merge(mln_gc_t *dest, mln_gc_t *src)
      */
     ASSERT(dest != src && dest->pool == src->pool);
     mln_gc_item_t *item;
+    while ((item = src->rset_head) != NULL) {
+        mln_gc_item_rset_chain_del(&(src->rset_head), &(src->rset_tail), item);
+        mln_gc_item_rset_chain_add(&(dest->rset_head), &(dest->rset_tail), item);
+    }
     while ((item = src->item_head) != NULL) {
         mln_gc_item_chain_del(&(src->item_head), &(src->item_tail), item);
         src->move_handler(dest, item->data);
         item->gc = dest;
         mln_gc_item_chain_add(&(dest->item_head), &(dest->item_tail), item);
     }
+    while ((item = src->old_head) != NULL) {
+        mln_gc_item_chain_del(&(src->old_head), &(src->old_tail), item);
+        src->move_handler(dest, item->data);
+        item->gc = dest;
+        mln_gc_item_chain_add(&(dest->old_head), &(dest->old_tail), item);
+    }
 }
 
 void mln_gc_collect_add(mln_gc_t *gc, void *data)
@@ -133,6 +180,8 @@ void mln_gc_collect_add(mln_gc_t *gc, void *data)
     if (data == NULL) return;
     mln_gc_item_t *item = (mln_gc_item_t *)(gc->item_getter(data));
     ASSERT(item != NULL); /* 'data' has NOT been added. */
+    if (gc->marking != NULL && !item->gen)
+        gc->marking->young_ref = 1;
     if (item->proc_prev != NULL || \
         item->proc_next != NULL || \
         (gc->proc_head == gc->proc_tail && gc->proc_head == item))
@@ -159,79 +208,277 @@ int mln_gc_clean_add(mln_gc_t *gc, void *data)
     return 0;
 }
 
-void mln_gc_collect(mln_gc_t *gc, void *root_data)
+int mln_gc_collect_begin(mln_gc_t *gc, void *root_data)
 {
-    int done = 0;
-    mln_gc_item_t *item, *head = NULL, *tail = NULL;
-    for (item = gc->item_head; item != NULL; item = item->next) {
-        if (item->proc_prev == NULL && \
-            item->proc_next == NULL && \
-            gc->proc_head != item)
-            mln_gc_item_proc_chain_add(&(gc->proc_head), &(gc->proc_tail), item);
+    if (gc->state != M_GC_STATE_IDLE) return -1;
+    gc->root = root_data;
+    gc->scan = gc->item_head;
+    gc->rscan = NULL;
+    gc->minor = 0;
+    gc->old_done = 0;
+    gc->state = M_GC_STATE_ENQUEUE;
+    return 0;
+}
+
+int mln_gc_collect_minor_begin(mln_gc_t *gc, void *root_data)
+{
+    if (gc->state != M_GC_STATE_IDLE) return -1;
+    gc->root = root_data;
+    gc->scan = gc->item_head;
+    gc->rscan = gc->rset_head;
+    gc->minor = 1;
+    gc->old_done = 0;
+    gc->state = M_GC_STATE_ENQUEUE;
+    return 0;
+}
+
+/*
+ * Called on every cycle survivor during partition. Nursery survivors
+ * age and eventually promote; old survivors reconcile their remembered
+ * set membership against what the mark pass just observed. Promotion
+ * can only make references older, so deciding from 'young_ref' never
+ * drops a live old-to-young edge.
+ */
+static inline void mln_gc_item_age(mln_gc_t *gc, mln_gc_item_t *item)
+{
+    if (item->gen) {
+        if (item->remembered && !item->young_ref) {
+            mln_gc_item_rset_chain_del(&(gc->rset_head), &(gc->rset_tail), item);
+            item->remembered = 0;
+        } else if (!item->remembered && item->young_ref) {
+            mln_gc_item_rset_chain_add(&(gc->rset_head), &(gc->rset_tail), item);
+            item->remembered = 1;
+        }
+        item->young_ref = 0;
+        return;
+    }
+    if (++(item->age) < M_GC_GEN_PROMOTE_AGE) {
+        item->young_ref = 0;
+        return;
     }
-    if (root_data != NULL && gc->root_setter != NULL)
-        gc->root_setter(gc, root_data);
-    while (!done) {
-        done = 1;
-        for (item = gc->proc_head; item != NULL; item = item->proc_next) {
+    item->gen = 1;
+    mln_gc_item_chain_del(&(gc->item_head), &(gc->item_tail), item);
+    mln_gc_item_chain_add(&(gc->old_head), &(gc->old_tail), item);
+    if (item->young_ref) {
+        mln_gc_item_rset_chain_add(&(gc->rset_head), &(gc->rset_tail), item);
+        item->remembered = 1;
+    }
+    item->young_ref = 0;
+}
+
+int mln_gc_collect_step(mln_gc_t *gc, mln_size_t budget)
+{
+    mln_gc_item_t *item;
+    mln_size_t left = budget? budget: (mln_size_t)-1;
+
+again:
+    switch (gc->state) {
+    case M_GC_STATE_ENQUEUE:
+        for (;;) {
+            while ((item = gc->scan) != NULL) {
+                if (!left) return 1;
+                --left;
+                gc->scan = item->next;
+                if (item->proc_prev == NULL && \
+                    item->proc_next == NULL && \
+                    gc->proc_head != item)
+                    mln_gc_item_proc_chain_add(&(gc->proc_head), &(gc->proc_tail), item);
+            }
+            if (!gc->minor && !gc->old_done) {
+                gc->old_done = 1;
+                gc->scan = gc->old_head;
+                continue;
+            }
+            break;
+        }
+        /*a minor cycle scans only the remembered part of the old generation*/
+        while ((item = gc->rscan) != NULL) {
+            if (!left) return 1;
+            --left;
+            gc->rscan = item->rset_next;
+            if (item->proc_prev == NULL && \
+                item->proc_next == NULL && \
+                gc->proc_head != item)
+                mln_gc_item_proc_chain_add(&(gc->proc_head), &(gc->proc_tail), item);
+        }
+        if (gc->root != NULL && gc->root_setter != NULL)
+            gc->root_setter(gc, gc->root);
+        gc->dirty = 0;
+        gc->progress = 0;
+        gc->scan = gc->proc_head;
+        gc->state = M_GC_STATE_MARK;
+        goto again;
+    case M_GC_STATE_MARK:
+        for (;;) {
+            if (gc->scan == NULL) {
+                if (!gc->progress && !gc->dirty) break;
+                gc->progress = 0;
+                gc->dirty = 0;
+                if ((gc->scan = gc->proc_head) == NULL) break;
+            }
+            if (!left) return 1;
+            --left;
+            item = gc->scan;
+            gc->scan = item->proc_next;
             if ((item->suspected && !item->credit) || item->visited) {
                 continue;
             }
+            gc->marking = item;
             gc->member_setter(gc, item->data);
+            gc->marking = NULL;
             item->visited = 1;
-            if (done) done = 0;
+            gc->progress = 1;
         }
-    }
-
-    while ((item = gc->proc_head) != NULL) {
-        mln_gc_item_proc_chain_del(&(gc->proc_head), &(gc->proc_tail), item);
-        if (item->inc) {
-            item->inc = 0;
-            item->visited = 0;
-            item->credit = 0;
-            continue;
+        gc->state = M_GC_STATE_PARTITION;
+        goto again;
+    case M_GC_STATE_PARTITION:
+        while ((item = gc->proc_head) != NULL) {
+            if (!left) return 1;
+            --left;
+            mln_gc_item_proc_chain_del(&(gc->proc_head), &(gc->proc_tail), item);
+            if (item->inc) {
+                item->inc = 0;
+                item->visited = 0;
+                item->credit = 0;
+                item->young_ref = 0;
+                continue;
+            }
+            /*old garbage is only reclaimed by a full cycle*/
+            if (item->credit || !item->suspected || (gc->minor && item->gen)) {
+                item->credit = 0;
+                item->visited = 0;
+                mln_gc_item_age(gc, item);
+                continue;
+            }
+            item->young_ref = 0;
+            mln_gc_item_proc_chain_add(&(gc->stage_head), &(gc->stage_tail), item);
         }
-        if (item->credit) {
-            item->credit = 0;
-            item->visited = 0;
-            continue;
+        gc->proc_head = gc->stage_head;
+        gc->proc_tail = gc->stage_tail;
+        gc->stage_head = gc->stage_tail = NULL;
+        gc->iter = gc->proc_head;
+        gc->state = M_GC_STATE_CLEAN;
+        goto again;
+    case M_GC_STATE_CLEAN:
+        while (gc->iter != NULL) {
+            if (!left) return 1;
+            --left;
+            if (gc->iter->visited) {
+                gc->iter = gc->iter->next;
+                continue;
+            }
+            gc->clean_searcher(gc, gc->iter->data);
+            if (gc->del) {
+                gc->del = 0;
+                continue;
+            }
+            gc->iter->visited = 1;
+            gc->iter = gc->iter->proc_next;
         }
-        if (!item->suspected) {
-            item->visited = 0;
-            item->credit = 0;
-            continue;
+        gc->state = M_GC_STATE_SWEEP;
+        goto again;
+    case M_GC_STATE_SWEEP:
+        while ((item = gc->proc_head) != NULL) {
+            if (!left) return 1;
+            --left;
+            mln_gc_item_proc_chain_del(&(gc->proc_head), &(gc->proc_tail), item);
+            if (item->inc) {
+                item->inc = 0;
+                item->visited = 0;
+                item->young_ref = 0;
+                continue;
+            }
+            if (item->remembered) {
+                mln_gc_item_rset_chain_del(&(gc->rset_head), &(gc->rset_tail), item);
+                item->remembered = 0;
+            }
+            if (item->gen)
+                mln_gc_item_chain_del(&(gc->old_head), &(gc->old_tail), item);
+            else
+                mln_gc_item_chain_del(&(gc->item_head), &(gc->item_tail), item);
+            gc->item_freer(item->data);
+            mln_gc_item_free(item);
         }
-        mln_gc_item_proc_chain_add(&head, &tail, item);
+        gc->root = NULL;
+        gc->minor = 0;
+        gc->old_done = 0;
+        gc->state = M_GC_STATE_IDLE;
+        /*fall through*/
+    default:
+        break;
     }
-    gc->proc_head = head;
-    gc->proc_tail = tail;
+    return 0;
+}
 
-    for (gc->iter = gc->proc_head; gc->iter != NULL;) {
-        if (gc->iter->visited) {
-            gc->iter = gc->iter->next;
-            continue;
-        }
-        gc->clean_searcher(gc, gc->iter->data);
-        if (gc->del) {
-            gc->del = 0;
-            continue;
+void mln_gc_write_barrier(mln_gc_t *gc, void *data)
+{
+    if (data == NULL) return;
+    mln_gc_item_t *item = (mln_gc_item_t *)(gc->item_getter(data));
+    if (item == NULL) return;
+    if (item->gen && !item->remembered) {
+        mln_gc_item_rset_chain_add(&(gc->rset_head), &(gc->rset_tail), item);
+        item->remembered = 1;
+        /*
+         * A minor cycle past enqueue would otherwise never scan this
+         * item; pull it into the work chain so the new reference is
+         * seen before the cycle ends.
+         */
+        if (gc->minor && gc->state == M_GC_STATE_MARK && \
+            item->proc_prev == NULL && \
+            item->proc_next == NULL && \
+            gc->proc_head != item)
+        {
+            mln_gc_item_proc_chain_add(&(gc->proc_head), &(gc->proc_tail), item);
+            gc->dirty = 1;
         }
-        gc->iter->visited = 1;
-        gc->iter = gc->iter->proc_next;
     }
-    while ((item = gc->proc_head) != NULL) {
-        mln_gc_item_proc_chain_del(&(gc->proc_head), &(gc->proc_tail), item);
-        if (item->inc) {
-            item->inc = 0;
-            item->visited = 0;
-            continue;
-        }
-        mln_gc_item_chain_del(&(gc->item_head), &(gc->item_tail), item);
-        gc->item_freer(item->data);
-        mln_gc_item_free(item);
+    if (gc->state != M_GC_STATE_MARK || !item->visited) return;
+    item->visited = 0;
+    gc->dirty = 1;
+}
+
+static void mln_gc_slice_handler(mln_event_t *ev, void *data)
+{
+    mln_gc_t *gc = (mln_gc_t *)data;
+    if (mln_gc_collect_step(gc, gc->budget) <= 0) return;
+    if (mln_event_timer_set(ev, 0, gc, mln_gc_slice_handler) == NULL) {
+        /*cannot re-arm, finish in place*/
+        while (mln_gc_collect_step(gc, 0) > 0)
+            ;
     }
 }
 
+int mln_gc_collect_schedule(mln_gc_t *gc, mln_event_t *ev, void *root_data, mln_size_t budget)
+{
+    if (mln_gc_collect_begin(gc, root_data) < 0) return -1;
+    gc->budget = budget? budget: M_GC_DEFAULT_BUDGET;
+    if (mln_event_timer_set(ev, 0, gc, mln_gc_slice_handler) == NULL) {
+        while (mln_gc_collect_step(gc, 0) > 0)
+            ;
+        return -1;
+    }
+    return 0;
+}
+
+void mln_gc_collect(mln_gc_t *gc, void *root_data)
+{
+    /*finish any cycle in flight, then run a full one synchronously*/
+    while (mln_gc_collect_step(gc, 0) > 0)
+        ;
+    if (mln_gc_collect_begin(gc, root_data) < 0) return;
+    while (mln_gc_collect_step(gc, 0) > 0)
+        ;
+}
+
+void mln_gc_collect_minor(mln_gc_t *gc, void *root_data)
+{
+    while (mln_gc_collect_step(gc, 0) > 0)
+        ;
+    if (mln_gc_collect_minor_begin(gc, root_data) < 0) return;
+    while (mln_gc_collect_step(gc, 0) > 0)
+        ;
+}
+
 void mln_gc_remove(mln_gc_t *gc, void *data, mln_gc_t *proc_gc)
 {
     mln_gc_item_t *item = (mln_gc_item_t *)(gc->item_getter(data));
@@ -239,15 +486,37 @@ void mln_gc_remove(mln_gc_t *gc, void *data, mln_gc_t *proc_gc)
     if (proc_gc == NULL) proc_gc = gc;
     if (item->proc_prev != NULL || \
         item->proc_next != NULL || \
-        proc_gc->proc_head == item)
+        proc_gc->proc_head == item || \
+        proc_gc->stage_head == item)
     {
         if (proc_gc->iter != NULL && proc_gc->iter == item) {
             proc_gc->iter = item->proc_next;
             proc_gc->del = 1;
         }
-        mln_gc_item_proc_chain_del(&(proc_gc->proc_head), &(proc_gc->proc_tail), item);
+        if (proc_gc->state == M_GC_STATE_MARK && proc_gc->scan == item)
+            proc_gc->scan = item->proc_next;
+        /*
+         * Mid-chain unlinks only touch the item's own neighbours, so the
+         * head/tail pair matters solely when the item bounds a chain;
+         * route endpoints of the partition stage to the stage chain.
+         */
+        if (proc_gc->stage_head == item || proc_gc->stage_tail == item)
+            mln_gc_item_proc_chain_del(&(proc_gc->stage_head), &(proc_gc->stage_tail), item);
+        else
+            mln_gc_item_proc_chain_del(&(proc_gc->proc_head), &(proc_gc->proc_tail), item);
     }
-    mln_gc_item_chain_del(&(gc->item_head), &(gc->item_tail), item);
+    if (item->remembered) {
+        if (gc->rscan == item) gc->rscan = item->rset_next;
+        mln_gc_item_rset_chain_del(&(gc->rset_head), &(gc->rset_tail), item);
+        item->remembered = 0;
+    }
+    if (gc->marking == item) gc->marking = NULL;
+    if (gc->state == M_GC_STATE_ENQUEUE && gc->scan == item)
+        gc->scan = item->next;
+    if (item->gen)
+        mln_gc_item_chain_del(&(gc->old_head), &(gc->old_tail), item);
+    else
+        mln_gc_item_chain_del(&(gc->item_head), &(gc->item_tail), item);
     mln_gc_item_free(item);
 }
 
@@ -6,9 +6,32 @@
 #include <stdlib.h>
 #include "mln_prime_generator.h"
 #include "mln_hash.h"
+#include "mln_string.h"
 #include <stdio.h>
 #include <string.h>
 
+#define M_HASH_REHASH_STEP 8 /*old buckets visited per operation*/
+#define M_HASH_BATCH 16 /*keys resolved per prefetch round in multi-search*/
+
+/*
+ * All dynamic hash/cmp dispatch funnels through these two: with
+ * 'string_key' set the key's cached hash replaces the handler and the
+ * bucket index is derived from h->len right here, which keeps the
+ * incremental-rehash trick of re-invoking with the old length working.
+ */
+static inline mln_u64_t mln_hash_calc(mln_hash_t *h, void *key)
+{
+    if (h->string_key) return mln_string_hash((mln_string_t *)key) % h->len;
+    return h->hash(h, key);
+}
+
+static inline int mln_hash_cmp_key(mln_hash_t *h, void *k1, void *k2)
+{
+    if (h->string_key)
+        return !mln_string_strseqcmp((mln_string_t *)k1, (mln_string_t *)k2);
+    return h->cmp(h, k1, k2);
+}
+
 MLN_CHAIN_FUNC_DECLARE(mln_hash_entry, \
                        mln_hash_entry_t, \
                        static inline void,);
@@ -22,6 +45,10 @@ static inline void
 mln_hash_expand(mln_hash_t *h) __NONNULL1(1);
 static inline void
 mln_move_hash_entry(mln_hash_t *h, mln_hash_mgr_t *old_tbl, mln_u32_t old_len) __NONNULL2(1,2);
+static inline void
+mln_hash_rehash_step(mln_hash_t *h) __NONNULL1(1);
+static inline mln_hash_entry_t *
+mln_hash_old_lookup(mln_hash_t *h, void *key, mln_hash_mgr_t **mgr_out) __NONNULL2(1,2);
 
 mln_hash_t *
 mln_hash_new(struct mln_hash_attr *attr)
@@ -53,13 +80,17 @@ mln_hash_new(struct mln_hash_attr *attr)
         else free(h);
         return NULL;
     }
+    h->old_tbl = NULL;
+    h->old_len = 0;
+    h->rehash_idx = 0;
     h->nr_nodes = 0;
     h->threshold = attr->calc_prime? mln_prime_generate(h->len << 1): h->len << 1;
     h->expandable = attr->expandable;
     h->calc_prime = attr->calc_prime;
+    h->incremental = attr->incremental;
+    h->string_key = attr->string_key;
     if (h->len == 0 || \
-        h->hash == NULL || \
-        h->cmp == NULL)
+        (!h->string_key && (h->hash == NULL || h->cmp == NULL)))
     {
         if (h->pool != NULL) {
             h->pool_free(h->tbl);
@@ -86,6 +117,19 @@ mln_hash_free(mln_hash_t *h, mln_hash_flag_t flg)
             mln_hash_entry_free(h, fr, flg);
         }
     }
+    if (h->old_tbl != NULL) {
+        mgr_end = h->old_tbl + h->old_len;
+        for (mgr = h->old_tbl; mgr < mgr_end; ++mgr) {
+            he = mgr->head;
+            while (he != NULL) {
+                fr = he;
+                he = he->next;
+                mln_hash_entry_free(h, fr, flg);
+            }
+        }
+        if (h->pool != NULL) h->pool_free(h->old_tbl);
+        else free(h->old_tbl);
+    }
     if (h->pool != NULL) h->pool_free(h->tbl);
     else free(h->tbl);
     if (h->pool != NULL) h->pool_free(h);
@@ -96,12 +140,17 @@ int mln_hash_replace(mln_hash_t *h, void *key, void *val)
 {
     void **k = (void **)key;
     void **v = (void **)val;
-    mln_u32_t index = h->hash(h, *k);
-    mln_hash_mgr_t *mgr = &(h->tbl[index]);
+    mln_u32_t index;
+    mln_hash_mgr_t *mgr;
     mln_hash_entry_t *he;
+
+    mln_hash_rehash_step(h);
+    index = mln_hash_calc(h, *k);
+    mgr = &(h->tbl[index]);
     for (he = mgr->head; he != NULL; he = he->next) {
-        if (h->cmp(h, *k, he->key)) break;
+        if (mln_hash_cmp_key(h, *k, he->key)) break;
     }
+    if (he == NULL) he = mln_hash_old_lookup(h, *k, NULL);
     if (he != NULL) {
         void *save_key = he->key;
         void *save_val = he->val;
@@ -112,12 +161,14 @@ int mln_hash_replace(mln_hash_t *h, void *key, void *val)
         return 0;
     }
 
-    if (h->expandable && h->nr_nodes > h->threshold) {
+    if (h->expandable && h->old_tbl == NULL && h->nr_nodes > h->threshold) {
         mln_hash_expand(h);
     }
-    if (h->expandable && h->nr_nodes <= (h->threshold >> 3)) {
+    if (h->expandable && h->old_tbl == NULL && h->nr_nodes <= (h->threshold >> 3)) {
         mln_hash_reduce(h);
     }
+    index = mln_hash_calc(h, *k);
+    mgr = &(h->tbl[index]);
     he = mln_hash_entry_new(h, *k, *v);
     if (he == NULL) return -1;
     mln_hash_entry_chain_add(&(mgr->head), &(mgr->tail), he);
@@ -128,13 +179,14 @@ int mln_hash_replace(mln_hash_t *h, void *key, void *val)
 
 int mln_hash_insert(mln_hash_t *h, void *key, void *val)
 {
-    if (h->expandable && h->nr_nodes > h->threshold) {
+    mln_hash_rehash_step(h);
+    if (h->expandable && h->old_tbl == NULL && h->nr_nodes > h->threshold) {
         mln_hash_expand(h);
     }
-    if (h->expandable && h->nr_nodes <= (h->threshold >> 3)) {
+    if (h->expandable && h->old_tbl == NULL && h->nr_nodes <= (h->threshold >> 3)) {
         mln_hash_reduce(h);
     }
-    mln_u32_t index = h->hash(h, key);
+    mln_u32_t index = mln_hash_calc(h, key);
     mln_hash_mgr_t *mgr = &(h->tbl[index]);
     mln_hash_entry_t *he = mln_hash_entry_new(h, key, val);
     if (he == NULL) return -1;
@@ -161,6 +213,12 @@ static inline void mln_hash_reduce(mln_hash_t *h)
         return;
     }
     h->threshold = h->calc_prime? mln_prime_generate(h->threshold >> 1): h->threshold >> 1;
+    if (h->incremental) {
+        h->old_tbl = old_tbl;
+        h->old_len = len;
+        h->rehash_idx = 0;
+        return;
+    }
     mln_move_hash_entry(h, old_tbl, len);
     if (h->pool != NULL) h->pool_free(old_tbl);
     else free(old_tbl);
@@ -184,6 +242,12 @@ static inline void mln_hash_expand(mln_hash_t *h)
     }
     h->threshold = h->calc_prime? mln_prime_generate(h->threshold + (h->threshold >> 1)): \
                                   (h->threshold + (h->threshold >> 1));
+    if (h->incremental) {
+        h->old_tbl = old_tbl;
+        h->old_len = len;
+        h->rehash_idx = 0;
+        return;
+    }
     mln_move_hash_entry(h, old_tbl, len);
     if (h->pool != NULL) h->pool_free(old_tbl);
     else free(old_tbl);
@@ -200,21 +264,70 @@ mln_move_hash_entry(mln_hash_t *h, mln_hash_mgr_t *old_tbl, mln_u32_t old_len)
     for (; old_tbl < old_end; ++old_tbl) {
         while ((he = old_tbl->head) != NULL) {
             mln_hash_entry_chain_del(&(old_tbl->head), &(old_tbl->tail), he);
-            index = h->hash(h, he->key);
+            index = mln_hash_calc(h, he->key);
             new_mgr = &(h->tbl[index]);
             mln_hash_entry_chain_add(&(new_mgr->head), &(new_mgr->tail), he);
         }
     }
 }
 
+static inline void mln_hash_rehash_step(mln_hash_t *h)
+{
+    int n = M_HASH_REHASH_STEP;
+    mln_hash_mgr_t *mgr, *new_mgr;
+    mln_hash_entry_t *he;
+    mln_u32_t index;
+
+    if (h->old_tbl == NULL) return;
+    while (n-- > 0 && h->rehash_idx < h->old_len) {
+        mgr = &(h->old_tbl[h->rehash_idx++]);
+        while ((he = mgr->head) != NULL) {
+            mln_hash_entry_chain_del(&(mgr->head), &(mgr->tail), he);
+            index = mln_hash_calc(h, he->key);
+            new_mgr = &(h->tbl[index]);
+            mln_hash_entry_chain_add(&(new_mgr->head), &(new_mgr->tail), he);
+        }
+    }
+    if (h->rehash_idx >= h->old_len) {
+        if (h->pool != NULL) h->pool_free(h->old_tbl);
+        else free(h->old_tbl);
+        h->old_tbl = NULL;
+        h->old_len = 0;
+        h->rehash_idx = 0;
+    }
+}
+
+static inline mln_hash_entry_t *
+mln_hash_old_lookup(mln_hash_t *h, void *key, mln_hash_mgr_t **mgr_out)
+{
+    mln_u64_t save;
+    mln_u32_t index;
+    mln_hash_mgr_t *mgr;
+    mln_hash_entry_t *he;
+
+    if (h->old_tbl == NULL) return NULL;
+    /*recover the old index, the hash handler folds by h->len*/
+    save = h->len;
+    h->len = h->old_len;
+    index = mln_hash_calc(h, key);
+    h->len = save;
+    mgr = &(h->old_tbl[index]);
+    for (he = mgr->head; he != NULL; he = he->next) {
+        if (mln_hash_cmp_key(h, key, he->key)) break;
+    }
+    if (mgr_out != NULL) *mgr_out = mgr;
+    return he;
+}
+
 void *mln_hash_change_value(mln_hash_t *h, void *key, void *new_value)
 {
-    mln_u32_t index = h->hash(h, key);
+    mln_u32_t index = mln_hash_calc(h, key);
     mln_hash_mgr_t *mgr = &(h->tbl[index]);
     mln_hash_entry_t *he;
     for (he = mgr->head; he != NULL; he = he->next) {
-        if (h->cmp(h, key, he->key)) break;
+        if (mln_hash_cmp_key(h, key, he->key)) break;
     }
+    if (he == NULL) he = mln_hash_old_lookup(h, key, NULL);
     if (he == NULL) return NULL;
     mln_u8ptr_t retval = (mln_u8ptr_t)(he->val);
     he->val = new_value;
@@ -223,22 +336,93 @@ void *mln_hash_change_value(mln_hash_t *h, void *key, void *new_value)
 
 void *mln_hash_search(mln_hash_t *h, void *key)
 {
-    mln_u32_t index = h->hash(h, key);
-    mln_hash_mgr_t *mgr = &(h->tbl[index]);
+    mln_u32_t index;
+    mln_hash_mgr_t *mgr;
     mln_hash_entry_t *he;
+
+    mln_hash_rehash_step(h);
+    index = mln_hash_calc(h, key);
+    mgr = &(h->tbl[index]);
     for (he = mgr->head; he != NULL; he = he->next) {
-        if (h->cmp(h, key, he->key)) break;
+        if (mln_hash_cmp_key(h, key, he->key)) break;
     }
+    if (mln_unlikely(he == NULL)) he = mln_hash_old_lookup(h, key, NULL);
     if (he == NULL) return NULL;
     return he->val;
 }
 
+static inline mln_hash_entry_t *
+mln_hash_old_lookup_hashed(mln_hash_t *h, void *key, mln_u64_t hval)
+{
+    mln_hash_mgr_t *mgr;
+    mln_hash_entry_t *he;
+
+    if (h->old_tbl == NULL) return NULL;
+    mgr = &(h->old_tbl[hval % h->old_len]);
+    for (he = mgr->head; he != NULL; he = he->next) {
+        if (mln_hash_cmp_key(h, key, he->key)) break;
+    }
+    return he;
+}
+
+void *mln_hash_search_hashed(mln_hash_t *h, void *key, mln_u64_t hval)
+{
+    mln_hash_mgr_t *mgr;
+    mln_hash_entry_t *he;
+
+    mln_hash_rehash_step(h);
+    mgr = &(h->tbl[hval % h->len]);
+    for (he = mgr->head; he != NULL; he = he->next) {
+        if (mln_hash_cmp_key(h, key, he->key)) break;
+    }
+    if (he == NULL) he = mln_hash_old_lookup_hashed(h, key, hval);
+    if (he == NULL) return NULL;
+    return he->val;
+}
+
+mln_size_t mln_hash_search_multi(mln_hash_t *h, void **keys, mln_u64_t *hvals, mln_size_t n, void **vals)
+{
+    mln_size_t i, base, cnt, found = 0;
+    mln_u64_t idx[M_HASH_BATCH];
+    mln_hash_entry_t *he;
+
+    mln_hash_rehash_step(h);
+    for (base = 0; base < n; base += cnt) {
+        cnt = n - base > M_HASH_BATCH? M_HASH_BATCH: n - base;
+        for (i = 0; i < cnt; ++i) {
+            idx[i] = hvals != NULL? hvals[base+i] % h->len: mln_hash_calc(h, keys[base+i]);
+            __builtin_prefetch(&(h->tbl[idx[i]]), 0, 1);
+        }
+        for (i = 0; i < cnt; ++i) {
+            if ((he = h->tbl[idx[i]].head) != NULL)
+                __builtin_prefetch(he, 0, 1);
+        }
+        for (i = 0; i < cnt; ++i) {
+            for (he = h->tbl[idx[i]].head; he != NULL; he = he->next) {
+                if (mln_hash_cmp_key(h, keys[base+i], he->key)) break;
+            }
+            if (he == NULL && h->old_tbl != NULL) {
+                he = hvals != NULL? mln_hash_old_lookup_hashed(h, keys[base+i], hvals[base+i]): \
+                                    mln_hash_old_lookup(h, keys[base+i], NULL);
+            }
+            vals[base+i] = he == NULL? NULL: he->val;
+            if (he != NULL) ++found;
+        }
+    }
+    return found;
+}
+
 void *mln_hash_search_iterator(mln_hash_t *h, void *key, int **ctx)
 {
+    /*
+     * the continuation context walks one chain, so a key split across the
+     * old and new tables would be missed -- finish any pending migration.
+     */
+    while (h->old_tbl != NULL) mln_hash_rehash_step(h);
     if (*ctx != NULL) {
         mln_hash_entry_t *he = *((mln_hash_entry_t **)ctx);
         for (; he != NULL; he = he->next) {
-            if (h->cmp(h, key, he->key)) break;
+            if (mln_hash_cmp_key(h, key, he->key)) break;
         }
         if (he == NULL) {
             *ctx = NULL;
@@ -247,11 +431,11 @@ void *mln_hash_search_iterator(mln_hash_t *h, void *key, int **ctx)
         *ctx = (int *)(he->next);
         return he->val;
     }
-    mln_u32_t index = h->hash(h, key);
+    mln_u32_t index = mln_hash_calc(h, key);
     mln_hash_mgr_t *mgr = &(h->tbl[index]);
     mln_hash_entry_t *he;
     for (he = mgr->head; he != NULL; he = he->next) {
-        if (h->cmp(h, key, he->key)) break;
+        if (mln_hash_cmp_key(h, key, he->key)) break;
     }
     if (he == NULL) return NULL;
     *ctx = (int *)(he->next);
@@ -260,12 +444,13 @@ void *mln_hash_search_iterator(mln_hash_t *h, void *key, int **ctx)
 
 void mln_hash_remove(mln_hash_t *h, void *key, mln_hash_flag_t flg)
 {
-    mln_u32_t index = h->hash(h, key);
+    mln_u32_t index = mln_hash_calc(h, key);
     mln_hash_mgr_t *mgr = &(h->tbl[index]);
     mln_hash_entry_t *he;
     for (he = mgr->head; he != NULL; he = he->next) {
-        if (h->cmp(h, key, he->key)) break;
+        if (mln_hash_cmp_key(h, key, he->key)) break;
     }
+    if (he == NULL) he = mln_hash_old_lookup(h, key, &mgr);
     if (he == NULL) return;
     mln_hash_entry_chain_del(&(mgr->head), &(mgr->tail), he);
     --(h->nr_nodes);
@@ -325,18 +510,27 @@ int mln_hash_iterate(mln_hash_t *h, hash_iterate_handler handler, void *udata)
                 return -1;
         }
     }
+    if (h->old_tbl != NULL) {
+        end = h->old_tbl + h->old_len;
+        for (mgr = h->old_tbl; mgr < end; ++mgr) {
+            for (he = mgr->head; he != NULL; he = he->next) {
+                if (handler != NULL && handler(he->key, he->val, udata) < 0)
+                    return -1;
+            }
+        }
+    }
     return 0;
 }
 
 int mln_hash_key_exist(mln_hash_t *h, void *key)
 {
-    mln_u32_t index = h->hash(h, key);
+    mln_u32_t index = mln_hash_calc(h, key);
     mln_hash_mgr_t *mgr = &(h->tbl[index]);
     mln_hash_entry_t *he;
     for (he = mgr->head; he != NULL; he = he->next) {
-        if (h->cmp(h, key, he->key)) return 1;
+        if (mln_hash_cmp_key(h, key, he->key)) return 1;
     }
-    return 0;
+    return mln_hash_old_lookup(h, key, NULL) == NULL? 0: 1;
 }
 
 void mln_hash_reset(mln_hash_t *h, mln_hash_flag_t flg)
@@ -351,6 +545,20 @@ void mln_hash_reset(mln_hash_t *h, mln_hash_flag_t flg)
             mln_hash_entry_free(h, he, flg);
         }
     }
+    if (h->old_tbl != NULL) {
+        end = h->old_tbl + h->old_len;
+        for (mgr = h->old_tbl; mgr < end; ++mgr) {
+            while ((he = mgr->head) != NULL) {
+                mln_hash_entry_chain_del(&(mgr->head), &(mgr->tail), he);
+                mln_hash_entry_free(h, he, flg);
+            }
+        }
+        if (h->pool != NULL) h->pool_free(h->old_tbl);
+        else free(h->old_tbl);
+        h->old_tbl = NULL;
+        h->old_len = 0;
+        h->rehash_idx = 0;
+    }
 
     h->nr_nodes = 0;
 }
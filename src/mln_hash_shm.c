@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "mln_hash_shm.h"
+#include "mln_defs.h"
+#include "mln_prime_generator.h"
+
+typedef struct mln_hash_shm_entry_s {
+    struct mln_hash_shm_entry_s *next;
+    mln_u64_t                    hash; /*full hash, rejects most mismatches before memcmp*/
+    mln_size_t                   klen;
+    mln_size_t                   vlen;
+    /*key bytes then value bytes follow the entry*/
+} mln_hash_shm_entry_t;
+
+typedef struct {
+    mln_hash_shm_entry_t        *head;
+    mln_u32_t                    lock;
+} mln_hash_shm_bucket_t;
+
+struct mln_hash_shm_s {
+    mln_alloc_t                 *pool;
+    mln_hash_shm_bucket_t       *tbl;
+    mln_u64_t                    len;
+    mln_u64_t                    nr_nodes;
+};
+
+#define mln_hash_shm_entry_key(e) ((mln_u8ptr_t)((e) + 1))
+#define mln_hash_shm_entry_val(e) ((mln_u8ptr_t)((e) + 1) + (e)->klen)
+
+static inline mln_u64_t mln_hash_shm_calc(mln_u8ptr_t key, mln_size_t len)
+{
+    /*FNV-1a 64*/
+    mln_u64_t h = 0xcbf29ce484222325ULL;
+    mln_u8ptr_t end = key + len;
+    for (; key < end; ++key) {
+        h ^= *key;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+mln_hash_shm_t *mln_hash_shm_new(mln_alloc_t *pool, mln_u64_t len_base)
+{
+    mln_hash_shm_t *h;
+    mln_u64_t i;
+
+    h = (mln_hash_shm_t *)mln_alloc_m(pool, sizeof(mln_hash_shm_t));
+    if (h == NULL) return NULL;
+    h->pool = pool;
+    h->len = mln_prime_generate(len_base);
+    h->nr_nodes = 0;
+    h->tbl = (mln_hash_shm_bucket_t *)mln_alloc_m(pool, h->len * sizeof(mln_hash_shm_bucket_t));
+    if (h->tbl == NULL) {
+        mln_alloc_free(h);
+        return NULL;
+    }
+    for (i = 0; i < h->len; ++i) {
+        h->tbl[i].head = NULL;
+        mln_spin_init(&h->tbl[i].lock);
+    }
+    return h;
+}
+
+void mln_hash_shm_free(mln_hash_shm_t *h)
+{
+    mln_hash_shm_entry_t *e, *fr;
+    mln_u64_t i;
+
+    if (h == NULL) return;
+    for (i = 0; i < h->len; ++i) {
+        for (e = h->tbl[i].head; e != NULL; ) {
+            fr = e;
+            e = e->next;
+            mln_alloc_free(fr);
+        }
+    }
+    mln_alloc_free(h->tbl);
+    mln_alloc_free(h);
+}
+
+static inline mln_hash_shm_entry_t *
+mln_hash_shm_lookup(mln_hash_shm_bucket_t *bkt, mln_u64_t hash, mln_u8ptr_t key, mln_size_t klen)
+{
+    mln_hash_shm_entry_t *e;
+
+    for (e = bkt->head; e != NULL; e = e->next) {
+        if (e->hash == hash && e->klen == klen && !memcmp(mln_hash_shm_entry_key(e), key, klen))
+            return e;
+    }
+    return NULL;
+}
+
+int mln_hash_shm_insert(mln_hash_shm_t *h, void *key, mln_size_t klen, void *val, mln_size_t vlen)
+{
+    mln_u64_t hash = mln_hash_shm_calc((mln_u8ptr_t)key, klen);
+    mln_hash_shm_bucket_t *bkt = &h->tbl[hash % h->len];
+    mln_hash_shm_entry_t *e, *old;
+
+    mln_spin_lock(&bkt->lock);
+    old = mln_hash_shm_lookup(bkt, hash, (mln_u8ptr_t)key, klen);
+    if (old != NULL && old->vlen == vlen) {
+        memcpy(mln_hash_shm_entry_val(old), val, vlen);
+        mln_spin_unlock(&bkt->lock);
+        return 0;
+    }
+    mln_spin_unlock(&bkt->lock);
+
+    /*allocate outside the bucket lock; the pool has its own locking*/
+    e = (mln_hash_shm_entry_t *)mln_alloc_m(h->pool, sizeof(mln_hash_shm_entry_t) + klen + vlen);
+    if (e == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    e->hash = hash;
+    e->klen = klen;
+    e->vlen = vlen;
+    memcpy(mln_hash_shm_entry_key(e), key, klen);
+    memcpy(mln_hash_shm_entry_val(e), val, vlen);
+
+    mln_spin_lock(&bkt->lock);
+    old = mln_hash_shm_lookup(bkt, hash, (mln_u8ptr_t)key, klen);
+    if (old != NULL) {
+        mln_hash_shm_entry_t **pp;
+        for (pp = &bkt->head; *pp != old; pp = &(*pp)->next)
+            ;
+        e->next = old->next;
+        *pp = e;
+        mln_spin_unlock(&bkt->lock);
+        mln_alloc_free(old);
+        return 0;
+    }
+    e->next = bkt->head;
+    bkt->head = e;
+    mln_spin_unlock(&bkt->lock);
+    __sync_fetch_and_add(&h->nr_nodes, 1);
+    return 0;
+}
+
+int mln_hash_shm_search(mln_hash_shm_t *h, void *key, mln_size_t klen, void *val, mln_size_t *vlen)
+{
+    mln_u64_t hash = mln_hash_shm_calc((mln_u8ptr_t)key, klen);
+    mln_hash_shm_bucket_t *bkt = &h->tbl[hash % h->len];
+    mln_hash_shm_entry_t *e;
+
+    mln_spin_lock(&bkt->lock);
+    e = mln_hash_shm_lookup(bkt, hash, (mln_u8ptr_t)key, klen);
+    if (e == NULL) {
+        mln_spin_unlock(&bkt->lock);
+        errno = ENOENT;
+        return -1;
+    }
+    if (e->vlen > *vlen) {
+        mln_spin_unlock(&bkt->lock);
+        errno = ERANGE;
+        return -1;
+    }
+    memcpy(val, mln_hash_shm_entry_val(e), e->vlen);
+    *vlen = e->vlen;
+    mln_spin_unlock(&bkt->lock);
+    return 0;
+}
+
+int mln_hash_shm_remove(mln_hash_shm_t *h, void *key, mln_size_t klen)
+{
+    mln_u64_t hash = mln_hash_shm_calc((mln_u8ptr_t)key, klen);
+    mln_hash_shm_bucket_t *bkt = &h->tbl[hash % h->len];
+    mln_hash_shm_entry_t *e, **pp;
+
+    mln_spin_lock(&bkt->lock);
+    for (pp = &bkt->head; (e = *pp) != NULL; pp = &e->next) {
+        if (e->hash == hash && e->klen == klen && !memcmp(mln_hash_shm_entry_key(e), key, klen)) {
+            *pp = e->next;
+            mln_spin_unlock(&bkt->lock);
+            mln_alloc_free(e);
+            __sync_fetch_and_sub(&h->nr_nodes, 1);
+            return 0;
+        }
+    }
+    mln_spin_unlock(&bkt->lock);
+    errno = ENOENT;
+    return -1;
+}
+
+int mln_hash_shm_iterate(mln_hash_shm_t *h, mln_hash_shm_iterate_handler handler, void *udata)
+{
+    mln_hash_shm_entry_t *e;
+    mln_u64_t i;
+
+    for (i = 0; i < h->len; ++i) {
+        mln_spin_lock(&h->tbl[i].lock);
+        for (e = h->tbl[i].head; e != NULL; e = e->next) {
+            if (handler(mln_hash_shm_entry_key(e), e->klen, \
+                        mln_hash_shm_entry_val(e), e->vlen, udata) < 0)
+            {
+                mln_spin_unlock(&h->tbl[i].lock);
+                return -1;
+            }
+        }
+        mln_spin_unlock(&h->tbl[i].lock);
+    }
+    return 0;
+}
+
+mln_u64_t mln_hash_shm_count(mln_hash_shm_t *h)
+{
+    return h->nr_nodes;
+}
@@ -8,6 +8,7 @@
 #include <ctype.h>
 #include "mln_types.h"
 #include "mln_http.h"
+#include "mln_clock.h"
 
 
 struct mln_http_chain_s {
@@ -20,8 +21,8 @@ struct mln_http_chain_s {
 
 static inline int mln_http_line_length(mln_http_t *http, mln_chain_t *in, mln_size_t *len);
 static inline int mln_http_process_line(mln_http_t *http, mln_chain_t **in, mln_size_t len);
-static inline int mln_http_parse_headline(mln_http_t *http, mln_u8ptr_t buf, mln_size_t len);
-static inline int mln_http_parse_field(mln_http_t *http, mln_u8ptr_t buf, mln_size_t len);
+static inline int mln_http_parse_headline(mln_http_t *http, mln_u8ptr_t buf, mln_size_t len, int zerocopy);
+static inline int mln_http_parse_field(mln_http_t *http, mln_u8ptr_t buf, mln_size_t len, int zerocopy);
 static void mln_http_hash_free(void *data);
 static mln_u64_t mln_http_hash_calc(mln_hash_t *h, void *key);
 static int mln_http_hash_cmp(mln_hash_t *h, void *key1, void *key2);
@@ -30,7 +31,7 @@ static int mln_http_dump_iterate_handler(void *key, void *val, void *data);
 static inline int
 mln_http_generate_version(struct mln_http_chain_s *hc);
 static inline int
-mln_http_generate_status(struct mln_http_chain_s *hc);
+mln_http_generate_status_line(struct mln_http_chain_s *hc);
 static inline int
 mln_http_generate_method(struct mln_http_chain_s *hc);
 static inline int
@@ -40,6 +41,8 @@ mln_http_generate_fields_hash_iterate_handler(void *key, void *val, void *data);
 static inline int
 mln_http_generate_write(struct mln_http_chain_s *hc, void *buf, mln_size_t size);
 static inline int
+mln_http_generate_write_ref(struct mln_http_chain_s *hc, mln_string_t *s);
+static inline int
 mln_http_generate_set_last_in_chain(struct mln_http_chain_s *hc);
 
 mln_string_t http_version[] = {
@@ -47,6 +50,81 @@ mln_string_t http_version[] = {
     mln_string("HTTP/1.1")
 };
 
+/*
+ * Common headers are resolved through a fixed perfect-hash index instead
+ * of the generic header hash: (len*6 + lower(first)*7 + lower(last)) % 59
+ * maps each of these names to a distinct slot of mln_http_common_map.
+ */
+static mln_string_t mln_http_common_headers[M_HTTP_COMMON_HEADER_NR] = {
+    mln_string("Host"),
+    mln_string("Connection"),
+    mln_string("Content-Length"),
+    mln_string("Content-Type"),
+    mln_string("Transfer-Encoding"),
+    mln_string("User-Agent"),
+    mln_string("Accept"),
+    mln_string("Accept-Encoding"),
+    mln_string("Accept-Language"),
+    mln_string("Cookie"),
+    mln_string("Set-Cookie"),
+    mln_string("Cache-Control"),
+    mln_string("Upgrade"),
+    mln_string("Origin"),
+    mln_string("Referer"),
+    mln_string("Authorization"),
+    mln_string("Server"),
+    mln_string("Date"),
+    mln_string("ETag"),
+    mln_string("Last-Modified")
+};
+
+static const mln_u8_t mln_http_common_map[59] = {
+    255, 255, 255, 255,   9,   6, 255, 255,  18, 255,  14,  16, 255, 255,   4,
+    255, 255, 255,  12, 255, 255, 255,  10, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255,   1,  13, 255,   3,  15,   0, 255,   8,
+    255,   7, 255, 255,  19, 255,   5, 255,  11, 255,   2, 255, 255,  17
+};
+
+static inline int mln_http_common_index(mln_string_t *name)
+{
+    mln_u32_t h;
+    mln_u8_t idx;
+
+    if (name->len == 0) return -1;
+    h = (name->len * 6 + \
+         tolower(name->data[0]) * 7 + \
+         tolower(name->data[name->len-1])) % 59;
+    idx = mln_http_common_map[h];
+    if (idx == 255 || !mln_string_eq_ci(name, &mln_http_common_headers[idx]))
+        return -1;
+    return idx;
+}
+
+/*pool-allocated string header borrowing 'buf' (a held receive buffer)*/
+static inline mln_string_t *
+mln_http_ref_string_new(mln_alloc_t *pool, mln_u8ptr_t buf, mln_size_t len)
+{
+    mln_string_t *s = (mln_string_t *)mln_alloc_m(pool, sizeof(mln_string_t));
+    if (s == NULL) return NULL;
+    s->data = buf;
+    s->len = len;
+    s->data_ref = 1;
+    s->pool = 1;
+    s->ref = 1;
+    return s;
+}
+
+static inline mln_string_t *
+mln_http_field_string_new(mln_http_t *http, mln_u8ptr_t buf, mln_size_t len, int zerocopy)
+{
+    mln_string_t tmp;
+
+    if (zerocopy)
+        return mln_http_ref_string_new(mln_http_pool_get(http), buf, len);
+    mln_string_nset(&tmp, buf, len);
+    return mln_string_pool_dup(mln_http_pool_get(http), &tmp);
+}
+
 mln_string_t http_method[] = {
     mln_string("GET"),
     mln_string("POST"),
@@ -117,6 +195,45 @@ mln_http_map_t mln_http_status[] = {
 {mln_string("Unparseable Response Headers"),    mln_string("600"), M_HTTP_UNPARSEABLE_RESPONSE_HEADERS}
 };
 
+#define M_HTTP_STATUS_NR (sizeof(mln_http_status)/sizeof(mln_http_map_t))
+#define M_HTTP_VERSION_NR (sizeof(http_version)/sizeof(mln_string_t))
+
+/*
+ * Fully rendered status lines ("HTTP/1.1 200 OK\r\n"), one per
+ * version/status pair, rendered once on first response generation.
+ * mln_http_generate() links them into the output chain by reference,
+ * so the hot path does no formatting and no copying for the headline.
+ */
+static char mln_http_status_line_buf[M_HTTP_VERSION_NR][M_HTTP_STATUS_NR][64];
+static mln_string_t mln_http_status_line[M_HTTP_VERSION_NR][M_HTTP_STATUS_NR];
+static volatile int mln_http_status_line_built = 0;
+static mln_u32_t mln_http_status_line_lock = 0;
+
+static void mln_http_status_line_build(void)
+{
+    int n;
+    mln_u32_t v, i;
+
+    if (mln_http_status_line_built) return;
+    mln_spin_lock(&mln_http_status_line_lock);
+    if (!mln_http_status_line_built) {
+        for (v = 0; v < M_HTTP_VERSION_NR; ++v) {
+            for (i = 0; i < M_HTTP_STATUS_NR; ++i) {
+                n = snprintf(mln_http_status_line_buf[v][i], \
+                             sizeof(mln_http_status_line_buf[v][i]), \
+                             "%s %s %s\r\n", \
+                             (char *)http_version[v].data, \
+                             (char *)mln_http_status[i].code_str.data, \
+                             (char *)mln_http_status[i].msg_str.data);
+                mln_string_nset(&mln_http_status_line[v][i], \
+                                mln_http_status_line_buf[v][i], n);
+            }
+        }
+        mln_http_status_line_built = 1;
+    }
+    mln_spin_unlock(&mln_http_status_line_lock);
+}
+
 
 int mln_http_parse(mln_http_t *http, mln_chain_t **in)
 {
@@ -141,6 +258,237 @@ int mln_http_parse(mln_http_t *http, mln_chain_t **in)
     return ret;
 }
 
+int mln_http_pipeline(mln_http_t *http, \
+                      mln_chain_t **in, \
+                      mln_http_handler request_handler, \
+                      mln_chain_t **out_head, \
+                      mln_chain_t **out_tail)
+{
+    int ret;
+    mln_chain_t *rhead, *rtail;
+
+    if (http == NULL || request_handler == NULL || \
+        in == NULL || out_head == NULL || out_tail == NULL)
+    {
+        return M_HTTP_RET_ERROR;
+    }
+
+    while (*in != NULL) {
+        ret = mln_http_parse(http, in);
+        if (ret == M_HTTP_RET_ERROR) return ret;
+        if (ret == M_HTTP_RET_OK) break;
+
+        rhead = rtail = NULL;
+        if (request_handler(http, &rhead, &rtail) == M_HTTP_RET_ERROR) {
+            if (rhead != NULL) mln_chain_pool_release_all(rhead);
+            return M_HTTP_RET_ERROR;
+        }
+        if (rhead != NULL) {
+            if (*out_head == NULL) {
+                *out_head = rhead;
+                *out_tail = rtail;
+            } else {
+                (*out_tail)->next = rhead;
+                *out_tail = rtail;
+            }
+        }
+        mln_http_reset(http);
+    }
+
+    return M_HTTP_RET_OK;
+}
+
+/*
+ * Consume 'len' line bytes plus the trailing '\n' from 'in', copying at
+ * most 'size' of them into 'buf'. Exhausted receive buffers are held or
+ * released according to the zero-copy mode. Return the copied length
+ * with the trailing '\r' stripped.
+ */
+static inline mln_size_t
+mln_http_chunk_line(mln_http_t *http, mln_chain_t **in, mln_size_t len, mln_u8ptr_t buf, mln_size_t size)
+{
+    mln_chain_t *c;
+    mln_buf_t *b;
+    mln_size_t i = 0, n = 0, total = len + 1;
+
+    while (i < total && (c = *in) != NULL) {
+        b = c->buf;
+        if (b == NULL || b->in_file || mln_buf_left_size(b) <= 0) {
+            *in = c->next;
+            if (http->zerocopy) {
+                c->next = NULL;
+                mln_chain_add(&(http->held_head), &(http->held_tail), c);
+            } else {
+                mln_chain_pool_release(c);
+            }
+            continue;
+        }
+        while (i < total && mln_buf_left_size(b) > 0) {
+            if (i < len && n < size) buf[n++] = *(b->left_pos);
+            ++(b->left_pos);
+            ++i;
+        }
+    }
+    if (n > 0 && buf[n-1] == (mln_u8_t)'\r') --n;
+
+    return n;
+}
+
+int mln_http_chunk_parse(mln_http_t *http, mln_chain_t **in, mln_http_chunk_handler chunk_handler)
+{
+    int ret;
+    mln_chain_t *c;
+    mln_buf_t *b, *seg;
+    mln_u8_t line[1024];
+    mln_u8ptr_t p, end;
+    mln_size_t len, n, chunk_size;
+    mln_alloc_t *pool;
+
+    if (http == NULL || in == NULL || chunk_handler == NULL)
+        return M_HTTP_RET_ERROR;
+    pool = mln_http_pool_get(http);
+
+    while (1) {
+        switch (http->chunk_state) {
+            case M_HTTP_CHUNK_SIZE:
+                if ((ret = mln_http_line_length(http, *in, &len)) != M_HTTP_RET_DONE)
+                    return ret;
+                n = mln_http_chunk_line(http, in, len, line, sizeof(line));
+                for (chunk_size = 0, p = line, end = line + n; p < end; ++p) {
+                    if (isdigit(*p)) {
+                        chunk_size = (chunk_size << 4) | (*p - '0');
+                    } else if (*p >= 'a' && *p <= 'f') {
+                        chunk_size = (chunk_size << 4) | (*p - 'a' + 10);
+                    } else if (*p >= 'A' && *p <= 'F') {
+                        chunk_size = (chunk_size << 4) | (*p - 'A' + 10);
+                    } else {
+                        break;/*chunk extension, ignored*/
+                    }
+                }
+                if (p == line || p - line > 16) {
+                    mln_http_error_set(http, M_HTTP_BAD_REQUEST);
+                    return M_HTTP_RET_ERROR;
+                }
+                if (chunk_size == 0) {
+                    http->chunk_state = M_HTTP_CHUNK_TRAILER;
+                } else {
+                    http->chunk_left = chunk_size;
+                    http->chunk_state = M_HTTP_CHUNK_DATA;
+                }
+                break;
+            case M_HTTP_CHUNK_DATA:
+                while (http->chunk_left > 0) {
+                    while ((c = *in) != NULL) {
+                        b = c->buf;
+                        if (b != NULL && !b->in_file && mln_buf_left_size(b) > 0)
+                            break;
+                        *in = c->next;
+                        if (http->zerocopy) {
+                            c->next = NULL;
+                            mln_chain_add(&(http->held_head), &(http->held_tail), c);
+                        } else {
+                            mln_chain_pool_release(c);
+                        }
+                    }
+                    if (c == NULL) return M_HTTP_RET_OK;
+                    n = mln_buf_left_size(b);
+                    if (n > http->chunk_left) n = http->chunk_left;
+                    seg = mln_buf_new(pool);
+                    if (seg == NULL) {
+                        mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
+                        return M_HTTP_RET_ERROR;
+                    }
+                    seg->left_pos = seg->pos = seg->start = b->left_pos;
+                    seg->last = seg->end = b->left_pos + n;
+                    seg->in_memory = 1;
+                    b->left_pos += n;
+                    http->chunk_left -= n;
+                    if (chunk_handler(http, seg) == M_HTTP_RET_ERROR)
+                        return M_HTTP_RET_ERROR;
+                }
+                http->chunk_state = M_HTTP_CHUNK_CRLF;
+                break;
+            case M_HTTP_CHUNK_CRLF:
+                if ((ret = mln_http_line_length(http, *in, &len)) != M_HTTP_RET_DONE)
+                    return ret;
+                n = mln_http_chunk_line(http, in, len, line, sizeof(line));
+                if (n != 0) {
+                    mln_http_error_set(http, M_HTTP_BAD_REQUEST);
+                    return M_HTTP_RET_ERROR;
+                }
+                http->chunk_state = M_HTTP_CHUNK_SIZE;
+                break;
+            default: /*M_HTTP_CHUNK_TRAILER*/
+                if ((ret = mln_http_line_length(http, *in, &len)) != M_HTTP_RET_DONE)
+                    return ret;
+                n = mln_http_chunk_line(http, in, len, line, sizeof(line));
+                if (n == 0) {
+                    http->chunk_state = M_HTTP_CHUNK_SIZE;
+                    if (chunk_handler(http, NULL) == M_HTTP_RET_ERROR)
+                        return M_HTTP_RET_ERROR;
+                    return M_HTTP_RET_DONE;
+                }
+                if (mln_http_parse_field(http, line, n, 0) == M_HTTP_RET_ERROR)
+                    return M_HTTP_RET_ERROR;
+                break;
+        }
+    }
+}
+
+static inline int
+mln_http_chunk_append(mln_http_t *http, mln_chain_t **head, mln_chain_t **tail, void *data, mln_size_t size)
+{
+    mln_alloc_t *pool = mln_http_pool_get(http);
+    mln_chain_t *c;
+    mln_buf_t *b;
+    mln_u8ptr_t buf;
+
+    if ((c = mln_chain_new(pool)) == NULL) return M_HTTP_RET_ERROR;
+    if ((b = mln_buf_new(pool)) == NULL) return M_HTTP_RET_ERROR;
+    if ((buf = (mln_u8ptr_t)mln_alloc_m(pool, size)) == NULL) return M_HTTP_RET_ERROR;
+    memcpy(buf, data, size);
+    b->left_pos = b->pos = b->start = buf;
+    b->last = b->end = buf + size;
+    b->in_memory = 1;
+    c->buf = b;
+    mln_chain_add(head, tail, c);
+
+    return M_HTTP_RET_OK;
+}
+
+int mln_http_chunk_generate(mln_http_t *http, mln_chain_t **out_head, mln_chain_t **out_tail, mln_buf_t *b)
+{
+    mln_chain_t *c;
+    char size_line[32];
+    int n;
+
+    if (http == NULL || out_head == NULL || out_tail == NULL)
+        return M_HTTP_RET_ERROR;
+
+    if (b == NULL || mln_buf_size(b) == 0) {
+        if (mln_http_chunk_append(http, out_head, out_tail, "0\r\n\r\n", 5) == M_HTTP_RET_ERROR)
+            goto err;
+        (*out_tail)->buf->last_in_chain = 1;
+        return M_HTTP_RET_DONE;
+    }
+
+    n = snprintf(size_line, sizeof(size_line), "%lx\r\n", (unsigned long)mln_buf_size(b));
+    if (mln_http_chunk_append(http, out_head, out_tail, size_line, n) == M_HTTP_RET_ERROR)
+        goto err;
+    if ((c = mln_chain_new(mln_http_pool_get(http))) == NULL)
+        goto err;
+    c->buf = b;
+    mln_chain_add(out_head, out_tail, c);
+    if (mln_http_chunk_append(http, out_head, out_tail, "\r\n", 2) == M_HTTP_RET_ERROR)
+        goto err;
+
+    return M_HTTP_RET_OK;
+
+err:
+    mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
+    return M_HTTP_RET_ERROR;
+}
+
 static inline int mln_http_line_length(mln_http_t *http, mln_chain_t *in, mln_size_t *len)
 {
     mln_buf_t *b;
@@ -178,6 +526,41 @@ static inline int mln_http_process_line(mln_http_t *http, mln_chain_t **in, mln_
     mln_alloc_t *pool = mln_http_pool_get(http);
     mln_u32_t type = mln_http_type_get(http);
 
+    if (http->zerocopy) {
+        while ((c = *in) != NULL) {
+            b = c->buf;
+            if (b != NULL && !b->in_file && mln_buf_left_size(b) > 0)
+                break;
+            /*may back slices of earlier lines, keep it alive*/
+            *in = c->next;
+            c->next = NULL;
+            mln_chain_add(&(http->held_head), &(http->held_tail), c);
+        }
+        if (c == NULL) return M_HTTP_RET_OK;
+        b = c->buf;
+        if ((mln_size_t)(b->last - b->left_pos) > len) {
+            /*whole line plus its '\n' lies in this buffer: slice in place*/
+            buf = b->left_pos;
+            b->left_pos += len + 1;
+            if (len > 0 && buf[len-1] == (mln_u8_t)'\r') --len;
+            if (len == 0) {
+                mln_http_done_set(http, 1);
+                ret = M_HTTP_RET_OK;
+            } else if (type == M_HTTP_UNKNOWN) {
+                ret = mln_http_parse_headline(http, buf, len, 1);
+            } else {
+                ret = mln_http_parse_field(http, buf, len, 1);
+            }
+            if (mln_buf_left_size(b) <= 0) {
+                *in = c->next;
+                c->next = NULL;
+                mln_chain_add(&(http->held_head), &(http->held_tail), c);
+            }
+            return ret;
+        }
+        /*line crosses a buffer boundary: take the copying path below*/
+    }
+
     buf = (mln_u8ptr_t)mln_alloc_m(pool, len+1);
     if (buf == NULL) {
         mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
@@ -190,7 +573,12 @@ static inline int mln_http_process_line(mln_http_t *http, mln_chain_t **in, mln_
         b = c->buf;
         if (b == NULL || b->in_file || mln_buf_left_size(b) <= 0) {
             *in = (*in)->next;
-            mln_chain_pool_release(c);
+            if (http->zerocopy) {
+                c->next = NULL;
+                mln_chain_add(&(http->held_head), &(http->held_tail), c);
+            } else {
+                mln_chain_pool_release(c);
+            }
             continue;
         }
         while (mln_buf_left_size(b) > 0) {
@@ -218,9 +606,9 @@ static inline int mln_http_process_line(mln_http_t *http, mln_chain_t **in, mln_
     }
 
     if (type == M_HTTP_UNKNOWN) {
-        ret = mln_http_parse_headline(http, buf, len);
+        ret = mln_http_parse_headline(http, buf, len, 0);
     } else {
-        ret = mln_http_parse_field(http, buf, len);
+        ret = mln_http_parse_field(http, buf, len, 0);
     }
 
     mln_alloc_free(buf);
@@ -228,12 +616,11 @@ static inline int mln_http_process_line(mln_http_t *http, mln_chain_t **in, mln_
     return ret;
 }
 
-static inline int mln_http_parse_headline(mln_http_t *http, mln_u8ptr_t buf, mln_size_t len)
+static inline int mln_http_parse_headline(mln_http_t *http, mln_u8ptr_t buf, mln_size_t len, int zerocopy)
 {
     mln_u8ptr_t p, end = buf + len, ques;
     mln_string_t tmp, *s, *scan, *send;
     mln_u32_t type, status = 0;
-    mln_alloc_t *pool = mln_http_pool_get(http);
 
     /*first part*/
     for (; buf < end; ++buf) {
@@ -293,8 +680,7 @@ static inline int mln_http_parse_headline(mln_http_t *http, mln_u8ptr_t buf, mln
                 break;
         }
         if (ques == NULL || ques+1 >= p) {
-            mln_string_nset(&tmp, buf, (ques == NULL)? p-buf: ques-buf);
-            s = mln_string_pool_dup(pool, &tmp);
+            s = mln_http_field_string_new(http, buf, (ques == NULL)? p-buf: ques-buf, zerocopy);
             if (s == NULL) {
                 mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
                 return M_HTTP_RET_ERROR;
@@ -302,15 +688,14 @@ static inline int mln_http_parse_headline(mln_http_t *http, mln_u8ptr_t buf, mln
             mln_http_uri_set(http, s);
             mln_http_args_set(http, NULL);
         } else {
-            mln_string_nset(&tmp, buf, ques-buf);
-            s = mln_string_pool_dup(pool, &tmp);
+            s = mln_http_field_string_new(http, buf, ques-buf, zerocopy);
             if (s == NULL) {
                 mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
                 return M_HTTP_RET_ERROR;
             }
             mln_http_uri_set(http, s);
-            mln_string_nset(&tmp, ++ques, p - ques);
-            s = mln_string_pool_dup(pool, &tmp);
+            ++ques;
+            s = mln_http_field_string_new(http, ques, p - ques, zerocopy);
             if (s == NULL) {
                 mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
                 return M_HTTP_RET_ERROR;
@@ -359,8 +744,7 @@ static inline int mln_http_parse_headline(mln_http_t *http, mln_u8ptr_t buf, mln
         mln_http_version_set(http, scan - http_version);
         return M_HTTP_RET_OK;
     }
-    mln_string_nset(&tmp, buf, end-buf);
-    s = mln_string_pool_dup(pool, &tmp);
+    s = mln_http_field_string_new(http, buf, end-buf, zerocopy);
     if (s == NULL) {
         mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
         return M_HTTP_RET_ERROR;
@@ -369,11 +753,11 @@ static inline int mln_http_parse_headline(mln_http_t *http, mln_u8ptr_t buf, mln
     return M_HTTP_RET_OK;
 }
 
-static inline int mln_http_parse_field(mln_http_t *http, mln_u8ptr_t buf, mln_size_t len)
+static inline int mln_http_parse_field(mln_http_t *http, mln_u8ptr_t buf, mln_size_t len, int zerocopy)
 {
-    mln_u8ptr_t p, end = buf + len;
+    int idx;
+    mln_u8ptr_t p, end = buf + len, name;
     mln_string_t tmp, *s, *v;
-    mln_alloc_t *pool = mln_http_pool_get(http);
     mln_u32_t type = mln_http_type_get(http);
     mln_hash_t *header_fields = mln_http_header_get(http);
 
@@ -398,12 +782,8 @@ static inline int mln_http_parse_field(mln_http_t *http, mln_u8ptr_t buf, mln_si
         }
         return M_HTTP_RET_ERROR;
     }
-    mln_string_nset(&tmp, buf, p-buf);
-    s = mln_string_pool_dup(pool, &tmp);
-    if (s == NULL) {
-        mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
-        return M_HTTP_RET_ERROR;
-    }
+    name = buf;
+    mln_string_nset(&tmp, name, p-name);
     buf = p;
 
     /* : */
@@ -411,16 +791,8 @@ static inline int mln_http_parse_field(mln_http_t *http, mln_u8ptr_t buf, mln_si
         if (*buf != (mln_u8_t)' ' && *buf != (mln_u8_t)'\t')
             break;
     }
-    if (buf >= end) {
-        if (mln_hash_insert(header_fields, s, NULL) < 0) {
-            mln_string_free(s);
-            mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
-            return M_HTTP_RET_ERROR;
-        }
-        return M_HTTP_RET_OK;
-    }
+    if (buf >= end) goto valueless;
     if (buf[0] != (mln_u8_t)':') {
-        mln_string_free(s);
         if (type == M_HTTP_REQUEST) {
             mln_http_error_set(http, M_HTTP_BAD_REQUEST);
         } else {
@@ -435,16 +807,26 @@ static inline int mln_http_parse_field(mln_http_t *http, mln_u8ptr_t buf, mln_si
         if (*buf != (mln_u8_t)' ' && *buf != (mln_u8_t)'\t')
             break;
     }
-    if (buf >= end) {
-        if (mln_hash_insert(header_fields, s, NULL) < 0) {
-            mln_string_free(s);
+    if (buf >= end) goto valueless;
+
+    /*common headers land in the perfect-hash index, not the generic hash*/
+    idx = mln_http_common_index(&tmp);
+    if (idx >= 0 && http->common_vals[idx] == NULL) {
+        v = mln_http_field_string_new(http, buf, end-buf, zerocopy);
+        if (v == NULL) {
             mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
             return M_HTTP_RET_ERROR;
         }
+        http->common_vals[idx] = v;
         return M_HTTP_RET_OK;
     }
-    mln_string_nset(&tmp, buf, end-buf);
-    v = mln_string_pool_dup(pool, &tmp);
+
+    s = mln_http_field_string_new(http, name, tmp.len, zerocopy);
+    if (s == NULL) {
+        mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
+        return M_HTTP_RET_ERROR;
+    }
+    v = mln_http_field_string_new(http, buf, end-buf, zerocopy);
     if (v == NULL) {
         mln_string_free(s);
         mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
@@ -458,6 +840,19 @@ static inline int mln_http_parse_field(mln_http_t *http, mln_u8ptr_t buf, mln_si
     }
 
     return M_HTTP_RET_OK;
+
+valueless:
+    s = mln_http_field_string_new(http, name, tmp.len, zerocopy);
+    if (s == NULL) {
+        mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
+        return M_HTTP_RET_ERROR;
+    }
+    if (mln_hash_insert(header_fields, s, NULL) < 0) {
+        mln_string_free(s);
+        mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
+        return M_HTTP_RET_ERROR;
+    }
+    return M_HTTP_RET_OK;
 }
 
 int mln_http_generate(mln_http_t *http, mln_chain_t **out_head, mln_chain_t **out_tail)
@@ -469,6 +864,7 @@ int mln_http_generate(mln_http_t *http, mln_chain_t **out_head, mln_chain_t **ou
     mln_hash_t *header_fields = mln_http_header_get(http);
     mln_http_handler handler = mln_http_handler_get(http);
     struct mln_http_chain_s hc;
+    mln_u32_t i;
     int ret;
 
     if (type == M_HTTP_UNKNOWN) {
@@ -501,11 +897,7 @@ int mln_http_generate(mln_http_t *http, mln_chain_t **out_head, mln_chain_t **ou
     }
 
     if (type == M_HTTP_RESPONSE) {
-        if (mln_http_generate_version(&hc) == M_HTTP_RET_ERROR)
-            goto err;
-        if (mln_http_generate_write(&hc, " ", 1) == M_HTTP_RET_ERROR)
-            goto err;
-        if (mln_http_generate_status(&hc) == M_HTTP_RET_ERROR)
+        if (mln_http_generate_status_line(&hc) == M_HTTP_RET_ERROR)
             goto err;
     } else {
         if (mln_http_generate_method(&hc) == M_HTTP_RET_ERROR)
@@ -518,9 +910,9 @@ int mln_http_generate(mln_http_t *http, mln_chain_t **out_head, mln_chain_t **ou
             goto err;
         if (mln_http_generate_version(&hc) == M_HTTP_RET_ERROR)
             goto err;
+        if (mln_http_generate_write(&hc, "\r\n", 2) == M_HTTP_RET_ERROR)
+            goto err;
     }
-    if (mln_http_generate_write(&hc, "\r\n", 2) == M_HTTP_RET_ERROR)
-        goto err;
 
     if (header_fields != NULL) {
         if (mln_hash_iterate(header_fields, \
@@ -528,6 +920,13 @@ int mln_http_generate(mln_http_t *http, mln_chain_t **out_head, mln_chain_t **ou
                               &hc) < 0)
             goto err;
     }
+    for (i = 0; i < M_HTTP_COMMON_HEADER_NR; ++i) {
+        if (http->common_vals[i] == NULL) continue;
+        if (mln_http_generate_fields_hash_iterate_handler(&mln_http_common_headers[i], \
+                                                          http->common_vals[i], \
+                                                          &hc) < 0)
+            goto err;
+    }
 
     if (mln_http_generate_write(&hc, "\r\n", 2) == M_HTTP_RET_ERROR)
         goto err;
@@ -537,12 +936,14 @@ int mln_http_generate(mln_http_t *http, mln_chain_t **out_head, mln_chain_t **ou
         if (mln_http_generate_set_last_in_chain(&hc) == M_HTTP_RET_ERROR)
             goto err;
     }
-    if (hc.head == NULL) {
-        hc.head = http->body_head;
-        hc.tail = http->body_tail;
-    } else {
-        hc.tail->next = http->body_head;
-        hc.tail = http->body_tail;
+    if (http->body_head != NULL) {
+        if (hc.head == NULL) {
+            hc.head = http->body_head;
+            hc.tail = http->body_tail;
+        } else {
+            hc.tail->next = http->body_head;
+            hc.tail = http->body_tail;
+        }
     }
     http->body_head = http->body_tail = NULL;
 
@@ -660,6 +1061,46 @@ mln_http_generate_write(struct mln_http_chain_s *hc, void *buf, mln_size_t size)
     return M_HTTP_RET_OK;
 }
 
+/*
+ * Link shared, immutable bytes into the output chain without copying.
+ * The buffer only references 's'; the next plain write opens a fresh
+ * pool buffer rather than appending to the shared one.
+ */
+static inline int
+mln_http_generate_write_ref(struct mln_http_chain_s *hc, mln_string_t *s)
+{
+    mln_http_t *http = hc->http;
+    mln_alloc_t *pool = mln_http_pool_get(http);
+
+    mln_chain_t *c = mln_chain_new(pool);
+    if (c == NULL) {
+        mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
+        return M_HTTP_RET_ERROR;
+    }
+    mln_buf_t *b = mln_buf_new(pool);
+    if (b == NULL) {
+        mln_chain_pool_release(c);
+        mln_http_error_set(http, M_HTTP_INTERNAL_SERVER_ERROR);
+        return M_HTTP_RET_ERROR;
+    }
+    c->buf = b;
+    b->left_pos = b->pos = b->start = s->data;
+    b->last = b->end = s->data + s->len;
+    b->in_memory = 1;
+    b->last_buf = 1;
+
+    if (hc->head == NULL) {
+        hc->head = hc->tail = c;
+    } else {
+        hc->tail->next = c;
+        hc->tail = c;
+    }
+    hc->pos = NULL;
+    hc->left_size = 0;
+
+    return M_HTTP_RET_OK;
+}
+
 static inline int
 mln_http_generate_version(struct mln_http_chain_s *hc)
 {
@@ -681,28 +1122,26 @@ mln_http_generate_version(struct mln_http_chain_s *hc)
 }
 
 static inline int
-mln_http_generate_status(struct mln_http_chain_s *hc)
+mln_http_generate_status_line(struct mln_http_chain_s *hc)
 {
+    mln_u32_t version = mln_http_version_get(hc->http);
     mln_u32_t status = mln_http_status_get(hc->http);
-    mln_http_map_t *map = mln_http_status;
-    mln_http_map_t *end = mln_http_status + sizeof(mln_http_status)/sizeof(mln_http_map_t);
+    mln_u32_t i;
 
-    for (; map < end; ++map) {
-        if (status == map->code) break;
-    }
-    if (map >= end) {
+    if (version >= M_HTTP_VERSION_NR) {
         mln_http_error_set(hc->http, M_HTTP_UNPARSEABLE_RESPONSE_HEADERS);
         return M_HTTP_RET_ERROR;
     }
-
-    if (mln_http_generate_write(hc, map->code_str.data, map->code_str.len) == M_HTTP_RET_ERROR)
-        return M_HTTP_RET_ERROR;
-    if (mln_http_generate_write(hc, " ", 1) == M_HTTP_RET_ERROR)
-        return M_HTTP_RET_ERROR;
-    if (mln_http_generate_write(hc, map->msg_str.data, map->msg_str.len) == M_HTTP_RET_ERROR)
+    for (i = 0; i < M_HTTP_STATUS_NR; ++i) {
+        if (status == mln_http_status[i].code) break;
+    }
+    if (i >= M_HTTP_STATUS_NR) {
+        mln_http_error_set(hc->http, M_HTTP_UNPARSEABLE_RESPONSE_HEADERS);
         return M_HTTP_RET_ERROR;
+    }
 
-    return M_HTTP_RET_OK;
+    mln_http_status_line_build();
+    return mln_http_generate_write_ref(hc, &mln_http_status_line[version][i]);
 }
 
 static inline int
@@ -768,6 +1207,8 @@ mln_http_generate_fields_hash_iterate_handler(void *key, void *val, void *data)
 
 int mln_http_field_set(mln_http_t *http, mln_string_t *key, mln_string_t *val)
 {
+    int idx;
+
     if (http == NULL || key == NULL) {
         return M_HTTP_RET_ERROR;
     }
@@ -777,11 +1218,22 @@ int mln_http_field_set(mln_http_t *http, mln_string_t *key, mln_string_t *val)
 
     mln_alloc_t *pool = mln_http_pool_get(http);
     mln_string_t *dup_key, *dup_val;
-    dup_key = mln_string_pool_dup(pool, key);
-    if (dup_key == NULL) return M_HTTP_RET_ERROR;
     dup_val = mln_string_pool_dup(pool, val);
-    if (dup_val == NULL) {
-        mln_string_free(dup_key);
+    if (dup_val == NULL) return M_HTTP_RET_ERROR;
+
+    if ((idx = mln_http_common_index(key)) >= 0) {
+        if (http->common_vals[idx] != NULL)
+            mln_string_free(http->common_vals[idx]);
+        http->common_vals[idx] = dup_val;
+        /*drop generic duplicates so lookups stay consistent*/
+        while (mln_hash_search(header_fields, key) != NULL)
+            mln_hash_remove(header_fields, key, M_HASH_F_KV);
+        return M_HTTP_RET_OK;
+    }
+
+    dup_key = mln_string_pool_dup(pool, key);
+    if (dup_key == NULL) {
+        mln_string_free(dup_val);
         return M_HTTP_RET_ERROR;
     }
     int ret = mln_hash_replace(header_fields, &dup_key, &dup_val);
@@ -792,10 +1244,21 @@ int mln_http_field_set(mln_http_t *http, mln_string_t *key, mln_string_t *val)
     return M_HTTP_RET_OK;
 }
 
+int mln_http_date_set(mln_http_t *http)
+{
+    mln_string_t key = mln_string("Date");
+    return mln_http_field_set(http, &key, mln_clock_http_date());
+}
+
 mln_string_t *mln_http_field_get(mln_http_t *http, mln_string_t *key)
 {
+    int idx;
+
     if (http == NULL) return NULL;
 
+    if ((idx = mln_http_common_index(key)) >= 0 && http->common_vals[idx] != NULL)
+        return http->common_vals[idx];
+
     mln_hash_t *header_fields = mln_http_header_get(http);
     if (header_fields == NULL) return NULL;
 
@@ -804,13 +1267,18 @@ mln_string_t *mln_http_field_get(mln_http_t *http, mln_string_t *key)
 
 mln_string_t *mln_http_field_iterator(mln_http_t *http, mln_string_t *key)
 {
-    int *ctx = NULL;
-    mln_string_t *val;
+    int *ctx = NULL, idx;
+    mln_string_t *val, *common = NULL;
     mln_u8ptr_t buf;
     mln_u32_t size = 0, cnt = 0;
     mln_alloc_t *pool = mln_http_pool_get(http);
     mln_hash_t *header = mln_http_header_get(http);
 
+    if ((idx = mln_http_common_index(key)) >= 0 && http->common_vals[idx] != NULL) {
+        common = http->common_vals[idx];
+        size += (common->len + 1);
+        ++cnt;
+    }
     do {
         val = mln_hash_search_iterator(header, key, &ctx);
         if (val != NULL) {
@@ -823,6 +1291,11 @@ mln_string_t *mln_http_field_iterator(mln_http_t *http, mln_string_t *key)
     buf = (mln_u8ptr_t)mln_alloc_m(pool, size+1);
     if (buf == NULL) return NULL;
     size = 0;
+    if (common != NULL) {
+        memcpy(buf+size, common->data, common->len);
+        size += common->len;
+        if (cnt-- > 1) buf[size++] = ',';
+    }
     do {
         val = mln_hash_search_iterator(header, key, &ctx);
         if (val != NULL) {
@@ -842,8 +1315,15 @@ mln_string_t *mln_http_field_iterator(mln_http_t *http, mln_string_t *key)
 
 void mln_http_field_remove(mln_http_t *http, mln_string_t *key)
 {
+    int idx;
+
     if (http == NULL || key == NULL) return;
 
+    if ((idx = mln_http_common_index(key)) >= 0 && http->common_vals[idx] != NULL) {
+        mln_string_free(http->common_vals[idx]);
+        http->common_vals[idx] = NULL;
+    }
+
     mln_string_t *val;
     mln_hash_t *header = mln_http_header_get(http);
     while ((val = (mln_string_t *)mln_hash_search(header, key)) != NULL) {
@@ -897,6 +1377,8 @@ mln_http_t *mln_http_init(mln_tcp_conn_t *connection, void *data, mln_http_handl
         mln_alloc_free(http);
         return NULL;
     }
+    memset(http->common_vals, 0, sizeof(http->common_vals));
+    http->held_head = http->held_tail = NULL;
     http->body_head = http->body_tail = NULL;
     http->body_handler = body_handler;
     http->data = data;
@@ -907,19 +1389,31 @@ mln_http_t *mln_http_init(mln_tcp_conn_t *connection, void *data, mln_http_handl
     http->status = M_HTTP_OK;
     http->method = 0;
     http->version = 0;
+    http->chunk_left = 0;
     http->type = M_HTTP_UNKNOWN;
     http->done = 0;
+    http->zerocopy = 0;
+    http->chunk_state = M_HTTP_CHUNK_SIZE;
 
     return http;
 }
 
 void mln_http_destroy(mln_http_t *http)
 {
+    mln_u32_t i;
+
     if (http == NULL) return;
 
     if (http->header_fields != NULL) {
         mln_hash_free(http->header_fields, M_HASH_F_KV);
     }
+    for (i = 0; i < M_HTTP_COMMON_HEADER_NR; ++i) {
+        if (http->common_vals[i] != NULL)
+            mln_string_free(http->common_vals[i]);
+    }
+    if (http->held_head != NULL) {
+        mln_chain_pool_release_all(http->held_head);
+    }
     if (http->body_head != NULL) {
         mln_chain_pool_release_all(http->body_head);
     }
@@ -938,11 +1432,23 @@ void mln_http_destroy(mln_http_t *http)
 
 void mln_http_reset(mln_http_t *http)
 {
+    mln_u32_t i;
+
     if (http == NULL) return;
 
     if (http->header_fields != NULL) {
         mln_hash_reset(http->header_fields, M_HASH_F_KV);
     }
+    for (i = 0; i < M_HTTP_COMMON_HEADER_NR; ++i) {
+        if (http->common_vals[i] != NULL) {
+            mln_string_free(http->common_vals[i]);
+            http->common_vals[i] = NULL;
+        }
+    }
+    if (http->held_head != NULL) {
+        mln_chain_pool_release_all(http->held_head);
+        http->held_head = http->held_tail = NULL;
+    }
     if (http->body_head != NULL) {
         mln_chain_pool_release_all(http->body_head);
         http->body_head = http->body_tail = NULL;
@@ -959,12 +1465,14 @@ void mln_http_reset(mln_http_t *http)
         mln_string_free(http->response_msg);
         http->response_msg = NULL;
     }
+    http->chunk_left = 0;
     http->error = M_HTTP_OK;
     http->status = M_HTTP_OK;
     http->method = 0;
     http->version = 0;
     http->type = M_HTTP_UNKNOWN;
     http->done = 0;
+    http->chunk_state = M_HTTP_CHUNK_SIZE;
 }
 
 static void mln_http_hash_free(void *data)
@@ -987,7 +1495,7 @@ static mln_u64_t mln_http_hash_calc(mln_hash_t *h, void *key)
 
 static int mln_http_hash_cmp(mln_hash_t *h, void *key1, void *key2)
 {
-    return !mln_string_strcasecmp((mln_string_t *)key1, (mln_string_t *)key2);
+    return mln_string_eq_ci((mln_string_t *)key1, (mln_string_t *)key2);
 }
 
 /*
@@ -1020,14 +1528,21 @@ void mln_http_dump(mln_http_t *http)
     printf("\ttype_code:%u\n", http->type);
     printf("\tfields:\n");
     if (rc <= 0) rc = 1;/*do nothing*/
+    mln_u32_t i;
+    for (i = 0; i < M_HTTP_COMMON_HEADER_NR; ++i) {
+        if (http->common_vals[i] != NULL)
+            mln_http_dump_iterate_handler(&mln_http_common_headers[i], http->common_vals[i], NULL);
+    }
     mln_hash_iterate(http->header_fields, mln_http_dump_iterate_handler, NULL);
 }
 
 static int mln_http_dump_iterate_handler(void *key, void *val, void *data)
 {
-    printf("\t\tkey:[%s] value:[%s]\n", \
-           (char *)(((mln_string_t *)key)->data), \
-           val == NULL?"NULL":(char *)(((mln_string_t *)val)->data));
+    mln_string_t *k = (mln_string_t *)key, *v = (mln_string_t *)val;
+    printf("\t\tkey:[%.*s] value:[%.*s]\n", \
+           (int)(k->len), (char *)(k->data), \
+           v == NULL? 4: (int)(v->len), \
+           v == NULL? "NULL": (char *)(v->data));
 
     return 0;
 }
@@ -0,0 +1,722 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#if defined(WIN32)
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+#include "mln_http_client.h"
+#include "mln_clock.h"
+
+#define M_HTTP_CLIENT_HASH_LEN        31
+#define M_HTTP_CLIENT_MAX_IDLE        8
+#define M_HTTP_CLIENT_IDLE_TIMEOUT_MS 60000
+#define M_HTTP_CLIENT_RESOLVE_TTL_MS  30000
+#define M_HTTP_CLIENT_PIPELINE_DEPTH  4
+#define M_HTTP_CLIENT_CHECK_MS        1000
+
+typedef struct mln_http_client_conn_s mln_http_client_conn_t;
+typedef struct mln_http_client_dest_s mln_http_client_dest_t;
+
+struct mln_http_client_req_s {
+    mln_http_t                *http;
+    mln_http_client_conn_t    *conn;
+    mln_http_client_cb_t       cb;
+    void                      *udata;
+    mln_chain_t               *body_head;
+    mln_chain_t               *body_tail;
+    mln_size_t                 body_left;
+    struct mln_http_client_req_s *next;
+    mln_u32_t                  flags;
+    mln_u32_t                  sent:1;
+    mln_u32_t                  responding:1;  /*http switched to response parsing*/
+    mln_u32_t                  body_checked:1;/*Content-Length/chunked decided*/
+    mln_u32_t                  chunked:1;
+    mln_u32_t                  chunk_done:1;
+    mln_u32_t                  no_body:1;     /*HEAD request, body forbidden*/
+};
+
+struct mln_http_client_conn_s {
+    mln_tcp_conn_t             conn;
+    mln_http_client_dest_t    *dest;
+    mln_http_client_req_t     *head;          /*in-flight FIFO, responses match in order*/
+    mln_http_client_req_t     *tail;
+    mln_size_t                 nreq;
+    mln_chain_t               *in;            /*received bytes not yet consumed by a parse*/
+    mln_u64_t                  idle_ms;       /*when the connection went idle*/
+    mln_http_client_conn_t    *prev;
+    mln_http_client_conn_t    *next;
+    mln_u32_t                  connected:1;
+    mln_u32_t                  idle:1;
+    mln_u32_t                  registered:1;  /*receive event armed*/
+};
+
+struct mln_http_client_dest_s {
+    mln_http_client_t         *client;
+    mln_string_t              *host;
+    mln_u16_t                  port;
+    struct sockaddr_storage    addr;
+    socklen_t                  addrlen;
+    mln_u64_t                  resolve_deadline_ms;
+    mln_http_client_conn_t    *conn_head;     /*every connection of this destination*/
+    mln_http_client_conn_t    *conn_tail;
+    mln_size_t                 nidle;
+};
+
+struct mln_http_client_s {
+    mln_event_t               *ev;
+    mln_alloc_t               *pool;
+    mln_hash_t                *dests;
+    mln_event_timer_t         *check_timer;
+    mln_u32_t                  max_idle;
+    mln_u32_t                  idle_timeout_ms;
+    mln_u32_t                  resolve_ttl_ms;
+    mln_u32_t                  pipeline_depth;
+};
+
+static int mln_http_client_resolve(mln_http_client_dest_t *dest);
+static void mln_http_client_conn_fail(mln_http_client_conn_t *c);
+static void mln_http_client_conn_destroy(mln_http_client_conn_t *c);
+static void mln_http_client_connect_handler(mln_event_t *ev, int fd, void *data);
+static void mln_http_client_send_handler(mln_event_t *ev, int fd, void *data);
+static void mln_http_client_recv_handler(mln_event_t *ev, int fd, void *data);
+static void mln_http_client_check_handler(mln_event_t *ev, void *data);
+static int mln_http_client_body_handler(mln_http_t *http, mln_chain_t **in, mln_chain_t **nil);
+
+MLN_CHAIN_FUNC_DECLARE(client_conn, mln_http_client_conn_t, static inline void,);
+MLN_CHAIN_FUNC_DEFINE(client_conn, mln_http_client_conn_t, static inline void, prev, next);
+
+static mln_u64_t mln_http_client_dest_hash(mln_hash_t *h, void *key)
+{
+    mln_string_t *s = (mln_string_t *)key;
+    mln_u8ptr_t p, end = s->data + s->len;
+    mln_u64_t sum = 0;
+
+    for (p = s->data; p < end; ++p)
+        sum = sum * 131 + *p;
+    return sum % h->len;
+}
+
+static int mln_http_client_dest_cmp(mln_hash_t *h, void *k1, void *k2)
+{
+    return !mln_string_strcmp((mln_string_t *)k1, (mln_string_t *)k2);
+}
+
+static void mln_http_client_nonblock_set(int fd)
+{
+#if defined(WIN32)
+    u_long opt = 1;
+    ioctlsocket(fd, FIONBIO, &opt);
+#else
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+mln_http_client_t *mln_http_client_new(mln_event_t *ev)
+{
+    mln_http_client_t *client;
+    mln_alloc_t *pool;
+    struct mln_hash_attr hattr;
+
+    if ((pool = mln_alloc_init(NULL)) == NULL) return NULL;
+    if ((client = (mln_http_client_t *)mln_alloc_m(pool, sizeof(mln_http_client_t))) == NULL) {
+        mln_alloc_destroy(pool);
+        return NULL;
+    }
+    client->ev = ev;
+    client->pool = pool;
+    client->max_idle = M_HTTP_CLIENT_MAX_IDLE;
+    client->idle_timeout_ms = M_HTTP_CLIENT_IDLE_TIMEOUT_MS;
+    client->resolve_ttl_ms = M_HTTP_CLIENT_RESOLVE_TTL_MS;
+    client->pipeline_depth = M_HTTP_CLIENT_PIPELINE_DEPTH;
+
+    hattr.pool = pool;
+    hattr.pool_alloc = (hash_pool_alloc_handler)mln_alloc_m;
+    hattr.pool_free = (hash_pool_free_handler)mln_alloc_free;
+    hattr.hash = mln_http_client_dest_hash;
+    hattr.cmp = mln_http_client_dest_cmp;
+    hattr.free_key = NULL;
+    hattr.free_val = NULL;
+    hattr.len_base = M_HTTP_CLIENT_HASH_LEN;
+    hattr.expandable = 0;
+    hattr.calc_prime = 0;
+    if ((client->dests = mln_hash_new(&hattr)) == NULL) {
+        mln_alloc_destroy(pool);
+        return NULL;
+    }
+    client->check_timer = mln_event_timer_set(ev, M_HTTP_CLIENT_CHECK_MS, client, mln_http_client_check_handler);
+    if (client->check_timer == NULL) {
+        mln_hash_free(client->dests, M_HASH_F_NONE);
+        mln_alloc_destroy(pool);
+        return NULL;
+    }
+    return client;
+}
+
+void mln_http_client_conf(mln_http_client_t *client, \
+                          mln_u32_t max_idle, \
+                          mln_u32_t idle_timeout_ms, \
+                          mln_u32_t resolve_ttl_ms, \
+                          mln_u32_t pipeline_depth)
+{
+    client->max_idle = max_idle;
+    client->idle_timeout_ms = idle_timeout_ms;
+    client->resolve_ttl_ms = resolve_ttl_ms;
+    client->pipeline_depth = pipeline_depth? pipeline_depth: 1;
+}
+
+static int mln_http_client_free_iterate_handler(void *key, void *val, void *udata)
+{
+    mln_http_client_dest_t *dest = (mln_http_client_dest_t *)val;
+
+    while (dest->conn_head != NULL)
+        mln_http_client_conn_fail(dest->conn_head);
+    mln_string_free(dest->host);
+    mln_string_free((mln_string_t *)key);
+    mln_alloc_free(dest);
+    return 0;
+}
+
+void mln_http_client_free(mln_http_client_t *client)
+{
+    if (client == NULL) return;
+    if (client->check_timer != NULL)
+        mln_event_timer_cancel(client->ev, client->check_timer);
+    mln_hash_iterate(client->dests, mln_http_client_free_iterate_handler, NULL);
+    mln_hash_free(client->dests, M_HASH_F_NONE);
+    mln_alloc_destroy(client->pool);
+}
+
+static int mln_http_client_resolve(mln_http_client_dest_t *dest)
+{
+    struct addrinfo hints, *res;
+    char host[256], service[16];
+
+    if (dest->host->len >= sizeof(host)) return -1;
+    memcpy(host, dest->host->data, dest->host->len);
+    host[dest->host->len] = 0;
+    snprintf(service, sizeof(service), "%u", (unsigned int)dest->port);
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, service, &hints, &res) != 0 || res == NULL)
+        return -1;
+    memcpy(&dest->addr, res->ai_addr, res->ai_addrlen);
+    dest->addrlen = res->ai_addrlen;
+    freeaddrinfo(res);
+    dest->resolve_deadline_ms = mln_clock_mono_ms() + dest->client->resolve_ttl_ms;
+    return 0;
+}
+
+static mln_http_client_dest_t *
+mln_http_client_dest_get(mln_http_client_t *client, mln_string_t *host, mln_u16_t port)
+{
+    mln_http_client_dest_t *dest;
+    mln_string_t *key, tmp;
+    char buf[300];
+    int n;
+
+    if (host->len >= 256) return NULL;
+    n = snprintf(buf, sizeof(buf), "%.*s:%u", (int)host->len, (char *)host->data, (unsigned int)port);
+    mln_string_nset(&tmp, buf, n);
+    dest = (mln_http_client_dest_t *)mln_hash_search(client->dests, &tmp);
+    if (dest != NULL) {
+        if (mln_clock_mono_ms() >= dest->resolve_deadline_ms && mln_http_client_resolve(dest) < 0)
+            return dest->addrlen? dest: NULL; /*stale address beats none*/
+        return dest;
+    }
+
+    dest = (mln_http_client_dest_t *)mln_alloc_m(client->pool, sizeof(mln_http_client_dest_t));
+    if (dest == NULL) return NULL;
+    dest->client = client;
+    if ((dest->host = mln_string_pool_dup(client->pool, host)) == NULL) {
+        mln_alloc_free(dest);
+        return NULL;
+    }
+    dest->port = port;
+    dest->addrlen = 0;
+    dest->resolve_deadline_ms = 0;
+    dest->conn_head = dest->conn_tail = NULL;
+    dest->nidle = 0;
+    if (mln_http_client_resolve(dest) < 0) {
+        goto err;
+    }
+    if ((key = mln_string_pool_dup(client->pool, &tmp)) == NULL) {
+        goto err;
+    }
+    if (mln_hash_insert(client->dests, key, dest) < 0) {
+        mln_string_free(key);
+        goto err;
+    }
+    return dest;
+
+err:
+    mln_string_free(dest->host);
+    mln_alloc_free(dest);
+    return NULL;
+}
+
+static mln_http_client_conn_t *
+mln_http_client_conn_acquire(mln_http_client_dest_t *dest, mln_u32_t flags)
+{
+    mln_http_client_t *client = dest->client;
+    mln_http_client_conn_t *c;
+    int fd;
+
+    /*a pipelined request may share a connection whose whole queue is pipelined*/
+    if ((flags & M_HTTP_CLIENT_PIPELINE) && client->pipeline_depth > 1) {
+        for (c = dest->conn_head; c != NULL; c = c->next) {
+            if (c->idle || !c->connected) continue;
+            if (c->nreq == 0 || c->nreq >= client->pipeline_depth) continue;
+            if (!(c->head->flags & M_HTTP_CLIENT_PIPELINE)) continue;
+            return c;
+        }
+    }
+    for (c = dest->conn_head; c != NULL; c = c->next) {
+        if (!c->idle) continue;
+        c->idle = 0;
+        --(dest->nidle);
+        return c;
+    }
+
+    if ((c = (mln_http_client_conn_t *)malloc(sizeof(mln_http_client_conn_t))) == NULL)
+        return NULL;
+    if ((fd = socket(((struct sockaddr *)&dest->addr)->sa_family, SOCK_STREAM, 0)) < 0) {
+        free(c);
+        return NULL;
+    }
+    mln_http_client_nonblock_set(fd);
+    if (mln_tcp_conn_init(&c->conn, fd) < 0) {
+        close(fd);
+        free(c);
+        return NULL;
+    }
+    c->dest = dest;
+    c->head = c->tail = NULL;
+    c->nreq = 0;
+    c->in = NULL;
+    c->idle_ms = 0;
+    c->prev = c->next = NULL;
+    c->connected = 0;
+    c->idle = 0;
+    c->registered = 0;
+    client_conn_chain_add(&dest->conn_head, &dest->conn_tail, c);
+    return c;
+}
+
+mln_http_client_req_t *
+mln_http_client_request_new(mln_http_client_t *client, \
+                            mln_string_t *host, \
+                            mln_u16_t port, \
+                            mln_u32_t flags)
+{
+    mln_http_client_dest_t *dest;
+    mln_http_client_conn_t *c;
+    mln_http_client_req_t *req;
+    mln_string_t host_key = mln_string("Host");
+
+    if ((dest = mln_http_client_dest_get(client, host, port)) == NULL)
+        return NULL;
+    if ((c = mln_http_client_conn_acquire(dest, flags)) == NULL)
+        return NULL;
+
+    req = (mln_http_client_req_t *)mln_alloc_m(mln_tcp_conn_pool_get(&c->conn), sizeof(mln_http_client_req_t));
+    if (req == NULL) return NULL;
+    memset(req, 0, sizeof(mln_http_client_req_t));
+    req->conn = c;
+    req->flags = flags;
+    if ((req->http = mln_http_init(&c->conn, req, NULL)) == NULL) {
+        mln_alloc_free(req);
+        return NULL;
+    }
+    mln_http_type_set(req->http, M_HTTP_REQUEST);
+    mln_http_version_set(req->http, M_HTTP_VERSION_1_1);
+    mln_http_method_set(req->http, M_HTTP_GET);
+    if (mln_http_field_set(req->http, &host_key, dest->host) == M_HTTP_RET_ERROR) {
+        mln_http_destroy(req->http);
+        mln_alloc_free(req);
+        return NULL;
+    }
+    return req;
+}
+
+mln_http_t *mln_http_client_request_http(mln_http_client_req_t *req)
+{
+    return req->http;
+}
+
+void mln_http_client_body(mln_http_t *resp, mln_chain_t **head, mln_chain_t **tail)
+{
+    mln_http_client_req_t *req = (mln_http_client_req_t *)mln_http_data_get(resp);
+    *head = req->body_head;
+    *tail = req->body_tail;
+}
+
+int mln_http_client_send(mln_http_client_t *client, \
+                         mln_http_client_req_t *req, \
+                         mln_http_client_cb_t cb, \
+                         void *udata)
+{
+    mln_http_client_conn_t *c = req->conn;
+    mln_chain_t *head = NULL, *tail = NULL;
+    int rc;
+
+    req->cb = cb;
+    req->udata = udata;
+    req->no_body = mln_http_method_get(req->http) == M_HTTP_HEAD? 1: 0;
+    if (mln_http_generate(req->http, &head, &tail) == M_HTTP_RET_ERROR)
+        return -1;
+    mln_tcp_conn_append_chain(&c->conn, head, tail, M_C_SEND);
+
+    if (c->tail == NULL) c->head = req;
+    else c->tail->next = req;
+    c->tail = req;
+    req->next = NULL;
+    ++(c->nreq);
+
+    if (!c->connected) {
+        if (c->nreq > 1) return 0; /*connect already in flight*/
+        rc = connect(mln_tcp_conn_fd_get(&c->conn), (struct sockaddr *)&c->dest->addr, c->dest->addrlen);
+        if (rc == 0) {
+            c->connected = 1;
+        } else if (errno == EINPROGRESS) {
+            return mln_event_fd_set(client->ev, \
+                                    mln_tcp_conn_fd_get(&c->conn), \
+                                    M_EV_SEND|M_EV_ONESHOT|M_EV_NONBLOCK, \
+                                    M_EV_UNLIMITED, \
+                                    c, \
+                                    mln_http_client_connect_handler);
+        } else {
+            c->dest->resolve_deadline_ms = 0; /*force re-resolution on the next attempt*/
+            mln_http_client_conn_fail(c);
+            return 0; /*callback already fired*/
+        }
+    }
+    return mln_event_fd_set(client->ev, \
+                            mln_tcp_conn_fd_get(&c->conn), \
+                            M_EV_SEND|M_EV_APPEND|M_EV_NONBLOCK, \
+                            M_EV_UNLIMITED, \
+                            c, \
+                            mln_http_client_send_handler);
+}
+
+static void mln_http_client_req_free(mln_http_client_req_t *req)
+{
+    if (req->body_head != NULL)
+        mln_chain_pool_release_all(req->body_head);
+    if (req->http != NULL)
+        mln_http_destroy(req->http);
+    mln_alloc_free(req);
+}
+
+static void mln_http_client_conn_destroy(mln_http_client_conn_t *c)
+{
+    mln_http_client_dest_t *dest = c->dest;
+
+    if (c->registered)
+        mln_event_fd_set(dest->client->ev, mln_tcp_conn_fd_get(&c->conn), M_EV_CLR, M_EV_UNLIMITED, NULL, NULL);
+    if (c->idle)
+        --(dest->nidle);
+    if (c->in != NULL)
+        mln_chain_pool_release_all(c->in);
+    client_conn_chain_del(&dest->conn_head, &dest->conn_tail, c);
+    close(mln_tcp_conn_fd_get(&c->conn));
+    mln_tcp_conn_destroy(&c->conn);
+    free(c);
+}
+
+/*fail every request queued on 'c' and drop the connection from the pool*/
+static void mln_http_client_conn_fail(mln_http_client_conn_t *c)
+{
+    mln_http_client_t *client = c->dest->client;
+    mln_http_client_req_t *req, *next;
+
+    req = c->head;
+    c->head = c->tail = NULL;
+    c->nreq = 0;
+    for (; req != NULL; req = next) {
+        next = req->next;
+        if (req->cb != NULL) req->cb(client, NULL, req->udata);
+        mln_http_client_req_free(req);
+    }
+    mln_http_client_conn_destroy(c);
+}
+
+static void mln_http_client_connect_handler(mln_event_t *ev, int fd, void *data)
+{
+    mln_http_client_conn_t *c = (mln_http_client_conn_t *)data;
+    int err = 0;
+    socklen_t len = sizeof(err);
+
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, (void *)&err, &len) < 0 || err != 0) {
+        c->dest->resolve_deadline_ms = 0;
+        mln_http_client_conn_fail(c);
+        return;
+    }
+    c->connected = 1;
+    mln_event_fd_set(ev, fd, M_EV_SEND|M_EV_APPEND|M_EV_NONBLOCK, M_EV_UNLIMITED, c, mln_http_client_send_handler);
+}
+
+static void mln_http_client_send_handler(mln_event_t *ev, int fd, void *data)
+{
+    mln_http_client_conn_t *c = (mln_http_client_conn_t *)data;
+    mln_http_client_req_t *req;
+    int ret;
+
+    while (mln_tcp_conn_head(&c->conn, M_C_SEND) != NULL) {
+        ret = mln_tcp_conn_send(&c->conn);
+        if (ret == M_C_FINISH) {
+            break;
+        } else if (ret == M_C_NOTYET) {
+            mln_tcp_conn_chain_release(&c->conn, mln_tcp_conn_remove(&c->conn, M_C_SENT));
+            mln_event_fd_set(ev, fd, M_EV_SEND|M_EV_APPEND|M_EV_NONBLOCK, M_EV_UNLIMITED, c, mln_http_client_send_handler);
+            return;
+        } else {
+            mln_http_client_conn_fail(c);
+            return;
+        }
+    }
+    mln_tcp_conn_chain_release(&c->conn, mln_tcp_conn_remove(&c->conn, M_C_SENT));
+
+    /*everything written; switch the head request over to response parsing*/
+    for (req = c->head; req != NULL; req = req->next)
+        req->sent = 1;
+    if (c->head != NULL && !c->head->responding) {
+        /*type stays M_HTTP_UNKNOWN: the parser detects the response itself*/
+        mln_http_reset(c->head->http);
+        mln_http_handler_set(c->head->http, mln_http_client_body_handler);
+        c->head->responding = 1;
+    }
+    if (!c->registered) {
+        if (mln_event_fd_set(ev, fd, M_EV_RECV|M_EV_APPEND|M_EV_NONBLOCK, M_EV_UNLIMITED, c, mln_http_client_recv_handler) < 0) {
+            mln_http_client_conn_fail(c);
+            return;
+        }
+        c->registered = 1;
+    }
+}
+
+/*
+ * Parse the response body. The first call after the headers decides
+ * between Content-Length and chunked transfer-encoding; a HEAD
+ * response and bodyless statuses finish immediately. Complete receive
+ * buffers are moved into the request's body chain by reference, only a
+ * buffer carrying bytes of the next pipelined response is split.
+ */
+static int mln_http_client_chunk_handler(mln_http_t *http, mln_buf_t *b)
+{
+    mln_http_client_req_t *req = (mln_http_client_req_t *)mln_http_data_get(http);
+    mln_alloc_t *pool = mln_http_pool_get(http);
+    mln_chain_t *c;
+    mln_buf_t *buf;
+    mln_u8ptr_t copy;
+    mln_size_t n;
+
+    if (b == NULL) {
+        req->chunk_done = 1;
+        return M_HTTP_RET_DONE;
+    }
+    n = mln_buf_left_size(b);
+    if (n == 0) return M_HTTP_RET_OK;
+    if ((c = mln_chain_new(pool)) == NULL || (buf = mln_buf_new(pool)) == NULL)
+        return M_HTTP_RET_ERROR;
+    if ((copy = (mln_u8ptr_t)mln_alloc_m(pool, n)) == NULL)
+        return M_HTTP_RET_ERROR;
+    memcpy(copy, b->left_pos, n);
+    buf->left_pos = buf->pos = buf->start = copy;
+    buf->last = buf->end = copy + n;
+    buf->in_memory = 1;
+    c->buf = buf;
+    mln_chain_add(&req->body_head, &req->body_tail, c);
+    return M_HTTP_RET_OK;
+}
+
+static int mln_http_client_body_handler(mln_http_t *http, mln_chain_t **in, mln_chain_t **nil)
+{
+    mln_http_client_req_t *req = (mln_http_client_req_t *)mln_http_data_get(http);
+    mln_string_t cl_key = mln_string("Content-Length");
+    mln_string_t te_key = mln_string("Transfer-Encoding");
+    mln_string_t chunked_val = mln_string("chunked");
+    mln_string_t *val;
+    mln_chain_t *c;
+    mln_size_t n;
+    mln_u32_t status;
+
+    if (!req->body_checked) {
+        req->body_checked = 1;
+        status = mln_http_status_get(http);
+        if (req->no_body || status < M_HTTP_OK || status == M_HTTP_NO_CONTENT || status == M_HTTP_NOT_MODIFIED)
+            return M_HTTP_RET_DONE;
+        if ((val = mln_http_field_get(http, &te_key)) != NULL && !mln_string_strcasecmp(val, &chunked_val)) {
+            req->chunked = 1;
+        } else if ((val = mln_http_field_get(http, &cl_key)) != NULL) {
+            for (n = 0; n < val->len; ++n) {
+                if (val->data[n] < '0' || val->data[n] > '9') break;
+                req->body_left = req->body_left * 10 + (val->data[n] - '0');
+            }
+            if (req->body_left == 0) return M_HTTP_RET_DONE;
+        } else {
+            return M_HTTP_RET_DONE;
+        }
+    }
+
+    if (req->chunked) {
+        if (mln_http_chunk_parse(http, in, mln_http_client_chunk_handler) == M_HTTP_RET_ERROR)
+            return M_HTTP_RET_ERROR;
+        return req->chunk_done? M_HTTP_RET_DONE: M_HTTP_RET_OK;
+    }
+
+    while (*in != NULL && req->body_left > 0) {
+        c = *in;
+        n = mln_buf_left_size(c->buf);
+        if (n == 0) {
+            *in = c->next;
+            c->next = NULL;
+            mln_chain_pool_release(c);
+            continue;
+        }
+        if (n <= req->body_left) {
+            *in = c->next;
+            c->next = NULL;
+            c->buf->pos = c->buf->left_pos; /*unconsumed span starts at left_pos*/
+            mln_chain_add(&req->body_head, &req->body_tail, c);
+            req->body_left -= n;
+        } else {
+            /*buffer runs into the next response: hand over only our part*/
+            mln_chain_t *nc;
+            mln_buf_t *buf;
+            mln_u8ptr_t copy;
+            mln_alloc_t *pool = mln_http_pool_get(http);
+            if ((nc = mln_chain_new(pool)) == NULL || (buf = mln_buf_new(pool)) == NULL)
+                return M_HTTP_RET_ERROR;
+            if ((copy = (mln_u8ptr_t)mln_alloc_m(pool, req->body_left)) == NULL)
+                return M_HTTP_RET_ERROR;
+            memcpy(copy, c->buf->left_pos, req->body_left);
+            buf->left_pos = buf->pos = buf->start = copy;
+            buf->last = buf->end = copy + req->body_left;
+            buf->in_memory = 1;
+            nc->buf = buf;
+            mln_chain_add(&req->body_head, &req->body_tail, nc);
+            c->buf->left_pos += req->body_left;
+            req->body_left = 0;
+        }
+    }
+    return req->body_left == 0? M_HTTP_RET_DONE: M_HTTP_RET_OK;
+}
+
+/*on response completion: keep-alive decides whether the connection returns to the pool*/
+static int mln_http_client_keepalive(mln_http_t *resp)
+{
+    mln_string_t conn_key = mln_string("Connection");
+    mln_string_t close_val = mln_string("close");
+    mln_string_t keep_val = mln_string("keep-alive");
+    mln_string_t *val = mln_http_field_get(resp, &conn_key);
+
+    if (val != NULL) {
+        if (!mln_string_strcasecmp(val, &close_val)) return 0;
+        if (!mln_string_strcasecmp(val, &keep_val)) return 1;
+    }
+    return mln_http_version_get(resp) == M_HTTP_VERSION_1_1;
+}
+
+static void mln_http_client_recv_handler(mln_event_t *ev, int fd, void *data)
+{
+    mln_http_client_conn_t *c = (mln_http_client_conn_t *)data;
+    mln_http_client_t *client = c->dest->client;
+    mln_http_client_req_t *req;
+    mln_chain_t *newin, *tail;
+    int ret, alive;
+
+    ret = mln_tcp_conn_recv(&c->conn, M_C_TYPE_MEMORY);
+    if (ret == M_C_ERROR || ret == M_C_CLOSED) {
+        if (c->in == NULL && c->head == NULL) {
+            mln_http_client_conn_destroy(c); /*idle connection, peer closed*/
+            return;
+        }
+        if (ret == M_C_ERROR || mln_tcp_conn_recv_empty(&c->conn)) {
+            mln_http_client_conn_fail(c);
+            return;
+        }
+        /*closed but trailing bytes arrived: parse them, fail on next read*/
+    }
+
+    if ((newin = mln_tcp_conn_remove(&c->conn, M_C_RECV)) != NULL) {
+        if (c->in == NULL) {
+            c->in = newin;
+        } else {
+            for (tail = c->in; tail->next != NULL; tail = tail->next)
+                ;
+            tail->next = newin;
+        }
+    }
+
+    while ((req = c->head) != NULL && req->sent && c->in != NULL) {
+        if (!req->responding) {
+            mln_http_reset(req->http);
+            mln_http_handler_set(req->http, mln_http_client_body_handler);
+            req->responding = 1;
+        }
+        ret = mln_http_parse(req->http, &c->in);
+        if (ret == M_HTTP_RET_ERROR) {
+            mln_http_client_conn_fail(c);
+            return;
+        }
+        if (ret == M_HTTP_RET_OK) return; /*need more input*/
+
+        /*response complete*/
+        c->head = req->next;
+        if (c->head == NULL) c->tail = NULL;
+        --(c->nreq);
+        alive = mln_http_client_keepalive(req->http);
+        if (req->cb != NULL) req->cb(client, req->http, req->udata);
+        mln_http_client_req_free(req);
+        if (!alive) {
+            mln_http_client_conn_fail(c);
+            return;
+        }
+        if (c->head == NULL) {
+            if (c->dest->nidle >= client->max_idle) {
+                mln_http_client_conn_destroy(c);
+                return;
+            }
+            c->idle = 1;
+            c->idle_ms = mln_clock_mono_ms();
+            ++(c->dest->nidle);
+            /*receive stays armed so a peer close evicts the idle connection*/
+            return;
+        }
+    }
+}
+
+static int mln_http_client_check_iterate_handler(void *key, void *val, void *udata)
+{
+    mln_http_client_dest_t *dest = (mln_http_client_dest_t *)val;
+    mln_u64_t now = *(mln_u64_t *)udata;
+    mln_http_client_conn_t *c, *next;
+
+    for (c = dest->conn_head; c != NULL; c = next) {
+        next = c->next;
+        if (c->idle && now - c->idle_ms >= dest->client->idle_timeout_ms)
+            mln_http_client_conn_destroy(c);
+    }
+    return 0;
+}
+
+static void mln_http_client_check_handler(mln_event_t *ev, void *data)
+{
+    mln_http_client_t *client = (mln_http_client_t *)data;
+    mln_u64_t now = mln_clock_mono_ms();
+
+    mln_hash_iterate(client->dests, mln_http_client_check_iterate_handler, &now);
+    client->check_timer = mln_event_timer_set(ev, M_HTTP_CLIENT_CHECK_MS, client, mln_http_client_check_handler);
+}
@@ -21,6 +21,102 @@ static inline void mln_iothread_msg_free(mln_iothread_msg_t *msg);
 MLN_CHAIN_FUNC_DECLARE(mln_iothread_msg, mln_iothread_msg_t, static inline void,);
 MLN_CHAIN_FUNC_DEFINE(mln_iothread_msg, mln_iothread_msg_t, static inline void, prev, next);
 
+static mln_iothread_ring_t *mln_iothread_ring_new(mln_u32_t size)
+{
+    mln_iothread_ring_t *r;
+
+    /* round up to a power of two */
+    --size;
+    size |= size >> 1;
+    size |= size >> 2;
+    size |= size >> 4;
+    size |= size >> 8;
+    size |= size >> 16;
+    ++size;
+
+    if ((r = (mln_iothread_ring_t *)malloc(sizeof(mln_iothread_ring_t))) == NULL)
+        return NULL;
+    if ((r->slots = (mln_iothread_msg_t **)calloc(size, sizeof(mln_iothread_msg_t *))) == NULL) {
+        free(r);
+        return NULL;
+    }
+    r->size = size;
+    r->mask = size - 1;
+    r->head = r->tail = 0;
+    r->waiting = 0;
+    return r;
+}
+
+static void mln_iothread_ring_free(mln_iothread_ring_t *r)
+{
+    mln_u32_t head, tail;
+    if (r == NULL) return;
+    head = r->head;
+    tail = r->tail;
+    while (head != tail)
+        mln_iothread_msg_free(r->slots[(head++) & r->mask]);
+    free(r->slots);
+    free(r);
+}
+
+static inline int
+mln_iothread_ring_send(mln_iothread_ring_t *r, int fd, mln_iothread_msg_t *msg, mln_u32_t feedback)
+{
+    mln_u32_t head, tail;
+
+    tail = __atomic_load_n(&(r->tail), __ATOMIC_RELAXED);
+    head = __atomic_load_n(&(r->head), __ATOMIC_ACQUIRE);
+    if (tail - head >= r->size) {
+        if (feedback) pthread_mutex_unlock(&(msg->mutex));
+        mln_iothread_msg_free(msg);
+        return 1;
+    }
+    r->slots[tail & r->mask] = msg;
+    __atomic_store_n(&(r->tail), tail + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n(&(r->waiting), 0, __ATOMIC_SEQ_CST))
+        (void)send(fd, " ", 1, 0);
+    return 0;
+}
+
+static inline int
+mln_iothread_ring_recv(mln_iothread_t *t, mln_iothread_ring_t *r, int fd, mln_iothread_ep_type_t from)
+{
+    int n = 0;
+    mln_s8_t c;
+    mln_u32_t head, tail;
+    mln_iothread_msg_t *msg;
+
+    while (recv(fd, &c, 1, 0) == 1)
+        ;/*swallow pending doorbells*/
+
+    head = __atomic_load_n(&(r->head), __ATOMIC_RELAXED);
+again:
+    tail = __atomic_load_n(&(r->tail), __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        msg = r->slots[head & r->mask];
+        __atomic_store_n(&(r->head), ++head, __ATOMIC_RELEASE);
+        if (t->handler != NULL)
+            t->handler(t, from, msg);
+        if (msg->feedback) {
+            if (!msg->hold)
+                pthread_mutex_unlock(&(msg->mutex));
+        } else {
+            mln_iothread_msg_free(msg);
+        }
+        ++n;
+    }
+    /*
+     * Raise the flag before the final emptiness check, so a message
+     * published in between either shows up here or gets a doorbell.
+     */
+    __atomic_store_n(&(r->waiting), 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&(r->tail), __ATOMIC_SEQ_CST) != head) {
+        __atomic_store_n(&(r->waiting), 0, __ATOMIC_SEQ_CST);
+        goto again;
+    }
+    return n;
+}
+
 int mln_iothread_init(mln_iothread_t *t, struct mln_iothread_attr *attr)
 {
     mln_u32_t i;
@@ -29,6 +125,10 @@ int mln_iothread_init(mln_iothread_t *t, struct mln_iothread_attr *attr)
     if (!attr->nthread || attr->entry == NULL) {
         return -1;
     }
+    if (attr->ringsize && attr->sharded) {
+        /* the ring is SPSC, sharding only applies to the list transport */
+        return -1;
+    }
 
     if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
         return -1;
@@ -44,9 +144,51 @@ int mln_iothread_init(mln_iothread_t *t, struct mln_iothread_attr *attr)
     pthread_mutex_init(&(t->user_lock), NULL);
     t->io_head = t->io_tail = NULL;
     t->user_head = t->user_tail = NULL;
+    t->io_ring = t->user_ring = NULL;
+    t->shards = NULL;
+    t->rr = 0;
     t->nthread = attr->nthread;
 
+    if (attr->sharded) {
+        if ((t->shards = (mln_iothread_shard_t *)calloc(attr->nthread, sizeof(mln_iothread_shard_t))) == NULL) {
+            mln_socket_close(fds[0]);
+            mln_socket_close(fds[1]);
+            return -1;
+        }
+        for (i = 0; i < attr->nthread; ++i) {
+            pthread_mutex_init(&(t->shards[i].lock), NULL);
+            t->shards[i].head = t->shards[i].tail = NULL;
+        }
+    }
+
+    if (attr->ringsize) {
+        /* SPSC by construction, so exactly one thread per endpoint */
+        if (attr->nthread != 1) {
+            mln_socket_close(fds[0]);
+            mln_socket_close(fds[1]);
+            return -1;
+        }
+        if ((t->io_ring = mln_iothread_ring_new(attr->ringsize)) == NULL || \
+            (t->user_ring = mln_iothread_ring_new(attr->ringsize)) == NULL)
+        {
+            mln_iothread_ring_free(t->io_ring);
+            t->io_ring = NULL;
+            mln_socket_close(fds[0]);
+            mln_socket_close(fds[1]);
+            return -1;
+        }
+    }
+
     if ((t->tids = (pthread_t *)calloc(t->nthread, sizeof(pthread_t))) == NULL) {
+        mln_iothread_ring_free(t->io_ring);
+        mln_iothread_ring_free(t->user_ring);
+        t->io_ring = t->user_ring = NULL;
+        if (t->shards != NULL) {
+            for (i = 0; i < t->nthread; ++i)
+                pthread_mutex_destroy(&(t->shards[i].lock));
+            free(t->shards);
+            t->shards = NULL;
+        }
         mln_socket_close(fds[0]);
         mln_socket_close(fds[1]);
         return -1;
@@ -76,10 +218,118 @@ void mln_iothread_destroy(mln_iothread_t *t)
         }
         free(t->tids);
     }
+    mln_iothread_ring_free(t->io_ring);
+    mln_iothread_ring_free(t->user_ring);
+    t->io_ring = t->user_ring = NULL;
+    if (t->shards != NULL) {
+        mln_u32_t i;
+        mln_iothread_msg_t *msg;
+        for (i = 0; i < t->nthread; ++i) {
+            while ((msg = t->shards[i].head) != NULL) {
+                mln_iothread_msg_chain_del(&(t->shards[i].head), &(t->shards[i].tail), msg);
+                mln_iothread_msg_free(msg);
+            }
+            pthread_mutex_destroy(&(t->shards[i].lock));
+        }
+        free(t->shards);
+        t->shards = NULL;
+    }
     mln_socket_close(t->io_fd);
     mln_socket_close(t->user_fd);
 }
 
+static int
+mln_iothread_shard_send(mln_iothread_t *t, mln_u32_t type, void *data, mln_u32_t feedback, mln_u32_t idx)
+{
+    mln_iothread_msg_t *msg;
+    mln_iothread_shard_t *s = &(t->shards[idx % t->nthread]);
+
+    if ((msg = mln_iothread_msg_new(type, data, feedback)) == NULL)
+        return -1;
+
+    if (feedback)
+        pthread_mutex_lock(&(msg->mutex));
+
+    pthread_mutex_lock(&(s->lock));
+
+    mln_iothread_msg_chain_add(&(s->head), &(s->tail), msg);
+
+    /* one doorbell byte per shard going nonempty, cleared by whoever drains it */
+    if (s->head == s->tail && s->head == msg && send(t->user_fd, " ", 1, 0) != 1) {
+        mln_iothread_msg_chain_del(&(s->head), &(s->tail), msg);
+        if (feedback) pthread_mutex_unlock(&(msg->mutex));
+        pthread_mutex_unlock(&(s->lock));
+        mln_iothread_msg_free(msg);
+        return 1;
+    }
+
+    pthread_mutex_unlock(&(s->lock));
+
+    if (feedback) {
+        pthread_mutex_lock(&(msg->mutex));
+        pthread_mutex_unlock(&(msg->mutex));
+        mln_iothread_msg_free(msg);
+    }
+
+    return 0;
+}
+
+static int mln_iothread_shard_recv(mln_iothread_t *t)
+{
+    int n = 0;
+    mln_s8_t c;
+    mln_u32_t i, idx;
+    mln_iothread_shard_t *s;
+    mln_iothread_msg_t *msg, *chain = NULL;
+    pthread_t self = pthread_self();
+
+    for (idx = 0; idx < t->nthread; ++idx) {
+        if (pthread_equal(t->tids[idx], self))
+            break;
+    }
+    if (idx == t->nthread) return -1;/*caller is not one of the I/O threads*/
+
+    s = &(t->shards[idx]);
+    pthread_mutex_lock(&(s->lock));
+    if ((chain = s->head) != NULL) {
+        s->head = s->tail = NULL;
+        (void)recv(t->io_fd, &c, 1, 0);
+    }
+    pthread_mutex_unlock(&(s->lock));
+
+    if (chain == NULL) {
+        /*run dry, sweep the siblings for a loaded one*/
+        for (i = 1; i < t->nthread; ++i) {
+            s = &(t->shards[(idx + i) % t->nthread]);
+            if (s->head == NULL) continue;
+            if (pthread_mutex_trylock(&(s->lock)) != 0) continue;/*owner is busy here, try the next sibling*/
+            if ((chain = s->head) != NULL) {
+                s->head = s->tail = NULL;
+                (void)recv(t->io_fd, &c, 1, 0);
+            }
+            pthread_mutex_unlock(&(s->lock));
+            if (chain != NULL) break;
+        }
+    }
+
+    /* the chain is detached, so the handler runs without any lock held */
+    while ((msg = chain) != NULL) {
+        chain = chain->next;
+        msg->prev = msg->next = NULL;
+        if (t->handler != NULL)
+            t->handler(t, user_thread, msg);
+        if (msg->feedback) {
+            if (!msg->hold)
+                pthread_mutex_unlock(&(msg->mutex));
+        } else {
+            mln_iothread_msg_free(msg);
+        }
+        ++n;
+    }
+
+    return n;
+}
+
 int mln_iothread_send(mln_iothread_t *t, mln_u32_t type, void *data, mln_iothread_ep_type_t to, mln_u32_t feedback)
 {
     int fd;
@@ -87,6 +337,10 @@ int mln_iothread_send(mln_iothread_t *t, mln_u32_t type, void *data, mln_iothrea
     mln_iothread_msg_t *msg;
     mln_iothread_msg_t **head, **tail;
 
+    if (to == io_thread && t->shards != NULL)
+        return mln_iothread_shard_send(t, type, data, feedback, \
+                                       __atomic_fetch_add(&(t->rr), 1, __ATOMIC_RELAXED));
+
     if (to == io_thread) {
         fd = t->user_fd;
         plock = &(t->io_lock);
@@ -105,6 +359,18 @@ int mln_iothread_send(mln_iothread_t *t, mln_u32_t type, void *data, mln_iothrea
     if (feedback)
         pthread_mutex_lock(&(msg->mutex));
 
+    if (t->io_ring != NULL) {
+        int rc;
+        if ((rc = mln_iothread_ring_send(to == io_thread? t->io_ring: t->user_ring, fd, msg, feedback)) != 0)
+            return rc;
+        if (feedback) {
+            pthread_mutex_lock(&(msg->mutex));
+            pthread_mutex_unlock(&(msg->mutex));
+            mln_iothread_msg_free(msg);
+        }
+        return 0;
+    }
+
     pthread_mutex_lock(plock);
 
     mln_iothread_msg_chain_add(head, tail, msg);
@@ -128,6 +394,13 @@ int mln_iothread_send(mln_iothread_t *t, mln_u32_t type, void *data, mln_iothrea
     return 0;
 }
 
+int mln_iothread_send_key(mln_iothread_t *t, mln_u32_t type, void *data, mln_iothread_ep_type_t to, mln_u32_t feedback, mln_u32_t key)
+{
+    if (to == io_thread && t->shards != NULL)
+        return mln_iothread_shard_send(t, type, data, feedback, key);
+    return mln_iothread_send(t, type, data, to, feedback);
+}
+
 int mln_iothread_recv(mln_iothread_t *t, mln_iothread_ep_type_t from)
 {
     int fd, n = 0;
@@ -148,6 +421,11 @@ int mln_iothread_recv(mln_iothread_t *t, mln_iothread_ep_type_t from)
         tail = &(t->io_tail);
     }
 
+    if (t->io_ring != NULL)
+        return mln_iothread_ring_recv(t, from == io_thread? t->user_ring: t->io_ring, fd, from);
+    if (from == user_thread && t->shards != NULL)
+        return mln_iothread_shard_recv(t);
+
     pthread_mutex_lock(plock);
 
     pos = *head;
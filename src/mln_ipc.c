@@ -3,7 +3,12 @@
  * Copyright (C) Niklaus F.Schen.
  */
 #if !defined(WIN32)
+#include <stdlib.h>
+#include <string.h>
 #include "mln_ipc.h"
+#include "mln_alloc.h"
+#include "mln_conf.h"
+#include "mln_log.h"
 
 /*
  * IPC only act on A child process and the parent process.
@@ -58,4 +63,250 @@ int mln_set_ipc_handlers(void)
     return 0;
 }
 
+
+/*
+ * Bulk channel. Each worker owns one single-producer single-consumer
+ * ring in a shared-memory pool mapped before fork; record layout is a
+ * 4-byte length followed by the payload, wrapping at the ring end.
+ * The worker publishes the head with a release store and knocks on the
+ * socketpair only when the master may have drained everything and gone
+ * idle; while the master lags behind it is still inside a drain and
+ * will pick the new records up without being woken.
+ */
+#define M_IPC_BULK_MIN_RING 4096
+
+typedef struct {
+    volatile mln_u64_t head; /*written by the worker*/
+    volatile mln_u64_t tail; /*written by the master*/
+    mln_u64_t          size; /*power of two, buffer follows*/
+} mln_ipc_bulk_ring_t;
+
+static mln_alloc_t *bulk_pool = NULL;
+static mln_size_t bulk_size = 0;
+static mln_ipc_bulk_cb_t bulk_cb = NULL;
+static void *bulk_cb_data = NULL;
+static mln_u8ptr_t bulk_scratch = NULL;
+static mln_ipc_bulk_ring_t *bulk_worker_ring = NULL;
+static int bulk_in_worker = 0;
+
+static int mln_ipc_bulk_nolock(void *locker)
+{
+    /*the pool is only touched by the single-threaded master*/
+    return 0;
+}
+
+static void
+mln_ipc_bulk_master_handler(mln_event_t *ev, void *f, void *buf, mln_u32_t len, void **udata)
+{
+    mln_ipc_bulk_drain((mln_fork_t *)f);
+}
+
+static void
+mln_ipc_bulk_worker_handler(mln_event_t *ev, void *c, void *buf, mln_u32_t len, void **udata)
+{
+    /*the master never sends this type to workers*/
+}
+
+int mln_ipc_bulk_init(mln_size_t ring_size, mln_ipc_bulk_cb_t cb, void *udata)
+{
+    struct mln_alloc_shm_attr_s attr;
+    mln_size_t size;
+    mln_sauto_t nworker = 1;
+    mln_conf_t *cf;
+    mln_conf_domain_t *cd;
+    mln_conf_cmd_t *cc;
+    mln_conf_item_t *ci;
+
+    if (bulk_pool != NULL) return -1;
+
+    for (size = M_IPC_BULK_MIN_RING; size < ring_size; size <<= 1)
+        ;
+    if ((cf = mln_conf()) != NULL && \
+        (cd = cf->search(cf, "main")) != NULL && \
+        (cc = cd->search(cd, "worker_proc")) != NULL && \
+        (ci = cc->search(cc, 1)) != NULL && \
+        ci->type == CONF_INT && ci->val.i > 0)
+    {
+        nworker = ci->val.i;
+    }
+    attr.size = (size + sizeof(mln_ipc_bulk_ring_t) + M_ALLOC_SHM_BITMAP_LEN) * \
+                (nworker + 4) + M_ALLOC_SHM_DEFAULT_SIZE;
+    attr.locker = &bulk_size;/*unused by the no-op lock but must be non-NULL*/
+    attr.lock = mln_ipc_bulk_nolock;
+    attr.unlock = mln_ipc_bulk_nolock;
+    if ((bulk_pool = mln_alloc_shm_init(&attr)) == NULL) {
+        mln_log(error, "mln_alloc_shm_init() failed.\n");
+        return -1;
+    }
+    if ((bulk_scratch = (mln_u8ptr_t)malloc(size)) == NULL) {
+        mln_log(error, "No memory.\n");
+        mln_alloc_destroy(bulk_pool);
+        bulk_pool = NULL;
+        return -1;
+    }
+    if (mln_ipc_handler_register(M_IPC_TYPE_BULK, \
+                                 mln_ipc_bulk_master_handler, \
+                                 mln_ipc_bulk_worker_handler, \
+                                 NULL, \
+                                 NULL) < 0)
+    {
+        mln_log(error, "No memory.\n");
+        free(bulk_scratch);
+        bulk_scratch = NULL;
+        mln_alloc_destroy(bulk_pool);
+        bulk_pool = NULL;
+        return -1;
+    }
+    bulk_size = size;
+    bulk_cb = cb;
+    bulk_cb_data = udata;
+    return 0;
+}
+
+void *mln_ipc_bulk_ring_new(void)
+{
+    mln_ipc_bulk_ring_t *r;
+
+    if (bulk_pool == NULL) return NULL;
+    if ((r = (mln_ipc_bulk_ring_t *)mln_alloc_m(bulk_pool, sizeof(*r) + bulk_size)) == NULL) {
+        mln_log(error, "Bulk IPC ring allocation failed.\n");
+        return NULL;
+    }
+    r->head = r->tail = 0;
+    r->size = bulk_size;
+    return r;
+}
+
+void mln_ipc_bulk_ring_free(void *ring)
+{
+    /*the pool copy in a worker is shared with the master -- hands off*/
+    if (ring == NULL || bulk_in_worker) return;
+    mln_alloc_free(ring);
+}
+
+void mln_ipc_bulk_worker_attach(void *ring)
+{
+    bulk_in_worker = 1;
+    bulk_worker_ring = (mln_ipc_bulk_ring_t *)ring;
+}
+
+static inline void
+mln_ipc_bulk_copy_in(mln_ipc_bulk_ring_t *r, mln_u64_t pos, void *src, mln_u32_t n)
+{
+    mln_u8ptr_t buf = (mln_u8ptr_t)(r + 1);
+    mln_u64_t off = pos & (r->size - 1);
+    mln_u64_t part = r->size - off;
+
+    if (n <= part) {
+        memcpy(buf + off, src, n);
+    } else {
+        memcpy(buf + off, src, part);
+        memcpy(buf, (mln_u8ptr_t)src + part, n - part);
+    }
+}
+
+static inline void
+mln_ipc_bulk_copy_out(mln_ipc_bulk_ring_t *r, mln_u64_t pos, void *dst, mln_u32_t n)
+{
+    mln_u8ptr_t buf = (mln_u8ptr_t)(r + 1);
+    mln_u64_t off = pos & (r->size - 1);
+    mln_u64_t part = r->size - off;
+
+    if (n <= part) {
+        memcpy(dst, buf + off, n);
+    } else {
+        memcpy(dst, buf + off, part);
+        memcpy((mln_u8ptr_t)dst + part, buf, n - part);
+    }
+}
+
+int mln_ipc_bulk_send(mln_event_t *ev, void *buf, mln_u32_t len)
+{
+    mln_ipc_bulk_ring_t *r = bulk_worker_ring;
+    mln_u64_t head, tail;
+    mln_u32_t need = sizeof(mln_u32_t) + len;
+    mln_u8_t byte = 0;
+
+    if (r == NULL || need > r->size) return -1;
+    head = r->head;
+    tail = __atomic_load_n(&(r->tail), __ATOMIC_ACQUIRE);
+    if (r->size - (head - tail) < need) return -1;
+    mln_ipc_bulk_copy_in(r, head, &len, sizeof(len));
+    mln_ipc_bulk_copy_in(r, head + sizeof(len), buf, len);
+    __atomic_store_n(&(r->head), head + need, __ATOMIC_RELEASE);
+    if (__atomic_load_n(&(r->tail), __ATOMIC_ACQUIRE) == head) {
+        if (mln_ipc_worker_send_prepare(ev, M_IPC_TYPE_BULK, &byte, 1) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+mln_size_t mln_ipc_bulk_drain(mln_fork_t *f)
+{
+    mln_ipc_bulk_ring_t *r = (mln_ipc_bulk_ring_t *)(f->bulk_ring);
+    mln_u64_t head, tail, off, part;
+    mln_u32_t len;
+    mln_u8ptr_t rec;
+    mln_size_t cnt = 0;
+
+    if (r == NULL) return 0;
+    tail = r->tail;
+    while ((head = __atomic_load_n(&(r->head), __ATOMIC_ACQUIRE)) != tail) {
+        mln_ipc_bulk_copy_out(r, tail, &len, sizeof(len));
+        if (sizeof(len) + (mln_u64_t)len > head - tail) break;
+        off = (tail + sizeof(len)) & (r->size - 1);
+        part = r->size - off;
+        if (len <= part) {
+            rec = (mln_u8ptr_t)(r + 1) + off;
+        } else {
+            mln_ipc_bulk_copy_out(r, tail + sizeof(len), bulk_scratch, len);
+            rec = bulk_scratch;
+        }
+        bulk_cb(f, rec, len, bulk_cb_data);
+        tail += sizeof(len) + len;
+        __atomic_store_n(&(r->tail), tail, __ATOMIC_RELEASE);
+        ++cnt;
+    }
+    return cnt;
+}
+
+/*
+ * event-loop statistics channel
+ */
+static mln_ipc_event_stat_cb_t evstat_cb = NULL;
+static void *evstat_udata = NULL;
+
+static void
+mln_ipc_event_stat_master_handler(mln_event_t *ev, void *f, void *buf, mln_u32_t len, void **udata)
+{
+    if (len != sizeof(mln_event_stat_t) || evstat_cb == NULL) return;
+    evstat_cb((mln_fork_t *)f, (mln_event_stat_t *)buf, evstat_udata);
+}
+
+static void
+mln_ipc_event_stat_worker_handler(mln_event_t *ev, void *c, void *buf, mln_u32_t len, void **udata)
+{
+    /*the master never sends this type to workers*/
+}
+
+int mln_ipc_event_stat_init(mln_ipc_event_stat_cb_t cb, void *udata)
+{
+    if (evstat_cb != NULL) return -1;
+    evstat_cb = cb;
+    evstat_udata = udata;
+    return mln_ipc_handler_register(M_IPC_TYPE_EVSTAT, \
+                                    mln_ipc_event_stat_master_handler, \
+                                    mln_ipc_event_stat_worker_handler, \
+                                    NULL, \
+                                    NULL);
+}
+
+int mln_ipc_event_stat_send(mln_event_t *ev)
+{
+    mln_event_stat_t st;
+
+    if (mln_event_stat_get(ev, &st) < 0) return -1;
+    return mln_ipc_worker_send_prepare(ev, M_IPC_TYPE_EVSTAT, (mln_u8ptr_t)&st, sizeof(st));
+}
+
 #endif
@@ -8,6 +8,77 @@
 #include <stdio.h>
 #include "mln_json.h"
 
+#if defined(MLN_JSON_SIMD)
+#if defined(__SSE2__) || defined(i386) || defined(__x86_64)
+#include <emmintrin.h>
+#define MLN_JSON_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define MLN_JSON_SIMD_NEON
+#endif
+#endif
+
+#if defined(MLN_JSON_SIMD_SSE2)
+/*
+ * Vectorized scanning stage (enabled by configure --enable-simdjson):
+ * 16 input bytes are classified at once, so whitespace runs and plain
+ * string content are skipped without the per-byte branches of the
+ * recursive scanner. The object model built on top is unchanged.
+ */
+static inline int mln_json_simd_ws_len(mln_u8_t *p)
+{
+    __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+    __m128i m = _mm_or_si128(\
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), \
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))), \
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')), \
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))));
+    int mask = _mm_movemask_epi8(m);
+    if (mask == 0xffff) return 16;
+    return __builtin_ctz(~mask);
+}
+
+static inline int mln_json_simd_str_stop(mln_u8_t *p)
+{
+    __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+    __m128i m = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\"')), \
+                             _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+    int mask = _mm_movemask_epi8(m);
+    if (mask == 0) return 16;
+    return __builtin_ctz(mask);
+}
+#elif defined(MLN_JSON_SIMD_NEON)
+/*same contract as the SSE2 pair; 4 mask bits per byte via vshrn*/
+static inline mln_u64_t mln_json_simd_neon_mask(uint8x16_t m)
+{
+    uint8x8_t n = vshrn_n_u16(vreinterpretq_u16_u8(m), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(n), 0);
+}
+
+static inline int mln_json_simd_ws_len(mln_u8_t *p)
+{
+    uint8x16_t chunk = vld1q_u8(p);
+    uint8x16_t m = vorrq_u8(\
+        vorrq_u8(vceqq_u8(chunk, vdupq_n_u8(' ')), vceqq_u8(chunk, vdupq_n_u8('\t'))), \
+        vorrq_u8(vceqq_u8(chunk, vdupq_n_u8('\r')), vceqq_u8(chunk, vdupq_n_u8('\n'))));
+    mln_u64_t mask = mln_json_simd_neon_mask(m);
+    if (mask == 0xffffffffffffffffULL) return 16;
+    return __builtin_ctzll(~mask) >> 2;
+}
+
+static inline int mln_json_simd_str_stop(mln_u8_t *p)
+{
+    uint8x16_t chunk = vld1q_u8(p);
+    uint8x16_t m = vorrq_u8(vceqq_u8(chunk, vdupq_n_u8('\"')), \
+                            vceqq_u8(chunk, vdupq_n_u8('\\')));
+    mln_u64_t mask = mln_json_simd_neon_mask(m);
+    if (mask == 0) return 16;
+    return __builtin_ctzll(mask) >> 2;
+}
+#else
+#undef MLN_JSON_SIMD
+#endif
+
 static inline mln_json_obj_t *mln_json_obj_new(void);
 static void mln_json_encode_utf8(unsigned int u, mln_u8ptr_t *b, int *count);
 static inline int mln_json_get_char(mln_u8ptr_t *s, int *len, unsigned int *hex);
@@ -17,19 +88,20 @@ static void mln_json_obj_free(void *data);
 static int mln_json_rbtree_cmp(const void *data1, const void *data2);
 static inline void mln_json_jumpoff_blank(char **jstr, int *len);
 static inline int
-mln_json_parse_json(mln_json_t *j, char *jstr, int len, mln_uauto_t index);
+mln_json_parse_json(mln_json_t *j, char *jstr, int len, mln_uauto_t index, int in_situ);
 static inline int
-mln_json_parse_obj(mln_json_t *val, char *jstr, int len, mln_uauto_t index);
+mln_json_parse_obj(mln_json_t *val, char *jstr, int len, mln_uauto_t index, int in_situ);
 static inline int
-mln_json_parse_array(mln_json_t *val, char *jstr, int len, mln_uauto_t index);
+mln_json_parse_array(mln_json_t *val, char *jstr, int len, mln_uauto_t index, int in_situ);
 static inline int
-mln_json_parse_string(mln_json_t *j, char *jstr, int len, mln_uauto_t index);
+mln_json_parse_string(mln_json_t *j, char *jstr, int len, mln_uauto_t index, int in_situ);
 static mln_u8ptr_t
 mln_json_parse_string_fetch(mln_u8ptr_t jstr, int *len);
 static int
 mln_json_parse_digit(mln_json_t *j, char *jstr, int len, mln_uauto_t index);
 static inline int
 mln_json_digit_process(double *val, char *s, int len);
+static inline int mln_json_fmt_number(double num, char *buf);
 static inline int
 mln_json_parse_true(mln_json_t *j, char *jstr, int len, mln_uauto_t index);
 static inline int
@@ -62,7 +134,7 @@ mln_json_t *mln_json_parse(mln_string_t *jstr)
         return NULL;
     }
 
-    if (mln_json_parse_json(j, (char *)(jstr->data), jstr->len, 0) != 0) {
+    if (mln_json_parse_json(j, (char *)(jstr->data), jstr->len, 0, 0) != 0) {
         mln_json_free(j);
         return NULL;
     }
@@ -74,6 +146,58 @@ mln_json_t *mln_json_parse(mln_string_t *jstr)
     return j;
 }
 
+mln_json_t *mln_json_parse_in_situ(mln_string_t *jstr)
+{
+    if (jstr == NULL) {
+        return NULL;
+    }
+
+    mln_json_t *j = mln_json_new();
+    if (j == NULL) {
+        return NULL;
+    }
+
+    if (mln_json_parse_json(j, (char *)(jstr->data), jstr->len, 0, 1) != 0) {
+        mln_json_free(j);
+        return NULL;
+    }
+    if (j->type != M_JSON_OBJECT && j->type != M_JSON_ARRAY) {
+        mln_json_free(j);
+        return NULL;
+    }
+
+    return j;
+}
+
+mln_string_t *mln_json_string_data_get(mln_json_t *j)
+{
+    int count;
+    mln_u8ptr_t buf;
+    mln_string_t *str, *dec;
+
+    if (j->type != M_JSON_STRING) {
+        return NULL;
+    }
+    str = j->data.m_j_string;
+    if (!j->esc || str == NULL) {
+        return str;
+    }
+    count = (int)(str->len);
+    buf = mln_json_parse_string_fetch(str->data, &count);
+    if (buf == NULL) {
+        return NULL;
+    }
+    dec = mln_string_const_ndup((char *)buf, count);
+    free(buf);
+    if (dec == NULL) {
+        return NULL;
+    }
+    mln_string_free(str);
+    j->data.m_j_string = dec;
+    j->esc = 0;
+    return dec;
+}
+
 mln_json_t *mln_json_new(void)
 {
     return (mln_json_t *)calloc(1, sizeof(mln_json_t));
@@ -113,7 +237,7 @@ void mln_json_free(void *json)
 }
 
 static inline int
-mln_json_parse_json(mln_json_t *j, char *jstr, int len, mln_uauto_t index)
+mln_json_parse_json(mln_json_t *j, char *jstr, int len, mln_uauto_t index, int in_situ)
 {
     if (jstr == NULL) {
         return -1;
@@ -128,11 +252,11 @@ mln_json_parse_json(mln_json_t *j, char *jstr, int len, mln_uauto_t index)
 
     switch (jstr[0]) {
         case '{':
-            return mln_json_parse_obj(j, jstr, len, index);
+            return mln_json_parse_obj(j, jstr, len, index, in_situ);
         case '[':
-            return mln_json_parse_array(j, jstr, len, index);
+            return mln_json_parse_array(j, jstr, len, index, in_situ);
         case '\"':
-            return mln_json_parse_string(j, jstr, len, index);
+            return mln_json_parse_string(j, jstr, len, index, in_situ);
         default:
             if (isdigit(jstr[0]) || jstr[0] == '-') {
                 return mln_json_parse_digit(j, jstr, len, index);
@@ -147,7 +271,7 @@ mln_json_parse_json(mln_json_t *j, char *jstr, int len, mln_uauto_t index)
 }
 
 static inline int
-mln_json_parse_obj(mln_json_t *val, char *jstr, int len, mln_uauto_t index)
+mln_json_parse_obj(mln_json_t *val, char *jstr, int len, mln_uauto_t index, int in_situ)
 {
     int left;
     struct mln_hash_attr hattr;
@@ -189,7 +313,7 @@ again:
     }
     mln_json_jumpoff_blank(&jstr, &len);
     if (jstr[0] != '}') {
-        left = mln_json_parse_json(obj->key, jstr, len, 0);
+        left = mln_json_parse_json(obj->key, jstr, len, 0, in_situ);
         if (left <= 0) {
             mln_json_obj_free(obj);
             return -1;
@@ -227,7 +351,7 @@ again:
         if (obj->val == NULL) {
             return -1;
         }
-        left = mln_json_parse_json(obj->val, jstr, len, 0);
+        left = mln_json_parse_json(obj->val, jstr, len, 0, in_situ);
         if (left <= 0) {
             return -1;
         }
@@ -257,7 +381,7 @@ again:
 }
 
 static inline int
-mln_json_parse_array(mln_json_t *val, char *jstr, int len, mln_uauto_t index)
+mln_json_parse_array(mln_json_t *val, char *jstr, int len, mln_uauto_t index, int in_situ)
 {
     int left;
     mln_json_t *j;
@@ -288,7 +412,7 @@ again:
         return -1;
     }
     if (jstr[0] != ']') {
-        left = mln_json_parse_json(j, jstr, len, ++cnt);
+        left = mln_json_parse_json(j, jstr, len, ++cnt, in_situ);
         if (left <= 0) {
             mln_json_free(j);
             return -1;
@@ -331,9 +455,9 @@ again:
 }
 
 static inline int
-mln_json_parse_string(mln_json_t *j, char *jstr, int len, mln_uauto_t index)
+mln_json_parse_string(mln_json_t *j, char *jstr, int len, mln_uauto_t index, int in_situ)
 {
-    mln_u8_t *p, flag = 0;
+    mln_u8_t *p, flag = 0, esc = 0;
     int plen, count = 0;
     mln_string_t *str;
     mln_u8ptr_t buf;
@@ -343,28 +467,54 @@ mln_json_parse_string(mln_json_t *j, char *jstr, int len, mln_uauto_t index)
         return -1;
     }
 
-    for (p = (mln_u8ptr_t)jstr, plen = len; plen > 0; ++p, ++count, --plen) {
+    p = (mln_u8ptr_t)jstr;
+    plen = len;
+    while (plen > 0) {
+#if defined(MLN_JSON_SIMD)
+        /*bulk-skip content bytes that are neither quote nor escape*/
+        if (!flag && plen >= 16) {
+            int n = mln_json_simd_str_stop(p);
+            if (n > 0) {
+                p += n;
+                count += n;
+                plen -= n;
+                continue;
+            }
+        }
+#endif
         if (!flag && *p == (mln_u8_t)'\\') {
-            flag = 1;
+            flag = esc = 1;
         } else {
             if (*p == (mln_u8_t)'\"' && (p == (mln_u8ptr_t)jstr || !flag))
                 break;
             if (flag) flag = 0;
         }
+        ++p;
+        ++count;
+        --plen;
     }
     if (plen <= 0) {
         return -1;
     }
 
-    buf = mln_json_parse_string_fetch((mln_u8ptr_t)jstr, &count);
-    if (buf == NULL) {
-        return -1;
-    }
+    if (in_situ) {
+        /*borrow the raw slice; escapes are resolved on first access*/
+        if ((str = (mln_string_t *)malloc(sizeof(mln_string_t))) == NULL) {
+            return -1;
+        }
+        mln_string_nset(str, jstr, count);
+        j->esc = esc;
+    } else {
+        buf = mln_json_parse_string_fetch((mln_u8ptr_t)jstr, &count);
+        if (buf == NULL) {
+            return -1;
+        }
 
-    str = mln_string_const_ndup((char *)buf, count);
-    free(buf);
-    if (str == NULL) {
-        return -1;
+        str = mln_string_const_ndup((char *)buf, count);
+        free(buf);
+        if (str == NULL) {
+            return -1;
+        }
     }
 
     j->index = index;
@@ -500,6 +650,318 @@ static inline int mln_json_get_char(mln_u8ptr_t *s, int *len, unsigned int *hex)
     return *((*s)++);
 }
 
+/*
+ * fast number formatting & parsing
+ * snprintf()/libc double handling dominates encode time for numeric
+ * payloads, so integers go through a two-digit-table itoa and doubles
+ * through a Grisu2 shortest-round-trip formatter (cached powers of ten,
+ * 64-bit significands). The decode side mirrors it: digits accumulate
+ * in a 64-bit mantissa and are scaled by an exact power-of-ten table,
+ * falling back to strtod() only when that cannot be exact.
+ */
+static const char mln_json_digit_pairs[] = \
+    "0001020304050607080910111213141516171819" \
+    "2021222324252627282930313233343536373839" \
+    "4041424344454647484950515253545556575859" \
+    "6061626364656667686970717273747576777879" \
+    "8081828384858687888990919293949596979899";
+
+static const double mln_json_exact_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const mln_u64_t mln_json_pow_cache_f[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL, 0xcf42894a5dce35eaULL,
+    0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL, 0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL,
+    0xbe5691ef416bd60cULL, 0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL, 0xc21094364dfb5637ULL,
+    0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL, 0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL,
+    0xb23867fb2a35b28eULL, 0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL, 0xb5b5ada8aaff80b8ULL,
+    0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL, 0x964e858c91ba2655ULL, 0xdff9772470297ebdULL,
+    0xa6dfbd9fb8e5b88fULL, 0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL, 0xaa242499697392d3ULL,
+    0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL, 0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL,
+    0x9c40000000000000ULL, 0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL, 0x9f4f2726179a2245ULL,
+    0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL, 0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL,
+    0x924d692ca61be758ULL, 0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL, 0x952ab45cfa97a0b3ULL,
+    0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL, 0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL,
+    0x88fcf317f22241e2ULL, 0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL, 0x8bab8eefb6409c1aULL,
+    0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL, 0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL,
+    0x80444b5e7aa7cf85ULL, 0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+static const mln_s16_t mln_json_pow_cache_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066,
+};
+
+static inline int mln_json_fmt_u64(mln_u64_t v, char *buf)
+{
+    char tmp[20];
+    char *p = tmp + sizeof(tmp);
+    int n;
+
+    while (v >= 100) {
+        n = (v % 100) << 1;
+        v /= 100;
+        *--p = mln_json_digit_pairs[n+1];
+        *--p = mln_json_digit_pairs[n];
+    }
+    if (v >= 10) {
+        n = v << 1;
+        *--p = mln_json_digit_pairs[n+1];
+        *--p = mln_json_digit_pairs[n];
+    } else {
+        *--p = '0' + v;
+    }
+    n = tmp + sizeof(tmp) - p;
+    memcpy(buf, p, n);
+    return n;
+}
+
+static inline int mln_json_fmt_int(mln_s64_t value, char *buf)
+{
+    if (value < 0) {
+        *buf = '-';
+        return mln_json_fmt_u64(-(mln_u64_t)value, buf + 1) + 1;
+    }
+    return mln_json_fmt_u64((mln_u64_t)value, buf);
+}
+
+typedef struct {
+    mln_u64_t f;
+    int       e;
+} mln_json_diyfp_t;
+
+static inline mln_json_diyfp_t mln_json_diyfp_from_double(double d)
+{
+    mln_json_diyfp_t r;
+    mln_u64_t bits, sig;
+    int exp;
+
+    memcpy(&bits, &d, sizeof(bits));
+    sig = bits & 0xfffffffffffffULL;
+    exp = (int)((bits >> 52) & 0x7ff);
+    if (exp != 0) {
+        r.f = sig + 0x10000000000000ULL;
+        r.e = exp - 1075;
+    } else {
+        r.f = sig;
+        r.e = -1074;
+    }
+    return r;
+}
+
+static inline mln_json_diyfp_t mln_json_diyfp_mul(mln_json_diyfp_t x, mln_json_diyfp_t y)
+{
+    mln_json_diyfp_t r;
+    mln_u64_t a = x.f >> 32, b = x.f & 0xffffffffULL;
+    mln_u64_t c = y.f >> 32, d = y.f & 0xffffffffULL;
+    mln_u64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    mln_u64_t tmp = (bd >> 32) + (ad & 0xffffffffULL) + (bc & 0xffffffffULL) + (1ULL << 31);
+
+    r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+    r.e = x.e + y.e + 64;
+    return r;
+}
+
+static inline mln_json_diyfp_t mln_json_diyfp_normalize(mln_json_diyfp_t v)
+{
+    while (!(v.f & 0x10000000000000ULL)) {
+        v.f <<= 1;
+        --(v.e);
+    }
+    v.f <<= 11;
+    v.e -= 11;
+    return v;
+}
+
+static inline void
+mln_json_diyfp_boundaries(mln_json_diyfp_t v, mln_json_diyfp_t *minus, mln_json_diyfp_t *plus)
+{
+    mln_json_diyfp_t pl, mi;
+
+    pl.f = (v.f << 1) + 1;
+    pl.e = v.e - 1;
+    while (!(pl.f & 0x20000000000000ULL)) {
+        pl.f <<= 1;
+        --(pl.e);
+    }
+    pl.f <<= 10;
+    pl.e -= 10;
+    if (v.f == 0x10000000000000ULL) {
+        mi.f = (v.f << 2) - 1;
+        mi.e = v.e - 2;
+    } else {
+        mi.f = (v.f << 1) - 1;
+        mi.e = v.e - 1;
+    }
+    mi.f <<= mi.e - pl.e;
+    mi.e = pl.e;
+    *minus = mi;
+    *plus = pl;
+}
+
+static inline mln_json_diyfp_t mln_json_cached_power(int e, int *K)
+{
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = (int)dk;
+    unsigned int index;
+    mln_json_diyfp_t r;
+
+    if (dk - k > 0.0) ++k;
+    index = (unsigned int)((k >> 3) + 1);
+    *K = -(-348 + (int)(index << 3));
+    r.f = mln_json_pow_cache_f[index];
+    r.e = mln_json_pow_cache_e[index];
+    return r;
+}
+
+static inline void
+mln_json_grisu_round(char *buffer, int len, mln_u64_t delta, mln_u64_t rest, \
+                     mln_u64_t ten_kappa, mln_u64_t wp_w)
+{
+    while (rest < wp_w && delta - rest >= ten_kappa && \
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w))
+    {
+        --buffer[len-1];
+        rest += ten_kappa;
+    }
+}
+
+static inline int
+mln_json_grisu_digit_gen(mln_json_diyfp_t w, mln_json_diyfp_t mp, \
+                         mln_u64_t delta, char *buffer, int *K)
+{
+    static const mln_u32_t pow10[] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+    };
+    mln_u64_t one_f = 1ULL << -mp.e, wp_w = mp.f - w.f, tmp;
+    mln_u32_t p1 = (mln_u32_t)(mp.f >> -mp.e), d;
+    mln_u64_t p2 = mp.f & (one_f - 1);
+    int kappa, len = 0;
+
+    for (kappa = 1; kappa < 10 && p1 >= pow10[kappa]; ++kappa)
+        ;
+    while (kappa > 0) {
+        d = p1 / pow10[kappa-1];
+        p1 %= pow10[kappa-1];
+        if (d || len) buffer[len++] = '0' + d;
+        --kappa;
+        tmp = ((mln_u64_t)p1 << -mp.e) + p2;
+        if (tmp <= delta) {
+            *K += kappa;
+            mln_json_grisu_round(buffer, len, delta, tmp, (mln_u64_t)pow10[kappa] << -mp.e, wp_w);
+            return len;
+        }
+    }
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        d = (mln_u32_t)(p2 >> -mp.e);
+        if (d || len) buffer[len++] = '0' + d;
+        p2 &= one_f - 1;
+        --kappa;
+        if (p2 < delta) {
+            *K += kappa;
+            mln_json_grisu_round(buffer, len, delta, p2, one_f, \
+                                 -kappa < 10? wp_w * pow10[-kappa]: 0);
+            return len;
+        }
+    }
+}
+
+static inline int mln_json_grisu2(double value, char *buffer, int *K)
+{
+    mln_json_diyfp_t v = mln_json_diyfp_from_double(value);
+    mln_json_diyfp_t w_m, w_p, c_mk, w0, wp, wm;
+
+    mln_json_diyfp_boundaries(v, &w_m, &w_p);
+    c_mk = mln_json_cached_power(w_p.e, K);
+    w0 = mln_json_diyfp_mul(mln_json_diyfp_normalize(v), c_mk);
+    wp = mln_json_diyfp_mul(w_p, c_mk);
+    wm = mln_json_diyfp_mul(w_m, c_mk);
+    ++(wm.f);
+    --(wp.f);
+    return mln_json_grisu_digit_gen(w0, wp, wp.f - wm.f, buffer, K);
+}
+
+static inline int mln_json_fmt_double(double value, char *buf)
+{
+    char digits[18], *p = buf;
+    int len, K = 0, kk, i;
+
+    if (value == 0) {
+        *p = '0';
+        return 1;
+    }
+    if (value < 0) {
+        *p++ = '-';
+        value = -value;
+    }
+    len = mln_json_grisu2(value, digits, &K);
+    kk = len + K; /* 10^(kk-1) <= value < 10^kk */
+    if (len <= kk && kk <= 21) {
+        /* trailing zeros only */
+        memcpy(p, digits, len);
+        for (i = len; i < kk; ++i) p[i] = '0';
+        p += kk;
+    } else if (0 < kk && kk <= 21) {
+        /* decimal point inside the digit run */
+        memcpy(p, digits, kk);
+        p += kk;
+        *p++ = '.';
+        memcpy(p, digits+kk, len-kk);
+        p += len - kk;
+    } else if (-6 < kk && kk <= 0) {
+        /* leading zeros after the point */
+        *p++ = '0';
+        *p++ = '.';
+        for (i = 0; i < -kk; ++i) *p++ = '0';
+        memcpy(p, digits, len);
+        p += len;
+    } else {
+        /* exponential */
+        *p++ = digits[0];
+        if (len > 1) {
+            *p++ = '.';
+            memcpy(p, digits+1, len-1);
+            p += len - 1;
+        }
+        *p++ = 'e';
+        kk -= 1;
+        if (kk < 0) {
+            *p++ = '-';
+            kk = -kk;
+        }
+        p += mln_json_fmt_u64((mln_u64_t)kk, p);
+    }
+    return p - buf;
+}
+
+static inline int mln_json_fmt_number(double num, char *buf)
+{
+    mln_u64_t bits;
+
+    if (num >= -9007199254740992.0 && num <= 9007199254740992.0 && (mln_s64_t)num == num)
+        return mln_json_fmt_int((mln_s64_t)num, buf);
+    memcpy(&bits, &num, sizeof(bits));
+    if (((bits >> 52) & 0x7ff) == 0x7ff) /* nan/inf keep the old rendering */
+        return snprintf(buf, 32, "%f", num);
+    return mln_json_fmt_double(num, buf);
+}
+
 static int
 mln_json_parse_digit(mln_json_t *j, char *jstr, int len, mln_uauto_t index)
 {
@@ -526,11 +988,41 @@ mln_json_parse_digit(mln_json_t *j, char *jstr, int len, mln_uauto_t index)
     return left;
 }
 
+static inline void
+mln_json_digit_assemble(double *val, mln_u64_t mant, int exp, int dropped, char *tok, char *end)
+{
+    char stack_buf[64], *buf = stack_buf;
+    mln_size_t toklen;
+
+    if (!dropped && mant <= 9007199254740992ULL && exp >= -22 && exp <= 22) {
+        /* both factors exact, one rounding: correctly rounded result */
+        if (exp >= 0) *val = (double)mant * mln_json_exact_pow10[exp];
+        else *val = (double)mant / mln_json_exact_pow10[-exp];
+        return;
+    }
+    toklen = end - tok;
+    if (toklen >= sizeof(stack_buf)) {
+        buf = (char *)malloc(toklen + 1);
+        if (buf == NULL) { /* out of memory: settle for the inexact product */
+            double f = (double)mant;
+            while (exp > 22) { f *= 1e22; exp -= 22; }
+            while (exp < -22) { f /= 1e22; exp += 22; }
+            *val = exp >= 0? f * mln_json_exact_pow10[exp]: f / mln_json_exact_pow10[-exp];
+            return;
+        }
+    }
+    memcpy(buf, tok, toklen);
+    buf[toklen] = 0;
+    *val = strtod(buf, NULL);
+    if (buf != stack_buf) free(buf);
+}
+
 static inline int
 mln_json_digit_process(double *val, char *s, int len)
 {
-    double f = 0;
-    int i, j, dir = 1;
+    mln_u64_t mant = 0;
+    int i, dir = 1, ndig = 0, exp = 0, dropped = 0;
+    char *begin = s;
 
     if (!isdigit(*s)) return -1;
 
@@ -541,24 +1033,37 @@ mln_json_digit_process(double *val, char *s, int len)
     } else {
         for (; len > 0; --len, ++s) {
             if (!isdigit(*s)) break;
-            (*val) *= 10;
-            (*val) += (*s - '0');
+            if (ndig < 19) {
+                mant = mant * 10 + (*s - '0');
+                ++ndig;
+            } else {
+                ++exp;
+                dropped = 1;
+            }
+        }
+        if (len <= 0) {
+            mln_json_digit_assemble(val, mant, exp, dropped, begin, s);
+            return 0;
         }
-        if (len <= 0) return 0;
     }
 
     if (*s == '.') {
         ++s;
         if (--len <= 0) return -1;
-        for (i = 1; len > 0; --len, ++s, ++i) {
+        for (; len > 0; --len, ++s) {
             if (!isdigit(*s)) break;
-            f = *s - '0';
-            for (j = 0; j < i; ++j) {
-                f /= 10;
+            if (ndig < 19) {
+                mant = mant * 10 + (*s - '0');
+                ++ndig;
+                --exp;
+            } else {
+                dropped = 1;
             }
-            *val += f;
         }
-        if (len <= 0) return 0;
+        if (len <= 0) {
+            mln_json_digit_assemble(val, mant, exp, dropped, begin, s);
+            return 0;
+        }
     }
 
     if (*s == 'e' || *s == 'E') {
@@ -567,27 +1072,30 @@ mln_json_digit_process(double *val, char *s, int len)
 
         if (*s == '+') {
             ++s;
-            if (--len <= 0) return 0;
+            if (--len <= 0) {
+                mln_json_digit_assemble(val, mant, exp, dropped, begin, s);
+                return 0;
+            }
         } else if (*s == '-') {
             dir = 0;
             ++s;
-            if (--len <= 0) return 0;
+            if (--len <= 0) {
+                mln_json_digit_assemble(val, mant, exp, dropped, begin, s);
+                return 0;
+            }
         }
 
         for (i = 0; len > 0; --len, ++s) {
             if (!isdigit(*s)) break;
-            i *= 10;
-            i += (*s - '0');
-        }
-        if (i == 0) return len;
-
-        for (f = 1, j = 0; j < i; ++j) {
-            if (dir) f *= 10;
-            else f /= 10;
+            if (i < 100000) {
+                i *= 10;
+                i += (*s - '0');
+            }
         }
-        (*val) *= f;
+        exp += dir? i: -i;
     }
 
+    mln_json_digit_assemble(val, mant, exp, dropped, begin, s);
     return len;
 }
 
@@ -657,13 +1165,125 @@ mln_string_t *mln_json_generate(mln_json_t *j)
     n = mln_json_write_content(j, buf);
     buf[n] = 0;
 
-    s = mln_string_const_ndup(buf, n);
-    free(buf);
-    if (s == NULL) return NULL;
+    /*hand the buffer to the string instead of copying it again*/
+    s = mln_string_buf_new((mln_u8ptr_t)buf, n);
+    if (s == NULL) {
+        free(buf);
+        return NULL;
+    }
 
     return s;
 }
 
+static inline mln_size_t mln_json_encode_length_calc(mln_json_t *j);
+
+static int mln_json_encode_length_hash_handler(void *key, void *val, void *data)
+{
+    mln_json_obj_t *obj = (mln_json_obj_t *)val;
+    mln_size_t *length = (mln_size_t *)data;
+
+    if (obj == NULL) return 0;
+    if (obj->key != NULL) (*length) += mln_json_encode_length_calc(obj->key);
+    if (obj->val != NULL) (*length) += mln_json_encode_length_calc(obj->val);
+    (*length) += 2; /*colon and comma*/
+    return 0;
+}
+
+static int mln_json_encode_length_rbtree_handler(mln_rbtree_node_t *node, void *data)
+{
+    mln_json_t *j = (mln_json_t *)mln_rbtree_node_data_get(node);
+    mln_size_t *length = (mln_size_t *)data;
+
+    if (j == NULL) return 0;
+    (*length) += (mln_json_encode_length_calc(j) + 1);
+    return 0;
+}
+
+static inline mln_size_t mln_json_encode_length_calc(mln_json_t *j)
+{
+    char num_str[512];
+    mln_size_t length = 0, save;
+    mln_u8ptr_t p, end;
+
+    if (j == NULL) return 0;
+
+    switch (j->type) {
+        case M_JSON_OBJECT:
+            length = 2;
+            save = length;
+            if (j->data.m_j_obj != NULL)
+                mln_hash_iterate(j->data.m_j_obj, mln_json_encode_length_hash_handler, &length);
+            if (length > save) --length; /*no comma after the last member*/
+            break;
+        case M_JSON_ARRAY:
+            length = 2;
+            save = length;
+            if (j->data.m_j_array != NULL)
+                mln_rbtree_iterate(j->data.m_j_array, mln_json_encode_length_rbtree_handler, &length);
+            if (length > save) --length;
+            break;
+        case M_JSON_STRING:
+            length = 2;
+            if (j->data.m_j_string != NULL) {
+                p = j->data.m_j_string->data;
+                end = p + j->data.m_j_string->len;
+                for (; p < end; ++p) {
+                    if (*p == '\"' || *p == '\\')
+                        ++length;
+                }
+                length += j->data.m_j_string->len;
+            }
+            break;
+        case M_JSON_NUM:
+            length = mln_json_fmt_number(j->data.m_j_number, num_str);
+            break;
+        case M_JSON_TRUE:
+            length = 4;
+            break;
+        case M_JSON_FALSE:
+            length = 5;
+            break;
+        case M_JSON_NULL:
+            length = 4;
+            break;
+        default:
+            break;
+    }
+
+    return length;
+}
+
+mln_size_t mln_json_encode_length(mln_json_t *j)
+{
+    return mln_json_encode_length_calc(j);
+}
+
+mln_chain_t *mln_json_generate_buf(mln_json_t *j, mln_alloc_t *pool)
+{
+    mln_size_t size = mln_json_encode_length_calc(j), n;
+    mln_chain_t *c;
+    mln_buf_t *b;
+    mln_u8ptr_t buf;
+
+    if ((c = mln_chain_new(pool)) == NULL) return NULL;
+    if ((b = mln_buf_new(pool)) == NULL) {
+        mln_chain_pool_release(c);
+        return NULL;
+    }
+    c->buf = b;
+    if ((buf = (mln_u8ptr_t)mln_alloc_m(pool, size)) == NULL) {
+        mln_chain_pool_release(c);
+        return NULL;
+    }
+    n = mln_json_write_content(j, (mln_s8ptr_t)buf);
+    b->left_pos = b->pos = b->start = buf;
+    b->last = b->end = buf + n;
+    b->in_memory = 1;
+    b->last_buf = 1;
+    b->last_in_chain = 1;
+    return c;
+}
+
 struct mln_json_tmp_s {
     mln_size_t  *length;
     mln_s8ptr_t *buf;
@@ -736,22 +1356,10 @@ mln_json_write_content(mln_json_t *j, mln_s8ptr_t buf)
             ++length;
             break;
         case M_JSON_NUM:
-        {
-            mln_s64_t i = (mln_s64_t)(j->data.m_j_number);
-            if (i == j->data.m_j_number)
-#if defined(WIN32)
-                n = snprintf(buf, 512, "%I64d", i);
-#elif defined(i386) || defined(__arm__) || defined(__wasm__)
-                n = snprintf(buf, 512, "%lld", i);
-#else
-                n = snprintf(buf, 512, "%ld", i);
-#endif
-            else
-                n = snprintf(buf, 512, "%f", j->data.m_j_number);
+            n = mln_json_fmt_number(j->data.m_j_number, buf);
             buf += n;
             length += n;
             break;
-        }
         case M_JSON_TRUE:
             memcpy(buf, "true", 4);
             buf += 4;
@@ -858,7 +1466,7 @@ static inline mln_size_t mln_json_get_length(mln_json_t *j)
             }
             break;
         case M_JSON_NUM:
-            length += snprintf(num_str, sizeof(num_str), "%f", j->data.m_j_number);
+            length += mln_json_fmt_number(j->data.m_j_number, num_str);
             break;
         case M_JSON_TRUE:
             length += 4;
@@ -969,6 +1577,14 @@ static int mln_json_rbtree_cmp(const void *data1, const void *data2)
 
 static inline void mln_json_jumpoff_blank(char **jstr, int *len)
 {
+#if defined(MLN_JSON_SIMD)
+    while (*len >= 16) {
+        int n = mln_json_simd_ws_len((mln_u8_t *)(*jstr));
+        (*jstr) += n;
+        (*len) -= n;
+        if (n < 16) return;
+    }
+#endif
     for (; \
          *len > 0 && (*jstr[0] == ' ' || *jstr[0] == '\t' || *jstr[0] == '\r' || *jstr[0] == '\n'); \
          ++(*jstr), --(*len))
@@ -1293,3 +1909,768 @@ mln_json_t *mln_json_element_remove(mln_json_t *j, mln_uauto_t index)
     return val;
 }
 
+/*
+ * SAX push parser
+ */
+#define M_JSON_SAX_TOK_NONE     0
+#define M_JSON_SAX_TOK_STRING   1
+#define M_JSON_SAX_TOK_ESC      2
+#define M_JSON_SAX_TOK_NUMBER   3
+#define M_JSON_SAX_TOK_LITERAL  4
+
+#define M_JSON_SAX_STATE_VALUE  0
+#define M_JSON_SAX_STATE_KEY    1
+#define M_JSON_SAX_STATE_COLON  2
+#define M_JSON_SAX_STATE_NEXT   3
+#define M_JSON_SAX_STATE_DONE   4
+
+mln_json_sax_t *mln_json_sax_new(mln_json_sax_handler handler, void *udata)
+{
+    mln_json_sax_t *ctx;
+
+    if (handler == NULL) return NULL;
+    ctx = (mln_json_sax_t *)calloc(1, sizeof(mln_json_sax_t));
+    if (ctx == NULL) return NULL;
+    ctx->handler = handler;
+    ctx->udata = udata;
+    ctx->state = M_JSON_SAX_STATE_VALUE;
+    ctx->tok = M_JSON_SAX_TOK_NONE;
+    return ctx;
+}
+
+void mln_json_sax_free(mln_json_sax_t *ctx)
+{
+    if (ctx == NULL) return;
+    if (ctx->save != NULL) free(ctx->save);
+    if (ctx->stack != NULL) free(ctx->stack);
+    free(ctx);
+}
+
+static inline int mln_json_sax_save_append(mln_json_sax_t *ctx, mln_u8ptr_t buf, mln_size_t len)
+{
+    mln_u8ptr_t tmp;
+    mln_size_t size = ctx->save_size;
+
+    if (ctx->save_len + len > size) {
+        if (size == 0) size = 64;
+        while (ctx->save_len + len > size) size <<= 1;
+        tmp = (mln_u8ptr_t)realloc(ctx->save, size);
+        if (tmp == NULL) return -1;
+        ctx->save = tmp;
+        ctx->save_size = size;
+    }
+    memcpy(ctx->save + ctx->save_len, buf, len);
+    ctx->save_len += len;
+    return 0;
+}
+
+static inline int mln_json_sax_emit(mln_json_sax_t *ctx, \
+                                    enum mln_json_sax_event event, \
+                                    mln_string_t *text, \
+                                    double num)
+{
+    if (ctx->handler(ctx, event, text, num, ctx->udata) < 0) {
+        ctx->error = 1;
+        return -1;
+    }
+    return 0;
+}
+
+static inline int mln_json_sax_push(mln_json_sax_t *ctx, mln_u8_t c)
+{
+    mln_u8ptr_t tmp;
+    mln_u32_t size = ctx->stack_size;
+
+    if (ctx->depth == size) {
+        size = size == 0? 32: size << 1;
+        tmp = (mln_u8ptr_t)realloc(ctx->stack, size);
+        if (tmp == NULL) return -1;
+        ctx->stack = tmp;
+        ctx->stack_size = size;
+    }
+    ctx->stack[ctx->depth++] = c;
+    return 0;
+}
+
+static inline void mln_json_sax_value_done(mln_json_sax_t *ctx)
+{
+    if (ctx->depth == 0) {
+        ctx->state = M_JSON_SAX_STATE_DONE;
+        ctx->done = 1;
+    } else {
+        ctx->state = M_JSON_SAX_STATE_NEXT;
+    }
+}
+
+static inline int mln_json_sax_pop_emit(mln_json_sax_t *ctx)
+{
+    mln_u8_t c = ctx->stack[--(ctx->depth)];
+    if (mln_json_sax_emit(ctx, \
+                          c == 'o'? M_JSON_SAX_OBJ_END: M_JSON_SAX_ARRAY_END, \
+                          NULL, 0) < 0)
+        return -1;
+    mln_json_sax_value_done(ctx);
+    return 0;
+}
+
+static inline int mln_json_sax_string_done(mln_json_sax_t *ctx)
+{
+    int count, is_key = ctx->state == M_JSON_SAX_STATE_KEY;
+    mln_u8ptr_t buf = NULL;
+    mln_string_t text;
+
+    if (ctx->tok_esc) {
+        count = (int)(ctx->save_len);
+        buf = mln_json_parse_string_fetch(ctx->save, &count);
+        if (buf == NULL) {
+            ctx->error = 1;
+            return -1;
+        }
+        mln_string_nset(&text, buf, count);
+    } else {
+        mln_string_nset(&text, ctx->save, ctx->save_len);
+    }
+    if (mln_json_sax_emit(ctx, is_key? M_JSON_SAX_KEY: M_JSON_SAX_STRING, &text, 0) < 0) {
+        if (buf != NULL) free(buf);
+        return -1;
+    }
+    if (buf != NULL) free(buf);
+    ctx->save_len = 0;
+    ctx->tok_esc = 0;
+    if (is_key) ctx->state = M_JSON_SAX_STATE_COLON;
+    else mln_json_sax_value_done(ctx);
+    return 0;
+}
+
+static inline int mln_json_sax_number_done(mln_json_sax_t *ctx)
+{
+    int sub_flag = 0;
+    char *s = (char *)(ctx->save);
+    int len = (int)(ctx->save_len);
+    double val = 0;
+
+    if (len > 0 && s[0] == '-') {
+        sub_flag = 1;
+        ++s;
+        --len;
+    }
+    if (len <= 0 || mln_json_digit_process(&val, s, len) != 0) {
+        ctx->error = 1;
+        return -1;
+    }
+    if (mln_json_sax_emit(ctx, M_JSON_SAX_NUMBER, NULL, sub_flag? -val: val) < 0)
+        return -1;
+    ctx->save_len = 0;
+    mln_json_sax_value_done(ctx);
+    return 0;
+}
+
+static inline int mln_json_sax_literal_done(mln_json_sax_t *ctx)
+{
+    char *s = (char *)(ctx->save);
+    enum mln_json_sax_event event;
+
+    if (ctx->save_len == 4 && !strncasecmp(s, "true", 4)) {
+        event = M_JSON_SAX_TRUE;
+    } else if (ctx->save_len == 5 && !strncasecmp(s, "false", 5)) {
+        event = M_JSON_SAX_FALSE;
+    } else if (ctx->save_len == 4 && !strncasecmp(s, "null", 4)) {
+        event = M_JSON_SAX_NULL;
+    } else {
+        ctx->error = 1;
+        return -1;
+    }
+    if (mln_json_sax_emit(ctx, event, NULL, 0) < 0) return -1;
+    ctx->save_len = 0;
+    mln_json_sax_value_done(ctx);
+    return 0;
+}
+
+static inline int mln_json_sax_dispatch(mln_json_sax_t *ctx, mln_u8_t c)
+{
+    switch (ctx->state) {
+        case M_JSON_SAX_STATE_VALUE:
+            if (c == '{') {
+                if (mln_json_sax_push(ctx, 'o') < 0) break;
+                if (mln_json_sax_emit(ctx, M_JSON_SAX_OBJ_START, NULL, 0) < 0) return -1;
+                ctx->state = M_JSON_SAX_STATE_KEY;
+                return 0;
+            }
+            if (c == '[') {
+                if (mln_json_sax_push(ctx, 'a') < 0) break;
+                if (mln_json_sax_emit(ctx, M_JSON_SAX_ARRAY_START, NULL, 0) < 0) return -1;
+                return 0;
+            }
+            if (c == ']' && ctx->depth > 0 && ctx->stack[ctx->depth-1] == 'a')
+                return mln_json_sax_pop_emit(ctx);
+            if (c == '\"') {
+                ctx->tok = M_JSON_SAX_TOK_STRING;
+                return 0;
+            }
+            if (c == '-' || isdigit(c)) {
+                ctx->tok = M_JSON_SAX_TOK_NUMBER;
+                return mln_json_sax_save_append(ctx, &c, 1) < 0? -1: 0;
+            }
+            if (isalpha(c)) {
+                ctx->tok = M_JSON_SAX_TOK_LITERAL;
+                return mln_json_sax_save_append(ctx, &c, 1) < 0? -1: 0;
+            }
+            break;
+        case M_JSON_SAX_STATE_KEY:
+            if (c == '\"') {
+                ctx->tok = M_JSON_SAX_TOK_STRING;
+                return 0;
+            }
+            if (c == '}' && ctx->depth > 0 && ctx->stack[ctx->depth-1] == 'o')
+                return mln_json_sax_pop_emit(ctx);
+            break;
+        case M_JSON_SAX_STATE_COLON:
+            if (c == ':') {
+                ctx->state = M_JSON_SAX_STATE_VALUE;
+                return 0;
+            }
+            break;
+        case M_JSON_SAX_STATE_NEXT:
+            if (c == ',') {
+                ctx->state = ctx->stack[ctx->depth-1] == 'o'? \
+                                 M_JSON_SAX_STATE_KEY: M_JSON_SAX_STATE_VALUE;
+                return 0;
+            }
+            if (c == '}' && ctx->stack[ctx->depth-1] == 'o')
+                return mln_json_sax_pop_emit(ctx);
+            if (c == ']' && ctx->stack[ctx->depth-1] == 'a')
+                return mln_json_sax_pop_emit(ctx);
+            break;
+        default: /*M_JSON_SAX_STATE_DONE*/
+            break;
+    }
+    ctx->error = 1;
+    return -1;
+}
+
+int mln_json_sax_feed(mln_json_sax_t *ctx, mln_u8ptr_t buf, mln_size_t len)
+{
+    mln_u8_t c;
+    mln_u8ptr_t p = buf, q, end;
+
+    if (ctx->error) return -1;
+
+    while (len > 0) {
+        switch (ctx->tok) {
+            case M_JSON_SAX_TOK_STRING:
+                end = p + len;
+                for (q = p; q < end && *q != (mln_u8_t)'\"' && *q != (mln_u8_t)'\\'; ++q)
+                    ;
+                if (q > p && mln_json_sax_save_append(ctx, p, q - p) < 0) {
+                    ctx->error = 1;
+                    return -1;
+                }
+                len -= q - p;
+                p = q;
+                if (len == 0) break;
+                if (*p == (mln_u8_t)'\\') {
+                    ctx->tok_esc = 1;
+                    if (mln_json_sax_save_append(ctx, p, 1) < 0) {
+                        ctx->error = 1;
+                        return -1;
+                    }
+                    ctx->tok = M_JSON_SAX_TOK_ESC;
+                } else {
+                    ctx->tok = M_JSON_SAX_TOK_NONE;
+                    if (mln_json_sax_string_done(ctx) < 0) return -1;
+                }
+                ++p;
+                --len;
+                break;
+            case M_JSON_SAX_TOK_ESC:
+                if (mln_json_sax_save_append(ctx, p, 1) < 0) {
+                    ctx->error = 1;
+                    return -1;
+                }
+                ctx->tok = M_JSON_SAX_TOK_STRING;
+                ++p;
+                --len;
+                break;
+            case M_JSON_SAX_TOK_NUMBER:
+                end = p + len;
+                for (q = p; \
+                     q < end && (isdigit(*q) || *q == (mln_u8_t)'.' || *q == (mln_u8_t)'e' || \
+                                 *q == (mln_u8_t)'E' || *q == (mln_u8_t)'+' || *q == (mln_u8_t)'-'); \
+                     ++q)
+                    ;
+                if (q > p && mln_json_sax_save_append(ctx, p, q - p) < 0) {
+                    ctx->error = 1;
+                    return -1;
+                }
+                len -= q - p;
+                p = q;
+                if (len == 0) break;
+                ctx->tok = M_JSON_SAX_TOK_NONE;
+                if (mln_json_sax_number_done(ctx) < 0) return -1;
+                break;
+            case M_JSON_SAX_TOK_LITERAL:
+                end = p + len;
+                for (q = p; q < end && isalpha(*q); ++q)
+                    ;
+                if (q > p && mln_json_sax_save_append(ctx, p, q - p) < 0) {
+                    ctx->error = 1;
+                    return -1;
+                }
+                len -= q - p;
+                p = q;
+                if (len == 0) break;
+                ctx->tok = M_JSON_SAX_TOK_NONE;
+                if (mln_json_sax_literal_done(ctx) < 0) return -1;
+                break;
+            default: /*M_JSON_SAX_TOK_NONE*/
+                c = *p;
+                if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                    ++p;
+                    --len;
+                    break;
+                }
+                if (mln_json_sax_dispatch(ctx, c) < 0) return -1;
+                ++p;
+                --len;
+                break;
+        }
+    }
+    return ctx->done? 1: 0;
+}
+
+int mln_json_sax_finish(mln_json_sax_t *ctx)
+{
+    if (ctx->error) return -1;
+    if (ctx->tok == M_JSON_SAX_TOK_NUMBER) {
+        ctx->tok = M_JSON_SAX_TOK_NONE;
+        if (mln_json_sax_number_done(ctx) < 0) return -1;
+    } else if (ctx->tok == M_JSON_SAX_TOK_LITERAL) {
+        ctx->tok = M_JSON_SAX_TOK_NONE;
+        if (mln_json_sax_literal_done(ctx) < 0) return -1;
+    } else if (ctx->tok != M_JSON_SAX_TOK_NONE) {
+        ctx->error = 1;
+        return -1;
+    }
+    if (!ctx->done || ctx->depth != 0) {
+        ctx->error = 1;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * streaming generate
+ */
+#define M_JSON_CHAIN_ALLOC_SIZE 4096
+
+struct mln_json_chain_s {
+    mln_alloc_t *pool;
+    mln_chain_t *head;
+    mln_chain_t *tail;
+    mln_u8ptr_t  pos;
+    mln_size_t   left_size;
+    mln_size_t   written;
+};
+
+static int mln_json_write_content_chain(mln_json_t *j, struct mln_json_chain_s *hc);
+static int
+mln_json_write_content_chain_hash_iterate_handler(void *key, void *val, void *data);
+static int
+mln_json_write_content_chain_rbtree_iterate_handler(mln_rbtree_node_t *node, void *data);
+
+static int mln_json_chain_write(struct mln_json_chain_s *hc, void *buf, mln_size_t size)
+{
+    mln_buf_t *cur;
+
+    while (size > 0) {
+        if (hc->left_size == 0) {
+            mln_chain_t *c = mln_chain_new(hc->pool);
+            if (c == NULL) return -1;
+            mln_buf_t *b = mln_buf_new(hc->pool);
+            if (b == NULL) {
+                mln_chain_pool_release(c);
+                return -1;
+            }
+            c->buf = b;
+            mln_u8ptr_t buffer = (mln_u8ptr_t)mln_alloc_m(hc->pool, M_JSON_CHAIN_ALLOC_SIZE);
+            if (buffer == NULL) {
+                mln_chain_pool_release(c);
+                return -1;
+            }
+            b->left_pos = b->pos = b->start = buffer;
+            b->last = b->end = buffer;
+            b->in_memory = 1;
+            b->last_buf = 1;
+
+            hc->pos = buffer;
+            hc->left_size = M_JSON_CHAIN_ALLOC_SIZE;
+            if (hc->head == NULL) {
+                hc->head = hc->tail = c;
+            } else {
+                hc->tail->next = c;
+                hc->tail = c;
+            }
+        }
+
+        cur = hc->tail->buf;
+        if (size <= hc->left_size) {
+            memcpy(hc->pos, buf, size);
+            hc->left_size -= size;
+            hc->pos += size;
+            hc->written += size;
+            size = 0;
+        } else {
+            memcpy(hc->pos, buf, hc->left_size);
+            size -= hc->left_size;
+            buf = (mln_u8ptr_t)buf + hc->left_size;
+            hc->pos += hc->left_size;
+            hc->written += hc->left_size;
+            hc->left_size = 0;
+        }
+        cur->last = cur->end = hc->pos;
+    }
+
+    return 0;
+}
+
+/*drop the trailing comma just written into the current buffer*/
+static inline void mln_json_chain_unwrite(struct mln_json_chain_s *hc)
+{
+    --(hc->pos);
+    ++(hc->left_size);
+    --(hc->written);
+    hc->tail->buf->last = hc->tail->buf->end = hc->pos;
+}
+
+int mln_json_generate_chain(mln_json_t *j, mln_alloc_t *pool, mln_chain_t **out_head, mln_chain_t **out_tail)
+{
+    struct mln_json_chain_s hc;
+
+    if (j == NULL || pool == NULL || out_head == NULL || out_tail == NULL)
+        return -1;
+
+    hc.pool = pool;
+    hc.head = hc.tail = NULL;
+    hc.pos = NULL;
+    hc.left_size = 0;
+    hc.written = 0;
+
+    if (mln_json_write_content_chain(j, &hc) < 0) {
+        mln_chain_pool_release_all(hc.head);
+        *out_head = *out_tail = NULL;
+        return -1;
+    }
+    if (hc.tail != NULL && hc.tail->buf != NULL)
+        hc.tail->buf->last_in_chain = 1;
+    *out_head = hc.head;
+    *out_tail = hc.tail;
+    return 0;
+}
+
+static int mln_json_write_content_chain(mln_json_t *j, struct mln_json_chain_s *hc)
+{
+    int n;
+    char num_str[512];
+    mln_u8ptr_t p, q, end;
+    mln_u8_t esc[2];
+    mln_size_t save;
+
+    if (j == NULL) return 0;
+
+    switch (j->type) {
+        case M_JSON_OBJECT:
+            if (mln_json_chain_write(hc, "{", 1) < 0) return -1;
+            save = hc->written;
+            if (j->data.m_j_obj != NULL) {
+                if (mln_hash_iterate(j->data.m_j_obj, \
+                                      mln_json_write_content_chain_hash_iterate_handler, \
+                                      hc) < 0)
+                    return -1;
+            }
+            if (hc->written > save) /*members written, trailing comma follows*/
+                mln_json_chain_unwrite(hc);
+            if (mln_json_chain_write(hc, "}", 1) < 0) return -1;
+            break;
+        case M_JSON_ARRAY:
+            if (mln_json_chain_write(hc, "[", 1) < 0) return -1;
+            save = hc->written;
+            if (j->data.m_j_array != NULL) {
+                if (mln_rbtree_iterate(j->data.m_j_array, \
+                                        mln_json_write_content_chain_rbtree_iterate_handler, \
+                                        hc) < 0)
+                    return -1;
+            }
+            if (hc->written > save)
+                mln_json_chain_unwrite(hc);
+            if (mln_json_chain_write(hc, "]", 1) < 0) return -1;
+            break;
+        case M_JSON_STRING:
+            if (mln_json_chain_write(hc, "\"", 1) < 0) return -1;
+            if (j->data.m_j_string != NULL) {
+                p = j->data.m_j_string->data;
+                end = p + j->data.m_j_string->len;
+                while (p < end) {
+                    for (q = p; q < end && *q != (mln_u8_t)'\"' && *q != (mln_u8_t)'\\'; ++q)
+                        ;
+                    if (q > p && mln_json_chain_write(hc, p, q - p) < 0) return -1;
+                    if (q < end) {
+                        esc[0] = '\\';
+                        esc[1] = *q;
+                        if (mln_json_chain_write(hc, esc, 2) < 0) return -1;
+                        ++q;
+                    }
+                    p = q;
+                }
+            }
+            if (mln_json_chain_write(hc, "\"", 1) < 0) return -1;
+            break;
+        case M_JSON_NUM:
+            n = mln_json_fmt_number(j->data.m_j_number, num_str);
+            if (mln_json_chain_write(hc, num_str, n) < 0) return -1;
+            break;
+        case M_JSON_TRUE:
+            if (mln_json_chain_write(hc, "true", 4) < 0) return -1;
+            break;
+        case M_JSON_FALSE:
+            if (mln_json_chain_write(hc, "false", 5) < 0) return -1;
+            break;
+        case M_JSON_NULL:
+            if (mln_json_chain_write(hc, "null", 4) < 0) return -1;
+            break;
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+static int
+mln_json_write_content_chain_hash_iterate_handler(void *key, void *val, void *data)
+{
+    mln_json_obj_t *obj = (mln_json_obj_t *)val;
+    struct mln_json_chain_s *hc = (struct mln_json_chain_s *)data;
+
+    if (obj == NULL) return 0;
+
+    if (obj->key != NULL) {
+        if (mln_json_write_content_chain(obj->key, hc) < 0) return -1;
+    }
+    if (mln_json_chain_write(hc, ":", 1) < 0) return -1;
+    if (obj->val != NULL) {
+        if (mln_json_write_content_chain(obj->val, hc) < 0) return -1;
+    }
+    if (mln_json_chain_write(hc, ",", 1) < 0) return -1;
+
+    return 0;
+}
+
+static int
+mln_json_write_content_chain_rbtree_iterate_handler(mln_rbtree_node_t *node, void *data)
+{
+    mln_json_t *j = (mln_json_t *)mln_rbtree_node_data_get(node);
+    struct mln_json_chain_s *hc = (struct mln_json_chain_s *)data;
+
+    if (j == NULL) return 0;
+
+    if (mln_json_write_content_chain(j, hc) < 0) return -1;
+    if (mln_json_chain_write(hc, ",", 1) < 0) return -1;
+
+    return 0;
+}
+
+
+/*
+ * lazy path query
+ */
+static inline int mln_json_query_string_skip(char **s, int *len)
+{
+    /* *s at the opening quote; leaves *s just past the closing one */
+    char *p = *s + 1;
+    int plen = *len - 1, flag = 0;
+
+    while (plen > 0) {
+#if defined(MLN_JSON_SIMD)
+        if (!flag && plen >= 16) {
+            int n = mln_json_simd_str_stop((mln_u8_t *)p);
+            if (n > 0) {
+                p += n;
+                plen -= n;
+                continue;
+            }
+        }
+#endif
+        if (!flag && *p == '\\') {
+            flag = 1;
+        } else {
+            if (*p == '\"' && !flag) break;
+            if (flag) flag = 0;
+        }
+        ++p;
+        --plen;
+    }
+    if (plen <= 0) return -1;
+    *s = p + 1;
+    *len = plen - 1;
+    return 0;
+}
+
+static int mln_json_query_value_skip(char **s, int *len)
+{
+    int depth;
+
+    mln_json_jumpoff_blank(s, len);
+    if (*len <= 0) return -1;
+    switch (**s) {
+        case '\"':
+            return mln_json_query_string_skip(s, len);
+        case '{':
+        case '[':
+            depth = 0;
+            do {
+                if (**s == '{' || **s == '[') {
+                    ++depth;
+                    ++(*s), --(*len);
+                } else if (**s == '}' || **s == ']') {
+                    --depth;
+                    ++(*s), --(*len);
+                } else if (**s == '\"') {
+                    if (mln_json_query_string_skip(s, len) < 0) return -1;
+                } else {
+                    ++(*s), --(*len);
+                }
+            } while (depth > 0 && *len > 0);
+            return depth == 0? 0: -1;
+        default:
+            for (; *len > 0; ++(*s), --(*len)) {
+                if (**s == ',' || **s == '}' || **s == ']' || **s == ' ' || \
+                    **s == '\t' || **s == '\r' || **s == '\n')
+                    break;
+            }
+            return 0;
+    }
+}
+
+static int mln_json_query_object_descend(char **s, int *len, char *key, int klen)
+{
+    /* *s at '{'; on match leaves *s at the member's value */
+    char *kstart;
+    int cur, match;
+
+    ++(*s), --(*len);
+    while (1) {
+        mln_json_jumpoff_blank(s, len);
+        if (*len <= 0 || **s != '\"') return -1;
+        kstart = *s + 1;
+        if (mln_json_query_string_skip(s, len) < 0) return -1;
+        cur = *s - 1 - kstart;
+        match = (cur == klen && !memcmp(kstart, key, klen));
+        mln_json_jumpoff_blank(s, len);
+        if (*len <= 0 || **s != ':') return -1;
+        ++(*s), --(*len);
+        if (match) return 0;
+        if (mln_json_query_value_skip(s, len) < 0) return -1;
+        mln_json_jumpoff_blank(s, len);
+        if (*len <= 0 || **s != ',') return -1;
+        ++(*s), --(*len);
+    }
+}
+
+static int mln_json_query_array_descend(char **s, int *len, mln_uauto_t index)
+{
+    /* *s at '['; on match leaves *s at element 'index' */
+    ++(*s), --(*len);
+    while (1) {
+        mln_json_jumpoff_blank(s, len);
+        if (*len <= 0 || **s == ']') return -1;
+        if (index == 0) return 0;
+        if (mln_json_query_value_skip(s, len) < 0) return -1;
+        mln_json_jumpoff_blank(s, len);
+        if (*len <= 0 || **s != ',') return -1;
+        ++(*s), --(*len);
+        --index;
+    }
+}
+
+int mln_json_query(mln_string_t *jstr, char *path, mln_json_query_result_t *res)
+{
+    char *s = (char *)jstr->data, *p = path, *seg, *start;
+    int len = jstr->len, klen;
+    mln_uauto_t index;
+
+    while (*p != 0) {
+        if (*p == '.') {
+            ++p;
+            continue;
+        }
+        mln_json_jumpoff_blank(&s, &len);
+        if (len <= 0) return -1;
+        if (*p == '[') {
+            for (index = 0, ++p; *p >= '0' && *p <= '9'; ++p) {
+                index = index * 10 + (*p - '0');
+            }
+            if (*p != ']') return -1;
+            ++p;
+            if (*s != '[') return -1;
+            if (mln_json_query_array_descend(&s, &len, index) < 0) return -1;
+        } else {
+            seg = p;
+            while (*p != 0 && *p != '.' && *p != '[') ++p;
+            klen = p - seg;
+            if (klen == 0) return -1;
+            if (*s != '{') return -1;
+            if (mln_json_query_object_descend(&s, &len, seg, klen) < 0) return -1;
+        }
+    }
+
+    mln_json_jumpoff_blank(&s, &len);
+    if (len <= 0) return -1;
+    res->num = 0;
+    switch (*s) {
+        case '\"':
+            start = s + 1;
+            if (mln_json_query_string_skip(&s, &len) < 0) return -1;
+            res->type = M_JSON_STRING;
+            mln_string_nset(&res->text, start, s - 1 - start);
+            return 0;
+        case '{':
+            res->type = M_JSON_OBJECT;
+            break;
+        case '[':
+            res->type = M_JSON_ARRAY;
+            break;
+        case 't':
+            if (len < 4 || memcmp(s, "true", 4)) return -1;
+            res->type = M_JSON_TRUE;
+            break;
+        case 'f':
+            if (len < 5 || memcmp(s, "false", 5)) return -1;
+            res->type = M_JSON_FALSE;
+            break;
+        case 'n':
+            if (len < 4 || memcmp(s, "null", 4)) return -1;
+            res->type = M_JSON_NULL;
+            break;
+        default: {
+            char *tok;
+            int toklen, sub_flag = 0;
+            start = s;
+            if (mln_json_query_value_skip(&s, &len) < 0) return -1;
+            tok = start;
+            toklen = s - start;
+            if (*tok == '-') {
+                sub_flag = 1;
+                ++tok;
+                --toklen;
+            }
+            if (toklen <= 0 || mln_json_digit_process(&res->num, tok, toklen) < 0) return -1;
+            if (sub_flag) res->num = -res->num;
+            res->type = M_JSON_NUM;
+            mln_string_nset(&res->text, start, s - start);
+            return 0;
+        }
+    }
+    start = s;
+    if (mln_json_query_value_skip(&s, &len) < 0) return -1;
+    mln_string_nset(&res->text, start, s - start);
+    return 0;
+}
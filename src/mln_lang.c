@@ -22,6 +22,7 @@
 #include "mln_lang_real.h"
 #include "mln_lang_str.h"
 #include "mln_lang_array.h"
+#include "mln_lang_bc.h"
 #if defined(WIN32)
 #include <libloaderapi.h>
 #else
@@ -78,6 +79,46 @@ MLN_CHAIN_FUNC_DEFINE(mln_lang_ctx, \
                       static inline void, \
                       prev, \
                       next);
+/*
+ * run queue
+ * Runnable tasks sit on per-priority intrusive lists and 'run_map'
+ * keeps one bit per non-empty level, so picking the next task is a
+ * find-first-set instead of a scan. Blocked tasks are parked on the
+ * wait chain and never touched by the scheduler.
+ */
+static inline int mln_lang_run_ffs(mln_u32_t map)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(map);
+#else
+    int n = 0;
+    while (!(map & 1)) {
+        map >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+static inline void mln_lang_run_add(mln_lang_t *lang, mln_lang_ctx_t *ctx)
+{
+    mln_u32_t pri = ctx->priority;
+    mln_lang_ctx_chain_add(&(lang->run_head[pri]), &(lang->run_tail[pri]), ctx);
+    lang->run_map |= ((mln_u32_t)1 << pri);
+}
+
+static inline void mln_lang_run_del(mln_lang_t *lang, mln_lang_ctx_t *ctx)
+{
+    mln_u32_t pri = ctx->priority;
+    mln_lang_ctx_chain_del(&(lang->run_head[pri]), &(lang->run_tail[pri]), ctx);
+    if (lang->run_head[pri] == NULL) lang->run_map &= ~((mln_u32_t)1 << pri);
+}
+
+static inline mln_lang_ctx_t *mln_lang_run_pick(mln_lang_t *lang)
+{
+    if (lang->run_map == 0) return NULL;
+    return lang->run_head[mln_lang_run_ffs(lang->run_map)];
+}
 MLN_CHAIN_FUNC_DECLARE(mln_lang_var, \
                        mln_lang_var_t, \
                        static inline void,);
@@ -95,7 +136,7 @@ __mln_lang_job_new(mln_lang_t *lang, \
 static inline void __mln_lang_job_free(mln_lang_ctx_t *ctx);
 static void mln_lang_run_handler(mln_event_t *ev, int fd, void *data);
 static inline mln_lang_ast_cache_t *
-mln_lang_ast_cache_new(mln_lang_t *lang, mln_lang_stm_t *stm, mln_string_t *code, mln_u64_t timestamp);
+mln_lang_ast_cache_new(mln_alloc_t *pool, mln_lang_stm_t *stm, mln_string_t *code, mln_u64_t timestamp);
 static inline void
 mln_lang_ast_cache_free(mln_lang_ast_cache_t *cache);
 static inline mln_lang_ctx_t *
@@ -195,6 +236,9 @@ static inline mln_lang_var_t *
 mln_lang_array_get_other(mln_lang_ctx_t *ctx, mln_lang_array_t *array, mln_lang_var_t *key);
 static inline mln_lang_var_t *
 mln_lang_array_get_nil(mln_lang_ctx_t *ctx, mln_lang_array_t *array);
+static inline mln_lang_var_t *
+mln_lang_array_vec_append(mln_lang_ctx_t *ctx, mln_lang_array_t *array);
+static int mln_lang_array_spill(mln_lang_ctx_t *ctx, mln_lang_array_t *array);
 static inline mln_lang_funccall_val_t *__mln_lang_funccall_val_new(mln_alloc_t *pool, mln_string_t *name);
 static inline void __mln_lang_funccall_val_free(mln_lang_funccall_val_t *func);
 static inline int mln_lang_funccall_val_operator_overload_test(mln_lang_ctx_t *ctx, mln_string_t *name);
@@ -295,6 +339,9 @@ static int mln_lang_resource_cmp(const mln_lang_resource_t *lr1, const mln_lang_
 static void mln_lang_resource_free_handler(mln_lang_resource_t *lr);
 static inline mln_lang_hash_t *mln_lang_hash_new(mln_lang_ctx_t *ctx);
 static inline void mln_lang_hash_free(mln_lang_hash_t *h);
+static inline mln_lang_val_t *mln_lang_ctx_int_cache_fetch(mln_lang_ctx_t *ctx, mln_s64_t i);
+static inline mln_lang_val_t *mln_lang_ctx_str_cache_fetch(mln_lang_ctx_t *ctx, mln_string_t *s);
+static inline void mln_lang_ctx_const_cache_release(mln_lang_ctx_t *ctx);
 static inline mln_lang_hash_bucket_t *mln_lang_hash_get_bucket(mln_lang_hash_t *h, mln_lang_symbol_node_t *sym);
 static mln_lang_ctx_pipe_t *mln_lang_ctx_pipe_new(mln_lang_ctx_t *ctx);
 static void mln_lang_ctx_pipe_free(mln_lang_ctx_pipe_t *p);
@@ -547,11 +594,16 @@ mln_lang_t *mln_lang_new(mln_event_t *ev, mln_lang_run_ctl_t signal, mln_lang_ru
     }
     lang->ev = ev;
     lang->pool = pool;
-    lang->run_head = lang->run_tail = NULL;
+    memset(lang->run_head, 0, sizeof(lang->run_head));
+    memset(lang->run_tail, 0, sizeof(lang->run_tail));
+    lang->run_map = 0;
     lang->wait_head = lang->wait_tail = NULL;
     lang->resource_set = NULL;
     lang->cache_head = NULL;
     lang->cache_tail = NULL;
+    lang->ctx_cache_head = NULL;
+    lang->ctx_cache_n = 0;
+    lang->shared_cache = NULL;
     lang->shift_table = NULL;
     lang->wait = 0;
     lang->quit = 0;
@@ -592,8 +644,8 @@ void mln_lang_free(mln_lang_t *lang)
     }
     mln_lang_ctx_t *ctx;
     mln_lang_ast_cache_t *cache;
-    while ((ctx = lang->run_head) != NULL) {
-        mln_lang_ctx_chain_del(&(lang->run_head), &(lang->run_tail), ctx);
+    while ((ctx = mln_lang_run_pick(lang)) != NULL) {
+        mln_lang_run_del(lang, ctx);
         mln_lang_ctx_free(ctx);
     }
     while ((ctx = lang->wait_head) != NULL) {
@@ -606,13 +658,139 @@ void mln_lang_free(mln_lang_t *lang)
         mln_lang_ast_cache_chain_del(&(lang->cache_head), &(lang->cache_tail), cache);
         mln_lang_ast_cache_free(cache);
     }
+    while ((ctx = lang->ctx_cache_head) != NULL) {
+        lang->ctx_cache_head = ctx->next;
+        mln_alloc_destroy(ctx->pool);
+        mln_alloc_free(ctx);
+    }
+    lang->ctx_cache_n = 0;
 
     pthread_mutex_unlock(&lang->lock);
     pthread_mutex_destroy(&lang->lock);
 
+    if (lang->shared_cache != NULL) mln_lang_shared_cache_free(lang->shared_cache);
     mln_alloc_destroy(lang->pool);
 }
 
+mln_lang_shared_cache_t *mln_lang_shared_cache_new(void)
+{
+    mln_alloc_t *pool;
+    mln_lang_shared_cache_t *sc;
+
+    if ((pool = mln_alloc_init(NULL)) == NULL)
+        return NULL;
+    if ((sc = (mln_lang_shared_cache_t *)mln_alloc_m(pool, sizeof(mln_lang_shared_cache_t))) == NULL) {
+        mln_alloc_destroy(pool);
+        return NULL;
+    }
+    sc->pool = pool;
+    sc->cache_head = NULL;
+    sc->cache_tail = NULL;
+    sc->ref = 1;
+    if (pthread_mutex_init(&sc->lock, NULL) != 0) {
+        mln_alloc_destroy(pool);
+        return NULL;
+    }
+    if ((sc->shift_table = mln_lang_ast_parser_generate()) == NULL) {
+        pthread_mutex_destroy(&sc->lock);
+        mln_alloc_destroy(pool);
+        return NULL;
+    }
+    return sc;
+}
+
+void mln_lang_shared_cache_free(mln_lang_shared_cache_t *sc)
+{
+    mln_lang_ast_cache_t *cache;
+
+    if (sc == NULL) return;
+
+    pthread_mutex_lock(&sc->lock);
+    if (--(sc->ref)) {
+        pthread_mutex_unlock(&sc->lock);
+        return;
+    }
+    while ((cache = sc->cache_head) != NULL) {
+        mln_lang_ast_cache_chain_del(&(sc->cache_head), &(sc->cache_tail), cache);
+        mln_lang_ast_cache_free(cache);
+    }
+    mln_lang_ast_parser_destroy(sc->shift_table);
+    pthread_mutex_unlock(&sc->lock);
+    pthread_mutex_destroy(&sc->lock);
+    mln_alloc_destroy(sc->pool);
+}
+
+int mln_lang_shared_cache_attach(mln_lang_t *lang, mln_lang_shared_cache_t *sc)
+{
+    if (lang->shared_cache != NULL) return -1;
+    pthread_mutex_lock(&sc->lock);
+    ++(sc->ref);
+    pthread_mutex_unlock(&sc->lock);
+    lang->shared_cache = sc;
+    mln_lang_cache_set(lang);
+    return 0;
+}
+
+mln_lang_group_t *mln_lang_group_new(void)
+{
+    mln_lang_group_t *group;
+
+    if ((group = (mln_lang_group_t *)malloc(sizeof(mln_lang_group_t))) == NULL)
+        return NULL;
+    group->langs = NULL;
+    group->nlangs = 0;
+    group->cursor = 0;
+    if (pthread_mutex_init(&group->lock, NULL) != 0) {
+        free(group);
+        return NULL;
+    }
+    return group;
+}
+
+void mln_lang_group_free(mln_lang_group_t *group)
+{
+    if (group == NULL) return;
+    pthread_mutex_destroy(&group->lock);
+    if (group->langs != NULL) free(group->langs);
+    free(group);
+}
+
+int mln_lang_group_add(mln_lang_group_t *group, mln_lang_t *lang)
+{
+    mln_lang_t **langs;
+
+    pthread_mutex_lock(&group->lock);
+    if ((langs = (mln_lang_t **)realloc(group->langs, (group->nlangs + 1) * sizeof(mln_lang_t *))) == NULL) {
+        pthread_mutex_unlock(&group->lock);
+        return -1;
+    }
+    langs[group->nlangs] = lang;
+    group->langs = langs;
+    ++(group->nlangs);
+    pthread_mutex_unlock(&group->lock);
+    return 0;
+}
+
+mln_lang_ctx_t *
+mln_lang_group_job_new(mln_lang_group_t *group, \
+                       mln_u32_t type, \
+                       mln_string_t *data, \
+                       void *udata, \
+                       mln_lang_return_handler handler)
+{
+    mln_lang_t *lang;
+
+    pthread_mutex_lock(&group->lock);
+    if (!group->nlangs) {
+        pthread_mutex_unlock(&group->lock);
+        return NULL;
+    }
+    lang = group->langs[group->cursor];
+    if (++(group->cursor) >= group->nlangs) group->cursor = 0;
+    pthread_mutex_unlock(&group->lock);
+    return mln_lang_job_new(lang, type, data, udata, handler);
+}
+
 static void mln_lang_run_handler(mln_event_t *ev, int fd, void *data)
 {
     int n;
@@ -623,12 +801,17 @@ static void mln_lang_run_handler(mln_event_t *ev, int fd, void *data)
     if (pthread_mutex_trylock(&lang->lock) != 0)
         return;
 
-    if ((ctx = lang->run_head) != NULL && ctx->owner == 0) {
-        mln_lang_ctx_chain_del(&lang->run_head, &lang->run_tail, ctx);
-        mln_lang_ctx_chain_add(&lang->run_head, &lang->run_tail, ctx);
+    if ((ctx = mln_lang_run_pick(lang)) != NULL && ctx->owner == 0) {
+        mln_lang_run_del(lang, ctx);
+        mln_lang_run_add(lang, ctx);
         ctx->owner = pthread_self();
         pthread_mutex_unlock(&lang->lock);
-        for (n = 0; n < M_LANG_DEFAULT_STEP; ++n) {
+        if (ctx->bc != NULL) {
+            mln_lang_bc_run(ctx, mln_lang_ctx_step_budget(ctx));
+            if (ctx->quit) goto quit;
+            goto slice_done;
+        }
+        for (n = mln_lang_ctx_step_budget(ctx); n > 0; --n) {
             if ((node = mln_lang_stack_top(ctx)) == NULL)
                 goto quit;
             mln_lang_stack_map[node->type](ctx);
@@ -643,12 +826,13 @@ quit:
                 goto out;
             }
         }
+slice_done:
         if (!ctx->ref)
             mln_gc_collect(ctx->gc, ctx);
         pthread_mutex_lock(&lang->lock);
         ctx->owner = 0;
 out:
-        if (lang->run_head != NULL)
+        if (lang->run_map != 0)
             lang->signal(lang);
     } else {
         lang->clear(lang);
@@ -658,14 +842,14 @@ out:
 
 
 static inline mln_lang_ast_cache_t *
-mln_lang_ast_cache_new(mln_lang_t *lang, mln_lang_stm_t *stm, mln_string_t *code, mln_u64_t timestamp)
+mln_lang_ast_cache_new(mln_alloc_t *pool, mln_lang_stm_t *stm, mln_string_t *code, mln_u64_t timestamp)
 {
     mln_lang_ast_cache_t *cache;
-    if ((cache = mln_alloc_m(lang->pool, sizeof(mln_lang_ast_cache_t))) == NULL) {
+    if ((cache = mln_alloc_m(pool, sizeof(mln_lang_ast_cache_t))) == NULL) {
         return NULL;
     }
     cache->stm = stm;
-    cache->code = mln_string_pool_dup(lang->pool, code);
+    cache->code = mln_string_pool_dup(pool, code);
     if (cache->code == NULL) {
         mln_alloc_free(cache);
         return NULL;
@@ -689,7 +873,12 @@ mln_lang_ast_cache_free(mln_lang_ast_cache_t *cache)
 }
 
 static inline mln_lang_ast_cache_t *
-mln_lang_ast_cache_search(mln_lang_t *lang, mln_u32_t type, mln_string_t *content)
+mln_lang_ast_cache_lookup(mln_alloc_t *pool, \
+                          void *shift_table, \
+                          mln_lang_ast_cache_t **head, \
+                          mln_lang_ast_cache_t **tail, \
+                          mln_u32_t type, \
+                          mln_string_t *content)
 {
     mln_lang_ast_cache_t *cache;
     mln_string_t data;
@@ -730,7 +919,7 @@ mln_lang_ast_cache_search(mln_lang_t *lang, mln_u32_t type, mln_string_t *conten
         data = *content;
     }
 
-    for (cache = lang->cache_head; cache != NULL; cache = cache->next) {
+    for (cache = *head; cache != NULL; cache = cache->next) {
         if (cache->expire) continue;
         if (now - cache->timestamp >= MLN_LANG_STM_CACHE_USEC) {
             cache->expire = 1;
@@ -742,45 +931,107 @@ mln_lang_ast_cache_search(mln_lang_t *lang, mln_u32_t type, mln_string_t *conten
         }
     }
 
-    stm = (mln_lang_stm_t *)mln_lang_ast_generate(lang->pool, lang->shift_table, content, type);
+    stm = (mln_lang_stm_t *)mln_lang_ast_generate(pool, shift_table, content, type);
     if (stm == NULL) {
         if (buf != NULL) free(buf);
         return NULL;
     }
 
-    cache = mln_lang_ast_cache_new(lang, stm, &data, now);
+    cache = mln_lang_ast_cache_new(pool, stm, &data, now);
     if (buf != NULL) free(buf);
     if (cache == NULL) {
         mln_lang_ast_free(stm);
         return NULL;
     }
-    mln_lang_ast_cache_chain_add(&(lang->cache_head), &(lang->cache_tail), cache);
+    mln_lang_ast_cache_chain_add(head, tail, cache);
+    return cache;
+}
+
+static inline mln_lang_ast_cache_t *
+mln_lang_ast_cache_search(mln_lang_t *lang, mln_u32_t type, mln_string_t *content)
+{
+    return mln_lang_ast_cache_lookup(lang->pool, \
+                                     lang->shift_table, \
+                                     &(lang->cache_head), \
+                                     &(lang->cache_tail), \
+                                     type, \
+                                     content);
+}
+
+/*
+ * Shared-store lookup. Compilation, entry creation and the reference
+ * bump all happen under the store's lock, so the returned entry cannot
+ * be dropped by another worker before the context has claimed it.
+ */
+static inline mln_lang_ast_cache_t *
+mln_lang_shared_cache_search(mln_lang_shared_cache_t *sc, mln_u32_t type, mln_string_t *content)
+{
+    mln_lang_ast_cache_t *cache;
+    pthread_mutex_lock(&sc->lock);
+    cache = mln_lang_ast_cache_lookup(sc->pool, \
+                                      sc->shift_table, \
+                                      &(sc->cache_head), \
+                                      &(sc->cache_tail), \
+                                      type, \
+                                      content);
+    if (cache != NULL) ++(cache->ref);
+    pthread_mutex_unlock(&sc->lock);
     return cache;
 }
 
+/*
+ * Releases a context's claim on a shared entry; the last claim of an
+ * entry frees it, mirroring the per-instance cache behavior.
+ */
+static inline void
+mln_lang_shared_cache_release(mln_lang_shared_cache_t *sc, mln_lang_ast_cache_t *cache)
+{
+    pthread_mutex_lock(&sc->lock);
+    if (!(--(cache->ref))) {
+        mln_lang_ast_cache_chain_del(&(sc->cache_head), &(sc->cache_tail), cache);
+        mln_lang_ast_cache_free(cache);
+    }
+    pthread_mutex_unlock(&sc->lock);
+}
+
 
 static inline mln_lang_ctx_t *
 mln_lang_ctx_new(mln_lang_t *lang, void *data, mln_string_t *filename, mln_u32_t type, mln_string_t *content)
 {
     mln_lang_ctx_t *ctx;
+    mln_lang_bc_t *bc = NULL;
     struct mln_rbtree_attr rbattr;
     struct mln_gc_attr gcattr;
 
-    if ((ctx = (mln_lang_ctx_t *)mln_alloc_m(lang->pool, sizeof(mln_lang_ctx_t))) == NULL) {
-        return NULL;
+    if (lang->ctx_cache_head != NULL) {
+        ctx = lang->ctx_cache_head;
+        lang->ctx_cache_head = ctx->next;
+        --(lang->ctx_cache_n);
+        if ((ctx->fset = mln_fileset_init(M_LANG_MAX_OPENFILE)) == NULL) {
+            mln_alloc_destroy(ctx->pool);
+            mln_alloc_free(ctx);
+            return NULL;
+        }
+    } else {
+        if ((ctx = (mln_lang_ctx_t *)mln_alloc_m(lang->pool, sizeof(mln_lang_ctx_t))) == NULL) {
+            return NULL;
+        }
+        if ((ctx->pool = mln_alloc_init(NULL)) == NULL) {
+            mln_alloc_free(ctx);
+            return NULL;
+        }
+        if ((ctx->fset = mln_fileset_init(M_LANG_MAX_OPENFILE)) == NULL) {
+            mln_alloc_destroy(ctx->pool);
+            mln_alloc_free(ctx);
+            return NULL;
+        }
     }
     ctx->lang = lang;
-    if ((ctx->pool = mln_alloc_init(NULL)) == NULL) {
-        mln_alloc_free(ctx);
-        return NULL;
-    }
-    if ((ctx->fset = mln_fileset_init(M_LANG_MAX_OPENFILE)) == NULL) {
-        mln_alloc_destroy(ctx->pool);
-        mln_alloc_free(ctx);
-        return NULL;
-    }
     ctx->data = data;
-    if (lang->cache) {
+    if (lang->shared_cache != NULL) {
+        ctx->cache = mln_lang_shared_cache_search(lang->shared_cache, type, content);
+        ctx->stm = ctx->cache == NULL? NULL: ctx->cache->stm;
+    } else if (lang->cache) {
         ctx->cache = mln_lang_ast_cache_search(lang, type, content);
         if (ctx->cache == NULL) {
             ctx->stm = NULL;
@@ -789,7 +1040,17 @@ mln_lang_ctx_new(mln_lang_t *lang, void *data, mln_string_t *filename, mln_u32_t
             ++(ctx->cache->ref);
         }
     } else {
-        ctx->stm = (mln_lang_stm_t *)mln_lang_ast_generate(ctx->pool, lang->shift_table, content, type);
+        ctx->cache = NULL;
+        /*
+         * A valid precompiled cache lets the task skip lexing and
+         * parsing entirely; it is installed as ctx->bc further down.
+         */
+        if (type == M_INPUT_T_FILE)
+            bc = mln_lang_bc_load(ctx, content);
+        if (bc != NULL)
+            ctx->stm = NULL;
+        else
+            ctx->stm = (mln_lang_stm_t *)mln_lang_ast_generate(ctx->pool, lang->shift_table, content, type);
     }
     /* ctx->run_stack do not need to be initialized */
     ctx->run_stack_top = NULL;
@@ -798,6 +1059,11 @@ mln_lang_ctx_new(mln_lang_t *lang, void *data, mln_string_t *filename, mln_u32_t
     ctx->ref = 0;
     ctx->filename = NULL;
     ctx->symbols = NULL;
+    ctx->int_cache = NULL;
+    ctx->str_cache = NULL;
+    ctx->cell_vars = NULL;
+    ctx->cell_vals = NULL;
+    ctx->cell_nvars = ctx->cell_nvals = 0;
     rbattr.pool = ctx->pool;
     rbattr.pool_alloc = (rbtree_pool_alloc_handler)mln_alloc_m;
     rbattr.pool_free = (rbtree_pool_free_handler)mln_alloc_free;
@@ -805,7 +1071,9 @@ mln_lang_ctx_new(mln_lang_t *lang, void *data, mln_string_t *filename, mln_u32_t
     rbattr.data_free = (rbtree_free_data)mln_lang_ctx_resource_free_handler;
     if ((ctx->resource_set = mln_rbtree_new(&rbattr)) == NULL) {
         if (ctx->cache != NULL) {
-            if (!(--(ctx->cache->ref))) {
+            if (lang->shared_cache != NULL) {
+                mln_lang_shared_cache_release(lang->shared_cache, ctx->cache);
+            } else if (!(--(ctx->cache->ref))) {
                 mln_lang_ast_cache_chain_del(&(ctx->lang->cache_head), &(ctx->lang->cache_tail), ctx->cache);
                 mln_lang_ast_cache_free(ctx->cache);
             }
@@ -827,6 +1095,9 @@ mln_lang_ctx_new(mln_lang_t *lang, void *data, mln_string_t *filename, mln_u32_t
     ctx->ret_flag = ctx->op_array_flag = ctx->op_bool_flag = ctx->op_func_flag = ctx->op_int_flag = \
     ctx->op_nil_flag = ctx->op_obj_flag = ctx->op_real_flag = ctx->op_str_flag = 0;
     ctx->quit = 0;
+    ctx->priority = M_LANG_PRIORITY_DEFAULT;
+    ctx->shared_stm = (lang->shared_cache != NULL && ctx->cache != NULL)? 1: 0;
+    ctx->bc = NULL;
 
     gcattr.pool = ctx->pool;
     gcattr.item_getter = (gc_item_getter)mln_lang_gc_item_getter;
@@ -872,6 +1143,21 @@ mln_lang_ctx_new(mln_lang_t *lang, void *data, mln_string_t *filename, mln_u32_t
         mln_lang_ctx_free(ctx);
         return NULL;
     }
+
+    /*
+     * Try to flatten the AST into bytecode. Tasks using constructs the
+     * compiler does not cover keep running on the stack-node walker.
+     * Freshly compiled file-based programs are stored back to disk, so
+     * the next boot skips parsing them.
+     */
+    if (bc != NULL) {
+        ctx->bc = (void *)bc;
+    } else if ((ctx->bc = (void *)mln_lang_bc_compile(ctx)) != NULL && \
+               type == M_INPUT_T_FILE && !lang->cache)
+    {
+        mln_lang_bc_store(ctx, content);
+    }
+
     return ctx;
 }
 
@@ -880,12 +1166,17 @@ static inline void mln_lang_ctx_free(mln_lang_ctx_t *ctx)
     if (ctx == NULL) return;
     mln_lang_symbol_node_t *sym;
 
+    if (ctx->bc != NULL) {
+        mln_lang_bc_free((mln_lang_bc_t *)(ctx->bc));
+        ctx->bc = NULL;
+    }
     while ((sym = ctx->sym_head) != NULL) {
         mln_lang_sym_chain_del(&ctx->sym_head, &ctx->sym_tail, sym);
         sym->ctx = NULL;
         mln_lang_symbol_node_free(sym);
     }
     if (ctx->ret_var != NULL) __mln_lang_var_free(ctx->ret_var);
+    mln_lang_ctx_const_cache_release(ctx);
     if (ctx->filename != NULL) mln_string_free(ctx->filename);
     while (mln_lang_stack_top(ctx) != NULL) {
         mln_lang_stack_node_free(mln_lang_stack_pop(ctx));
@@ -902,7 +1193,9 @@ static inline void mln_lang_ctx_free(mln_lang_ctx_t *ctx)
     if (ctx->resource_set != NULL) mln_rbtree_free(ctx->resource_set);
     if (ctx->stm != NULL) {
         if (ctx->cache) {
-            if (!(--(ctx->cache->ref))) {
+            if (ctx->lang->shared_cache != NULL) {
+                mln_lang_shared_cache_release(ctx->lang->shared_cache, ctx->cache);
+            } else if (!(--(ctx->cache->ref))) {
                 mln_lang_ast_cache_chain_del(&(ctx->lang->cache_head), &(ctx->lang->cache_tail), ctx->cache);
                 mln_lang_ast_cache_free(ctx->cache);
             }
@@ -911,6 +1204,18 @@ static inline void mln_lang_ctx_free(mln_lang_ctx_t *ctx)
         }
     }
     mln_fileset_destroy(ctx->fset);
+    if (ctx->lang != NULL && ctx->lang->ctx_cache_n < M_LANG_CTX_CACHE_MAX) {
+        /*
+         * Park the shell for the next job. The reset keeps the pool's
+         * chunks, so a recycled context starts on warm memory and
+         * skips pool construction.
+         */
+        mln_alloc_reset(ctx->pool);
+        ctx->next = ctx->lang->ctx_cache_head;
+        ctx->lang->ctx_cache_head = ctx;
+        ++(ctx->lang->ctx_cache_n);
+        return;
+    }
     mln_alloc_destroy(ctx->pool);
     mln_alloc_free(ctx);
 }
@@ -919,7 +1224,7 @@ void mln_lang_ctx_suspend(mln_lang_ctx_t *ctx)
 {
     if (ctx->ref) return;
     ++(ctx->ref);
-    mln_lang_ctx_chain_del(&(ctx->lang->run_head), &(ctx->lang->run_tail), ctx);
+    mln_lang_run_del(ctx->lang, ctx);
     mln_lang_ctx_chain_add(&(ctx->lang->wait_head), &(ctx->lang->wait_tail), ctx);
 }
 
@@ -928,14 +1233,27 @@ void mln_lang_ctx_continue(mln_lang_ctx_t *ctx)
     if (!ctx->ref) return;
     --(ctx->ref);
     mln_lang_ctx_chain_del(&(ctx->lang->wait_head), &(ctx->lang->wait_tail), ctx);
-    mln_lang_ctx_chain_add(&(ctx->lang->run_head), &(ctx->lang->run_tail), ctx);
-    if (ctx->lang->run_head != NULL) {
+    mln_lang_run_add(ctx->lang, ctx);
+    if (ctx->lang->run_map != 0) {
         ctx->lang->signal(ctx->lang);
     } else {
         ctx->lang->clear(ctx->lang);
     }
 }
 
+void mln_lang_ctx_priority_set(mln_lang_ctx_t *ctx, mln_u32_t priority)
+{
+    if (priority > M_LANG_PRIORITY_MAX) priority = M_LANG_PRIORITY_MAX;
+    if (ctx->priority == priority) return;
+    if (ctx->ref) {/*parked on the wait chain, only remember the level*/
+        ctx->priority = priority;
+        return;
+    }
+    mln_lang_run_del(ctx->lang, ctx);
+    ctx->priority = priority;
+    mln_lang_run_add(ctx->lang, ctx);
+}
+
 static inline mln_lang_set_detail_t *
 mln_lang_ctx_get_class(mln_lang_ctx_t *ctx)
 {
@@ -1009,10 +1327,10 @@ __mln_lang_job_new(mln_lang_t *lang, \
         return NULL;
     }
     ctx->return_handler = handler;
-    mln_lang_ctx_chain_add(&(lang->run_head), &(lang->run_tail), ctx);
-    if (lang->run_head != NULL) {
+    mln_lang_run_add(lang, ctx);
+    if (lang->run_map != 0) {
         if (lang->signal(lang) < 0) {
-            mln_lang_ctx_chain_del(&(lang->run_head), &(lang->run_tail), ctx);
+            mln_lang_run_del(lang, ctx);
             mln_lang_ctx_free(ctx);
             return NULL;
         }
@@ -1038,9 +1356,9 @@ static inline void __mln_lang_job_free(mln_lang_ctx_t *ctx)
     if (ctx->ref)
         mln_lang_ctx_chain_del(&(lang->wait_head), &(lang->wait_tail), ctx);
     else
-        mln_lang_ctx_chain_del(&(lang->run_head), &(lang->run_tail), ctx);
+        mln_lang_run_del(lang, ctx);
     mln_lang_ctx_free(ctx);
-    if (lang->run_head != NULL) {
+    if (lang->run_map != 0) {
         lang->signal(lang);
     } else {
         lang->clear(lang);
@@ -1158,6 +1476,9 @@ static inline mln_lang_var_t *__mln_lang_var_create_int(mln_lang_ctx_t *ctx, mln
 {
     mln_lang_val_t *val;
     mln_lang_var_t *var;
+    if (name == NULL && (val = mln_lang_ctx_int_cache_fetch(ctx, off)) != NULL) {
+        return __mln_lang_var_new_ref_string(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL);
+    }
     if ((val = __mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &off)) == NULL) {
         return NULL;
     }
@@ -1231,6 +1552,9 @@ mln_lang_var_t *mln_lang_var_create_string(mln_lang_ctx_t *ctx, mln_string_t *s,
     mln_lang_val_t *val;
     mln_lang_var_t *var;
     mln_string_t *dup;
+    if (name == NULL && (val = mln_lang_ctx_str_cache_fetch(ctx, s)) != NULL) {
+        return __mln_lang_var_new_ref_string(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL);
+    }
     if ((dup = mln_string_pool_dup(ctx->pool, s)) == NULL) {
         return NULL;
     }
@@ -1572,6 +1896,13 @@ static int mln_lang_set_member_iterate_handler(mln_rbtree_node_t *node, void *ud
     return 0;
 }
 
+static mln_u64_t mln_lang_object_shape_counter = 0;
+
+void mln_lang_object_shape_restamp(mln_lang_object_t *obj)
+{
+    obj->version = ++mln_lang_object_shape_counter;
+}
+
 int mln_lang_object_add_member(mln_lang_ctx_t *ctx, mln_lang_object_t *obj, mln_lang_var_t *var)
 {
     mln_lang_var_t *dup;
@@ -1589,6 +1920,7 @@ int mln_lang_object_add_member(mln_lang_ctx_t *ctx, mln_lang_object_t *obj, mln_
         __mln_lang_var_free(dup);
         return -1;
     }
+    mln_lang_object_shape_restamp(obj);
     return 0;
 }
 
@@ -1602,6 +1934,103 @@ mln_lang_var_t *mln_lang_var_new(mln_lang_ctx_t *ctx, \
     return __mln_lang_var_new(ctx, name, type, val, in_set);
 }
 
+mln_lang_var_t *
+mln_lang_var_result(mln_lang_ctx_t *ctx, mln_lang_var_t *reuse, mln_s32_t type, void *data)
+{
+    mln_lang_val_t *val;
+    mln_lang_var_t *var;
+    /*
+     * A dying temporary: anonymous, not referenced elsewhere and the sole
+     * owner of an unshared scalar value. Such a variable is discarded by
+     * the caller right after this operation, so its cells can carry the
+     * result instead. The extra reference keeps it alive through the
+     * caller's release of the operand.
+     */
+    if (reuse != NULL && reuse->ref == 0 && reuse->name == NULL && reuse->in_set == NULL && \
+        (val = reuse->val) != NULL && val->ref == 1 && !val->not_modify && \
+        val->udata == NULL && val->func == NULL && \
+        (val->type == M_LANG_VAL_TYPE_NIL || val->type == M_LANG_VAL_TYPE_BOOL || \
+         val->type == M_LANG_VAL_TYPE_INT || val->type == M_LANG_VAL_TYPE_REAL))
+    {
+        switch (type) {
+            case M_LANG_VAL_TYPE_NIL:
+                break;
+            case M_LANG_VAL_TYPE_INT:
+                val->data.i = *(mln_s64_t *)data;
+                break;
+            case M_LANG_VAL_TYPE_BOOL:
+                val->data.b = *(mln_u8ptr_t)data;
+                break;
+            case M_LANG_VAL_TYPE_REAL:
+                val->data.f = *(double *)data;
+                break;
+            default:
+                goto fresh;
+        }
+        val->type = type;
+        return mln_lang_var_ref(reuse);
+    }
+fresh:
+    if ((val = __mln_lang_val_new(ctx, type, data)) == NULL) {
+        return NULL;
+    }
+    if ((var = __mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+        __mln_lang_val_free(val);
+        return NULL;
+    }
+    return var;
+}
+
+#define M_LANG_CELL_CACHE_MAX 4096
+
+static inline mln_lang_var_t *
+mln_lang_ctx_var_cell_get(mln_lang_ctx_t *ctx)
+{
+    mln_lang_var_t *var = ctx->cell_vars;
+    if (var != NULL) {
+        ctx->cell_vars = var->next;
+        --(ctx->cell_nvars);
+        return var;
+    }
+    return (mln_lang_var_t *)mln_alloc_m(ctx->pool, sizeof(mln_lang_var_t));
+}
+
+static inline void mln_lang_ctx_var_cell_put(mln_lang_var_t *var)
+{
+    mln_lang_ctx_t *ctx = var->ctx;
+    if (ctx == NULL || ctx->cell_nvars >= M_LANG_CELL_CACHE_MAX) {
+        mln_alloc_free(var);
+        return;
+    }
+    var->next = ctx->cell_vars;
+    ctx->cell_vars = var;
+    ++(ctx->cell_nvars);
+}
+
+static inline mln_lang_val_t *
+mln_lang_ctx_val_cell_get(mln_lang_ctx_t *ctx)
+{
+    mln_lang_val_t *val = ctx->cell_vals;
+    if (val != NULL) {
+        ctx->cell_vals = val->next;
+        --(ctx->cell_nvals);
+        return val;
+    }
+    return (mln_lang_val_t *)mln_alloc_m(ctx->pool, sizeof(mln_lang_val_t));
+}
+
+static inline void mln_lang_ctx_val_cell_put(mln_lang_val_t *val)
+{
+    mln_lang_ctx_t *ctx = val->ctx;
+    if (ctx == NULL || ctx->cell_nvals >= M_LANG_CELL_CACHE_MAX) {
+        mln_alloc_free(val);
+        return;
+    }
+    val->next = ctx->cell_vals;
+    ctx->cell_vals = val;
+    ++(ctx->cell_nvals);
+}
+
 static inline mln_lang_var_t *
 __mln_lang_var_new(mln_lang_ctx_t *ctx, \
                    mln_string_t *name, \
@@ -1610,9 +2039,10 @@ __mln_lang_var_new(mln_lang_ctx_t *ctx, \
                    mln_lang_set_detail_t *in_set)
 {
     mln_lang_var_t *var;
-    if ((var = (mln_lang_var_t *)mln_alloc_m(ctx->pool, sizeof(mln_lang_var_t))) == NULL) {
+    if ((var = mln_lang_ctx_var_cell_get(ctx)) == NULL) {
         return NULL;
     }
+    var->ctx = ctx;
     var->type = type;
     if (name != NULL) {
         if ((var->name = mln_string_pool_dup(ctx->pool, name)) == NULL) {
@@ -1639,9 +2069,10 @@ __mln_lang_var_new_ref_string(mln_lang_ctx_t *ctx, \
                               mln_lang_set_detail_t *in_set)
 {
     mln_lang_var_t *var;
-    if ((var = (mln_lang_var_t *)mln_alloc_m(ctx->pool, sizeof(mln_lang_var_t))) == NULL) {
+    if ((var = mln_lang_ctx_var_cell_get(ctx)) == NULL) {
         return NULL;
     }
+    var->ctx = ctx;
     var->type = type;
     if (name != NULL) {
         var->name = mln_string_ref(name);
@@ -1661,9 +2092,10 @@ static inline mln_lang_var_t *
 mln_lang_var_transform(mln_lang_ctx_t *ctx, mln_lang_var_t *realvar, mln_lang_var_t *defvar)
 {
     mln_lang_var_t *var;
-    if ((var = (mln_lang_var_t *)mln_alloc_m(ctx->pool, sizeof(mln_lang_var_t))) == NULL) {
+    if ((var = mln_lang_ctx_var_cell_get(ctx)) == NULL) {
         return NULL;
     }
+    var->ctx = ctx;
     var->type = defvar->type;
     ASSERT(defvar->name != NULL);
     var->name = mln_string_ref(defvar->name);
@@ -1707,7 +2139,7 @@ static inline void __mln_lang_var_free(void *data)
         mln_lang_set_detail_free(var->in_set);
         var->in_set = NULL;
     }
-    mln_alloc_free(var);
+    mln_lang_ctx_var_cell_put(var);
 }
 
 mln_lang_var_t *mln_lang_var_dup(mln_lang_ctx_t *ctx, mln_lang_var_t *var)
@@ -1996,6 +2428,18 @@ mln_lang_func_detail_t *mln_lang_func_detail_new(mln_lang_ctx_t *ctx, \
     return __mln_lang_func_detail_new(ctx, type, data, exp, closure);
 }
 
+mln_lang_func_detail_t *
+mln_lang_func_detail_leaf_new(mln_lang_ctx_t *ctx, mln_lang_internal_leaf process)
+{
+    mln_lang_func_detail_t *lfd;
+    if ((lfd = __mln_lang_func_detail_new(ctx, M_FUNC_INTERNAL, NULL, NULL, NULL)) == NULL) {
+        return NULL;
+    }
+    lfd->data.leaf_process = process;
+    lfd->leaf = 1;
+    return lfd;
+}
+
 static inline mln_lang_func_detail_t *
 __mln_lang_func_detail_new(mln_lang_ctx_t *ctx, \
                            mln_lang_func_type_t type, \
@@ -2014,6 +2458,7 @@ __mln_lang_func_detail_new(mln_lang_ctx_t *ctx, \
     lfd->closure_tail = NULL;
     lfd->nargs = 0;
     lfd->type = type;
+    lfd->leaf = 0;
     switch (type) {
         case M_FUNC_INTERNAL:
             lfd->data.process = (mln_lang_internal)data;
@@ -2073,6 +2518,7 @@ mln_lang_func_detail_dup(mln_lang_ctx_t *ctx, mln_lang_func_detail_t *func)
     }
     ret = __mln_lang_func_detail_new(ctx, func->type, data, NULL, NULL);
     if (ret == NULL) return NULL;
+    ret->leaf = func->leaf;
 
     for (var = func->args_head; var != NULL; var = var->next, ++(ret->nargs)) {
         if ((newvar = __mln_lang_var_dup(ctx, var)) == NULL) {
@@ -2130,6 +2576,7 @@ mln_lang_object_new(mln_lang_ctx_t *ctx, mln_lang_set_detail_t *in_set)
             return NULL;
         }
     }
+    mln_lang_object_shape_restamp(obj);
     obj->gc_item = NULL;
     obj->ctx = ctx;
 
@@ -2171,9 +2618,10 @@ static inline mln_lang_val_t *
 __mln_lang_val_new(mln_lang_ctx_t *ctx, mln_s32_t type, void *data)
 {
     mln_lang_val_t *val;
-    if ((val = (mln_lang_val_t *)mln_alloc_m(ctx->pool, sizeof(mln_lang_val_t))) == NULL) {
+    if ((val = mln_lang_ctx_val_cell_get(ctx)) == NULL) {
         return NULL;
     }
+    val->ctx = ctx;
     val->prev = val->next = NULL;
     switch (type) {
         case M_LANG_VAL_TYPE_NIL:
@@ -2236,7 +2684,7 @@ static inline void __mln_lang_val_free(void *data)
         val->func = NULL;
     }
     mln_lang_val_data_free(val);
-    mln_alloc_free(val);
+    mln_lang_ctx_val_cell_put(val);
 }
 
 static inline void mln_lang_val_data_free(mln_lang_val_t *val)
@@ -2428,8 +2876,12 @@ static inline mln_lang_array_t *__mln_lang_array_new(mln_lang_ctx_t *ctx)
         mln_alloc_free(la);
         return NULL;
     }
+    la->vec = NULL;
+    la->vec_n = 0;
+    la->vec_cap = 0;
     la->index = 0;
     la->ref = 0;
+    la->spilled = 0;
     la->gc_item = NULL;
     la->ctx = ctx;
 
@@ -2457,6 +2909,13 @@ static inline void __mln_lang_array_free(mln_lang_array_t *array)
     }
     if (array->elems_key != NULL) mln_rbtree_free(array->elems_key);
     if (array->elems_index != NULL) mln_rbtree_free(array->elems_index);
+    if (array->vec != NULL) {
+        mln_u64_t i;
+        for (i = 0; i < array->vec_n; ++i) {
+            if (array->vec[i] != NULL) __mln_lang_var_free(array->vec[i]);
+        }
+        mln_alloc_free(array->vec);
+    }
 
     if (array->gc_item != NULL) {
         if (array->gc_item->gc != NULL)
@@ -2534,6 +2993,59 @@ __mln_lang_array_get(mln_lang_ctx_t *ctx, mln_lang_array_t *array, mln_lang_var_
     return ret;
 }
 
+static inline mln_lang_var_t *
+mln_lang_array_vec_append(mln_lang_ctx_t *ctx, mln_lang_array_t *array)
+{
+    mln_lang_var_t *nil, **v;
+    if (array->vec_n >= array->vec_cap) {
+        mln_u64_t cap = array->vec_cap? (array->vec_cap << 1): 8;
+        if (array->vec == NULL)
+            v = (mln_lang_var_t **)mln_alloc_m(ctx->pool, cap * sizeof(mln_lang_var_t *));
+        else
+            v = (mln_lang_var_t **)mln_alloc_re(ctx->pool, array->vec, cap * sizeof(mln_lang_var_t *));
+        if (v == NULL) {
+            __mln_lang_errmsg(ctx, "No memory.");
+            return NULL;
+        }
+        array->vec = v;
+        array->vec_cap = cap;
+    }
+    if ((nil = __mln_lang_var_create_nil(ctx, NULL)) == NULL) {
+        __mln_lang_errmsg(ctx, "No memory.");
+        return NULL;
+    }
+    array->vec[array->vec_n++] = nil;
+    if (array->index < array->vec_n) array->index = array->vec_n;
+    return nil;
+}
+
+static int mln_lang_array_spill(mln_lang_ctx_t *ctx, mln_lang_array_t *array)
+{
+    mln_u64_t i, n = array->vec_n;
+    mln_rbtree_t *tree = array->elems_index;
+    mln_rbtree_node_t *rn;
+    mln_lang_array_elem_t *elem;
+    for (i = 0; i < n; ++i) {
+        if ((elem = mln_lang_array_elem_new(ctx->pool, NULL, array->vec[i], i)) == NULL) {
+            return -1;
+        }
+        if ((rn = mln_rbtree_node_new(tree, elem)) == NULL) {
+            elem->value = NULL;/*still owned by the vector*/
+            mln_lang_array_elem_free(elem);
+            return -1;
+        }
+        mln_rbtree_insert(tree, rn);
+        array->vec[i] = NULL;
+    }
+    if (array->vec != NULL) {
+        mln_alloc_free(array->vec);
+        array->vec = NULL;
+    }
+    array->vec_n = array->vec_cap = 0;
+    array->spilled = 1;
+    return 0;
+}
+
 static inline mln_lang_var_t *
 mln_lang_array_get_int(mln_lang_ctx_t *ctx, mln_lang_array_t *array, mln_lang_var_t *key)
 {
@@ -2541,6 +3053,15 @@ mln_lang_array_get_int(mln_lang_ctx_t *ctx, mln_lang_array_t *array, mln_lang_va
     mln_rbtree_node_t *rn;
     mln_lang_var_t *ret, *nil;
     mln_lang_array_elem_t *elem;
+    if (!array->spilled) {
+        mln_u64_t i = (mln_u64_t)key->val->data.i;
+        if (i < array->vec_n) return array->vec[i];
+        if (i == array->vec_n) return mln_lang_array_vec_append(ctx, array);
+        if (mln_lang_array_spill(ctx, array) < 0) {
+            __mln_lang_errmsg(ctx, "No memory.");
+            return NULL;
+        }
+    }
     if ((nil = __mln_lang_var_create_nil(ctx, NULL)) == NULL) {
         __mln_lang_errmsg(ctx, "No memory.");
         return NULL;
@@ -2576,6 +3097,10 @@ mln_lang_array_get_other(mln_lang_ctx_t *ctx, mln_lang_array_t *array, mln_lang_
     mln_rbtree_node_t *rn;
     mln_lang_var_t *ret, *nil, *k;
     mln_lang_array_elem_t *elem;
+    if (!array->spilled && mln_lang_array_spill(ctx, array) < 0) {
+        __mln_lang_errmsg(ctx, "No memory.");
+        return NULL;
+    }
     if ((nil = __mln_lang_var_create_nil(ctx, NULL)) == NULL) {
         __mln_lang_errmsg(ctx, "No memory.");
         return NULL;
@@ -2622,6 +3147,13 @@ mln_lang_array_get_nil(mln_lang_ctx_t *ctx, mln_lang_array_t *array)
     mln_rbtree_node_t *rn;
     mln_lang_var_t *nil;
     mln_lang_array_elem_t *elem;
+    if (!array->spilled && array->index == array->vec_n) {
+        return mln_lang_array_vec_append(ctx, array);
+    }
+    if (!array->spilled && mln_lang_array_spill(ctx, array) < 0) {
+        __mln_lang_errmsg(ctx, "No memory.");
+        return NULL;
+    }
     if ((nil = __mln_lang_var_create_nil(ctx, NULL)) == NULL) {
         __mln_lang_errmsg(ctx, "No memory.");
         return NULL;
@@ -2648,6 +3180,12 @@ int mln_lang_array_elem_exist(mln_lang_array_t *array, mln_lang_var_t *key)
     mln_lang_var_t *nil, *k;
     mln_lang_array_elem_t *elem;
     mln_lang_ctx_t *ctx = array->ctx;
+    if (!array->spilled) {
+        /*dense arrays keep the trees empty*/
+        if (mln_lang_var_val_type_get(key) == M_LANG_VAL_TYPE_INT)
+            return (mln_u64_t)key->val->data.i < array->vec_n? 1: 0;
+        return 0;
+    }
     if ((nil = __mln_lang_var_create_nil(ctx, NULL)) == NULL) {
         return 0;
     }
@@ -3518,7 +4056,9 @@ static inline int __mln_lang_condition_is_true(mln_lang_var_t *var)
             if (val->data.func != NULL) return 1;
             break;
         case M_LANG_VAL_TYPE_ARRAY:
-            if (val->data.array != NULL && mln_rbtree_node_num(val->data.array->elems_index) > 0) return 1;
+            if (val->data.array != NULL && \
+                (val->data.array->vec_n > 0 || mln_rbtree_node_num(val->data.array->elems_index) > 0))
+                return 1;
             break;
         default:
             mln_log(error, "shouldn't be here. %X\n", val->type);
@@ -5089,19 +5629,45 @@ again_index:
         }
         mln_lang_var_t *res = NULL;
         mln_lang_var_t *var;
-        if ((var = mln_lang_var_create_string(ctx, locate->right.id, NULL)) == NULL) {
-            __mln_lang_errmsg(ctx, "No memory.");
-            node->ret_var2 = NULL;
-            ctx->quit = 1;
-            return;
-        }
-        if (method->property_handler(ctx, &res, ctx->ret_var, var) < 0) {
+        /*
+         * Inline cache: a repeated o.field at this site takes the
+         * member slot recorded on the last resolution, as long as the
+         * object still carries the shape stamp the slot was resolved
+         * under, skipping the member tree walk and the name-string
+         * allocation. Operator-overloaded property access bypasses it,
+         * and so do contexts on a shared AST: the cache words live in
+         * the statement node, which other threads walk concurrently.
+         */
+        if (!ctx->op_obj_flag && !ctx->shared_stm && \
+            mln_lang_var_val_type_get(ctx->ret_var) == M_LANG_VAL_TYPE_OBJECT) {
+            mln_lang_object_t *obj = mln_lang_var_val_get(ctx->ret_var)->data.obj;
+            if (locate->cache_members == (void *)obj->members && locate->cache_version == obj->version)
+                res = mln_lang_var_ref((mln_lang_var_t *)locate->cache_var);
+        }
+        if (res == NULL) {
+            if ((var = mln_lang_var_create_string(ctx, locate->right.id, NULL)) == NULL) {
+                __mln_lang_errmsg(ctx, "No memory.");
+                node->ret_var2 = NULL;
+                ctx->quit = 1;
+                return;
+            }
+            if (method->property_handler(ctx, &res, ctx->ret_var, var) < 0) {
+                __mln_lang_var_free(var);
+                node->ret_var2 = NULL;
+                ctx->quit = 1;
+                return;
+            }
             __mln_lang_var_free(var);
-            node->ret_var2 = NULL;
-            ctx->quit = 1;
-            return;
+            if (res != NULL && !ctx->op_obj_flag && !ctx->shared_stm && \
+                mln_lang_var_val_type_get(ctx->ret_var) == M_LANG_VAL_TYPE_OBJECT && \
+                res->val->type != M_LANG_VAL_TYPE_CALL)
+            {
+                mln_lang_object_t *obj = mln_lang_var_val_get(ctx->ret_var)->data.obj;
+                locate->cache_members = (void *)obj->members;
+                locate->cache_version = obj->version;
+                locate->cache_var = (void *)res;
+            }
         }
-        __mln_lang_var_free(var);
         ctx->ret_var = NULL;
         __mln_lang_ctx_set_ret_var(ctx, res);
         if (res->val->type == M_LANG_VAL_TYPE_CALL) {
@@ -5303,6 +5869,38 @@ static inline int mln_lang_stack_handler_funccall_run(mln_lang_ctx_t *ctx, \
         }
     }
 
+    /*
+     * Fast call path for leaf natives. The handler declared that it never
+     * suspends and never retains its arguments, so the evaluated arguments
+     * are handed over borrowed -- no duplication, no symbols joined into
+     * the scope. The scope itself is still pushed because the caller
+     * withdraws it unconditionally once the call returns.
+     */
+    if (prototype->type == M_FUNC_INTERNAL && prototype->leaf && funccall->object == NULL) {
+        mln_lang_var_t *argv[M_LANG_LEAF_ARGS_MAX];
+        mln_size_t nargs = 0;
+        for (var = funccall->args_head; var != NULL && nargs < M_LANG_LEAF_ARGS_MAX; var = var->next) {
+            argv[nargs++] = var;
+        }
+        if (mln_lang_scope_push(ctx, funcname, M_LANG_SCOPE_TYPE_FUNC, node, NULL) == NULL) {
+            __mln_lang_errmsg(ctx, "Scope stack is full.");
+            return -1;
+        }
+        mln_lang_ctx_reset_ret_var(ctx);
+        if (prototype->data.leaf_process == NULL) {
+            __mln_lang_errmsg(ctx, "Not implemented.");
+            return -1;
+        }
+        pthread_mutex_lock(&ctx->lang->lock);
+        if ((var = prototype->data.leaf_process(ctx, argv, nargs)) == NULL) {
+            pthread_mutex_unlock(&ctx->lang->lock);
+            return -1;
+        }
+        __mln_lang_ctx_set_ret_var(ctx, var);
+        pthread_mutex_unlock(&ctx->lang->lock);
+        return 0;
+    }
+
     if ((scope = mln_lang_scope_push(ctx, funcname, M_LANG_SCOPE_TYPE_FUNC, node, NULL)) == NULL) {
         __mln_lang_errmsg(ctx, "Scope stack is full.");
         return -1;
@@ -6012,6 +6610,17 @@ static void mln_lang_dump_array(mln_lang_array_t *array, int cnt, mln_rbtree_t *
     }
     blank();
     mln_log(none, "ALL ELEMENTS:\n");
+    {
+        mln_u64_t i;
+        for (i = 0; i < array->vec_n; ++i) {
+            if (array->vec[i] == NULL) continue;
+            blank();
+            mln_log(none, "Index: %I\n", i);
+            blank();
+            mln_log(none, "Value:\n");
+            mln_lang_dump_var(array->vec[i], tmp+2, check);
+        }
+    }
     mln_rbtree_iterate(array->elems_index, mln_lang_dump_array_elem, &ls);
     blank();
     mln_log(none, "KEY ELEMENTS:\n");
@@ -6967,9 +7576,27 @@ static void mln_lang_gc_item_member_setter_recursive(struct mln_lang_gc_setter_s
             mln_rbtree_iterate(t, mln_lang_gc_item_member_setter_obj_iterate_handler, lgs);
             break;
         default:
-            t = gc_item->data.array->elems_index;
+        {
+            mln_lang_array_t *a = gc_item->data.array;
+            mln_u64_t i;
+            mln_s32_t type;
+            mln_lang_val_t *val;
+            for (i = 0; i < a->vec_n; ++i) {
+                if (a->vec[i] == NULL) continue;
+                type = mln_lang_var_val_type_get(a->vec[i]);
+                val = mln_lang_var_val_get(a->vec[i]);
+                if (type == M_LANG_VAL_TYPE_OBJECT) {
+                    mln_gc_collect_add(lgs->gc, val->data.obj->gc_item);
+                    mln_lang_gc_item_member_setter_recursive(lgs, val->data.obj->gc_item);
+                } else if (type == M_LANG_VAL_TYPE_ARRAY) {
+                    mln_gc_collect_add(lgs->gc, val->data.array->gc_item);
+                    mln_lang_gc_item_member_setter_recursive(lgs, val->data.array->gc_item);
+                }
+            }
+            t = a->elems_index;
             mln_rbtree_iterate(t, mln_lang_gc_item_member_setter_array_iterate_handler, lgs);
             break;
+        }
     }
 }
 
@@ -7060,11 +7687,39 @@ static void mln_lang_gc_item_clean_searcher(mln_gc_t *gc, mln_lang_gc_item_t *gc
             mln_rbtree_iterate(t, mln_lang_gc_item_clean_searcher_obj_iterate_handler, &gs);
             break;
         default:
-            t = gc_item->data.array->elems_index;
+        {
+            mln_lang_array_t *a = gc_item->data.array;
+            mln_u64_t i;
+            mln_s32_t type;
+            mln_lang_val_t *val;
+            for (i = 0; i < a->vec_n; ++i) {
+                if (a->vec[i] == NULL) continue;
+                type = mln_lang_var_val_type_get(a->vec[i]);
+                val = mln_lang_var_val_get(a->vec[i]);
+                if (type == M_LANG_VAL_TYPE_OBJECT) {
+                    if (mln_gc_clean_add(gc, val->data.obj->gc_item) < 0) {
+                        if (val->data.obj->ref > 0) {
+                            --(val->data.obj->ref);
+                        }
+                        val->data.obj = NULL;
+                        val->type = M_LANG_VAL_TYPE_NIL;/*the slot stays, the cycle member goes*/
+                    }
+                } else if (type == M_LANG_VAL_TYPE_ARRAY) {
+                    if (mln_gc_clean_add(gc, val->data.array->gc_item) < 0) {
+                        if (val->data.array->ref > 0) {
+                            --(val->data.array->ref);
+                        }
+                        val->data.array = NULL;
+                        val->type = M_LANG_VAL_TYPE_NIL;
+                    }
+                }
+            }
+            t = a->elems_index;
             gs.tree = t;
             gs.gc = gc;
             mln_rbtree_iterate(t, mln_lang_gc_item_clean_searcher_array_iterate_handler, &gs);
             break;
+        }
     }
 }
 
@@ -7305,6 +7960,106 @@ static inline mln_lang_hash_bucket_t *mln_lang_hash_get_bucket(mln_lang_hash_t *
     return &h->bucket[(idx * sym->layer) % h->len];
 }
 
+/*
+ * constant caches
+ * Small integer and string constants are produced over and over again in
+ * script loops. Every cached value is shared by reference and marked
+ * not-modify, so the mutation guards in the stack handlers keep scripts
+ * from writing through a shared value. The caches hold one reference on
+ * each value and drop it in mln_lang_ctx_free().
+ */
+static inline mln_lang_val_t *mln_lang_ctx_int_cache_fetch(mln_lang_ctx_t *ctx, mln_s64_t i)
+{
+    mln_lang_val_t *val;
+    if (i < M_LANG_INT_CACHE_MIN || i > M_LANG_INT_CACHE_MAX) return NULL;
+    if (ctx->int_cache == NULL) {
+        mln_size_t size = (M_LANG_INT_CACHE_MAX - M_LANG_INT_CACHE_MIN + 1) * sizeof(mln_lang_val_t *);
+        if ((ctx->int_cache = (mln_lang_val_t **)mln_alloc_c(ctx->pool, size)) == NULL)
+            return NULL;
+    }
+    if ((val = ctx->int_cache[i - M_LANG_INT_CACHE_MIN]) == NULL) {
+        if ((val = __mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL)
+            return NULL;
+        mln_lang_val_not_modify_set(val);
+        ++(val->ref);
+        ctx->int_cache[i - M_LANG_INT_CACHE_MIN] = val;
+    }
+    return val;
+}
+
+static inline mln_lang_val_t *mln_lang_ctx_str_cache_fetch(mln_lang_ctx_t *ctx, mln_string_t *s)
+{
+    mln_u64_t idx = 0, i, n = s->len;
+    mln_u8ptr_t p = s->data;
+    mln_string_t *dup;
+    mln_lang_val_t *val;
+    mln_lang_str_cache_node_t *cn;
+
+    if (n > M_LANG_STR_CACHE_MAX_LEN) return NULL;
+    if (ctx->str_cache == NULL) {
+        mln_lang_str_cache_t *cache;
+        if ((cache = (mln_lang_str_cache_t *)mln_alloc_m(ctx->pool, sizeof(mln_lang_str_cache_t))) == NULL)
+            return NULL;
+        if ((cache->bucket = (mln_lang_str_cache_node_t **)mln_alloc_c(ctx->pool, \
+                                 sizeof(mln_lang_str_cache_node_t *)*M_LANG_STR_CACHE_TABLE_LEN)) == NULL)
+        {
+            mln_alloc_free(cache);
+            return NULL;
+        }
+        cache->len = M_LANG_STR_CACHE_TABLE_LEN;
+        ctx->str_cache = cache;
+    }
+    for (i = 0; i < n; ++i) {
+        idx += p[i];
+    }
+    idx %= ctx->str_cache->len;
+    for (cn = ctx->str_cache->bucket[idx]; cn != NULL; cn = cn->next) {
+        if (!mln_string_strcmp(cn->val->data.s, s)) return cn->val;
+    }
+    if ((cn = (mln_lang_str_cache_node_t *)mln_alloc_m(ctx->pool, sizeof(mln_lang_str_cache_node_t))) == NULL)
+        return NULL;
+    if ((dup = mln_string_pool_dup(ctx->pool, s)) == NULL) {
+        mln_alloc_free(cn);
+        return NULL;
+    }
+    if ((val = __mln_lang_val_new(ctx, M_LANG_VAL_TYPE_STRING, dup)) == NULL) {
+        mln_string_free(dup);
+        mln_alloc_free(cn);
+        return NULL;
+    }
+    mln_lang_val_not_modify_set(val);
+    ++(val->ref);
+    cn->val = val;
+    cn->next = ctx->str_cache->bucket[idx];
+    ctx->str_cache->bucket[idx] = cn;
+    return val;
+}
+
+static inline void mln_lang_ctx_const_cache_release(mln_lang_ctx_t *ctx)
+{
+    if (ctx->int_cache != NULL) {
+        mln_lang_val_t **v, **end;
+        for (v = ctx->int_cache, end = v + (M_LANG_INT_CACHE_MAX - M_LANG_INT_CACHE_MIN + 1); v < end; ++v) {
+            if (*v != NULL) __mln_lang_val_free(*v);
+        }
+        mln_alloc_free(ctx->int_cache);
+        ctx->int_cache = NULL;
+    }
+    if (ctx->str_cache != NULL) {
+        mln_lang_str_cache_node_t **b, **end, *cn;
+        for (b = ctx->str_cache->bucket, end = b + ctx->str_cache->len; b < end; ++b) {
+            while ((cn = *b) != NULL) {
+                *b = cn->next;
+                __mln_lang_val_free(cn->val);
+                mln_alloc_free(cn);
+            }
+        }
+        mln_alloc_free(ctx->str_cache->bucket);
+        mln_alloc_free(ctx->str_cache);
+        ctx->str_cache = NULL;
+    }
+}
+
 /*
  * pipe for communication between C code and script
  */
@@ -1901,6 +1901,9 @@ mln_lang_locate_new(mln_alloc_t *pool, \
     }
     ll->jump = NULL;
     ll->type = 0;
+    ll->cache_members = NULL;
+    ll->cache_version = 0;
+    ll->cache_var = NULL;
     ll->next = NULL;
     if (next != NULL) {
         mln_lang_locate_t *tmp = ll;
@@ -1918,6 +1921,9 @@ mln_lang_locate_new(mln_alloc_t *pool, \
             n->line = line;
             n->left = NULL;
             n->op = next->op;
+            n->cache_members = NULL;
+            n->cache_version = 0;
+            n->cache_var = NULL;
             n->next = NULL;
             switch (n->op) {
                 case M_LOCATE_INDEX:
@@ -0,0 +1,1154 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#if !defined(WIN32)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "mln_lang_bc.h"
+
+/*
+ * The bytecode engine is an alternative execution stage for script
+ * tasks. mln_lang_bc_compile() walks the AST once and flattens it into
+ * an instruction array; mln_lang_bc_run() then executes it with a
+ * computed-goto dispatch loop, which removes the per-step stack-node
+ * dispatch of the AST walker. Operator semantics are untouched: every
+ * operation still goes through the mln_lang_methods tables, symbols
+ * still live in the context's symbol hash, and the scheduler slices
+ * execution with a budget charged per backward branch. Constructs the
+ * compiler does not cover simply leave the task on the AST walker.
+ */
+
+/*opcodes; the order must match the dispatch table in mln_lang_bc_run()*/
+enum {
+    M_LANG_BC_NIL = 0, /*push nil literal*/
+    M_LANG_BC_TRUE,    /*push true literal*/
+    M_LANG_BC_FALSE,   /*push false literal*/
+    M_LANG_BC_INT,     /*push integer literal (data.i)*/
+    M_LANG_BC_REAL,    /*push real literal (data.f)*/
+    M_LANG_BC_STR,     /*push string literal (data.s)*/
+    M_LANG_BC_LOAD,    /*push variable (data.s), created as nil when absent*/
+    M_LANG_BC_POP,     /*drop the stack top*/
+    M_LANG_BC_SETRET,  /*pop into ctx->ret_var*/
+    M_LANG_BC_RESET,   /*clear ctx->ret_var*/
+    M_LANG_BC_JMP,     /*jump to target*/
+    M_LANG_BC_JF,      /*pop; jump to target when false*/
+    M_LANG_BC_JFS,     /*pop; when false set ctx->ret_var and jump*/
+    M_LANG_BC_AND,     /*when top is false jump keeping it, else pop*/
+    M_LANG_BC_OR,      /*when top is true jump keeping it, else pop*/
+    M_LANG_BC_BINOP,   /*pop two, apply method at moff of the left operand*/
+    M_LANG_BC_UNOP,    /*pop one, apply method at moff; target!=0 means it mutates*/
+    M_LANG_BC_STORE,   /*pop value, assign into variable (data.s) via moff*/
+    M_LANG_BC_RET,     /*finish the task with ctx->ret_var (nil when unset)*/
+    M_LANG_BC_END      /*finish the task*/
+};
+
+#define mln_lang_bc_moff(m) ((mln_u16_t)offsetof(mln_lang_method_t, m))
+
+typedef struct {
+    mln_lang_ctx_t                  *ctx;
+    mln_lang_bc_t                   *bc;
+    mln_s32_t                        break_head;
+    mln_s32_t                        cont_head;
+    int                              in_loop;
+} mln_lang_bc_gen_t;
+
+static mln_s32_t mln_lang_bc_emit(mln_lang_bc_gen_t *g, mln_u16_t op, mln_u16_t moff, mln_s32_t target);
+static int mln_lang_bc_gen_stm(mln_lang_bc_gen_t *g, mln_lang_stm_t *stm);
+static int mln_lang_bc_gen_block(mln_lang_bc_gen_t *g, mln_lang_block_t *block);
+static int mln_lang_bc_gen_if(mln_lang_bc_gen_t *g, mln_lang_if_t *i);
+static int mln_lang_bc_gen_while(mln_lang_bc_gen_t *g, mln_lang_while_t *w);
+static int mln_lang_bc_gen_for(mln_lang_bc_gen_t *g, mln_lang_for_t *f);
+static int mln_lang_bc_gen_exp(mln_lang_bc_gen_t *g, mln_lang_exp_t *exp);
+static int mln_lang_bc_gen_assign(mln_lang_bc_gen_t *g, mln_lang_assign_t *assign);
+static int mln_lang_bc_gen_logiclow(mln_lang_bc_gen_t *g, mln_lang_logiclow_t *ll);
+static int mln_lang_bc_gen_logichigh(mln_lang_bc_gen_t *g, mln_lang_logichigh_t *lh);
+static int mln_lang_bc_gen_relativelow(mln_lang_bc_gen_t *g, mln_lang_relativelow_t *rl);
+static int mln_lang_bc_gen_relativehigh(mln_lang_bc_gen_t *g, mln_lang_relativehigh_t *rh);
+static int mln_lang_bc_gen_move(mln_lang_bc_gen_t *g, mln_lang_move_t *mv);
+static int mln_lang_bc_gen_addsub(mln_lang_bc_gen_t *g, mln_lang_addsub_t *as);
+static int mln_lang_bc_gen_muldiv(mln_lang_bc_gen_t *g, mln_lang_muldiv_t *md);
+static int mln_lang_bc_gen_suffix(mln_lang_bc_gen_t *g, mln_lang_suffix_t *suffix);
+static int mln_lang_bc_gen_locate(mln_lang_bc_gen_t *g, mln_lang_locate_t *locate);
+static int mln_lang_bc_gen_spec(mln_lang_bc_gen_t *g, mln_lang_spec_t *spec);
+static int mln_lang_bc_gen_factor(mln_lang_bc_gen_t *g, mln_lang_factor_t *factor);
+static mln_string_t *mln_lang_bc_lvalue(mln_lang_assign_t *assign);
+static mln_lang_symbol_node_t *mln_lang_bc_symbol_fetch(mln_lang_ctx_t *ctx, mln_string_t *name);
+
+static mln_s32_t mln_lang_bc_emit(mln_lang_bc_gen_t *g, mln_u16_t op, mln_u16_t moff, mln_s32_t target)
+{
+    mln_lang_bc_t *bc = g->bc;
+    mln_lang_bc_inst_t *inst;
+
+    if (bc->ninst >= bc->cap) {
+        mln_size_t cap = bc->cap << 1;
+        if ((inst = (mln_lang_bc_inst_t *)mln_alloc_m(g->ctx->pool, cap * sizeof(mln_lang_bc_inst_t))) == NULL)
+            return -1;
+        memcpy(inst, bc->insts, bc->ninst * sizeof(mln_lang_bc_inst_t));
+        mln_alloc_free(bc->insts);
+        bc->insts = inst;
+        bc->cap = cap;
+    }
+    inst = &bc->insts[bc->ninst];
+    inst->op = op;
+    inst->moff = moff;
+    inst->target = target;
+    inst->data.i = 0;
+    inst->sym = NULL;
+    return (mln_s32_t)(bc->ninst++);
+}
+
+static inline void mln_lang_bc_patch(mln_lang_bc_gen_t *g, mln_s32_t pos, mln_s32_t target)
+{
+    if (pos >= 0) g->bc->insts[pos].target = target;
+}
+
+/*walk a chain of pending jumps linked through 'target' and point them all at 'target'*/
+static inline void mln_lang_bc_patch_chain(mln_lang_bc_gen_t *g, mln_s32_t head, mln_s32_t target)
+{
+    mln_s32_t next;
+    while (head >= 0) {
+        next = g->bc->insts[head].target;
+        g->bc->insts[head].target = target;
+        head = next;
+    }
+}
+
+static int mln_lang_bc_gen_stm(mln_lang_bc_gen_t *g, mln_lang_stm_t *stm)
+{
+    for (; stm != NULL; stm = stm->next) {
+        switch (stm->type) {
+            case M_STM_BLOCK:
+                if (mln_lang_bc_gen_block(g, stm->data.block) < 0) return -1;
+                break;
+            case M_STM_WHILE:
+                if (mln_lang_bc_gen_while(g, stm->data.w) < 0) return -1;
+                break;
+            case M_STM_FOR:
+                if (mln_lang_bc_gen_for(g, stm->data.f) < 0) return -1;
+                break;
+            default: /*functions, sets, labels and switch stay on the AST walker*/
+                return -1;
+        }
+    }
+    return 0;
+}
+
+static int mln_lang_bc_gen_block(mln_lang_bc_gen_t *g, mln_lang_block_t *block)
+{
+    if (block == NULL) return mln_lang_bc_emit(g, M_LANG_BC_RESET, 0, 0) < 0? -1: 0;
+    switch (block->type) {
+        case M_BLOCK_EXP:
+            if (block->data.exp == NULL)
+                return mln_lang_bc_emit(g, M_LANG_BC_RESET, 0, 0) < 0? -1: 0;
+            if (mln_lang_bc_gen_exp(g, block->data.exp) < 0) return -1;
+            return mln_lang_bc_emit(g, M_LANG_BC_SETRET, 0, 0) < 0? -1: 0;
+        case M_BLOCK_STM:
+            if (block->data.stm == NULL)
+                return mln_lang_bc_emit(g, M_LANG_BC_RESET, 0, 0) < 0? -1: 0;
+            return mln_lang_bc_gen_stm(g, block->data.stm);
+        case M_BLOCK_CONTINUE:
+        {
+            mln_s32_t pos;
+            if (!g->in_loop) return -1;
+            if ((pos = mln_lang_bc_emit(g, M_LANG_BC_JMP, 0, g->cont_head)) < 0) return -1;
+            g->cont_head = pos;
+            return 0;
+        }
+        case M_BLOCK_BREAK:
+        {
+            mln_s32_t pos;
+            if (!g->in_loop) return -1;
+            if ((pos = mln_lang_bc_emit(g, M_LANG_BC_JMP, 0, g->break_head)) < 0) return -1;
+            g->break_head = pos;
+            return 0;
+        }
+        case M_BLOCK_RETURN:
+            if (block->data.exp != NULL) {
+                if (mln_lang_bc_gen_exp(g, block->data.exp) < 0) return -1;
+                if (mln_lang_bc_emit(g, M_LANG_BC_SETRET, 0, 0) < 0) return -1;
+            } else {
+                if (mln_lang_bc_emit(g, M_LANG_BC_RESET, 0, 0) < 0) return -1;
+            }
+            return mln_lang_bc_emit(g, M_LANG_BC_RET, 0, 0) < 0? -1: 0;
+        case M_BLOCK_IF:
+            return mln_lang_bc_gen_if(g, block->data.i);
+        default: /*M_BLOCK_GOTO*/
+            return -1;
+    }
+}
+
+static int mln_lang_bc_gen_if(mln_lang_bc_gen_t *g, mln_lang_if_t *i)
+{
+    mln_s32_t jf, jend;
+
+    if (i == NULL || i->condition == NULL) return -1;
+    if (mln_lang_bc_gen_exp(g, i->condition) < 0) return -1;
+    if ((jf = mln_lang_bc_emit(g, M_LANG_BC_JF, 0, 0)) < 0) return -1;
+    if (mln_lang_bc_gen_block(g, i->blockstm) < 0) return -1;
+    if ((jend = mln_lang_bc_emit(g, M_LANG_BC_JMP, 0, 0)) < 0) return -1;
+    mln_lang_bc_patch(g, jf, (mln_s32_t)(g->bc->ninst));
+    if (i->elsestm != NULL) {
+        if (mln_lang_bc_gen_block(g, i->elsestm) < 0) return -1;
+    } else {
+        if (mln_lang_bc_emit(g, M_LANG_BC_RESET, 0, 0) < 0) return -1;
+    }
+    mln_lang_bc_patch(g, jend, (mln_s32_t)(g->bc->ninst));
+    return 0;
+}
+
+static int mln_lang_bc_gen_while(mln_lang_bc_gen_t *g, mln_lang_while_t *w)
+{
+    mln_s32_t start, jf = -1, end;
+    mln_s32_t save_break = g->break_head, save_cont = g->cont_head;
+    int save_in_loop = g->in_loop;
+
+    start = (mln_s32_t)(g->bc->ninst);
+    if (w->condition != NULL) {
+        if (mln_lang_bc_gen_exp(g, w->condition) < 0) return -1;
+        if ((jf = mln_lang_bc_emit(g, M_LANG_BC_JF, 0, 0)) < 0) return -1;
+    }
+    g->break_head = g->cont_head = -1;
+    g->in_loop = 1;
+    if (w->blockstm != NULL && mln_lang_bc_gen_block(g, w->blockstm) < 0) return -1;
+    if (mln_lang_bc_emit(g, M_LANG_BC_JMP, 0, start) < 0) return -1;
+    end = (mln_s32_t)(g->bc->ninst);
+    mln_lang_bc_patch(g, jf, end);
+    mln_lang_bc_patch_chain(g, g->break_head, end);
+    mln_lang_bc_patch_chain(g, g->cont_head, start);
+    if (mln_lang_bc_emit(g, M_LANG_BC_RESET, 0, 0) < 0) return -1;
+    g->break_head = save_break;
+    g->cont_head = save_cont;
+    g->in_loop = save_in_loop;
+    return 0;
+}
+
+static int mln_lang_bc_gen_for(mln_lang_bc_gen_t *g, mln_lang_for_t *f)
+{
+    mln_s32_t start, jf = -1, mod, end;
+    mln_s32_t save_break = g->break_head, save_cont = g->cont_head;
+    int save_in_loop = g->in_loop;
+
+    if (f->blockstm == NULL) return -1;
+    if (f->init_exp != NULL) {
+        if (mln_lang_bc_gen_exp(g, f->init_exp) < 0) return -1;
+        if (mln_lang_bc_emit(g, M_LANG_BC_POP, 0, 0) < 0) return -1;
+    }
+    start = (mln_s32_t)(g->bc->ninst);
+    if (f->condition != NULL) {
+        if (mln_lang_bc_gen_exp(g, f->condition) < 0) return -1;
+        if ((jf = mln_lang_bc_emit(g, M_LANG_BC_JFS, 0, 0)) < 0) return -1;
+    }
+    g->break_head = g->cont_head = -1;
+    g->in_loop = 1;
+    if (mln_lang_bc_gen_block(g, f->blockstm) < 0) return -1;
+    mod = (mln_s32_t)(g->bc->ninst);
+    if (f->mod_exp != NULL) {
+        if (mln_lang_bc_gen_exp(g, f->mod_exp) < 0) return -1;
+        if (mln_lang_bc_emit(g, M_LANG_BC_POP, 0, 0) < 0) return -1;
+    }
+    if (mln_lang_bc_emit(g, M_LANG_BC_JMP, 0, start) < 0) return -1;
+    end = (mln_s32_t)(g->bc->ninst);
+    mln_lang_bc_patch(g, jf, end);
+    mln_lang_bc_patch_chain(g, g->break_head, end);
+    mln_lang_bc_patch_chain(g, g->cont_head, mod);
+    g->break_head = save_break;
+    g->cont_head = save_cont;
+    g->in_loop = save_in_loop;
+    return 0;
+}
+
+static int mln_lang_bc_gen_exp(mln_lang_bc_gen_t *g, mln_lang_exp_t *exp)
+{
+    for (; exp != NULL; exp = exp->next) {
+        if (exp->assign == NULL) return -1;
+        if (mln_lang_bc_gen_assign(g, exp->assign) < 0) return -1;
+        if (exp->next != NULL && mln_lang_bc_emit(g, M_LANG_BC_POP, 0, 0) < 0) return -1;
+    }
+    return 0;
+}
+
+/*return the identifier when the assignment left side is a plain variable, else NULL*/
+static mln_string_t *mln_lang_bc_lvalue(mln_lang_assign_t *assign)
+{
+    mln_lang_logiclow_t *ll;
+    mln_lang_logichigh_t *lh;
+    mln_lang_relativelow_t *rl;
+    mln_lang_relativehigh_t *rh;
+    mln_lang_move_t *mv;
+    mln_lang_addsub_t *as;
+    mln_lang_muldiv_t *md;
+    mln_lang_suffix_t *suffix;
+    mln_lang_locate_t *locate;
+    mln_lang_spec_t *spec;
+
+    if ((ll = assign->left) == NULL || ll->op != M_LOGICLOW_NONE) return NULL;
+    if ((lh = ll->left) == NULL || lh->op != M_LOGICHIGH_NONE) return NULL;
+    if ((rl = lh->left) == NULL || rl->op != M_RELATIVELOW_NONE) return NULL;
+    if ((rh = rl->left) == NULL || rh->op != M_RELATIVEHIGH_NONE) return NULL;
+    if ((mv = rh->left) == NULL || mv->op != M_MOVE_NONE) return NULL;
+    if ((as = mv->left) == NULL || as->op != M_ADDSUB_NONE) return NULL;
+    if ((md = as->left) == NULL || md->op != M_MULDIV_NONE) return NULL;
+    if ((suffix = md->left) == NULL || suffix->op != M_SUFFIX_NONE) return NULL;
+    if ((locate = suffix->left) == NULL || locate->op != M_LOCATE_NONE || locate->next != NULL) return NULL;
+    if ((spec = locate->left) == NULL || spec->op != M_SPEC_FACTOR) return NULL;
+    if (spec->data.factor == NULL || spec->data.factor->type != M_FACTOR_ID) return NULL;
+    return spec->data.factor->data.s_id;
+}
+
+static int mln_lang_bc_gen_assign(mln_lang_bc_gen_t *g, mln_lang_assign_t *assign)
+{
+    mln_string_t *name;
+    mln_u16_t moff;
+    mln_s32_t pos;
+
+    if (assign->op == M_ASSIGN_NONE)
+        return mln_lang_bc_gen_logiclow(g, assign->left);
+
+    if ((name = mln_lang_bc_lvalue(assign)) == NULL) return -1;
+    if (mln_lang_bc_gen_assign(g, assign->right) < 0) return -1;
+    switch (assign->op) {
+        case M_ASSIGN_EQUAL:  moff = mln_lang_bc_moff(assign_handler); break;
+        case M_ASSIGN_PLUSEQ: moff = mln_lang_bc_moff(pluseq_handler); break;
+        case M_ASSIGN_SUBEQ:  moff = mln_lang_bc_moff(subeq_handler); break;
+        case M_ASSIGN_LMOVEQ: moff = mln_lang_bc_moff(lmoveq_handler); break;
+        case M_ASSIGN_RMOVEQ: moff = mln_lang_bc_moff(rmoveq_handler); break;
+        case M_ASSIGN_MULEQ:  moff = mln_lang_bc_moff(muleq_handler); break;
+        case M_ASSIGN_DIVEQ:  moff = mln_lang_bc_moff(diveq_handler); break;
+        case M_ASSIGN_OREQ:   moff = mln_lang_bc_moff(oreq_handler); break;
+        case M_ASSIGN_ANDEQ:  moff = mln_lang_bc_moff(andeq_handler); break;
+        case M_ASSIGN_XOREQ:  moff = mln_lang_bc_moff(xoreq_handler); break;
+        case M_ASSIGN_MODEQ:  moff = mln_lang_bc_moff(modeq_handler); break;
+        default: return -1;
+    }
+    if ((pos = mln_lang_bc_emit(g, M_LANG_BC_STORE, moff, 0)) < 0) return -1;
+    g->bc->insts[pos].data.s = name;
+    return 0;
+}
+
+static int mln_lang_bc_gen_logiclow(mln_lang_bc_gen_t *g, mln_lang_logiclow_t *ll)
+{
+    mln_s32_t j;
+
+    if (ll == NULL) return -1;
+    if (mln_lang_bc_gen_logichigh(g, ll->left) < 0) return -1;
+    if (ll->op == M_LOGICLOW_NONE) return 0;
+    if ((j = mln_lang_bc_emit(g, ll->op == M_LOGICLOW_AND? M_LANG_BC_AND: M_LANG_BC_OR, 0, 0)) < 0)
+        return -1;
+    if (mln_lang_bc_gen_logiclow(g, ll->right) < 0) return -1;
+    mln_lang_bc_patch(g, j, (mln_s32_t)(g->bc->ninst));
+    return 0;
+}
+
+static int mln_lang_bc_gen_logichigh(mln_lang_bc_gen_t *g, mln_lang_logichigh_t *lh)
+{
+    mln_lang_logichigh_t *p;
+    mln_u16_t moff;
+
+    if (lh == NULL) return -1;
+    if (mln_lang_bc_gen_relativelow(g, lh->left) < 0) return -1;
+    for (p = lh; p->op != M_LOGICHIGH_NONE; p = p->right) {
+        if (p->right == NULL || mln_lang_bc_gen_relativelow(g, p->right->left) < 0) return -1;
+        switch (p->op) {
+            case M_LOGICHIGH_OR:  moff = mln_lang_bc_moff(cor_handler); break;
+            case M_LOGICHIGH_AND: moff = mln_lang_bc_moff(cand_handler); break;
+            default:              moff = mln_lang_bc_moff(cxor_handler); break;
+        }
+        if (mln_lang_bc_emit(g, M_LANG_BC_BINOP, moff, 0) < 0) return -1;
+    }
+    return 0;
+}
+
+static int mln_lang_bc_gen_relativelow(mln_lang_bc_gen_t *g, mln_lang_relativelow_t *rl)
+{
+    mln_lang_relativelow_t *p;
+    mln_u16_t moff;
+
+    if (rl == NULL) return -1;
+    if (mln_lang_bc_gen_relativehigh(g, rl->left) < 0) return -1;
+    for (p = rl; p->op != M_RELATIVELOW_NONE; p = p->right) {
+        if (p->right == NULL || mln_lang_bc_gen_relativehigh(g, p->right->left) < 0) return -1;
+        moff = p->op == M_RELATIVELOW_EQUAL? mln_lang_bc_moff(equal_handler): mln_lang_bc_moff(nonequal_handler);
+        if (mln_lang_bc_emit(g, M_LANG_BC_BINOP, moff, 0) < 0) return -1;
+    }
+    return 0;
+}
+
+static int mln_lang_bc_gen_relativehigh(mln_lang_bc_gen_t *g, mln_lang_relativehigh_t *rh)
+{
+    mln_lang_relativehigh_t *p;
+    mln_u16_t moff;
+
+    if (rh == NULL) return -1;
+    if (mln_lang_bc_gen_move(g, rh->left) < 0) return -1;
+    for (p = rh; p->op != M_RELATIVEHIGH_NONE; p = p->right) {
+        if (p->right == NULL || mln_lang_bc_gen_move(g, p->right->left) < 0) return -1;
+        switch (p->op) {
+            case M_RELATIVEHIGH_LESS:    moff = mln_lang_bc_moff(less_handler); break;
+            case M_RELATIVEHIGH_LESSEQ:  moff = mln_lang_bc_moff(lesseq_handler); break;
+            case M_RELATIVEHIGH_GREATER: moff = mln_lang_bc_moff(grea_handler); break;
+            default:                     moff = mln_lang_bc_moff(greale_handler); break;
+        }
+        if (mln_lang_bc_emit(g, M_LANG_BC_BINOP, moff, 0) < 0) return -1;
+    }
+    return 0;
+}
+
+static int mln_lang_bc_gen_move(mln_lang_bc_gen_t *g, mln_lang_move_t *mv)
+{
+    mln_lang_move_t *p;
+    mln_u16_t moff;
+
+    if (mv == NULL) return -1;
+    if (mln_lang_bc_gen_addsub(g, mv->left) < 0) return -1;
+    for (p = mv; p->op != M_MOVE_NONE; p = p->right) {
+        if (p->right == NULL || mln_lang_bc_gen_addsub(g, p->right->left) < 0) return -1;
+        moff = p->op == M_MOVE_LMOVE? mln_lang_bc_moff(lmov_handler): mln_lang_bc_moff(rmov_handler);
+        if (mln_lang_bc_emit(g, M_LANG_BC_BINOP, moff, 0) < 0) return -1;
+    }
+    return 0;
+}
+
+static int mln_lang_bc_gen_addsub(mln_lang_bc_gen_t *g, mln_lang_addsub_t *as)
+{
+    mln_lang_addsub_t *p;
+    mln_u16_t moff;
+
+    if (as == NULL) return -1;
+    if (mln_lang_bc_gen_muldiv(g, as->left) < 0) return -1;
+    for (p = as; p->op != M_ADDSUB_NONE; p = p->right) {
+        if (p->right == NULL || mln_lang_bc_gen_muldiv(g, p->right->left) < 0) return -1;
+        moff = p->op == M_ADDSUB_PLUS? mln_lang_bc_moff(plus_handler): mln_lang_bc_moff(sub_handler);
+        if (mln_lang_bc_emit(g, M_LANG_BC_BINOP, moff, 0) < 0) return -1;
+    }
+    return 0;
+}
+
+static int mln_lang_bc_gen_muldiv(mln_lang_bc_gen_t *g, mln_lang_muldiv_t *md)
+{
+    mln_lang_muldiv_t *p;
+    mln_u16_t moff;
+
+    if (md == NULL) return -1;
+    if (mln_lang_bc_gen_suffix(g, md->left) < 0) return -1;
+    for (p = md; p->op != M_MULDIV_NONE; p = p->right) {
+        if (p->right == NULL || mln_lang_bc_gen_suffix(g, p->right->left) < 0) return -1;
+        switch (p->op) {
+            case M_MULDIV_MUL: moff = mln_lang_bc_moff(mul_handler); break;
+            case M_MULDIV_DIV: moff = mln_lang_bc_moff(div_handler); break;
+            default:           moff = mln_lang_bc_moff(mod_handler); break;
+        }
+        if (mln_lang_bc_emit(g, M_LANG_BC_BINOP, moff, 0) < 0) return -1;
+    }
+    return 0;
+}
+
+static int mln_lang_bc_gen_suffix(mln_lang_bc_gen_t *g, mln_lang_suffix_t *suffix)
+{
+    if (suffix == NULL) return -1;
+    if (mln_lang_bc_gen_locate(g, suffix->left) < 0) return -1;
+    if (suffix->op == M_SUFFIX_NONE) return 0;
+    return mln_lang_bc_emit(g, \
+                            M_LANG_BC_UNOP, \
+                            suffix->op == M_SUFFIX_INC? mln_lang_bc_moff(sinc_handler): mln_lang_bc_moff(sdec_handler), \
+                            1) < 0? -1: 0;
+}
+
+static int mln_lang_bc_gen_locate(mln_lang_bc_gen_t *g, mln_lang_locate_t *locate)
+{
+    if (locate == NULL || locate->op != M_LOCATE_NONE || locate->next != NULL)
+        return -1; /*index, property and call expressions stay on the AST walker*/
+    return mln_lang_bc_gen_spec(g, locate->left);
+}
+
+static int mln_lang_bc_gen_spec(mln_lang_bc_gen_t *g, mln_lang_spec_t *spec)
+{
+    if (spec == NULL) return -1;
+    switch (spec->op) {
+        case M_SPEC_NEGATIVE:
+            if (mln_lang_bc_gen_spec(g, spec->data.spec) < 0) return -1;
+            return mln_lang_bc_emit(g, M_LANG_BC_UNOP, mln_lang_bc_moff(negative_handler), 0) < 0? -1: 0;
+        case M_SPEC_REVERSE:
+            if (mln_lang_bc_gen_spec(g, spec->data.spec) < 0) return -1;
+            return mln_lang_bc_emit(g, M_LANG_BC_UNOP, mln_lang_bc_moff(reverse_handler), 0) < 0? -1: 0;
+        case M_SPEC_NOT:
+            if (mln_lang_bc_gen_spec(g, spec->data.spec) < 0) return -1;
+            return mln_lang_bc_emit(g, M_LANG_BC_UNOP, mln_lang_bc_moff(not_handler), 0) < 0? -1: 0;
+        case M_SPEC_INC:
+            if (mln_lang_bc_gen_spec(g, spec->data.spec) < 0) return -1;
+            return mln_lang_bc_emit(g, M_LANG_BC_UNOP, mln_lang_bc_moff(pinc_handler), 1) < 0? -1: 0;
+        case M_SPEC_DEC:
+            if (mln_lang_bc_gen_spec(g, spec->data.spec) < 0) return -1;
+            return mln_lang_bc_emit(g, M_LANG_BC_UNOP, mln_lang_bc_moff(pdec_handler), 1) < 0? -1: 0;
+        case M_SPEC_PARENTH:
+            if (spec->data.exp == NULL)
+                return mln_lang_bc_emit(g, M_LANG_BC_NIL, 0, 0) < 0? -1: 0;
+            return mln_lang_bc_gen_exp(g, spec->data.exp);
+        case M_SPEC_FACTOR:
+            return mln_lang_bc_gen_factor(g, spec->data.factor);
+        default: /*M_SPEC_REFER, M_SPEC_NEW*/
+            return -1;
+    }
+}
+
+static int mln_lang_bc_gen_factor(mln_lang_bc_gen_t *g, mln_lang_factor_t *factor)
+{
+    mln_s32_t pos;
+
+    if (factor == NULL) return -1;
+    switch (factor->type) {
+        case M_FACTOR_BOOL:
+            return mln_lang_bc_emit(g, factor->data.b? M_LANG_BC_TRUE: M_LANG_BC_FALSE, 0, 0) < 0? -1: 0;
+        case M_FACTOR_STRING:
+            if ((pos = mln_lang_bc_emit(g, M_LANG_BC_STR, 0, 0)) < 0) return -1;
+            g->bc->insts[pos].data.s = factor->data.s_id;
+            return 0;
+        case M_FACTOR_INT:
+            if ((pos = mln_lang_bc_emit(g, M_LANG_BC_INT, 0, 0)) < 0) return -1;
+            g->bc->insts[pos].data.i = factor->data.i;
+            return 0;
+        case M_FACTOR_REAL:
+            if ((pos = mln_lang_bc_emit(g, M_LANG_BC_REAL, 0, 0)) < 0) return -1;
+            g->bc->insts[pos].data.f = factor->data.f;
+            return 0;
+        case M_FACTOR_ID:
+            if ((pos = mln_lang_bc_emit(g, M_LANG_BC_LOAD, 0, 0)) < 0) return -1;
+            g->bc->insts[pos].data.s = factor->data.s_id;
+            return 0;
+        case M_FACTOR_NIL:
+            return mln_lang_bc_emit(g, M_LANG_BC_NIL, 0, 0) < 0? -1: 0;
+        default: /*M_FACTOR_ARRAY*/
+            return -1;
+    }
+}
+
+mln_lang_bc_t *mln_lang_bc_compile(mln_lang_ctx_t *ctx)
+{
+    mln_lang_bc_t *bc;
+    mln_lang_bc_gen_t g;
+
+    if (ctx->stm == NULL) return NULL;
+    if ((bc = (mln_lang_bc_t *)mln_alloc_m(ctx->pool, sizeof(mln_lang_bc_t))) == NULL)
+        return NULL;
+    bc->cap = 64;
+    bc->ninst = 0;
+    bc->pc = 0;
+    bc->sp = 0;
+    if ((bc->insts = (mln_lang_bc_inst_t *)mln_alloc_m(ctx->pool, bc->cap * sizeof(mln_lang_bc_inst_t))) == NULL) {
+        mln_alloc_free(bc);
+        return NULL;
+    }
+    g.ctx = ctx;
+    g.bc = bc;
+    g.break_head = g.cont_head = -1;
+    g.in_loop = 0;
+    if (mln_lang_bc_gen_stm(&g, ctx->stm) < 0 || mln_lang_bc_emit(&g, M_LANG_BC_END, 0, 0) < 0) {
+        mln_lang_bc_free(bc);
+        return NULL;
+    }
+    return bc;
+}
+
+void mln_lang_bc_free(mln_lang_bc_t *bc)
+{
+    if (bc == NULL) return;
+    while (bc->sp > 0)
+        mln_lang_var_free(bc->stack[--(bc->sp)]);
+    if (bc->insts != NULL) mln_alloc_free(bc->insts);
+    mln_alloc_free(bc);
+}
+
+/*
+ * precompiled script cache
+ * A compiled program is serialized into '<script>.mlnc' next to the
+ * source. The header records the source file's size and mtime, so a
+ * stale or foreign cache file is rejected and the task falls back to
+ * the parser. Bump M_LANG_BC_CACHE_VERSION whenever the opcode set or
+ * the mln_lang_method_t layout changes, since instruction operands
+ * embed method offsets.
+ */
+#if !defined(WIN32)
+
+#define M_LANG_BC_CACHE_MAGIC   0x434e4c4dU/*"MLNC"*/
+#define M_LANG_BC_CACHE_VERSION 1
+#define M_LANG_BC_CACHE_ORDER   0x0102030405060708ULL
+#define M_LANG_BC_CACHE_PATHLEN 1024
+#define M_LANG_BC_CACHE_MAXINST 0x1000000
+
+typedef struct {
+    mln_u32_t                        magic;
+    mln_u32_t                        version;
+    mln_u64_t                        order;/*byte order probe*/
+    mln_u64_t                        src_size;
+    mln_u64_t                        src_mtime;
+    mln_u64_t                        ninst;
+    mln_u64_t                        nstr;
+} mln_lang_bc_cache_head_t;
+
+typedef struct {
+    mln_u16_t                        op;
+    mln_u16_t                        moff;
+    mln_s32_t                        target;
+    mln_u64_t                        data;/*integer, real bits or string table index*/
+} mln_lang_bc_cache_inst_t;
+
+static inline int mln_lang_bc_inst_has_str(mln_u16_t op)
+{
+    return op == M_LANG_BC_STR || op == M_LANG_BC_LOAD || op == M_LANG_BC_STORE;
+}
+
+static inline int mln_lang_bc_inst_has_jump(mln_u16_t op)
+{
+    return op == M_LANG_BC_JMP || op == M_LANG_BC_JF || op == M_LANG_BC_JFS || \
+           op == M_LANG_BC_AND || op == M_LANG_BC_OR;
+}
+
+static int mln_lang_bc_cache_path(mln_string_t *path, char *buf, mln_size_t len, int tmp)
+{
+    int n = snprintf(buf, len, "%.*s.mlnc%s", (int)(path->len), (char *)(path->data), tmp? ".tmp": "");
+    return (n <= 0 || (mln_size_t)n >= len)? -1: 0;
+}
+
+static int mln_lang_bc_write(int fd, void *buf, mln_size_t len)
+{
+    mln_u8ptr_t p = (mln_u8ptr_t)buf;
+    ssize_t n;
+    while (len > 0) {
+        if ((n = write(fd, p, len)) <= 0) return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+void mln_lang_bc_store(mln_lang_ctx_t *ctx, mln_string_t *path)
+{
+    mln_lang_bc_t *bc = (mln_lang_bc_t *)(ctx->bc);
+    mln_lang_bc_cache_head_t head;
+    mln_lang_bc_cache_inst_t ci;
+    mln_lang_bc_inst_t *inst, *end;
+    mln_string_t **tbl;
+    mln_u64_t nstr = 0, i;
+    char fpath[M_LANG_BC_CACHE_PATHLEN], tpath[M_LANG_BC_CACHE_PATHLEN];
+    struct stat st;
+    int fd;
+
+    if (bc == NULL || bc->ninst == 0) return;
+    if (mln_lang_bc_cache_path(path, fpath, sizeof(fpath), 0) < 0) return;
+    if (mln_lang_bc_cache_path(path, tpath, sizeof(tpath), 1) < 0) return;
+    {
+        char spath[M_LANG_BC_CACHE_PATHLEN];
+        int n = snprintf(spath, sizeof(spath), "%.*s", (int)(path->len), (char *)(path->data));
+        if (n <= 0 || (mln_size_t)n >= sizeof(spath)) return;
+        if (stat(spath, &st) < 0) return;
+    }
+
+    if ((tbl = (mln_string_t **)mln_alloc_m(ctx->pool, bc->ninst * sizeof(mln_string_t *))) == NULL)
+        return;
+    for (inst = bc->insts, end = inst + bc->ninst; inst < end; ++inst) {
+        if (!mln_lang_bc_inst_has_str(inst->op)) continue;
+        for (i = 0; i < nstr; ++i) {
+            if (!mln_string_strcmp(tbl[i], inst->data.s)) break;
+        }
+        if (i == nstr) tbl[nstr++] = inst->data.s;
+    }
+
+    if ((fd = open(tpath, O_WRONLY|O_CREAT|O_TRUNC, 0644)) < 0) {
+        mln_alloc_free(tbl);
+        return;
+    }
+    head.magic = M_LANG_BC_CACHE_MAGIC;
+    head.version = M_LANG_BC_CACHE_VERSION;
+    head.order = M_LANG_BC_CACHE_ORDER;
+    head.src_size = (mln_u64_t)(st.st_size);
+    head.src_mtime = (mln_u64_t)(st.st_mtime);
+    head.ninst = bc->ninst;
+    head.nstr = nstr;
+    if (mln_lang_bc_write(fd, &head, sizeof(head)) < 0) goto failed;
+    for (i = 0; i < nstr; ++i) {
+        mln_u64_t slen = tbl[i]->len;
+        if (mln_lang_bc_write(fd, &slen, sizeof(slen)) < 0) goto failed;
+        if (slen > 0 && mln_lang_bc_write(fd, tbl[i]->data, slen) < 0) goto failed;
+    }
+    for (inst = bc->insts, end = inst + bc->ninst; inst < end; ++inst) {
+        ci.op = inst->op;
+        ci.moff = inst->moff;
+        ci.target = inst->target;
+        if (mln_lang_bc_inst_has_str(inst->op)) {
+            for (i = 0; i < nstr && mln_string_strcmp(tbl[i], inst->data.s); ++i)
+                ;
+            ci.data = i;
+        } else {
+            memcpy(&ci.data, &inst->data, sizeof(ci.data));
+        }
+        if (mln_lang_bc_write(fd, &ci, sizeof(ci)) < 0) goto failed;
+    }
+    close(fd);
+    mln_alloc_free(tbl);
+    if (rename(tpath, fpath) < 0) unlink(tpath);
+    return;
+
+failed:
+    close(fd);
+    unlink(tpath);
+    mln_alloc_free(tbl);
+}
+
+mln_lang_bc_t *mln_lang_bc_load(mln_lang_ctx_t *ctx, mln_string_t *path)
+{
+    mln_lang_bc_t *bc;
+    mln_lang_bc_cache_head_t *head;
+    mln_lang_bc_cache_inst_t *ci;
+    mln_lang_bc_inst_t *inst;
+    mln_string_t **tbl = NULL;
+    mln_u8ptr_t base = NULL, p, send;
+    mln_u64_t i, slen;
+    char fpath[M_LANG_BC_CACHE_PATHLEN], spath[M_LANG_BC_CACHE_PATHLEN];
+    struct stat st, cst;
+    mln_size_t size;
+    int fd = -1, n;
+
+    if (mln_lang_bc_cache_path(path, fpath, sizeof(fpath), 0) < 0) return NULL;
+    n = snprintf(spath, sizeof(spath), "%.*s", (int)(path->len), (char *)(path->data));
+    if (n <= 0 || (mln_size_t)n >= sizeof(spath)) return NULL;
+    if (stat(spath, &st) < 0) return NULL;
+    if ((fd = open(fpath, O_RDONLY)) < 0) return NULL;
+    if (fstat(fd, &cst) < 0 || (mln_size_t)(cst.st_size) < sizeof(mln_lang_bc_cache_head_t)) {
+        close(fd);
+        return NULL;
+    }
+    size = (mln_size_t)(cst.st_size);
+    if ((base = (mln_u8ptr_t)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    head = (mln_lang_bc_cache_head_t *)base;
+    if (head->magic != M_LANG_BC_CACHE_MAGIC || \
+        head->version != M_LANG_BC_CACHE_VERSION || \
+        head->order != M_LANG_BC_CACHE_ORDER || \
+        head->src_size != (mln_u64_t)(st.st_size) || \
+        head->src_mtime != (mln_u64_t)(st.st_mtime) || \
+        head->ninst == 0 || head->ninst > M_LANG_BC_CACHE_MAXINST || \
+        head->nstr > head->ninst)
+    {
+        goto failed;
+    }
+
+    p = base + sizeof(mln_lang_bc_cache_head_t);
+    send = base + size;
+    if (head->nstr > 0) {
+        if ((tbl = (mln_string_t **)mln_alloc_m(ctx->pool, head->nstr * sizeof(mln_string_t *))) == NULL)
+            goto failed;
+    }
+    for (i = 0; i < head->nstr; ++i) {
+        mln_u8ptr_t buf;
+        if (p + sizeof(mln_u64_t) > send) goto failed;
+        memcpy(&slen, p, sizeof(slen));
+        p += sizeof(mln_u64_t);
+        if (slen > (mln_u64_t)(send - p)) goto failed;
+        if ((buf = (mln_u8ptr_t)mln_alloc_m(ctx->pool, slen + 1)) == NULL) goto failed;
+        memcpy(buf, p, slen);
+        buf[slen] = 0;
+        if ((tbl[i] = mln_string_buf_pool_new(ctx->pool, buf, slen)) == NULL) {
+            mln_alloc_free(buf);
+            goto failed;
+        }
+        p += slen;
+    }
+    if ((mln_u64_t)(send - p) != head->ninst * sizeof(mln_lang_bc_cache_inst_t)) goto failed;
+
+    if ((bc = (mln_lang_bc_t *)mln_alloc_m(ctx->pool, sizeof(mln_lang_bc_t))) == NULL) goto failed;
+    bc->cap = bc->ninst = head->ninst;
+    bc->pc = 0;
+    bc->sp = 0;
+    if ((bc->insts = (mln_lang_bc_inst_t *)mln_alloc_m(ctx->pool, bc->cap * sizeof(mln_lang_bc_inst_t))) == NULL) {
+        mln_alloc_free(bc);
+        goto failed;
+    }
+    for (i = 0; i < head->ninst; ++i) {
+        ci = (mln_lang_bc_cache_inst_t *)(p + i * sizeof(mln_lang_bc_cache_inst_t));
+        inst = &bc->insts[i];
+        if (ci->op > M_LANG_BC_END || ci->moff >= sizeof(mln_lang_method_t)) goto failed_bc;
+        if (mln_lang_bc_inst_has_jump(ci->op) && \
+            (ci->target < 0 || (mln_u64_t)(ci->target) >= head->ninst))
+        {
+            goto failed_bc;
+        }
+        inst->op = ci->op;
+        inst->moff = ci->moff;
+        inst->target = ci->target;
+        inst->sym = NULL;
+        if (mln_lang_bc_inst_has_str(ci->op)) {
+            if (ci->data >= head->nstr) goto failed_bc;
+            inst->data.s = tbl[ci->data];
+        } else {
+            memcpy(&inst->data, &ci->data, sizeof(ci->data));
+        }
+    }
+    if (bc->insts[head->ninst - 1].op != M_LANG_BC_END) goto failed_bc;
+
+    munmap(base, size);
+    close(fd);
+    if (tbl != NULL) mln_alloc_free(tbl);
+    return bc;
+
+failed_bc:
+    mln_lang_bc_free(bc);
+failed:
+    if (base != NULL) munmap(base, size);
+    if (fd >= 0) close(fd);
+    if (tbl != NULL) mln_alloc_free(tbl);
+    return NULL;
+}
+
+#else
+
+void mln_lang_bc_store(mln_lang_ctx_t *ctx, mln_string_t *path)
+{
+    (void)ctx;
+    (void)path;
+}
+
+mln_lang_bc_t *mln_lang_bc_load(mln_lang_ctx_t *ctx, mln_string_t *path)
+{
+    (void)ctx;
+    (void)path;
+    return NULL;
+}
+
+#endif
+
+static mln_lang_symbol_node_t *mln_lang_bc_symbol_fetch(mln_lang_ctx_t *ctx, mln_string_t *name)
+{
+    mln_lang_symbol_node_t *sym;
+    mln_string_t *dup;
+    mln_lang_var_t *var;
+    int local = (name->len > 0 && name->data[0] > 64 && name->data[0] < 91)? 0: 1;
+
+    if ((sym = mln_lang_symbol_node_search(ctx, name, local)) != NULL) return sym;
+    if ((dup = mln_string_pool_dup(ctx->pool, name)) == NULL) {
+        mln_lang_errmsg(ctx, "No memory.");
+        return NULL;
+    }
+    var = mln_lang_var_create_nil(ctx, dup);
+    mln_string_free(dup);
+    if (var == NULL) {
+        mln_lang_errmsg(ctx, "No memory.");
+        return NULL;
+    }
+    if (mln_lang_symbol_node_join(ctx, M_LANG_SYMBOL_VAR, var) < 0) {
+        mln_lang_errmsg(ctx, "No memory.");
+        mln_lang_var_free(var);
+        return NULL;
+    }
+    return mln_lang_symbol_node_search(ctx, name, local);
+}
+
+void mln_lang_bc_run(mln_lang_ctx_t *ctx, int step)
+{
+    mln_lang_bc_t *bc = (mln_lang_bc_t *)(ctx->bc);
+    mln_lang_bc_inst_t *inst;
+    mln_lang_symbol_node_t *sym;
+    mln_lang_var_t *var, *op1, *op2, *res;
+    mln_lang_method_t *method;
+    mln_lang_op handler;
+
+#if defined(__GNUC__)
+    static const void *dispatch_tbl[] = {
+        &&L_NIL, &&L_TRUE, &&L_FALSE, &&L_INT, &&L_REAL, &&L_STR,
+        &&L_LOAD, &&L_POP, &&L_SETRET, &&L_RESET,
+        &&L_JMP, &&L_JF, &&L_JFS, &&L_AND, &&L_OR,
+        &&L_BINOP, &&L_UNOP, &&L_STORE, &&L_RET, &&L_END
+    };
+#define mln_lang_bc_dispatch() do {\
+    inst = bc->insts + bc->pc;\
+    goto *dispatch_tbl[inst->op];\
+} while (0)
+#else
+#define mln_lang_bc_dispatch() do {\
+    inst = bc->insts + bc->pc;\
+    switch (inst->op) {\
+        case M_LANG_BC_NIL: goto L_NIL;\
+        case M_LANG_BC_TRUE: goto L_TRUE;\
+        case M_LANG_BC_FALSE: goto L_FALSE;\
+        case M_LANG_BC_INT: goto L_INT;\
+        case M_LANG_BC_REAL: goto L_REAL;\
+        case M_LANG_BC_STR: goto L_STR;\
+        case M_LANG_BC_LOAD: goto L_LOAD;\
+        case M_LANG_BC_POP: goto L_POP;\
+        case M_LANG_BC_SETRET: goto L_SETRET;\
+        case M_LANG_BC_RESET: goto L_RESET;\
+        case M_LANG_BC_JMP: goto L_JMP;\
+        case M_LANG_BC_JF: goto L_JF;\
+        case M_LANG_BC_JFS: goto L_JFS;\
+        case M_LANG_BC_AND: goto L_AND;\
+        case M_LANG_BC_OR: goto L_OR;\
+        case M_LANG_BC_BINOP: goto L_BINOP;\
+        case M_LANG_BC_UNOP: goto L_UNOP;\
+        case M_LANG_BC_STORE: goto L_STORE;\
+        case M_LANG_BC_RET: goto L_RET;\
+        default: goto L_END;\
+    }\
+} while (0)
+#endif
+/*
+ * Take a branch to inst->target. Preemption is budget-based: without
+ * calls the compiled subset can only run unboundedly through a backward
+ * branch, so straight-line code and forward branches execute unchecked
+ * and each backward branch taken spends one unit of 'step'. When the
+ * budget hits zero the task yields with pc already at the loop head.
+ */
+#define mln_lang_bc_branch() do {\
+    if (inst->target <= (mln_s32_t)bc->pc) {\
+        bc->pc = inst->target;\
+        if (--step <= 0) return;\
+    } else {\
+        bc->pc = inst->target;\
+    }\
+} while (0)
+#define mln_lang_bc_push(v) do {\
+    if (bc->sp >= M_LANG_BC_STACK_LEN) {\
+        mln_lang_var_free(v);\
+        mln_lang_errmsg(ctx, "Stack is full.");\
+        goto failed;\
+    }\
+    bc->stack[(bc->sp)++] = (v);\
+} while (0)
+
+    mln_lang_bc_dispatch();
+
+L_NIL:
+    if ((var = mln_lang_var_create_nil(ctx, NULL)) == NULL) goto nomem;
+    mln_lang_bc_push(var);
+    ++(bc->pc);
+    mln_lang_bc_dispatch();
+
+L_TRUE:
+    if ((var = mln_lang_var_create_true(ctx, NULL)) == NULL) goto nomem;
+    mln_lang_bc_push(var);
+    ++(bc->pc);
+    mln_lang_bc_dispatch();
+
+L_FALSE:
+    if ((var = mln_lang_var_create_false(ctx, NULL)) == NULL) goto nomem;
+    mln_lang_bc_push(var);
+    ++(bc->pc);
+    mln_lang_bc_dispatch();
+
+L_INT:
+    if ((var = mln_lang_var_create_int(ctx, inst->data.i, NULL)) == NULL) goto nomem;
+    mln_lang_bc_push(var);
+    ++(bc->pc);
+    mln_lang_bc_dispatch();
+
+L_REAL:
+    if ((var = mln_lang_var_create_real(ctx, inst->data.f, NULL)) == NULL) goto nomem;
+    mln_lang_bc_push(var);
+    ++(bc->pc);
+    mln_lang_bc_dispatch();
+
+L_STR:
+    if ((var = mln_lang_var_create_string(ctx, inst->data.s, NULL)) == NULL) goto nomem;
+    mln_lang_bc_push(var);
+    ++(bc->pc);
+    mln_lang_bc_dispatch();
+
+L_LOAD:
+    if ((sym = inst->sym) == NULL) {
+        if ((sym = mln_lang_bc_symbol_fetch(ctx, inst->data.s)) == NULL) goto failed;
+        inst->sym = sym;
+    }
+    if (sym->type != M_LANG_SYMBOL_VAR) {
+        mln_lang_errmsg(ctx, "Invalid token. Token is a SET name, not a value or function.");
+        goto failed;
+    }
+    mln_lang_bc_push(mln_lang_var_ref(sym->data.var));
+    ++(bc->pc);
+    mln_lang_bc_dispatch();
+
+L_POP:
+    mln_lang_var_free(bc->stack[--(bc->sp)]);
+    ++(bc->pc);
+    mln_lang_bc_dispatch();
+
+L_SETRET:
+    mln_lang_ctx_set_ret_var(ctx, bc->stack[--(bc->sp)]);
+    ++(bc->pc);
+    mln_lang_bc_dispatch();
+
+L_RESET:
+    mln_lang_ctx_set_ret_var(ctx, NULL);
+    ++(bc->pc);
+    mln_lang_bc_dispatch();
+
+L_JMP:
+    mln_lang_bc_branch();
+    mln_lang_bc_dispatch();
+
+L_JF:
+    var = bc->stack[--(bc->sp)];
+    if (!mln_lang_condition_is_true(var)) {
+        mln_lang_var_free(var);
+        mln_lang_bc_branch();
+    } else {
+        mln_lang_var_free(var);
+        ++(bc->pc);
+    }
+    mln_lang_bc_dispatch();
+
+L_JFS:
+    var = bc->stack[--(bc->sp)];
+    if (!mln_lang_condition_is_true(var)) {
+        mln_lang_ctx_set_ret_var(ctx, var);
+        mln_lang_bc_branch();
+    } else {
+        mln_lang_var_free(var);
+        ++(bc->pc);
+    }
+    mln_lang_bc_dispatch();
+
+L_AND:
+    if (!mln_lang_condition_is_true(bc->stack[bc->sp - 1])) {
+        mln_lang_bc_branch();
+    } else {
+        mln_lang_var_free(bc->stack[--(bc->sp)]);
+        ++(bc->pc);
+    }
+    mln_lang_bc_dispatch();
+
+L_OR:
+    if (mln_lang_condition_is_true(bc->stack[bc->sp - 1])) {
+        mln_lang_bc_branch();
+    } else {
+        mln_lang_var_free(bc->stack[--(bc->sp)]);
+        ++(bc->pc);
+    }
+    mln_lang_bc_dispatch();
+
+L_BINOP:
+    op2 = bc->stack[--(bc->sp)];
+    op1 = bc->stack[--(bc->sp)];
+    method = mln_lang_methods[mln_lang_var_val_type_get(op1)];
+    if (method == NULL || (handler = *(mln_lang_op *)((mln_u8ptr_t)method + inst->moff)) == NULL) {
+        mln_lang_var_free(op1);
+        mln_lang_var_free(op2);
+        mln_lang_errmsg(ctx, "Operation NOT support.");
+        goto failed;
+    }
+    res = NULL;
+    if (handler(ctx, &res, op1, op2) < 0) {
+        mln_lang_var_free(op1);
+        mln_lang_var_free(op2);
+        goto failed;
+    }
+    mln_lang_var_free(op1);
+    mln_lang_var_free(op2);
+    if (mln_lang_var_val_type_get(res) == M_LANG_VAL_TYPE_CALL) {
+        mln_lang_var_free(res);
+        mln_lang_errmsg(ctx, "Operation NOT support.");
+        goto failed;
+    }
+    mln_lang_bc_push(res);
+    ++(bc->pc);
+    mln_lang_bc_dispatch();
+
+L_UNOP:
+    op1 = bc->stack[--(bc->sp)];
+    method = mln_lang_methods[mln_lang_var_val_type_get(op1)];
+    if (method == NULL || (handler = *(mln_lang_op *)((mln_u8ptr_t)method + inst->moff)) == NULL) {
+        mln_lang_var_free(op1);
+        mln_lang_errmsg(ctx, "Operation NOT support.");
+        goto failed;
+    }
+    if (inst->target && mln_lang_val_not_modify_isset(op1->val)) {
+        mln_lang_var_free(op1);
+        mln_lang_errmsg(ctx, "Operand cannot be changed.");
+        goto failed;
+    }
+    res = NULL;
+    if (handler(ctx, &res, op1, NULL) < 0) {
+        mln_lang_var_free(op1);
+        goto failed;
+    }
+    mln_lang_var_free(op1);
+    if (mln_lang_var_val_type_get(res) == M_LANG_VAL_TYPE_CALL) {
+        mln_lang_var_free(res);
+        mln_lang_errmsg(ctx, "Operation NOT support.");
+        goto failed;
+    }
+    mln_lang_bc_push(res);
+    ++(bc->pc);
+    mln_lang_bc_dispatch();
+
+L_STORE:
+    if ((sym = inst->sym) == NULL) {
+        if ((sym = mln_lang_bc_symbol_fetch(ctx, inst->data.s)) == NULL) goto failed;
+        inst->sym = sym;
+    }
+    if (sym->type != M_LANG_SYMBOL_VAR) {
+        mln_lang_errmsg(ctx, "Invalid token. Token is a SET name, not a value or function.");
+        goto failed;
+    }
+    op1 = sym->data.var;
+    op2 = bc->stack[--(bc->sp)];
+    /*like the AST walker, pick the method by the right operand's type*/
+    method = mln_lang_methods[mln_lang_var_val_type_get(op2)];
+    if (method == NULL || (handler = *(mln_lang_op *)((mln_u8ptr_t)method + inst->moff)) == NULL) {
+        mln_lang_var_free(op2);
+        mln_lang_errmsg(ctx, "Operation NOT support.");
+        goto failed;
+    }
+    if (mln_lang_val_not_modify_isset(op1->val)) {
+        mln_lang_var_free(op2);
+        mln_lang_errmsg(ctx, "Operand cannot be changed.");
+        goto failed;
+    }
+    res = NULL;
+    if (handler(ctx, &res, op1, op2) < 0) {
+        mln_lang_var_free(op2);
+        goto failed;
+    }
+    mln_lang_var_free(op2);
+    if (mln_lang_var_val_type_get(res) == M_LANG_VAL_TYPE_CALL) {
+        mln_lang_var_free(res);
+        mln_lang_errmsg(ctx, "Operation NOT support.");
+        goto failed;
+    }
+    mln_lang_bc_push(res);
+    ++(bc->pc);
+    mln_lang_bc_dispatch();
+
+L_RET:
+    if (ctx->ret_var == NULL) {
+        if ((var = mln_lang_var_create_nil(ctx, NULL)) == NULL) goto nomem;
+        mln_lang_ctx_set_ret_var(ctx, var);
+    }
+    ctx->ret_flag = 1;
+    goto L_END;
+
+L_END:
+    /*same as the walker: only an explicit return leaves a value behind*/
+    if (!ctx->ret_flag)
+        mln_lang_ctx_set_ret_var(ctx, NULL);
+    ctx->quit = 1;
+    while (bc->sp > 0)
+        mln_lang_var_free(bc->stack[--(bc->sp)]);
+    return;
+
+nomem:
+    mln_lang_errmsg(ctx, "No memory.");
+failed:
+    ctx->quit = 1;
+    while (bc->sp > 0)
+        mln_lang_var_free(bc->stack[--(bc->sp)]);
+    return;
+}
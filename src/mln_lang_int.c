@@ -603,17 +603,11 @@ mln_lang_int_cor(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1,
         mln_lang_errmsg(ctx, "Operation NOT support.");
         return -1;
     }
-    mln_lang_val_t *val;
     mln_s64_t i = mln_lang_int_var_toint(op1) | mln_lang_int_var_toint(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -637,15 +631,9 @@ mln_lang_int_cand(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         mln_lang_errmsg(ctx, "Operation NOT support.");
         return -1;
     }
-    mln_lang_val_t *val;
     mln_s64_t i = mln_lang_int_var_toint(op1) & mln_lang_int_var_toint(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -671,17 +659,11 @@ mln_lang_int_cxor(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         mln_lang_errmsg(ctx, "Operation NOT support.");
         return -1;
     }
-    mln_lang_val_t *val;
     mln_s64_t i = mln_lang_int_var_toint(op1) ^ mln_lang_int_var_toint(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -707,17 +689,11 @@ mln_lang_int_equal(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op
         }
         return 0;
     }
-    mln_lang_val_t *val;
     mln_u8_t b = mln_lang_int_var_toint(op1) == mln_lang_int_var_toint(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -743,17 +719,11 @@ mln_lang_int_nonequal(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t
         }
         return 0;
     }
-    mln_lang_val_t *val;
     mln_u8_t b = mln_lang_int_var_toint(op1) != mln_lang_int_var_toint(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -766,7 +736,6 @@ mln_lang_int_less(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_u8_t b;
     mln_s32_t type = mln_lang_var_val_type_get(op2);
     if (type == M_LANG_VAL_TYPE_OBJECT || \
@@ -797,13 +766,8 @@ mln_lang_int_less(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
     } else {
         b = mln_lang_int_var_toint(op1) < mln_lang_int_var_toint(op2);
     }
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -818,7 +782,6 @@ mln_lang_int_lesseq(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *o
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_u8_t b;
     mln_s32_t type = mln_lang_var_val_type_get(op2);
     if (type == M_LANG_VAL_TYPE_OBJECT || \
@@ -848,13 +811,8 @@ mln_lang_int_lesseq(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *o
     } else {
         b = mln_lang_int_var_toint(op1) <= mln_lang_int_var_toint(op2);
     }
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -869,7 +827,6 @@ mln_lang_int_grea(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_u8_t b;
     mln_s32_t type = mln_lang_var_val_type_get(op2);
     if (type == M_LANG_VAL_TYPE_OBJECT || \
@@ -899,15 +856,10 @@ mln_lang_int_grea(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
     } else {
         b = mln_lang_int_var_toint(op1) > mln_lang_int_var_toint(op2);
     }
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -920,7 +872,6 @@ mln_lang_int_greale(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *o
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_u8_t b;
     mln_s32_t type = mln_lang_var_val_type_get(op2);
     if (type == M_LANG_VAL_TYPE_OBJECT || \
@@ -950,13 +901,8 @@ mln_lang_int_greale(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *o
     } else {
         b = mln_lang_int_var_toint(op1) >= mln_lang_int_var_toint(op2);
     }
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -982,17 +928,11 @@ mln_lang_int_lmov(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         mln_lang_errmsg(ctx, "Operation NOT support.");
         return -1;
     }
-    mln_lang_val_t *val;
     mln_s64_t i = mln_lang_int_var_toint(op1) << mln_lang_int_var_toint(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -1016,15 +956,9 @@ mln_lang_int_rmov(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         mln_lang_errmsg(ctx, "Operation NOT support.");
         return -1;
     }
-    mln_lang_val_t *val;
     mln_s64_t i = mln_lang_int_var_toint(op1) >> mln_lang_int_var_toint(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -1062,23 +996,15 @@ mln_lang_int_plus(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         }
         return handler(ctx, ret, op1, op2);
     }
-    mln_lang_val_t *val;
     if (type == M_LANG_VAL_TYPE_REAL) {
         double r = mln_lang_int_var_toreal(op1) + mln_lang_int_var_toreal(op2);
-        if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
-            mln_lang_errmsg(ctx, "No memory.");
-            return -1;
-        }
+        *ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_REAL, &r);
     } else {
         mln_s64_t i = mln_lang_int_var_toint(op1) + mln_lang_int_var_toint(op2);
-        if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
-            mln_lang_errmsg(ctx, "No memory.");
-            return -1;
-        }
+        *ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i);
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if (*ret == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -1103,23 +1029,15 @@ mln_lang_int_sub(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1,
         mln_lang_errmsg(ctx, "Operation NOT support.");
         return -1;
     }
-    mln_lang_val_t *val;
     if (type == M_LANG_VAL_TYPE_REAL) {
         double r = mln_lang_int_var_toreal(op1) - mln_lang_int_var_toreal(op2);
-        if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
-            mln_lang_errmsg(ctx, "No memory.");
-            return -1;
-        }
+        *ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_REAL, &r);
     } else {
         mln_s64_t i = mln_lang_int_var_toint(op1) - mln_lang_int_var_toint(op2);
-        if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
-            mln_lang_errmsg(ctx, "No memory.");
-            return -1;
-        }
+        *ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i);
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if (*ret == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -1144,23 +1062,15 @@ mln_lang_int_mul(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1,
         mln_lang_errmsg(ctx, "Operation NOT support.");
         return -1;
     }
-    mln_lang_val_t *val;
     if (type == M_LANG_VAL_TYPE_REAL) {
         double r = mln_lang_int_var_toreal(op1) * mln_lang_int_var_toreal(op2);
-        if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
-            mln_lang_errmsg(ctx, "No memory.");
-            return -1;
-        }
+        *ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_REAL, &r);
     } else {
         mln_s64_t i = mln_lang_int_var_toint(op1) * mln_lang_int_var_toint(op2);
-        if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
-            mln_lang_errmsg(ctx, "No memory.");
-            return -1;
-        }
+        *ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i);
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if (*ret == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -1185,7 +1095,6 @@ mln_lang_int_div(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1,
         mln_lang_errmsg(ctx, "Operation NOT support.");
         return -1;
     }
-    mln_lang_val_t *val;
     if (type == M_LANG_VAL_TYPE_REAL) {
         double tmp = mln_lang_int_var_toreal(op2);
         double tmpr = tmp < 0? -tmp: tmp;
@@ -1194,10 +1103,7 @@ mln_lang_int_div(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1,
             return -1;
         }
         double r = mln_lang_int_var_toreal(op1) / tmp;
-        if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
-            mln_lang_errmsg(ctx, "No memory.");
-            return -1;
-        }
+        *ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_REAL, &r);
     } else {
         mln_s64_t tmp =  mln_lang_int_var_toint(op2);
         if (!tmp) {
@@ -1205,14 +1111,10 @@ mln_lang_int_div(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1,
             return -1;
         }
         mln_s64_t i = mln_lang_int_var_toint(op1) / tmp;
-        if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
-            mln_lang_errmsg(ctx, "No memory.");
-            return -1;
-        }
+        *ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i);
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if (*ret == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -1238,22 +1140,16 @@ mln_lang_int_mod(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1,
         mln_lang_errmsg(ctx, "Operation NOT support.");
         return -1;
     }
-    mln_lang_val_t *val;
     mln_s64_t tmp =  mln_lang_int_var_toint(op2);
     if (!tmp) {
         mln_lang_errmsg(ctx, "Modulo by zero.");
         return -1;
     }
     mln_s64_t i = mln_lang_int_var_toint(op1) % tmp;
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -1266,16 +1162,10 @@ mln_lang_int_sdec(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_s64_t i = mln_lang_int_var_toint(op1);
     mln_lang_var_set_int(op1, i-1);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -1290,16 +1180,10 @@ mln_lang_int_sinc(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_s64_t i = mln_lang_int_var_toint(op1);
     mln_lang_var_set_int(op1, i+1);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -1338,17 +1222,11 @@ mln_lang_int_negative(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_s64_t i = -mln_lang_int_var_toint(op1);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -1361,15 +1239,9 @@ mln_lang_int_reverse(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_s64_t i = ~mln_lang_int_var_toint(op1);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -1384,17 +1256,11 @@ mln_lang_int_not(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1,
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_u8_t b = !mln_lang_int_var_toint(op1);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -1407,16 +1273,10 @@ mln_lang_int_pinc(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_s64_t i = mln_lang_int_var_toint(op1) + 1;
     mln_lang_var_set_int(op1, i);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -1431,16 +1291,10 @@ mln_lang_int_pdec(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_s64_t i = mln_lang_int_var_toint(op1) - 1;
     mln_lang_var_set_int(op1, i);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_INT, &i)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
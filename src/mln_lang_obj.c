@@ -620,6 +620,7 @@ mln_lang_obj_property(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t
                 return -1;
             }
             mln_rbtree_insert(obj->members, rn);
+            mln_lang_object_shape_restamp(obj);
         }
         *ret = mln_lang_var_ref(var);
     } else {
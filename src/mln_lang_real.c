@@ -475,17 +475,11 @@ mln_lang_real_equal(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *o
         }
         return 0;
     }
-    mln_lang_val_t *val;
     mln_u8_t b = mln_lang_real_var_toreal(op1) == mln_lang_real_var_toreal(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -511,15 +505,9 @@ mln_lang_real_nonequal(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t
         }
         return 0;
     }
-    mln_lang_val_t *val;
     mln_u8_t b = mln_lang_real_var_toreal(op1) != mln_lang_real_var_toreal(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -534,7 +522,6 @@ mln_lang_real_less(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_u8_t b;
     mln_s32_t type = mln_lang_var_val_type_get(op2);
     if (type == M_LANG_VAL_TYPE_OBJECT || \
@@ -560,15 +547,10 @@ mln_lang_real_less(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op
         return handler(ctx, ret, op1, op2);
     }
     b = mln_lang_real_var_toreal(op1) < mln_lang_real_var_toreal(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -581,7 +563,6 @@ mln_lang_real_lesseq(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_u8_t b;
     mln_s32_t type = mln_lang_var_val_type_get(op2);
     if (type == M_LANG_VAL_TYPE_OBJECT || \
@@ -607,13 +588,8 @@ mln_lang_real_lesseq(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *
         return handler(ctx, ret, op1, op2);
     }
     b = mln_lang_real_var_toreal(op1) <= mln_lang_real_var_toreal(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -628,7 +604,6 @@ mln_lang_real_grea(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_u8_t b;
     mln_s32_t type = mln_lang_var_val_type_get(op2);
     if (type == M_LANG_VAL_TYPE_OBJECT || \
@@ -654,15 +629,10 @@ mln_lang_real_grea(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op
         return handler(ctx, ret, op1, op2);
     }
     b = mln_lang_real_var_toreal(op1) > mln_lang_real_var_toreal(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -675,7 +645,6 @@ mln_lang_real_greale(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_u8_t b;
     mln_s32_t type = mln_lang_var_val_type_get(op2);
     if (type == M_LANG_VAL_TYPE_OBJECT || \
@@ -701,13 +670,8 @@ mln_lang_real_greale(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *
         return handler(ctx, ret, op1, op2);
     }
     b = mln_lang_real_var_toreal(op1) >= mln_lang_real_var_toreal(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -769,17 +733,11 @@ mln_lang_real_plus(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op
         }
         return handler(ctx, ret, op1, op2);
     }
-    mln_lang_val_t *val;
     double r = mln_lang_real_var_toreal(op1) + mln_lang_real_var_toreal(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -802,15 +760,9 @@ mln_lang_real_sub(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         mln_lang_errmsg(ctx, "Operation NOT support.");
         return -1;
     }
-    mln_lang_val_t *val;
     double r = mln_lang_real_var_toreal(op1) - mln_lang_real_var_toreal(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -835,17 +787,11 @@ mln_lang_real_mul(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         mln_lang_errmsg(ctx, "Operation NOT support.");
         return -1;
     }
-    mln_lang_val_t *val;
     double r = mln_lang_real_var_toreal(op1) * mln_lang_real_var_toreal(op2);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -868,7 +814,6 @@ mln_lang_real_div(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         mln_lang_errmsg(ctx, "Operation NOT support.");
         return -1;
     }
-    mln_lang_val_t *val;
     double tmp = mln_lang_real_var_toreal(op2);
     double tmpr = tmp < 0? -tmp: tmp;
     if (tmpr <= 1e-15) {
@@ -876,13 +821,8 @@ mln_lang_real_div(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         return -1;
     }
     double r = mln_lang_real_var_toreal(op1) / tmp;
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -909,18 +849,12 @@ mln_lang_real_sdec(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     double r = mln_lang_real_var_toreal(op1);
     mln_lang_var_set_real(op1, r-1);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -933,16 +867,10 @@ mln_lang_real_sinc(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     double r = mln_lang_real_var_toreal(op1);
     mln_lang_var_set_real(op1, r+1);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -981,17 +909,11 @@ mln_lang_real_negative(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     double r = -mln_lang_real_var_toreal(op1);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -1016,15 +938,9 @@ mln_lang_real_not(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     mln_u8_t b = !mln_lang_real_var_toreal(op1);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_BOOL, &b)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
@@ -1039,18 +955,12 @@ mln_lang_real_pinc(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     double r = mln_lang_real_var_toreal(op1) + 1;
     mln_lang_var_set_real(op1, r);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
     }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
-        return -1;
-    }
     return 0;
 }
 
@@ -1063,16 +973,10 @@ mln_lang_real_pdec(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op
         if (rc > 0) return 0;
     }
 
-    mln_lang_val_t *val;
     double r = mln_lang_real_var_toreal(op1) - 1;
     mln_lang_var_set_real(op1, r);
-    if ((val = mln_lang_val_new(ctx, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
-        mln_lang_errmsg(ctx, "No memory.");
-        return -1;
-    }
-    if ((*ret = mln_lang_var_new(ctx, NULL, M_LANG_VAR_NORMAL, val, NULL)) == NULL) {
+    if ((*ret = mln_lang_var_result(ctx, op1, M_LANG_VAL_TYPE_REAL, &r)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
-        mln_lang_val_free(val);
         return -1;
     }
     return 0;
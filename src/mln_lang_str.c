@@ -14,6 +14,8 @@
 #endif
 
 static inline mln_string_t *__mln_lang_str_var_tostring(mln_alloc_t *pool, mln_lang_var_t *var);
+static inline int mln_lang_str_can_append(mln_lang_val_t *val);
+static inline int mln_lang_str_append(mln_alloc_t *pool, mln_string_t *s1, mln_string_t *s2);
 static int
 mln_lang_str_assign(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1, mln_lang_var_t *op2);
 static int
@@ -218,6 +220,59 @@ static inline mln_string_t *__mln_lang_str_var_tostring(mln_alloc_t *pool, mln_l
     return mln_string_pool_dup(pool, &tmp);
 }
 
+/*
+ * True when 'val' holds a string this context may grow in place: the
+ * value and the string are both unshared (interned constants and
+ * watched values are shared or flagged and fall out here) and the
+ * string either owns its buffer or is the inline small-string layout.
+ */
+static inline int mln_lang_str_can_append(mln_lang_val_t *val)
+{
+    mln_string_t *s;
+    if (val == NULL || val->type != M_LANG_VAL_TYPE_STRING) return 0;
+    if (val->ref != 1 || val->not_modify || val->udata != NULL || val->func != NULL) return 0;
+    if ((s = val->data.s) == NULL || s->ref != 1 || !s->pool) return 0;
+    if (s->data_ref && s->data != (mln_u8ptr_t)(s + 1)) return 0;
+    return 1;
+}
+
+/*
+ * Appends 's2' onto 's1' in place. The buffer is grown to a
+ * power-of-two capacity, so mln_alloc_re() keeps the block as long as
+ * the capacity class fits and each byte is copied O(log n) times over
+ * a whole build-by-append loop instead of once per iteration.
+ */
+static inline int mln_lang_str_append(mln_alloc_t *pool, mln_string_t *s1, mln_string_t *s2)
+{
+    mln_u8ptr_t data, src;
+    mln_u64_t need, cap, off = 0, slen = s2->len;
+    int alias = 0;
+
+    if (slen == 0) return 0;
+    if (s1->data != NULL && s2->data >= s1->data && s2->data < s1->data + s1->len) {
+        alias = 1;/*appending (a slice of) the string onto itself*/
+        off = (mln_u64_t)(s2->data - s1->data);
+    }
+    need = s1->len + slen + 1;
+    for (cap = 32; cap < need; cap <<= 1) ;
+    if (s1->data == NULL || s1->data_ref) {
+        /* empty or inline layout: move into an owned, growable buffer */
+        if ((data = (mln_u8ptr_t)mln_alloc_m(pool, cap)) == NULL) return -1;
+        if (s1->len > 0) memcpy(data, s1->data, s1->len);
+        s1->data = data;
+        s1->data_ref = 0;
+    } else {
+        if ((data = (mln_u8ptr_t)mln_alloc_re(pool, s1->data, cap)) == NULL) return -1;
+        s1->data = data;
+    }
+    src = alias? s1->data + off: s2->data;
+    memcpy(s1->data + s1->len, src, slen);
+    s1->len += slen;
+    s1->data[s1->len] = 0;
+    s1->hash = 0;/*content changed, drop the cached hash*/
+    return 0;
+}
+
 static int
 mln_lang_str_assign(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1, mln_lang_var_t *op2)
 {
@@ -245,6 +300,20 @@ mln_lang_str_pluseq(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *o
     }
 
     mln_string_t *s, *tmp1, *tmp2;
+    if (mln_lang_str_can_append(op1->val)) {
+        if ((tmp2 = __mln_lang_str_var_tostring(ctx->pool, op2)) == NULL) {
+            mln_lang_errmsg(ctx, "No memory.");
+            return -1;
+        }
+        if (mln_lang_str_append(ctx->pool, op1->val->data.s, tmp2) < 0) {
+            mln_lang_errmsg(ctx, "No memory.");
+            mln_string_free(tmp2);
+            return -1;
+        }
+        mln_string_free(tmp2);
+        *ret = mln_lang_var_ref(op1);
+        return 0;
+    }
     if ((tmp1 = __mln_lang_str_var_tostring(ctx->pool, op1)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
@@ -698,6 +767,27 @@ mln_lang_str_plus(mln_lang_ctx_t *ctx, mln_lang_var_t **ret, mln_lang_var_t *op1
 
     mln_string_t *s, *tmp1, *tmp2;
     mln_lang_val_t *val;
+    /*
+     * A dying temporary on the left -- the intermediate of a chained
+     * concatenation like a+b+c -- is extended in place and handed on,
+     * so the already-built prefix is not copied again per term.
+     */
+    if (op1->ref == 0 && op1->name == NULL && op1->in_set == NULL && \
+        mln_lang_str_can_append(op1->val))
+    {
+        if ((tmp2 = __mln_lang_str_var_tostring(ctx->pool, op2)) == NULL) {
+            mln_lang_errmsg(ctx, "No memory.");
+            return -1;
+        }
+        if (mln_lang_str_append(ctx->pool, op1->val->data.s, tmp2) < 0) {
+            mln_lang_errmsg(ctx, "No memory.");
+            mln_string_free(tmp2);
+            return -1;
+        }
+        mln_string_free(tmp2);
+        *ret = mln_lang_var_ref(op1);
+        return 0;
+    }
     if ((tmp1 = __mln_lang_str_var_tostring(ctx->pool, op1)) == NULL) {
         mln_lang_errmsg(ctx, "No memory.");
         return -1;
@@ -12,6 +12,9 @@
 #include <errno.h>
 #include <unistd.h>
 #include <ctype.h>
+#if !defined(WIN32)
+#include <sys/mman.h>
+#endif
 #include "mln_string.h"
 #include "mln_lex.h"
 
@@ -90,6 +93,7 @@ mln_lex_input_new(mln_lex_t *lex, mln_u32_t type, mln_string_t *data, int *err,
         return NULL;
     }
     li->dir = NULL;
+    li->mapped = 0;
     if (type == M_INPUT_T_BUF) {
         li->fd = -1;
         li->pos = li->buf = li->data->data;
@@ -166,6 +170,23 @@ goon:
         }
         li->buf = li->pos = NULL;
         li->buf_len = MLN_DEFAULT_BUFLEN;
+#if !defined(WIN32)
+        /*
+         * Map the whole file and scan it in place. Falls back to the
+         * buffered read path if the mapping fails (e.g. a pipe).
+         */
+        {
+            struct stat st;
+            void *m;
+            if (fstat(li->fd, &st) == 0 && st.st_size > 0 && \
+                (m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, li->fd, 0)) != MAP_FAILED)
+            {
+                li->buf = li->pos = (mln_u8ptr_t)m;
+                li->buf_len = st.st_size;
+                li->mapped = 1;
+            }
+        }
+#endif
     } else {
         mln_alloc_free(li->data);
         mln_alloc_free(li);
@@ -183,7 +204,14 @@ void mln_lex_input_free(void *in)
     if (input->fd >= 0) close(input->fd);
     if (input->data != NULL) mln_string_free(input->data);
     if (input->dir != NULL) mln_string_free(input->dir);
-    if (input->buf != NULL && input->type == M_INPUT_T_FILE) mln_alloc_free(input->buf);
+    if (input->buf != NULL && input->type == M_INPUT_T_FILE) {
+#if !defined(WIN32)
+        if (input->mapped)
+            munmap(input->buf, input->buf_len);
+        else
+#endif
+            mln_alloc_free(input->buf);
+    }
     mln_alloc_free(input);
 }
 
@@ -251,6 +279,69 @@ static int mln_lex_keywords_cmp(const void *data1, const void *data2)
     return mln_string_strcmp(lk1->keyword, lk2->keyword);
 }
 
+/*
+ * Searches for a hash seed that places every keyword in its own slot,
+ * so recognition at token time is one hash plus one memcmp() instead of
+ * a tree walk. The keyword set is fixed at init, so the search runs
+ * once. On failure (no seed found or no memory) the lexer just keeps
+ * the red-black tree lookup.
+ */
+static void mln_lex_keyword_tbl_build(mln_lex_t *lex, mln_string_t *keywords)
+{
+    mln_uauto_t n = 0, i, tries;
+    mln_u64_t len, seed = 0;
+    mln_string_t *scan, **slots;
+    mln_lex_keyword_t *tbl;
+
+    for (scan = keywords; scan->data != NULL; ++scan) ++n;
+    if (n == 0) return;
+    for (len = 1; len < (n << 2); len <<= 1) ;
+
+    if ((slots = (mln_string_t **)malloc(len * sizeof(mln_string_t *))) == NULL)
+        return;
+    for (tries = 0; ; ++tries) {
+        if (tries == 32) {
+            mln_string_t **tmp;
+            if (len >= 65536 || (tmp = (mln_string_t **)realloc(slots, (len << 1) * sizeof(mln_string_t *))) == NULL) {
+                free(slots);
+                return;
+            }
+            slots = tmp;
+            len <<= 1;
+            tries = 0;
+        }
+        seed += 0x9e3779b97f4a7c15ULL;
+        memset(slots, 0, len * sizeof(mln_string_t *));
+        for (scan = keywords; scan->data != NULL; ++scan) {
+            i = mln_lex_keyword_hash(scan->data, scan->len, seed) & (len - 1);
+            if (slots[i] != NULL) break;
+            slots[i] = scan;
+        }
+        if (scan->data == NULL) break;
+    }
+
+    if ((tbl = (mln_lex_keyword_t *)mln_alloc_c(lex->pool, len * sizeof(mln_lex_keyword_t))) == NULL) {
+        free(slots);
+        return;
+    }
+    for (i = 0; i < len; ++i) {
+        if (slots[i] == NULL) continue;
+        if ((tbl[i].keyword = mln_string_pool_dup(lex->pool, slots[i])) == NULL) {
+            while (i > 0) {
+                if (tbl[--i].keyword != NULL) mln_string_free(tbl[i].keyword);
+            }
+            mln_alloc_free(tbl);
+            free(slots);
+            return;
+        }
+        tbl[i].val = slots[i] - keywords;
+    }
+    free(slots);
+    lex->kw_tbl = tbl;
+    lex->kw_tbl_len = len;
+    lex->kw_seed = seed;
+}
+
 mln_lex_t *mln_lex_init(struct mln_lex_attr *attr)
 {
     mln_lex_macro_t *lm;
@@ -307,6 +398,9 @@ err:
     else
         memset(&(lex->hooks), 0, sizeof(mln_lex_hooks_t));
 
+    lex->kw_tbl = NULL;
+    lex->kw_tbl_len = 0;
+    lex->kw_seed = 0;
     if (attr->keywords != NULL) {
         rbattr.pool = lex->pool;
         rbattr.pool_alloc = (rbtree_pool_alloc_handler)mln_alloc_m;
@@ -331,6 +425,7 @@ err:
             }
             mln_rbtree_insert(lex->keywords, rn);
         }
+        mln_lex_keyword_tbl_build(lex, attr->keywords);
     } else {
         lex->keywords = NULL;
     }
@@ -383,6 +478,13 @@ void mln_lex_destroy(mln_lex_t *lex)
     if (lex->err_msg != NULL) mln_alloc_free(lex->err_msg);
     if (lex->result_buf != NULL) mln_alloc_free(lex->result_buf);
     if (lex->keywords != NULL) mln_rbtree_free(lex->keywords);
+    if (lex->kw_tbl != NULL) {
+        mln_u64_t i;
+        for (i = 0; i < lex->kw_tbl_len; ++i) {
+            if (lex->kw_tbl[i].keyword != NULL) mln_string_free(lex->kw_tbl[i].keyword);
+        }
+        mln_alloc_free(lex->kw_tbl);
+    }
     if (lex->env != NULL) mln_alloc_free(lex->env);
     mln_alloc_free(lex);
 }
@@ -13,9 +13,14 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include <errno.h>
+#if !defined(WIN32)
+#include <pthread.h>
+#include <sched.h>
+#endif
 #include "mln_log.h"
 #include "mln_path.h"
 #include "mln_tools.h"
+#include "mln_clock.h"
 
 /*
  * declarations
@@ -37,15 +42,547 @@ static void mln_log_atfork_lock(void);
 static void mln_log_atfork_unlock(void);
 #endif
 static int mln_log_get_log(mln_log_t *log, mln_conf_t *cf, int is_init);
+static int mln_log_set_async(mln_log_t *log, mln_conf_t *cf, int is_init);
+extern char log_err_fmt[];
 static mln_logger_t _logger = _mln_sys_log_process;
 
+/*
+ * Formatted-timestamp cache. The date/time prefix only changes once a
+ * second, so each logging thread keeps the last rendered prefix and
+ * memcpy's it while the second still matches instead of re-running
+ * snprintf per record; the flusher keeps a cache of its own for
+ * binary-record rendering.
+ */
+typedef struct {
+    time_t                        sec;
+    mln_u32_t                     len;
+    char                          buf[40];
+} mln_log_tm_cache_t;
+
+static __thread mln_log_tm_cache_t m_log_tm_cache;
+
+static inline mln_u32_t mln_log_tm_prefix(mln_log_tm_cache_t *c, time_t sec)
+{
+    if (sec != c->sec || c->len == 0) {
+        struct utctime uc;
+        mln_time2utc(sec, &uc);
+        c->len = (mln_u32_t)snprintf(c->buf, sizeof(c->buf)-1, \
+                                     "%02ld/%02ld/%ld %02ld:%02ld:%02ld GMT ", \
+                                     uc.month, uc.day, uc.year, \
+                                     uc.hour, uc.minute, uc.second);
+        c->sec = sec;
+    }
+    return c->len;
+}
+
+/*
+ * async mode
+ */
+#if !defined(WIN32)
+#define M_LOG_ASYNC_RING_SIZE (1 << 16) /*per-thread, power of two*/
+#define M_LOG_ASYNC_REC_SIZE  4096
+
+typedef struct mln_log_async_ring_s {
+    mln_u8_t                      buf[M_LOG_ASYNC_RING_SIZE];
+    volatile mln_u64_t            head;     /*consumer position*/
+    volatile mln_u64_t            tail;     /*producer position*/
+    volatile mln_u64_t            dropped;
+    mln_u64_t                     reported; /*flusher only*/
+    struct mln_log_async_ring_s  *next;
+} mln_log_async_ring_t;
+
+static __thread mln_log_async_ring_t *m_log_ring = NULL;
+static __thread struct {
+    char                          buf[M_LOG_ASYNC_REC_SIZE];
+    mln_size_t                    len;
+    int                           active;
+} m_log_staging;
+
+static mln_log_async_ring_t *g_log_rings = NULL;
+static pthread_mutex_t g_log_rings_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t g_log_flusher;
+static volatile int g_log_flusher_running = 0;
+
+/*
+ * Binary mode ('log_binary on;'): ring content becomes a sequence of
+ * framed records instead of raw text. A frame is this header followed
+ * by 'size' payload bytes; M_LOG_FRAME_BIN payload is a
+ * mln_log_bin_rec_t followed by the captured arguments of the format
+ * string, in order. Pointers stored in the record are to string
+ * literals and stay valid because rendering happens in-process.
+ */
+#define M_LOG_FRAME_TEXT 0
+#define M_LOG_FRAME_BIN  1
+
+typedef struct {
+    mln_u32_t                     size; /*payload bytes following this header*/
+    mln_u32_t                     type;
+} mln_log_frame_t;
+
+typedef struct {
+    mln_u64_t                     msg;  /*format string address*/
+    mln_u64_t                     file;
+    mln_u64_t                     func;
+    mln_u64_t                     sec;
+    mln_u32_t                     level;
+    mln_u32_t                     line;
+    mln_u32_t                     pid;
+    mln_u32_t                     padding;
+} mln_log_bin_rec_t;
+
+static void mln_log_async_enqueue(mln_u8ptr_t buf, mln_size_t size)
+{
+    mln_u64_t head, tail, off, part;
+    mln_log_async_ring_t *r = m_log_ring;
+
+    if (r == NULL) {
+        if ((r = (mln_log_async_ring_t *)calloc(1, sizeof(mln_log_async_ring_t))) == NULL)
+            return;
+        pthread_mutex_lock(&g_log_rings_lock);
+        r->next = g_log_rings;
+        __atomic_store_n(&g_log_rings, r, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&g_log_rings_lock);
+        m_log_ring = r;
+    }
+    if (size > M_LOG_ASYNC_REC_SIZE + sizeof(mln_log_frame_t))
+        size = M_LOG_ASYNC_REC_SIZE + sizeof(mln_log_frame_t);
+    while (1) {
+        head = __atomic_load_n(&(r->head), __ATOMIC_ACQUIRE);
+        tail = r->tail;
+        if (M_LOG_ASYNC_RING_SIZE - (tail - head) >= size) break;
+        if (!g_log.overflow_block) {
+            __atomic_add_fetch(&(r->dropped), 1, __ATOMIC_SEQ_CST);
+            return;
+        }
+        sched_yield();
+    }
+    off = tail & (M_LOG_ASYNC_RING_SIZE - 1);
+    part = M_LOG_ASYNC_RING_SIZE - off;
+    if (part > size) part = size;
+    memcpy(r->buf + off, buf, part);
+    if (size > part) memcpy(r->buf, buf + part, size - part);
+    __atomic_store_n(&(r->tail), tail + size, __ATOMIC_RELEASE);
+}
+
+/*
+ * Publish a formatted text record: raw bytes in plain async mode, a
+ * text frame when the ring carries framed records (binary mode).
+ */
+static void mln_log_async_publish(mln_u8ptr_t buf, mln_size_t size)
+{
+    if (!g_log.binary) {
+        mln_log_async_enqueue(buf, size);
+        return;
+    }
+    mln_u8_t tmp[sizeof(mln_log_frame_t) + M_LOG_ASYNC_REC_SIZE];
+    mln_log_frame_t *f = (mln_log_frame_t *)tmp;
+    if (size > M_LOG_ASYNC_REC_SIZE) size = M_LOG_ASYNC_REC_SIZE;
+    f->size = (mln_u32_t)size;
+    f->type = M_LOG_FRAME_TEXT;
+    memcpy(tmp + sizeof(mln_log_frame_t), buf, size);
+    mln_log_async_enqueue(tmp, sizeof(mln_log_frame_t) + size);
+}
+
+/*
+ * Capture a log call as a framed binary record in 'buf': frame header,
+ * record header, then one encoded argument per format directive
+ * (strings length-prefixed, numbers widened to 8 bytes). Returns the
+ * total frame size, or -1 on an unknown directive or an oversized
+ * record -- the caller then falls back to the formatted path.
+ */
+static int mln_log_bin_encode(mln_log_level_t level, \
+                              const char *file, \
+                              const char *func, \
+                              int line, \
+                              char *msg, \
+                              va_list arg, \
+                              mln_u8_t *buf, \
+                              mln_size_t size)
+{
+    mln_log_frame_t *f = (mln_log_frame_t *)buf;
+    mln_log_bin_rec_t *rec = (mln_log_bin_rec_t *)(f + 1);
+    mln_u8_t *p = (mln_u8_t *)(rec + 1), *end = buf + size;
+    char *fmt = msg;
+    struct timeval tv;
+    mln_u64_t v;
+    mln_u32_t len;
+
+    if (p > end) return -1;
+    mln_clock_wall(&tv);
+    rec->msg = (mln_u64_t)msg;
+    rec->file = (mln_u64_t)file;
+    rec->func = (mln_u64_t)func;
+    rec->sec = (mln_u64_t)tv.tv_sec;
+    rec->level = (mln_u32_t)level;
+    rec->line = (mln_u32_t)line;
+    rec->pid = (mln_u32_t)getpid();
+    rec->padding = 0;
+    for (; *fmt != 0; ++fmt) {
+        if (*fmt != '%') continue;
+        switch (*++fmt) {
+            case 's':
+            {
+                char *s = va_arg(arg, char *);
+                len = (mln_u32_t)strlen(s);
+                if (p + sizeof(len) + len > end) return -1;
+                memcpy(p, &len, sizeof(len));
+                memcpy(p + sizeof(len), s, len);
+                p += sizeof(len) + len;
+                break;
+            }
+            case 'S':
+            {
+                mln_string_t *s = va_arg(arg, mln_string_t *);
+                len = (mln_u32_t)s->len;
+                if (p + sizeof(len) + len > end) return -1;
+                memcpy(p, &len, sizeof(len));
+                memcpy(p + sizeof(len), s->data, len);
+                p += sizeof(len) + len;
+                break;
+            }
+            case 'f':
+            {
+                double d = va_arg(arg, double);
+                if (p + sizeof(d) > end) return -1;
+                memcpy(p, &d, sizeof(d));
+                p += sizeof(d);
+                break;
+            }
+            case 'l': v = (mln_u64_t)va_arg(arg, long); goto num;
+            case 'd': v = (mln_u64_t)va_arg(arg, int); goto num;
+            case 'c': v = (mln_u64_t)va_arg(arg, int); goto num;
+            case 'x': v = (mln_u64_t)va_arg(arg, int); goto num;
+            case 'X': v = (mln_u64_t)va_arg(arg, long); goto num;
+            case 'u': v = (mln_u64_t)va_arg(arg, unsigned int); goto num;
+            case 'U': v = (mln_u64_t)va_arg(arg, unsigned long); goto num;
+            case 'i':
+#if defined(i386) || defined(__arm__)
+                v = (mln_u64_t)va_arg(arg, long long);
+#else
+                v = (mln_u64_t)va_arg(arg, long);
+#endif
+                goto num;
+            case 'I':
+#if defined(i386) || defined(__arm__)
+                v = (mln_u64_t)va_arg(arg, unsigned long long);
+#else
+                v = (mln_u64_t)va_arg(arg, unsigned long);
+#endif
+num:
+                if (p + sizeof(v) > end) return -1;
+                memcpy(p, &v, sizeof(v));
+                p += sizeof(v);
+                break;
+            default:
+                return -1; /*let the formatted path report the error*/
+        }
+    }
+    f->size = (mln_u32_t)(p - (mln_u8_t *)rec);
+    f->type = M_LOG_FRAME_BIN;
+    return (int)(p - buf);
+}
+
+/*
+ * Output buffer for the renderer: one record becomes one (or very few)
+ * writes instead of a write per format fragment.
+ */
+typedef struct {
+    mln_log_t                    *log;
+    mln_u32_t                     len;
+    mln_u8_t                      buf[M_LOG_ASYNC_REC_SIZE];
+} mln_log_render_buf_t;
+
+static inline void mln_log_render_put(mln_log_render_buf_t *rb, void *data, mln_u32_t n)
+{
+    if (n > sizeof(rb->buf)) n = sizeof(rb->buf); /*fragments are bounded by the record size*/
+    if (rb->len + n > sizeof(rb->buf)) {
+        mln_log_write(rb->log, rb->buf, rb->len);
+        rb->len = 0;
+    }
+    memcpy(rb->buf + rb->len, data, n);
+    rb->len += n;
+}
+
+/*
+ * Render a binary record to text, mirroring _mln_sys_log_process.
+ * Only called from the flusher, which already holds the log locks.
+ */
+static void mln_log_bin_render(mln_log_t *log, mln_u8_t *payload, mln_u32_t size)
+{
+    static mln_log_tm_cache_t render_tm_cache; /*flusher only*/
+    mln_log_bin_rec_t *rec = (mln_log_bin_rec_t *)payload;
+    mln_u8_t *p = payload + sizeof(mln_log_bin_rec_t), *end = payload + size;
+    char *msg, *seg, *file, *func;
+    char line_str[256];
+    int n, cnt;
+    mln_u64_t v;
+    mln_u32_t len;
+    mln_log_render_buf_t rb;
+
+    if (size < sizeof(mln_log_bin_rec_t)) return;
+    rb.log = log;
+    rb.len = 0;
+    msg = (char *)(rec->msg);
+    file = (char *)(rec->file);
+    func = (char *)(rec->func);
+    if (rec->level > none) {
+        n = mln_log_tm_prefix(&render_tm_cache, (time_t)(rec->sec));
+        mln_log_render_put(&rb, (void *)render_tm_cache.buf, n);
+    }
+    switch (rec->level) {
+        case none:
+            break;
+        case report:
+            mln_log_render_put(&rb, (void *)"REPORT: ", 8);
+            break;
+        case debug:
+            mln_log_render_put(&rb, (void *)"DEBUG: ", 7);
+            break;
+        case warn:
+            mln_log_render_put(&rb, (void *)"WARN: ", 6);
+            break;
+        case error:
+            mln_log_render_put(&rb, (void *)"ERROR: ", 7);
+            break;
+        default:
+            return;
+    }
+    if (rec->level >= debug) {
+        mln_log_render_put(&rb, (void *)file, strlen(file));
+        mln_log_render_put(&rb, (void *)":", 1);
+        mln_log_render_put(&rb, (void *)func, strlen(func));
+        mln_log_render_put(&rb, (void *)":", 1);
+        n = snprintf(line_str, sizeof(line_str)-1, "%d", (int)(rec->line));
+        mln_log_render_put(&rb, (void *)line_str, n);
+        mln_log_render_put(&rb, (void *)": ", 2);
+    }
+    if (rec->level > none) {
+        n = snprintf(line_str, sizeof(line_str)-1, "PID:%d ", (int)(rec->pid));
+        mln_log_render_put(&rb, (void *)line_str, n);
+    }
+
+    cnt = 0;
+    seg = msg;
+    while (*msg != 0) {
+        if (*msg != '%') {
+            ++cnt;
+            ++msg;
+            continue;
+        }
+        mln_log_render_put(&rb, (void *)seg, cnt);
+        cnt = 0;
+        ++msg;
+        seg = msg + 1;
+        switch (*msg) {
+            case 's':
+            case 'S':
+                if (p + sizeof(len) > end) goto err;
+                memcpy(&len, p, sizeof(len));
+                p += sizeof(len);
+                if (p + len > end) goto err;
+                mln_log_render_put(&rb, (void *)p, len);
+                p += len;
+                break;
+            case 'f':
+            {
+                double d;
+                if (p + sizeof(d) > end) goto err;
+                memcpy(&d, p, sizeof(d));
+                p += sizeof(d);
+                n = snprintf(line_str, sizeof(line_str)-1, "%f", d);
+                mln_log_render_put(&rb, (void *)line_str, n);
+                break;
+            }
+            case 'c':
+                if (p + sizeof(v) > end) goto err;
+                memcpy(&v, p, sizeof(v));
+                p += sizeof(v);
+                line_str[0] = (char)v;
+                mln_log_render_put(&rb, (void *)line_str, 1);
+                break;
+            case 'l':
+            case 'd':
+            case 'x':
+            case 'X':
+            case 'u':
+            case 'U':
+            case 'i':
+            case 'I':
+                if (p + sizeof(v) > end) goto err;
+                memcpy(&v, p, sizeof(v));
+                p += sizeof(v);
+                switch (*msg) {
+                    case 'l':
+                        n = snprintf(line_str, sizeof(line_str)-1, "%ld", (long)v);
+                        break;
+                    case 'd':
+                        n = snprintf(line_str, sizeof(line_str)-1, "%d", (int)v);
+                        break;
+                    case 'x':
+                        n = snprintf(line_str, sizeof(line_str)-1, "%x", (int)v);
+                        break;
+                    case 'X':
+                        n = snprintf(line_str, sizeof(line_str)-1, "%lx", (long)v);
+                        break;
+                    case 'u':
+                        n = snprintf(line_str, sizeof(line_str)-1, "%u", (unsigned int)v);
+                        break;
+                    case 'U':
+                        n = snprintf(line_str, sizeof(line_str)-1, "%lu", (unsigned long)v);
+                        break;
+                    case 'i':
+#if defined(i386) || defined(__arm__)
+                        n = snprintf(line_str, sizeof(line_str)-1, "%lld", (long long)v);
+#else
+                        n = snprintf(line_str, sizeof(line_str)-1, "%ld", (long)v);
+#endif
+                        break;
+                    default: /*'I'*/
+#if defined(i386) || defined(__arm__)
+                        n = snprintf(line_str, sizeof(line_str)-1, "%llu", (unsigned long long)v);
+#else
+                        n = snprintf(line_str, sizeof(line_str)-1, "%lu", (unsigned long)v);
+#endif
+                        break;
+                }
+                mln_log_render_put(&rb, (void *)line_str, n);
+                break;
+            default:
+                goto err;
+        }
+        ++msg;
+    }
+    if (cnt)
+        mln_log_render_put(&rb, (void *)seg, cnt);
+    if (rb.len) mln_log_write(log, rb.buf, rb.len);
+    return;
+err:
+    mln_log_render_put(&rb, (void *)log_err_fmt, strlen(log_err_fmt));
+    mln_log_render_put(&rb, (void *)"\n", 1);
+    if (rb.len) mln_log_write(log, rb.buf, rb.len);
+}
+
+/*
+ * Wrap-aware copy out of a ring, 'pos' being a virtual position.
+ */
+static inline void
+mln_log_ring_copy(mln_log_async_ring_t *r, mln_u64_t pos, mln_u8_t *dst, mln_u64_t n)
+{
+    mln_u64_t off = pos & (M_LOG_ASYNC_RING_SIZE - 1);
+    mln_u64_t part = M_LOG_ASYNC_RING_SIZE - off;
+    if (part > n) part = n;
+    memcpy(dst, r->buf + off, part);
+    if (n > part) memcpy(dst + part, r->buf, n - part);
+}
+
+static int mln_log_async_drain(void)
+{
+    int busy = 0, n;
+    mln_u64_t head, tail, off, chunk, dropped;
+    mln_log_async_ring_t *r;
+    char note[128];
+
+    for (r = __atomic_load_n(&g_log_rings, __ATOMIC_ACQUIRE); r != NULL; r = r->next) {
+        tail = __atomic_load_n(&(r->tail), __ATOMIC_ACQUIRE);
+        head = r->head;
+        if (tail != head) {
+            busy = 1;
+            mln_spin_lock(&(g_log.thread_lock));
+            mln_file_lock(g_log.fd);
+            if (g_log.binary) {
+                mln_log_frame_t f;
+                mln_u8_t payload[M_LOG_ASYNC_REC_SIZE];
+                while (tail - head >= sizeof(f)) {
+                    mln_log_ring_copy(r, head, (mln_u8_t *)&f, sizeof(f));
+                    if (f.size > M_LOG_ASYNC_REC_SIZE || tail - head < sizeof(f) + f.size)
+                        break; /*never happens: frames are published whole*/
+                    mln_log_ring_copy(r, head + sizeof(f), payload, f.size);
+                    head += sizeof(f) + f.size;
+                    if (f.type == M_LOG_FRAME_BIN)
+                        mln_log_bin_render(&g_log, payload, f.size);
+                    else
+                        mln_log_write(&g_log, payload, f.size);
+                }
+            } else {
+                while (head != tail) {
+                    off = head & (M_LOG_ASYNC_RING_SIZE - 1);
+                    chunk = tail - head;
+                    if (chunk > M_LOG_ASYNC_RING_SIZE - off) chunk = M_LOG_ASYNC_RING_SIZE - off;
+                    mln_log_write(&g_log, r->buf + off, chunk);
+                    head += chunk;
+                }
+            }
+            mln_file_unlock(g_log.fd);
+            mln_spin_unlock(&(g_log.thread_lock));
+            __atomic_store_n(&(r->head), head, __ATOMIC_RELEASE);
+        }
+        dropped = __atomic_load_n(&(r->dropped), __ATOMIC_SEQ_CST);
+        if (dropped != r->reported) {
+            n = snprintf(note, sizeof(note) - 1, \
+                         "WARN: log: %lu record(s) dropped, ring full\n", \
+                         (unsigned long)(dropped - r->reported));
+            mln_spin_lock(&(g_log.thread_lock));
+            mln_file_lock(g_log.fd);
+            mln_log_write(&g_log, note, n);
+            mln_file_unlock(g_log.fd);
+            mln_spin_unlock(&(g_log.thread_lock));
+            r->reported = dropped;
+        }
+    }
+    return busy;
+}
+
+static void *mln_log_async_flusher(void *arg)
+{
+    while (__atomic_load_n(&g_log_flusher_running, __ATOMIC_SEQ_CST)) {
+        if (!mln_log_async_drain()) usleep(1000);
+    }
+    mln_log_async_drain();
+    return NULL;
+}
+
+static int mln_log_async_start(void)
+{
+    if (g_log_flusher_running) return 0;
+    g_log_flusher_running = 1;
+    if (pthread_create(&g_log_flusher, NULL, mln_log_async_flusher, NULL) != 0) {
+        g_log_flusher_running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+static void mln_log_async_stop(void)
+{
+    if (!g_log_flusher_running) return;
+    __atomic_store_n(&g_log_flusher_running, 0, __ATOMIC_SEQ_CST);
+    pthread_join(g_log_flusher, NULL);
+    /*
+     * rings stay allocated: other threads keep thread-local pointers
+     * into them and may still format a record during shutdown.
+     */
+}
+#endif
+
+mln_u64_t mln_log_async_dropped(void)
+{
+    mln_u64_t total = 0;
+#if !defined(WIN32)
+    mln_log_async_ring_t *r;
+    for (r = __atomic_load_n(&g_log_rings, __ATOMIC_ACQUIRE); r != NULL; r = r->next) {
+        total += __atomic_load_n(&(r->dropped), __ATOMIC_SEQ_CST);
+    }
+#endif
+    return total;
+}
+
 /*
  * global variables
  */
 char log_err_level[] = "Log level permission deny.";
 char log_err_fmt[] = "Log message format error.";
 char log_path_cmd[] = "log_path";
-mln_log_t g_log = {{0},{0},{0},STDERR_FILENO,0,0,none,(mln_spin_t)0};
+mln_log_t g_log = {{0},{0},{0},STDERR_FILENO,0,0,0,0,0,0,none,(mln_spin_t)0};
 
 /*
  * file lock
@@ -153,6 +690,12 @@ int mln_log_init(mln_conf_t *cf)
         mln_log_destroy();
         return -1;
     }
+
+    if (mln_log_set_async(log, cf, 1) < 0) {
+        fprintf(stderr, "%s(): Set log async mode failed.\n", __FUNCTION__);
+        mln_log_destroy();
+        return -1;
+    }
     return 0;
 }
 
@@ -264,6 +807,9 @@ static void mln_log_atfork_unlock(void)
 void mln_log_destroy(void)
 {
     mln_log_t *log = &g_log;
+#if !defined(WIN32)
+    mln_log_async_stop();
+#endif
     if (log->fd > 0 && \
         log->fd != STDIN_FILENO && \
         log->fd != STDOUT_FILENO && \
@@ -326,6 +872,83 @@ static int mln_log_set_level(mln_log_t *log, mln_conf_t *cf, int is_init)
     return 0;
 }
 
+/*
+ * mln_log_set_async
+ */
+static int mln_log_set_async(mln_log_t *log, mln_conf_t *cf, int is_init)
+{
+#if defined(WIN32)
+    return 0;
+#else
+    if (cf == NULL) return 0;
+
+    mln_conf_domain_t *cd = cf->search(cf, "main");
+    if (cd == NULL) return 0;
+    mln_conf_cmd_t *cc = cd->search(cd, "log_async_overflow");
+    mln_conf_item_t *ci;
+    if (cc != NULL) {
+        ci = cc->search(cc, 1);
+        if (ci == NULL || ci->type != CONF_STR) {
+            if (is_init)
+                fprintf(stderr, "Parameter type of command 'log_async_overflow' error.\n");
+            else
+                mln_log(error, "Parameter type of command 'log_async_overflow' error.\n");
+            return -1;
+        }
+        if (!mln_string_const_strcmp(ci->val.s, "drop")) {
+            log->overflow_block = 0;
+        } else if (!mln_string_const_strcmp(ci->val.s, "block")) {
+            log->overflow_block = 1;
+        } else {
+            if (is_init)
+                fprintf(stderr, "Parameter value of command [log_async_overflow] error.\n");
+            else
+                mln_log(error, "Parameter value of command [log_async_overflow] error.\n");
+            return -1;
+        }
+    }
+
+    cc = cd->search(cd, "log_async");
+    if (cc != NULL) {
+        ci = cc->search(cc, 1);
+        if (ci == NULL || ci->type != CONF_BOOL) {
+            if (is_init)
+                fprintf(stderr, "Parameter type of command 'log_async' error.\n");
+            else
+                mln_log(error, "Parameter type of command 'log_async' error.\n");
+            return -1;
+        }
+        log->async = ci->val.b? 1: 0;
+    }
+
+    /*
+     * binary mode is fixed at initialization: it changes the ring
+     * content from raw text to framed records, which cannot be
+     * switched while rings may still hold the other format.
+     */
+    if (is_init) {
+        cc = cd->search(cd, "log_binary");
+        if (cc != NULL) {
+            ci = cc->search(cc, 1);
+            if (ci == NULL || ci->type != CONF_BOOL) {
+                fprintf(stderr, "Parameter type of command 'log_binary' error.\n");
+                return -1;
+            }
+            log->binary = ci->val.b? 1: 0;
+            if (log->binary) log->async = 1; /*deferred rendering needs the flusher*/
+        }
+    }
+
+    /*the flusher thread is only started once, at initialization*/
+    if (is_init && log->async && mln_log_async_start() < 0) {
+        log->async = 0;
+        log->binary = 0;
+        return -1;
+    }
+    return 0;
+#endif
+}
+
 /*
  * log_reload
  */
@@ -335,6 +958,7 @@ int mln_log_reload(void *data)
     mln_log_get_log(&g_log, mln_conf(), 0);
     mln_file_lock(g_log.fd);
     int ret = mln_log_set_level(&g_log, mln_conf(), 0);
+    if (ret == 0) ret = mln_log_set_async(&g_log, mln_conf(), 0);
     mln_file_unlock(g_log.fd);
     mln_spin_unlock(&(g_log.thread_lock));
     return ret;
@@ -350,9 +974,41 @@ void _mln_sys_log(mln_log_level_t level, \
                   char *msg, \
                   ...)
 {
+    va_list arg;
+#if !defined(WIN32)
+    if (g_log.async && g_log_flusher_running) {
+        if (g_log.binary && _logger == _mln_sys_log_process) {
+            if (level < g_log.level) return;
+            mln_u8_t rec[sizeof(mln_log_frame_t) + M_LOG_ASYNC_REC_SIZE];
+            int n;
+            va_start(arg, msg);
+            n = mln_log_bin_encode(level, file, func, line, msg, arg, rec, sizeof(rec));
+            va_end(arg);
+            if (n > 0) {
+                mln_log_async_enqueue(rec, (mln_size_t)n);
+                return;
+            }
+            /*oversized record or unknown directive: take the formatted path*/
+        }
+        /*
+         * The record is formatted into a thread-local staging buffer
+         * and pushed into this thread's ring in one piece; no lock is
+         * taken on this path.
+         */
+        m_log_staging.active = 1;
+        m_log_staging.len = 0;
+        va_start(arg, msg);
+        if (_logger != NULL)
+            _logger(&g_log, level, file, func, line, msg, arg);
+        va_end(arg);
+        m_log_staging.active = 0;
+        if (m_log_staging.len > 0)
+            mln_log_async_publish((mln_u8ptr_t)(m_log_staging.buf), m_log_staging.len);
+        return;
+    }
+#endif
     mln_spin_lock(&(g_log.thread_lock));
     mln_file_lock(g_log.fd);
-    va_list arg;
     va_start(arg, msg);
     if (_logger != NULL)
         _logger(&g_log, level, file, func, line, msg, arg);
@@ -363,6 +1019,18 @@ void _mln_sys_log(mln_log_level_t level, \
 
 static inline ssize_t mln_log_write(mln_log_t *log, void *buf, mln_size_t size)
 {
+#if !defined(WIN32)
+    if (m_log_staging.active) {
+        if (m_log_staging.len + size > M_LOG_ASYNC_REC_SIZE) {
+            mln_log_async_publish((mln_u8ptr_t)(m_log_staging.buf), m_log_staging.len);
+            m_log_staging.len = 0;
+            if (size > M_LOG_ASYNC_REC_SIZE) size = M_LOG_ASYNC_REC_SIZE;
+        }
+        memcpy(m_log_staging.buf + m_log_staging.len, buf, size);
+        m_log_staging.len += size;
+        return size;
+    }
+#endif
     ssize_t ret = write(log->fd, buf, size);
     if (log->init && !log->in_daemon) {
         int rc = write(STDERR_FILENO, buf, size);
@@ -393,16 +1061,11 @@ _mln_sys_log_process(mln_log_t *log, \
     if (level < log->level) return;
     int n;
     struct timeval tv;
-    struct utctime uc;
-    gettimeofday(&tv, NULL);
-    mln_time2utc(tv.tv_sec, &uc);
+    mln_clock_wall(&tv);
     char line_str[256] = {0};
     if (level > none) {
-        n = snprintf(line_str, sizeof(line_str)-1, \
-                         "%02ld/%02ld/%ld %02ld:%02ld:%02ld GMT ", \
-                         uc.month, uc.day, uc.year, \
-                         uc.hour, uc.minute, uc.second);
-        mln_log_write(log, (void *)line_str, n);
+        n = mln_log_tm_prefix(&m_log_tm_cache, tv.tv_sec);
+        mln_log_write(log, (void *)m_log_tm_cache.buf, n);
     }
     switch (level) {
         case none:
@@ -7,15 +7,15 @@
 #include <string.h>
 #include "mln_md5.h"
 
-static inline void mln_md5_calc_block(mln_md5_t *m);
+static inline void mln_md5_compress(mln_md5_t *m, const mln_u8_t *block);
 
-static mln_u32_t s[4][4] = {
+static const mln_u32_t s[4][4] = {
     {7, 12, 17, 22},
     {5, 9, 14, 20},
     {4, 11, 16, 23},
     {6, 10, 15, 21}
 };
-static mln_u32_t ti[4][16] = {
+static const mln_u32_t ti[4][16] = {
     {0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
      0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
      0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
@@ -78,11 +78,18 @@ void mln_md5_calc(mln_md5_t *m, mln_u8ptr_t input, mln_uauto_t len, mln_u32_t is
 
     m->length += len;
     while (len+m->pos > __M_MD5_BUFLEN) {
+        if (m->pos == 0 && len > __M_MD5_BUFLEN) {
+            /*full block straight from the input, no staging copy*/
+            mln_md5_compress(m, input);
+            input += __M_MD5_BUFLEN;
+            len -= __M_MD5_BUFLEN;
+            continue;
+        }
         size = __M_MD5_BUFLEN - m->pos;
         memcpy(&(m->buf[m->pos]), input, size);
         len -= size;
         input += size;
-        mln_md5_calc_block(m);
+        mln_md5_compress(m, m->buf);
         m->pos = 0;
     }
 
@@ -98,11 +105,11 @@ void mln_md5_calc(mln_md5_t *m, mln_u8ptr_t input, mln_uauto_t len, mln_u32_t is
             if (m->pos < __M_MD5_BUFLEN) {
                 memset(&(m->buf[m->pos]), 0, __M_MD5_BUFLEN-m->pos);
                 m->buf[m->pos] = 1 << 7;
-                mln_md5_calc_block(m);
+                mln_md5_compress(m, m->buf);
                 m->pos = 0;
                 memset(m->buf, 0, 56);
             } else {
-                mln_md5_calc_block(m);
+                mln_md5_compress(m, m->buf);
                 m->pos = 0;
                 memset(m->buf, 0, 56);
                 m->buf[m->pos] = 1 << 7;
@@ -117,22 +124,28 @@ void mln_md5_calc(mln_md5_t *m, mln_u8ptr_t input, mln_uauto_t len, mln_u32_t is
         m->buf[61] = (m->length >> 40) & 0xff;
         m->buf[62] = (m->length >> 48) & 0xff;
         m->buf[63] = (m->length >> 56) & 0xff;
-        mln_md5_calc_block(m);
+        mln_md5_compress(m, m->buf);
         m->pos = 0;
     }
 }
 
-static inline void mln_md5_calc_block(mln_md5_t *m)
+static inline void mln_md5_compress(mln_md5_t *m, const mln_u8_t *block)
 {
-    mln_u32_t i = 0, j = 0, group[16];
+    mln_u32_t group[16];
     mln_u32_t a = m->A, b = m->B, c = m->C, d = m->D;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    /*MD5 words are little-endian, so the block is loadable as-is*/
+    memcpy(group, block, __M_MD5_BUFLEN);
+#else
+    mln_u32_t i = 0, j = 0;
     while (i < __M_MD5_BUFLEN) {
         group[j] = 0;
-        group[j] |= (m->buf[i++] & 0xff);
-        group[j] |= ((m->buf[i++] & 0xff) << 8);
-        group[j] |= ((m->buf[i++] & 0xff) << 16);
-        group[j++] |= ((m->buf[i++] & 0xff) << 24);
+        group[j] |= (block[i++] & 0xff);
+        group[j] |= ((block[i++] & 0xff) << 8);
+        group[j] |= ((block[i++] & 0xff) << 16);
+        group[j++] |= ((block[i++] & 0xff) << 24);
     }
+#endif
 
     __M_MD5_FF(a, b, c, d, group[0], s[0][0], ti[0][0]);
     __M_MD5_FF(d, a, b, c, group[1], s[0][1], ti[0][1]);
@@ -272,3 +285,171 @@ void mln_md5_dump(mln_md5_t *m)
     printf("%lx %lx %lx %lx\n", (unsigned long)m->A, (unsigned long)m->B, (unsigned long)m->C, (unsigned long)m->D);
 }
 
+
+void mln_md5_calc_chain(mln_md5_t *m, mln_chain_t *in, mln_u32_t is_last)
+{
+    mln_buf_t *b;
+
+    for (; in != NULL; in = in->next) {
+        if ((b = in->buf) == NULL || !b->in_memory || b->pos == NULL)
+            continue;
+        mln_md5_calc(m, b->pos, b->last - b->pos, is_last && in->next == NULL);
+    }
+}
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+/*
+ * Four independent MD5 states advance in lockstep, one message in each
+ * 32-bit lane; the round structure mirrors the scalar listing above.
+ * Lanes diverge once the shortest message runs out of full blocks, and
+ * each finishes through the scalar path.
+ */
+#define __M_MD5_X4_F(b,c,d) _mm_or_si128(_mm_and_si128(b,c), _mm_andnot_si128(b,d))
+#define __M_MD5_X4_G(b,c,d) _mm_or_si128(_mm_and_si128(b,d), _mm_andnot_si128(d,c))
+#define __M_MD5_X4_H(b,c,d) _mm_xor_si128(_mm_xor_si128(b,c),d)
+#define __M_MD5_X4_I(b,c,d) _mm_xor_si128(c, _mm_or_si128(b, _mm_xor_si128(d, ones)))
+#define __M_MD5_X4_STEP(F,a,b,c,d,x,S,T) \
+    a = _mm_add_epi32(a, _mm_add_epi32(_mm_add_epi32(F(b,c,d), x), _mm_set1_epi32((mln_s32_t)(T)))); \
+    a = _mm_or_si128(_mm_slli_epi32(a, S), _mm_srli_epi32(a, 32-(S))); \
+    a = _mm_add_epi32(a, b)
+
+static inline mln_u32_t mln_md5_load32(const mln_u8_t *p)
+{
+    mln_u32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void mln_md5_compress_x4(__m128i st[4], const mln_u8_t *blocks[4])
+{
+    const __m128i ones = _mm_set1_epi32(-1);
+    __m128i x[16];
+    __m128i a = st[0], b = st[1], c = st[2], d = st[3];
+    int j;
+
+    for (j = 0; j < 16; ++j) {
+        x[j] = _mm_set_epi32((mln_s32_t)mln_md5_load32(blocks[3] + (j << 2)), \
+                             (mln_s32_t)mln_md5_load32(blocks[2] + (j << 2)), \
+                             (mln_s32_t)mln_md5_load32(blocks[1] + (j << 2)), \
+                             (mln_s32_t)mln_md5_load32(blocks[0] + (j << 2)));
+    }
+
+    __M_MD5_X4_STEP(__M_MD5_X4_F, a, b, c, d, x[0], 7, ti[0][0]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, d, a, b, c, x[1], 12, ti[0][1]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, c, d, a, b, x[2], 17, ti[0][2]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, b, c, d, a, x[3], 22, ti[0][3]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, a, b, c, d, x[4], 7, ti[0][4]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, d, a, b, c, x[5], 12, ti[0][5]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, c, d, a, b, x[6], 17, ti[0][6]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, b, c, d, a, x[7], 22, ti[0][7]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, a, b, c, d, x[8], 7, ti[0][8]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, d, a, b, c, x[9], 12, ti[0][9]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, c, d, a, b, x[10], 17, ti[0][10]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, b, c, d, a, x[11], 22, ti[0][11]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, a, b, c, d, x[12], 7, ti[0][12]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, d, a, b, c, x[13], 12, ti[0][13]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, c, d, a, b, x[14], 17, ti[0][14]);
+    __M_MD5_X4_STEP(__M_MD5_X4_F, b, c, d, a, x[15], 22, ti[0][15]);
+
+    __M_MD5_X4_STEP(__M_MD5_X4_G, a, b, c, d, x[1], 5, ti[1][0]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, d, a, b, c, x[6], 9, ti[1][1]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, c, d, a, b, x[11], 14, ti[1][2]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, b, c, d, a, x[0], 20, ti[1][3]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, a, b, c, d, x[5], 5, ti[1][4]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, d, a, b, c, x[10], 9, ti[1][5]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, c, d, a, b, x[15], 14, ti[1][6]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, b, c, d, a, x[4], 20, ti[1][7]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, a, b, c, d, x[9], 5, ti[1][8]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, d, a, b, c, x[14], 9, ti[1][9]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, c, d, a, b, x[3], 14, ti[1][10]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, b, c, d, a, x[8], 20, ti[1][11]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, a, b, c, d, x[13], 5, ti[1][12]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, d, a, b, c, x[2], 9, ti[1][13]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, c, d, a, b, x[7], 14, ti[1][14]);
+    __M_MD5_X4_STEP(__M_MD5_X4_G, b, c, d, a, x[12], 20, ti[1][15]);
+
+    __M_MD5_X4_STEP(__M_MD5_X4_H, a, b, c, d, x[5], 4, ti[2][0]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, d, a, b, c, x[8], 11, ti[2][1]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, c, d, a, b, x[11], 16, ti[2][2]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, b, c, d, a, x[14], 23, ti[2][3]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, a, b, c, d, x[1], 4, ti[2][4]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, d, a, b, c, x[4], 11, ti[2][5]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, c, d, a, b, x[7], 16, ti[2][6]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, b, c, d, a, x[10], 23, ti[2][7]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, a, b, c, d, x[13], 4, ti[2][8]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, d, a, b, c, x[0], 11, ti[2][9]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, c, d, a, b, x[3], 16, ti[2][10]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, b, c, d, a, x[6], 23, ti[2][11]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, a, b, c, d, x[9], 4, ti[2][12]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, d, a, b, c, x[12], 11, ti[2][13]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, c, d, a, b, x[15], 16, ti[2][14]);
+    __M_MD5_X4_STEP(__M_MD5_X4_H, b, c, d, a, x[2], 23, ti[2][15]);
+
+    __M_MD5_X4_STEP(__M_MD5_X4_I, a, b, c, d, x[0], 6, ti[3][0]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, d, a, b, c, x[7], 10, ti[3][1]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, c, d, a, b, x[14], 15, ti[3][2]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, b, c, d, a, x[5], 21, ti[3][3]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, a, b, c, d, x[12], 6, ti[3][4]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, d, a, b, c, x[3], 10, ti[3][5]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, c, d, a, b, x[10], 15, ti[3][6]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, b, c, d, a, x[1], 21, ti[3][7]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, a, b, c, d, x[8], 6, ti[3][8]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, d, a, b, c, x[15], 10, ti[3][9]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, c, d, a, b, x[6], 15, ti[3][10]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, b, c, d, a, x[13], 21, ti[3][11]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, a, b, c, d, x[4], 6, ti[3][12]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, d, a, b, c, x[11], 10, ti[3][13]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, c, d, a, b, x[2], 15, ti[3][14]);
+    __M_MD5_X4_STEP(__M_MD5_X4_I, b, c, d, a, x[9], 21, ti[3][15]);
+
+    st[0] = _mm_add_epi32(st[0], a);
+    st[1] = _mm_add_epi32(st[1], b);
+    st[2] = _mm_add_epi32(st[2], c);
+    st[3] = _mm_add_epi32(st[3], d);
+}
+#endif
+
+void mln_md5_batch(mln_u8ptr_t *inputs, mln_uauto_t *lens, mln_u8ptr_t *digests, mln_size_t n)
+{
+    mln_md5_t m;
+    mln_size_t i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        mln_uauto_t k, blocks = lens[i] >> 6;
+        const mln_u8_t *blks[4];
+        union { __m128i v; mln_u32_t u[4]; } lane[4];
+        __m128i st[4];
+        int l;
+
+        for (l = 1; l < 4; ++l) {
+            if ((lens[i+l] >> 6) < blocks) blocks = lens[i+l] >> 6;
+        }
+        st[0] = _mm_set1_epi32((mln_s32_t)0x67452301);
+        st[1] = _mm_set1_epi32((mln_s32_t)0xefcdab89);
+        st[2] = _mm_set1_epi32((mln_s32_t)0x98badcfe);
+        st[3] = _mm_set1_epi32((mln_s32_t)0x10325476);
+        for (k = 0; k < blocks; ++k) {
+            for (l = 0; l < 4; ++l) blks[l] = inputs[i+l] + (k << 6);
+            mln_md5_compress_x4(st, blks);
+        }
+        for (l = 0; l < 4; ++l) lane[l].v = st[l];
+        for (l = 0; l < 4; ++l) {
+            m.A = lane[0].u[l];
+            m.B = lane[1].u[l];
+            m.C = lane[2].u[l];
+            m.D = lane[3].u[l];
+            m.length = blocks << 6;
+            m.pos = 0;
+            mln_md5_calc(&m, inputs[i+l] + (blocks << 6), lens[i+l] - (blocks << 6), 1);
+            mln_md5_tobytes(&m, digests[i+l], 16);
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        mln_md5_init(&m);
+        mln_md5_calc(&m, inputs[i], lens[i], 1);
+        mln_md5_tobytes(&m, digests[i], 16);
+    }
+}
@@ -0,0 +1,245 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "mln_ohash.h"
+
+#define M_OHASH_MIN_LEN 8
+
+static inline int mln_ohash_expand(mln_ohash_t *h) __NONNULL1(1);
+static inline void
+mln_ohash_place(mln_ohash_slot_t *slots, mln_u64_t mask, mln_u64_t hash, void *key, void *val);
+static inline mln_ohash_slot_t *
+mln_ohash_lookup(mln_ohash_t *h, void *key) __NONNULL2(1,2);
+static inline void
+mln_ohash_kv_free(mln_ohash_t *h, mln_ohash_slot_t *slot, mln_hash_flag_t flg) __NONNULL2(1,2);
+
+mln_ohash_t *mln_ohash_new(struct mln_ohash_attr *attr)
+{
+    mln_ohash_t *h;
+    mln_u64_t len;
+
+    if (attr->hash == NULL || attr->cmp == NULL) return NULL;
+    for (len = M_OHASH_MIN_LEN; len < attr->len_base; len <<= 1)
+        ;
+    if (attr->pool != NULL) {
+        h = (mln_ohash_t *)attr->pool_alloc(attr->pool, sizeof(mln_ohash_t));
+    } else {
+        h = (mln_ohash_t *)malloc(sizeof(mln_ohash_t));
+    }
+    if (h == NULL) return NULL;
+    h->pool = attr->pool;
+    h->pool_alloc = attr->pool_alloc;
+    h->pool_free = attr->pool_free;
+    h->hash = attr->hash;
+    h->cmp = attr->cmp;
+    h->free_key = attr->free_key;
+    h->free_val = attr->free_val;
+    if (h->pool != NULL) {
+        h->slots = (mln_ohash_slot_t *)h->pool_alloc(h->pool, len*sizeof(mln_ohash_slot_t));
+        if (h->slots != NULL) memset(h->slots, 0, len*sizeof(mln_ohash_slot_t));
+    } else {
+        h->slots = (mln_ohash_slot_t *)calloc(len, sizeof(mln_ohash_slot_t));
+    }
+    if (h->slots == NULL) {
+        if (h->pool != NULL) h->pool_free(h);
+        else free(h);
+        return NULL;
+    }
+    h->mask = len - 1;
+    h->nr_nodes = 0;
+    return h;
+}
+
+void mln_ohash_free(mln_ohash_t *h, mln_hash_flag_t flg)
+{
+    mln_ohash_slot_t *slot, *end = h->slots + h->mask + 1;
+    for (slot = h->slots; slot < end; ++slot) {
+        if (slot->key != NULL) mln_ohash_kv_free(h, slot, flg);
+    }
+    if (h->pool != NULL) {
+        h->pool_free(h->slots);
+        h->pool_free(h);
+    } else {
+        free(h->slots);
+        free(h);
+    }
+}
+
+/*
+ * Robin-hood placement: a probing pair that is closer to its home slot
+ * than the carried one gets displaced and the carried pair continues
+ * from there, which bounds the variance of probe lengths.
+ */
+static inline void
+mln_ohash_place(mln_ohash_slot_t *slots, mln_u64_t mask, mln_u64_t hash, void *key, void *val)
+{
+    mln_u64_t idx = hash & mask, dist = 0, cur;
+    mln_ohash_slot_t *slot, tmp;
+
+    for (;;) {
+        slot = &slots[idx];
+        if (slot->key == NULL) {
+            slot->hash = hash;
+            slot->key = key;
+            slot->val = val;
+            return;
+        }
+        cur = (idx - (slot->hash & mask)) & mask;
+        if (cur < dist) {
+            tmp = *slot;
+            slot->hash = hash;
+            slot->key = key;
+            slot->val = val;
+            hash = tmp.hash;
+            key = tmp.key;
+            val = tmp.val;
+            dist = cur;
+        }
+        idx = (idx + 1) & mask;
+        ++dist;
+    }
+}
+
+static inline int mln_ohash_expand(mln_ohash_t *h)
+{
+    mln_u64_t len = (h->mask + 1) << 1;
+    mln_ohash_slot_t *slots, *slot, *end;
+
+    if (h->pool != NULL) {
+        slots = (mln_ohash_slot_t *)h->pool_alloc(h->pool, len*sizeof(mln_ohash_slot_t));
+        if (slots != NULL) memset(slots, 0, len*sizeof(mln_ohash_slot_t));
+    } else {
+        slots = (mln_ohash_slot_t *)calloc(len, sizeof(mln_ohash_slot_t));
+    }
+    if (slots == NULL) return -1;
+    end = h->slots + h->mask + 1;
+    for (slot = h->slots; slot < end; ++slot) {
+        if (slot->key != NULL)
+            mln_ohash_place(slots, len - 1, slot->hash, slot->key, slot->val);
+    }
+    if (h->pool != NULL) h->pool_free(h->slots);
+    else free(h->slots);
+    h->slots = slots;
+    h->mask = len - 1;
+    return 0;
+}
+
+int mln_ohash_insert(mln_ohash_t *h, void *key, void *val)
+{
+    /*keep the load below 7/8 so probe sequences stay short*/
+    if (h->nr_nodes + 1 > h->mask + 1 - ((h->mask + 1) >> 3)) {
+        if (mln_ohash_expand(h) < 0) return -1;
+    }
+    mln_ohash_place(h->slots, h->mask, h->hash(h, key), key, val);
+    ++(h->nr_nodes);
+    return 0;
+}
+
+static inline mln_ohash_slot_t *
+mln_ohash_lookup(mln_ohash_t *h, void *key)
+{
+    mln_u64_t hash = h->hash(h, key);
+    mln_u64_t idx = hash & h->mask, dist = 0;
+    mln_ohash_slot_t *slot;
+
+    for (;;) {
+        slot = &(h->slots[idx]);
+        if (slot->key == NULL) return NULL;
+        if (slot->hash == hash && h->cmp(h, key, slot->key)) return slot;
+        /*every resident here is closer to home than us, the key is absent*/
+        if (((idx - (slot->hash & h->mask)) & h->mask) < dist) return NULL;
+        idx = (idx + 1) & h->mask;
+        ++dist;
+    }
+}
+
+void *mln_ohash_search(mln_ohash_t *h, void *key)
+{
+    mln_ohash_slot_t *slot = mln_ohash_lookup(h, key);
+    return slot == NULL? NULL: slot->val;
+}
+
+int mln_ohash_key_exist(mln_ohash_t *h, void *key)
+{
+    return mln_ohash_lookup(h, key) == NULL? 0: 1;
+}
+
+void *mln_ohash_change_value(mln_ohash_t *h, void *key, void *new_value)
+{
+    void *retval;
+    mln_ohash_slot_t *slot = mln_ohash_lookup(h, key);
+    if (slot == NULL) return NULL;
+    retval = slot->val;
+    slot->val = new_value;
+    return retval;
+}
+
+void mln_ohash_remove(mln_ohash_t *h, void *key, mln_hash_flag_t flg)
+{
+    mln_u64_t idx, next;
+    mln_ohash_slot_t *slot = mln_ohash_lookup(h, key), *nslot;
+
+    if (slot == NULL) return;
+    mln_ohash_kv_free(h, slot, flg);
+    /*backward-shift deletion keeps probe sequences tombstone-free*/
+    idx = slot - h->slots;
+    for (;;) {
+        next = (idx + 1) & h->mask;
+        nslot = &(h->slots[next]);
+        if (nslot->key == NULL || ((next - (nslot->hash & h->mask)) & h->mask) == 0)
+            break;
+        h->slots[idx] = *nslot;
+        idx = next;
+    }
+    h->slots[idx].key = NULL;
+    --(h->nr_nodes);
+}
+
+int mln_ohash_iterate(mln_ohash_t *h, ohash_iterate_handler handler, void *udata)
+{
+    mln_ohash_slot_t *slot, *end = h->slots + h->mask + 1;
+    for (slot = h->slots; slot < end; ++slot) {
+        if (slot->key == NULL) continue;
+        if (handler != NULL && handler(slot->key, slot->val, udata) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+void mln_ohash_reset(mln_ohash_t *h, mln_hash_flag_t flg)
+{
+    mln_ohash_slot_t *slot, *end = h->slots + h->mask + 1;
+    for (slot = h->slots; slot < end; ++slot) {
+        if (slot->key == NULL) continue;
+        mln_ohash_kv_free(h, slot, flg);
+        slot->key = NULL;
+    }
+    h->nr_nodes = 0;
+}
+
+static inline void
+mln_ohash_kv_free(mln_ohash_t *h, mln_ohash_slot_t *slot, mln_hash_flag_t flg)
+{
+    switch (flg) {
+        case M_HASH_F_VAL:
+            if (h->free_val != NULL)
+                h->free_val(slot->val);
+            break;
+        case M_HASH_F_KEY:
+            if (h->free_key != NULL)
+                h->free_key(slot->key);
+            break;
+        case M_HASH_F_KV:
+            if (h->free_val != NULL)
+                h->free_val(slot->val);
+            if (h->free_key != NULL)
+                h->free_key(slot->key);
+            break;
+        default: break;
+    }
+}
+
@@ -4,6 +4,14 @@
  */
 
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#if !defined(WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 #include "mln_parser_generator.h"
 
 /*
@@ -903,3 +911,155 @@ mln_pg_output_state_iterate_handler(mln_rbtree_node_t *node, void *udata)
     return 0;
 }
 
+
+
+/*
+ * Serialized shift table cache.
+ * The blob layout is a fixed header followed by nr_state rows of
+ * nr_col mln_shift_t entries. The header pins down everything the
+ * loader must agree on: format version, row element size and the
+ * grammar hash the tables were generated from.
+ */
+typedef struct {
+    mln_u32_t                 magic;
+    mln_u32_t                 version;
+    mln_u64_t                 hash;
+    mln_u64_t                 nr_state;
+    mln_u32_t                 nr_col;
+    mln_u32_t                 shift_size;
+    mln_s32_t                 type_val;
+    mln_u32_t                 padding;
+} mln_pg_cache_header_t;
+
+mln_u64_t mln_pg_grammar_hash(mln_production_t *prod_tbl, mln_u32_t nr_prod)
+{
+    /*FNV-1a over every production string, with a separator per rule*/
+    mln_u64_t h = 0xcbf29ce484222325ULL;
+    mln_u32_t i;
+    char *p;
+
+    for (i = 0; i < nr_prod; ++i) {
+        for (p = prod_tbl[i].production; *p != 0; ++p) {
+            h ^= (mln_u8_t)(*p);
+            h *= 0x100000001b3ULL;
+        }
+        h ^= 0xff;
+        h *= 0x100000001b3ULL;
+    }
+    h ^= nr_prod;
+    h *= 0x100000001b3ULL;
+    return h;
+}
+
+int mln_pg_shift_tbl_dump(mln_pg_shift_tbl_t *tbl, mln_u64_t hash, const char *path)
+{
+#if defined(WIN32)
+    return -1;
+#else
+    mln_pg_cache_header_t hdr;
+    char tmp[1024];
+    int fd;
+    mln_sauto_t i;
+    ssize_t row_size;
+
+    if (tbl == NULL || path == NULL || tbl->map != NULL) return -1;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = M_PG_CACHE_MAGIC;
+    hdr.version = M_PG_CACHE_VERSION;
+    hdr.hash = hash;
+    hdr.nr_state = (mln_u64_t)tbl->nr_state;
+    hdr.nr_col = tbl->nr_col;
+    hdr.shift_size = (mln_u32_t)sizeof(mln_shift_t);
+    hdr.type_val = tbl->type_val;
+
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    if ((fd = open(tmp, O_WRONLY|O_CREAT|O_TRUNC, 0644)) < 0) return -1;
+    if (write(fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr)) goto err;
+    row_size = (ssize_t)(tbl->nr_col * sizeof(mln_shift_t));
+    if (tbl->flat != NULL) {
+        if (write(fd, tbl->flat, row_size * tbl->nr_state) != row_size * tbl->nr_state) goto err;
+    } else for (i = 0; i < tbl->nr_state; ++i) {
+        if (write(fd, tbl->tbl[i], row_size) != row_size) goto err;
+    }
+    close(fd);
+    if (rename(tmp, path) < 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+err:
+    close(fd);
+    unlink(tmp);
+    return -1;
+#endif
+}
+
+mln_pg_shift_tbl_t *mln_pg_shift_tbl_load(mln_u64_t hash, const char *path)
+{
+#if defined(WIN32)
+    return NULL;
+#else
+    int fd;
+    struct stat st;
+    void *map;
+    mln_u8ptr_t base;
+    mln_pg_cache_header_t *hdr;
+    mln_pg_shift_tbl_t *tbl;
+    mln_u64_t i, expect;
+
+    if (path == NULL) return NULL;
+    if ((fd = open(path, O_RDONLY)) < 0) return NULL;
+    if (fstat(fd, &st) < 0 || (mln_size_t)st.st_size < sizeof(mln_pg_cache_header_t)) {
+        close(fd);
+        return NULL;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    hdr = (mln_pg_cache_header_t *)map;
+    expect = sizeof(mln_pg_cache_header_t) + \
+             hdr->nr_state * (mln_u64_t)hdr->nr_col * sizeof(mln_shift_t);
+    if (hdr->magic != M_PG_CACHE_MAGIC || \
+        hdr->version != M_PG_CACHE_VERSION || \
+        hdr->shift_size != (mln_u32_t)sizeof(mln_shift_t) || \
+        hdr->hash != hash || \
+        (mln_u64_t)st.st_size != expect)
+    {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    if ((tbl = (mln_pg_shift_tbl_t *)malloc(sizeof(mln_pg_shift_tbl_t))) == NULL) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    if ((tbl->tbl = (mln_shift_t **)malloc(hdr->nr_state * sizeof(mln_shift_t *))) == NULL) {
+        free(tbl);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    base = (mln_u8ptr_t)map + sizeof(mln_pg_cache_header_t);
+    for (i = 0; i < hdr->nr_state; ++i) {
+        tbl->tbl[i] = (mln_shift_t *)(base + i * (mln_u64_t)hdr->nr_col * sizeof(mln_shift_t));
+    }
+    tbl->flat = (mln_shift_t *)base;/*the blob is one dense block already*/
+    tbl->nr_state = (mln_sauto_t)hdr->nr_state;
+    tbl->type_val = hdr->type_val;
+    tbl->nr_col = hdr->nr_col;
+    tbl->map = map;
+    tbl->map_size = (mln_size_t)st.st_size;
+    return tbl;
+#endif
+}
+
+void mln_pg_shift_tbl_cache_free(mln_pg_shift_tbl_t *tbl)
+{
+    if (tbl == NULL || tbl->map == NULL) return;
+#if !defined(WIN32)
+    munmap(tbl->map, tbl->map_size);
+#endif
+    if (tbl->tbl != NULL) free(tbl->tbl);
+    free(tbl);
+}
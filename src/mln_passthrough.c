@@ -0,0 +1,303 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /*for splice and F_SETPIPE_SZ*/
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#if !defined(WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "mln_passthrough.h"
+
+/*per-splice ceiling; also the pipe size requested at setup*/
+#define M_PASSTHROUGH_SPLICE_MAX (1024*1024)
+
+static void mln_passthrough_recv_handler(mln_event_t *ev, int fd, void *data);
+static void mln_passthrough_send_handler(mln_event_t *ev, int fd, void *data);
+static int mln_passthrough_pump(mln_passthrough_t *pt);
+static int mln_passthrough_flush(mln_passthrough_t *pt);
+static void mln_passthrough_relink(mln_passthrough_t *pt);
+static int mln_passthrough_pipe_drain(mln_passthrough_t *pt);
+static void mln_passthrough_pipe_close(mln_passthrough_t *pt);
+static void mln_passthrough_finish(mln_passthrough_t *pt, int reason);
+
+mln_passthrough_t *
+mln_passthrough_new(mln_event_t *ev, \
+                    mln_tcp_conn_t *src, \
+                    mln_tcp_conn_t *dst, \
+                    mln_passthrough_done_t done, \
+                    void *data)
+{
+    mln_passthrough_t *pt;
+
+    if ((pt = (mln_passthrough_t *)malloc(sizeof(mln_passthrough_t))) == NULL)
+        return NULL;
+    pt->ev = ev;
+    pt->src = src;
+    pt->dst = dst;
+    pt->done = done;
+    pt->data = data;
+    pt->forwarded = 0;
+    pt->piped = 0;
+    pt->pipefds[0] = pt->pipefds[1] = -1;
+    pt->eof = 0;
+    pt->paused = 0;
+    pt->finished = 0;
+#if defined(__linux__)
+    /*
+     * The kernel path is set up optimistically; the first splice that
+     * fails with EINVAL (kTLS socket, non-socket fd, ...) tears it down
+     * and the chain-relink path takes over for the rest of the session.
+     */
+    if (pipe2(pt->pipefds, O_NONBLOCK | O_CLOEXEC) < 0) {
+        pt->pipefds[0] = pt->pipefds[1] = -1;
+    } else {
+        (void)fcntl(pt->pipefds[1], F_SETPIPE_SZ, M_PASSTHROUGH_SPLICE_MAX);
+    }
+#endif
+    /*bytes a protocol parser already pulled off 'src' go first*/
+    mln_passthrough_relink(pt);
+    if (mln_passthrough_flush(pt) < 0) {
+        mln_passthrough_pipe_close(pt);
+        free(pt);
+        return NULL;
+    }
+    if (pt->paused) {
+        if (mln_event_fd_set(ev, mln_tcp_conn_fd_get(dst), \
+                             M_EV_SEND|M_EV_NONBLOCK, M_EV_UNLIMITED, \
+                             pt, mln_passthrough_send_handler) < 0)
+        {
+            mln_passthrough_pipe_close(pt);
+            free(pt);
+            return NULL;
+        }
+    } else if (mln_event_fd_set(ev, mln_tcp_conn_fd_get(src), \
+                                M_EV_RECV|M_EV_NONBLOCK, M_EV_UNLIMITED, \
+                                pt, mln_passthrough_recv_handler) < 0)
+    {
+        mln_passthrough_pipe_close(pt);
+        free(pt);
+        return NULL;
+    }
+    return pt;
+}
+
+void mln_passthrough_free(mln_passthrough_t *pt)
+{
+    if (pt == NULL) return;
+    if (!pt->finished) {
+        mln_event_fd_set(pt->ev, mln_tcp_conn_fd_get(pt->src), M_EV_CLR, M_EV_UNLIMITED, NULL, NULL);
+        mln_event_fd_set(pt->ev, mln_tcp_conn_fd_get(pt->dst), M_EV_CLR, M_EV_UNLIMITED, NULL, NULL);
+    }
+    mln_passthrough_pipe_close(pt);
+    free(pt);
+}
+
+static void mln_passthrough_pipe_close(mln_passthrough_t *pt)
+{
+#if !defined(WIN32)
+    if (pt->pipefds[0] >= 0) {
+        close(pt->pipefds[0]);
+        close(pt->pipefds[1]);
+    }
+#endif
+    pt->pipefds[0] = pt->pipefds[1] = -1;
+}
+
+/*
+ * Move everything on the source's receive chain onto the destination's
+ * send chain. Pure pointer surgery: the descriptors and their payload
+ * keep living in the source connection's pool.
+ */
+static void mln_passthrough_relink(mln_passthrough_t *pt)
+{
+    mln_chain_t *head, *tail, *c;
+
+    if ((tail = mln_tcp_conn_tail(pt->src, M_C_RECV)) == NULL)
+        return;
+    head = mln_tcp_conn_remove(pt->src, M_C_RECV);
+    for (c = head; c != NULL; c = c->next) {
+        pt->forwarded += mln_buf_size(c->buf);
+    }
+    mln_tcp_conn_append_chain(pt->dst, head, tail, M_C_SEND);
+}
+
+/*
+ * Push pending bytes (kernel pipe first, then the send chain) towards
+ * the destination and recompute the backpressure state.
+ */
+static int mln_passthrough_flush(mln_passthrough_t *pt)
+{
+#if defined(__linux__)
+    while (pt->piped) {
+        ssize_t n = splice(pt->pipefds[0], NULL, mln_tcp_conn_fd_get(pt->dst), NULL, \
+                           pt->piped, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            pt->piped -= n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) break;
+        if (n < 0 && errno == EINVAL) {
+            /*destination refuses splice: lift the bytes out and fall back*/
+            if (mln_passthrough_pipe_drain(pt) < 0) return -1;
+            break;
+        }
+        return -1;
+    }
+#endif
+    if (!mln_tcp_conn_send_empty(pt->dst)) {
+        int rc = mln_tcp_conn_send(pt->dst);
+        mln_chain_pool_release_all(mln_tcp_conn_remove(pt->dst, M_C_SENT));
+        if (rc == M_C_ERROR) return -1;
+    }
+    pt->paused = (pt->piped != 0 || !mln_tcp_conn_send_empty(pt->dst));
+    return 0;
+}
+
+/*
+ * Lift bytes stuck in the pipe into pool buffers on the destination's
+ * send chain and retire the kernel path. Only taken when the outbound
+ * side rejects splice after the inbound side accepted it.
+ */
+static int mln_passthrough_pipe_drain(mln_passthrough_t *pt)
+{
+#if defined(__linux__)
+    mln_alloc_t *pool = mln_tcp_conn_pool_get(pt->dst);
+    mln_chain_t *c;
+    mln_buf_t *b;
+    mln_u8ptr_t buf;
+    ssize_t n;
+
+    while (pt->piped) {
+        if ((buf = (mln_u8ptr_t)mln_alloc_m(pool, pt->piped)) == NULL)
+            return -1;
+        n = read(pt->pipefds[0], buf, pt->piped);
+        if (n <= 0) {
+            mln_alloc_free(buf);
+            if (n < 0 && errno == EINTR) continue;
+            return -1;
+        }
+        if ((c = mln_chain_new(pool)) == NULL || (b = mln_buf_new(pool)) == NULL) {
+            mln_alloc_free(buf);
+            return -1;
+        }
+        c->buf = b;
+        b->left_pos = b->pos = b->start = buf;
+        b->last = b->end = buf + n;
+        b->in_memory = 1;
+        b->last_buf = 1;
+        mln_tcp_conn_append(pt->dst, c, M_C_SEND);
+        pt->piped -= n;
+    }
+#endif
+    mln_passthrough_pipe_close(pt);
+    return 0;
+}
+
+/*
+ * Drain the source socket. The splice path moves bytes into the pipe
+ * and flushes them onward without touching userspace; the chain path
+ * receives into the source's pool and relinks. Either way the loop
+ * stops on EAGAIN, EOF or backpressure.
+ */
+static int mln_passthrough_pump(mln_passthrough_t *pt)
+{
+#if defined(__linux__)
+    while (pt->pipefds[0] >= 0) {
+        ssize_t n = splice(mln_tcp_conn_fd_get(pt->src), NULL, pt->pipefds[1], NULL, \
+                           M_PASSTHROUGH_SPLICE_MAX, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            pt->piped += n;
+            pt->forwarded += n;
+            if (mln_passthrough_flush(pt) < 0) return -1;
+            if (pt->paused) return 0;
+            continue;
+        }
+        if (n == 0) {
+            pt->eof = 1;
+            return mln_passthrough_flush(pt);
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN) {
+            /*pipe full counts as backpressure, not as socket idle*/
+            if (pt->piped) {
+                if (mln_passthrough_flush(pt) < 0) return -1;
+                if (pt->paused) return 0;
+                continue;
+            }
+            return mln_passthrough_flush(pt);
+        }
+        if (errno == EINVAL || errno == ENOSYS) {
+            mln_passthrough_pipe_close(pt);
+            break; /*chain path from here on*/
+        }
+        return -1;
+    }
+#endif
+    {
+        int rc = mln_tcp_conn_recv(pt->src, M_C_TYPE_MEMORY);
+        mln_passthrough_relink(pt);
+        if (rc == M_C_ERROR) return -1;
+        if (rc == M_C_CLOSED) pt->eof = 1;
+    }
+    return mln_passthrough_flush(pt);
+}
+
+static void mln_passthrough_finish(mln_passthrough_t *pt, int reason)
+{
+    pt->finished = 1;
+    mln_event_fd_set(pt->ev, mln_tcp_conn_fd_get(pt->src), M_EV_CLR, M_EV_UNLIMITED, NULL, NULL);
+    mln_event_fd_set(pt->ev, mln_tcp_conn_fd_get(pt->dst), M_EV_CLR, M_EV_UNLIMITED, NULL, NULL);
+    if (pt->done != NULL) pt->done(pt, reason);
+}
+
+static void mln_passthrough_recv_handler(mln_event_t *ev, int fd, void *data)
+{
+    mln_passthrough_t *pt = (mln_passthrough_t *)data;
+
+    if (mln_passthrough_pump(pt) < 0) {
+        return mln_passthrough_finish(pt, M_C_ERROR);
+    }
+    if (pt->paused) {
+        /*stop pulling from the source until the destination drains*/
+        mln_event_fd_set(ev, fd, M_EV_CLR, M_EV_UNLIMITED, NULL, NULL);
+        if (mln_event_fd_set(ev, mln_tcp_conn_fd_get(pt->dst), \
+                             M_EV_SEND|M_EV_NONBLOCK, M_EV_UNLIMITED, \
+                             pt, mln_passthrough_send_handler) < 0)
+        {
+            return mln_passthrough_finish(pt, M_C_ERROR);
+        }
+        return;
+    }
+    if (pt->eof) {
+        return mln_passthrough_finish(pt, M_C_CLOSED);
+    }
+}
+
+static void mln_passthrough_send_handler(mln_event_t *ev, int fd, void *data)
+{
+    mln_passthrough_t *pt = (mln_passthrough_t *)data;
+
+    if (mln_passthrough_flush(pt) < 0) {
+        return mln_passthrough_finish(pt, M_C_ERROR);
+    }
+    if (pt->paused) return; /*still blocked, stay armed*/
+    mln_event_fd_set(ev, fd, M_EV_CLR, M_EV_UNLIMITED, NULL, NULL);
+    if (pt->eof) {
+        return mln_passthrough_finish(pt, M_C_CLOSED);
+    }
+    if (mln_event_fd_set(ev, mln_tcp_conn_fd_get(pt->src), \
+                         M_EV_RECV|M_EV_NONBLOCK, M_EV_UNLIMITED, \
+                         pt, mln_passthrough_recv_handler) < 0)
+    {
+        mln_passthrough_finish(pt, M_C_ERROR);
+    }
+}
+
@@ -0,0 +1,229 @@
+
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "mln_perf.h"
+#include "mln_trace.h"
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define M_PERF_NCOUNTER 4
+
+/*
+ * One counter context per instrumented thread, registered on the
+ * global list with the same lock-free push the fast trace rings use;
+ * everything past registration is thread-private. 'map' records which
+ * of the four requested counters actually opened -- a kernel may
+ * refuse e.g. cache misses inside a VM -- so the group read's value
+ * slots land in the right stat fields whatever subset survived.
+ */
+typedef struct mln_perf_thread_s {
+    int                       fds[M_PERF_NCOUNTER];
+    int                       map[M_PERF_NCOUNTER];
+    int                       n;
+    mln_u64_t                 begin[M_PERF_MAX_SECTION][M_PERF_NCOUNTER];
+    mln_perf_stat_t           stats[M_PERF_MAX_SECTION];
+    struct mln_perf_thread_s *next;
+} mln_perf_thread_t;
+
+mln_u32_t mln_perf_on = 0;
+
+static mln_perf_thread_t *perf_threads = NULL;
+static __thread mln_perf_thread_t *perf_thread_self = NULL;
+static mln_string_t *perf_sections[M_PERF_MAX_SECTION];
+static mln_u32_t perf_nsection = 0;
+static mln_u32_t perf_trace_base = 0;
+static pthread_mutex_t perf_section_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#if defined(__linux__)
+static const mln_u64_t perf_configs[M_PERF_NCOUNTER] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static int mln_perf_event_open(mln_u64_t config, int group_fd)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = group_fd < 0? 1: 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+#endif
+
+static mln_perf_thread_t *mln_perf_thread_new(void)
+{
+    mln_perf_thread_t *t, *head;
+#if defined(__linux__)
+    int i, fd;
+#endif
+
+    t = (mln_perf_thread_t *)calloc(1, sizeof(mln_perf_thread_t));
+    if (t == NULL) return NULL;
+#if defined(__linux__)
+    for (i = 0; i < M_PERF_NCOUNTER; ++i) {
+        fd = mln_perf_event_open(perf_configs[i], t->n? t->fds[0]: -1);
+        if (fd < 0) {
+            if (!i) break; /*no leader, no group*/
+            continue;
+        }
+        t->fds[t->n] = fd;
+        t->map[t->n] = i;
+        ++(t->n);
+    }
+    if (t->n) ioctl(t->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    do {
+        head = __atomic_load_n(&perf_threads, __ATOMIC_ACQUIRE);
+        t->next = head;
+    } while (!__atomic_compare_exchange_n(&perf_threads, &head, t, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    perf_thread_self = t;
+    return t;
+}
+
+static inline int mln_perf_group_read(mln_perf_thread_t *t, mln_u64_t *values)
+{
+#if defined(__linux__)
+    mln_u64_t buf[M_PERF_NCOUNTER + 1];
+
+    if (!t->n) return -1;
+    if (read(t->fds[0], buf, (t->n + 1) * sizeof(mln_u64_t)) < 0) return -1;
+    memcpy(values, buf + 1, t->n * sizeof(mln_u64_t));
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+int mln_perf_init(void)
+{
+    if (mln_perf_on) return -1;
+    mln_perf_on = 1;
+    return 0;
+}
+
+int mln_perf_section_register(char *name)
+{
+    mln_u32_t i, n;
+    int sid = -1;
+
+    pthread_mutex_lock(&perf_section_lock);
+    n = perf_nsection;
+    for (i = 0; i < n; ++i) {
+        if (!mln_string_const_strcmp(perf_sections[i], name)) {
+            pthread_mutex_unlock(&perf_section_lock);
+            return (int)i;
+        }
+    }
+    if (n < M_PERF_MAX_SECTION && (perf_sections[n] = mln_string_new(name)) != NULL) {
+        sid = (int)n;
+        __atomic_store_n(&perf_nsection, n + 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&perf_section_lock);
+    return sid;
+}
+
+mln_string_t *mln_perf_section_name(int sid)
+{
+    if (sid < 0 || (mln_u32_t)sid >= __atomic_load_n(&perf_nsection, __ATOMIC_ACQUIRE))
+        return NULL;
+    return perf_sections[sid];
+}
+
+void mln_perf_section_begin(int sid)
+{
+    mln_perf_thread_t *t;
+
+    if (sid < 0 || sid >= M_PERF_MAX_SECTION) return;
+    if ((t = perf_thread_self) == NULL && (t = mln_perf_thread_new()) == NULL)
+        return;
+    mln_perf_group_read(t, t->begin[sid]);
+}
+
+void mln_perf_section_end(int sid)
+{
+    mln_perf_thread_t *t;
+    mln_u64_t now[M_PERF_NCOUNTER], delta[M_PERF_NCOUNTER] = {0, 0, 0, 0};
+    mln_perf_stat_t *st;
+    int i;
+
+    if (sid < 0 || sid >= M_PERF_MAX_SECTION) return;
+    if ((t = perf_thread_self) == NULL) return;
+    if (mln_perf_group_read(t, now) < 0) return;
+    for (i = 0; i < t->n; ++i)
+        delta[t->map[i]] = now[i] - t->begin[sid][i];
+    st = &t->stats[sid];
+    ++(st->calls);
+    st->cycles += delta[0];
+    st->instructions += delta[1];
+    st->cache_misses += delta[2];
+    st->branch_misses += delta[3];
+    if (perf_trace_base)
+        mln_trace_fast(perf_trace_base + (mln_u32_t)sid, delta[0], delta[1], delta[2], delta[3]);
+}
+
+int mln_perf_stat(int sid, mln_perf_stat_t *st)
+{
+    mln_perf_thread_t *t;
+    mln_perf_stat_t *s;
+
+    if (sid < 0 || (mln_u32_t)sid >= __atomic_load_n(&perf_nsection, __ATOMIC_ACQUIRE))
+        return -1;
+    memset(st, 0, sizeof(mln_perf_stat_t));
+    for (t = __atomic_load_n(&perf_threads, __ATOMIC_ACQUIRE); t != NULL; t = t->next) {
+        s = &t->stats[sid];
+        st->calls += s->calls;
+        st->cycles += s->cycles;
+        st->instructions += s->instructions;
+        st->cache_misses += s->cache_misses;
+        st->branch_misses += s->branch_misses;
+    }
+    return 0;
+}
+
+void mln_perf_trace_base_set(mln_u32_t base)
+{
+    perf_trace_base = base;
+}
+
+void mln_perf_finalize(void)
+{
+    mln_perf_thread_t *t, *next;
+    mln_u32_t i;
+    int j;
+
+    mln_perf_on = 0;
+    for (t = perf_threads; t != NULL; t = next) {
+        next = t->next;
+#if defined(__linux__)
+        for (j = 0; j < t->n; ++j) close(t->fds[j]);
+#else
+        (void)j;
+#endif
+        free(t);
+    }
+    perf_threads = NULL;
+    perf_thread_self = NULL;
+    for (i = 0; i < perf_nsection; ++i) {
+        mln_string_free(perf_sections[i]);
+        perf_sections[i] = NULL;
+    }
+    perf_nsection = 0;
+    perf_trace_base = 0;
+}
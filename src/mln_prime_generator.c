@@ -3,90 +3,91 @@
  * Copyright (C) Niklaus F.Schen.
  */
 
-#include <stdio.h>
 #include <stdlib.h>
-#include <sys/time.h>
+#include <string.h>
 #include "mln_types.h"
 
-static inline mln_u32_t rand_scope(mln_u32_t low, mln_u32_t high);
-static inline void seperate(mln_u32_t num, mln_u32_t *pwr, mln_u32_t *odd);
-static inline mln_u64_t modular_expoinentiation(mln_u32_t base, mln_u32_t pwr, mln_u32_t n);
-static inline mln_u32_t witness(mln_u32_t base, mln_u32_t prim);
+/*
+ * Primes are located with a segmented sieve of Eratosthenes. The first
+ * call sieves all primes below 65536 (the square root of any 32-bit
+ * candidate) into a process-lifetime cache; later calls either answer
+ * directly from that cache or sieve one small odd-only segment starting
+ * at the query, crossing off multiples of the cached primes. Repeated
+ * queries -- hash table resizing in particular -- amortize to a binary
+ * search or a single segment scan.
+ */
+#define M_PRIME_SMALL_LIMIT 65536
+#define M_PRIME_SEG         4096 /*odd candidates per segment*/
 
-mln_u32_t mln_prime_generate(mln_u32_t n)
+static mln_u8_t small_bitmap[M_PRIME_SMALL_LIMIT >> 4];
+static mln_u32_t small_primes[6600];
+static mln_u32_t n_small = 0;
+
+static inline void mln_prime_bit_set(mln_u8_t *bitmap, mln_u32_t idx)
 {
-    if (n <= 2) return 2;
-    if (n >= 1073741824) return 1073741827;
-    mln_u32_t a, prim = n%2 ? n : n+1;
-    int s;
-    while (1) {
-        s = prim<=4 ? 1 : (prim - 1)>>2;
-        for(; s>=0; --s) {
-            a = rand_scope(n, prim);
-            if (witness(a, prim)) {
-                break;
-            }
-        }
-        if (s < 0) break;
-        prim += 2;
-    }
-    return prim;
+    bitmap[idx >> 3] |= (mln_u8_t)(1 << (idx & 7));
 }
 
-static inline mln_u32_t rand_scope(mln_u32_t low, mln_u32_t high)
+static inline int mln_prime_bit_isset(mln_u8_t *bitmap, mln_u32_t idx)
 {
-    struct timeval tv;
-    mln_u32_t r = 0;
-    while (!r) {
-        tv.tv_usec = tv.tv_sec = 0;
-        gettimeofday(&tv, NULL);
-        srand(tv.tv_sec*1000000+tv.tv_usec);
-        r = ((mln_u32_t)rand() + low) % high;
-    }
-    return r;
+    return bitmap[idx >> 3] & (1 << (idx & 7));
 }
 
-static inline void seperate(mln_u32_t num, mln_u32_t *pwr, mln_u32_t *odd)
+static void mln_prime_cache_init(void)
 {
-    *pwr = 0;
-    while (!(num % 2)) {
-        num >>= 1;
-        ++(*pwr);
+    mln_u32_t i, j;
+
+    small_primes[n_small++] = 2;
+    for (i = 3; i < M_PRIME_SMALL_LIMIT; i += 2) {
+        if (mln_prime_bit_isset(small_bitmap, i >> 1)) continue;
+        small_primes[n_small++] = i;
+        for (j = i * i; j < M_PRIME_SMALL_LIMIT; j += (i << 1))
+            mln_prime_bit_set(small_bitmap, j >> 1);
     }
-    *odd = num;
 }
 
-static inline mln_u64_t modular_expoinentiation(mln_u32_t base, mln_u32_t pwr, mln_u32_t n)
+mln_u32_t mln_prime_generate(mln_u32_t n)
 {
-    int i;
-    mln_u64_t d = 1;
-    for (i = sizeof(pwr)*8-1; i>=0; --i) {
-        d *= d;
-        d %= n;
-        if ((1<<i) & pwr) {
-            d *= base;
-            d %= n;
+    if (n <= 2) return 2;
+    if (n >= 1073741824) return 1073741827;
+
+    mln_u8_t seg[M_PRIME_SEG >> 3];
+    mln_u32_t k, p, lo, hi, mid;
+    mln_u64_t low, high, v, i;
+
+    if (!n_small) mln_prime_cache_init();
+
+    if (n <= small_primes[n_small - 1]) {
+        /*binary search the first cached prime >= n*/
+        for (lo = 0, hi = n_small - 1; lo < hi; ) {
+            mid = (lo + hi) >> 1;
+            if (small_primes[mid] < n)
+                lo = mid + 1;
+            else
+                hi = mid;
         }
+        return small_primes[lo];
     }
-    return d;
-}
 
-static inline mln_u32_t witness(mln_u32_t base, mln_u32_t prim)
-{
-    mln_u32_t pwr, odd;
-    seperate(prim - 1, &pwr, &odd);
-    mln_u64_t new_x = 0, x = modular_expoinentiation(base, odd, prim);
-    mln_u32_t i;
-    for (i = 0; i<pwr; ++i) {
-        new_x = (x * x) % prim;
-        if (new_x == 1 && x != 1 && x != prim-1) {
-            return 1;
+    for (low = n | 1; ; low = high) {
+        high = low + (M_PRIME_SEG << 1);
+        memset(seg, 0, sizeof(seg));
+        for (k = 1; k < n_small; ++k) {
+            p = small_primes[k];
+            v = (mln_u64_t)p * p;
+            if (v >= high) break;
+            if (v < low) {
+                v = (low + p - 1) / p * p;
+                if (!(v & 1)) v += p;
+            }
+            for (; v < high; v += (p << 1))
+                mln_prime_bit_set(seg, (mln_u32_t)((v - low) >> 1));
+        }
+        for (i = 0; i < M_PRIME_SEG; ++i) {
+            if (!mln_prime_bit_isset(seg, i))
+                return (mln_u32_t)(low + (i << 1));
         }
-        x = new_x;
-    }
-    if (new_x != 1) {
-        return 1;
     }
-    return 0;
+    /*not reached*/
+    return n;
 }
-
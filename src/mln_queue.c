@@ -17,12 +17,46 @@ mln_queue_t *mln_queue_init(struct mln_queue_attr *attr)
         return NULL;
     }
     q->head = q->tail = q->queue;
+    q->cells = NULL;
+    q->enq_pos = q->deq_pos = 0;
+    return q;
+}
+
+mln_queue_t *mln_queue_mpmc_init(struct mln_queue_attr *attr)
+{
+    mln_queue_t *q = (mln_queue_t *)malloc(sizeof(mln_queue_t));
+    mln_uauto_t len, i;
+
+    if (q == NULL) return NULL;
+    for (len = 2; len < attr->qlen; len <<= 1)
+        ;
+    q->qlen = len;
+    q->nr_element = 0;
+    q->free_handler = attr->free_handler;
+    q->queue = q->head = q->tail = NULL;
+    q->cells = (mln_queue_cell_t *)calloc(len, sizeof(mln_queue_cell_t));
+    if (q->cells == NULL) {
+        free(q);
+        return NULL;
+    }
+    for (i = 0; i < len; ++i) q->cells[i].seq = i;
+    q->enq_pos = q->deq_pos = 0;
     return q;
 }
 
 void mln_queue_destroy(mln_queue_t *q)
 {
     if (q == NULL) return;
+    if (q->cells != NULL) {
+        void *data;
+        if (q->free_handler != NULL) {
+            while (mln_queue_pop_mpmc(q, &data) == 0)
+                q->free_handler(data);
+        }
+        free(q->cells);
+        free(q);
+        return;
+    }
     if (q->free_handler != NULL) {
         while (q->nr_element) {
             q->free_handler(*(q->head));
@@ -106,3 +140,69 @@ void mln_queue_free_index(mln_queue_t *q, mln_uauto_t index)
         q->free_handler(save);
 }
 
+
+int mln_queue_push_mpmc(mln_queue_t *q, void *data)
+{
+    mln_queue_cell_t *cell;
+    mln_u64_t pos = __atomic_load_n(&(q->enq_pos), __ATOMIC_RELAXED);
+    mln_s64_t diff;
+
+    for (;;) {
+        cell = &(q->cells[pos & (q->qlen - 1)]);
+        diff = (mln_s64_t)__atomic_load_n(&(cell->seq), __ATOMIC_ACQUIRE) - (mln_s64_t)pos;
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&(q->enq_pos), &pos, pos + 1, 1, \
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if (diff < 0) {
+            return -1;
+        } else {
+            pos = __atomic_load_n(&(q->enq_pos), __ATOMIC_RELAXED);
+        }
+    }
+    cell->data = data;
+    __atomic_store_n(&(cell->seq), pos + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int mln_queue_pop_mpmc(mln_queue_t *q, void **data)
+{
+    mln_queue_cell_t *cell;
+    mln_u64_t pos = __atomic_load_n(&(q->deq_pos), __ATOMIC_RELAXED);
+    mln_s64_t diff;
+
+    for (;;) {
+        cell = &(q->cells[pos & (q->qlen - 1)]);
+        diff = (mln_s64_t)__atomic_load_n(&(cell->seq), __ATOMIC_ACQUIRE) - (mln_s64_t)(pos + 1);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&(q->deq_pos), &pos, pos + 1, 1, \
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if (diff < 0) {
+            return -1;
+        } else {
+            pos = __atomic_load_n(&(q->deq_pos), __ATOMIC_RELAXED);
+        }
+    }
+    *data = cell->data;
+    __atomic_store_n(&(cell->seq), pos + q->qlen, __ATOMIC_RELEASE);
+    return 0;
+}
+
+mln_uauto_t mln_queue_push_mpmc_batch(mln_queue_t *q, void **data, mln_uauto_t n)
+{
+    mln_uauto_t i;
+    for (i = 0; i < n; ++i) {
+        if (mln_queue_push_mpmc(q, data[i]) < 0) break;
+    }
+    return i;
+}
+
+mln_uauto_t mln_queue_pop_mpmc_batch(mln_queue_t *q, void **data, mln_uauto_t n)
+{
+    mln_uauto_t i;
+    for (i = 0; i < n; ++i) {
+        if (mln_queue_pop_mpmc(q, &data[i]) < 0) break;
+    }
+    return i;
+}
@@ -49,6 +49,8 @@ mln_rbtree_new(struct mln_rbtree_attr *attr)
     t->min = &(t->nil);
     t->head = t->tail = NULL;
     t->iter = NULL;
+    t->free_head = NULL;
+    t->free_count = 0;
     t->nr_node = 0;
     t->del = 0;
     return t;
@@ -97,6 +99,13 @@ mln_rbtree_node_new(mln_rbtree_t *t, void *data)
 {
     mln_rbtree_node_t *n;
 
+    if ((n = t->free_head) != NULL) {
+        t->free_head = n->next;
+        --(t->free_count);
+        n->data = data;
+        n->nofree = 0;
+        return n;
+    }
     if (t->pool == NULL)
         n = (mln_rbtree_node_t *)malloc(sizeof(mln_rbtree_node_t));
     else
@@ -236,6 +245,76 @@ mln_rbtree_min(mln_rbtree_t *t)
     return t->min;
 }
 
+/*bulk load*/
+static mln_rbtree_node_t *
+rbtree_bulk_build(mln_rbtree_t *t, void **datas, mln_uauto_t n, \
+                  mln_u32_t depth, mln_u32_t red_depth, mln_rbtree_node_t *parent, int *err)
+{
+    mln_uauto_t mid;
+    mln_rbtree_node_t *node;
+
+    if (n == 0 || *err) return &(t->nil);
+    mid = n >> 1;
+    node = mln_rbtree_node_new(t, datas[mid]);
+    if (node == NULL) {
+        *err = 1;
+        return &(t->nil);
+    }
+    node->parent = parent;
+    /*the deepest, possibly partial level is red, every other level black*/
+    node->color = depth == red_depth? M_RB_RED: M_RB_BLACK;
+    node->left = rbtree_bulk_build(t, datas, mid, depth+1, red_depth, node, err);
+    mln_rbtree_chain_add(&(t->head), &(t->tail), node);
+    node->right = rbtree_bulk_build(t, datas+mid+1, n-mid-1, depth+1, red_depth, node, err);
+    return node;
+}
+
+int mln_rbtree_bulk_load(mln_rbtree_t *t, void **datas, mln_uauto_t n)
+{
+    int err = 0;
+    mln_u32_t levels;
+    mln_uauto_t tmp;
+    mln_rbtree_node_t *fr;
+
+    if (t->root != &(t->nil) || n == 0) return -1;
+    for (levels = 0, tmp = n; tmp != 0; tmp >>= 1) ++levels;
+    t->root = rbtree_bulk_build(t, datas, n, 1, levels > 1? levels: 0, &(t->nil), &err);
+    if (err) {
+        /*release created nodes without touching the caller's data*/
+        while ((fr = t->tail) != NULL) {
+            mln_rbtree_chain_del(&(t->head), &(t->tail), fr);
+            if (t->pool != NULL) t->pool_free(fr);
+            else free(fr);
+        }
+        t->root = &(t->nil);
+        return -1;
+    }
+    t->min = rbtree_minimum(t, t->root);
+    t->nr_node = n;
+    return 0;
+}
+
+/*range iterate*/
+int mln_rbtree_range_iterate(mln_rbtree_t *t, void *low, void *high, rbtree_iterate_handler handler, void *udata)
+{
+    mln_rbtree_node_t *n = t->root, *start = &(t->nil), *next;
+
+    while (n != &(t->nil)) {
+        if (t->cmp(low, n->data) <= 0) {
+            start = n;
+            n = n->left;
+        } else {
+            n = n->right;
+        }
+    }
+    for (n = start; n != &(t->nil); n = next) {
+        if (t->cmp(high, n->data) < 0) break;
+        next = mln_rbtree_successor(t, n);
+        if (handler(n, udata) < 0) return -1;
+    }
+    return 0;
+}
+
 /*iterate*/
 int mln_rbtree_iterate(mln_rbtree_t *t, rbtree_iterate_handler handler, void *udata)
 {
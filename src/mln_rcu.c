@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "mln_rcu.h"
+#include "mln_defs.h"
+
+typedef struct {
+    void                        *ptr;
+    mln_u64_t                    epoch;
+} mln_rcu_retire_t;
+
+struct mln_rcu_s {
+    mln_alloc_t                 *pool;
+    mln_rcu_free_handler         free_handler;
+    void                        *cur;
+    mln_u64_t                    epoch; /*starts at 1 so slot 0 stays the quiescent mark*/
+    mln_u32_t                    lock;  /*writer side only*/
+    mln_rcu_retire_t             retired[M_RCU_RETIRE_MAX];
+    mln_u32_t                    nretired;
+    mln_rcu_reader_t             readers[M_RCU_READER_MAX];
+};
+
+mln_rcu_t *mln_rcu_new(mln_alloc_t *pool, mln_rcu_free_handler free_handler)
+{
+    mln_rcu_t *rcu;
+
+    rcu = (mln_rcu_t *)mln_alloc_m(pool, sizeof(mln_rcu_t));
+    if (rcu == NULL) return NULL;
+    memset(rcu, 0, sizeof(mln_rcu_t));
+    rcu->pool = pool;
+    rcu->free_handler = free_handler;
+    rcu->epoch = 1;
+    mln_spin_init(&rcu->lock);
+    return rcu;
+}
+
+static inline void mln_rcu_version_free(mln_rcu_t *rcu, void *version)
+{
+    if (version == NULL) return;
+    if (rcu->free_handler != NULL) rcu->free_handler(version);
+    else mln_alloc_free(version);
+}
+
+void mln_rcu_free(mln_rcu_t *rcu)
+{
+    mln_u32_t i;
+
+    if (rcu == NULL) return;
+    for (i = 0; i < rcu->nretired; ++i) {
+        mln_rcu_version_free(rcu, rcu->retired[i].ptr);
+    }
+    mln_rcu_version_free(rcu, rcu->cur);
+    mln_alloc_free(rcu);
+}
+
+mln_rcu_reader_t *mln_rcu_reader_register(mln_rcu_t *rcu)
+{
+    mln_rcu_reader_t *r, *end = rcu->readers + M_RCU_READER_MAX;
+    mln_u32_t expect;
+
+    for (r = rcu->readers; r < end; ++r) {
+        expect = 0;
+        if (__atomic_compare_exchange_n(&r->in_use, &expect, 1, 0, \
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        {
+            __atomic_store_n(&r->epoch, 0, __ATOMIC_RELEASE);
+            return r;
+        }
+    }
+    return NULL;
+}
+
+void mln_rcu_reader_unregister(mln_rcu_reader_t *reader)
+{
+    if (reader == NULL) return;
+    __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&reader->in_use, 0, __ATOMIC_RELEASE);
+}
+
+void *mln_rcu_read_lock(mln_rcu_t *rcu, mln_rcu_reader_t *reader)
+{
+    /*
+     * The slot store must be visible before the version pointer is
+     * loaded, or a concurrent publish could scan the slots between the
+     * two, find this reader quiescent and free the version it is about
+     * to pick up. The full fence here pairs with the one in publish;
+     * a slot stamped with a stale epoch only delays reclamation, it
+     * never permits it, so the epoch load needs no loop.
+     */
+    __atomic_store_n(&reader->epoch, \
+                     __atomic_load_n(&rcu->epoch, __ATOMIC_ACQUIRE), \
+                     __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return __atomic_load_n(&rcu->cur, __ATOMIC_ACQUIRE);
+}
+
+void mln_rcu_read_unlock(mln_rcu_reader_t *reader)
+{
+    __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+}
+
+/*
+ * Free every retired version older than the earliest epoch any active
+ * reader entered under. Caller holds the writer lock.
+ */
+static void mln_rcu_reclaim(mln_rcu_t *rcu)
+{
+    mln_rcu_reader_t *r, *end = rcu->readers + M_RCU_READER_MAX;
+    mln_u64_t e, min = (mln_u64_t)-1;
+    mln_u32_t i, keep = 0;
+
+    for (r = rcu->readers; r < end; ++r) {
+        if (!__atomic_load_n(&r->in_use, __ATOMIC_ACQUIRE)) continue;
+        e = __atomic_load_n(&r->epoch, __ATOMIC_ACQUIRE);
+        if (e != 0 && e < min) min = e;
+    }
+    for (i = 0; i < rcu->nretired; ++i) {
+        if (rcu->retired[i].epoch < min) {
+            mln_rcu_version_free(rcu, rcu->retired[i].ptr);
+        } else {
+            rcu->retired[keep++] = rcu->retired[i];
+        }
+    }
+    rcu->nretired = keep;
+}
+
+void mln_rcu_publish(mln_rcu_t *rcu, void *version)
+{
+    void *old;
+
+    mln_spin_lock(&rcu->lock);
+    old = __atomic_exchange_n(&rcu->cur, version, __ATOMIC_ACQ_REL);
+    if (old != NULL) {
+        /*
+         * A full retire ring means M_RCU_RETIRE_MAX versions are pinned
+         * by read sections; with sections forbidden from blocking this
+         * resolves in reader-section time.
+         */
+        while (rcu->nretired >= M_RCU_RETIRE_MAX) {
+            mln_rcu_reclaim(rcu);
+        }
+        rcu->retired[rcu->nretired].ptr = old;
+        rcu->retired[rcu->nretired].epoch = __atomic_load_n(&rcu->epoch, __ATOMIC_RELAXED);
+        ++(rcu->nretired);
+    }
+    __atomic_fetch_add(&rcu->epoch, 1, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    mln_rcu_reclaim(rcu);
+    mln_spin_unlock(&rcu->lock);
+}
+
+void *mln_rcu_current(mln_rcu_t *rcu)
+{
+    return __atomic_load_n(&rcu->cur, __ATOMIC_ACQUIRE);
+}
@@ -912,3 +912,511 @@ void mln_reg_match_result_free(mln_reg_match_t *results)
     mln_reg_match_chain_del(NULL, NULL, NULL);
 }
 
+/*compiled patterns*/
+#define M_REGEXP_DFA_MAX_ELEM   63
+#define M_REGEXP_DFA_MAX_STATE  128
+
+typedef struct {
+    mln_u8_t cls[32]; /*256-bit byte class membership*/
+    mln_u8_t quant;   /*0, '*', '+' or '?'*/
+} mln_reg_elem_t;
+
+static inline void *mln_reg_alloc(mln_alloc_t *pool, mln_size_t size)
+{
+    return pool == NULL? malloc(size): mln_alloc_m(pool, size);
+}
+
+static inline void mln_reg_dealloc(mln_alloc_t *pool, void *ptr)
+{
+    if (ptr == NULL) return;
+    if (pool == NULL) free(ptr);
+    else mln_alloc_free(ptr);
+}
+
+static inline void mln_reg_cls_set(mln_u8_t *cls, mln_u8_t c)
+{
+    cls[c >> 3] |= ((mln_u8_t)1 << (c & 0x7));
+}
+
+static inline int mln_reg_cls_test(mln_u8_t *cls, mln_u8_t c)
+{
+    return cls[c >> 3] & ((mln_u8_t)1 << (c & 0x7));
+}
+
+static int mln_reg_dfa_parse_class(char **regexp, int *reglen, mln_reg_elem_t *elem)
+{
+    char *p = *regexp;
+    int left = *reglen, c, len, lo, hi, reverse = 0, i;
+
+    len = mln_get_length(p, left);/*jump off '['*/
+    p += len;
+    left -= len;
+
+    c = mln_get_char(M_REGEXP_MASK_SQUARE, p, left);
+    if (c == M_REGEXP_XOR) {
+        reverse = 1;
+        len = mln_get_length(p, left);
+        p += len;
+        left -= len;
+    }
+
+    while (left > 0) {
+        c = mln_get_char(M_REGEXP_MASK_SQUARE, p, left);
+        len = mln_get_length(p, left);
+        if (c == M_REGEXP_RSQUAR) {
+            p += len;
+            left -= len;
+            if (reverse) {
+                for (i = 0; i < 32; ++i) elem->cls[i] = ~elem->cls[i];
+            }
+            *regexp = p;
+            *reglen = left;
+            return 0;
+        }
+        if (c >= 128) return -1;/*nested or special member*/
+        lo = (mln_u8_t)c;
+        p += len;
+        left -= len;
+        c = mln_get_char(M_REGEXP_MASK_SQUARE, p, left);
+        len = mln_get_length(p, left);
+        if (c == M_REGEXP_SUB && left > len) {
+            p += len;
+            left -= len;
+            c = mln_get_char(M_REGEXP_MASK_SQUARE, p, left);
+            len = mln_get_length(p, left);
+            if (c >= 128) return -1;
+            hi = (mln_u8_t)c;
+            if (lo > hi) return -1;
+            for (; lo <= hi; ++lo) mln_reg_cls_set(elem->cls, (mln_u8_t)lo);
+            p += len;
+            left -= len;
+        } else {
+            mln_reg_cls_set(elem->cls, (mln_u8_t)lo);
+        }
+    }
+    return -1;/*unterminated class*/
+}
+
+static int mln_reg_dfa_parse(mln_string_t *exp, mln_reg_elem_t *elems, mln_u32_t *nelem)
+{
+    char *p = (char *)(exp->data);
+    int left = exp->len, c, len, i;
+    mln_u32_t n = 0;
+    mln_reg_elem_t *elem;
+
+    c = mln_get_char(0, p, left);
+    if (c == M_REGEXP_XOR) {/*leading anchor, matching is anchored anyway*/
+        len = mln_get_length(p, left);
+        p += len;
+        left -= len;
+    }
+
+    while (left > 0) {
+        c = mln_get_char(0, p, left);
+        len = mln_get_length(p, left);
+        if (c == M_REGEXP_DOLL && left == len) break;/*trailing anchor*/
+        if (n >= M_REGEXP_DFA_MAX_ELEM) return -1;
+
+        elem = &elems[n];
+        memset(elem, 0, sizeof(*elem));
+        switch (c) {
+            case M_REGEXP_DOT:
+                memset(elem->cls, 0xff, sizeof(elem->cls));
+                break;
+            case M_REGEXP_NUM:
+                for (i = '0'; i <= '9'; ++i) mln_reg_cls_set(elem->cls, (mln_u8_t)i);
+                break;
+            case M_REGEXP_NOT_NUM:
+                memset(elem->cls, 0xff, sizeof(elem->cls));
+                for (i = '0'; i <= '9'; ++i) elem->cls[i >> 3] &= ~((mln_u8_t)1 << (i & 0x7));
+                break;
+            case M_REGEXP_ALPHA:
+                for (i = 'a'; i <= 'z'; ++i) mln_reg_cls_set(elem->cls, (mln_u8_t)i);
+                for (i = 'A'; i <= 'Z'; ++i) mln_reg_cls_set(elem->cls, (mln_u8_t)i);
+                break;
+            case M_REGEXP_LSQUAR:
+                if (mln_reg_dfa_parse_class(&p, &left, elem) < 0) return -1;
+                goto quant;
+            default:
+                if (c >= 128) return -1;/*group, alternation, brace, ...*/
+                mln_reg_cls_set(elem->cls, (mln_u8_t)c);
+                break;
+        }
+        p += len;
+        left -= len;
+
+quant:
+        if (left > 0) {
+            c = mln_get_char(0, p, left);
+            len = mln_get_length(p, left);
+            if (c == M_REGEXP_STAR || c == M_REGEXP_PLUS || c == M_REGEXP_QUES) {
+                elem->quant = c == M_REGEXP_STAR? '*': (c == M_REGEXP_PLUS? '+': '?');
+                p += len;
+                left -= len;
+            } else if (c == M_REGEXP_LBRACE) {
+                return -1;
+            }
+        }
+        ++n;
+    }
+    *nelem = n;
+    return 0;
+}
+
+static mln_u64_t mln_reg_dfa_closure(mln_reg_elem_t *elems, mln_u32_t n, mln_u64_t set)
+{
+    mln_u32_t i;
+    mln_u64_t prev = 0;
+
+    while (prev != set) {
+        prev = set;
+        for (i = 0; i < n; ++i) {
+            if ((set & ((mln_u64_t)1 << i)) && (elems[i].quant == '*' || elems[i].quant == '?'))
+                set |= ((mln_u64_t)1 << (i + 1));
+        }
+    }
+    return set;
+}
+
+static int mln_reg_dfa_build(mln_reg_t *reg, mln_reg_elem_t *elems, mln_u32_t n)
+{
+    mln_u64_t states[M_REGEXP_DFA_MAX_STATE], t;
+    mln_u32_t nstates = 2, i, c, j;
+    mln_u16_t *trans;
+    mln_u8ptr_t accepts;
+
+    states[0] = 0;/*dead state*/
+    states[1] = mln_reg_dfa_closure(elems, n, (mln_u64_t)1);
+    if ((trans = (mln_u16_t *)mln_reg_alloc(reg->pool, (M_REGEXP_DFA_MAX_STATE << 8) * sizeof(mln_u16_t))) == NULL)
+        return -1;
+    memset(trans, 0, (M_REGEXP_DFA_MAX_STATE << 8) * sizeof(mln_u16_t));
+
+    for (i = 1; i < nstates; ++i) {
+        for (c = 0; c < 256; ++c) {
+            t = 0;
+            for (j = 0; j < n; ++j) {
+                if (!(states[i] & ((mln_u64_t)1 << j))) continue;
+                if (!mln_reg_cls_test(elems[j].cls, (mln_u8_t)c)) continue;
+                t |= ((mln_u64_t)1 << (j + 1));
+                if (elems[j].quant == '*' || elems[j].quant == '+')
+                    t |= ((mln_u64_t)1 << j);
+            }
+            t = mln_reg_dfa_closure(elems, n, t);
+            if (t == 0) continue;
+            for (j = 0; j < nstates; ++j) {
+                if (states[j] == t) break;
+            }
+            if (j == nstates) {
+                if (nstates >= M_REGEXP_DFA_MAX_STATE) {
+                    mln_reg_dealloc(reg->pool, trans);
+                    return -1;
+                }
+                states[nstates++] = t;
+            }
+            trans[(i << 8) + c] = j;
+        }
+    }
+    if ((accepts = (mln_u8ptr_t)mln_reg_alloc(reg->pool, nstates)) == NULL) {
+        mln_reg_dealloc(reg->pool, trans);
+        return -1;
+    }
+    for (i = 0; i < nstates; ++i) {
+        accepts[i] = (states[i] >> n) & 0x1;
+    }
+    reg->trans = trans;
+    reg->accepts = accepts;
+    reg->nstates = nstates;
+    return 0;
+}
+
+static void mln_reg_literal_extract(mln_reg_t *reg, mln_string_t *exp)
+{
+    char *p = (char *)(exp->data);
+    int left = exp->len, c, len, count;
+    mln_u8ptr_t buf;
+    mln_u32_t cur = 0, run = 0, best_off = 0, best_len = 0;
+
+    reg->literal = NULL;
+    reg->litlen = 0;
+    if (!exp->len || (buf = (mln_u8ptr_t)malloc(exp->len)) == NULL) return;
+
+    while (left > 0) {
+        c = mln_get_char(0, p, left);
+        len = mln_get_length(p, left);
+        if (c == M_REGEXP_LPAR || c == M_REGEXP_RPAR || c == M_REGEXP_OR) {
+            free(buf);/*branches may not share the literal*/
+            return;
+        }
+        if (c == M_REGEXP_LSQUAR || c == M_REGEXP_LBRACE) {
+            int open = c, close = c == M_REGEXP_LSQUAR? M_REGEXP_RSQUAR: M_REGEXP_RBRACE;
+            unsigned int flag = c == M_REGEXP_LSQUAR? M_REGEXP_MASK_SQUARE: 0;
+            if (run > best_len) {
+                best_off = cur - run;
+                best_len = run;
+            }
+            run = 0;
+            count = 0;
+            while (left > 0) {
+                c = mln_get_char(flag, p, left);
+                len = mln_get_length(p, left);
+                p += len;
+                left -= len;
+                if (c == open) ++count;
+                if (c == close && --count == 0) break;
+            }
+            continue;
+        }
+        if (c >= 128) {/*'.', specials, quantifiers, anchors*/
+            if (run > best_len) {
+                best_off = cur - run;
+                best_len = run;
+            }
+            run = 0;
+            p += len;
+            left -= len;
+            continue;
+        }
+        /*literal byte: only required if not quantified*/
+        p += len;
+        left -= len;
+        if (left > 0) {
+            int nc = mln_get_char(0, p, left);
+            if (nc == M_REGEXP_STAR || nc == M_REGEXP_PLUS || \
+                nc == M_REGEXP_QUES || nc == M_REGEXP_LBRACE)
+            {
+                if (run > best_len) {
+                    best_off = cur - run;
+                    best_len = run;
+                }
+                run = 0;
+                continue;
+            }
+        }
+        buf[cur++] = (mln_u8_t)c;
+        ++run;
+    }
+    if (run > best_len) {
+        best_off = cur - run;
+        best_len = run;
+    }
+    if (!best_len) {
+        free(buf);
+        return;
+    }
+    if ((reg->literal = (mln_u8ptr_t)mln_reg_alloc(reg->pool, best_len)) == NULL) {
+        free(buf);
+        return;
+    }
+    memcpy(reg->literal, buf + best_off, best_len);
+    reg->litlen = best_len;
+    free(buf);
+}
+
+static inline int mln_reg_literal_exists(mln_reg_t *reg, mln_string_t *text)
+{
+    mln_u8ptr_t p = text->data, end = text->data + text->len;
+
+    if (reg->literal == NULL) return 1;
+    if (text->len < reg->litlen) return 0;
+    while ((p = (mln_u8ptr_t)memchr(p, reg->literal[0], end - p - reg->litlen + 1)) != NULL) {
+        if (!memcmp(p, reg->literal, reg->litlen)) return 1;
+        if (++p + reg->litlen > end) break;
+    }
+    return 0;
+}
+
+static mln_reg_t *mln_reg_compile_in(mln_alloc_t *pool, mln_string_t *exp)
+{
+    mln_reg_t *reg;
+    mln_reg_elem_t *elems;
+    mln_u32_t n = 0;
+
+    if (exp == NULL) return NULL;
+    if ((reg = (mln_reg_t *)mln_reg_alloc(pool, sizeof(mln_reg_t))) == NULL)
+        return NULL;
+    reg->pool = pool;
+    reg->exp = pool == NULL? mln_string_dup(exp): mln_string_pool_dup(pool, exp);
+    if (reg->exp == NULL) {
+        mln_reg_dealloc(pool, reg);
+        return NULL;
+    }
+    reg->trans = NULL;
+    reg->accepts = NULL;
+    reg->nstates = 0;
+    mln_reg_literal_extract(reg, exp);
+
+    if ((elems = (mln_reg_elem_t *)malloc((M_REGEXP_DFA_MAX_ELEM + 1) * sizeof(mln_reg_elem_t))) != NULL) {
+        if (!mln_reg_dfa_parse(reg->exp, elems, &n)) {
+            (void)mln_reg_dfa_build(reg, elems, n);/*failure just keeps the backtracker*/
+        }
+        free(elems);
+    }
+    return reg;
+}
+
+mln_reg_t *mln_reg_compile(mln_string_t *exp)
+{
+    return mln_reg_compile_in(NULL, exp);
+}
+
+mln_reg_t *mln_reg_pool_compile(mln_alloc_t *pool, mln_string_t *exp)
+{
+    if (pool == NULL) return NULL;
+    return mln_reg_compile_in(pool, exp);
+}
+
+void mln_reg_free(mln_reg_t *reg)
+{
+    if (reg == NULL) return;
+    if (reg->exp != NULL) mln_string_free(reg->exp);
+    mln_reg_dealloc(reg->pool, reg->trans);
+    mln_reg_dealloc(reg->pool, reg->accepts);
+    mln_reg_dealloc(reg->pool, reg->literal);
+    mln_reg_dealloc(reg->pool, reg);
+}
+
+static inline int mln_reg_equal_nofilter(mln_reg_t *reg, mln_string_t *text)
+{
+    mln_u8ptr_t p, end;
+    mln_u32_t state = 1;
+
+    if (reg->trans == NULL)
+        return mln_reg_equal(reg->exp, text);
+
+    for (p = text->data, end = text->data + text->len; p < end; ++p) {
+        state = reg->trans[(state << 8) + *p];
+        if (!state) return 0;
+    }
+    return reg->accepts[state];
+}
+
+int mln_reg_compiled_equal(mln_reg_t *reg, mln_string_t *text)
+{
+    if (reg == NULL || text == NULL) return 0;
+    if (!mln_reg_literal_exists(reg, text)) return 0;
+    return mln_reg_equal_nofilter(reg, text);
+}
+
+int mln_reg_compiled_match(mln_reg_t *reg, mln_string_t *text, mln_reg_match_t **head, mln_reg_match_t **tail)
+{
+    if (reg == NULL || text == NULL) return -1;
+    if (!mln_reg_literal_exists(reg, text)) return -1;
+    return mln_reg_match(reg->exp, text, head, tail);
+}
+
+/*pattern sets*/
+mln_reg_set_t *mln_reg_set_new(void)
+{
+    mln_reg_set_t *set;
+
+    if ((set = (mln_reg_set_t *)malloc(sizeof(mln_reg_set_t))) == NULL)
+        return NULL;
+    set->regs = NULL;
+    set->order = NULL;
+    set->nregs = 0;
+    set->cap = 0;
+    set->dirty = 0;
+    return set;
+}
+
+int mln_reg_set_add(mln_reg_set_t *set, mln_reg_t *reg)
+{
+    mln_reg_t **regs;
+    mln_size_t cap;
+
+    if (set == NULL || reg == NULL) return -1;
+    if (set->nregs >= set->cap) {
+        cap = set->cap? (set->cap << 1): 8;
+        if ((regs = (mln_reg_t **)realloc(set->regs, cap * sizeof(mln_reg_t *))) == NULL)
+            return -1;
+        set->regs = regs;
+        set->cap = cap;
+    }
+    set->regs[set->nregs++] = reg;
+    set->dirty = 1;
+    return 0;
+}
+
+static int mln_reg_set_index_build(mln_reg_set_t *set)
+{
+    mln_size_t i;
+    mln_u32_t cnt[256] = {0}, nlit = 0, c;
+
+    for (i = 0; i < set->nregs; ++i) {
+        if (set->regs[i]->literal == NULL) continue;
+        ++cnt[set->regs[i]->literal[0]];
+        ++nlit;
+    }
+    if (set->order != NULL) {
+        free(set->order);
+        set->order = NULL;
+    }
+    if (nlit) {
+        if ((set->order = (mln_u32_t *)malloc(nlit * sizeof(mln_u32_t))) == NULL)
+            return -1;
+    }
+    set->heads[0] = 0;
+    for (c = 0; c < 256; ++c) {
+        set->heads[c + 1] = set->heads[c] + cnt[c];
+    }
+    memset(cnt, 0, sizeof(cnt));
+    for (i = 0; i < set->nregs; ++i) {
+        if (set->regs[i]->literal == NULL) continue;
+        c = set->regs[i]->literal[0];
+        set->order[set->heads[c] + cnt[c]++] = i;
+    }
+    set->dirty = 0;
+    return 0;
+}
+
+int mln_reg_set_equal(mln_reg_set_t *set, mln_string_t *text, mln_u8ptr_t results)
+{
+    mln_reg_t *reg;
+    mln_u8ptr_t p, end;
+    mln_size_t i;
+    mln_u32_t j, pending = 0;
+    int matched = 0;
+
+    if (set == NULL || text == NULL || results == NULL) return -1;
+    if (set->dirty && mln_reg_set_index_build(set) < 0) return -1;
+
+    /*one pass over the subject locates every required literal*/
+    for (i = 0; i < set->nregs; ++i) {
+        if (set->regs[i]->literal == NULL) {
+            results[i] = 1;
+        } else {
+            results[i] = 2;
+            ++pending;
+        }
+    }
+    for (p = text->data, end = text->data + text->len; pending && p < end; ++p) {
+        for (j = set->heads[*p]; j < set->heads[*p + 1]; ++j) {
+            reg = set->regs[set->order[j]];
+            if (results[set->order[j]] != 2) continue;
+            if ((mln_size_t)(end - p) < reg->litlen) continue;
+            if (!memcmp(p, reg->literal, reg->litlen)) {
+                results[set->order[j]] = 1;
+                --pending;
+            }
+        }
+    }
+
+    for (i = 0; i < set->nregs; ++i) {
+        if (results[i] == 1 && mln_reg_equal_nofilter(set->regs[i], text)) {
+            results[i] = 1;
+            ++matched;
+        } else {
+            results[i] = 0;
+        }
+    }
+    return matched;
+}
+
+void mln_reg_set_free(mln_reg_set_t *set)
+{
+    if (set == NULL) return;
+    if (set->regs != NULL) free(set->regs);
+    if (set->order != NULL) free(set->order);
+    free(set);
+}
+
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) Niklaus F.Schen.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "mln_router.h"
+
+typedef struct mln_router_node_s mln_router_node_t;
+
+struct mln_router_node_s {
+    mln_string_t             seg;      /*literal segment or capture name*/
+    mln_router_node_t       *children; /*literal children*/
+    mln_router_node_t       *next;     /*sibling in the children list*/
+    mln_router_node_t       *param;    /*':name' child, at most one per node*/
+    mln_router_node_t       *wildcard; /*'*name' child, always terminal*/
+    void                    *data;
+    mln_u32_t                is_end;
+};
+
+struct mln_router_s {
+    mln_alloc_t             *pool;
+    mln_router_node_t        root;
+    mln_size_t               nroutes;
+};
+
+static mln_router_node_t *mln_router_node_new(mln_alloc_t *pool, mln_u8ptr_t seg, mln_size_t len)
+{
+    mln_router_node_t *node;
+    node = (mln_router_node_t *)mln_alloc_m(pool, sizeof(mln_router_node_t) + len);
+    if (node == NULL) return NULL;
+    node->seg.data = (mln_u8ptr_t)(node + 1);
+    node->seg.len = len;
+    node->seg.data_ref = 1;
+    node->seg.pool = 1;
+    node->seg.ref = 1;
+    memcpy(node->seg.data, seg, len);
+    node->children = node->next = node->param = node->wildcard = NULL;
+    node->data = NULL;
+    node->is_end = 0;
+    return node;
+}
+
+mln_router_t *mln_router_new(void)
+{
+    mln_router_t *router;
+    mln_alloc_t *pool;
+
+    if ((pool = mln_alloc_init(NULL)) == NULL) return NULL;
+    router = (mln_router_t *)mln_alloc_m(pool, sizeof(mln_router_t));
+    if (router == NULL) {
+        mln_alloc_destroy(pool);
+        return NULL;
+    }
+    router->pool = pool;
+    memset(&router->root, 0, sizeof(router->root));
+    router->nroutes = 0;
+    return router;
+}
+
+void mln_router_free(mln_router_t *router)
+{
+    if (router == NULL) return;
+    mln_alloc_destroy(router->pool);
+}
+
+int mln_router_add(mln_router_t *router, mln_string_t *path, void *data)
+{
+    mln_router_node_t *node = &router->root, *child;
+    mln_u8ptr_t p = path->data, end = path->data + path->len, s;
+
+    while (p < end) {
+        while (p < end && *p == '/') ++p;
+        if (p >= end) break;
+        for (s = p; p < end && *p != '/'; ++p);
+
+        if (*s == ':') {
+            if (p - s < 2) return -1;
+            if (node->param != NULL) {
+                /*one capture name per position, or lookups would be ambiguous*/
+                if (node->param->seg.len != (mln_size_t)(p - s - 1) || \
+                    memcmp(node->param->seg.data, s + 1, p - s - 1))
+                    return -1;
+            } else {
+                child = mln_router_node_new(router->pool, s + 1, p - s - 1);
+                if (child == NULL) return -1;
+                node->param = child;
+            }
+            node = node->param;
+        } else if (*s == '*') {
+            if (p - s < 2 || p < end) return -1;
+            if (node->wildcard != NULL) return -1;
+            child = mln_router_node_new(router->pool, s + 1, p - s - 1);
+            if (child == NULL) return -1;
+            node->wildcard = child;
+            node = child;
+        } else {
+            for (child = node->children; child != NULL; child = child->next) {
+                if (child->seg.len == (mln_size_t)(p - s) && \
+                    !memcmp(child->seg.data, s, p - s))
+                    break;
+            }
+            if (child == NULL) {
+                child = mln_router_node_new(router->pool, s, p - s);
+                if (child == NULL) return -1;
+                child->next = node->children;
+                node->children = child;
+            }
+            node = child;
+        }
+    }
+
+    if (node->is_end) return -1;
+    node->data = data;
+    node->is_end = 1;
+    ++(router->nroutes);
+    return 0;
+}
+
+static void *
+mln_router_node_match(mln_router_node_t *node, \
+                      mln_u8ptr_t p, \
+                      mln_u8ptr_t end, \
+                      mln_router_param_t *params, \
+                      mln_size_t cap, \
+                      mln_size_t *n)
+{
+    void *ret;
+    mln_u8ptr_t e;
+    mln_router_node_t *child;
+
+    while (p < end && *p == '/') ++p;
+    if (p >= end) {
+        if (node->is_end) return node->data;
+    } else {
+        for (e = p; e < end && *e != '/'; ++e);
+
+        for (child = node->children; child != NULL; child = child->next) {
+            if (child->seg.data[0] == *p && \
+                child->seg.len == (mln_size_t)(e - p) && \
+                !memcmp(child->seg.data, p, e - p))
+            {
+                if ((ret = mln_router_node_match(child, e, end, params, cap, n)) != NULL)
+                    return ret;
+                break;
+            }
+        }
+        if (node->param != NULL && *n < cap) {
+            params[*n].name = node->param->seg;
+            mln_string_nset(&params[*n].value, p, e - p);
+            ++(*n);
+            if ((ret = mln_router_node_match(node->param, e, end, params, cap, n)) != NULL)
+                return ret;
+            --(*n);
+        }
+    }
+    if (node->wildcard != NULL && p < end && *n < cap) {
+        params[*n].name = node->wildcard->seg;
+        mln_string_nset(&params[*n].value, p, end - p);
+        ++(*n);
+        return node->wildcard->data;
+    }
+    return NULL;
+}
+
+void *mln_router_match(mln_router_t *router, \
+                       mln_string_t *path, \
+                       mln_router_param_t *params, \
+                       mln_size_t nparams, \
+                       mln_size_t *matched)
+{
+    mln_size_t n = 0;
+    void *ret;
+
+    ret = mln_router_node_match(&router->root, \
+                                path->data, \
+                                path->data + path->len, \
+                                params, \
+                                params == NULL? 0: nparams, \
+                                &n);
+    if (matched != NULL) *matched = ret == NULL? 0: n;
+    return ret;
+}
@@ -40,12 +40,12 @@ struct mln_EMSAPKCS1V15_HASH_s {
 
 mln_rsa_key_t *mln_rsa_key_new(void)
 {
-    return (mln_rsa_key_t *)malloc(sizeof(mln_rsa_key_t));
+    return (mln_rsa_key_t *)calloc(1, sizeof(mln_rsa_key_t));
 }
 
 mln_rsa_key_t *mln_rsa_key_pool_new(mln_alloc_t *pool)
 {
-    return (mln_rsa_key_t *)mln_alloc_m(pool, sizeof(mln_rsa_key_t));
+    return (mln_rsa_key_t *)mln_alloc_c(pool, sizeof(mln_rsa_key_t));
 }
 
 void mln_rsa_key_free(mln_rsa_key_t *key)
@@ -107,6 +107,7 @@ lp:
     if (pub != NULL) {
         pub->n = n;
         pub->ed = e;
+        pub->e = e;
         pub->dp = pub->dq = e;
         mln_bignum_div(&(pub->dp), &tmpp_1, NULL);
         mln_bignum_div(&(pub->dq), &tmpq_1, NULL);
@@ -115,6 +116,7 @@ lp:
     if (pri != NULL) {
         pri->n = n;
         pri->ed = d;
+        pri->e = e;
         pri->dp = pri->dq = d;
         mln_bignum_div(&(pri->dp), &tmpp_1, NULL);
         mln_bignum_div(&(pri->dq), &tmpq_1, NULL);
@@ -124,24 +126,102 @@ lp:
     return 0;
 }
 
+/*
+ * Base blinding: raise a random r to the public exponent, fold it into
+ * the input and strip r^-1 from the result, so the CRT exponentiation
+ * never runs on the attacker-chosen value directly. Needs the public
+ * exponent in the key; generated keys carry it, hand-built keys without
+ * it simply run unblinded.
+ */
+static inline int
+mln_rsa_blinding_new(mln_rsa_key_t *key, mln_bignum_t *r_e, mln_bignum_t *rinv)
+{
+    mln_bignum_t r, one;
+    mln_u32_t i, n, tries;
+    unsigned int seed;
+    struct timeval tv;
+
+    if (mln_bignum_get_length(&(key->e)) == 0) return -1;
+
+    if (key->blind) {
+        /*square the cached pair so no two operations share a mask*/
+        mln_bignum_t tmp;
+        tmp = key->bre;
+        mln_bignum_mul(&(key->bre), &tmp);
+        mln_bignum_div(&(key->bre), &(key->n), NULL);
+        tmp = key->brinv;
+        mln_bignum_mul(&(key->brinv), &tmp);
+        mln_bignum_div(&(key->brinv), &(key->n), NULL);
+        *r_e = key->bre;
+        *rinv = key->brinv;
+        return 0;
+    }
+
+    gettimeofday(&tv, NULL);
+    seed = tv.tv_sec * 1000000 + tv.tv_usec;
+    mln_bignum_assign(&one, "1", 1);
+    n = mln_bignum_get_length(&(key->n));
+    for (tries = 0; tries < 3; ++tries) {
+        memset(&r, 0, sizeof(r));
+        for (i = 0; i + 1 < n; ++i) {
+#if defined(WIN32)
+            mln_u32_t val;
+            rand_s(&val);
+            r.data[i] = val;
+#else
+            r.data[i] = ((mln_u64_t)rand_r(&seed) << 17) ^ rand_r(&seed);
+#endif
+            r.data[i] %= M_BIGNUM_UMAX;
+        }
+        for (; i > 0 && r.data[i - 1] == 0; --i)
+            ;
+        if (i == 0) continue;
+        r.length = i;
+        if (mln_bignum_extend_eulid(&r, &(key->n), rinv, NULL) < 0) continue;
+        if (mln_bignum_compare(rinv, &one) < 0) continue;
+        *r_e = r;
+        if (mln_bignum_pwr(r_e, &(key->e), &(key->n)) < 0) continue;
+        key->bre = *r_e;
+        key->brinv = *rinv;
+        key->blind = 1;
+        return 0;
+    }
+    return -1;
+}
+
 static inline int mln_rsa_rsaep_rsadp(mln_rsa_key_t *key, mln_bignum_t *in, mln_bignum_t *out)
 {
     if (key->pwr || mln_bignum_abs_compare(&(key->ed), &(key->p)) <= 0) {
-in:
         if (mln_bignum_pwr(in, &(key->ed), &(key->n)) < 0) return -1;
         *out = *in;
     } else {
-        mln_bignum_t m1, m2;
+        mln_bignum_t m1, m2, t, r_e, rinv;
+        int blinded = mln_rsa_blinding_new(key, &r_e, &rinv) == 0;
+
+        if (blinded) {
+            mln_bignum_mul(in, &r_e);
+            mln_bignum_div(in, &(key->n), NULL);
+        }
         m1 = m2 = *in;
-        mln_bignum_pwr(&m1, &(key->dp), &(key->p));
-        mln_bignum_pwr(&m2, &(key->dq), &(key->q));
-        mln_bignum_sub(&m1, &m2);
-        if (mln_bignum_is_negative(&m1)) goto in;
+        if (mln_bignum_pwr(&m1, &(key->dp), &(key->p)) < 0) return -1;
+        if (mln_bignum_pwr(&m2, &(key->dq), &(key->q)) < 0) return -1;
+        /*Garner: h = qinv * (m1 - m2) mod p, result = m2 + h*q*/
+        t = m2;
+        if (mln_bignum_abs_compare(&t, &(key->p)) >= 0) {
+            mln_bignum_div(&t, &(key->p), NULL);
+        }
+        mln_bignum_sub(&m1, &t);
+        if (mln_bignum_is_negative(&m1)) {
+            mln_bignum_add(&m1, &(key->p));
+        }
         mln_bignum_mul(&m1, &(key->qinv));
         mln_bignum_div(&m1, &(key->p), NULL);
         mln_bignum_mul(&m1, &(key->q));
         mln_bignum_add(&m1, &m2);
-        mln_bignum_div(&m1, &(key->n), NULL);
+        if (blinded) {
+            mln_bignum_mul(&m1, &rinv);
+            mln_bignum_div(&m1, &(key->n), NULL);
+        }
         *out = m1;
     }
     return 0;
@@ -7,6 +7,46 @@
 #include <string.h>
 #include "mln_sha.h"
 
+/*
+ * Hardware SHA: the x86-64 SHA extensions and the ARMv8 Crypto
+ * Extensions, detected once at runtime with the scalar rounds below as
+ * the fallback -- the same dispatch pattern as mln_aes.c. The block
+ * routines take the streams to process as small arrays so the batch
+ * API can keep two independent messages in flight and hide the
+ * instruction latency.
+ */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define MLN_SHA_HW_X86 1
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#if defined(HWCAP_SHA1) && defined(HWCAP_SHA2)
+#define MLN_SHA_HW_ARM 1
+#include <arm_neon.h>
+#endif
+#endif
+
+#if defined(MLN_SHA_HW_X86) || defined(MLN_SHA_HW_ARM)
+#define M_SHA_BATCH_LANES 2
+
+static int mln_sha_hw_support(void)
+{
+    static int support = -1;
+    if (support < 0) {
+#if defined(MLN_SHA_HW_X86)
+        support = __builtin_cpu_supports("sha")? 1: 0;
+#else
+        support = ((getauxval(AT_HWCAP) & HWCAP_SHA1) && (getauxval(AT_HWCAP) & HWCAP_SHA2))? 1: 0;
+#endif
+    }
+    return support;
+}
+
+static void mln_sha1_hw_block_n(mln_sha1_t **ss, mln_u8ptr_t *datas, mln_u32_t n);
+static void mln_sha256_hw_block_n(mln_sha256_t **ss, mln_u8ptr_t *datas, mln_u32_t n);
+#endif
+
 /*
  * sha1
  */
@@ -138,6 +178,13 @@ void mln_sha1_calc(mln_sha1_t *s, mln_u8ptr_t input, mln_uauto_t len, mln_u32_t
 
 static inline void mln_sha1_calc_block(mln_sha1_t *s)
 {
+#if defined(MLN_SHA_HW_X86) || defined(MLN_SHA_HW_ARM)
+    if (mln_sha_hw_support()) {
+        mln_u8ptr_t data = s->buf;
+        mln_sha1_hw_block_n(&s, &data, 1);
+        return;
+    }
+#endif
     mln_u32_t i = 0, j = 0, group[16];
     mln_u32_t a = s->H0, b = s->H1, c = s->H2, d = s->H3, e = s->H4;
     while (i < __M_SHA_BUFLEN) {
@@ -339,6 +386,196 @@ static mln_u32_t sha256_round_constant[] = {
 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
 };
 
+#if defined(MLN_SHA_HW_X86)
+__attribute__((target("sha,sse4.1"))) static void
+mln_sha1_hw_block_n(mln_sha1_t **ss, mln_u8ptr_t *datas, mln_u32_t n)
+{
+    mln_u32_t g, j;
+    __m128i abcd[M_SHA_BATCH_LANES], save[M_SHA_BATCH_LANES], e[M_SHA_BATCH_LANES];
+    __m128i prev[M_SHA_BATCH_LANES], m[M_SHA_BATCH_LANES][4], t;
+    const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+    for (j = 0; j < n; ++j) {
+        abcd[j] = save[j] = prev[j] = _mm_set_epi32(ss[j]->H0, ss[j]->H1, ss[j]->H2, ss[j]->H3);
+        e[j] = _mm_set_epi32(ss[j]->H4, 0, 0, 0);
+    }
+    for (g = 0; g < 20; ++g) {
+        for (j = 0; j < n; ++j) {
+            if (g < 4) {
+                m[j][g] = _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)(datas[j] + (g << 4))), mask);
+            } else {
+                m[j][g & 3] = _mm_sha1msg2_epu32(\
+                                  _mm_xor_si128(\
+                                      _mm_sha1msg1_epu32(m[j][g & 3], m[j][(g + 1) & 3]), \
+                                      m[j][(g + 2) & 3]), \
+                                  m[j][(g + 3) & 3]);
+            }
+            if (g == 0) t = _mm_add_epi32(e[j], m[j][0]);
+            else t = _mm_sha1nexte_epu32(prev[j], m[j][g & 3]);
+            prev[j] = abcd[j];
+            switch (g / 5) {
+                case 0: abcd[j] = _mm_sha1rnds4_epu32(abcd[j], t, 0); break;
+                case 1: abcd[j] = _mm_sha1rnds4_epu32(abcd[j], t, 1); break;
+                case 2: abcd[j] = _mm_sha1rnds4_epu32(abcd[j], t, 2); break;
+                default: abcd[j] = _mm_sha1rnds4_epu32(abcd[j], t, 3); break;
+            }
+        }
+    }
+    for (j = 0; j < n; ++j) {
+        abcd[j] = _mm_add_epi32(abcd[j], save[j]);
+        t = _mm_sha1nexte_epu32(prev[j], e[j]);
+        ss[j]->H0 = (mln_u32_t)_mm_extract_epi32(abcd[j], 3);
+        ss[j]->H1 = (mln_u32_t)_mm_extract_epi32(abcd[j], 2);
+        ss[j]->H2 = (mln_u32_t)_mm_extract_epi32(abcd[j], 1);
+        ss[j]->H3 = (mln_u32_t)_mm_extract_epi32(abcd[j], 0);
+        ss[j]->H4 = (mln_u32_t)_mm_extract_epi32(t, 3);
+    }
+}
+
+__attribute__((target("sha,sse4.1"))) static void
+mln_sha256_hw_block_n(mln_sha256_t **ss, mln_u8ptr_t *datas, mln_u32_t n)
+{
+    mln_u32_t g, j, st[8];
+    __m128i s0[M_SHA_BATCH_LANES], s1[M_SHA_BATCH_LANES];
+    __m128i save0[M_SHA_BATCH_LANES], save1[M_SHA_BATCH_LANES];
+    __m128i m[M_SHA_BATCH_LANES][4], t, tmp;
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    for (j = 0; j < n; ++j) {
+        tmp = _mm_shuffle_epi32(_mm_set_epi32(ss[j]->H3, ss[j]->H2, ss[j]->H1, ss[j]->H0), 0xB1);
+        t = _mm_shuffle_epi32(_mm_set_epi32(ss[j]->H7, ss[j]->H6, ss[j]->H5, ss[j]->H4), 0x1B);
+        s0[j] = save0[j] = _mm_alignr_epi8(tmp, t, 8);   /*ABEF*/
+        s1[j] = save1[j] = _mm_blend_epi16(t, tmp, 0xF0);/*CDGH*/
+    }
+    for (g = 0; g < 16; ++g) {
+        for (j = 0; j < n; ++j) {
+            if (g < 4) {
+                m[j][g] = _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)(datas[j] + (g << 4))), mask);
+            } else {
+                m[j][g & 3] = _mm_sha256msg2_epu32(\
+                                  _mm_add_epi32(\
+                                      _mm_sha256msg1_epu32(m[j][g & 3], m[j][(g + 1) & 3]), \
+                                      _mm_alignr_epi8(m[j][(g + 3) & 3], m[j][(g + 2) & 3], 4)), \
+                                  m[j][(g + 3) & 3]);
+            }
+            t = _mm_add_epi32(m[j][g & 3], _mm_loadu_si128((__m128i *)(sha256_round_constant + (g << 2))));
+            s1[j] = _mm_sha256rnds2_epu32(s1[j], s0[j], t);
+            t = _mm_shuffle_epi32(t, 0x0E);
+            s0[j] = _mm_sha256rnds2_epu32(s0[j], s1[j], t);
+        }
+    }
+    for (j = 0; j < n; ++j) {
+        s0[j] = _mm_add_epi32(s0[j], save0[j]);
+        s1[j] = _mm_add_epi32(s1[j], save1[j]);
+        tmp = _mm_shuffle_epi32(s0[j], 0x1B);        /*FEBA*/
+        t = _mm_shuffle_epi32(s1[j], 0xB1);          /*DCHG*/
+        _mm_storeu_si128((__m128i *)st, _mm_blend_epi16(tmp, t, 0xF0));
+        _mm_storeu_si128((__m128i *)(st + 4), _mm_alignr_epi8(t, tmp, 8));
+        ss[j]->H0 = st[0];
+        ss[j]->H1 = st[1];
+        ss[j]->H2 = st[2];
+        ss[j]->H3 = st[3];
+        ss[j]->H4 = st[4];
+        ss[j]->H5 = st[5];
+        ss[j]->H6 = st[6];
+        ss[j]->H7 = st[7];
+    }
+}
+#elif defined(MLN_SHA_HW_ARM)
+__attribute__((target("+crypto"))) static void
+mln_sha1_hw_block_n(mln_sha1_t **ss, mln_u8ptr_t *datas, mln_u32_t n)
+{
+    mln_u32_t g, j, st[4], e[M_SHA_BATCH_LANES], e0[M_SHA_BATCH_LANES], tmp;
+    uint32x4_t abcd[M_SHA_BATCH_LANES], save[M_SHA_BATCH_LANES], m[M_SHA_BATCH_LANES][4], t;
+
+    for (j = 0; j < n; ++j) {
+        st[0] = ss[j]->H0;
+        st[1] = ss[j]->H1;
+        st[2] = ss[j]->H2;
+        st[3] = ss[j]->H3;
+        abcd[j] = save[j] = vld1q_u32(st);
+        e[j] = e0[j] = ss[j]->H4;
+    }
+    for (g = 0; g < 20; ++g) {
+        for (j = 0; j < n; ++j) {
+            if (g < 4) {
+                m[j][g] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(datas[j] + (g << 4))));
+            } else {
+                m[j][g & 3] = vsha1su1q_u32(\
+                                  vsha1su0q_u32(m[j][g & 3], m[j][(g + 1) & 3], m[j][(g + 2) & 3]), \
+                                  m[j][(g + 3) & 3]);
+            }
+            t = vaddq_u32(m[j][g & 3], vdupq_n_u32(k[g / 5]));
+            tmp = vsha1h_u32(vgetq_lane_u32(abcd[j], 0));
+            switch (g / 5) {
+                case 0: abcd[j] = vsha1cq_u32(abcd[j], e[j], t); break;
+                case 1: abcd[j] = vsha1pq_u32(abcd[j], e[j], t); break;
+                case 2: abcd[j] = vsha1mq_u32(abcd[j], e[j], t); break;
+                default: abcd[j] = vsha1pq_u32(abcd[j], e[j], t); break;
+            }
+            e[j] = tmp;
+        }
+    }
+    for (j = 0; j < n; ++j) {
+        vst1q_u32(st, vaddq_u32(abcd[j], save[j]));
+        ss[j]->H0 = st[0];
+        ss[j]->H1 = st[1];
+        ss[j]->H2 = st[2];
+        ss[j]->H3 = st[3];
+        ss[j]->H4 = e0[j] + e[j];
+    }
+}
+
+__attribute__((target("+crypto"))) static void
+mln_sha256_hw_block_n(mln_sha256_t **ss, mln_u8ptr_t *datas, mln_u32_t n)
+{
+    mln_u32_t g, j, st[8];
+    uint32x4_t s0[M_SHA_BATCH_LANES], s1[M_SHA_BATCH_LANES];
+    uint32x4_t save0[M_SHA_BATCH_LANES], save1[M_SHA_BATCH_LANES];
+    uint32x4_t m[M_SHA_BATCH_LANES][4], t, tmp;
+
+    for (j = 0; j < n; ++j) {
+        st[0] = ss[j]->H0;
+        st[1] = ss[j]->H1;
+        st[2] = ss[j]->H2;
+        st[3] = ss[j]->H3;
+        st[4] = ss[j]->H4;
+        st[5] = ss[j]->H5;
+        st[6] = ss[j]->H6;
+        st[7] = ss[j]->H7;
+        s0[j] = save0[j] = vld1q_u32(st);
+        s1[j] = save1[j] = vld1q_u32(st + 4);
+    }
+    for (g = 0; g < 16; ++g) {
+        for (j = 0; j < n; ++j) {
+            if (g < 4) {
+                m[j][g] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(datas[j] + (g << 4))));
+            } else {
+                m[j][g & 3] = vsha256su1q_u32(\
+                                  vsha256su0q_u32(m[j][g & 3], m[j][(g + 1) & 3]), \
+                                  m[j][(g + 2) & 3], m[j][(g + 3) & 3]);
+            }
+            t = vaddq_u32(m[j][g & 3], vld1q_u32(sha256_round_constant + (g << 2)));
+            tmp = s0[j];
+            s0[j] = vsha256hq_u32(s0[j], s1[j], t);
+            s1[j] = vsha256h2q_u32(s1[j], tmp, t);
+        }
+    }
+    for (j = 0; j < n; ++j) {
+        vst1q_u32(st, vaddq_u32(s0[j], save0[j]));
+        vst1q_u32(st + 4, vaddq_u32(s1[j], save1[j]));
+        ss[j]->H0 = st[0];
+        ss[j]->H1 = st[1];
+        ss[j]->H2 = st[2];
+        ss[j]->H3 = st[3];
+        ss[j]->H4 = st[4];
+        ss[j]->H5 = st[5];
+        ss[j]->H6 = st[6];
+        ss[j]->H7 = st[7];
+    }
+}
+#endif
+
 void mln_sha256_init(mln_sha256_t *s)
 {
     s->H0 = 0x6a09e667;
@@ -449,6 +686,13 @@ static inline mln_u32_t mln_sha256_safe_add(mln_u32_t x, mln_u32_t y)
 
 static inline void mln_sha256_calc_block(mln_sha256_t *s)
 {
+#if defined(MLN_SHA_HW_X86) || defined(MLN_SHA_HW_ARM)
+    if (mln_sha_hw_support()) {
+        mln_u8ptr_t data = s->buf;
+        mln_sha256_hw_block_n(&s, &data, 1);
+        return;
+    }
+#endif
     mln_u32_t h0, h1, h2, h3, h4, h5, h6, h7;
     mln_u32_t j, t1, t2;
     mln_u32_t group[64] = {0};
@@ -592,6 +836,49 @@ void mln_sha256_tostring(mln_sha256_t *s, mln_s8ptr_t buf, mln_u32_t len)
     if (n < len) buf[n] = 0;
 }
 
+void mln_sha256_batch(mln_sha256_t **ss, mln_u8ptr_t *inputs, mln_uauto_t *lens, mln_u32_t n)
+{
+    mln_u32_t i;
+
+#if defined(MLN_SHA_HW_X86) || defined(MLN_SHA_HW_ARM)
+    if (mln_sha_hw_support()) {
+        mln_sha256_t *pair[M_SHA_BATCH_LANES];
+        mln_u8ptr_t data[M_SHA_BATCH_LANES];
+        mln_uauto_t left[M_SHA_BATCH_LANES];
+        mln_u32_t j;
+
+        for (i = 0; i + M_SHA_BATCH_LANES <= n; i += M_SHA_BATCH_LANES) {
+            for (j = 0; j < M_SHA_BATCH_LANES; ++j) {
+                pair[j] = ss[i + j];
+                data[j] = inputs[i + j];
+                left[j] = lens[i + j];
+            }
+            if (pair[0]->pos == 0 && pair[1]->pos == 0) {
+                /*whole blocks of both streams run interleaved, tails fall through below*/
+                while (left[0] >= __M_SHA_BUFLEN && left[1] >= __M_SHA_BUFLEN) {
+                    mln_sha256_hw_block_n(pair, data, M_SHA_BATCH_LANES);
+                    for (j = 0; j < M_SHA_BATCH_LANES; ++j) {
+                        pair[j]->length += __M_SHA_BUFLEN;
+                        data[j] += __M_SHA_BUFLEN;
+                        left[j] -= __M_SHA_BUFLEN;
+                    }
+                }
+            }
+            for (j = 0; j < M_SHA_BATCH_LANES; ++j) {
+                mln_sha256_calc(pair[j], data[j], left[j], 1);
+            }
+        }
+        for (; i < n; ++i) {
+            mln_sha256_calc(ss[i], inputs[i], lens[i], 1);
+        }
+        return;
+    }
+#endif
+    for (i = 0; i < n; ++i) {
+        mln_sha256_calc(ss[i], inputs[i], lens[i], 1);
+    }
+}
+
 void mln_sha256_dump(mln_sha256_t *s)
 {
     printf("%lx %lx %lx %lx %lx %lx %lx %lx\n", \
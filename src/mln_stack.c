@@ -10,34 +10,23 @@
  * declarations
  */
 MLN_CHAIN_FUNC_DECLARE(mln_stack, \
-                       mln_stack_node_t, \
+                       mln_stack_seg_t, \
                        static inline void,);
-static mln_stack_node_t *
-mln_stack_node_init(void *data);
-static void
-mln_stack_node_destroy(mln_stack_t *st, stack_free free_handler, mln_stack_node_t *sn);
+static void mln_stack_seg_destroy(mln_stack_t *st, stack_free free_handler, mln_stack_seg_t *seg, mln_u32_t n);
 
 /*
- * stack_node
+ * stack_seg
  */
-static mln_stack_node_t *
-mln_stack_node_init(void *data)
-{
-    mln_stack_node_t *sn = (mln_stack_node_t *)malloc(sizeof(mln_stack_node_t));
-    if (sn == NULL) return NULL;
-    sn->prev = NULL;
-    sn->next = NULL;
-    sn->data = data;
-    return sn;
-}
-
 static void
-mln_stack_node_destroy(mln_stack_t *st, stack_free free_handler, mln_stack_node_t *sn)
+mln_stack_seg_destroy(mln_stack_t *st, stack_free free_handler, mln_stack_seg_t *seg, mln_u32_t n)
 {
-    if (sn == NULL) return;
-    if (free_handler != NULL)
-        free_handler(sn->data);
-    free(sn);
+    if (seg == NULL) return;
+    if (free_handler != NULL) {
+        mln_u32_t i;
+        for (i = 0; i < n; ++i)
+            free_handler(seg->elems[i]);
+    }
+    free(seg);
 }
 
 /*
@@ -49,6 +38,9 @@ mln_stack_t *mln_stack_init(struct mln_stack_attr *attr)
     if (st == NULL) return NULL;
     st->bottom = NULL;
     st->top = NULL;
+    st->free_head = NULL;
+    st->free_tail = NULL;
+    st->top_idx = 0;
     st->nr_node = 0;
     st->free_handler = attr->free_handler;
     st->copy_handler = attr->copy_handler;
@@ -59,11 +51,15 @@ void mln_stack_destroy(mln_stack_t *st)
 {
     if (st == NULL) return;
 
-    mln_stack_node_t *sn;
+    mln_stack_seg_t *seg;
 
-    while ((sn = st->bottom) != NULL) {
-        mln_stack_chain_del(&(st->bottom), &(st->top), sn);
-        mln_stack_node_destroy(st, st->free_handler, sn);
+    while ((seg = st->bottom) != NULL) {
+        mln_stack_chain_del(&(st->bottom), &(st->top), seg);
+        mln_stack_seg_destroy(st, st->free_handler, seg, st->bottom == NULL? st->top_idx: M_STACK_SEG_NR);
+    }
+    while ((seg = st->free_head) != NULL) {
+        mln_stack_chain_del(&(st->free_head), &(st->free_tail), seg);
+        free(seg);
     }
     free(st);
 }
@@ -72,7 +68,7 @@ void mln_stack_destroy(mln_stack_t *st)
  * chain
  */
 MLN_CHAIN_FUNC_DEFINE(mln_stack, \
-                      mln_stack_node_t, \
+                      mln_stack_seg_t, \
                       static inline void, \
                       prev, \
                       next);
@@ -83,10 +79,18 @@ MLN_CHAIN_FUNC_DEFINE(mln_stack, \
  */
 int mln_stack_push(mln_stack_t *st, void *data)
 {
-    mln_stack_node_t *sn;
-    sn = mln_stack_node_init(data);
-    if (sn == NULL) return -1;
-    mln_stack_chain_add(&(st->bottom), &(st->top), sn);
+    if (st->top == NULL || st->top_idx == M_STACK_SEG_NR) {
+        mln_stack_seg_t *seg;
+        if ((seg = st->free_head) != NULL) {
+            mln_stack_chain_del(&(st->free_head), &(st->free_tail), seg);
+        } else if ((seg = (mln_stack_seg_t *)malloc(sizeof(mln_stack_seg_t))) == NULL) {
+            return -1;
+        }
+        seg->prev = seg->next = NULL;
+        mln_stack_chain_add(&(st->bottom), &(st->top), seg);
+        st->top_idx = 0;
+    }
+    st->top->elems[(st->top_idx)++] = data;
     ++(st->nr_node);
     return 0;
 }
@@ -96,12 +100,17 @@ int mln_stack_push(mln_stack_t *st, void *data)
  */
 void *mln_stack_pop(mln_stack_t *st)
 {
-    mln_stack_node_t *sn = st->top;
-    if (sn == NULL) return NULL;
-    mln_stack_chain_del(&(st->bottom), &(st->top), sn);
+    void *ptr;
+
+    if (!st->nr_node) return NULL;
+    ptr = st->top->elems[--(st->top_idx)];
     --(st->nr_node);
-    void *ptr = sn->data;
-    mln_stack_node_destroy(st, NULL, sn);
+    if (st->top_idx == 0 && st->top->prev != NULL) {
+        mln_stack_seg_t *seg = st->top;
+        mln_stack_chain_del(&(st->bottom), &(st->top), seg);
+        mln_stack_chain_add(&(st->free_head), &(st->free_tail), seg);
+        st->top_idx = M_STACK_SEG_NR;
+    }
     return ptr;
 }
 
@@ -116,24 +125,28 @@ mln_stack_t *mln_stack_dup(mln_stack_t *st, void *udata)
     sattr.copy_handler = st->copy_handler;
     mln_stack_t *new_st = mln_stack_init(&sattr);
     if (new_st == NULL) return NULL;
-    mln_stack_node_t *scan;
+    mln_stack_seg_t *scan;
+    mln_u32_t i, n;
     void *data;
     for (scan = st->bottom; scan != NULL; scan = scan->next) {
-        if (new_st->copy_handler == NULL) {
-            data = scan->data;
-        } else {
-            data = new_st->copy_handler(scan->data, udata);
-            if (data == NULL) {
+        n = scan == st->top? st->top_idx: M_STACK_SEG_NR;
+        for (i = 0; i < n; ++i) {
+            if (new_st->copy_handler == NULL) {
+                data = scan->elems[i];
+            } else {
+                data = new_st->copy_handler(scan->elems[i], udata);
+                if (data == NULL) {
+                    mln_stack_destroy(new_st);
+                    return NULL;
+                }
+            }
+            if (mln_stack_push(new_st, data) < 0) {
+                if (new_st->free_handler != NULL)
+                    new_st->free_handler(data);
                 mln_stack_destroy(new_st);
                 return NULL;
             }
         }
-        if (mln_stack_push(new_st, data) < 0) {
-            if (new_st->free_handler != NULL)
-                new_st->free_handler(data);
-            mln_stack_destroy(new_st);
-            return NULL;
-        }
     }
     return new_st;
 }
@@ -143,9 +156,13 @@ mln_stack_t *mln_stack_dup(mln_stack_t *st, void *udata)
  */
 int mln_stack_iterate(mln_stack_t *st, stack_iterate_handler handler, void *data)
 {
-    mln_stack_node_t *sn;
-    for (sn = st->top; sn != NULL; sn = sn->prev) {
-        if (handler(sn->data, data) < 0) return -1;
+    mln_stack_seg_t *seg;
+    mln_u32_t i;
+    for (seg = st->top; seg != NULL; seg = seg->prev) {
+        i = seg == st->top? st->top_idx: M_STACK_SEG_NR;
+        for (; i > 0; --i) {
+            if (handler(seg->elems[i - 1], data) < 0) return -1;
+        }
     }
     return 0;
 }
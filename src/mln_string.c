@@ -25,9 +25,49 @@ static inline mln_string_t *mln_string_assign(char *s, mln_u32_t len)
     str->pool = 0;
     str->data_ref = 1;
     str->ref = 1;
+    str->hash = 0;
     return str;
 }
 
+/*
+ * Small-string optimization: strings up to M_STRING_INLINE_MAX bytes
+ * are stored right behind the descriptor in a single allocation.
+ * data_ref is set so that mln_string_free() releases the whole block
+ * with the descriptor instead of freeing the bytes separately.
+ */
+#define M_STRING_INLINE_MAX 24
+
+static inline mln_string_t *mln_string_inline_new(const mln_u8_t *data, mln_u64_t len)
+{
+    mln_string_t *s = (mln_string_t *)malloc(sizeof(mln_string_t) + len + 1);
+    if (s == NULL) return NULL;
+    s->data = (mln_u8ptr_t)(s + 1);
+    if (data != NULL) memcpy(s->data, data, len);
+    s->data[len] = 0;
+    s->len = len;
+    s->data_ref = 1;
+    s->pool = 0;
+    s->ref = 1;
+    s->hash = 0;
+    return s;
+}
+
+static inline mln_string_t *
+mln_string_inline_pool_new(mln_alloc_t *pool, const mln_u8_t *data, mln_u64_t len)
+{
+    mln_string_t *s = (mln_string_t *)mln_alloc_m(pool, sizeof(mln_string_t) + len + 1);
+    if (s == NULL) return NULL;
+    s->data = (mln_u8ptr_t)(s + 1);
+    if (data != NULL) memcpy(s->data, data, len);
+    s->data[len] = 0;
+    s->len = len;
+    s->data_ref = 1;
+    s->pool = 1;
+    s->ref = 1;
+    s->hash = 0;
+    return s;
+}
+
 mln_string_t *mln_string_buf_new(mln_u8ptr_t buf, mln_u64_t len)
 {
     mln_string_t *str = (mln_string_t *)malloc(sizeof(mln_string_t));
@@ -38,6 +78,7 @@ mln_string_t *mln_string_buf_new(mln_u8ptr_t buf, mln_u64_t len)
     str->data_ref = 0;
     str->pool = 0;
     str->ref = 1;
+    str->hash = 0;
     return str;
 }
 
@@ -51,12 +92,19 @@ mln_string_t *mln_string_buf_pool_new(mln_alloc_t *pool, mln_u8ptr_t buf, mln_u6
     str->data_ref = 0;
     str->pool = 1;
     str->ref = 1;
+    str->hash = 0;
     return str;
 }
 
 mln_string_t *mln_string_pool_new(mln_alloc_t *pool, const char *s)
 {
-    mln_string_t *str = (mln_string_t *)mln_alloc_m(pool, sizeof(mln_string_t));
+    mln_string_t *str;
+    if (s != NULL) {
+        mln_u64_t l = strlen(s);
+        if (l <= M_STRING_INLINE_MAX)
+            return mln_string_inline_pool_new(pool, (mln_u8_t *)s, l);
+    }
+    str = (mln_string_t *)mln_alloc_m(pool, sizeof(mln_string_t));
     if (str == NULL) return NULL;
     if (s == NULL) {
         str->data = NULL;
@@ -64,6 +112,7 @@ mln_string_t *mln_string_pool_new(mln_alloc_t *pool, const char *s)
         str->data_ref = 0;
         str->pool = 1;
         str->ref = 1;
+        str->hash = 0;
         return str;
     }
     mln_s32_t len = strlen(s);
@@ -77,12 +126,19 @@ mln_string_t *mln_string_pool_new(mln_alloc_t *pool, const char *s)
     str->data_ref = 0;
     str->pool = 1;
     str->ref = 1;
+    str->hash = 0;
     return str;
 }
 
 mln_string_t *mln_string_new(const char *s)
 {
-    mln_string_t *str = (mln_string_t *)malloc(sizeof(mln_string_t));
+    mln_string_t *str;
+    if (s != NULL) {
+        mln_u64_t l = strlen(s);
+        if (l <= M_STRING_INLINE_MAX)
+            return mln_string_inline_new((mln_u8_t *)s, l);
+    }
+    str = (mln_string_t *)malloc(sizeof(mln_string_t));
     if (str == NULL) return NULL;
     if (s == NULL) {
         str->data = NULL;
@@ -90,6 +146,7 @@ mln_string_t *mln_string_new(const char *s)
         str->data_ref = 0;
         str->pool = 0;
         str->ref = 1;
+        str->hash = 0;
         return str;
     }
     mln_s32_t len = strlen(s);
@@ -103,11 +160,14 @@ mln_string_t *mln_string_new(const char *s)
     str->data_ref = 0;
     str->pool = 0;
     str->ref = 1;
+    str->hash = 0;
     return str;
 }
 
 mln_string_t *mln_string_dup(mln_string_t *str)
 {
+    if (str->len <= M_STRING_INLINE_MAX)
+        return mln_string_inline_new(str->data, str->len);
     mln_string_t *s = (mln_string_t *)malloc(sizeof(mln_string_t));
     if (s == NULL) return NULL;
     if ((s->data = (mln_u8ptr_t)malloc(str->len + 1)) == NULL) {
@@ -120,11 +180,14 @@ mln_string_t *mln_string_dup(mln_string_t *str)
     s->data_ref = 0;
     s->pool = 0;
     s->ref = 1;
+    s->hash = 0;
     return s;
 }
 
 mln_string_t *mln_string_pool_dup(mln_alloc_t *pool, mln_string_t *str)
 {
+    if (str->len <= M_STRING_INLINE_MAX)
+        return mln_string_inline_pool_new(pool, str->data, str->len);
     mln_string_t *s = (mln_string_t *)mln_alloc_m(pool, sizeof(mln_string_t));
     if (s == NULL) return NULL;
     if ((s->data = (mln_u8ptr_t)mln_alloc_m(pool, str->len + 1)) == NULL) {
@@ -137,15 +200,18 @@ mln_string_t *mln_string_pool_dup(mln_alloc_t *pool, mln_string_t *str)
     s->data_ref = 0;
     s->pool = 1;
     s->ref = 1;
+    s->hash = 0;
     return s;
 }
 
 mln_string_t *mln_string_ndup(mln_string_t *str, mln_s32_t size)
 {
     if (size < 0) return NULL;
+    mln_s32_t min = size > str->len ? str->len : size;
+    if ((mln_u64_t)min <= M_STRING_INLINE_MAX)
+        return mln_string_inline_new(str->data, min);
     mln_string_t *s = (mln_string_t *)malloc(sizeof(mln_string_t));
     if (s == NULL) return NULL;
-    mln_s32_t min = size > str->len ? str->len : size;
     if ((s->data = (mln_u8ptr_t)malloc(min + 1)) == NULL) {
         free(s);
         return NULL;
@@ -156,12 +222,15 @@ mln_string_t *mln_string_ndup(mln_string_t *str, mln_s32_t size)
     s->data_ref = 0;
     s->pool = 0;
     s->ref = 1;
+    s->hash = 0;
     return s;
 }
 
 mln_string_t *mln_string_const_ndup(char *str, mln_s32_t size)
 {
     if (size < 0) return NULL;
+    if ((mln_u64_t)size <= M_STRING_INLINE_MAX)
+        return mln_string_inline_new((mln_u8_t *)str, size);
     mln_string_t *s = (mln_string_t *)malloc(sizeof(mln_string_t));
     if (s == NULL) return NULL;
     if ((s->data = (mln_u8ptr_t)malloc(size + 1)) == NULL) {
@@ -174,6 +243,7 @@ mln_string_t *mln_string_const_ndup(char *str, mln_s32_t size)
     s->data_ref = 0;
     s->pool = 0;
     s->ref = 1;
+    s->hash = 0;
     return s;
 }
 
@@ -186,6 +256,7 @@ mln_string_t *mln_string_ref_dup(mln_string_t *str)
     s->data_ref = 1;
     s->pool = 0;
     s->ref = 1;
+    s->hash = 0;
     return s;
 }
 
@@ -198,6 +269,7 @@ mln_string_t *mln_string_const_ref_dup(char *s)
     str->data_ref = 1;
     str->pool = 0;
     str->ref = 1;
+    str->hash = 0;
     return str;
 }
 
@@ -287,19 +359,79 @@ int mln_string_const_strncmp(mln_string_t *s1, char *s2, mln_u32_t n)
     return 0;
 }
 
+/*
+ * Vectorized case-insensitive comparison: both 16-byte lanes are
+ * lowered (0x20 OR'd into bytes in the 'A'-'Z' range) and compared at
+ * once; a mismatching lane pins down the first differing byte, which
+ * decides the ordering. HTTP header matching runs every header name
+ * through these, so the per-byte tolower() loop was a hot leaf.
+ */
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define MLN_STR_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define MLN_STR_SIMD_NEON
+#endif
+
+static inline int mln_string_casecmp_core(mln_u8_t *p1, mln_u8_t *p2, mln_u32_t len)
+{
+    mln_u32_t i = 0;
+#if defined(MLN_STR_SIMD_SSE2)
+    while (len - i >= 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(p1 + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(p2 + i));
+        __m128i la = _mm_and_si128(_mm_cmpgt_epi8(a, _mm_set1_epi8('A' - 1)), \
+                                   _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), a));
+        __m128i lb = _mm_and_si128(_mm_cmpgt_epi8(b, _mm_set1_epi8('A' - 1)), \
+                                   _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), b));
+        a = _mm_or_si128(a, _mm_and_si128(la, _mm_set1_epi8(0x20)));
+        b = _mm_or_si128(b, _mm_and_si128(lb, _mm_set1_epi8(0x20)));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+        if (mask != 0xffff) {
+            i += __builtin_ctz(~mask);
+            return tolower(p1[i]) - tolower(p2[i]);
+        }
+        i += 16;
+    }
+#elif defined(MLN_STR_SIMD_NEON)
+    while (len - i >= 16) {
+        uint8x16_t a = vld1q_u8(p1 + i);
+        uint8x16_t b = vld1q_u8(p2 + i);
+        uint8x16_t la = vandq_u8(vcgeq_u8(a, vdupq_n_u8('A')), vcleq_u8(a, vdupq_n_u8('Z')));
+        uint8x16_t lb = vandq_u8(vcgeq_u8(b, vdupq_n_u8('A')), vcleq_u8(b, vdupq_n_u8('Z')));
+        a = vorrq_u8(a, vandq_u8(la, vdupq_n_u8(0x20)));
+        b = vorrq_u8(b, vandq_u8(lb, vdupq_n_u8(0x20)));
+        /*4 mask bits per byte via vshrn, as in the json scanner*/
+        uint8x8_t n = vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(a, b)), 4);
+        mln_u64_t mask = vget_lane_u64(vreinterpret_u64_u8(n), 0);
+        if (mask != (mln_u64_t)-1) {
+            i += __builtin_ctzll(~mask) >> 2;
+            return tolower(p1[i]) - tolower(p2[i]);
+        }
+        i += 16;
+    }
+#endif
+    for (; i < len; ++i) {
+        int res = tolower(p1[i]) - tolower(p2[i]);
+        if (res) return res;
+    }
+    return 0;
+}
+
 int mln_string_strcasecmp(mln_string_t *s1, mln_string_t *s2)
 {
     if (s1 == s2 || s1->data == s2->data) return 0;
     if (s1->len > s2->len) return 1;
     if (s1->len < s2->len) return -1;
-    return strncasecmp((char *)(s1->data), (char *)(s2->data), s1->len);
+    return mln_string_casecmp_core(s1->data, s2->data, s1->len);
 }
 
 int mln_string_strncasecmp(mln_string_t *s1, mln_string_t *s2, mln_u32_t n)
 {
     if (s1 == s2 || s1->data == s2->data) return 0;
     if (s1->len < n || s2->len < n) return -1;
-    return strncasecmp((char *)(s1->data), (char *)(s2->data), n);
+    return mln_string_casecmp_core(s1->data, s2->data, n);
 }
 
 int mln_string_const_strcasecmp(mln_string_t *s1, char *s2)
@@ -308,7 +440,7 @@ int mln_string_const_strcasecmp(mln_string_t *s1, char *s2)
     mln_u32_t len = strlen(s2);
     if (s1->len > len) return 1;
     if (s1->len < len) return -1;
-    return strncasecmp((char *)(s1->data), s2, len);
+    return mln_string_casecmp_core(s1->data, (mln_u8ptr_t)s2, len);
 }
 
 int mln_string_const_strncasecmp(mln_string_t *s1, char *s2, mln_u32_t n)
@@ -316,21 +448,59 @@ int mln_string_const_strncasecmp(mln_string_t *s1, char *s2, mln_u32_t n)
     if (s1->data == (mln_u8ptr_t)s2) return 0;
     mln_u32_t len = strlen(s2);
     if (s1->len < n || len < n) return -1;
-    return strncasecmp((char *)(s1->data), s2, n);
+    return mln_string_casecmp_core(s1->data, (mln_u8ptr_t)s2, n);
+}
+
+int mln_string_eq_ci(mln_string_t *s1, mln_string_t *s2)
+{
+    if (s1->len != s2->len) return 0;
+    if (s1 == s2 || s1->data == s2->data) return 1;
+    return mln_string_casecmp_core(s1->data, s2->data, s1->len) == 0;
+}
+
+/*
+ * Two-character-filter search: memchr() locates candidates for the first
+ * pattern byte (libc vectorizes it), the last byte is checked before the
+ * full memcmp() verify, which rejects most false candidates in two loads.
+ * Length-aware, so embedded NUL bytes in text or pattern are handled.
+ */
+static inline char *
+mln_string_search(mln_u8ptr_t text, mln_size_t tlen, mln_u8ptr_t pattern, mln_size_t plen)
+{
+    mln_u8ptr_t p = text, end;
+    mln_u8_t head, tail;
+
+    if (plen == 0) return (char *)text;
+    if (plen > tlen) return NULL;
+
+    head = pattern[0];
+    tail = pattern[plen - 1];
+    end = text + tlen - plen + 1;
+    while (p < end) {
+        p = (mln_u8ptr_t)memchr(p, head, end - p);
+        if (p == NULL) return NULL;
+        if (p[plen - 1] == tail && \
+            (plen <= 2 || !memcmp(p + 1, pattern + 1, plen - 2)))
+        {
+            return (char *)p;
+        }
+        ++p;
+    }
+    return NULL;
 }
 
 char *mln_string_strstr(mln_string_t *text, mln_string_t *pattern)
 {
     if (text == pattern || text->data == pattern->data)
         return (char *)(text->data);
-    return strstr((char *)(text->data), (char *)(pattern->data));
+    return mln_string_search(text->data, text->len, pattern->data, pattern->len);
 }
 
 char *mln_string_const_strstr(mln_string_t *text, char *pattern)
 {
     if (text->data == (mln_u8ptr_t)pattern)
         return (char *)(text->data);
-    return strstr((char *)(text->data), pattern);
+    return mln_string_search(text->data, text->len, (mln_u8ptr_t)pattern, strlen(pattern));
 }
 
 mln_string_t *mln_string_new_strstr(mln_string_t *text, mln_string_t *pattern)
@@ -422,6 +592,113 @@ static inline int *compute_prefix_function(const char *pattern, int m)
     return shift;
 }
 
+/*
+ * Multi-pattern matcher.
+ * A dense Aho-Corasick automaton: one 256-entry transition row per
+ * state with the failure function folded into the rows at build time,
+ * so the scan is one table load per text byte no matter how many
+ * patterns are registered.
+ */
+
+mln_string_ac_t *mln_string_ac_new(mln_string_t *patterns, mln_size_t n)
+{
+    mln_string_ac_t *ac;
+    mln_u32_t nstates = 1, next_id = 1, s, v, *queue;
+    mln_u32_t qhead = 0, qtail = 0;
+    mln_size_t i, j;
+    int c;
+
+    for (i = 0; i < n; ++i) {
+        if (patterns[i].len == 0) return NULL;
+        nstates += patterns[i].len;
+    }
+
+    ac = (mln_string_ac_t *)malloc(sizeof(mln_string_ac_t));
+    if (ac == NULL) return NULL;
+    ac->tbl = (mln_u32_t *)calloc((mln_size_t)nstates << 8, sizeof(mln_u32_t));
+    ac->fail = (mln_u32_t *)calloc(nstates, sizeof(mln_u32_t));
+    ac->olink = (mln_u32_t *)calloc(nstates, sizeof(mln_u32_t));
+    ac->out = (mln_u32_t *)calloc(nstates, sizeof(mln_u32_t));
+    ac->plen = (mln_size_t *)calloc(n? n: 1, sizeof(mln_size_t));
+    if (ac->tbl == NULL || ac->fail == NULL || ac->olink == NULL || \
+        ac->out == NULL || ac->plen == NULL)
+    {
+        mln_string_ac_free(ac);
+        return NULL;
+    }
+
+    for (i = 0; i < n; ++i) {
+        s = 0;
+        for (j = 0; j < patterns[i].len; ++j) {
+            v = ac->tbl[((mln_size_t)s << 8) + patterns[i].data[j]];
+            if (v == 0) {
+                v = next_id++;
+                ac->tbl[((mln_size_t)s << 8) + patterns[i].data[j]] = v;
+            }
+            s = v;
+        }
+        if (ac->out[s] == 0) ac->out[s] = i + 1;
+        ac->plen[i] = patterns[i].len;
+    }
+    ac->nstates = next_id;
+    ac->npatterns = n;
+
+    queue = (mln_u32_t *)malloc(next_id * sizeof(mln_u32_t));
+    if (queue == NULL) {
+        mln_string_ac_free(ac);
+        return NULL;
+    }
+    for (c = 0; c < 256; ++c) {
+        if ((v = ac->tbl[c]) != 0) {
+            queue[qtail++] = v;
+        }
+    }
+    while (qhead < qtail) {
+        s = queue[qhead++];
+        ac->olink[s] = ac->out[ac->fail[s]]? ac->fail[s]: ac->olink[ac->fail[s]];
+        for (c = 0; c < 256; ++c) {
+            v = ac->tbl[((mln_size_t)s << 8) + c];
+            if (v != 0) {
+                ac->fail[v] = ac->tbl[((mln_size_t)(ac->fail[s]) << 8) + c];
+                queue[qtail++] = v;
+            } else {
+                ac->tbl[((mln_size_t)s << 8) + c] = \
+                    ac->tbl[((mln_size_t)(ac->fail[s]) << 8) + c];
+            }
+        }
+    }
+    free(queue);
+    return ac;
+}
+
+void mln_string_ac_free(mln_string_ac_t *ac)
+{
+    if (ac == NULL) return;
+    if (ac->tbl != NULL) free(ac->tbl);
+    if (ac->fail != NULL) free(ac->fail);
+    if (ac->olink != NULL) free(ac->olink);
+    if (ac->out != NULL) free(ac->out);
+    if (ac->plen != NULL) free(ac->plen);
+    free(ac);
+}
+
+int mln_string_ac_match(mln_string_ac_t *ac, mln_string_t *text, mln_string_ac_cb_t cb, void *udata)
+{
+    mln_u32_t s = 0, t;
+    mln_size_t i, index;
+    mln_u8ptr_t data = text->data;
+
+    for (i = 0; i < text->len; ++i) {
+        s = ac->tbl[((mln_size_t)s << 8) + data[i]];
+        for (t = ac->out[s]? s: ac->olink[s]; t != 0; t = ac->olink[t]) {
+            index = ac->out[t] - 1;
+            if (cb(text, i + 1 - ac->plen[index], index, udata) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
 mln_string_t *mln_string_slice(mln_string_t *s, const char *sep_array/*ended by \0*/)
 {
     const char *ps;
@@ -451,6 +728,7 @@ static mln_string_t *mln_string_slice_recursive(char *s, mln_u64_t len, mln_u8pt
         ret[cnt-1].data_ref = 0;
         ret[cnt-1].pool = 0;
         ret[cnt-1].ref = 1;
+        ret[cnt-1].hash = 0;
         return ret;
     }
     ++cnt;
@@ -465,6 +743,7 @@ static mln_string_t *mln_string_slice_recursive(char *s, mln_u64_t len, mln_u8pt
     array[cnt-2].data_ref = 1;
     array[cnt-2].pool = 0;
     array[cnt-2].ref = 1;
+    array[cnt-2].hash = 0;
     return array;
 }
 
@@ -488,6 +767,7 @@ mln_string_t *mln_string_strcat(mln_string_t *s1, mln_string_t *s2)
         ret->data_ref = 0;
         ret->pool = 0;
         ret->ref = 1;
+        ret->hash = 0;
         return ret;
     }
     if ((ret->data = (mln_u8ptr_t)malloc(len + 1)) == NULL) {
@@ -501,6 +781,7 @@ mln_string_t *mln_string_strcat(mln_string_t *s1, mln_string_t *s2)
     ret->data_ref = 0;
     ret->pool = 0;
     ret->ref = 1;
+    ret->hash = 0;
     return ret;
 }
 
@@ -515,6 +796,7 @@ mln_string_t *mln_string_pool_strcat(mln_alloc_t *pool, mln_string_t *s1, mln_st
         ret->data_ref = 0;
         ret->pool = 1;
         ret->ref = 1;
+        ret->hash = 0;
         return ret;
     }
     if ((ret->data = (mln_u8ptr_t)mln_alloc_m(pool, len + 1)) == NULL) {
@@ -528,6 +810,7 @@ mln_string_t *mln_string_pool_strcat(mln_alloc_t *pool, mln_string_t *s1, mln_st
     ret->data_ref = 0;
     ret->pool = 1;
     ret->ref = 1;
+    ret->hash = 0;
     return ret;
 }
 
@@ -585,6 +868,7 @@ void mln_string_upper(mln_string_t *s)
         if (chars[s->data[i]])
             s->data[i] = chars[s->data[i]];
     }
+    s->hash = 0;/*contents changed, drop the cached hash*/
 }
 
 void mln_string_lower(mln_string_t *s)
@@ -601,5 +885,111 @@ void mln_string_lower(mln_string_t *s)
         if (chars[s->data[i]])
             s->data[i] = chars[s->data[i]];
     }
+    s->hash = 0;/*contents changed, drop the cached hash*/
 }
 
+
+/*
+ * String builder.
+ * Fragments are appended into growing segments so that assembling a
+ * composite string does not reallocate or copy what was already
+ * written; mln_string_builder_finalize() then emits the result as one
+ * contiguous mln_string_t in a single allocation.
+ */
+
+/*segment capacities: start small, double up to the cap*/
+#define M_STRING_BUILDER_SEG_MIN 256
+#define M_STRING_BUILDER_SEG_MAX 8192
+
+static inline mln_u8ptr_t mln_string_builder_seg_buf(mln_string_builder_seg_t *seg)
+{
+    return (mln_u8ptr_t)(seg + 1);
+}
+
+void mln_string_builder_init(mln_string_builder_t *sb, mln_alloc_t *pool)
+{
+    sb->pool = pool;
+    sb->head = sb->tail = NULL;
+    sb->len = 0;
+}
+
+void mln_string_builder_destroy(mln_string_builder_t *sb)
+{
+    mln_string_builder_seg_t *seg, *next;
+
+    if (sb == NULL) return;
+    for (seg = sb->head; seg != NULL; seg = next) {
+        next = seg->next;
+        if (sb->pool != NULL) mln_alloc_free(seg);
+        else free(seg);
+    }
+    sb->head = sb->tail = NULL;
+    sb->len = 0;
+}
+
+int mln_string_builder_append(mln_string_builder_t *sb, char *s, mln_u64_t len)
+{
+    mln_string_builder_seg_t *seg;
+    mln_size_t size, n;
+
+    while (len > 0) {
+        seg = sb->tail;
+        if (seg == NULL || seg->len == seg->size) {
+            size = seg == NULL? M_STRING_BUILDER_SEG_MIN: (seg->size << 1);
+            if (size > M_STRING_BUILDER_SEG_MAX) size = M_STRING_BUILDER_SEG_MAX;
+            if (sb->pool != NULL)
+                seg = (mln_string_builder_seg_t *)mln_alloc_m(sb->pool, sizeof(mln_string_builder_seg_t) + size);
+            else
+                seg = (mln_string_builder_seg_t *)malloc(sizeof(mln_string_builder_seg_t) + size);
+            if (seg == NULL) return -1;
+            seg->next = NULL;
+            seg->len = 0;
+            seg->size = size;
+            if (sb->tail == NULL) sb->head = sb->tail = seg;
+            else {
+                sb->tail->next = seg;
+                sb->tail = seg;
+            }
+        }
+        n = seg->size - seg->len;
+        if ((mln_u64_t)n > len) n = len;
+        memcpy(mln_string_builder_seg_buf(seg) + seg->len, s, n);
+        seg->len += n;
+        s += n;
+        len -= n;
+        sb->len += n;
+    }
+    return 0;
+}
+
+int mln_string_builder_append_string(mln_string_builder_t *sb, mln_string_t *s)
+{
+    return mln_string_builder_append(sb, (char *)(s->data), s->len);
+}
+
+mln_string_t *mln_string_builder_finalize(mln_string_builder_t *sb)
+{
+    mln_string_t *str;
+    mln_string_builder_seg_t *seg;
+    mln_u8ptr_t p;
+
+    if (sb->pool != NULL)
+        str = (mln_string_t *)mln_alloc_m(sb->pool, sizeof(mln_string_t) + sb->len + 1);
+    else
+        str = (mln_string_t *)malloc(sizeof(mln_string_t) + sb->len + 1);
+    if (str == NULL) return NULL;
+    str->data = (mln_u8ptr_t)(str + 1);
+    str->len = sb->len;
+    str->data_ref = 1;
+    str->pool = sb->pool != NULL? 1: 0;
+    str->ref = 1;
+    str->hash = 0;
+    p = str->data;
+    for (seg = sb->head; seg != NULL; seg = seg->next) {
+        memcpy(p, mln_string_builder_seg_buf(seg), seg->len);
+        p += seg->len;
+    }
+    *p = 0;
+    mln_string_builder_destroy(sb);
+    return str;
+}
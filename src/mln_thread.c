@@ -11,6 +11,7 @@
 #endif
 #include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include "mln_thread.h"
 #include "mln_rbtree.h"
@@ -34,6 +35,7 @@ char thread_start_func[] = "thread_main";
  */
 static mln_thread_module_t *module_array = NULL;
 static mln_size_t module_array_num = 0;
+static mln_u32_t thread_ring_size = 0; /*0: classic socketpair transport*/
 
 /*
  * declarations
@@ -78,6 +80,117 @@ static inline void *
 mln_get_module_entrance(char *alias);
 static inline int
 __mln_thread_create(mln_thread_t *t);
+static inline void
+mln_main_thread_itc_route(mln_event_t *ev, mln_thread_t *t, mln_thread_msg_t *msg);
+static void
+mln_thread_ring_flush(mln_event_t *ev, mln_thread_t *t);
+
+/*
+ * ring transport
+ */
+void mln_thread_ring_size_set(mln_u32_t size)
+{
+    thread_ring_size = size;
+}
+
+static mln_thread_ring_t *mln_thread_ring_new(mln_u32_t size)
+{
+    mln_thread_ring_t *r;
+
+    /* round up to a power of two */
+    --size;
+    size |= size >> 1;
+    size |= size >> 2;
+    size |= size >> 4;
+    size |= size >> 8;
+    size |= size >> 16;
+    ++size;
+
+    if ((r = (mln_thread_ring_t *)malloc(sizeof(mln_thread_ring_t))) == NULL)
+        return NULL;
+    if ((r->slots = (mln_thread_msg_t *)calloc(size, sizeof(mln_thread_msg_t))) == NULL) {
+        free(r);
+        return NULL;
+    }
+    r->size = size;
+    r->mask = size - 1;
+    r->head = r->tail = 0;
+    r->waiting = 1; /*consumers start parked, the first message must knock*/
+    return r;
+}
+
+static void mln_thread_ring_reset(mln_thread_ring_t *r)
+{
+    mln_u32_t head, tail;
+    if (r == NULL) return;
+    head = r->head;
+    tail = r->tail;
+    while (head != tail)
+        mln_thread_clear_msg(&(r->slots[(head++) & r->mask]));
+    r->head = r->tail = 0;
+    r->waiting = 1;
+}
+
+static void mln_thread_ring_free(mln_thread_ring_t *r)
+{
+    if (r == NULL) return;
+    mln_thread_ring_reset(r);
+    free(r->slots);
+    free(r);
+}
+
+static inline void mln_thread_fd_nonblock_set(int fd)
+{
+    int flg = fcntl(fd, F_GETFL, NULL);
+    fcntl(fd, F_SETFL, flg | O_NONBLOCK);
+}
+
+int mln_thread_msg_post(mln_thread_msg_t *msg)
+{
+    mln_thread_t *t = m_thread;
+    mln_thread_ring_t *r;
+    mln_u32_t head, tail;
+
+    if (t == NULL || (r = t->to_main) == NULL) return -1;
+    tail = __atomic_load_n(&(r->tail), __ATOMIC_RELAXED);
+    head = __atomic_load_n(&(r->head), __ATOMIC_ACQUIRE);
+    if (tail - head >= r->size) return 1;
+    r->slots[tail & r->mask] = *msg;
+    __atomic_store_n(&(r->tail), tail + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n(&(r->waiting), 0, __ATOMIC_SEQ_CST))
+        (void)send(t->peerfd, " ", 1, 0);
+    return 0;
+}
+
+int mln_thread_msg_fetch(mln_thread_msg_t *msg)
+{
+    mln_thread_t *t = m_thread;
+    mln_thread_ring_t *r;
+    mln_s8_t c;
+    mln_u32_t head, tail;
+
+    if (t == NULL || (r = t->to_child) == NULL) return -1;
+    head = __atomic_load_n(&(r->head), __ATOMIC_RELAXED);
+again:
+    tail = __atomic_load_n(&(r->tail), __ATOMIC_ACQUIRE);
+    if (head != tail) {
+        *msg = r->slots[head & r->mask];
+        __atomic_store_n(&(r->head), head + 1, __ATOMIC_RELEASE);
+        return 0;
+    }
+    while (recv(t->peerfd, &c, 1, 0) == 1)
+        ;/*swallow stale doorbells before parking*/
+    /*
+     * Raise the flag before the final emptiness check, so a message
+     * published in between either shows up here or gets a doorbell.
+     */
+    __atomic_store_n(&(r->waiting), 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&(r->tail), __ATOMIC_SEQ_CST) != head) {
+        __atomic_store_n(&(r->waiting), 0, __ATOMIC_SEQ_CST);
+        goto again;
+    }
+    return -1;
+}
 
 
 /*
@@ -109,6 +222,19 @@ mln_thread_init(struct mln_thread_attr *attr)
     t->local_tail = NULL;
     t->dest_head = NULL;
     t->dest_tail = NULL;
+    t->to_main = t->to_child = NULL;
+    if (thread_ring_size) {
+        if ((t->to_main = mln_thread_ring_new(thread_ring_size)) == NULL || \
+            (t->to_child = mln_thread_ring_new(thread_ring_size)) == NULL)
+        {
+            mln_thread_ring_free(t->to_main);
+            mln_tcp_conn_destroy(&(t->conn));
+            mln_string_free(t->alias);
+            free(t);
+            return NULL;
+        }
+        mln_thread_fd_nonblock_set(attr->peerfd);
+    }
     return t;
 }
 
@@ -143,6 +269,8 @@ mln_thread_destroy(mln_thread_t *t)
     mln_thread_itc_chain_release_msg(c);
     mln_tcp_conn_destroy(&(t->conn));
     mln_thread_clear_msg_queue(t->ev, t);
+    mln_thread_ring_free(t->to_main);
+    mln_thread_ring_free(t->to_child);
     free(t);
 }
 
@@ -440,6 +568,41 @@ mln_thread_itc_chain_release_msg(mln_chain_t *c)
 /*
  * main thread itc_handler
  */
+static void
+mln_main_thread_ring_recv(mln_event_t *ev, mln_thread_t *t)
+{
+    mln_thread_ring_t *r = t->to_main;
+    int fd = mln_tcp_conn_fd_get(&(t->conn));
+    mln_s8_t c;
+    ssize_t n;
+    mln_u32_t head, tail;
+    mln_thread_msg_t msg;
+    int closed = 0;
+
+    while ((n = recv(fd, &c, 1, 0)) == 1)
+        ;/*swallow pending doorbells*/
+    if (n == 0) closed = 1;
+
+    head = __atomic_load_n(&(r->head), __ATOMIC_RELAXED);
+again:
+    tail = __atomic_load_n(&(r->tail), __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        msg = r->slots[head & r->mask];
+        __atomic_store_n(&(r->head), ++head, __ATOMIC_RELEASE);
+        mln_main_thread_itc_route(ev, t, &msg);
+    }
+    if (closed) {
+        mln_log(report, "Child thread '%s' exit.\n", t->argv[0]);
+        mln_thread_deal_child_exit(ev, t);
+        return;
+    }
+    __atomic_store_n(&(r->waiting), 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&(r->tail), __ATOMIC_SEQ_CST) != head) {
+        __atomic_store_n(&(r->waiting), 0, __ATOMIC_SEQ_CST);
+        goto again;
+    }
+}
+
 static void
 mln_main_thread_itc_recv_handler(mln_event_t *ev, int fd, void *data)
 {
@@ -447,6 +610,11 @@ mln_main_thread_itc_recv_handler(mln_event_t *ev, int fd, void *data)
     mln_tcp_conn_t *conn = &(t->conn);
     int ret;
 
+    if (t->to_main != NULL) {
+        mln_main_thread_ring_recv(ev, t);
+        return;
+    }
+
     while (1) {
         ret = mln_tcp_conn_recv(conn, M_C_TYPE_MEMORY);
         if (ret == M_C_FINISH) {
@@ -467,56 +635,106 @@ mln_main_thread_itc_recv_handler(mln_event_t *ev, int fd, void *data)
     mln_main_thread_itc_recv_handler_process(ev, t);
 }
 
-static void
-mln_main_thread_itc_recv_handler_process(mln_event_t *ev, mln_thread_t *t)
+static inline void
+mln_main_thread_itc_route(mln_event_t *ev, mln_thread_t *t, mln_thread_msg_t *msg)
 {
-    mln_tcp_conn_t *conn = &(t->conn);
-    mln_thread_msg_t msg, *m;
+    mln_thread_msg_t *m;
     mln_thread_msgq_t *tmq;
     mln_thread_t *target, tmp;
     mln_rbtree_node_t *rn;
 
-    while (1) {
-        if (mln_itc_get_buf_with_len(conn, &msg, sizeof(msg)) < 0) {
-            return;
-        }
+    tmq = mln_thread_msgq_init(t, msg);
+    if (tmq == NULL) {
+        mln_log(error, "No memory.\n");
+        return;
+    }
 
-        tmq = mln_thread_msgq_init(t, &msg);
-        if (tmq == NULL) {
-            mln_log(error, "No memory.\n");
-            continue;
-        }
+    m = &(tmq->msg);
+    m->src = mln_string_dup(t->alias);
+    if (m->src == NULL) {
+        mln_log(error, "No memory.\n");
+        mln_thread_clear_msg(&(tmq->msg));
+        mln_thread_msgq_destroy(tmq);
+        return;
+    }
 
-        m = &(tmq->msg);
-        m->src = mln_string_dup(t->alias);
-        if (m->src == NULL) {
-            mln_log(error, "No memory.\n");
-            mln_thread_clear_msg(&(tmq->msg));
-            mln_thread_msgq_destroy(tmq);
-            continue;
-        }
+    tmp.alias = m->dest;
+    rn = mln_rbtree_search(thread_tree, &tmp);
+    if (mln_rbtree_null(rn, thread_tree)) {
+        mln_log(report, "No such thread named '%s'.\n", (char *)(m->dest->data));
+        mln_thread_clear_msg(&(tmq->msg));
+        mln_thread_msgq_destroy(tmq);
+        return;
+    }
 
-        tmp.alias = m->dest;
-        rn = mln_rbtree_search(thread_tree, &tmp);
-        if (mln_rbtree_null(rn, thread_tree)) {
-            mln_log(report, "No such thread named '%s'.\n", (char *)(m->dest->data));
-            mln_thread_clear_msg(&(tmq->msg));
-            mln_thread_msgq_destroy(tmq);
-            continue;
-        }
+    target = (mln_thread_t *)mln_rbtree_node_data_get(rn);
+    if (target->to_child != NULL) {
+        msg_local_chain_add(&(t->local_head), &(t->local_tail), tmq);
+        msg_dest_chain_add(&(target->dest_head), &(target->dest_tail), tmq);
+        mln_thread_ring_flush(ev, target);
+        return;
+    }
+    if (target->dest_head == NULL) {
+        mln_event_fd_set(ev, \
+                         mln_tcp_conn_fd_get(&(target->conn)), \
+                         M_EV_SEND|M_EV_ONESHOT|M_EV_NONBLOCK|M_EV_APPEND, \
+                         M_EV_UNLIMITED, \
+                         target, \
+                         mln_main_thread_itc_send_handler);
+    }
 
-        target = (mln_thread_t *)mln_rbtree_node_data_get(rn);
-        if (target->dest_head == NULL) {
-            mln_event_fd_set(ev, \
-                             mln_tcp_conn_fd_get(&(target->conn)), \
-                             M_EV_SEND|M_EV_ONESHOT|M_EV_NONBLOCK|M_EV_APPEND, \
-                             M_EV_UNLIMITED, \
-                             target, \
-                             mln_main_thread_itc_send_handler);
+    msg_local_chain_add(&(t->local_head), &(t->local_tail), tmq);
+    msg_dest_chain_add(&(target->dest_head), &(target->dest_tail), tmq);
+}
+
+static void
+mln_thread_ring_flush_retry(mln_event_t *ev, void *data)
+{
+    mln_thread_ring_flush(ev, (mln_thread_t *)data);
+}
+
+/*
+ * Batched delivery into the target's ring; messages that do not fit
+ * stay on the dest chain and are retried from a short timer, since the
+ * child gives no readable event when it drains its ring.
+ */
+static void
+mln_thread_ring_flush(mln_event_t *ev, mln_thread_t *t)
+{
+    mln_thread_ring_t *r = t->to_child;
+    mln_thread_msgq_t *tmq;
+    mln_u32_t head, tail;
+
+    while ((tmq = t->dest_head) != NULL) {
+        tail = __atomic_load_n(&(r->tail), __ATOMIC_RELAXED);
+        head = __atomic_load_n(&(r->head), __ATOMIC_ACQUIRE);
+        if (tail - head >= r->size) {
+            if (mln_event_timer_set(ev, 1, t, mln_thread_ring_flush_retry) == NULL)
+                mln_log(error, "No memory.\n");
+            return;
         }
+        msg_dest_chain_del(&(t->dest_head), &(t->dest_tail), tmq);
+        if (tmq->sender != NULL)
+            msg_local_chain_del(&(tmq->sender->local_head), &(tmq->sender->local_tail), tmq);
+        r->slots[tail & r->mask] = tmq->msg;
+        mln_thread_msgq_destroy(tmq);
+        __atomic_store_n(&(r->tail), tail + 1, __ATOMIC_SEQ_CST);
+        if (__atomic_exchange_n(&(r->waiting), 0, __ATOMIC_SEQ_CST))
+            (void)send(mln_tcp_conn_fd_get(&(t->conn)), " ", 1, 0);
+    }
+}
 
-        msg_local_chain_add(&(t->local_head), &(t->local_tail), tmq);
-        msg_dest_chain_add(&(target->dest_head), &(target->dest_tail), tmq);
+static void
+mln_main_thread_itc_recv_handler_process(mln_event_t *ev, mln_thread_t *t)
+{
+    mln_tcp_conn_t *conn = &(t->conn);
+    mln_thread_msg_t msg;
+
+    while (1) {
+        if (mln_itc_get_buf_with_len(conn, &msg, sizeof(msg)) < 0) {
+            return;
+        }
+        mln_main_thread_itc_route(ev, t, &msg);
     }
 }
 
@@ -656,6 +874,10 @@ mln_thread_deal_child_exit(mln_event_t *ev, mln_thread_t *t)
     }
     mln_tcp_conn_fd_set(&(t->conn), fds[0]);
     t->peerfd = fds[1];
+    mln_thread_ring_reset(t->to_main);
+    mln_thread_ring_reset(t->to_child);
+    if (t->to_main != NULL)
+        mln_thread_fd_nonblock_set(t->peerfd);
     if (__mln_thread_create(t) < 0) {
         mln_thread_destroy(t);
         return -1;
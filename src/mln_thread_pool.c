@@ -39,10 +39,53 @@ __thread mln_thread_pool_member_t *m_thread_pool_self = NULL;
 
 static void *child_thread_launcher(void *arg);
 static void mln_thread_pool_free(mln_thread_pool_t *tp);
+static mln_sptr_t mln_thread_pool_steal_loop(mln_thread_pool_member_t *tpm);
+static inline void mln_thread_pool_future_complete(mln_thread_pool_future_t *future, int rc);
 
 MLN_CHAIN_FUNC_DECLARE(mln_child, \
                        mln_thread_pool_member_t, \
                        static inline void,);
+MLN_CHAIN_FUNC_DECLARE(mln_res, \
+                       mln_thread_pool_resource_t, \
+                       static inline void,);
+
+/*
+ * work-stealing deques
+ * Each deque has its own spin lock, so submission and consumption are
+ * spread over the workers instead of serializing on the pool mutex.
+ * The owner takes from the head, thieves from the tail.
+ */
+static inline void
+mln_thread_pool_deque_push(mln_thread_pool_deque_t *d, mln_thread_pool_resource_t *tpr)
+{
+    mln_spin_lock(&(d->lock));
+    mln_res_chain_add(&(d->head), &(d->tail), tpr);
+    mln_spin_unlock(&(d->lock));
+}
+
+static inline mln_thread_pool_resource_t *
+mln_thread_pool_deque_pop(mln_thread_pool_deque_t *d)
+{
+    mln_thread_pool_resource_t *tpr;
+    if (d->head == NULL) return NULL;
+    mln_spin_lock(&(d->lock));
+    if ((tpr = d->head) != NULL)
+        mln_res_chain_del(&(d->head), &(d->tail), tpr);
+    mln_spin_unlock(&(d->lock));
+    return tpr;
+}
+
+static inline mln_thread_pool_resource_t *
+mln_thread_pool_deque_steal(mln_thread_pool_deque_t *d)
+{
+    mln_thread_pool_resource_t *tpr;
+    if (d->tail == NULL) return NULL;
+    if (mln_spin_trylock(&(d->lock)) != 0) return NULL;/*owner is busy here, try the next sibling*/
+    if ((tpr = d->tail) != NULL)
+        mln_res_chain_del(&(d->head), &(d->tail), tpr);
+    mln_spin_unlock(&(d->lock));
+    return tpr;
+}
 
 /*
  * thread_pool_member
@@ -55,7 +98,9 @@ mln_thread_pool_member_new(mln_thread_pool_t *tpool, mln_u32_t child)
         return NULL;
     }
     tpm->data = NULL;
+    tpm->future = NULL;
     tpm->pool = tpool;
+    tpm->deque = NULL;
     tpm->idle = 1;
     tpm->locked = 0;
     tpm->forked = 0;
@@ -67,6 +112,8 @@ mln_thread_pool_member_new(mln_thread_pool_t *tpool, mln_u32_t child)
 static inline void mln_thread_pool_member_free(mln_thread_pool_member_t *member)
 {
     if (member == NULL) return;
+    if (member->future != NULL)
+        mln_thread_pool_future_complete(member->future, -1);
     if (member->data != NULL && member->pool->free_handler != NULL)
         member->pool->free_handler(member->data);
     free(member);
@@ -183,13 +230,21 @@ mln_thread_pool_new(struct mln_thread_pool_attr *tpattr, int *err)
     }
     tp->res_chain_head = tp->res_chain_tail = NULL;
     tp->child_head = tp->child_tail = NULL;
+    tp->deques = NULL;
+    tp->n_deques = 0;
+    tp->rr = 0;
     tp->idle = tp->counter = 0;
     tp->quit = 0;
+    tp->steal = tpattr->work_stealing? 1: 0;
     tp->cond_timeout = tpattr->cond_timeout;
+    tp->idle_timeout = tpattr->idle_timeout;
+    tp->spawned = tp->retired = 0;
     tp->n_res = 0;
+    tp->spawn_threshold = tpattr->spawn_threshold;
     tp->process_handler = tpattr->child_process_handler;
     tp->free_handler = tpattr->free_handler;
     tp->max = tpattr->max;
+    tp->min = tpattr->min > tpattr->max? tpattr->max: tpattr->min;
 #ifdef MLN_USE_UNIX98
     if (tpattr->concurrency) pthread_setconcurrency(tpattr->concurrency);
 #endif
@@ -206,7 +261,24 @@ mln_thread_pool_new(struct mln_thread_pool_attr *tpattr, int *err)
         return NULL;
     }
 #endif
+    if (tp->steal) {
+        mln_u32_t i;
+        if ((tp->deques = (mln_thread_pool_deque_t *)calloc(tpattr->max, sizeof(mln_thread_pool_deque_t))) == NULL) {
+            pthread_attr_destroy(&(tp->attr));
+            pthread_cond_destroy(&(tp->cond));
+            pthread_mutex_destroy(&(tp->mutex));
+            free(tp);
+            *err = ENOMEM;
+            return NULL;
+        }
+        tp->n_deques = tpattr->max;
+        for (i = 0; i < tp->n_deques; ++i) {
+            mln_spin_init(&(tp->deques[i].lock));
+            tp->deques[i].head = tp->deques[i].tail = NULL;
+        }
+    }
     if ((m_thread_pool_self = mln_thread_pool_member_join(tp, 0)) == NULL) {
+        if (tp->deques != NULL) free(tp->deques);
         pthread_attr_destroy(&(tp->attr));
         pthread_cond_destroy(&(tp->cond));
         pthread_mutex_destroy(&(tp->mutex));
@@ -224,9 +296,23 @@ static void mln_thread_pool_free(mln_thread_pool_t *tp)
     mln_thread_pool_resource_t *tpr;
     while ((tpr = tp->res_chain_head) != NULL) {
         tp->res_chain_head = tp->res_chain_head->next;
+        if (tpr->future != NULL) mln_thread_pool_future_complete(tpr->future, -1);
         if (tp->free_handler != NULL) tp->free_handler(tpr->data);
         free(tpr);
     }
+    if (tp->deques != NULL) {
+        mln_u32_t i;
+        for (i = 0; i < tp->n_deques; ++i) {
+            while ((tpr = tp->deques[i].head) != NULL) {
+                tp->deques[i].head = tpr->next;
+                if (tpr->future != NULL) mln_thread_pool_future_complete(tpr->future, -1);
+                if (tp->free_handler != NULL) tp->free_handler(tpr->data);
+                free(tpr);
+            }
+            mln_spin_destroy(&(tp->deques[i].lock));
+        }
+        free(tp->deques);
+    }
     ASSERT(tp->child_head == NULL && !tp->counter && !tp->idle);
     pthread_mutex_destroy(&(tp->mutex));
     pthread_cond_destroy(&(tp->cond));
@@ -236,23 +322,101 @@ static void mln_thread_pool_free(mln_thread_pool_t *tp)
 
 
 /*
- * resource
+ * future
  */
-int mln_thread_pool_resource_add(void *data)
+mln_thread_pool_future_t *mln_thread_pool_future_new(void)
 {
-    /*
-     * Only main thread can call this function
-     */
-    ASSERT(m_thread_pool_self != NULL);
+    mln_thread_pool_future_t *f;
+    if ((f = (mln_thread_pool_future_t *)malloc(sizeof(mln_thread_pool_future_t))) == NULL) {
+        return NULL;
+    }
+    if (pthread_mutex_init(&(f->mutex), NULL) != 0) {
+        free(f);
+        return NULL;
+    }
+    if (pthread_cond_init(&(f->cond), NULL) != 0) {
+        pthread_mutex_destroy(&(f->mutex));
+        free(f);
+        return NULL;
+    }
+    f->rc = 0;
+    f->done = 0;
+    return f;
+}
 
-    mln_thread_pool_resource_t *tpr;
+void mln_thread_pool_future_free(mln_thread_pool_future_t *future)
+{
+    if (future == NULL) return;
+    pthread_cond_destroy(&(future->cond));
+    pthread_mutex_destroy(&(future->mutex));
+    free(future);
+}
+
+static inline void
+mln_thread_pool_future_reset(mln_thread_pool_future_t *future)
+{
+    pthread_mutex_lock(&(future->mutex));
+    future->rc = 0;
+    future->done = 0;
+    pthread_mutex_unlock(&(future->mutex));
+}
+
+static inline void
+mln_thread_pool_future_complete(mln_thread_pool_future_t *future, int rc)
+{
+    pthread_mutex_lock(&(future->mutex));
+    future->rc = rc;
+    future->done = 1;
+    pthread_cond_broadcast(&(future->cond));
+    pthread_mutex_unlock(&(future->mutex));
+}
+
+int mln_thread_pool_future_wait(mln_thread_pool_future_t *future)
+{
+    int rc;
+    pthread_mutex_lock(&(future->mutex));
+    while (!future->done)
+        pthread_cond_wait(&(future->cond), &(future->mutex));
+    rc = future->rc;
+    pthread_mutex_unlock(&(future->mutex));
+    return rc;
+}
+
+int mln_thread_pool_future_try(mln_thread_pool_future_t *future, int *rc)
+{
+    int done;
+    pthread_mutex_lock(&(future->mutex));
+    if ((done = future->done) && rc != NULL)
+        *rc = future->rc;
+    pthread_mutex_unlock(&(future->mutex));
+    return done? 0: -1;
+}
+
+/*
+ * resource
+ */
+static int mln_thread_pool_resource_add_prepared(mln_thread_pool_resource_t *tpr)
+{
     mln_thread_pool_t *tpool = m_thread_pool_self->pool;
 
-    if ((tpr = (mln_thread_pool_resource_t *)malloc(sizeof(mln_thread_pool_resource_t))) == NULL) {
-        return ENOMEM;
+    if (tpool->steal) {
+        /*
+         * Round-robin over the deques; the cursor is private to the
+         * main thread, which is the only legal submitter anyway.
+         * Sleeping workers are only poked when some really exist, so
+         * the pool mutex stays out of the saturated fast path.
+         */
+        mln_thread_pool_deque_push(&(tpool->deques[(tpool->rr)++ % tpool->n_deques]), tpr);
+        __atomic_add_fetch(&(tpool->n_res), 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&(tpool->idle), __ATOMIC_SEQ_CST) > 1) {
+            m_thread_pool_self->locked = 1;
+            pthread_mutex_lock(&(tpool->mutex));
+            pthread_cond_signal(&(tpool->cond));
+            pthread_mutex_unlock(&(tpool->mutex));
+            m_thread_pool_self->locked = 0;
+        }
+        return 0;
     }
-    tpr->data = data;
-    tpr->next = NULL;
 
     m_thread_pool_self->locked = 1;
     pthread_mutex_lock(&(tpool->mutex));
@@ -265,7 +429,10 @@ int mln_thread_pool_resource_add(void *data)
     }
     ++(tpool->n_res);
 
-    if (tpool->idle <= 1 && tpool->counter < tpool->max+1) {
+    if ((tpool->idle <= 1 || \
+         (tpool->spawn_threshold && tpool->n_res >= tpool->spawn_threshold)) && \
+        tpool->counter < tpool->max+1)
+    {
         int rc;
         pthread_t threadid;
         mln_thread_pool_member_t *tpm;
@@ -279,6 +446,7 @@ int mln_thread_pool_resource_add(void *data)
             m_thread_pool_self->locked = 0;
             return rc;
         }
+        ++(tpool->spawned);
     }
     pthread_cond_signal(&(tpool->cond));
 
@@ -287,6 +455,136 @@ int mln_thread_pool_resource_add(void *data)
     return 0;
 }
 
+int mln_thread_pool_resource_add(void *data)
+{
+    /*
+     * Only main thread can call this function
+     */
+    ASSERT(m_thread_pool_self != NULL);
+
+    mln_thread_pool_resource_t *tpr;
+
+    if ((tpr = (mln_thread_pool_resource_t *)malloc(sizeof(mln_thread_pool_resource_t))) == NULL) {
+        return ENOMEM;
+    }
+    tpr->data = data;
+    tpr->future = NULL;
+    tpr->prev = tpr->next = NULL;
+    return mln_thread_pool_resource_add_prepared(tpr);
+}
+
+int mln_thread_pool_resource_add_future(void *data, mln_thread_pool_future_t *future)
+{
+    /*
+     * Only main thread can call this function
+     */
+    ASSERT(m_thread_pool_self != NULL);
+
+    mln_thread_pool_resource_t *tpr;
+
+    if ((tpr = (mln_thread_pool_resource_t *)malloc(sizeof(mln_thread_pool_resource_t))) == NULL) {
+        return ENOMEM;
+    }
+    mln_thread_pool_future_reset(future);
+    tpr->data = data;
+    tpr->future = future;
+    tpr->prev = tpr->next = NULL;
+    return mln_thread_pool_resource_add_prepared(tpr);
+}
+
+int mln_thread_pool_resource_batch_add(void **datas, mln_thread_pool_future_t **futures, mln_size_t n)
+{
+    /*
+     * Only main thread can call this function
+     */
+    ASSERT(m_thread_pool_self != NULL);
+
+    mln_size_t i;
+    mln_thread_pool_resource_t *tpr, *head = NULL, *tail = NULL;
+    mln_thread_pool_t *tpool = m_thread_pool_self->pool;
+
+    if (!n) return 0;
+
+    for (i = 0; i < n; ++i) {
+        if ((tpr = (mln_thread_pool_resource_t *)malloc(sizeof(mln_thread_pool_resource_t))) == NULL) {
+            while ((tpr = head) != NULL) {
+                head = head->next;
+                free(tpr);
+            }
+            return ENOMEM;
+        }
+        tpr->data = datas[i];
+        tpr->future = futures == NULL? NULL: futures[i];
+        if (tpr->future != NULL) mln_thread_pool_future_reset(tpr->future);
+        tpr->prev = tpr->next = NULL;
+        if (head == NULL) head = tail = tpr;
+        else tail = tail->next = tpr;
+    }
+
+    if (tpool->steal) {
+        /*
+         * Stripe the batch over the deques in blocks, one lock hold
+         * per deque, then wake every sleeper at once.
+         */
+        mln_u32_t k = tpool->n_deques;
+        mln_size_t per = (n + k - 1) / k;
+        while (head != NULL) {
+            mln_thread_pool_deque_t *d = &(tpool->deques[(tpool->rr)++ % k]);
+            mln_spin_lock(&(d->lock));
+            for (i = 0; i < per && head != NULL; ++i) {
+                tpr = head;
+                head = head->next;
+                mln_res_chain_add(&(d->head), &(d->tail), tpr);
+            }
+            mln_spin_unlock(&(d->lock));
+        }
+        __atomic_add_fetch(&(tpool->n_res), n, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&(tpool->idle), __ATOMIC_SEQ_CST) > 1) {
+            m_thread_pool_self->locked = 1;
+            pthread_mutex_lock(&(tpool->mutex));
+            pthread_cond_broadcast(&(tpool->cond));
+            pthread_mutex_unlock(&(tpool->mutex));
+            m_thread_pool_self->locked = 0;
+        }
+        return 0;
+    }
+
+    m_thread_pool_self->locked = 1;
+    pthread_mutex_lock(&(tpool->mutex));
+
+    if (tpool->res_chain_head == NULL) {
+        tpool->res_chain_head = head;
+    } else {
+        tpool->res_chain_tail->next = head;
+    }
+    tpool->res_chain_tail = tail;
+    tpool->n_res += n;
+
+    /* make sure enough workers exist to drain the whole batch */
+    {
+        mln_u32_t spawned = 0, idle0 = tpool->idle;
+        pthread_t threadid;
+        mln_thread_pool_member_t *tpm;
+        while (tpool->counter < tpool->max+1 && (mln_size_t)(idle0 - 1 + spawned) < n) {
+            if ((tpm = mln_thread_pool_member_join(tpool, 1)) == NULL) break;
+            if (pthread_create(&threadid, &(tpool->attr), child_thread_launcher, tpm) != 0) {
+                mln_child_chain_del(&(tpool->child_head), &(tpool->child_tail), tpm);
+                --(tpool->counter);
+                --(tpool->idle);
+                free(tpm);
+                break;
+            }
+            ++spawned;
+            ++(tpool->spawned);
+        }
+    }
+    pthread_cond_broadcast(&(tpool->cond));
+
+    pthread_mutex_unlock(&(tpool->mutex));
+    m_thread_pool_self->locked = 0;
+    return 0;
+}
+
 static void *mln_thread_pool_resource_remove(void)
 {
     /*
@@ -303,8 +601,15 @@ again:
     if (tpool->res_chain_head == NULL) tpool->res_chain_tail = NULL;
     --(tpool->n_res);
     m_thread_pool_self->data = tpr->data;
+    m_thread_pool_self->future = tpr->future;
     free(tpr);
-    if (m_thread_pool_self->data == NULL) goto again;
+    if (m_thread_pool_self->data == NULL) {
+        if (m_thread_pool_self->future != NULL) {
+            mln_thread_pool_future_complete(m_thread_pool_self->future, 0);
+            m_thread_pool_self->future = NULL;
+        }
+        goto again;
+    }
 
     m_thread_pool_self->idle = 0;
     --(tpool->idle);
@@ -328,6 +633,54 @@ int mln_thread_pool_run(struct mln_thread_pool_attr *tpattr)
     if ((tpool = mln_thread_pool_new(tpattr, &rc)) == NULL) {
         return rc;
     }
+    if (tpool->steal) {
+        /*
+         * All workers are started up front so every deque has its
+         * owner; submission never spawns threads in this mode.
+         */
+        mln_u32_t i;
+        pthread_t threadid;
+        mln_thread_pool_member_t *tpm;
+        m_thread_pool_self->locked = 1;
+        pthread_mutex_lock(&(tpool->mutex));
+        for (i = 0; i < tpool->n_deques; ++i) {
+            if ((tpm = mln_thread_pool_member_join(tpool, 1)) == NULL) break;
+            tpm->deque = &(tpool->deques[i]);
+            if (pthread_create(&threadid, &(tpool->attr), child_thread_launcher, tpm) != 0) {
+                mln_child_chain_del(&(tpool->child_head), &(tpool->child_tail), tpm);
+                --(tpool->counter);
+                --(tpool->idle);
+                free(tpm);
+                break;
+            }
+            ++(tpool->spawned);
+        }
+        pthread_mutex_unlock(&(tpool->mutex));
+        m_thread_pool_self->locked = 0;
+    } else if (tpool->min) {
+        /*
+         * The permanent part of the pool is started before any work
+         * arrives; submission only spawns the elastic part above 'min'.
+         */
+        mln_u32_t i;
+        pthread_t threadid;
+        mln_thread_pool_member_t *tpm;
+        m_thread_pool_self->locked = 1;
+        pthread_mutex_lock(&(tpool->mutex));
+        for (i = 0; i < tpool->min; ++i) {
+            if ((tpm = mln_thread_pool_member_join(tpool, 1)) == NULL) break;
+            if (pthread_create(&threadid, &(tpool->attr), child_thread_launcher, tpm) != 0) {
+                mln_child_chain_del(&(tpool->child_head), &(tpool->child_tail), tpm);
+                --(tpool->counter);
+                --(tpool->idle);
+                free(tpm);
+                break;
+            }
+            ++(tpool->spawned);
+        }
+        pthread_mutex_unlock(&(tpool->mutex));
+        m_thread_pool_self->locked = 0;
+    }
     rc = tpattr->main_process_handler(tpattr->main_data);
     tpool->quit = 1;
     while (1) {
@@ -349,6 +702,76 @@ int mln_thread_pool_run(struct mln_thread_pool_attr *tpattr)
     return rc;
 }
 
+static mln_sptr_t mln_thread_pool_steal_loop(mln_thread_pool_member_t *tpm)
+{
+    mln_sptr_t rc = 0;
+    struct timespec ts;
+    mln_u32_t i, n, base;
+    mln_thread_pool_t *tpool = tpm->pool;
+    mln_thread_pool_deque_t *d = tpm->deque;
+    mln_thread_pool_resource_t *tpr;
+
+    tpm->locked = 1;
+    pthread_mutex_lock(&(tpool->mutex));
+    tpm->idle = 0;
+    __atomic_sub_fetch(&(tpool->idle), 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&(tpool->mutex));
+    tpm->locked = 0;
+
+    base = (mln_u32_t)(d - tpool->deques);
+    n = tpool->n_deques;
+    while (1) {
+        if ((tpr = mln_thread_pool_deque_pop(d)) == NULL) {
+            /*run dry, sweep the siblings' tails*/
+            for (i = 1; i < n; ++i) {
+                if ((tpr = mln_thread_pool_deque_steal(&(tpool->deques[(base + i) % n]))) != NULL)
+                    break;
+            }
+        }
+        if (tpr != NULL) {
+            __atomic_sub_fetch(&(tpool->n_res), 1, __ATOMIC_SEQ_CST);
+            tpm->data = tpr->data;
+            tpm->future = tpr->future;
+            free(tpr);
+            if (tpm->data == NULL) {
+                if (tpm->future != NULL) {
+                    mln_thread_pool_future_complete(tpm->future, 0);
+                    tpm->future = NULL;
+                }
+                continue;
+            }
+            rc = tpool->process_handler(tpm->data);
+            tpm->data = NULL;
+            if (tpm->future != NULL) {
+                mln_thread_pool_future_complete(tpm->future, (int)rc);
+                tpm->future = NULL;
+            }
+            continue;
+        }
+        if (tpool->quit) break;
+
+        /*
+         * Register as a sleeper before the last emptiness check, so a
+         * submission racing with us either sees the sleeper or is seen
+         * here; the timed wait bounds anything slipping through.
+         */
+        tpm->locked = 1;
+        pthread_mutex_lock(&(tpool->mutex));
+        tpm->idle = 1;
+        __atomic_add_fetch(&(tpool->idle), 1, __ATOMIC_SEQ_CST);
+        if (!tpool->quit && __atomic_load_n(&(tpool->n_res), __ATOMIC_SEQ_CST) == 0) {
+            ts.tv_sec = time(NULL) + tpool->cond_timeout / 1000;
+            ts.tv_nsec = (tpool->cond_timeout % 1000) * 1000000;
+            pthread_cond_timedwait(&(tpool->cond), &(tpool->mutex), &ts);
+        }
+        tpm->idle = 0;
+        __atomic_sub_fetch(&(tpool->idle), 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&(tpool->mutex));
+        tpm->locked = 0;
+    }
+    return rc;
+}
+
 static void *child_thread_launcher(void *arg)
 {
     mln_sptr_t rc = 0;
@@ -357,12 +780,15 @@ static void *child_thread_launcher(void *arg)
 
     struct timespec ts;
     mln_u32_t timeout = 0;
+    mln_u64_t idled = 0;/*ms spent waiting since the last resource*/
     mln_thread_pool_member_t *tpm = (mln_thread_pool_member_t *)arg;
     mln_thread_pool_t *tpool = tpm->pool;
 
     m_thread_pool_self = tpm;
 
-    while (1) {
+    if (tpool->steal) {
+        rc = mln_thread_pool_steal_loop(tpm);
+    } else while (1) {
         tpm->locked = 1;
         pthread_mutex_lock(&(tpool->mutex));
 
@@ -374,18 +800,28 @@ again:
         if (tpool->quit) break;
 
         if (mln_thread_pool_resource_remove() == NULL) {
-            if (timeout) break;
+            /*
+             * A worker only retires once it has been quiet for
+             * idle_timeout (at least one whole cond_timeout) and the
+             * pool would still hold min children without it.
+             */
+            if (timeout && idled >= tpool->idle_timeout && tpool->counter - 1 > tpool->min) {
+                ++(tpool->retired);
+                break;
+            }
 
             ts.tv_sec = time(NULL) + tpool->cond_timeout / 1000;
             ts.tv_nsec = (tpool->cond_timeout % 1000) * 1000000;
             if ((rc = pthread_cond_timedwait(&(tpool->cond), &(tpool->mutex), &ts)) != 0) {
                 if (rc == ETIMEDOUT) {
                     timeout = 1;
+                    idled += tpool->cond_timeout;
                     goto again;
                 }
                 break;
             } else {
                 timeout = 0;
+                idled = 0;
                 goto again;
             }
         }
@@ -393,8 +829,13 @@ again:
         pthread_mutex_unlock(&(tpool->mutex));
         tpm->locked = 0;
         timeout = 0;
+        idled = 0;
         rc = tpool->process_handler(tpm->data);
         tpm->data = NULL;
+        if (tpm->future != NULL) {
+            mln_thread_pool_future_complete(tpm->future, (int)rc);
+            tpm->future = NULL;
+        }
     }
 
     forked = m_thread_pool_self->forked;
@@ -426,9 +867,13 @@ void mln_thread_resource_info(struct mln_thread_pool_info *info)
     m_thread_pool_self->locked = 1;
     pthread_mutex_lock(&(tpool->mutex));
     info->max_num = tpool->max;
+    info->min_num = tpool->min;
     info->idle_num = tpool->idle;
     info->cur_num = tpool->counter;
-    info->res_num = tpool->n_res;
+    info->res_num = tpool->steal? \
+        (mln_size_t)__atomic_load_n(&(tpool->n_res), __ATOMIC_SEQ_CST): tpool->n_res;
+    info->spawned = tpool->spawned;
+    info->retired = tpool->retired;
     pthread_mutex_unlock(&(tpool->mutex));
     m_thread_pool_self->locked = 0;
 }
@@ -438,4 +883,9 @@ MLN_CHAIN_FUNC_DEFINE(mln_child, \
                       static inline void, \
                       prev, \
                       next);
+MLN_CHAIN_FUNC_DEFINE(mln_res, \
+                      mln_thread_pool_resource_t, \
+                      static inline void, \
+                      prev, \
+                      next);
 
@@ -3,8 +3,12 @@
  * Copyright (C) Niklaus F.Schen.
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /*for mremap*/
+#endif
 #if !defined(WIN32)
 #include <sys/resource.h>
+#include <sys/mman.h>
 #include <pwd.h>
 #endif
 #include <string.h>
@@ -48,6 +52,8 @@ mln_boot_t boot_params[] = {
 char mln_core_file_cmd[] = "core_file_size";
 char mln_nofile_cmd[] = "max_nofile";
 char mln_limit_unlimited[] = "unlimited";
+char mln_hot_text_cmd[] = "hot_text_hugepage";
+char mln_prefault_cmd[] = "prefault_data";
 
 int mln_sys_limit_modify(void)
 {
@@ -143,6 +149,155 @@ static int mln_sys_nofile_modify(void)
     return 0;
 }
 
+static int mln_sys_layout_switch(mln_conf_domain_t *cd, char *cmd, int *on)
+{
+    mln_conf_cmd_t *cc = cd->search(cd, cmd);
+    if (cc == NULL) return 0;
+
+    mln_conf_item_t *ci = cc->search(cc, 1);
+    if (ci == NULL || ci->type != CONF_BOOL) {
+        fprintf(stderr, "Invalid argument of %s.\n", cmd);
+        return -1;
+    }
+    *on = ci->val.b? 1: 0;
+    return 0;
+}
+
+#if defined(__linux__)
+#define M_TOOLS_HUGE_SIZE    ((unsigned long)(2*1024*1024))
+#define M_TOOLS_REGION_MAX   64
+#define M_TOOLS_PREFAULT_CAP ((unsigned long)(256*1024*1024))
+
+typedef struct {
+    unsigned long start;
+    unsigned long end;
+} mln_layout_region_t;
+
+/*
+ * Collect regions from /proc/self/maps whose permissions equal 'perms'.
+ * With 'self_text' set only segments of the running binary and of
+ * libmelon are taken; otherwise pseudo mappings ([stack], [vdso], ...)
+ * are skipped. Remapping mutates the maps file, so regions are gathered
+ * completely before the caller touches any of them.
+ */
+static int
+mln_layout_regions_collect(mln_layout_region_t *regions, char *perms, int self_text)
+{
+    FILE *fp;
+    int n = 0, cnt;
+    char line[512], p[8], path[256], exe[256];
+    unsigned long start, end;
+    ssize_t len;
+
+    if ((len = readlink("/proc/self/exe", exe, sizeof(exe)-1)) < 0) len = 0;
+    exe[len] = 0;
+
+    if ((fp = fopen("/proc/self/maps", "r")) == NULL) return 0;
+    while (n < M_TOOLS_REGION_MAX && fgets(line, sizeof(line), fp) != NULL) {
+        path[0] = 0;
+        cnt = sscanf(line, "%lx-%lx %7s %*s %*s %*s %255s", &start, &end, p, path);
+        if (cnt < 3 || strcmp(p, perms)) continue;
+        if (self_text) {
+            if (cnt < 4 || (strcmp(path, exe) && strstr(path, "libmelon") == NULL))
+                continue;
+        } else {
+            if (cnt >= 4 && path[0] == '[') continue;
+            if (end - start > M_TOOLS_PREFAULT_CAP) continue;
+        }
+        regions[n].start = start;
+        regions[n].end = end;
+        ++n;
+    }
+    fclose(fp);
+    return n;
+}
+
+/*
+ * Move the 2MB-aligned window inside [start,end) onto anonymous memory
+ * advised for huge pages. The text is copied aside, made executable and
+ * slid back over itself with one mremap(); no user instruction runs
+ * during the syscall, so the function may relocate the very segment it
+ * executes from.
+ */
+static int mln_layout_text_remap(unsigned long start, unsigned long end)
+{
+    unsigned long astart = (start + M_TOOLS_HUGE_SIZE - 1) & ~(M_TOOLS_HUGE_SIZE - 1);
+    unsigned long aend = end & ~(M_TOOLS_HUGE_SIZE - 1);
+    unsigned long len = aend - astart;
+    void *buf;
+
+    if (aend <= astart) return 0;
+
+    buf = mmap(NULL, len, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED) return -1;
+#if defined(MADV_HUGEPAGE)
+    madvise(buf, len, MADV_HUGEPAGE);
+#endif
+    memcpy(buf, (void *)astart, len);
+    if (mprotect(buf, len, PROT_READ|PROT_EXEC) < 0) {
+        munmap(buf, len);
+        return -1;
+    }
+    if (mremap(buf, len, len, MREMAP_MAYMOVE|MREMAP_FIXED, (void *)astart) == MAP_FAILED) {
+        munmap(buf, len);
+        return -1;
+    }
+#if defined(MADV_COLLAPSE)
+    madvise((void *)astart, len, MADV_COLLAPSE);/*synchronous when supported, else khugepaged*/
+#endif
+    return 0;
+}
+
+static void mln_layout_data_prefault(void)
+{
+    mln_layout_region_t regions[M_TOOLS_REGION_MAX];
+    int n, i;
+    volatile unsigned char c;
+    unsigned long p;
+
+    n = mln_layout_regions_collect(regions, "rw-p", 0);
+    for (i = 0; i < n; ++i) {
+        for (p = regions[i].start; p < regions[i].end; p += 4096) {
+            c = *(volatile unsigned char *)p;
+        }
+    }
+    (void)c;
+}
+#endif
+
+int mln_sys_layout_modify(void)
+{
+    int text = 0, data = 0;
+
+    mln_conf_t *cf = mln_conf();
+    if (cf == NULL) {
+        fprintf(stderr, "Configuration messed up.\n");
+        return -1;
+    }
+    mln_conf_domain_t *cd = cf->search(cf, "main");
+    if (cd == NULL) {
+        fprintf(stderr, "Configuration messed up.\n");
+        return -1;
+    }
+    if (mln_sys_layout_switch(cd, mln_hot_text_cmd, &text) < 0) return -1;
+    if (mln_sys_layout_switch(cd, mln_prefault_cmd, &data) < 0) return -1;
+
+#if defined(__linux__)
+    if (text) {
+        mln_layout_region_t regions[M_TOOLS_REGION_MAX];
+        int n, i;
+        n = mln_layout_regions_collect(regions, "r-xp", 1);
+        for (i = 0; i < n; ++i) {
+            (void)mln_layout_text_remap(regions[i].start, regions[i].end);
+        }
+    }
+    if (data) mln_layout_data_prefault();
+#else
+    (void)text; (void)data;
+#endif
+    return 0;
+}
+
 #if !defined(WIN32)
 int mln_daemon(void)
 {
@@ -93,7 +93,7 @@ void mln_trace_finalize(void)
 
 static void mln_trace_lang_check(mln_event_t *ev, void *data)
 {
-    if (trace_lang != NULL && trace_lang->run_head == NULL && trace_lang->wait_head == NULL) {
+    if (trace_lang != NULL && mln_lang_task_empty(trace_lang)) {
         mln_lang_free(trace_lang);
         trace_lang = NULL;
         trace_ctx = NULL;
@@ -130,3 +130,172 @@ int mln_trace_recv_handler_set(mln_lang_ctx_pipe_recv_cb_t recv_handler)
     return mln_lang_ctx_pipe_recv_handler_set(trace_ctx, recv_handler);
 }
 
+
+/*
+ * Fast-path trace points: per-thread rings of binary records, drained
+ * in batches by a timer on the event loop and piped to the trace
+ * script as binary strings. Each ring is single-producer (its thread)
+ * single-consumer (the flush timer), so record traffic needs no lock;
+ * only first-use registration pushes onto the global ring list.
+ */
+#include <stdarg.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#define M_TRACE_FAST_BATCH 256
+#define M_TRACE_FAST_FLUSH_MSEC 10
+
+typedef struct mln_trace_ring_s {
+    mln_trace_record_t      *records;
+    volatile mln_u64_t       head;
+    volatile mln_u64_t       tail;
+    mln_u64_t                size;
+    mln_u64_t                drops;
+    mln_u64_t                tid;
+    struct mln_trace_ring_s *next;
+} mln_trace_ring_t;
+
+static mln_trace_ring_t *trace_rings = NULL;
+static __thread mln_trace_ring_t *trace_ring_self = NULL;
+static __thread mln_u32_t trace_countdown = 1;
+static mln_u32_t trace_sample = 1;
+static mln_u32_t trace_ring_size = 0;
+static mln_u32_t trace_fast_stop = 0;
+
+static void mln_trace_fast_flush_handler(mln_event_t *ev, void *data);
+
+static mln_trace_ring_t *mln_trace_ring_new(void)
+{
+    mln_trace_ring_t *r, *head;
+
+    r = (mln_trace_ring_t *)malloc(sizeof(mln_trace_ring_t) + trace_ring_size * sizeof(mln_trace_record_t));
+    if (r == NULL) return NULL;
+    r->records = (mln_trace_record_t *)(r + 1);
+    r->head = r->tail = 0;
+    r->size = trace_ring_size;
+    r->drops = 0;
+    r->tid = (mln_u64_t)pthread_self();
+    do {
+        head = __atomic_load_n(&trace_rings, __ATOMIC_ACQUIRE);
+        r->next = head;
+    } while (!__atomic_compare_exchange_n(&trace_rings, &head, r, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    trace_ring_self = r;
+    return r;
+}
+
+int mln_trace_fast_init(mln_event_t *ev, mln_u32_t nrecord, mln_u32_t sample)
+{
+    mln_u32_t size;
+
+    if (trace_ring_size) return -1;
+    if (nrecord < M_TRACE_FAST_BATCH) nrecord = M_TRACE_FAST_BATCH;
+    for (size = 1; size < nrecord; size <<= 1)
+        ;
+    trace_sample = sample? sample: 1;
+    trace_fast_stop = 0;
+    if (mln_event_timer_set(ev, M_TRACE_FAST_FLUSH_MSEC, NULL, mln_trace_fast_flush_handler) == NULL)
+        return -1;
+    trace_ring_size = size;
+    return 0;
+}
+
+int mln_trace_fast_emit(mln_u32_t point, mln_u32_t nargs, mln_s64_t a1, mln_s64_t a2, mln_s64_t a3, mln_s64_t a4)
+{
+    mln_trace_ring_t *r;
+    mln_trace_record_t *rec;
+    mln_u64_t head;
+    struct timeval tv;
+
+    if (!trace_ring_size) return 0;
+    if (--trace_countdown) return 0;
+    trace_countdown = trace_sample;
+
+    if ((r = trace_ring_self) == NULL && (r = mln_trace_ring_new()) == NULL)
+        return -1;
+    head = r->head;
+    if (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >= r->size) {
+        ++r->drops;
+        return -1;
+    }
+    rec = &r->records[head & (r->size - 1)];
+    gettimeofday(&tv, NULL);
+    rec->time = (mln_u64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    rec->tid = r->tid;
+    rec->point = point;
+    rec->nargs = nargs > 4? 4: nargs;
+    rec->args[0] = a1;
+    rec->args[1] = a2;
+    rec->args[2] = a3;
+    rec->args[3] = a4;
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void mln_trace_fast_sample_set(mln_u32_t sample)
+{
+    trace_sample = sample? sample: 1;
+}
+
+mln_size_t mln_trace_fast_flush(void)
+{
+    static mln_trace_record_t batch[M_TRACE_FAST_BATCH];
+    mln_trace_ring_t *r;
+    mln_string_t msg;
+    mln_u64_t head, tail, n, i;
+    mln_size_t sent = 0;
+
+    for (r = __atomic_load_n(&trace_rings, __ATOMIC_ACQUIRE); r != NULL; r = r->next) {
+        while (1) {
+            tail = r->tail;
+            head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+            if (head == tail) break;
+            n = head - tail;
+            if (n > M_TRACE_FAST_BATCH) n = M_TRACE_FAST_BATCH;
+            for (i = 0; i < n; ++i)
+                batch[i] = r->records[(tail + i) & (r->size - 1)];
+            __atomic_store_n(&r->tail, tail + n, __ATOMIC_RELEASE);
+            sent += n;
+            if (trace_ctx != NULL) {
+                msg.data = (mln_u8ptr_t)batch;
+                msg.len = n * sizeof(mln_trace_record_t);
+                msg.data_ref = 1;
+                msg.pool = 0;
+                msg.ref = 1;
+                mln_lang_ctx_pipe_send(trace_ctx, "S", &msg);
+            }
+        }
+    }
+    return sent;
+}
+
+mln_u64_t mln_trace_fast_drops(void)
+{
+    mln_trace_ring_t *r;
+    mln_u64_t drops = 0;
+
+    for (r = __atomic_load_n(&trace_rings, __ATOMIC_ACQUIRE); r != NULL; r = r->next)
+        drops += r->drops;
+    return drops;
+}
+
+static void mln_trace_fast_flush_handler(mln_event_t *ev, void *data)
+{
+    if (trace_fast_stop) return;
+    mln_trace_fast_flush();
+    if (mln_event_timer_set(ev, M_TRACE_FAST_FLUSH_MSEC, NULL, mln_trace_fast_flush_handler) == NULL)
+        trace_fast_stop = 1;
+}
+
+void mln_trace_fast_finalize(void)
+{
+    mln_trace_ring_t *r, *next;
+
+    trace_fast_stop = 1;
+    trace_ring_size = 0;
+    for (r = trace_rings; r != NULL; r = next) {
+        next = r->next;
+        free(r);
+    }
+    trace_rings = NULL;
+    trace_ring_self = NULL;
+}
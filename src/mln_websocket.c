@@ -6,6 +6,8 @@
 #include <stdio.h>
 #include <sys/time.h>
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 #include "mln_websocket.h"
 #include "mln_regexp.h"
 #include "mln_sha.h"
@@ -21,6 +23,8 @@ static mln_string_t *mln_websocket_accept_field(mln_http_t *http);
 static int mln_websocket_iterate_set_fields(void *key, void *val, void *data);
 static mln_string_t *mln_websocket_client_handshake_key_generate(mln_alloc_t *pool);
 static mln_string_t *mln_websocket_extension_tokens(mln_alloc_t *pool, mln_string_t *in);
+static int mln_websocket_strcasestr(mln_string_t *s, char *needle);
+static int mln_websocket_deflate_out(mln_websocket_t *ws);
 static mln_u32_t mln_websocket_masking_key_generate(void);
 
 int mln_websocket_init(mln_websocket_t *ws, mln_http_t *http)
@@ -46,14 +50,20 @@ int mln_websocket_init(mln_websocket_t *ws, mln_http_t *http)
     ws->data = NULL;
     ws->content = NULL;
     ws->extension_handler = NULL;
+    ws->deflate_enc = ws->deflate_dec = NULL;
     ws->content_len = 0;
     ws->content_free = 0;
+    ws->deflate = 0;
     ws->fin = 0;
     ws->rsv1 = ws->rsv2 = ws->rsv3 = 0;
     ws->opcode = 0;
     ws->mask = 0;
     ws->status = 0;
     ws->masking_key = 0;
+    ws->reassemble = 0;
+    ws->msg_opcode = 0;
+    ws->msg_head = ws->msg_tail = NULL;
+    ws->msg_len = 0;
 
     return 0;
 }
@@ -101,6 +111,9 @@ void mln_websocket_destroy(mln_websocket_t *ws)
     if (ws->args != NULL) mln_string_free(ws->args);
     if (ws->key != NULL) mln_string_free(ws->key);
     if (ws->content_free) mln_alloc_free(ws->content);
+    if (ws->msg_head != NULL) mln_chain_pool_release_all(ws->msg_head);
+    if (ws->deflate_enc != NULL) mln_deflate_free(ws->deflate_enc);
+    if (ws->deflate_dec != NULL) mln_deflate_free(ws->deflate_dec);
 }
 
 void mln_websocket_free(mln_websocket_t *ws)
@@ -137,6 +150,15 @@ void mln_websocket_reset(mln_websocket_t *ws)
         ws->content = NULL;
     }
     ws->extension_handler = NULL;
+    if (ws->deflate_enc != NULL) {
+        mln_deflate_free(ws->deflate_enc);
+        ws->deflate_enc = NULL;
+    }
+    if (ws->deflate_dec != NULL) {
+        mln_deflate_free(ws->deflate_dec);
+        ws->deflate_dec = NULL;
+    }
+    ws->deflate = 0;
     ws->content_len = 0;
     ws->fin = 0;
     ws->rsv1 = ws->rsv2 = ws->rsv3 = 0;
@@ -144,6 +166,13 @@ void mln_websocket_reset(mln_websocket_t *ws)
     ws->mask = 0;
     ws->status = 0;
     ws->masking_key = 0;
+    ws->reassemble = 0;
+    ws->msg_opcode = 0;
+    if (ws->msg_head != NULL) {
+        mln_chain_pool_release_all(ws->msg_head);
+        ws->msg_head = ws->msg_tail = NULL;
+    }
+    ws->msg_len = 0;
 }
 
 
@@ -175,6 +204,18 @@ int mln_websocket_validate(mln_websocket_t *ws)
     if (ret != M_WS_RET_OK) return ret;
     if (mln_http_type_get(http) != M_HTTP_RESPONSE) return M_WS_RET_ERROR;
 
+    if (ws->deflate && ws->deflate_enc == NULL) {
+        mln_string_t ext_key = mln_string("Sec-WebSocket-Extensions");
+        tmp = mln_http_field_get(http, &ext_key);
+        if (tmp != NULL && mln_websocket_strcasestr(tmp, "permessage-deflate") >= 0) {
+            int client_nct = mln_websocket_strcasestr(tmp, "client_no_context_takeover") >= 0;
+            int server_nct = mln_websocket_strcasestr(tmp, "server_no_context_takeover") >= 0;
+            ws->deflate_enc = mln_deflate_new(ws->pool, !client_nct);
+            ws->deflate_dec = mln_deflate_new(ws->pool, !server_nct);
+            if (ws->deflate_enc == NULL || ws->deflate_dec == NULL) return M_WS_RET_ERROR;
+        }
+    }
+
     return M_WS_RET_OK;
 }
 
@@ -241,6 +282,20 @@ static int mln_websocket_match_iterate_handler(void *key, void *val, void *data)
     return 0;
 }
 
+static int mln_websocket_strcasestr(mln_string_t *s, char *needle)
+{
+    mln_size_t i, j, n = strlen(needle);
+
+    if (s->len < n) return -1;
+    for (i = 0; i + n <= s->len; ++i) {
+        for (j = 0; j < n; ++j) {
+            if (tolower(s->data[i+j]) != tolower((mln_u8_t)needle[j])) break;
+        }
+        if (j == n) return (int)i;
+    }
+    return -1;
+}
+
 int mln_websocket_handshake_response_generate(mln_websocket_t *ws, mln_chain_t **chead, mln_chain_t **ctail)
 {
     mln_string_t *tmp;
@@ -256,9 +311,23 @@ int mln_websocket_handshake_response_generate(mln_websocket_t *ws, mln_chain_t *
 
     mln_string_t extension_key = mln_string("Sec-WebSocket-Extensions");
     mln_string_t *extension_val = NULL;
+    int pmd = 0, client_nct = 0, server_nct = 0;
     tmp = mln_http_field_iterator(http, &extension_key);
     if (tmp) {
-        extension_val = mln_websocket_extension_tokens(ws->pool, tmp);
+        if (ws->deflate && mln_websocket_strcasestr(tmp, "permessage-deflate") >= 0) {
+            pmd = 1;
+            client_nct = mln_websocket_strcasestr(tmp, "client_no_context_takeover") >= 0;
+            server_nct = mln_websocket_strcasestr(tmp, "server_no_context_takeover") >= 0;
+        }
+        if (pmd) {
+            char extbuf[128];
+            mln_string_t t;
+            int n = snprintf(extbuf, sizeof(extbuf), "permessage-deflate%s%s",                              server_nct? "; server_no_context_takeover": "",                              client_nct? "; client_no_context_takeover": "");
+            mln_string_nset(&t, extbuf, n);
+            extension_val = mln_string_pool_dup(ws->pool, &t);
+        } else {
+            extension_val = mln_websocket_extension_tokens(ws->pool, tmp);
+        }
         if (extension_val == NULL) {
             if (protocol_val != NULL) mln_string_free(protocol_val);
             return M_WS_RET_FAILED;
@@ -311,6 +380,12 @@ int mln_websocket_handshake_response_generate(mln_websocket_t *ws, mln_chain_t *
 
     if (mln_http_generate(http, chead, ctail) == M_HTTP_RET_ERROR) return M_WS_RET_FAILED;
 
+    if (pmd) {
+        ws->deflate_enc = mln_deflate_new(ws->pool, !server_nct);
+        ws->deflate_dec = mln_deflate_new(ws->pool, !client_nct);
+        if (ws->deflate_enc == NULL || ws->deflate_dec == NULL) return M_WS_RET_FAILED;
+    }
+
     return M_WS_RET_OK;
 }
 
@@ -437,6 +512,11 @@ int mln_websocket_handshake_request_generate(mln_websocket_t *ws, mln_chain_t **
     if (mln_http_field_set(http, &upgrade_key, &upgrade_val) < 0) return M_WS_RET_FAILED;
     if (mln_http_field_set(http, &connection_key, &upgrade_key) < 0) return M_WS_RET_FAILED;
     if (mln_http_field_set(http, &version_key, &version_val) < 0) return M_WS_RET_FAILED;
+    if (ws->deflate) {
+        mln_string_t ext_key = mln_string("Sec-WebSocket-Extensions");
+        mln_string_t ext_val = mln_string("permessage-deflate");
+        if (mln_http_field_set(http, &ext_key, &ext_val) < 0) return M_WS_RET_FAILED;
+    }
 
     if (mln_hash_iterate(ws->fields, mln_websocket_iterate_set_fields, http) < 0)
         return M_WS_RET_FAILED;
@@ -630,26 +710,52 @@ static mln_u32_t mln_websocket_masking_key_generate(void)
     return ((mln_u32_t)tmp | (mln_u32_t)rand());
 }
 
-int mln_websocket_generate(mln_websocket_t *ws, mln_chain_t **out_cnode)
+/*
+ * XOR 'len' bytes of 'src' into 'dst' with the 4-byte masking key,
+ * 'off' bytes into the key cycle. The key is repeated into a 64-bit
+ * word and applied 32 bytes per iteration so the compiler can keep the
+ * loop in vector registers; the scalar tail handles the remainder.
+ * 'dst' and 'src' may be the same buffer.
+ */
+static inline void
+mln_websocket_mask(mln_u8ptr_t dst, mln_u8ptr_t src, mln_u64_t len, mln_u8_t *key, mln_u32_t off)
+{
+    mln_u64_t word, w0, w1, w2, w3, i;
+    mln_u8_t k[8];
+
+    for (i = 0; i < 8; ++i) k[i] = key[(off + i) % 4];
+    memcpy(&word, k, 8);
+    for (; len >= 32; len -= 32, dst += 32, src += 32) {
+        memcpy(&w0, src, 8);
+        memcpy(&w1, src+8, 8);
+        memcpy(&w2, src+16, 8);
+        memcpy(&w3, src+24, 8);
+        w0 ^= word;
+        w1 ^= word;
+        w2 ^= word;
+        w3 ^= word;
+        memcpy(dst, &w0, 8);
+        memcpy(dst+8, &w1, 8);
+        memcpy(dst+16, &w2, 8);
+        memcpy(dst+24, &w3, 8);
+    }
+    for (; len >= 8; len -= 8, dst += 8, src += 8) {
+        memcpy(&w0, src, 8);
+        w0 ^= word;
+        memcpy(dst, &w0, 8);
+    }
+    for (i = 0; i < len; ++i) dst[i] = src[i] ^ key[(off + i) % 4];
+}
+
+static inline int
+mln_websocket_frame_stat(mln_websocket_t *ws, mln_u64_t *pclen, mln_u8_t *pplen, mln_size_t *psize)
 {
     mln_size_t size = 2;
-    mln_u8ptr_t buf, p;
-    mln_buf_t *b;
-    mln_chain_t *c;
-    mln_alloc_t *pool = ws->pool;
     mln_u8_t payload_length = 0;
-    mln_u8ptr_t content = NULL;
-    mln_u64_t clen = 0;
+    mln_u64_t clen = mln_websocket_get_content_len(ws);
     mln_u32_t opcode = mln_websocket_get_opcode(ws);
 
-    if (mln_websocket_get_ext_handler(ws) != NULL) {
-        int ret = mln_websocket_get_ext_handler(ws)(ws);
-        if (ret != M_WS_RET_OK) return ret;
-    }
-
-    content = (mln_u8ptr_t)mln_websocket_get_content(ws);
-    clen = mln_websocket_get_content_len(ws);
-    if (content == NULL && clen) return M_WS_RET_ERROR;
+    if (mln_websocket_get_content(ws) == NULL && clen) return M_WS_RET_ERROR;
 
     if (opcode == M_WS_OPCODE_CLOSE) {
         clen += 2;
@@ -675,27 +781,18 @@ int mln_websocket_generate(mln_websocket_t *ws, mln_chain_t **out_cnode)
 
     if (mln_websocket_get_maskbit(ws)) size += 4;
 
-    c = mln_chain_new(pool);
-    if (c == NULL) return M_WS_RET_FAILED;
-    b = mln_buf_new(pool);
-    if (b == NULL) {
-        mln_chain_pool_release(c);
-        return M_WS_RET_FAILED;
-    }
-    c->buf = b;
-    buf = (mln_u8ptr_t)mln_alloc_m(pool, size);
-    if (buf == NULL) {
-        mln_chain_pool_release(c);
-        return M_WS_RET_FAILED;
-    }
-    b->left_pos = b->pos = b->start = buf;
-    b->end = b->last = buf + size;
-    b->in_memory = 1;
-    b->last_buf = 1;
-    if (mln_websocket_get_fin(ws)) b->last_in_chain = 1;
-    *out_cnode = c;
+    *pclen = clen;
+    *pplen = payload_length;
+    *psize = size;
+    return M_WS_RET_OK;
+}
+
+static inline void
+mln_websocket_frame_fill(mln_websocket_t *ws, mln_u8ptr_t p, mln_u64_t clen, mln_u8_t payload_length)
+{
+    mln_u8ptr_t content = (mln_u8ptr_t)mln_websocket_get_content(ws);
+    mln_u32_t opcode = mln_websocket_get_opcode(ws);
 
-    p = buf;
     *p = 0;
     if (mln_websocket_get_fin(ws)) *p |= 0x80;
     if (mln_websocket_get_rsv1(ws)) *p |= 0x40;
@@ -723,21 +820,17 @@ int mln_websocket_generate(mln_websocket_t *ws, mln_chain_t **out_cnode)
 
     if (mln_websocket_get_maskbit(ws)) {
         mln_u8_t tmpkey[4];
-        mln_u32_t i, j, m = mln_websocket_get_masking_key(ws);
-        mln_u8ptr_t pc = (mln_u8ptr_t)content;
+        mln_u32_t i = 0, m = mln_websocket_get_masking_key(ws);
         *p++ = tmpkey[0] = ((m >> 24) & 0xff);
         *p++ = tmpkey[1] = ((m >> 16) & 0xff);
         *p++ = tmpkey[2] = ((m >> 8) & 0xff);
         *p++ = tmpkey[3] = (m & 0xff);
 
-        i = 0;
         if (opcode == M_WS_OPCODE_CLOSE) {
             *p++ = ((mln_websocket_get_status(ws) >> 8) & 0xff) ^ tmpkey[i++%4];
             *p++ = (mln_websocket_get_status(ws) & 0xff) ^ tmpkey[i++%4];
         }
-        for (j = 0; i < clen; ++i, ++j) {
-            *p++ = pc[j] ^ tmpkey[i%4];
-        }
+        mln_websocket_mask(p, content, clen - i, tmpkey, i);
     } else {
         if (opcode == M_WS_OPCODE_CLOSE) {
             *p++ = (mln_websocket_get_status(ws) >> 8) & 0xff;
@@ -746,6 +839,222 @@ int mln_websocket_generate(mln_websocket_t *ws, mln_chain_t **out_cnode)
         }
         if (content != NULL) memcpy(p, content, clen);
     }
+}
+
+static int mln_websocket_deflate_out(mln_websocket_t *ws)
+{
+    mln_u8ptr_t out;
+    mln_size_t outlen;
+    mln_u8_t opcode = mln_websocket_get_opcode(ws);
+
+    if (ws->deflate_enc == NULL || !mln_websocket_get_fin(ws) || mln_websocket_get_rsv1(ws))
+        return M_WS_RET_OK;
+    if (opcode != M_WS_OPCODE_TEXT && opcode != M_WS_OPCODE_BINARY)
+        return M_WS_RET_OK;
+    if (ws->content == NULL || ws->content_len == 0)
+        return M_WS_RET_OK;
+
+    if (mln_deflate_compress(ws->deflate_enc, \
+                             (mln_u8ptr_t)(ws->content), \
+                             ws->content_len, \
+                             &out, \
+                             &outlen) < 0)
+    {
+        return M_WS_RET_FAILED;
+    }
+    if (mln_websocket_get_content_free(ws))
+        mln_alloc_free(ws->content);
+    mln_websocket_set_content(ws, out);
+    mln_websocket_set_content_len(ws, outlen);
+    mln_websocket_set_content_free(ws);
+    mln_websocket_set_rsv1(ws);
+
+    return M_WS_RET_OK;
+}
+
+static int mln_websocket_deflate_in(mln_websocket_t *ws)
+{
+    mln_u8ptr_t tmp, out;
+    mln_size_t outlen;
+    mln_u8_t opcode = mln_websocket_get_opcode(ws);
+
+    if (ws->deflate_dec == NULL || !mln_websocket_get_rsv1(ws) || !mln_websocket_get_fin(ws))
+        return M_WS_RET_OK;
+    if (opcode != M_WS_OPCODE_TEXT && opcode != M_WS_OPCODE_BINARY)
+        return M_WS_RET_OK;
+    if (ws->content == NULL)
+        return M_WS_RET_OK;
+
+    /*restore the stripped tail, see RFC 7692 7.2.2*/
+    tmp = (mln_u8ptr_t)mln_alloc_m(ws->pool, ws->content_len + 4);
+    if (tmp == NULL) return M_WS_RET_FAILED;
+    memcpy(tmp, ws->content, ws->content_len);
+    tmp[ws->content_len] = 0x00;
+    tmp[ws->content_len+1] = 0x00;
+    tmp[ws->content_len+2] = 0xff;
+    tmp[ws->content_len+3] = 0xff;
+    if (mln_deflate_decompress(ws->deflate_dec, tmp, ws->content_len+4, &out, &outlen) < 0) {
+        mln_alloc_free(tmp);
+        return M_WS_RET_FAILED;
+    }
+    mln_alloc_free(tmp);
+    if (mln_websocket_get_content_free(ws))
+        mln_alloc_free(ws->content);
+    mln_websocket_set_content(ws, out);
+    mln_websocket_set_content_len(ws, outlen);
+    mln_websocket_set_content_free(ws);
+    mln_websocket_reset_rsv1(ws);
+
+    return M_WS_RET_OK;
+}
+
+int mln_websocket_generate(mln_websocket_t *ws, mln_chain_t **out_cnode)
+{
+    mln_size_t size;
+    mln_u8ptr_t buf;
+    mln_buf_t *b;
+    mln_chain_t *c;
+    mln_alloc_t *pool = ws->pool;
+    mln_u8_t payload_length;
+    mln_u64_t clen;
+
+    if (mln_websocket_get_ext_handler(ws) != NULL) {
+        int ret = mln_websocket_get_ext_handler(ws)(ws);
+        if (ret != M_WS_RET_OK) return ret;
+    }
+    if (mln_websocket_deflate_out(ws) != M_WS_RET_OK) return M_WS_RET_FAILED;
+
+    if (mln_websocket_frame_stat(ws, &clen, &payload_length, &size) != M_WS_RET_OK)
+        return M_WS_RET_ERROR;
+
+    c = mln_chain_new(pool);
+    if (c == NULL) return M_WS_RET_FAILED;
+    b = mln_buf_new(pool);
+    if (b == NULL) {
+        mln_chain_pool_release(c);
+        return M_WS_RET_FAILED;
+    }
+    c->buf = b;
+    buf = (mln_u8ptr_t)mln_alloc_m(pool, size);
+    if (buf == NULL) {
+        mln_chain_pool_release(c);
+        return M_WS_RET_FAILED;
+    }
+    b->left_pos = b->pos = b->start = buf;
+    b->end = b->last = buf + size;
+    b->in_memory = 1;
+    b->last_buf = 1;
+    if (mln_websocket_get_fin(ws)) b->last_in_chain = 1;
+    *out_cnode = c;
+
+    mln_websocket_frame_fill(ws, buf, clen, payload_length);
+
+    return M_WS_RET_OK;
+}
+
+int mln_websocket_generate_append(mln_websocket_t *ws, mln_chain_t **out_head, mln_chain_t **out_tail)
+{
+    mln_size_t size, cap;
+    mln_u8ptr_t buf;
+    mln_buf_t *b;
+    mln_chain_t *c;
+    mln_alloc_t *pool = ws->pool;
+    mln_u8_t payload_length;
+    mln_u64_t clen;
+
+    if (mln_websocket_get_ext_handler(ws) != NULL) {
+        int ret = mln_websocket_get_ext_handler(ws)(ws);
+        if (ret != M_WS_RET_OK) return ret;
+    }
+    if (mln_websocket_deflate_out(ws) != M_WS_RET_OK) return M_WS_RET_FAILED;
+
+    if (mln_websocket_frame_stat(ws, &clen, &payload_length, &size) != M_WS_RET_OK)
+        return M_WS_RET_ERROR;
+
+    b = *out_tail == NULL? NULL: (*out_tail)->buf;
+    if (b == NULL || !b->in_memory || (mln_size_t)(b->end - b->last) < size) {
+        cap = size > M_WS_BATCH_ALLOC_SIZE? size: M_WS_BATCH_ALLOC_SIZE;
+        c = mln_chain_new(pool);
+        if (c == NULL) return M_WS_RET_FAILED;
+        b = mln_buf_new(pool);
+        if (b == NULL) {
+            mln_chain_pool_release(c);
+            return M_WS_RET_FAILED;
+        }
+        c->buf = b;
+        buf = (mln_u8ptr_t)mln_alloc_m(pool, cap);
+        if (buf == NULL) {
+            mln_chain_pool_release(c);
+            return M_WS_RET_FAILED;
+        }
+        b->left_pos = b->pos = b->start = buf;
+        b->last = buf;
+        b->end = buf + cap;
+        b->in_memory = 1;
+        b->last_buf = 1;
+        mln_chain_add(out_head, out_tail, c);
+    }
+
+    mln_websocket_frame_fill(ws, b->last, clen, payload_length);
+    b->last += size;
+    if (mln_websocket_get_fin(ws)) b->last_in_chain = 1;
+
+    return M_WS_RET_OK;
+}
+
+int mln_websocket_broadcast(mln_websocket_t *ws, \
+                            mln_tcp_conn_t **conns, \
+                            mln_size_t nconns, \
+                            void *buf, \
+                            mln_size_t len, \
+                            mln_u32_t flags)
+{
+    mln_chain_t *frame = NULL, *c;
+    mln_buf_t *b;
+    mln_alloc_t *pool;
+    mln_size_t i;
+    int ret;
+
+    if (mln_websocket_get_content_free(ws)) {
+        mln_alloc_free(mln_websocket_get_content(ws));
+        mln_websocket_reset_content_free(ws);
+    }
+    mln_websocket_set_content(ws, buf);
+    mln_websocket_set_content_len(ws, len);
+    mln_websocket_reset_content_free(ws);
+    if (flags & M_WS_FLAG_END) mln_websocket_set_fin(ws);
+    else mln_websocket_reset_fin(ws);
+    mln_websocket_reset_rsv1(ws);
+    mln_websocket_reset_rsv2(ws);
+    mln_websocket_reset_rsv3(ws);
+    if (flags & M_WS_FLAG_NEW) {
+        mln_websocket_set_opcode(ws, (flags & M_WS_FLAG_TEXT)? M_WS_OPCODE_TEXT: M_WS_OPCODE_BINARY);
+    } else {
+        mln_websocket_set_opcode(ws, M_WS_OPCODE_CONTINUE);
+    }
+    /*server-to-client frames carry no mask, so one rendering fits every peer*/
+    mln_websocket_reset_maskbit(ws);
+
+    if ((ret = mln_websocket_generate(ws, &frame)) != M_WS_RET_OK) return ret;
+
+    for (i = 0; i < nconns; ++i) {
+        pool = mln_tcp_conn_pool_get(conns[i]);
+        c = mln_chain_new(pool);
+        if (c == NULL) {
+            mln_chain_pool_release(frame);
+            return M_WS_RET_FAILED;
+        }
+        b = mln_buf_ref(pool, frame->buf);
+        if (b == NULL) {
+            mln_chain_pool_release(c);
+            mln_chain_pool_release(frame);
+            return M_WS_RET_FAILED;
+        }
+        c->buf = b;
+        mln_tcp_conn_append(conns[i], c, M_C_SEND);
+    }
+    /*the frame bytes survive until the last shadow is sent and released*/
+    mln_chain_pool_release(frame);
 
     return M_WS_RET_OK;
 }
@@ -839,6 +1148,20 @@ againm:
         }
     }
 
+    int reass = ws->reassemble && \
+                ((b1&0xf) == M_WS_OPCODE_CONTINUE || \
+                 (b1&0xf) == M_WS_OPCODE_TEXT || \
+                 (b1&0xf) == M_WS_OPCODE_BINARY) && \
+                !((b1 & 0x40) && ws->deflate_dec != NULL);
+    if (reass && (b1&0xf) != M_WS_OPCODE_CONTINUE) {
+        if (ws->msg_head != NULL) {
+            /*a new message begins, drop the previous one if it was never taken*/
+            mln_chain_pool_release_all(ws->msg_head);
+            ws->msg_head = ws->msg_tail = NULL;
+        }
+        ws->msg_len = 0;
+    }
+
     if (len) {
         if ((b1&0xf) == M_WS_OPCODE_CLOSE && len > 1) {
             mln_u16_t status = 0;
@@ -867,6 +1190,64 @@ against:
         } else {
             mln_websocket_set_status(ws, 0);
         }
+        if (reass) {
+            mln_chain_t *cc, *nc, *first = NULL, *last = NULL;
+            mln_buf_t *nb;
+            mln_u64_t avail = p < end? (mln_u64_t)(end - p): 0, take;
+
+            for (cc = c == NULL? NULL: c->next; avail < len && cc != NULL; cc = cc->next) {
+                if (cc->buf == NULL || mln_buf_left_size(cc->buf) == 0) continue;
+                avail += (mln_u64_t)(cc->buf->end - cc->buf->left_pos);
+            }
+            if (avail < len) return M_WS_RET_NOTYET;
+
+            for (tmp = len; tmp > 0; ) {
+                if (p >= end) {
+                    for (c = c->next; c != NULL; c = c->next) {
+                        if (c->buf == NULL || mln_buf_left_size(c->buf) == 0) continue;
+                        break;
+                    }
+                    p = c->buf->left_pos;
+                    end = c->buf->end;
+                    continue;
+                }
+                take = (mln_u64_t)(end - p) > tmp? tmp: (mln_u64_t)(end - p);
+                nb = mln_buf_ref(mln_websocket_get_pool(ws), c->buf);
+                nc = nb == NULL? NULL: mln_chain_new(mln_websocket_get_pool(ws));
+                if (nc == NULL) {
+                    if (first != NULL) mln_chain_pool_release_all(first);
+                    return M_WS_RET_FAILED;
+                }
+                nb->left_pos = nb->pos = nb->start = p;
+                nb->last = nb->end = p + take;
+                nc->buf = nb;
+                if (first == NULL) first = last = nc;
+                else last = last->next = nc;
+                p += take;
+                tmp -= take;
+            }
+            if (b2 & 0x80) {
+                /*unmask in place, the shadows and their owners share the bytes*/
+                mln_u8_t tmpkey[4];
+                mln_u64_t off = 0;
+                tmpkey[0] = (masking_key >> 24) & 0xff;
+                tmpkey[1] = (masking_key >> 16) & 0xff;
+                tmpkey[2] = (masking_key >> 8) & 0xff;
+                tmpkey[3] = masking_key & 0xff;
+                for (nc = first; nc != NULL; nc = nc->next) {
+                    take = nc->buf->last - nc->buf->pos;
+                    mln_websocket_mask(nc->buf->pos, nc->buf->pos, take, tmpkey, (mln_u32_t)(off & 3));
+                    off += take;
+                }
+            }
+            if (ws->msg_head == NULL) {
+                ws->msg_head = first;
+                ws->msg_tail = last;
+            } else {
+                ws->msg_tail->next = first;
+                ws->msg_tail = last;
+            }
+        } else {
         content = (mln_u8ptr_t)mln_alloc_m(mln_websocket_get_pool(ws), len);
         if (content == NULL) return M_WS_RET_FAILED;
         tmp = p - end;
@@ -890,6 +1271,7 @@ againc:
             tmp = (len-tmp > p-end)? p-end: len-tmp;
             goto againc;
         }
+        }
     }
 
     if (mln_websocket_get_content_free(ws)) {
@@ -912,6 +1294,10 @@ againc:
     else mln_websocket_reset_maskbit(ws);
     if (b2 & 0x80) mln_websocket_set_masking_key(ws, masking_key);
     else mln_websocket_set_masking_key(ws, 0);
+    if (reass) {
+        if ((b1&0xf) != M_WS_OPCODE_CONTINUE) ws->msg_opcode = b1 & 0xf;
+        ws->msg_len += len;
+    }
 
     if (mln_websocket_get_maskbit(ws)) {
         mln_u8_t tmpkey[4];
@@ -927,12 +1313,11 @@ againc:
             mln_websocket_set_status(ws, status);
         }
         if (content != NULL) {
-            for (tmp = 0; tmp < len; ++tmp) {
-                content[tmp] ^= tmpkey[i++%4];
-            }
+            mln_websocket_mask(content, content, len, tmpkey, i);
         }
     }
 
+    if (mln_websocket_deflate_in(ws) != M_WS_RET_OK) return M_WS_RET_FAILED;
     if (mln_websocket_get_ext_handler(ws) != NULL) {
         int ret = mln_websocket_get_ext_handler(ws)(ws);
         if (ret != M_WS_RET_OK) return ret;
@@ -958,6 +1343,60 @@ againc:
         }
     }
 
-    return M_WS_RET_OK;
+    return (reass && !(b1 & 0x80))? M_WS_RET_FRAGMENT: M_WS_RET_OK;
+}
+
+mln_chain_t *mln_websocket_msg_take(mln_websocket_t *ws)
+{
+    mln_chain_t *c = ws->msg_head;
+    ws->msg_head = ws->msg_tail = NULL;
+    return c;
+}
+
+mln_u8ptr_t mln_websocket_msg_flatten(mln_websocket_t *ws)
+{
+    mln_u8ptr_t buf, pos;
+    mln_chain_t *c;
+    mln_u64_t n;
+
+    if (ws->msg_head == NULL || ws->msg_len == 0) return NULL;
+    buf = (mln_u8ptr_t)mln_alloc_m(ws->pool, ws->msg_len);
+    if (buf == NULL) return NULL;
+    for (pos = buf, c = ws->msg_head; c != NULL; c = c->next) {
+        if (c->buf == NULL) continue;
+        n = c->buf->last - c->buf->pos;
+        memcpy(pos, c->buf->pos, n);
+        pos += n;
+    }
+    mln_chain_pool_release_all(ws->msg_head);
+    ws->msg_head = ws->msg_tail = NULL;
+    if (mln_websocket_get_content_free(ws)) {
+        mln_alloc_free(mln_websocket_get_content(ws));
+    }
+    mln_websocket_set_content(ws, buf);
+    mln_websocket_set_content_len(ws, ws->msg_len);
+    mln_websocket_set_content_free(ws);
+    return buf;
+}
+
+int mln_websocket_parse_batch(mln_websocket_t *ws, \
+                              mln_chain_t **in, \
+                              mln_websocket_frame_handler frame_handler, \
+                              void *data)
+{
+    int ret;
+
+    while (*in != NULL) {
+        ret = mln_websocket_parse(ws, in);
+        if (ret == M_WS_RET_FRAGMENT) continue;
+        if (ret != M_WS_RET_OK) return ret;
+        if (frame_handler != NULL && \
+            (ret = frame_handler(ws, data)) != M_WS_RET_OK)
+        {
+            return ret;
+        }
+    }
+
+    return M_WS_RET_NOTYET;
 }
 